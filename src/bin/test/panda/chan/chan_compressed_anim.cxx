@@ -0,0 +1,227 @@
+// Filename: chan_compressed_anim.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "animBundle.h"
+#include "animChannelMatrixXfmTable.h"
+#include "animChannelMatrixCompressed.h"
+#include "bamFile.h"
+#include "trueClock.h"
+#include "randomizer.h"
+#include "pnotify.h"
+
+// This program builds an animation of 100 joints over 2000 frames,
+// then a copy of it with each channel converted to an
+// AnimChannelMatrixCompressed within a tolerance of 0.001 units and
+// 0.05 degrees.  It reports the memory taken by the channel tables
+// of each, and the time taken to sample both at random frames, and
+// fails if any component of the compressed channels strays further
+// from the original than its tolerance, or if they don't survive a
+// trip through a bam stream unchanged.
+
+static const int num_joints = 100;
+static const int num_frames = 2000;
+static const int num_samples = 200000;
+static const float tolerance = 0.001f;
+static const float hpr_tolerance = 0.05f;
+
+static const char table_ids[] = "hprxyz";
+
+static PT(AnimBundle)
+make_anim() {
+  PT(AnimBundle) anim = new AnimBundle("walk", 30.0f, num_frames);
+  AnimGroup *skeleton = new AnimGroup(anim, "<skeleton>");
+
+  for (int i = 0; i < num_joints; ++i) {
+    char name[16];
+    sprintf(name, "joint%03d", i);
+    AnimChannelMatrixXfmTable *channel = new AnimChannelMatrixXfmTable(skeleton, name);
+
+    // Motion-capture-like data: a couple of smooth waves for the
+    // rotations, a gentle drift for the translation, and one
+    // component of each held still.
+    for (int t = 0; t < 6; ++t) {
+      if (t == 2 || t == 5) {
+        PTA_float table = PTA_float::empty_array(1);
+        table[0] = (float)i * 0.1f;
+        channel->set_table(table_ids[t], table);
+        continue;
+      }
+      PTA_float table = PTA_float::empty_array(num_frames);
+      for (int f = 0; f < num_frames; ++f) {
+        float phase = (float)f * 0.02f + (float)(i * 6 + t);
+        if (t < 3) {
+          table[f] = 40.0f * csin(phase) + 5.0f * csin(phase * 3.7f);
+        } else {
+          table[f] = 0.2f * ccos(phase) + (float)f * 0.0001f;
+        }
+      }
+      channel->set_table(table_ids[t], table);
+    }
+  }
+  return anim;
+}
+
+static PT(AnimBundle)
+make_compressed(AnimBundle *source) {
+  PT(AnimBundle) anim = new AnimBundle("walk", source->get_base_frame_rate(),
+                                       source->get_num_frames());
+  AnimGroup *source_skeleton = source->get_child(0);
+  AnimGroup *skeleton = new AnimGroup(anim, source_skeleton->get_name());
+
+  for (int i = 0; i < source_skeleton->get_num_children(); ++i) {
+    AnimChannelMatrixXfmTable *table;
+    DCAST_INTO_R(table, source_skeleton->get_child(i), NULL);
+    new AnimChannelMatrixCompressed(skeleton, *table, tolerance, hpr_tolerance);
+  }
+  return anim;
+}
+
+// Returns the size in bytes of the tables of the uncompressed channel.
+static size_t
+get_table_size(AnimChannelMatrixXfmTable *channel) {
+  size_t size = 0;
+  for (int t = 0; t < 6; ++t) {
+    size += channel->get_table(table_ids[t]).size() * sizeof(float);
+  }
+  return size;
+}
+
+static int
+check_error(AnimBundle *source, AnimBundle *compressed) {
+  int num_errors = 0;
+  AnimGroup *source_skeleton = source->get_child(0);
+  AnimGroup *skeleton = compressed->get_child(0);
+
+  for (int i = 0; i < source_skeleton->get_num_children(); ++i) {
+    AnimChannelMatrixXfmTable *a;
+    AnimChannelMatrixCompressed *b;
+    DCAST_INTO_R(a, source_skeleton->get_child(i), 1);
+    DCAST_INTO_R(b, skeleton->get_child(i), 1);
+
+    for (int t = 0; t < 6; ++t) {
+      float limit = (t < 3) ? hpr_tolerance : tolerance;
+      CPTA_float original = a->get_table(table_ids[t]);
+      PTA_float decoded = b->get_table(table_ids[t]);
+      for (int f = 0; f < num_frames; ++f) {
+        float x = original[f % original.size()];
+        float y = decoded[f % decoded.size()];
+        // Allow a little for the rounding of the float32 arithmetic.
+        if (cabs(x - y) > limit * 1.01f + 1.0e-5f) {
+          nout << b->get_name() << ", " << table_ids[t] << " at frame "
+               << f << ": " << y << " instead of " << x << "\n";
+          ++num_errors;
+          break;
+        }
+      }
+    }
+  }
+  return num_errors;
+}
+
+static double
+time_samples(AnimBundle *anim, float &checksum) {
+  AnimGroup *skeleton = anim->get_child(0);
+  pvector<AnimChannelMatrix *> channels;
+  for (int i = 0; i < skeleton->get_num_children(); ++i) {
+    channels.push_back(DCAST(AnimChannelMatrix, skeleton->get_child(i)));
+  }
+
+  Randomizer random(1);
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+
+  checksum = 0.0f;
+  LMatrix4f mat;
+  for (int s = 0; s < num_samples; ++s) {
+    AnimChannelMatrix *channel = channels[random.random_int(num_joints)];
+    channel->get_value(random.random_int(num_frames), mat);
+    checksum += mat(3, 0);
+  }
+  return clock->get_short_time() - start;
+}
+
+static PT(AnimBundle)
+round_trip(AnimBundle *anim) {
+  ostringstream out;
+  BamFile bam;
+  if (!bam.open_write(out) || !bam.write_object(anim)) {
+    return NULL;
+  }
+  bam.close();
+
+  istringstream in(out.str());
+  if (!bam.open_read(in)) {
+    return NULL;
+  }
+  TypedWritable *object = bam.read_object();
+  if (object == NULL || !bam.resolve() ||
+      !object->is_of_type(AnimBundle::get_class_type())) {
+    return NULL;
+  }
+  PT(AnimBundle) result = DCAST(AnimBundle, object);
+  bam.close();
+  return result;
+}
+
+int
+main(int argc, char *argv[]) {
+  PT(AnimBundle) anim = make_anim();
+  PT(AnimBundle) compressed = make_compressed(anim);
+
+  size_t original_size = 0;
+  size_t compressed_size = 0;
+  AnimGroup *skeleton = anim->get_child(0);
+  AnimGroup *compressed_skeleton = compressed->get_child(0);
+  for (int i = 0; i < num_joints; ++i) {
+    original_size += get_table_size(DCAST(AnimChannelMatrixXfmTable, skeleton->get_child(i)));
+    compressed_size += DCAST(AnimChannelMatrixCompressed, compressed_skeleton->get_child(i))->get_data_size();
+  }
+  nout << num_joints << " joints, " << num_frames << " frames.\n"
+       << "Tables:     " << original_size / 1024 << " KB\n"
+       << "Compressed: " << compressed_size / 1024 << " KB ("
+       << (double)original_size / (double)compressed_size << " times smaller)\n";
+
+  float original_checksum, compressed_checksum;
+  double original_time = time_samples(anim, original_checksum);
+  double compressed_time = time_samples(compressed, compressed_checksum);
+  nout << num_samples << " random samples: "
+       << original_time * 1000.0 << " ms from the tables, "
+       << compressed_time * 1000.0 << " ms compressed.\n";
+
+  int num_errors = check_error(anim, compressed);
+
+  PT(AnimBundle) reloaded = round_trip(compressed);
+  if (reloaded == (AnimBundle *)NULL) {
+    nout << "Could not write and read back the compressed animation.\n";
+    ++num_errors;
+  } else {
+    num_errors += check_error(anim, reloaded);
+    float reloaded_checksum;
+    time_samples(reloaded, reloaded_checksum);
+    if (reloaded_checksum != compressed_checksum) {
+      nout << "Reloaded animation differs from the original.\n";
+      ++num_errors;
+    }
+  }
+
+  if (num_errors != 0) {
+    nout << num_errors << " channels exceeded their tolerance.\n";
+    return 1;
+  }
+  nout << "All channels within tolerance.\n";
+  return 0;
+}
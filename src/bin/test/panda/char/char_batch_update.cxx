@@ -0,0 +1,273 @@
+// Filename: char_batch_update.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "character.h"
+#include "characterJoint.h"
+#include "characterJointBundle.h"
+#include "characterBatchEvaluator.h"
+#include "animBundle.h"
+#include "animControl.h"
+#include "animChannelMatrixXfmTable.h"
+#include "partSubset.h"
+#include "config_gobj.h"
+#include "config_char.h"
+#include "clockObject.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program animates a crowd of characters, 1000 by default, each
+// playing one of a handful of frames of the same animation, for a
+// number of frames: first by calling Character::update() on each
+// one, then with a CharacterBatchEvaluator, and then with a
+// CharacterBatchEvaluator and the number of vertex-animation-threads
+// given on the command line (default 4).  It reports the time taken
+// each way, and fails if the joints don't end up in exactly the same
+// place.
+//
+// It then animates the crowd individually in each of the states that
+// Character's animation LOD may put a bundle into: reduced to the
+// first joints of the skeleton, throttled to a few updates a second,
+// and offscreen.  The bundles are put into these states directly, as
+// the cull traversal would do.  It fails if the reduced joints don't
+// match the fully animated ones, or if the offscreen characters move
+// at all.
+
+static const int num_joints = 48;
+static const int num_reduced_joints = 8;
+static const int num_anim_frames = 60;
+static const int num_frame_offsets = 8;
+static const int num_frames = 30;
+
+static PT(AnimBundle)
+make_anim() {
+  PT(AnimBundle) anim = new AnimBundle("npc", 24.0f, num_anim_frames);
+  AnimGroup *skeleton = new AnimGroup(anim, "<skeleton>");
+
+  // The joints form a binary tree, so that each joint's children are
+  // created in order of their names, as the parts will be.
+  pvector<AnimGroup *> channels;
+  for (int i = 0; i < num_joints; ++i) {
+    AnimGroup *parent = (i == 0) ? skeleton : channels[(i - 1) / 2];
+    char name[16];
+    sprintf(name, "joint%02d", i);
+    AnimChannelMatrixXfmTable *channel = new AnimChannelMatrixXfmTable(parent, name);
+
+    static const char table_ids[] = "hprxyz";
+    for (int t = 0; t < 6; ++t) {
+      PTA_float table = PTA_float::empty_array(num_anim_frames);
+      for (int f = 0; f < num_anim_frames; ++f) {
+        float phase = (float)f * 0.1f + (float)(i * 6 + t);
+        table[f] = (t < 3) ? 30.0f * csin(phase) : 0.5f * ccos(phase);
+      }
+      channel->set_table(table_ids[t], table);
+    }
+    channels.push_back(channel);
+  }
+  return anim;
+}
+
+class Crowd {
+public:
+  pvector< PT(Character) > _characters;
+  pvector< PT(AnimControl) > _controls;
+  pvector< pvector<CharacterJoint *> > _joints;
+};
+
+static void
+make_crowd(Crowd &crowd, AnimBundle *anim, int num_characters) {
+  for (int c = 0; c < num_characters; ++c) {
+    PT(Character) character = new Character("npc");
+    PartBundle *bundle = character->get_bundle(0);
+    PartGroup *skeleton = new PartGroup(bundle, "<skeleton>");
+
+    pvector<CharacterJoint *> joints;
+    for (int i = 0; i < num_joints; ++i) {
+      PartGroup *parent = (i == 0) ? skeleton : joints[(i - 1) / 2];
+      char name[16];
+      sprintf(name, "joint%02d", i);
+      joints.push_back(new CharacterJoint(character, bundle, parent, name,
+                                          LMatrix4f::ident_mat()));
+    }
+
+    PT(AnimControl) control = bundle->bind_anim(anim, 0);
+    nassertv(control != (AnimControl *)NULL);
+
+    crowd._characters.push_back(character);
+    crowd._controls.push_back(control);
+    crowd._joints.push_back(joints);
+  }
+}
+
+static double
+animate_crowd(Crowd &crowd, CharacterBatchEvaluator *evaluator) {
+  ClockObject *clock = ClockObject::get_global_clock();
+  TrueClock *true_clock = TrueClock::get_global_ptr();
+  double elapsed = 0.0;
+
+  int num_characters = (int)crowd._characters.size();
+  for (int f = 0; f < num_frames; ++f) {
+    clock->tick();
+    for (int c = 0; c < num_characters; ++c) {
+      crowd._controls[c]->pose((f + (c % num_frame_offsets) * 5) % num_anim_frames);
+    }
+
+    double start = true_clock->get_short_time();
+    if (evaluator != (CharacterBatchEvaluator *)NULL) {
+      evaluator->update();
+    } else {
+      for (int c = 0; c < num_characters; ++c) {
+        crowd._characters[c]->update();
+      }
+    }
+    elapsed += true_clock->get_short_time() - start;
+  }
+
+  return elapsed;
+}
+
+// Returns true if the first num_compare joints of each character in
+// a match those of b.
+static bool
+same_joints(const Crowd &a, const Crowd &b, int num_compare = num_joints) {
+  for (size_t c = 0; c < a._joints.size(); ++c) {
+    for (int i = 0; i < num_compare; ++i) {
+      LMatrix4f ma, mb;
+      a._joints[c][i]->get_net_transform(ma);
+      b._joints[c][i]->get_net_transform(mb);
+      if (ma.compare_to(mb, 0.0f) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static bool
+all_identity(const Crowd &crowd) {
+  for (size_t c = 0; c < crowd._joints.size(); ++c) {
+    for (int i = 0; i < num_joints; ++i) {
+      LMatrix4f m;
+      crowd._joints[c][i]->get_net_transform(m);
+      if (!m.almost_equal(LMatrix4f::ident_mat())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_threads = 4;
+  int num_characters = 1000;
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_characters = max(atoi(argv[2]), 1);
+  }
+
+  ClockObject *clock = ClockObject::get_global_clock();
+  clock->set_mode(ClockObject::M_non_real_time);
+  clock->set_frame_rate(30.0);
+
+  PT(AnimBundle) anim = make_anim();
+  Crowd individual, batched, threaded;
+  make_crowd(individual, anim, num_characters);
+  make_crowd(batched, anim, num_characters);
+  make_crowd(threaded, anim, num_characters);
+
+  double individual_time = animate_crowd(individual, NULL);
+
+  PT(CharacterBatchEvaluator) evaluator = new CharacterBatchEvaluator;
+  for (int c = 0; c < num_characters; ++c) {
+    evaluator->add_character(batched._characters[c]);
+  }
+  double batched_time = animate_crowd(batched, evaluator);
+  int num_evaluated = evaluator->get_num_poses_evaluated();
+  int num_shared = evaluator->get_num_poses_shared();
+  int num_fallback = evaluator->get_num_bundles_fallback();
+
+  // The worker threads are started the first time they are needed,
+  // so vertex-animation-threads must be set before then.
+  vertex_animation_threads = num_threads;
+  anim_batch_min_joints = 0;
+  PT(CharacterBatchEvaluator) threaded_evaluator = new CharacterBatchEvaluator;
+  for (int c = 0; c < num_characters; ++c) {
+    threaded_evaluator->add_character(threaded._characters[c]);
+  }
+  double threaded_time = animate_crowd(threaded, threaded_evaluator);
+
+  bool same = same_joints(individual, batched) && same_joints(individual, threaded);
+
+  Crowd reduced, throttled, offscreen;
+  make_crowd(reduced, anim, num_characters);
+  make_crowd(throttled, anim, num_characters);
+  make_crowd(offscreen, anim, num_characters);
+
+  // In a binary tree numbered this way, the first joints are the
+  // ones nearest the root.
+  PartSubset subset;
+  for (int i = 0; i < num_reduced_joints; ++i) {
+    char name[16];
+    sprintf(name, "joint%02d", i);
+    subset.add_include_joint(GlobPattern(name));
+  }
+  for (int c = 0; c < num_characters; ++c) {
+    PartBundle *bundle = reduced._characters[c]->get_bundle(0);
+    bundle->set_lod_subset(subset);
+    bundle->set_lod_reduced(true);
+
+    bundle = throttled._characters[c]->get_bundle(0);
+    bundle->set_update_delay(0.25);
+    bundle->set_lod_frame_blend(true);
+
+    // These are never culled, so they are never visible.
+    offscreen._characters[c]->set_lod_skip_offscreen(true);
+  }
+
+  double reduced_time = animate_crowd(reduced, NULL);
+  double throttled_time = animate_crowd(throttled, NULL);
+  double offscreen_time = animate_crowd(offscreen, NULL);
+
+  // The reduced crowd was posed exactly as the individual one was, so
+  // its reduced joints should be exactly where those are, and the
+  // rest should not.
+  bool reduced_ok = same_joints(individual, reduced, num_reduced_joints) &&
+    !same_joints(individual, reduced);
+  bool offscreen_ok = all_identity(offscreen);
+
+  double frame_scale = 1000.0 / num_frames;
+  nout << num_characters << " characters of " << num_joints
+       << " joints, per frame:\n"
+       << "  individually:        " << individual_time * frame_scale << " ms\n"
+       << "  batched:             " << batched_time * frame_scale << " ms\n"
+       << "  batched, " << num_threads << " threads:  "
+       << threaded_time * frame_scale << " ms\n"
+       << num_evaluated << " poses evaluated, " << num_shared << " shared, "
+       << num_fallback << " bundles not batched.\n"
+       << (same ? "Joints identical.\n" : "JOINTS DIFFER!\n")
+       << "Animation LOD, individually, per frame:\n"
+       << "  reduced to " << num_reduced_joints << ":        "
+       << reduced_time * frame_scale << " ms\n"
+       << "  throttled:           " << throttled_time * frame_scale << " ms\n"
+       << "  offscreen:           " << offscreen_time * frame_scale << " ms\n"
+       << (reduced_ok ? "Reduced joints match.\n" : "REDUCED JOINTS DIFFER!\n")
+       << (offscreen_ok ? "Offscreen characters held still.\n" : "OFFSCREEN CHARACTERS MOVED!\n");
+
+  return (same && reduced_ok && offscreen_ok) ? 0 : 1;
+}
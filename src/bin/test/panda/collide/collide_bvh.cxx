@@ -0,0 +1,176 @@
+// Filename: collide_bvh.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "collisionTraverser.h"
+#include "collisionNode.h"
+#include "collisionSphere.h"
+#include "collisionRay.h"
+#include "collisionHandlerQueue.h"
+#include "collisionEntry.h"
+#include "collisionBVH.h"
+#include "config_collide.h"
+#include "geomNode.h"
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexWriter.h"
+#include "nodePath.h"
+#include "randomizer.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program builds a large static terrain mesh and a large
+// CollisionNode full of spheres, and drops a number of rays onto
+// them, first with the bounding-volume hierarchies disabled and then
+// with them enabled.  It checks that both traversals report the same
+// collisions in the same order, and reports the time taken by each.
+// Run it with a grid size on the command line, e.g. "collide_bvh 200".
+
+static const int num_rays = 200;
+static const int num_spheres = 10000;
+static const int num_frames = 5;
+
+static PT(GeomNode)
+make_terrain(int size) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("terrain", GeomVertexFormat::get_v3(), Geom::UH_static);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  for (int y = 0; y <= size; ++y) {
+    for (int x = 0; x <= size; ++x) {
+      float z = csin(x * 0.1f) * ccos(y * 0.13f) * 3.0f;
+      vertex.add_data3f(x, y, z);
+    }
+  }
+
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      int a = y * (size + 1) + x;
+      int b = a + 1;
+      int c = a + size + 1;
+      int d = c + 1;
+      tris->add_vertices(a, b, d);
+      tris->add_vertices(a, d, c);
+    }
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  PT(GeomNode) gnode = new GeomNode("terrain");
+  gnode->add_geom(geom);
+  return gnode;
+}
+
+static PT(CollisionNode)
+make_spheres(int size) {
+  Randomizer random(2);
+  PT(CollisionNode) cnode = new CollisionNode("spheres");
+  for (int i = 0; i < num_spheres; ++i) {
+    LPoint3f center(random.random_real(size), random.random_real(size),
+                    random.random_real(5.0));
+    cnode->add_solid(new CollisionSphere(center, 0.2f + random.random_real(0.5)));
+  }
+  return cnode;
+}
+
+// Traverses the scene and returns a digest of the collisions found,
+// in the order they were reported.
+static double
+run_traversal(CollisionTraverser &trav, CollisionHandlerQueue *queue,
+              const NodePath &root, int &num_entries) {
+  trav.traverse(root);
+
+  num_entries = queue->get_num_entries();
+  double digest = 0.0;
+  for (int i = 0; i < num_entries; ++i) {
+    CollisionEntry *entry = queue->get_entry(i);
+    LPoint3f p = entry->get_surface_point(root);
+    digest += (i + 1) * (p[0] + p[1] * 3.0 + p[2] * 7.0);
+  }
+  return digest;
+}
+
+int
+main(int argc, char *argv[]) {
+  int size = 200;
+  if (argc > 1) {
+    size = max(atoi(argv[1]), 2);
+  }
+
+  NodePath root("root");
+  PT(GeomNode) terrain = make_terrain(size);
+  root.attach_new_node(terrain);
+  root.attach_new_node(make_spheres(size));
+
+  CollisionTraverser trav;
+  PT(CollisionHandlerQueue) queue = new CollisionHandlerQueue;
+
+  Randomizer random(1);
+  for (int i = 0; i < num_rays; ++i) {
+    PT(CollisionNode) cnode = new CollisionNode("ray");
+    cnode->add_solid(new CollisionRay(LPoint3f(0.0f, 0.0f, 10.0f),
+                                      LVector3f(0.0f, 0.0f, -1.0f)));
+    cnode->set_into_collide_mask(CollideMask::all_off());
+    NodePath ray = root.attach_new_node(cnode);
+    ray.set_pos(random.random_real(size), random.random_real(size), 0.0f);
+    trav.add_collider(ray, queue);
+  }
+
+  nout << "Terrain has " << size * size * 2 << " triangles; "
+       << num_spheres << " spheres, " << num_rays << " rays.\n";
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  // First, without the BVH.
+  int saved_min_items = collide_bvh_min_items;
+  collide_bvh_min_items.set_value(0);
+
+  int linear_entries = 0;
+  double linear_digest = 0.0;
+  double start = clock->get_short_time();
+  for (int n = 0; n < num_frames; ++n) {
+    linear_digest = run_traversal(trav, queue, root, linear_entries);
+  }
+  double linear_time = (clock->get_short_time() - start) / num_frames;
+
+  // Now with the BVH.  The first traversal builds it.
+  collide_bvh_min_items.set_value(max(saved_min_items, 1));
+
+  start = clock->get_short_time();
+  int bvh_entries = 0;
+  double bvh_digest = run_traversal(trav, queue, root, bvh_entries);
+  double build_time = clock->get_short_time() - start;
+
+  start = clock->get_short_time();
+  for (int n = 0; n < num_frames; ++n) {
+    bvh_digest = run_traversal(trav, queue, root, bvh_entries);
+  }
+  double bvh_time = (clock->get_short_time() - start) / num_frames;
+
+  CollisionBVH *bvh = DCAST(CollisionBVH, terrain->get_collision_accel());
+  if (bvh != (CollisionBVH *)NULL) {
+    nout << *bvh << "\n";
+  }
+
+  nout << "Without BVH: " << linear_entries << " entries, "
+       << linear_time * 1000.0 << " ms per traversal.\n"
+       << "With BVH:    " << bvh_entries << " entries, "
+       << bvh_time * 1000.0 << " ms per traversal ("
+       << build_time * 1000.0 << " ms for the first, including the build).\n";
+
+  bool ok = (linear_entries == bvh_entries && linear_digest == bvh_digest);
+  nout << (ok ? "Results agree.\n" : "RESULTS DIFFER!\n");
+  return ok ? 0 : 1;
+}
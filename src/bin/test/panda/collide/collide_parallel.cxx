@@ -0,0 +1,148 @@
+// Filename: collide_parallel.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "collisionTraverser.h"
+#include "collisionNode.h"
+#include "collisionSphere.h"
+#include "collisionHandlerQueue.h"
+#include "collisionEntry.h"
+#include "config_collide.h"
+#include "nodePath.h"
+#include "randomizer.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program builds a scene graph of many small CollisionNodes,
+// grouped under a hierarchy of parent nodes, and moves a large number
+// of colliders through it.  It traverses the scene first on a single
+// thread and then with collide-num-threads, and checks that both
+// traversals deliver the same collisions to the handlers in the same
+// order.  Run it with a number of colliders on the command line, e.g.
+// "collide_parallel 1000".
+
+static const int num_groups = 20;
+static const int nodes_per_group = 50;
+static const float world_size = 100.0f;
+static const int num_frames = 5;
+
+class Collision {
+public:
+  PandaNode *_from;
+  PandaNode *_into;
+  const CollisionSolid *_into_solid;
+  LPoint3f _point;
+};
+typedef pvector<Collision> Collisions;
+
+static void
+make_scene(const NodePath &root) {
+  Randomizer random(3);
+  for (int g = 0; g < num_groups; ++g) {
+    NodePath group = root.attach_new_node("group");
+    for (int n = 0; n < nodes_per_group; ++n) {
+      PT(CollisionNode) cnode = new CollisionNode("target");
+      for (int s = 0; s < 3; ++s) {
+        LPoint3f center(random.random_real(world_size),
+                        random.random_real(world_size),
+                        random.random_real(world_size));
+        cnode->add_solid(new CollisionSphere(center, 1.0f + random.random_real(2.0)));
+      }
+      cnode->set_from_collide_mask(CollideMask::all_off());
+      group.attach_new_node(cnode);
+    }
+  }
+}
+
+static void
+run_traversal(CollisionTraverser &trav, CollisionHandlerQueue *queue,
+              const NodePath &root, Collisions &collisions) {
+  trav.traverse(root);
+
+  collisions.clear();
+  int num_entries = queue->get_num_entries();
+  for (int i = 0; i < num_entries; ++i) {
+    CollisionEntry *entry = queue->get_entry(i);
+    Collision c;
+    c._from = entry->get_from_node();
+    c._into = entry->get_into_node();
+    c._into_solid = entry->get_into();
+    c._point = entry->get_surface_point(root);
+    collisions.push_back(c);
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_colliders = 1000;
+  if (argc > 1) {
+    num_colliders = max(atoi(argv[1]), 1);
+  }
+
+  NodePath root("root");
+  make_scene(root);
+
+  CollisionTraverser trav;
+  PT(CollisionHandlerQueue) queue = new CollisionHandlerQueue;
+
+  Randomizer random(4);
+  for (int i = 0; i < num_colliders; ++i) {
+    PT(CollisionNode) cnode = new CollisionNode("collider");
+    cnode->add_solid(new CollisionSphere(LPoint3f::zero(), 2.0f));
+    cnode->set_into_collide_mask(CollideMask::all_off());
+    NodePath collider = root.attach_new_node(cnode);
+    collider.set_pos(random.random_real(world_size),
+                     random.random_real(world_size),
+                     random.random_real(world_size));
+    trav.add_collider(collider, queue);
+  }
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  int saved_num_threads = collide_num_threads;
+  collide_num_threads.set_value(0);
+
+  Collisions serial;
+  double start = clock->get_short_time();
+  for (int n = 0; n < num_frames; ++n) {
+    run_traversal(trav, queue, root, serial);
+  }
+  double serial_time = (clock->get_short_time() - start) / num_frames;
+
+  collide_num_threads.set_value(max(saved_num_threads, 4));
+
+  Collisions parallel;
+  start = clock->get_short_time();
+  for (int n = 0; n < num_frames; ++n) {
+    run_traversal(trav, queue, root, parallel);
+  }
+  double parallel_time = (clock->get_short_time() - start) / num_frames;
+
+  bool ok = (serial.size() == parallel.size());
+  for (size_t i = 0; ok && i < serial.size(); ++i) {
+    ok = (serial[i]._from == parallel[i]._from &&
+          serial[i]._into == parallel[i]._into &&
+          serial[i]._into_solid == parallel[i]._into_solid &&
+          serial[i]._point == parallel[i]._point);
+  }
+
+  nout << num_colliders << " colliders, "
+       << num_groups * nodes_per_group << " target nodes.\n"
+       << "Serial:   " << serial.size() << " entries, "
+       << serial_time * 1000.0 << " ms per traversal.\n"
+       << "Parallel: " << parallel.size() << " entries, "
+       << parallel_time * 1000.0 << " ms per traversal with "
+       << collide_num_threads << " threads.\n"
+       << (ok ? "Results agree.\n" : "RESULTS DIFFER!\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+// Filename: display_munge_cache.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "display_tiny_test.h"
+#include "graphicsStateGuardian.h"
+#include "standardMunger.h"
+#include "renderState.h"
+#include "geomVertexRewriter.h"
+#include "geomCacheManager.h"
+#include "bamCache.h"
+#include "configVariableInt.h"
+#include "randomizer.h"
+
+// This program munges a scene of many Geoms whose vertex colors are
+// packed in DirectX order, the way egg2pg stores them, for a GSG that
+// wants them as four bytes, the way the OpenGL munger converts them.
+// It munges the scene once with model-cache-munged-geoms off, and
+// twice with it on: first with an empty cache, and then again after
+// the in-memory munge cache has been flushed, as on a later run of the
+// same program.  It reports the time taken by each, and fails if the
+// munged vertex data read from the cache differs from the data
+// munged directly.  Every other Geom is a mirror image of the one
+// before it, which differs from it only in the sign bits of its
+// vertices, so that the cache must tell them apart.  Run it with a
+// number of Geoms and a number of vertices in each, e.g.
+// "display_munge_cache 500 4000".
+
+// Converts packed colors to four bytes, as CLP(GeomMunger) does.
+// tinydisplay's own munger never changes the vertex format.
+class PackedColorMunger : public StandardMunger {
+public:
+  PackedColorMunger(GraphicsStateGuardian *gsg) :
+    StandardMunger(gsg, RenderState::make_empty(), 4, NT_uint8, C_color) {
+  }
+
+protected:
+  virtual CPT(GeomVertexFormat) munge_format_impl(const GeomVertexFormat *orig,
+                                                  const GeomVertexAnimationSpec &animation) {
+    PT(GeomVertexFormat) new_format = new GeomVertexFormat(*orig);
+    new_format->set_animation(animation);
+
+    const GeomVertexColumn *color_type = orig->get_color_column();
+    if (color_type != (GeomVertexColumn *)NULL &&
+        color_type->get_numeric_type() == NT_packed_dabc) {
+      int color_array = orig->get_array_with(InternalName::get_color());
+      PT(GeomVertexArrayFormat) new_array_format = new_format->modify_array(color_array);
+      new_array_format->add_column
+        (InternalName::get_color(), 4, NT_uint8, C_color, color_type->get_start());
+    }
+
+    return GeomVertexFormat::register_format(new_format);
+  }
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    StandardMunger::init_type();
+    register_type(_type_handle, "PackedColorMunger",
+                  StandardMunger::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+TypeHandle PackedColorMunger::_type_handle;
+
+typedef pvector< CPT(Geom) > Geoms;
+typedef pvector< CPT(GeomVertexData) > Datas;
+
+static void
+make_scene(Geoms &geoms, int num_geoms, int num_vertices) {
+  Randomizer random(7);
+  for (int g = 0; g < num_geoms; ++g) {
+    if (g % 2 == 1) {
+      PT(GeomVertexData) vdata = new GeomVertexData(*geoms.back()->get_vertex_data());
+      GeomVertexRewriter vertex(vdata, InternalName::get_vertex());
+      while (!vertex.is_at_end()) {
+        LVecBase3f v = vertex.get_data3f();
+        vertex.set_data3f(-v[0], v[1], v[2]);
+      }
+      PT(Geom) geom = geoms.back()->make_copy();
+      geom->set_vertex_data(vdata);
+      geoms.push_back(geom);
+      continue;
+    }
+
+    PT(GeomVertexData) vdata = new GeomVertexData
+      ("scene", GeomVertexFormat::get_v3n3cpt2(), Geom::UH_static);
+    vdata->unclean_set_num_rows(num_vertices);
+    GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+    GeomVertexWriter normal(vdata, InternalName::get_normal());
+    GeomVertexWriter color(vdata, InternalName::get_color());
+    GeomVertexWriter texcoord(vdata, InternalName::get_texcoord());
+    for (int i = 0; i < num_vertices; ++i) {
+      vertex.set_data3f(random.random_real(10.0), random.random_real(10.0),
+                        random.random_real(10.0));
+      normal.set_data3f(0.0f, 0.0f, 1.0f);
+      color.set_data4f(random.random_real(1.0), random.random_real(1.0),
+                       random.random_real(1.0), 1.0f);
+      texcoord.set_data2f(random.random_real(1.0), random.random_real(1.0));
+    }
+
+    PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+    for (int i = 0; i + 2 < num_vertices; i += 3) {
+      tris->add_vertices(i, i + 1, i + 2);
+    }
+    PT(Geom) geom = new Geom(vdata);
+    geom->add_primitive(tris);
+    geoms.push_back(geom);
+  }
+}
+
+static double
+munge_scene(GeomMunger *munger, const Geoms &geoms, Datas &results) {
+  // Forget what was munged before, as a new run of the program would.
+  GeomCacheManager::get_global_ptr()->flush();
+
+  Thread *current_thread = Thread::get_current_thread();
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+
+  results.clear();
+  Geoms::const_iterator gi;
+  for (gi = geoms.begin(); gi != geoms.end(); ++gi) {
+    CPT(Geom) geom = (*gi);
+    CPT(GeomVertexData) data = geom->get_vertex_data(current_thread);
+    munger->munge_geom(geom, data, true, current_thread);
+    results.push_back(data);
+  }
+
+  return clock->get_short_time() - start;
+}
+
+// Returns the number of vertex datas that differ between a and b.
+static int
+count_data_differ(const Datas &a, const Datas &b) {
+  int num_differ = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    bool same = (a[i]->get_format() == b[i]->get_format() &&
+                 a[i]->get_num_arrays() == b[i]->get_num_arrays());
+    for (int j = 0; same && j < a[i]->get_num_arrays(); ++j) {
+      same = (a[i]->get_array(j)->get_handle()->get_data() ==
+              b[i]->get_array(j)->get_handle()->get_data());
+    }
+    if (!same) {
+      ++num_differ;
+    }
+  }
+  return num_differ;
+}
+
+static int
+count_cache_files(const Filename &dirname) {
+  vector_string contents;
+  dirname.scan_directory(contents);
+  int count = 0;
+  for (size_t i = 0; i < contents.size(); ++i) {
+    if (Filename(contents[i]).get_extension() == "vdo") {
+      ++count;
+    }
+  }
+  return count;
+}
+
+static void
+remove_cache(const Filename &dirname) {
+  vector_string contents;
+  dirname.scan_directory(contents);
+  for (size_t i = 0; i < contents.size(); ++i) {
+    Filename(dirname, contents[i]).unlink();
+  }
+  rmdir(dirname.to_os_specific().c_str());
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_geoms = 500;
+  int num_vertices = 4000;
+  if (argc > 1) {
+    num_geoms = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_vertices = max(atoi(argv[2]), 3);
+  }
+
+#ifndef HAVE_OPENSSL
+  nout << "The munge cache requires OpenSSL.\n";
+  return 0;
+#endif  // HAVE_OPENSSL
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  GraphicsOutput *buffer = open_tiny_buffer("munge cache", 16);
+  engine->open_windows();
+  GraphicsStateGuardian *gsg = buffer->get_gsg();
+  if (gsg == (GraphicsStateGuardian *)NULL) {
+    nout << "No GSG.\n";
+    exit(1);
+  }
+
+  PackedColorMunger::init_type();
+  PT(GeomMunger) munger = GeomMunger::register_munger
+    (new PackedColorMunger(gsg), Thread::get_current_thread());
+
+  Filename cache_dir = Filename::temporary("", "munge_cache");
+  cache_dir.make_dir();
+  BamCache *cache = BamCache::get_global_ptr();
+  cache->set_root(cache_dir);
+  cache->set_active(true);
+  cache->set_read_only(false);
+
+  // Cache even small vertex datas, if that's what was asked for.
+  ConfigVariableInt munge_cache_min_vertices("munge-cache-min-vertices");
+  munge_cache_min_vertices.set_value(0);
+
+  Geoms geoms;
+  make_scene(geoms, num_geoms, num_vertices);
+  nout << num_geoms << " Geoms of " << num_vertices << " vertices.\n";
+
+  Datas direct, cold, warm;
+  cache->set_cache_munged_geoms(false);
+  double direct_time = munge_scene(munger, geoms, direct);
+
+  cache->set_cache_munged_geoms(true);
+  double cold_time = munge_scene(munger, geoms, cold);
+  int num_files = count_cache_files(cache_dir);
+  double warm_time = munge_scene(munger, geoms, warm);
+
+  nout << "Without the munge cache: " << direct_time * 1000.0 << " ms\n"
+       << "Empty munge cache:       " << cold_time * 1000.0 << " ms ("
+       << num_files << " entries stored)\n"
+       << "Full munge cache:        " << warm_time * 1000.0 << " ms\n";
+
+  int cold_differ = count_data_differ(direct, cold);
+  int warm_differ = count_data_differ(direct, warm);
+  bool ok = (cold_differ == 0 && warm_differ == 0 && num_files == num_geoms &&
+             count_cache_files(cache_dir) == num_files);
+
+  cache->set_cache_munged_geoms(false);
+  cache->flush_index();
+  remove_cache(cache_dir);
+  engine->remove_all_windows();
+
+  if (!ok) {
+    nout << cold_differ << " and " << warm_differ
+         << " vertex datas differ; " << num_files << " entries stored.\n";
+    return 1;
+  }
+  nout << "Cached vertex data matches.\n";
+  return 0;
+}
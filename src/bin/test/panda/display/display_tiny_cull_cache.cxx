@@ -0,0 +1,108 @@
+// Filename: display_tiny_cull_cache.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "display_tiny_test.h"
+#include "cullCacheNode.h"
+#include "configVariableBool.h"
+#include "randomizer.h"
+
+// This program renders a town of many small buildings, each its own
+// GeomNode, below a CullCacheNode, into an offscreen tinydisplay
+// buffer.  It renders the town from a still camera with cull-cache
+// off and then on, reporting the frames per second of each, and then
+// moves the camera and does it again; the images rendered with and
+// without the cache must be identical.  Run it with a number of
+// buildings and an image size, e.g. "display_tiny_cull_cache 20000 256".
+
+static const int num_frames = 20;
+
+static NodePath
+make_town(int num_buildings) {
+  NodePath root("root");
+  NodePath town = root.attach_new_node(new CullCacheNode("town"));
+
+  Randomizer random(5);
+  float extent = 2.0f * csqrt((float)num_buildings);
+  for (int i = 0; i < num_buildings; ++i) {
+    Colorf color(0.5f + random.random_real(0.5), 0.5f + random.random_real(0.5),
+                 0.5f + random.random_real(0.5), 1.0f);
+    NodePath building = make_box("building", color);
+    building.reparent_to(town);
+    building.set_pos(random.random_real(extent * 2.0f) - extent,
+                     random.random_real(extent * 2.0f) - extent,
+                     0.0f);
+    building.set_scale(0.5f + random.random_real(1.0),
+                       0.5f + random.random_real(1.0),
+                       0.5f + random.random_real(3.0));
+  }
+  return root;
+}
+
+static double
+render(GraphicsEngine *engine, GraphicsOutput *buffer, bool use_cache,
+       PNMImage &image) {
+  ConfigVariableBool cull_cache("cull-cache");
+  cull_cache.set_value(use_cache);
+  return render_frames(engine, buffer, num_frames, image);
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_buildings = 20000;
+  int size = 256;
+  if (argc > 1) {
+    num_buildings = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    size = max(atoi(argv[2]), 16);
+  }
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  GraphicsOutput *buffer = open_tiny_buffer("cull cache", size);
+
+  NodePath root = make_town(num_buildings);
+  CullCacheNode *town = DCAST(CullCacheNode, root.get_child(0).node());
+
+  NodePath camera_np;
+  make_camera(buffer, root, camera_np, Colorf(0.5f, 0.7f, 0.9f, 1.0f));
+  camera_np.set_pos(0.0f, 0.0f, 3.0f);
+  camera_np.set_hpr(30.0f, -5.0f, 0.0f);
+
+  nout << num_buildings << " buildings, " << size << "x" << size << ".\n";
+
+  bool ok = true;
+  for (int view = 0; view < 2; ++view) {
+    PNMImage plain_image, cached_image;
+    double plain_fps = render(engine, buffer, false, plain_image);
+    double cached_fps = render(engine, buffer, true, cached_image);
+    int num_differ = count_differ(plain_image, cached_image);
+
+    nout << "View " << view << ": without cache " << plain_fps
+         << " fps, with cache " << cached_fps << " fps, "
+         << town->get_num_cached_objects() << " objects cached, "
+         << num_differ << " pixels differ.\n";
+    ok = ok && (num_differ == 0) && (town->get_num_cached_objects() > 0);
+
+    // Turn the camera for the next view; the cache must notice.
+    camera_np.set_hpr(150.0f, -10.0f, 0.0f);
+  }
+
+  nout << (ok ? "Images match.\n" : "IMAGES DIFFER!\n");
+
+  engine->remove_all_windows();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Filename: display_tiny_instancing.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "display_tiny_test.h"
+#include "instancedNode.h"
+#include "transformState.h"
+#include "randomizer.h"
+
+// This program renders a forest of identical trees into an offscreen
+// tinydisplay buffer, first with a separate node for each tree, and
+// then with a single InstancedNode holding one instance per tree.
+// The camera stands inside the forest, so that many of the trees are
+// outside the view frustum.  It reports the frames per second of each
+// and fails if the two images are not identical.  The instance
+// transforms are composed in a different order from the separate
+// nodes' transforms, so the trees are placed at whole-unit positions
+// with scales of a few bits, and the camera is not rotated, so that
+// every product is exact either way.  Run it with a number of trees
+// and an image size, e.g. "display_tiny_instancing 5000 512".
+
+static const int num_frames = 20;
+static const int tree_sides = 12;
+
+static void
+add_cone(GeomVertexWriter &vertex, GeomVertexWriter &color,
+         GeomTriangles *tris, float bottom, float top, float radius,
+         const Colorf &base_color) {
+  int start = vertex.get_write_row();
+  vertex.add_data3f(0.0f, 0.0f, top);
+  color.add_data4f(base_color * 1.2f);
+  for (int i = 0; i < tree_sides; ++i) {
+    float angle = 2.0f * MathNumbers::pi_f * i / tree_sides;
+    vertex.add_data3f(radius * cosf(angle), radius * sinf(angle), bottom);
+    float shade = 0.6f + 0.4f * (i % 2);
+    color.add_data4f(base_color[0] * shade, base_color[1] * shade,
+                     base_color[2] * shade, 1.0f);
+  }
+  for (int i = 0; i < tree_sides; ++i) {
+    tris->add_vertices(start, start + 1 + i, start + 1 + (i + 1) % tree_sides);
+  }
+}
+
+static NodePath
+make_tree() {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    ("tree", GeomVertexFormat::get_v3c4(), Geom::UH_static);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter color(vdata, InternalName::get_color());
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+
+  add_cone(vertex, color, tris, 0.0f, 1.5f, 0.2f, Colorf(0.4f, 0.25f, 0.1f, 1.0f));
+  add_cone(vertex, color, tris, 1.0f, 3.0f, 1.2f, Colorf(0.1f, 0.5f, 0.15f, 1.0f));
+  add_cone(vertex, color, tris, 2.2f, 4.0f, 0.9f, Colorf(0.15f, 0.6f, 0.2f, 1.0f));
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  PT(GeomNode) gnode = new GeomNode("tree");
+  gnode->add_geom(geom);
+  return NodePath(gnode);
+}
+
+// Returns the transform of each tree, scattered over a square around
+// the origin.
+static pvector< CPT(TransformState) >
+make_placements(int num_trees) {
+  Randomizer random(17);
+  int extent = (int)(2.0f * csqrt((float)num_trees)) + 1;
+  pvector< CPT(TransformState) > placements;
+  placements.reserve(num_trees);
+  for (int i = 0; i < num_trees; ++i) {
+    LPoint3f pos((float)(random.random_int(extent * 2) - extent),
+                 (float)(random.random_int(extent * 2) - extent),
+                 0.0f);
+    float scale = 0.75f + 0.125f * random.random_int(5);
+    placements.push_back(TransformState::make_pos_hpr_scale
+                         (pos, LVecBase3f::zero(), LVecBase3f(scale, scale, scale)));
+  }
+  return placements;
+}
+
+static NodePath
+make_separate_forest(const pvector< CPT(TransformState) > &placements) {
+  NodePath root("separate");
+  NodePath tree = make_tree();
+  for (size_t i = 0; i < placements.size(); ++i) {
+    NodePath copy = tree.copy_to(root);
+    copy.set_transform(placements[i]);
+  }
+  return root;
+}
+
+static NodePath
+make_instanced_forest(const pvector< CPT(TransformState) > &placements) {
+  NodePath root("instanced");
+  PT(InstancedNode) inode = new InstancedNode("forest");
+  PT(InstanceList) instances = inode->modify_instances();
+  instances->reserve(placements.size());
+  for (size_t i = 0; i < placements.size(); ++i) {
+    instances->add_instance(placements[i]);
+  }
+  NodePath forest = root.attach_new_node(inode);
+  make_tree().reparent_to(forest);
+  return root;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_trees = 5000;
+  int size = 512;
+  if (argc > 1) {
+    num_trees = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    size = max(atoi(argv[2]), 16);
+  }
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  GraphicsOutput *buffer = open_tiny_buffer("instancing", size);
+
+  pvector< CPT(TransformState) > placements = make_placements(num_trees);
+  NodePath separate = make_separate_forest(placements);
+  NodePath instanced = make_instanced_forest(placements);
+
+  NodePath camera_np;
+  make_camera(buffer, separate, camera_np, Colorf(0.5f, 0.7f, 0.9f, 1.0f));
+  camera_np.set_pos(0.5f, 0.5f, 2.0f);
+
+  PNMImage separate_image;
+  double separate_fps = render_frames(engine, buffer, num_frames, separate_image);
+
+  camera_np.reparent_to(instanced);
+  PNMImage instanced_image;
+  double instanced_fps = render_frames(engine, buffer, num_frames, instanced_image);
+
+  int num_differ = count_differ(separate_image, instanced_image);
+  bool ok = (num_differ == 0);
+
+  nout << num_trees << " trees, " << size << "x" << size << ".\n"
+       << "Separate nodes: " << separate_fps << " fps.\n"
+       << "InstancedNode:  " << instanced_fps << " fps.\n"
+       << num_differ << " pixels differ.\n"
+       << (ok ? "Images match.\n" : "IMAGES DIFFER!\n");
+
+  engine->remove_all_windows();
+  return ok ? 0 : 1;
+}
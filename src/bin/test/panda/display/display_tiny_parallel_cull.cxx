@@ -0,0 +1,127 @@
+// Filename: display_tiny_parallel_cull.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "display_tiny_test.h"
+#include "config_pgraph.h"
+#include "transparencyAttrib.h"
+#include "randomizer.h"
+
+// This program renders a town of many small buildings, grouped into
+// blocks, into an offscreen tinydisplay buffer: first with the cull
+// traversal on the cull thread alone, and then split at the blocks
+// among the number of cull-num-threads given on the command line
+// (default 4).  Some of the blocks are transparent, and one is drawn
+// in the fixed bin, so that the images depend on the workers' results
+// being merged into the bins in order.  It reports the frames per
+// second of each, from two views, and fails if the images are not
+// identical.  Run it with a number of threads, a number of buildings
+// and an image size, e.g. "display_tiny_parallel_cull 4 20000 256".
+
+static const int num_frames = 20;
+static const int num_blocks = 64;
+
+static NodePath
+make_town(int num_buildings) {
+  NodePath root("root");
+  NodePath town = root.attach_new_node("town");
+
+  Randomizer random(5);
+  float extent = 2.0f * csqrt((float)num_buildings);
+
+  pvector<NodePath> blocks;
+  for (int b = 0; b < num_blocks; ++b) {
+    NodePath block = town.attach_new_node("block");
+    if (b % 4 == 1) {
+      block.set_transparency(TransparencyAttrib::M_alpha);
+      block.set_color_scale(1.0f, 1.0f, 1.0f, 0.5f);
+    } else if (b == 2) {
+      block.set_bin("fixed", 10);
+    }
+    blocks.push_back(block);
+  }
+
+  for (int i = 0; i < num_buildings; ++i) {
+    Colorf color(0.5f + random.random_real(0.5), 0.5f + random.random_real(0.5),
+                 0.5f + random.random_real(0.5), 1.0f);
+    NodePath building = make_box("building", color);
+    building.reparent_to(blocks[random.random_int(num_blocks)]);
+    building.set_pos(random.random_real(extent * 2.0f) - extent,
+                     random.random_real(extent * 2.0f) - extent,
+                     0.0f);
+    building.set_scale(0.5f + random.random_real(1.0),
+                       0.5f + random.random_real(1.0),
+                       0.5f + random.random_real(3.0));
+  }
+  return root;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_threads = 4;
+  int num_buildings = 20000;
+  int size = 256;
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_buildings = max(atoi(argv[2]), 1);
+  }
+  if (argc > 3) {
+    size = max(atoi(argv[3]), 16);
+  }
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  GraphicsOutput *buffer = open_tiny_buffer("parallel cull", size);
+
+  NodePath root = make_town(num_buildings);
+
+  NodePath camera_np;
+  make_camera(buffer, root, camera_np, Colorf(0.5f, 0.7f, 0.9f, 1.0f));
+  camera_np.set_pos(0.0f, 0.0f, 3.0f);
+  camera_np.set_hpr(30.0f, -5.0f, 0.0f);
+
+  // The blocks are the children of the town, two levels below the
+  // scene root.
+  cull_split_depth = 2;
+
+  nout << num_buildings << " buildings in " << num_blocks << " blocks, "
+       << size << "x" << size << ".\n";
+
+  bool ok = true;
+  for (int view = 0; view < 2; ++view) {
+    PNMImage serial_image, parallel_image;
+    cull_num_threads = 0;
+    double serial_fps = render_frames(engine, buffer, num_frames, serial_image);
+    cull_num_threads = num_threads;
+    double parallel_fps = render_frames(engine, buffer, num_frames, parallel_image);
+    int num_differ = count_differ(serial_image, parallel_image);
+
+    nout << "View " << view << ": serial " << serial_fps << " fps, "
+         << num_threads << " threads " << parallel_fps << " fps, "
+         << num_differ << " pixels differ.\n";
+    ok = ok && (num_differ == 0);
+
+    // Look back across the town, so the transparent blocks sort the
+    // other way.
+    camera_np.set_hpr(210.0f, -10.0f, 0.0f);
+  }
+
+  nout << (ok ? "Images match.\n" : "IMAGES DIFFER!\n");
+
+  engine->remove_all_windows();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// Filename: display_tiny_software_occlusion.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "display_tiny_test.h"
+#include "cullTraverser.h"
+#include "cullCacheNode.h"
+#include "softwareOcclusionCullTraverser.h"
+#include "occlusionDepthBuffer.h"
+#include "configVariableBool.h"
+#include "randomizer.h"
+
+// This program renders a town of many small buildings, each its own
+// GeomNode, most of which are hidden behind a long wall, into an
+// offscreen tinydisplay buffer.  It renders the town with the default
+// CullTraverser, and then with a SoftwareOcclusionCullTraverser using
+// the wall as the occluder, first with software-occlusion-simd on and
+// then off, reporting the frames per second of each.  The images must
+// all be identical, the SSE2 and scalar depth buffers must be
+// identical, and some buildings must have been culled.
+//
+// The town is below a CullCacheNode, with cull-cache on.  Finally the
+// wall is moved out of the way while the camera stays still, and the
+// buildings it uncovers must appear, just as they do without
+// occlusion culling.  Run it with a number of buildings and an image
+// size, e.g. "display_tiny_software_occlusion 20000 256".
+
+static const int num_frames = 20;
+
+static NodePath
+make_town(int num_buildings, const DrawMask &occluder_mask) {
+  NodePath root("root");
+  root.hide(occluder_mask);
+
+  // The wall runs across the view, not far in front of the camera.
+  NodePath wall = make_box("wall", Colorf(0.6f, 0.5f, 0.4f, 1.0f));
+  wall.reparent_to(root);
+  wall.set_pos(0.0f, 15.0f, 0.0f);
+  wall.set_scale(40.0f, 1.0f, 12.0f);
+  wall.show_through(occluder_mask);
+
+  // The town lies behind it, and spreads out beyond its ends.
+  NodePath town = root.attach_new_node(new CullCacheNode("town"));
+  Randomizer random(5);
+  float extent = csqrt((float)num_buildings);
+  for (int i = 0; i < num_buildings; ++i) {
+    Colorf color(0.5f + random.random_real(0.5), 0.5f + random.random_real(0.5),
+                 0.5f + random.random_real(0.5), 1.0f);
+    NodePath building = make_box("building", color);
+    building.reparent_to(town);
+    building.set_pos(random.random_real(extent * 8.0f) - extent * 4.0f,
+                     20.0f + random.random_real(extent * 4.0f),
+                     0.0f);
+    building.set_scale(0.5f + random.random_real(1.0),
+                       0.5f + random.random_real(1.0),
+                       0.5f + random.random_real(3.0));
+  }
+  return root;
+}
+
+// Copies out every level of the depth buffer.
+static void
+get_depths(const OcclusionDepthBuffer *depth_buffer, pvector<float> &depths) {
+  depths.clear();
+  for (int li = 0; li < depth_buffer->get_num_levels(); ++li) {
+    for (int y = 0; y < depth_buffer->get_level_y_size(li); ++y) {
+      for (int x = 0; x < depth_buffer->get_level_x_size(li); ++x) {
+        depths.push_back(depth_buffer->get_depth(x, y, li));
+      }
+    }
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_buildings = 20000;
+  int size = 256;
+  if (argc > 1) {
+    num_buildings = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    size = max(atoi(argv[2]), 16);
+  }
+
+  ConfigVariableBool cull_cache("cull-cache");
+  cull_cache.set_value(true);
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  GraphicsOutput *buffer = open_tiny_buffer("software occlusion", size);
+
+  DrawMask occluder_mask = DrawMask::bit(1);
+  NodePath root = make_town(num_buildings, occluder_mask);
+  NodePath wall = root.find("wall");
+
+  NodePath camera_np;
+  DisplayRegion *dr = make_camera(buffer, root, camera_np,
+                                  Colorf(0.5f, 0.7f, 0.9f, 1.0f));
+  camera_np.set_pos(0.0f, 0.0f, 3.0f);
+  camera_np.set_hpr(0.0f, -2.0f, 0.0f);
+
+  nout << num_buildings << " buildings, " << size << "x" << size << ".\n";
+
+  PT(CullTraverser) plain_trav = new CullTraverser;
+  PNMImage plain_image;
+  dr->set_cull_traverser(plain_trav);
+  double plain_fps = render_frames(engine, buffer, num_frames, plain_image);
+  nout << "Without occlusion culling: " << plain_fps << " fps.\n";
+
+  PT(SoftwareOcclusionCullTraverser) trav = new SoftwareOcclusionCullTraverser;
+  trav->set_occlusion_mask(occluder_mask);
+  dr->set_cull_traverser(trav);
+
+  ConfigVariableBool software_occlusion_simd("software-occlusion-simd");
+  bool ok = true;
+  pvector<float> simd_depths, scalar_depths;
+  for (int simd = 1; simd >= 0; --simd) {
+    software_occlusion_simd.set_value(simd != 0);
+    PNMImage image;
+    double fps = render_frames(engine, buffer, num_frames, image);
+    int num_differ = count_differ(plain_image, image);
+
+    nout << "With occlusion culling, " << (simd ? "SSE2" : "scalar")
+         << ": " << fps << " fps, " << trav->get_num_occluded() << " of "
+         << trav->get_num_tested() << " nodes occluded, "
+         << num_differ << " pixels differ.\n";
+    ok = ok && (num_differ == 0) && (trav->get_num_occluded() > 0);
+
+    get_depths(trav->get_depth_buffer(), simd ? simd_depths : scalar_depths);
+  }
+
+  if (simd_depths != scalar_depths) {
+    nout << "SSE2 and scalar depth buffers differ.\n";
+    ok = false;
+  }
+
+  // Now lower the wall into the ground.  Nothing below the town's
+  // CullCacheNode has changed, but the buildings behind the wall
+  // must appear.
+  wall.set_z(-20.0f);
+  PNMImage moved_image, moved_plain_image;
+  render_frames(engine, buffer, num_frames, moved_image);
+  dr->set_cull_traverser(plain_trav);
+  render_frames(engine, buffer, num_frames, moved_plain_image);
+
+  int num_uncovered = count_differ(plain_image, moved_plain_image);
+  int num_differ = count_differ(moved_plain_image, moved_image);
+  nout << "With the wall lowered: " << num_uncovered
+       << " pixels uncovered, " << num_differ << " pixels differ.\n";
+  ok = ok && (num_uncovered > 0) && (num_differ == 0);
+
+  nout << (ok ? "Images match.\n" : "IMAGES DIFFER!\n");
+
+  engine->remove_all_windows();
+  return ok ? 0 : 1;
+}
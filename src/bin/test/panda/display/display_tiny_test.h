@@ -0,0 +1,167 @@
+// Filename: display_tiny_test.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef DISPLAY_TINY_TEST_H
+#define DISPLAY_TINY_TEST_H
+
+#include "pandabase.h"
+
+#include "graphicsEngine.h"
+#include "graphicsPipeSelection.h"
+#include "graphicsOutput.h"
+#include "displayRegion.h"
+#include "frameBufferProperties.h"
+#include "windowProperties.h"
+#include "camera.h"
+#include "perspectiveLens.h"
+#include "nodePath.h"
+#include "geomNode.h"
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexWriter.h"
+#include "pnmImage.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// The pieces shared by the display_tiny_* programs, each of which
+// renders a scene into an offscreen tinydisplay buffer in two or more
+// ways, and checks that the images are identical.
+
+// Opens an offscreen tinydisplay buffer of the indicated size, or
+// exits the program if it can't.
+inline GraphicsOutput *
+open_tiny_buffer(const string &name, int size) {
+  GraphicsPipeSelection *selection = GraphicsPipeSelection::get_global_ptr();
+  PT(GraphicsPipe) pipe = selection->make_pipe("TinyOffscreenGraphicsPipe", "tinydisplay");
+  if (pipe.is_null()) {
+    nout << "Could not load tinydisplay.\n";
+    exit(1);
+  }
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  GraphicsOutput *buffer = engine->make_output
+    (pipe, name, 0, FrameBufferProperties::get_default(),
+     WindowProperties::size(size, size), GraphicsPipe::BF_refuse_window);
+  if (buffer == (GraphicsOutput *)NULL) {
+    nout << "Could not open an offscreen buffer.\n";
+    exit(1);
+  }
+  return buffer;
+}
+
+// Creates a camera below root, and a display region of the buffer
+// that views the scene through it.
+inline DisplayRegion *
+make_camera(GraphicsOutput *buffer, const NodePath &root, NodePath &camera_np,
+            const Colorf &clear_color) {
+  PT(Camera) camera = new Camera("camera");
+  camera->set_lens(new PerspectiveLens);
+  camera_np = root.attach_new_node(camera);
+
+  DisplayRegion *dr = buffer->make_display_region();
+  dr->set_camera(camera_np);
+  buffer->set_clear_color(clear_color);
+  buffer->set_clear_color_active(true);
+  return dr;
+}
+
+// Renders one untimed frame, to load textures and fill caches, and
+// then num_frames timed frames.  Stores the final image, and returns
+// the frames per second.
+inline double
+render_frames(GraphicsEngine *engine, GraphicsOutput *buffer, int num_frames,
+              PNMImage &image) {
+  engine->render_frame();
+  engine->sync_frame();
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  for (int n = 0; n < num_frames; ++n) {
+    engine->render_frame();
+  }
+  engine->sync_frame();
+  double elapsed = clock->get_short_time() - start;
+
+  buffer->get_screenshot(image);
+  return num_frames / elapsed;
+}
+
+// Returns the number of pixels that differ between the two images.
+inline int
+count_differ(const PNMImage &a, const PNMImage &b) {
+  if (a.get_x_size() != b.get_x_size() || a.get_y_size() != b.get_y_size()) {
+    return a.get_x_size() * a.get_y_size();
+  }
+  bool alpha = a.has_alpha() && b.has_alpha();
+  int num_differ = 0;
+  for (int y = 0; y < a.get_y_size(); ++y) {
+    for (int x = 0; x < a.get_x_size(); ++x) {
+      if (a.get_red_val(x, y) != b.get_red_val(x, y) ||
+          a.get_green_val(x, y) != b.get_green_val(x, y) ||
+          a.get_blue_val(x, y) != b.get_blue_val(x, y) ||
+          (alpha && a.get_alpha_val(x, y) != b.get_alpha_val(x, y))) {
+        ++num_differ;
+      }
+    }
+  }
+  return num_differ;
+}
+
+// Makes a unit box, standing on the origin, with four shaded walls
+// and a roof: a building, or a wall when it is scaled.
+inline NodePath
+make_box(const string &name, const Colorf &color) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    (name, GeomVertexFormat::get_v3c4(), Geom::UH_static);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter cwriter(vdata, InternalName::get_color());
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+
+  static const float corners[4][2] = {
+    { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f }
+  };
+  for (int i = 0; i < 4; ++i) {
+    const float *a = corners[i];
+    const float *b = corners[(i + 1) % 4];
+    float shade = 0.6f + 0.1f * i;
+    int start = vertex.get_write_row();
+    vertex.add_data3f(a[0], a[1], 0.0f);
+    vertex.add_data3f(b[0], b[1], 0.0f);
+    vertex.add_data3f(b[0], b[1], 1.0f);
+    vertex.add_data3f(a[0], a[1], 1.0f);
+    for (int j = 0; j < 4; ++j) {
+      cwriter.add_data4f(color[0] * shade, color[1] * shade, color[2] * shade, 1.0f);
+    }
+    tris->add_vertices(start, start + 1, start + 2);
+    tris->add_vertices(start, start + 2, start + 3);
+  }
+  int start = vertex.get_write_row();
+  for (int i = 0; i < 4; ++i) {
+    vertex.add_data3f(corners[i][0], corners[i][1], 1.0f);
+    cwriter.add_data4f(color);
+  }
+  tris->add_vertices(start, start + 1, start + 2);
+  tris->add_vertices(start, start + 2, start + 3);
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  PT(GeomNode) gnode = new GeomNode(name);
+  gnode->add_geom(geom);
+  return NodePath(gnode);
+}
+
+#endif
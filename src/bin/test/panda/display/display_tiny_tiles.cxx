@@ -0,0 +1,169 @@
+// Filename: display_tiny_tiles.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "display_tiny_test.h"
+#include "texture.h"
+#include "configVariableInt.h"
+#include "configVariableBool.h"
+#include "randomizer.h"
+
+// This program renders a scene of many overlapping smooth-shaded
+// triangles, some of them textured and some of them blended, into an
+// offscreen tinydisplay buffer.  It renders the scene first with the
+// serial rasterizer and the scalar triangle fillers, then with the
+// SSE2 fillers enabled by td-simd, and then with those and
+// td-num-threads as well.  It reports the frames per second of each,
+// and checks that all of the images are bit-identical.  Run it with a
+// number of triangles, a number of threads and an image size, e.g.
+// "display_tiny_tiles 20000 4 1024".
+
+static const int num_frames = 20;
+
+static PT(Texture)
+make_texture() {
+  PNMImage image(64, 64, 4);
+  for (int y = 0; y < 64; ++y) {
+    for (int x = 0; x < 64; ++x) {
+      bool on = (((x >> 3) ^ (y >> 3)) & 1) != 0;
+      image.set_xel(x, y, on ? 1.0 : 0.2, x / 63.0, y / 63.0);
+      image.set_alpha(x, y, on ? 1.0 : 0.5);
+    }
+  }
+  PT(Texture) tex = new Texture("checker");
+  tex->load(image);
+  return tex;
+}
+
+static NodePath
+make_triangles(const string &name, int num_triangles, Randomizer &random) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    (name, GeomVertexFormat::get_v3c4t2(), Geom::UH_static);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter color(vdata, InternalName::get_color());
+  GeomVertexWriter texcoord(vdata, InternalName::get_texcoord());
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+
+  for (int i = 0; i < num_triangles; ++i) {
+    LPoint3f center(random.random_real(20.0) - 10.0,
+                    random.random_real(20.0) + 10.0,
+                    random.random_real(20.0) - 10.0);
+    float size = 0.5f + random.random_real(3.0);
+    for (int v = 0; v < 3; ++v) {
+      vertex.add_data3f(center + LVector3f(random.random_real(size * 2.0) - size,
+                                           random.random_real(size * 2.0) - size,
+                                           random.random_real(size * 2.0) - size));
+      color.add_data4f(random.random_real(1.0), random.random_real(1.0),
+                       random.random_real(1.0), 0.5f + random.random_real(0.5));
+      texcoord.add_data2f(random.random_real(2.0), random.random_real(2.0));
+    }
+    tris->add_next_vertices(3);
+    tris->close_primitive();
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+  PT(GeomNode) gnode = new GeomNode(name);
+  gnode->add_geom(geom);
+  return NodePath(gnode);
+}
+
+static NodePath
+make_scene(int num_triangles) {
+  Randomizer random(11);
+  NodePath root("root");
+
+  int per_group = max(num_triangles / 4, 1);
+  make_triangles("smooth", per_group, random).reparent_to(root);
+
+  NodePath textured = make_triangles("textured", per_group, random);
+  textured.set_texture(make_texture());
+  textured.reparent_to(root);
+
+  NodePath blended = make_triangles("blended", per_group, random);
+  blended.set_transparency(TransparencyAttrib::M_alpha);
+  blended.set_bin("fixed", 10);
+  blended.reparent_to(root);
+
+  NodePath both = make_triangles("both", per_group, random);
+  both.set_texture(make_texture());
+  both.set_transparency(TransparencyAttrib::M_alpha);
+  both.set_bin("fixed", 20);
+  both.reparent_to(root);
+
+  return root;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_triangles = 20000;
+  int num_threads = 4;
+  int size = 1024;
+  if (argc > 1) {
+    num_triangles = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_threads = max(atoi(argv[2]), 1);
+  }
+  if (argc > 3) {
+    size = max(atoi(argv[3]), 16);
+  }
+
+  ConfigVariableInt td_num_threads("td-num-threads");
+  td_num_threads.set_value(0);
+  ConfigVariableBool td_simd("td-simd");
+  td_simd.set_value(false);
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  GraphicsOutput *buffer = open_tiny_buffer("tiles", size);
+
+  NodePath render_root = make_scene(num_triangles);
+  NodePath camera_np;
+  make_camera(buffer, render_root, camera_np, Colorf(0.1f, 0.1f, 0.3f, 1.0f));
+
+  nout << num_triangles << " triangles, " << size << "x" << size << ".\n";
+
+  PNMImage scalar_image;
+  double scalar_fps = render_frames(engine, buffer, num_frames, scalar_image);
+  nout << "Serial, scalar: " << scalar_fps << " fps.\n";
+
+  bool ok = true;
+  for (int pass = 0; pass < 2; ++pass) {
+    // First the SSE2 fillers alone, on the draw thread, so the timing
+    // reflects the fillers; then the tiled rasterizer as well.
+    td_simd.set_value(true);
+    td_num_threads.set_value(pass == 0 ? 0 : num_threads);
+
+    PNMImage image;
+    double fps = render_frames(engine, buffer, num_frames, image);
+    int num_differ = count_differ(scalar_image, image);
+    if (pass == 0) {
+      nout << "Serial, SIMD:   ";
+    } else {
+      nout << "Tiled, SIMD:    ";
+    }
+    nout << fps << " fps";
+    if (pass != 0) {
+      nout << " with " << num_threads << " threads";
+    }
+    nout << ", " << num_differ << " pixels differ.\n";
+    ok = ok && (num_differ == 0);
+  }
+
+  nout << (ok ? "Images are identical.\n" : "IMAGES DIFFER!\n");
+
+  engine->remove_all_windows();
+  return ok ? 0 : 1;
+}
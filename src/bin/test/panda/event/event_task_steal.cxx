@@ -0,0 +1,148 @@
+// Filename: event_task_steal.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "asyncTask.h"
+#include "asyncTaskManager.h"
+#include "asyncTaskChain.h"
+#include "atomicAdjust.h"
+#include "randomizer.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program runs a large number of very short tasks, spread over
+// a few sort values, on a threaded task chain: first with the usual
+// shared task list, and then in work-stealing mode, with the tasks
+// handed over with AsyncTaskChain::submit().  It reports the time
+// taken by each, and checks that every task ran the expected number
+// of times and that no two tasks with different sort values ever ran
+// at the same time.  Run it with a number of tasks on the command
+// line, e.g. "event_task_steal 20000".
+
+static const int num_sorts = 4;
+static const int num_epochs = 10;
+static const int num_threads = 8;
+
+static TVOLATILE AtomicAdjust::Integer running[num_sorts];
+static TVOLATILE AtomicAdjust::Integer num_runs;
+static TVOLATILE AtomicAdjust::Integer num_overlaps;
+
+class StealTask : public AsyncTask {
+public:
+  StealTask(int work) :
+    AsyncTask("steal"),
+    _work(work),
+    _count(0),
+    _result(0.0)
+  {
+  }
+  ALLOC_DELETED_CHAIN(StealTask);
+
+  virtual DoneStatus do_task() {
+    int sort = get_sort();
+    AtomicAdjust::inc(running[sort]);
+    for (int i = 0; i < num_sorts; ++i) {
+      if (i != sort && AtomicAdjust::get(running[i]) != 0) {
+        AtomicAdjust::inc(num_overlaps);
+      }
+    }
+
+    // A small, uneven amount of busywork.
+    for (int i = 0; i < _work; ++i) {
+      _result += csqrt((double)(i + _count));
+    }
+
+    AtomicAdjust::inc(num_runs);
+    AtomicAdjust::dec(running[sort]);
+
+    ++_count;
+    return (_count < num_epochs) ? DS_cont : DS_done;
+  }
+
+  int _work;
+  int _count;
+  double _result;
+};
+
+static double
+run_tasks(AsyncTaskManager *task_mgr, int num_tasks, bool work_stealing) {
+  AsyncTaskChain *chain = task_mgr->make_task_chain(work_stealing ? "steal" : "shared");
+  chain->set_num_threads(num_threads);
+  chain->set_work_stealing(work_stealing);
+
+  num_runs = 0;
+  num_overlaps = 0;
+
+  // Most tasks are trivial, but a few are a hundred times longer, so
+  // that the threads' shares of the work are badly unbalanced.
+  Randomizer random(5);
+  pvector<PT(AsyncTask)> tasks;
+  tasks.reserve(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    int work = (random.random_int(100) == 0) ? 5000 : 50;
+    PT(AsyncTask) task = new StealTask(work);
+    task->set_sort(random.random_int(num_sorts));
+    task->set_priority(random.random_int(10));
+    tasks.push_back(task);
+  }
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  for (int i = 0; i < num_tasks; ++i) {
+    if (work_stealing) {
+      chain->submit(tasks[i]);
+    } else {
+      tasks[i]->set_task_chain(chain->get_name());
+      task_mgr->add(tasks[i]);
+    }
+  }
+  chain->wait_for_tasks();
+  double elapsed = clock->get_short_time() - start;
+
+  chain->stop_threads();
+  return elapsed;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_tasks = 20000;
+  if (argc > 1) {
+    num_tasks = max(atoi(argv[1]), 1);
+  }
+
+  PT(AsyncTaskManager) task_mgr = new AsyncTaskManager("task_mgr");
+  int expected = num_tasks * num_epochs;
+
+  double shared_time = run_tasks(task_mgr, num_tasks, false);
+  int shared_runs = num_runs;
+  int shared_overlaps = num_overlaps;
+
+  double steal_time = run_tasks(task_mgr, num_tasks, true);
+  int steal_runs = num_runs;
+  int steal_overlaps = num_overlaps;
+
+  bool ok = (shared_runs == expected && steal_runs == expected &&
+             shared_overlaps == 0 && steal_overlaps == 0);
+
+  nout << num_tasks << " tasks, " << num_epochs << " epochs, "
+       << num_threads << " threads.\n"
+       << "Shared list:   " << shared_runs << " runs in "
+       << shared_time * 1000.0 << " ms, "
+       << shared_overlaps << " sort overlaps.\n"
+       << "Work stealing: " << steal_runs << " runs in "
+       << steal_time * 1000.0 << " ms, "
+       << steal_overlaps << " sort overlaps.\n"
+       << (ok ? "Results agree.\n" : "RESULTS DIFFER!\n");
+  return ok ? 0 : 1;
+}
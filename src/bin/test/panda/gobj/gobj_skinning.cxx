@@ -0,0 +1,230 @@
+// Filename: gobj_skinning.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "geom.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexArrayFormat.h"
+#include "geomVertexWriter.h"
+#include "geomVertexReader.h"
+#include "transformBlendTable.h"
+#include "userVertexTransform.h"
+#include "sparseArray.h"
+#include "config_gobj.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program soft-skins a crowd of characters, 500 by default, on
+// the CPU, for a number of frames: first with vertex-animation-simd
+// off, then with it on, and then with it on and the characters
+// divided among the number of vertex-animation-threads given on the
+// command line (default 4) with GeomVertexData::animate_vertices_batch().
+// It reports the time taken each way, and fails if the skinned
+// vertices are not identical.
+
+static const int num_joints = 24;
+static const int num_vertices = 1500;
+static const int num_frames = 20;
+
+class Character {
+public:
+  pvector< PT(UserVertexTransform) > _joints;
+  PT(GeomVertexData) _vdata;
+};
+
+static const GeomVertexFormat *
+make_format() {
+  PT(GeomVertexArrayFormat) array = new GeomVertexArrayFormat;
+  array->add_column(InternalName::get_vertex(), 3,
+                    Geom::NT_float32, Geom::C_point);
+  array->add_column(InternalName::get_normal(), 3,
+                    Geom::NT_float32, Geom::C_vector);
+
+  PT(GeomVertexArrayFormat) blend_array = new GeomVertexArrayFormat;
+  blend_array->add_column(InternalName::get_transform_blend(), 1,
+                          Geom::NT_uint16, Geom::C_index);
+
+  PT(GeomVertexFormat) format = new GeomVertexFormat;
+  format->add_array(array);
+  format->add_array(blend_array);
+
+  GeomVertexAnimationSpec spec;
+  spec.set_panda();
+  format->set_animation(spec);
+
+  CPT(GeomVertexFormat) registered = GeomVertexFormat::register_format(format);
+  return registered;
+}
+
+static void
+make_character(Character &character, int index) {
+  character._joints.clear();
+  for (int j = 0; j < num_joints; ++j) {
+    character._joints.push_back(new UserVertexTransform("joint"));
+  }
+
+  // Each vertex is influenced by up to four joints, like the
+  // vertices of a typical skinned model.
+  PT(TransformBlendTable) table = new TransformBlendTable;
+  unsigned int seed = index + 1;
+  pvector<int> blend_indices;
+  for (int i = 0; i < num_vertices; ++i) {
+    seed = seed * 1103515245 + 12345;
+    int j0 = (i * num_joints) / num_vertices;
+    int j1 = (j0 + 1) % num_joints;
+    int j2 = (j0 + 2) % num_joints;
+    int j3 = (j0 + 3) % num_joints;
+    float w = (float)((seed >> 16) & 0xff) / 255.0f;
+    TransformBlend blend;
+    switch (i % 4) {
+    case 0:
+      blend = TransformBlend(character._joints[j0], 1.0f);
+      break;
+    case 1:
+      blend = TransformBlend(character._joints[j0], w,
+                             character._joints[j1], 1.0f - w);
+      break;
+    case 2:
+      blend = TransformBlend(character._joints[j0], 0.5f * w,
+                             character._joints[j1], 0.5f,
+                             character._joints[j2], 0.5f - 0.5f * w);
+      break;
+    default:
+      blend = TransformBlend(character._joints[j0], 0.25f * w,
+                             character._joints[j1], 0.25f,
+                             character._joints[j2], 0.25f,
+                             character._joints[j3], 0.5f - 0.25f * w);
+      break;
+    }
+    blend_indices.push_back(table->add_blend(blend));
+  }
+  table->set_rows(SparseArray::lower_on(num_vertices));
+
+  character._vdata = new GeomVertexData("character", make_format(), Geom::UH_dynamic);
+  character._vdata->set_transform_blend_table(table);
+  character._vdata->set_num_rows(num_vertices);
+
+  GeomVertexWriter vertex(character._vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(character._vdata, InternalName::get_normal());
+  GeomVertexWriter blend(character._vdata, InternalName::get_transform_blend());
+  for (int i = 0; i < num_vertices; ++i) {
+    float t = (float)i / (float)num_vertices;
+    vertex.add_data3f(ccos(t * 40.0f), csin(t * 40.0f), t * 2.0f);
+    normal.add_data3f(ccos(t * 40.0f), csin(t * 40.0f), 0.0f);
+    blend.add_data1i(blend_indices[i]);
+  }
+}
+
+static void
+pose_character(Character &character, int index, int frame) {
+  for (int j = 0; j < num_joints; ++j) {
+    float angle = (float)(frame * 3 + j * 7 + index);
+    LMatrix4f mat = LMatrix4f::rotate_mat(angle, LVector3f(0.0f, 1.0f, 1.0f));
+    mat.set_row(3, LVecBase3f(0.01f * j, 0.02f * frame, 0.0f));
+    character._joints[j]->set_matrix(mat);
+  }
+}
+
+static double
+animate_crowd(pvector<Character> &crowd, bool batch, pvector<float> &result) {
+  Thread *current_thread = Thread::get_current_thread();
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double elapsed = 0.0;
+
+  pvector<const GeomVertexData *> vdatas;
+  for (size_t c = 0; c < crowd.size(); ++c) {
+    vdatas.push_back(crowd[c]._vdata);
+  }
+
+  for (int frame = 0; frame < num_frames; ++frame) {
+    for (size_t c = 0; c < crowd.size(); ++c) {
+      pose_character(crowd[c], (int)c, frame);
+    }
+
+    double start = clock->get_short_time();
+    if (batch) {
+      GeomVertexData::animate_vertices_batch(vdatas, current_thread);
+    } else {
+      for (size_t c = 0; c < crowd.size(); ++c) {
+        crowd[c]._vdata->animate_vertices(true, current_thread);
+      }
+    }
+    elapsed += clock->get_short_time() - start;
+  }
+
+  // Collect the final skinned vertices and normals of the whole crowd.
+  result.clear();
+  for (size_t c = 0; c < crowd.size(); ++c) {
+    CPT(GeomVertexData) animated = crowd[c]._vdata->animate_vertices(true, current_thread);
+    GeomVertexReader vertex(animated, InternalName::get_vertex());
+    GeomVertexReader normal(animated, InternalName::get_normal());
+    while (!vertex.is_at_end()) {
+      const LVecBase3f &v = vertex.get_data3f();
+      const LVecBase3f &n = normal.get_data3f();
+      result.push_back(v[0]);
+      result.push_back(v[1]);
+      result.push_back(v[2]);
+      result.push_back(n[0]);
+      result.push_back(n[1]);
+      result.push_back(n[2]);
+    }
+  }
+
+  return elapsed;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_threads = 4;
+  int num_characters = 500;
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_characters = max(atoi(argv[2]), 1);
+  }
+
+  pvector<Character> crowd(num_characters);
+  for (int c = 0; c < num_characters; ++c) {
+    make_character(crowd[c], c);
+  }
+
+  // The worker threads are started the first time they are needed,
+  // so vertex-animation-threads must be set before then.
+  vertex_animation_threads = num_threads;
+  vertex_animation_min_rows = 0;
+
+  pvector<float> scalar, simd, threaded;
+  vertex_animation_simd = false;
+  double scalar_time = animate_crowd(crowd, false, scalar);
+  vertex_animation_simd = true;
+  double simd_time = animate_crowd(crowd, false, simd);
+  double threaded_time = animate_crowd(crowd, true, threaded);
+
+  bool same = (scalar == simd && scalar == threaded);
+
+  double frame_scale = 1000.0 / num_frames;
+  nout << num_characters << " characters of " << num_vertices
+       << " vertices and " << num_joints << " joints, per frame:\n"
+       << "  scalar:            " << scalar_time * frame_scale << " ms\n"
+       << "  simd:              " << simd_time * frame_scale << " ms\n"
+       << "  simd, " << num_threads << " threads:  "
+       << threaded_time * frame_scale << " ms\n"
+       << (same ? "Vertices identical.\n" : "VERTICES DIFFER!\n");
+
+  return same ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Filename: gobj_texture_stream.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "texture.h"
+#include "texturePool.h"
+#include "textureStreamManager.h"
+#include "config_gobj.h"
+#include "asyncTaskManager.h"
+#include "clockObject.h"
+#include "pnmImage.h"
+#include "filename.h"
+#include "pnotify.h"
+
+// This program writes out a 256x256 image, loads it through the
+// TexturePool with texture-streaming enabled, and checks that only
+// the mipmap tail is loaded at first; that the full image is loaded
+// once the texture is reported to cover 256 pixels on screen; and
+// that the fine levels are discarded again, down to the tail, when
+// the budget is reduced.
+
+static bool
+check(bool condition, const char *message) {
+  if (!condition) {
+    nout << "FAILED: " << message << "\n";
+  }
+  return condition;
+}
+
+// Runs the manager's update for one frame, and then waits for any
+// requests it issued to finish loading.
+static void
+run_frame(TextureStreamManager *manager) {
+  ClockObject::get_global_clock()->tick();
+  manager->update();
+
+  AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+  AsyncTaskChain *chain = task_mgr->find_task_chain("texture_stream");
+  while (chain != (AsyncTaskChain *)NULL && chain->get_num_tasks() != 0) {
+    task_mgr->poll();
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  texture_streaming = true;
+  texture_stream_tail_size = 64;
+  texture_stream_threads = 0;
+
+  PNMImage image(256, 256, 3);
+  for (int y = 0; y < 256; ++y) {
+    for (int x = 0; x < 256; ++x) {
+      image.set_xel_val(x, y, x, y, (x + y) / 2);
+    }
+  }
+  Filename filename = Filename::temporary("", "stream_", ".ppm");
+  if (!image.write(filename)) {
+    nout << "Couldn't write " << filename << "\n";
+    return 1;
+  }
+
+  bool ok = true;
+  PT(Texture) tex = TexturePool::load_texture(filename);
+  if (tex == (Texture *)NULL) {
+    nout << "Couldn't load " << filename << "\n";
+    filename.unlink();
+    return 1;
+  }
+
+  TextureStreamManager *manager = TextureStreamManager::get_global_ptr();
+  ok = check(tex->get_streaming(), "texture is not streamed") && ok;
+  ok = check(tex->get_stream_level() == 2 && tex->get_x_size() == 64,
+             "texture should start with the 64x64 tail") && ok;
+  ok = check(tex->get_num_ram_mipmap_images() == 7,
+             "tail should have 7 levels") && ok;
+  nout << "Loaded: level " << tex->get_stream_level() << ", "
+       << tex->get_x_size() << "x" << tex->get_y_size() << ", "
+       << tex->get_stream_resident_size() << " bytes.\n";
+
+  // Not seen on screen yet: nothing more is loaded.
+  run_frame(manager);
+  ok = check(tex->get_stream_level() == 2, "unseen texture was loaded") && ok;
+
+  // Seen at 100 pixels: the 128x128 level is enough.
+  tex->note_stream_screen_size(100);
+  run_frame(manager);
+  ok = check(tex->get_stream_level() == 1 && tex->get_x_size() == 128,
+             "texture should be at 128x128") && ok;
+
+  // Seen at 256 pixels: load the full image.
+  tex->note_stream_screen_size(256);
+  run_frame(manager);
+  ok = check(tex->get_stream_level() == 0 && tex->get_x_size() == 256,
+             "texture should be at 256x256") && ok;
+  ok = check(manager->get_resident_size() >= 256 * 256 * 3,
+             "resident size is too small") && ok;
+  nout << "Streamed in: level " << tex->get_stream_level() << ", "
+       << tex->get_x_size() << "x" << tex->get_y_size() << ", "
+       << tex->get_stream_resident_size() << " bytes.\n";
+
+  // The budget only allows the tail: the fine levels go, even
+  // though the texture still wants them.
+  manager->set_budget(64 * 64 * 3 * 2);
+  tex->note_stream_screen_size(256);
+  run_frame(manager);
+  ok = check(tex->get_stream_level() == 2 && tex->get_x_size() == 64,
+             "texture should be evicted to the tail") && ok;
+  ok = check(manager->get_resident_size() <= 64 * 64 * 3 * 2,
+             "resident size exceeds the budget") && ok;
+  nout << "Evicted: level " << tex->get_stream_level() << ", "
+       << tex->get_x_size() << "x" << tex->get_y_size() << ", "
+       << tex->get_stream_resident_size() << " bytes.\n";
+
+  manager->set_budget(-1);
+  tex->set_streaming(false);
+  ok = check(tex->get_x_size() == 256,
+             "texture should be full size when no longer streamed") && ok;
+
+  TexturePool::release_texture(tex);
+  filename.unlink();
+
+  nout << (ok ? "Texture streaming OK.\n" : "TEXTURE STREAMING FAILED!\n");
+  return ok ? 0 : 1;
+}
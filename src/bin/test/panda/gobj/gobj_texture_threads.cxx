@@ -0,0 +1,138 @@
+// Filename: gobj_texture_threads.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "texture.h"
+#include "config_gobj.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program generates the mipmap levels of a large 2-D texture, a
+// cube map and a 3-D texture, and compresses them with libsquish (if
+// it is available), first with texture-work-threads set to 0 and then
+// with it set to the number given on the command line (default 4).
+// It reports the time taken each way, and fails if the resulting
+// images are not identical.
+
+enum TextureKind {
+  TK_2d,
+  TK_cube_map,
+  TK_3d,
+};
+
+static PT(Texture)
+make_texture(TextureKind kind, int size) {
+  PT(Texture) tex = new Texture("test");
+  switch (kind) {
+  case TK_2d:
+    tex->setup_2d_texture(size, size, Texture::T_unsigned_byte, Texture::F_rgba);
+    break;
+
+  case TK_cube_map:
+    tex->setup_cube_map(size, Texture::T_unsigned_byte, Texture::F_rgba);
+    break;
+
+  case TK_3d:
+    tex->setup_3d_texture(size, size, size, Texture::T_unsigned_byte, Texture::F_rgba);
+    break;
+  }
+
+  // Smooth gradients with some noise, so that the compressor has some
+  // work to do.
+  PTA_uchar image = tex->make_ram_image();
+  unsigned int seed = 1;
+  for (size_t i = 0; i < image.size(); ++i) {
+    seed = seed * 1103515245 + 12345;
+    image[i] = (unsigned char)((i / 4) % 251 + ((seed >> 16) & 0x7));
+  }
+  return tex;
+}
+
+static bool
+process(TextureKind kind, int size, bool compress, int num_threads,
+        pvector<CPTA_uchar> &levels, double &elapsed) {
+  texture_work_threads = num_threads;
+  PT(Texture) tex = make_texture(kind, size);
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  tex->generate_ram_mipmap_images();
+  if (compress && !tex->compress_ram_image(Texture::CM_dxt5, Texture::QL_normal)) {
+    return false;
+  }
+  elapsed = clock->get_short_time() - start;
+
+  levels.clear();
+  for (int n = 0; n < tex->get_num_ram_mipmap_images(); ++n) {
+    levels.push_back(tex->get_ram_mipmap_image(n));
+  }
+  return true;
+}
+
+static bool
+same_levels(const pvector<CPTA_uchar> &a, const pvector<CPTA_uchar> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t n = 0; n < a.size(); ++n) {
+    if (a[n].size() != b[n].size() ||
+        memcmp(a[n].p(), b[n].p(), a[n].size()) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_threads = 4;
+  if (argc > 1) {
+    num_threads = max(atoi(argv[1]), 1);
+  }
+
+  static const struct {
+    TextureKind _kind;
+    const char *_name;
+    int _size;
+  } tests[] = {
+    { TK_2d, "2-d 4096", 4096 },
+    { TK_cube_map, "cube map 1024", 1024 },
+    { TK_3d, "3-d 256", 256 },
+  };
+
+  bool ok = true;
+  for (int ti = 0; ti < 3; ++ti) {
+    for (int compress = 0; compress < 2; ++compress) {
+      pvector<CPTA_uchar> serial, parallel;
+      double serial_time, parallel_time;
+      if (!process(tests[ti]._kind, tests[ti]._size, compress != 0, 0,
+                   serial, serial_time) ||
+          !process(tests[ti]._kind, tests[ti]._size, compress != 0, num_threads,
+                   parallel, parallel_time)) {
+        nout << tests[ti]._name << ": compression not available.\n";
+        continue;
+      }
+
+      bool same = same_levels(serial, parallel);
+      ok = ok && same;
+      nout << tests[ti]._name << (compress ? ", mipmaps + dxt5: " : ", mipmaps: ")
+           << serial_time * 1000.0 << " ms serial, "
+           << parallel_time * 1000.0 << " ms on " << num_threads
+           << " threads" << (same ? "" : ", IMAGES DIFFER") << "\n";
+    }
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// Filename: linmath_simd.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "luse.h"
+#include "lmatrix.h"
+#include "lquaternion.h"
+#include "lsimd.h"
+#include "trueClock.h"
+#include "randomizer.h"
+#include "pvector.h"
+#include "pnotify.h"
+
+// This program compares the scalar and vectorized implementations of
+// the kernels in LSimd, first checking that they agree, and then
+// timing each of them.
+
+static const int num_matrices = 256;
+static const int num_points = 100000;
+static const int matrix_iterations = 20000;
+static const int point_iterations = 50;
+
+static pvector<LMatrix4f> matrices;
+static pvector<LQuaternionf> quats;
+static pvector<LPoint3f> points;
+static pvector<LPoint3f> results;
+
+static void
+make_data() {
+  Randomizer random(1);
+  for (int i = 0; i < num_matrices; ++i) {
+    LMatrix4f mat;
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) {
+        mat(r, c) = random.random_real(2.0) - 1.0;
+      }
+    }
+    // Make sure it's not affine, so invert_from() takes the general
+    // path.
+    mat(3, 3) += 2.0f;
+    matrices.push_back(mat);
+
+    LQuaternionf quat(random.random_real(2.0) - 1.0,
+                      random.random_real(2.0) - 1.0,
+                      random.random_real(2.0) - 1.0,
+                      random.random_real(2.0) - 1.0);
+    quat.normalize();
+    quats.push_back(quat);
+  }
+
+  for (int i = 0; i < num_points; ++i) {
+    points.push_back(LPoint3f(random.random_real(100.0),
+                              random.random_real(100.0),
+                              random.random_real(100.0)));
+  }
+  results.resize(num_points);
+}
+
+// Runs each of the kernels once over the test data, and accumulates
+// the results into a checksum-like sum that can be compared between
+// the implementations.
+static LVecBase4f
+run_once() {
+  LVecBase4f sum(0.0f, 0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < num_matrices; ++i) {
+    const LMatrix4f &a = matrices[i];
+    const LMatrix4f &b = matrices[(i + 1) % num_matrices];
+    LMatrix4f m = a * b;
+    LMatrix4f inv;
+    inv.invert_from(m);
+    LMatrix4f ident = inv * m;
+    sum[0] += m(1, 2) + ident(0, 0) + ident(2, 1);
+
+    LQuaternionf q = quats[i] * quats[(i + 1) % num_matrices];
+    sum[1] += q[0] + q[3];
+  }
+
+  matrices[0].xform_point_array(&results[0], &points[0], num_points);
+  for (int i = 0; i < num_points; i += 97) {
+    sum[2] += results[i][0] + results[i][2];
+  }
+  return sum;
+}
+
+static void
+time_level(LSimd::Level level) {
+  LSimd::set_level(level);
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  LMatrix4f m;
+  double start = clock->get_short_time();
+  for (int n = 0; n < matrix_iterations; ++n) {
+    for (int i = 0; i < num_matrices - 1; ++i) {
+      m.multiply(matrices[i], matrices[i + 1]);
+    }
+  }
+  double multiply_time = clock->get_short_time() - start;
+
+  start = clock->get_short_time();
+  for (int n = 0; n < matrix_iterations / 4; ++n) {
+    for (int i = 0; i < num_matrices; ++i) {
+      m.invert_from(matrices[i]);
+    }
+  }
+  double invert_time = clock->get_short_time() - start;
+
+  LQuaternionf q;
+  start = clock->get_short_time();
+  for (int n = 0; n < matrix_iterations; ++n) {
+    for (int i = 0; i < num_matrices - 1; ++i) {
+      q = quats[i] * quats[i + 1];
+    }
+  }
+  double quat_time = clock->get_short_time() - start;
+
+  start = clock->get_short_time();
+  for (int n = 0; n < point_iterations; ++n) {
+    matrices[n % num_matrices].xform_point_array(&results[0], &points[0],
+                                                 num_points);
+  }
+  double batch_time = clock->get_short_time() - start;
+
+  start = clock->get_short_time();
+  for (int n = 0; n < point_iterations; ++n) {
+    const LMatrix4f &mat = matrices[n % num_matrices];
+    for (int i = 0; i < num_points; ++i) {
+      results[i] = mat.xform_point(points[i]);
+    }
+  }
+  double loop_time = clock->get_short_time() - start;
+
+  double num_mults = (double)matrix_iterations * (num_matrices - 1);
+  double num_inverts = (double)(matrix_iterations / 4) * num_matrices;
+  double num_xforms = (double)point_iterations * num_points;
+
+  nout << LSimd::get_level_name(level) << ":\n"
+       << "  multiply:          " << multiply_time * 1.0e9 / num_mults << " ns\n"
+       << "  invert_from:       " << invert_time * 1.0e9 / num_inverts << " ns\n"
+       << "  quat multiply:     " << quat_time * 1.0e9 / num_mults << " ns\n"
+       << "  xform_point_array: " << batch_time * 1.0e9 / num_xforms << " ns/point\n"
+       << "  xform_point loop:  " << loop_time * 1.0e9 / num_xforms << " ns/point\n";
+}
+
+int
+main(int argc, char *argv[]) {
+  make_data();
+
+  LSimd::Level supported = LSimd::get_supported_level();
+  nout << "Supported level: " << LSimd::get_level_name(supported) << "\n";
+
+  LSimd::set_level(LSimd::L_none);
+  LVecBase4f scalar_sum = run_once();
+  LSimd::set_level(supported);
+  LVecBase4f simd_sum = run_once();
+
+  bool ok = scalar_sum.almost_equal(simd_sum, 0.01f);
+  nout << "Scalar results: " << scalar_sum << "\n"
+       << "Vector results: " << simd_sum << "\n"
+       << (ok ? "Results agree.\n" : "RESULTS DIFFER!\n");
+
+  time_level(LSimd::L_none);
+  if (supported != LSimd::L_none) {
+    time_level(supported);
+  }
+
+  return ok ? 0 : 1;
+}
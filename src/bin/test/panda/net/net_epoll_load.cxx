@@ -0,0 +1,184 @@
+// Filename: net_epoll_load.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netDatagram.h"
+#include "configVariableBool.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "pnotify.h"
+
+#include <sys/select.h>
+
+// This program opens a large number of loopback TCP clients against
+// a QueuedConnectionReader, has each of them send a burst of
+// datagrams, and measures how long it takes the reader to receive
+// them all: first with select(), and then with net-use-epoll.  The
+// select() run is skipped if there are too many connections for an
+// fd_set.  Run it with a port, a number of clients and a number of
+// datagrams per client, e.g. "net_epoll_load 4500 10000 20"; more
+// than about 500 clients will need a larger "ulimit -n".
+
+static const int num_reader_threads = 4;
+static const double max_wait = 60.0;
+
+static bool
+run_load(int port, int num_clients, int num_datagrams, bool use_epoll,
+         double &elapsed, int &num_received) {
+  elapsed = 0.0;
+  num_received = 0;
+
+  ConfigVariableBool net_use_epoll("net-use-epoll");
+  net_use_epoll.set_value(use_epoll);
+
+  QueuedConnectionManager cm;
+  PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, 1024);
+  if (rendezvous.is_null()) {
+    nout << "Cannot grab port " << port << ".\n";
+    return false;
+  }
+
+  QueuedConnectionListener listener(&cm, 0);
+  listener.add_connection(rendezvous);
+  QueuedConnectionReader reader(&cm, num_reader_threads);
+  ConnectionWriter writer(&cm, 0);
+
+  // Open the clients, accepting each one on the server side as we
+  // go, so the listen backlog never fills up.
+  typedef pvector< PT(Connection) > Connections;
+  Connections clients, servers;
+  for (int i = 0; i < num_clients; ++i) {
+    PT(Connection) client = cm.open_TCP_client_connection("127.0.0.1", port, 5000);
+    if (client.is_null()) {
+      nout << "Could only open " << i << " clients.\n";
+      return false;
+    }
+    clients.push_back(client);
+
+    while ((int)servers.size() <= i) {
+      while (listener.new_connection_available()) {
+        PT(Connection) server;
+        if (listener.get_new_connection(server)) {
+          reader.add_connection(server);
+          servers.push_back(server);
+        }
+      }
+      if ((int)servers.size() <= i) {
+        Thread::force_yield();
+      }
+    }
+  }
+
+  NetDatagram datagram;
+  for (int j = 0; j < 64; ++j) {
+    datagram.add_uint32(j);
+  }
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+
+  int expected = num_clients * num_datagrams;
+  for (int d = 0; d < num_datagrams; ++d) {
+    Connections::iterator ci;
+    for (ci = clients.begin(); ci != clients.end(); ++ci) {
+      writer.send(datagram, (*ci));
+    }
+
+    // Drain what has arrived so far, so the queue doesn't fill up.
+    while (reader.data_available()) {
+      NetDatagram received;
+      if (reader.get_data(received)) {
+        ++num_received;
+      }
+    }
+  }
+
+  while (num_received < expected &&
+         clock->get_short_time() - start < max_wait) {
+    if (reader.data_available()) {
+      NetDatagram received;
+      if (reader.get_data(received)) {
+        ++num_received;
+      }
+    } else {
+      Thread::sleep(0.0005);
+    }
+  }
+  elapsed = clock->get_short_time() - start;
+
+  Connections::iterator ci;
+  for (ci = clients.begin(); ci != clients.end(); ++ci) {
+    cm.close_connection(*ci);
+  }
+  for (ci = servers.begin(); ci != servers.end(); ++ci) {
+    cm.close_connection(*ci);
+  }
+  cm.close_connection(rendezvous);
+
+  return num_received == expected;
+}
+
+int
+main(int argc, char *argv[]) {
+  if (argc < 2) {
+    nout << "net_epoll_load port [num_clients [num_datagrams]]\n";
+    exit(1);
+  }
+
+  int port = atoi(argv[1]);
+  int num_clients = 1000;
+  int num_datagrams = 20;
+  if (argc > 2) {
+    num_clients = max(atoi(argv[2]), 1);
+  }
+  if (argc > 3) {
+    num_datagrams = max(atoi(argv[3]), 1);
+  }
+  int expected = num_clients * num_datagrams;
+
+  nout << num_clients << " clients, " << num_datagrams
+       << " datagrams each, " << num_reader_threads << " reader threads.\n";
+
+  bool ok = true;
+
+  // Both ends of each connection are in this process, and select()
+  // can't handle descriptors beyond FD_SETSIZE.
+  if (num_clients * 2 + 16 < FD_SETSIZE) {
+    double elapsed;
+    int num_received;
+    bool select_ok = run_load(port, num_clients, num_datagrams, false,
+                              elapsed, num_received);
+    nout << "select(): received " << num_received << " of " << expected
+         << " in " << elapsed * 1000.0 << " ms.\n";
+    ok = ok && select_ok;
+  } else {
+    nout << "select(): skipped, too many connections.\n";
+  }
+
+  double elapsed;
+  int num_received;
+  bool epoll_ok = run_load(port + 1, num_clients, num_datagrams, true,
+                           elapsed, num_received);
+  nout << "epoll:    received " << num_received << " of " << expected
+       << " in " << elapsed * 1000.0 << " ms.\n";
+  ok = ok && epoll_ok;
+
+  nout << (ok ? "All datagrams received.\n" : "DATAGRAMS LOST!\n");
+  return ok ? 0 : 1;
+}
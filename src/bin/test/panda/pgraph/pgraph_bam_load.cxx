@@ -0,0 +1,193 @@
+// Filename: pgraph_bam_load.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "loader.h"
+#include "loaderOptions.h"
+#include "bamFile.h"
+#include "bamWriter.h"
+#include "pandaNode.h"
+#include "geomNode.h"
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexWriter.h"
+#include "texture.h"
+#include "textureAttrib.h"
+#include "renderState.h"
+#include "config_util.h"
+#include "randomizer.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program writes a bam file holding many large vertex arrays and
+// texture images, then loads it back first without and then with
+// LoaderOptions::LF_parallel_decode, timing each load and checking
+// that both produce the same data.  It then writes the same scene again
+// with bam-aligned-payloads and loads that file first by copying the
+// payloads and then by mapping the file, also timing the first pass
+// over the loaded data.  Run it with the number of nodes on the command
+// line, e.g. "pgraph_bam_load 200".
+
+static const int rows_per_node = 16384;
+static const int texture_size = 256;
+static const char *bam_filename = "pgraph_bam_load.bam";
+static const char *aligned_filename = "pgraph_bam_load_aligned.bam";
+
+static PT(PandaNode)
+make_scene(int num_nodes) {
+  Randomizer random(5);
+  PT(PandaNode) root = new PandaNode("root");
+
+  for (int n = 0; n < num_nodes; ++n) {
+    PT(GeomVertexData) vdata = new GeomVertexData
+      ("vdata", GeomVertexFormat::get_v3n3t2(), Geom::UH_static);
+    vdata->unclean_set_num_rows(rows_per_node);
+    GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+    GeomVertexWriter normal(vdata, InternalName::get_normal());
+    GeomVertexWriter texcoord(vdata, InternalName::get_texcoord());
+    for (int i = 0; i < rows_per_node; ++i) {
+      vertex.add_data3f(random.random_real(100.0), random.random_real(100.0),
+                        random.random_real(100.0));
+      normal.add_data3f(0.0f, 0.0f, 1.0f);
+      texcoord.add_data2f(random.random_real(1.0), random.random_real(1.0));
+    }
+
+    PT(GeomTriangles) triangles = new GeomTriangles(Geom::UH_static);
+    triangles->add_next_vertices(rows_per_node - rows_per_node % 3);
+    triangles->close_primitive();
+
+    PT(Geom) geom = new Geom(vdata);
+    geom->add_primitive(triangles);
+
+    PT(Texture) tex = new Texture("tex");
+    tex->setup_2d_texture(texture_size, texture_size,
+                          Texture::T_unsigned_byte, Texture::F_rgba);
+    PTA_uchar image = tex->modify_ram_image();
+    for (size_t i = 0; i < image.size(); ++i) {
+      image[i] = (unsigned char)random.random_int(256);
+    }
+
+    PT(GeomNode) gnode = new GeomNode("geom");
+    gnode->add_geom(geom, RenderState::make(TextureAttrib::make(tex)));
+    root->add_child(gnode);
+  }
+
+  return root;
+}
+
+// Returns a checksum of all of the vertex and texture data under the
+// node.
+static unsigned int
+checksum(PandaNode *root) {
+  unsigned int sum = 0;
+  int num_children = root->get_num_children();
+  for (int n = 0; n < num_children; ++n) {
+    GeomNode *gnode = DCAST(GeomNode, root->get_child(n));
+    CPT(GeomVertexData) vdata = gnode->get_geom(0)->get_vertex_data();
+    for (int a = 0; a < vdata->get_num_arrays(); ++a) {
+      CPT(GeomVertexArrayDataHandle) handle = vdata->get_array(a)->get_handle();
+      const unsigned char *p = handle->get_read_pointer(true);
+      size_t size = handle->get_data_size_bytes();
+      for (size_t i = 0; i < size; ++i) {
+        sum = sum * 31 + p[i];
+      }
+    }
+
+    const TextureAttrib *tattrib = DCAST(TextureAttrib, gnode->get_geom_state(0)->get_attrib(TextureAttrib::get_class_slot()));
+    CPTA_uchar image = tattrib->get_texture()->get_ram_image();
+    for (size_t i = 0; i < image.size(); ++i) {
+      sum = sum * 31 + image[i];
+    }
+  }
+  return sum;
+}
+
+static bool
+write_bam(const char *filename, PandaNode *scene, bool aligned) {
+  BamFile bam;
+  if (!bam.open_write(filename)) {
+    return false;
+  }
+  bam.get_writer()->set_file_texture_mode(BTM_rawdata);
+  bam.get_writer()->set_aligned_payloads(aligned);
+  bam.write_object(scene);
+  bam.close();
+  return true;
+}
+
+// Loads the named bam file, and returns the time spent loading it and
+// the time spent in the first pass over the loaded data.
+static void
+load(const char *filename, bool parallel, bool mapped,
+     double &load_time, double &touch_time, unsigned int &sum) {
+  int flags = LoaderOptions::LF_report_errors | LoaderOptions::LF_no_cache;
+  if (parallel) {
+    flags |= LoaderOptions::LF_parallel_decode;
+  }
+  LoaderOptions options(flags);
+  bam_map_payloads.set_value(mapped);
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  PT(PandaNode) model = Loader::get_global_ptr()->load_sync(filename, options);
+  double loaded = clock->get_short_time();
+  load_time = loaded - start;
+
+  nassertv(model != (PandaNode *)NULL);
+  sum = checksum(model);
+  touch_time = clock->get_short_time() - loaded;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_nodes = 200;
+  if (argc > 1) {
+    num_nodes = max(atoi(argv[1]), 1);
+  }
+
+  PT(PandaNode) scene = make_scene(num_nodes);
+  unsigned int original_sum = checksum(scene);
+  if (!write_bam(bam_filename, scene, false) ||
+      !write_bam(aligned_filename, scene, true)) {
+    return 1;
+  }
+  scene.clear();
+
+  double serial_time, parallel_time, copied_time, mapped_time;
+  double serial_touch, parallel_touch, copied_touch, mapped_touch;
+  unsigned int serial_sum, parallel_sum, copied_sum, mapped_sum;
+  load(bam_filename, false, false, serial_time, serial_touch, serial_sum);
+  load(bam_filename, true, false, parallel_time, parallel_touch, parallel_sum);
+  load(aligned_filename, false, false, copied_time, copied_touch, copied_sum);
+  load(aligned_filename, false, true, mapped_time, mapped_touch, mapped_sum);
+
+  bool ok = (serial_sum == original_sum && parallel_sum == original_sum &&
+             copied_sum == original_sum && mapped_sum == original_sum);
+
+  nout << num_nodes << " nodes.\n"
+       << "Serial decode:   " << serial_time * 1000.0 << " ms.\n"
+       << "Parallel decode: " << parallel_time * 1000.0 << " ms with "
+       << bam_decode_threads << " threads.\n"
+       << "Aligned, copied: load " << copied_time * 1000.0
+       << " ms, first pass " << copied_touch * 1000.0 << " ms.\n"
+       << "Aligned, mapped: load " << mapped_time * 1000.0
+       << " ms, first pass " << mapped_touch * 1000.0 << " ms.\n"
+       << (ok ? "Results agree.\n" : "RESULTS DIFFER!\n");
+
+  Filename(bam_filename).unlink();
+  Filename(aligned_filename).unlink();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// Filename: pgraph_bounds_incremental.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "pandaNode.h"
+#include "boundingSphere.h"
+#include "transformState.h"
+#include "configVariableBool.h"
+#include "randomizer.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program builds a scene of many groups of small nodes, twice:
+// once normally, and once with bounds-incremental set.  Each frame it
+// moves a few of the nodes in both scenes, and then asks for the
+// bounding volume of the root.  It reports the time spent on this
+// and the number of children read by update_bounds() for each scene,
+// and checks that the incrementally computed bounds still enclose
+// every node.  Run it with a number of groups, a number of nodes per
+// group, a number of nodes to move per frame and a number of frames,
+// e.g. "pgraph_bounds_incremental 100 200 20 500".
+
+typedef pvector< PT(PandaNode) > Leaves;
+
+static PT(PandaNode)
+make_scene(int num_groups, int num_leaves, bool incremental,
+           Leaves &leaves) {
+  ConfigVariableBool bounds_incremental("bounds-incremental");
+  bounds_incremental.set_value(incremental);
+
+  Randomizer random(1);
+  PT(PandaNode) root = new PandaNode("root");
+  for (int g = 0; g < num_groups; ++g) {
+    PT(PandaNode) group = new PandaNode("group");
+    root->add_child(group);
+    for (int l = 0; l < num_leaves; ++l) {
+      PT(PandaNode) leaf = new PandaNode("leaf");
+      leaf->set_bounds(new BoundingSphere(LPoint3f::origin(), 1.0f));
+      leaf->set_transform(TransformState::make_pos
+                          (LVecBase3f(random.random_real(1000.0),
+                                      random.random_real(1000.0),
+                                      random.random_real(100.0))));
+      group->add_child(leaf);
+      leaves.push_back(leaf);
+    }
+  }
+
+  // Compute the initial bounds now, so that it isn't counted below.
+  root->get_bounds();
+  return root;
+}
+
+// Returns true if the root's bounding sphere encloses the sphere
+// around each of the leaves.
+static bool
+check_bounds(PandaNode *root, const Leaves &leaves) {
+  CPT(BoundingVolume) bounds = root->get_bounds();
+  const BoundingSphere *sphere = bounds->as_bounding_sphere();
+  nassertr(sphere != (BoundingSphere *)NULL, false);
+
+  Leaves::const_iterator li;
+  for (li = leaves.begin(); li != leaves.end(); ++li) {
+    LPoint3f pos = (*li)->get_transform()->get_pos();
+    float dist = (pos - sphere->get_center()).length() + 1.0f;
+    if (dist > sphere->get_radius() * 1.0001f + 0.001f) {
+      nout << "Leaf at " << pos << " is outside " << *sphere << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_groups = 100;
+  int num_leaves = 200;
+  int num_moves = 20;
+  int num_frames = 500;
+  if (argc > 1) {
+    num_groups = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_leaves = max(atoi(argv[2]), 1);
+  }
+  if (argc > 3) {
+    num_moves = max(atoi(argv[3]), 0);
+  }
+  if (argc > 4) {
+    num_frames = max(atoi(argv[4]), 1);
+  }
+
+  nout << num_groups << " groups of " << num_leaves << " nodes, moving "
+       << num_moves << " nodes per frame for " << num_frames
+       << " frames.\n";
+
+  Leaves full_leaves, incremental_leaves;
+  PT(PandaNode) full_root = 
+    make_scene(num_groups, num_leaves, false, full_leaves);
+  PT(PandaNode) incremental_root =
+    make_scene(num_groups, num_leaves, true, incremental_leaves);
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  Randomizer random(2);
+  double full_time = 0.0, incremental_time = 0.0;
+  int full_reads = 0, incremental_reads = 0;
+  int num_incremental = PandaNode::get_num_incremental_bounds_updates();
+  bool ok = true;
+
+  for (int f = 0; f < num_frames && ok; ++f) {
+    for (int m = 0; m < num_moves; ++m) {
+      int li = random.random_int((int)full_leaves.size());
+      CPT(TransformState) transform = TransformState::make_pos
+        (LVecBase3f(random.random_real(1000.0),
+                    random.random_real(1000.0),
+                    random.random_real(100.0)));
+      full_leaves[li]->set_transform(transform);
+      incremental_leaves[li]->set_transform(transform);
+    }
+
+    int reads = PandaNode::get_num_bounds_child_reads();
+    double start = clock->get_short_time();
+    full_root->get_bounds();
+    double mid = clock->get_short_time();
+    full_reads += PandaNode::get_num_bounds_child_reads() - reads;
+
+    reads = PandaNode::get_num_bounds_child_reads();
+    incremental_root->get_bounds();
+    double end = clock->get_short_time();
+    incremental_reads += PandaNode::get_num_bounds_child_reads() - reads;
+
+    full_time += mid - start;
+    incremental_time += end - mid;
+
+    ok = check_bounds(incremental_root, incremental_leaves);
+  }
+  num_incremental = PandaNode::get_num_incremental_bounds_updates() - num_incremental;
+
+  nout << "full:        " << full_time * 1000.0 << " ms, "
+       << full_reads << " children read.\n"
+       << "incremental: " << incremental_time * 1000.0 << " ms, "
+       << incremental_reads << " children read, "
+       << num_incremental << " incremental updates.\n";
+
+  if (!ok) {
+    nout << "INCREMENTAL BOUNDS TOO SMALL!\n";
+    return 1;
+  }
+  if (num_moves > 0 && num_incremental == 0) {
+    nout << "NO INCREMENTAL UPDATES!\n";
+    return 1;
+  }
+  nout << "Incremental bounds enclose all nodes.\n";
+  return 0;
+}
@@ -0,0 +1,165 @@
+// Filename: pgraph_compose_stress.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "pandabase.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "mutexHolder.h"
+#include "pointerTo.h"
+#include "trueClock.h"
+#include "transformState.h"
+#include "renderState.h"
+#include "colorAttrib.h"
+#include "colorScaleAttrib.h"
+#include "cullFaceAttrib.h"
+#include "depthWriteAttrib.h"
+#include "randomizer.h"
+#include "string_utils.h"
+
+// This program hammers on TransformState::compose() and
+// RenderState::compose() from several threads at once, to measure
+// the contention on the global state cache.  Run it with a thread
+// count on the command line, e.g. "pgraph_compose_stress 8".
+
+// The number of compositions each thread performs per output line.
+static const int iterations_per_output = 200000;
+
+// The number of output lines per thread.
+static const int outputs_per_thread = 5;
+
+// The number of distinct states in the pool each thread composes from.
+static const int pool_size = 32;
+
+static Mutex _output_lock;
+
+#define OUTPUT(stuff) { \
+  MutexHolder holder(_output_lock); \
+  stuff; \
+}
+
+typedef pvector< CPT(TransformState) > Transforms;
+typedef pvector< CPT(RenderState) > States;
+
+static Transforms transforms;
+static States states;
+
+static void
+make_pools() {
+  Randomizer random(1);
+  for (int i = 0; i < pool_size; ++i) {
+    LVecBase3f pos(random.random_real(10.0), random.random_real(10.0),
+                   random.random_real(10.0));
+    LVecBase3f hpr(random.random_real(360.0), random.random_real(360.0),
+                   random.random_real(360.0));
+    LVecBase3f scale(1.0f + random.random_real(1.0), 1.0f, 1.0f);
+    transforms.push_back(TransformState::make_pos_hpr_scale(pos, hpr, scale));
+
+    CPT(RenderState) state = RenderState::make_empty();
+    if (i & 1) {
+      Colorf color(random.random_real(1.0), 0.0f, 0.0f, 1.0f);
+      state = state->add_attrib(ColorAttrib::make_flat(color));
+    }
+    if (i & 2) {
+      LVecBase4f scale(1.0f, random.random_real(1.0), 1.0f, 1.0f);
+      state = state->add_attrib(ColorScaleAttrib::make(scale));
+    }
+    if (i & 4) {
+      state = state->add_attrib(CullFaceAttrib::make_reverse());
+    }
+    if (i & 8) {
+      state = state->add_attrib
+        (DepthWriteAttrib::make(DepthWriteAttrib::M_off));
+    }
+    states.push_back(state);
+  }
+}
+
+class MyThread : public Thread {
+public:
+  MyThread(const string &name, int index) :
+    Thread(name, name),
+    _index(index),
+    _rate(0.0)
+  {
+  }
+
+  virtual void thread_main() {
+    TrueClock *clock = TrueClock::get_global_ptr();
+    Randomizer random(_index + 1);
+
+    double total_seconds = 0.0;
+    for (int n = 0; n < outputs_per_thread; ++n) {
+      double start_time = clock->get_short_time();
+
+      for (int i = 0; i < iterations_per_output; ++i) {
+        int a = random.random_int(pool_size);
+        int b = random.random_int(pool_size);
+        CPT(TransformState) t = transforms[a]->compose(transforms[b]);
+        t = t->invert_compose(transforms[b]);
+        CPT(RenderState) s = states[a]->compose(states[b]);
+      }
+
+      double elapsed_seconds = clock->get_short_time() - start_time;
+      total_seconds += elapsed_seconds;
+    }
+
+    // Each iteration performs three compositions.
+    _rate = 3.0 * iterations_per_output * outputs_per_thread / total_seconds;
+    OUTPUT(nout << *this << " achieved " << _rate / 1000000.0
+           << " million compositions per second.\n");
+  }
+
+  int _index;
+  double _rate;
+};
+
+int
+main(int argc, char *argv[]) {
+  int number_of_threads = 4;
+  if (argc > 1) {
+    number_of_threads = max(atoi(argv[1]), 1);
+  }
+
+  make_pools();
+
+  OUTPUT(nout << "Making " << number_of_threads << " threads.\n");
+
+  typedef pvector< PT(MyThread) > Threads;
+  Threads threads;
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start_time = clock->get_short_time();
+
+  for (int i = 0; i < number_of_threads; ++i) {
+    PT(MyThread) thread = new MyThread("compose_" + format_string(i), i);
+    threads.push_back(thread);
+    thread->start(TP_normal, true);
+  }
+
+  // Now join all the threads.
+  double total_rate = 0.0;
+  Threads::iterator ti;
+  for (ti = threads.begin(); ti != threads.end(); ++ti) {
+    (*ti)->join();
+    total_rate += (*ti)->_rate;
+  }
+
+  double elapsed = clock->get_short_time() - start_time;
+  nout << "Total: " << total_rate / 1000000.0
+       << " million compositions per second on " << number_of_threads
+       << " threads, " << elapsed << " seconds elapsed.\n";
+
+  Thread::prepare_for_exit();
+  return 0;
+}
@@ -0,0 +1,275 @@
+// Filename: pgraph_flatten_parallel.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "pandabase.h"
+
+#include "nodePath.h"
+#include "pandaNode.h"
+#include "geomNode.h"
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexData.h"
+#include "geomVertexFormat.h"
+#include "geomVertexWriter.h"
+#include "colorAttrib.h"
+#include "colorScaleAttrib.h"
+#include "configVariableInt.h"
+#include "randomizer.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program builds a city of procedurally generated blocks of
+// buildings, and flattens it with flatten_strong(), first serially
+// and then with flatten-threads.  It reports the time taken by each,
+// and checks that the two flattened graphs are the same, node for
+// node and vertex for vertex.  Some of the buildings share a common
+// Geom, and a street lamp is instanced under several blocks, so that
+// some of the blocks can't be flattened independently.  Run it with a
+// number of blocks, a number of buildings per block and a number of
+// threads, e.g. "pgraph_flatten_parallel 200 50 4".
+
+// Returns the vertices of a box of the indicated color.
+static PT(GeomVertexData)
+make_box_vertices(const string &name, const Colorf &color) {
+  PT(GeomVertexData) vdata = new GeomVertexData
+    (name, GeomVertexFormat::get_v3n3c4(), Geom::UH_static);
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(vdata, InternalName::get_normal());
+  GeomVertexWriter cwriter(vdata, InternalName::get_color());
+
+  for (int axis = 0; axis < 3; ++axis) {
+    for (int side = -1; side <= 1; side += 2) {
+      LVector3f n(0.0f, 0.0f, 0.0f);
+      n[axis] = (float)side;
+      LVector3f u(0.0f, 0.0f, 0.0f);
+      u[(axis + 1) % 3] = 1.0f;
+      LVector3f v = n.cross(u);
+      for (int corner = 0; corner < 4; ++corner) {
+        float a = (corner == 1 || corner == 2) ? 1.0f : -1.0f;
+        float b = (corner >= 2) ? 1.0f : -1.0f;
+        vertex.add_data3f(n * 0.5f + u * (a * 0.5f) + v * (b * 0.5f));
+        normal.add_data3f(n);
+        cwriter.add_data4f(color);
+      }
+    }
+  }
+  return vdata;
+}
+
+static PT(Geom)
+make_box(const string &name, const Colorf &color) {
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+  for (int face = 0; face < 6; ++face) {
+    int f = face * 4;
+    tris->add_vertices(f, f + 1, f + 2);
+    tris->close_primitive();
+    tris->add_vertices(f, f + 2, f + 3);
+    tris->close_primitive();
+  }
+
+  PT(Geom) geom = new Geom(make_box_vertices(name, color));
+  geom->add_primitive(tris);
+  return geom;
+}
+
+static NodePath
+make_city(int num_blocks, int num_buildings) {
+  Randomizer random(17);
+  NodePath city("city");
+
+  // A few Geoms shared by buildings throughout the city.
+  PT(Geom) shared_boxes[3];
+  for (int s = 0; s < 3; ++s) {
+    shared_boxes[s] = make_box("shared", Colorf(0.5f, 0.5f, 0.5f + s * 0.2f, 1.0f));
+  }
+
+  // A street lamp, instanced under every eighth block.
+  PT(GeomNode) lamp = new GeomNode("lamp");
+  lamp->add_geom(make_box("lamp", Colorf(1.0f, 1.0f, 0.5f, 1.0f)));
+
+  int side = 1;
+  while (side * side < num_blocks) {
+    ++side;
+  }
+
+  for (int bi = 0; bi < num_blocks; ++bi) {
+    NodePath block = city.attach_new_node("block");
+    block.set_pos((bi % side) * 100.0f, (bi / side) * 100.0f, 0.0f);
+
+    // Some blocks are in a district of their own, with a color scale.
+    NodePath parent = block;
+    if (bi % 5 == 0) {
+      parent = block.attach_new_node("district");
+      parent.set_color_scale(0.8f, 0.9f, 1.0f, 1.0f);
+    }
+
+    for (int i = 0; i < num_buildings; ++i) {
+      PT(GeomNode) building = new GeomNode("building");
+      if (random.random_int(10) == 0) {
+        building->add_geom(shared_boxes[random.random_int(3)]);
+      } else {
+        Colorf color(random.random_real(1.0), random.random_real(1.0),
+                     random.random_real(1.0), 1.0f);
+        building->add_geom(make_box("building", color));
+      }
+      NodePath np = parent.attach_new_node(building);
+      float height = 5.0f + random.random_real(40.0);
+      np.set_pos(random.random_real(90.0), random.random_real(90.0), 
+                 height * 0.5f);
+      np.set_hpr(random.random_real(360.0), 0.0f, 0.0f);
+      np.set_scale(4.0f + random.random_real(8.0), 
+                   4.0f + random.random_real(8.0), height);
+      if (random.random_int(4) == 0) {
+        np.set_color(random.random_real(1.0), random.random_real(1.0),
+                     random.random_real(1.0), 1.0f);
+      }
+    }
+
+    if (bi % 8 == 0) {
+      block.attach_new_node(lamp);
+    }
+  }
+
+  return city;
+}
+
+// Accumulates the 64-bit FNV-1a hash of some bytes.
+static void
+hash_bytes(unsigned long long &hash, const void *data, size_t size) {
+  const unsigned char *p = (const unsigned char *)data;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+}
+
+static void
+hash_string(unsigned long long &hash, const string &str) {
+  hash_bytes(hash, str.data(), str.size());
+  hash_bytes(hash, "", 1);
+}
+
+static void
+hash_array(unsigned long long &hash, const GeomVertexArrayData *array) {
+  hash_string(hash, array->get_handle()->get_data());
+}
+
+// Computes a hash of everything in the graph at node and below that
+// flattening might affect, and counts the nodes, Geoms and vertices.
+static void
+r_hash_graph(unsigned long long &hash, PandaNode *node,
+             int &num_nodes, int &num_geoms, int &num_vertices) {
+  ++num_nodes;
+  hash_string(hash, node->get_type().get_name());
+  hash_string(hash, node->get_name());
+  LMatrix4f mat = node->get_transform()->get_mat();
+  hash_bytes(hash, mat.get_data(), sizeof(float) * 16);
+  ostringstream state;
+  node->get_state()->output(state);
+  hash_string(hash, state.str());
+
+  if (node->is_geom_node()) {
+    GeomNode *gnode = DCAST(GeomNode, node);
+    for (int gi = 0; gi < gnode->get_num_geoms(); ++gi) {
+      ++num_geoms;
+      CPT(Geom) geom = gnode->get_geom(gi);
+      ostringstream geom_state;
+      gnode->get_geom_state(gi)->output(geom_state);
+      hash_string(hash, geom_state.str());
+
+      CPT(GeomVertexData) vdata = geom->get_vertex_data();
+      num_vertices += vdata->get_num_rows();
+      hash_string(hash, vdata->get_name());
+      for (int ai = 0; ai < vdata->get_num_arrays(); ++ai) {
+        hash_array(hash, vdata->get_array(ai));
+      }
+
+      for (int pi = 0; pi < geom->get_num_primitives(); ++pi) {
+        CPT(GeomPrimitive) prim = geom->get_primitive(pi);
+        hash_string(hash, prim->get_type().get_name());
+        int first = prim->get_first_vertex();
+        int count = prim->get_num_vertices();
+        hash_bytes(hash, &first, sizeof(first));
+        hash_bytes(hash, &count, sizeof(count));
+        if (prim->is_indexed()) {
+          hash_array(hash, prim->get_vertices());
+        }
+      }
+    }
+  }
+
+  for (int ci = 0; ci < node->get_num_children(); ++ci) {
+    r_hash_graph(hash, node->get_child(ci), num_nodes, num_geoms, num_vertices);
+  }
+}
+
+static unsigned long long
+flatten_city(int num_blocks, int num_buildings, int num_threads,
+             double &elapsed) {
+  ConfigVariableInt flatten_threads("flatten-threads");
+  flatten_threads.set_value(num_threads);
+
+  NodePath city = make_city(num_blocks, num_buildings);
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  int num_removed = city.flatten_strong();
+  elapsed = clock->get_short_time() - start;
+
+  unsigned long long hash = 14695981039346656037ULL;
+  int num_nodes = 0, num_geoms = 0, num_vertices = 0;
+  r_hash_graph(hash, city.node(), num_nodes, num_geoms, num_vertices);
+
+  nout << num_threads << " threads: removed " << num_removed
+       << " nodes in " << elapsed * 1000.0 << " ms; " << num_nodes
+       << " nodes, " << num_geoms << " geoms, " << num_vertices
+       << " vertices remain.\n";
+  return hash;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_blocks = 200;
+  int num_buildings = 50;
+  int num_threads = 4;
+  if (argc > 1) {
+    num_blocks = max(atoi(argv[1]), 1);
+  }
+  if (argc > 2) {
+    num_buildings = max(atoi(argv[2]), 1);
+  }
+  if (argc > 3) {
+    num_threads = max(atoi(argv[3]), 1);
+  }
+
+  nout << num_blocks << " blocks of " << num_buildings << " buildings.\n";
+
+  double serial_time, parallel_time;
+  unsigned long long serial_hash = 
+    flatten_city(num_blocks, num_buildings, 0, serial_time);
+  unsigned long long parallel_hash = 
+    flatten_city(num_blocks, num_buildings, num_threads, parallel_time);
+
+  if (parallel_time > 0.0) {
+    nout << "Speedup: " << serial_time / parallel_time << "\n";
+  }
+
+  if (serial_hash != parallel_hash) {
+    nout << "FLATTENED GRAPHS DIFFER!\n";
+    return 1;
+  }
+  nout << "Flattened graphs are identical.\n";
+  return 0;
+}
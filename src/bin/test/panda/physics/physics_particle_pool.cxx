@@ -0,0 +1,96 @@
+// Filename: physics_particle_pool.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "particleSystem.h"
+#include "pointParticleRenderer.h"
+#include "physicsManager.h"
+#include "physicalNode.h"
+#include "forceNode.h"
+#include "linearVectorForce.h"
+#include "nodePath.h"
+#include "trueClock.h"
+#include "pnotify.h"
+
+// This program fills a particle system with a large number of
+// particles under gravity, and times its update and render, first with
+// the BaseParticle pool and then in packed-pool mode.  Run it with a
+// number of particles on the command line, e.g.
+// "physics_particle_pool 100000".
+
+static const int num_frames = 60;
+static const float frame_time = 1.0f / 60.0f;
+
+static double
+run_system(bool packed_pool, int num_particles, int &num_living) {
+  NodePath render("render");
+
+  PT(ForceNode) force_node = new ForceNode("gravity");
+  render.attach_new_node(force_node);
+  PT(LinearVectorForce) gravity =
+    new LinearVectorForce(0.0f, 0.0f, -9.8f, 1.0f, false);
+  force_node->add_force(gravity);
+
+  PhysicsManager physics_manager;
+  physics_manager.add_linear_force(gravity);
+
+  PT(ParticleSystem) system = new ParticleSystem(num_particles);
+  system->set_render_parent(render);
+  system->set_packed_pool_flag(packed_pool);
+  system->set_birth_rate(frame_time);
+  system->set_litter_size(num_particles / num_frames + 1);
+  system->get_factory()->set_lifespan_base(num_frames * frame_time);
+
+  PT(PhysicalNode) physical_node = new PhysicalNode("particles");
+  physical_node->add_physical(system);
+  render.attach_new_node(physical_node);
+  physics_manager.attach_physical(system);
+
+  // Run a few frames first, so the pool is full when timing starts.
+  for (int n = 0; n < num_frames; ++n) {
+    physics_manager.do_physics(frame_time);
+    system->update(frame_time);
+  }
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  for (int n = 0; n < num_frames; ++n) {
+    physics_manager.do_physics(frame_time);
+    system->update(frame_time);
+    system->render();
+  }
+  double elapsed = (clock->get_short_time() - start) / num_frames;
+
+  num_living = system->get_living_particles();
+  physics_manager.remove_physical(system);
+  return elapsed;
+}
+
+int
+main(int argc, char *argv[]) {
+  int num_particles = 100000;
+  if (argc > 1) {
+    num_particles = max(atoi(argv[1]), 1);
+  }
+
+  int object_living, packed_living;
+  double object_time = run_system(false, num_particles, object_living);
+  double packed_time = run_system(true, num_particles, packed_living);
+
+  nout << num_particles << " particles.\n"
+       << "BaseParticle pool: " << object_living << " living, "
+       << object_time * 1000.0 << " ms per frame.\n"
+       << "Packed pool:       " << packed_living << " living, "
+       << packed_time * 1000.0 << " ms per frame.\n";
+  return 0;
+}
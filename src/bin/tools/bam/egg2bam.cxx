@@ -22,6 +22,7 @@
 #include "config_chan.h"
 #include "pandaNode.h"
 #include "geomNode.h"
+#include "collisionBVH.h"
 #include "renderState.h"
 #include "textureAttrib.h"
 #include "dcast.h"
@@ -108,6 +109,15 @@ EggToBam() :
      "written exactly as they are, losslessly.",
      &EggToBam::dispatch_none, &_compression_off);
 
+  add_option
+    ("bvh", "", 0,
+     "Build a collision bounding-volume hierarchy for each GeomNode "
+     "with enough triangles to benefit from one, and store it in the "
+     "bam file, so that it need not be built the first time the model is "
+     "tested for collisions.  (Large CollisionNodes always carry their "
+     "hierarchy in the bam file.)  See collide-bvh-min-items.",
+     &EggToBam::dispatch_none, &_collide_bvh);
+
   add_option
     ("rawtex", "", 0,
      "Record texture data directly in the bam file, instead of storing "
@@ -190,6 +200,14 @@ EggToBam() :
      "settings appearing within the egg file will override this.",
      &EggToBam::dispatch_string, NULL, &_ctex_quality);
 
+  add_option
+    ("texthreads", "count", 0,
+     "Generates mipmap levels and performs the libsquish compression "
+     "requested by -ctex on this many threads in addition to the main "
+     "thread.  This overrides the texture-work-threads setting in "
+     "Config.prc.  The resulting textures are the same either way.",
+     &EggToBam::dispatch_int, &_has_tex_threads, &_tex_threads);
+
   add_option
     ("load-display", "display name", 0,
      "Specifies the particular display module to load to perform the texture "
@@ -233,6 +251,9 @@ run() {
     // Ditto with -combine_geoms.
     egg_combine_geoms = (_egg_combine_geoms != 0);
   }
+  if (_has_tex_threads) {
+    texture_work_threads = _tex_threads;
+  }
 
   // We always set egg_suppress_hidden.
   egg_suppress_hidden = _egg_suppress_hidden;
@@ -315,6 +336,11 @@ run() {
     }
   }
   
+  if (_collide_bvh) {
+    int num_bvhs = CollisionBVH::build_all(root);
+    nout << "Built collision hierarchies for " << num_bvhs << " nodes.\n";
+  }
+
   if (_ls) {
     root->ls(nout, 0);
   }
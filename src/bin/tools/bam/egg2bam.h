@@ -61,12 +61,15 @@ private:
   bool _has_compression_quality;
   int _compression_quality;
   bool _compression_off;
+  bool _collide_bvh;
   bool _tex_rawdata;
   bool _tex_txo;
   bool _tex_txopz;
   bool _tex_ctex;
   bool _tex_mipmap;
   string _ctex_quality;
+  bool _has_tex_threads;
+  int _tex_threads;
   string _load_display;
 
   // The rest of this is required to support -ctex.
@@ -27,6 +27,7 @@
 #include "eggTable.h"
 #include "eggGroup.h"
 #include "eggAnimPreload.h"
+#include "eggXfmSAnim.h"
 #include "string_utils.h"
 #include "dcast.h"
 #include "pset.h"
@@ -193,8 +194,22 @@ EggOptchar() {
      "to quantize different channels by a different amount.",
      &EggOptchar::dispatch_double_components, NULL, &_quantize_anims);
 
+  add_option
+    ("ca", "tolerance,hpr_tolerance", 0,
+     "Marks the animation tables so that, when they are loaded or converted "
+     "by egg2bam, they are stored as compressed channels: quantized keys at "
+     "evenly-spaced frames, which need far less memory than the original "
+     "tables.  Every frame of the scale, shear and translate components "
+     "will be within tolerance of its original value, and every frame of "
+     "the hpr components within hpr_tolerance degrees.  Specify 0,0 to "
+     "store the tables uncompressed, regardless of egg-anim-tolerance.",
+     &EggOptchar::dispatch_double_pair, &_got_anim_tolerance, &_anim_tolerance[0]);
+
   _optimal_hierarchy = false;
   _vref_quantum = 0.01;
+  _got_anim_tolerance = false;
+  _anim_tolerance[0] = 0.0;
+  _anim_tolerance[1] = 0.0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -290,6 +305,15 @@ run() {
       do_defpose();
     }
 
+    // Record the compression tolerance in each of the animation
+    // tables.
+    if (_got_anim_tolerance) {
+      Eggs::iterator ei;
+      for (ei = _eggs.begin(); ei != _eggs.end(); ++ei) {
+        do_anim_tolerance(*ei);
+      }
+    }
+
     write_eggs();
   }
 }
@@ -1515,6 +1539,29 @@ do_defpose() {
   ch->get_root_joint()->apply_default_pose(anim_index, frame);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: EggOptchar::do_anim_tolerance
+//       Access: Private
+//  Description: Recursively walks the indicated egg hierarchy,
+//               setting the tolerances specified by -ca on each of
+//               the transform animation tables.
+////////////////////////////////////////////////////////////////////
+void EggOptchar::
+do_anim_tolerance(EggNode *egg_node) {
+  if (egg_node->is_of_type(EggXfmSAnim::get_class_type())) {
+    EggXfmSAnim *anim = DCAST(EggXfmSAnim, egg_node);
+    anim->set_tolerance(_anim_tolerance[0]);
+    anim->set_hpr_tolerance(_anim_tolerance[1]);
+
+  } else if (egg_node->is_of_type(EggGroupNode::get_class_type())) {
+    EggGroupNode *egg_group = DCAST(EggGroupNode, egg_node);
+    EggGroupNode::iterator ci;
+    for (ci = egg_group->begin(); ci != egg_group->end(); ++ci) {
+      do_anim_tolerance(*ci);
+    }
+  }
+}
+
 int main(int argc, char *argv[]) {
   // A call to pystub() to force libpystub.so to be linked in.
   pystub();
@@ -79,6 +79,7 @@ private:
   void rename_primitives(EggGroupNode *egg_group, const string &name);
   void do_preload();
   void do_defpose();
+  void do_anim_tolerance(EggNode *egg_node);
 
   bool _list_hierarchy;
   bool _list_hierarchy_v;
@@ -123,6 +124,9 @@ private:
 
   bool _optimal_hierarchy;
   double _vref_quantum;
+
+  bool _got_anim_tolerance;
+  double _anim_tolerance[2];
 };
 
 #endif
@@ -14,6 +14,7 @@
 
 #include "image_resize.h"
 #include "string_utils.h"
+#include "config_pnmimage.h"
 #include "pystub.h"
 
 ////////////////////////////////////////////////////////////////////
@@ -46,6 +47,18 @@ ImageResize() : ImageFilter(true) {
      "Use Gaussian filtering to resize the image, with the indicated radius.",
      &ImageResize::dispatch_double, &_use_gaussian_filter, &_filter_radius);
 
+  add_option
+    ("l", "lobes", 0,
+     "Use Lanczos filtering to resize the image, with the indicated number "
+     "of lobes (typically 2 or 3).  This preserves more detail than -g.",
+     &ImageResize::dispatch_double, &_use_lanczos_filter, &_lanczos_radius);
+
+  add_option
+    ("j", "threads", 0,
+     "Filter the image using the indicated number of additional threads.  "
+     "This overrides the pnm-filter-threads config variable.",
+     &ImageResize::dispatch_int, &_got_num_threads, &_num_threads);
+
   add_option
     ("1", "", 0,
      "This option is ignored.  It is provided only for backward compatibility "
@@ -53,6 +66,8 @@ ImageResize() : ImageFilter(true) {
      &ImageResize::dispatch_none, NULL, NULL);
 
   _filter_radius = 1.0;
+  _lanczos_radius = 3.0;
+  _num_threads = 0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -79,7 +94,13 @@ run() {
                      _image.get_num_channels(), 
                      _image.get_maxval(), _image.get_type());
 
-  if (_use_gaussian_filter) {
+  if (_got_num_threads) {
+    pnm_filter_threads = _num_threads;
+  }
+
+  if (_use_lanczos_filter) {
+    new_image.lanczos_filter_from(_lanczos_radius, _image);
+  } else if (_use_gaussian_filter) {
     new_image.gaussian_filter_from(_filter_radius, _image);
   } else {
     new_image.quick_filter_from(_image);
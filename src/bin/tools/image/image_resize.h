@@ -63,6 +63,10 @@ private:
 
   bool _use_gaussian_filter;
   double _filter_radius;
+  bool _use_lanczos_filter;
+  double _lanczos_radius;
+  bool _got_num_threads;
+  int _num_threads;
 };
 
 #include "image_resize.I"
@@ -0,0 +1,261 @@
+// Filename: imageResizeBench.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "image_resize_bench.h"
+#include "config_pnmimage.h"
+#include "trueClock.h"
+#include "pystub.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageResizeBench::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+ImageResizeBench::
+ImageResizeBench() {
+  set_program_description
+    ("This program measures the speed of the PNMImage resampling filters.  "
+     "It synthesizes a square image, by default 16384 x 16384 pixels, and "
+     "shrinks it with each filter three times: on a single thread with "
+     "pnm-filter-simd disabled, on a single thread with pnm-filter-simd "
+     "enabled, and with pnm-filter-threads set.  It reports the time "
+     "taken by each, and the number of pixels of each result that differ "
+     "from the first.  Note that the default image size needs a few "
+     "gigabytes of memory.");
+
+  add_option
+    ("s", "size", 0,
+     "Specify the width and height of the source image, in pixels.",
+     &ImageResizeBench::dispatch_int, NULL, &_source_size);
+
+  add_option
+    ("d", "dest_size", 0,
+     "Specify the width and height of the resized image, in pixels.",
+     &ImageResizeBench::dispatch_int, NULL, &_dest_size);
+
+  add_option
+    ("c", "channels", 0,
+     "Specify the number of channels in the image, 1 to 4.",
+     &ImageResizeBench::dispatch_int, NULL, &_num_channels);
+
+  add_option
+    ("f", "filter", 0,
+     "Measure only the named filter: box, gaussian, lanczos or quick.  "
+     "The default is to measure all of them.",
+     &ImageResizeBench::dispatch_string, NULL, &_filter);
+
+  add_option
+    ("r", "radius", 0,
+     "Specify the radius of the box and gaussian filters, and the number "
+     "of lobes of the lanczos filter.",
+     &ImageResizeBench::dispatch_double, NULL, &_radius);
+
+  add_option
+    ("j", "threads", 0,
+     "Specify the number of additional threads to use for the last run "
+     "of each filter.",
+     &ImageResizeBench::dispatch_int, NULL, &_num_threads);
+
+  _source_size = 16384;
+  _dest_size = 4096;
+  _num_channels = 3;
+  _radius = 3.0;
+  _num_threads = 3;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageResizeBench::run
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+void ImageResizeBench::
+run() {
+  nout << "Synthesizing " << _source_size << " x " << _source_size
+       << " x " << _num_channels << " image.\n";
+  _source.clear(_source_size, _source_size, _num_channels);
+
+  // A smooth gradient overlaid with a fine checkerboard and some
+  // pseudo-random noise, so that the filters have high frequencies to
+  // remove.
+  unsigned int seed = 1;
+  xelval maxval = _source.get_maxval();
+  for (int y = 0; y < _source_size; ++y) {
+    for (int x = 0; x < _source_size; ++x) {
+      seed = seed * 1103515245 + 12345;
+      int noise = (int)((seed >> 16) & 0x3f);
+      int check = ((x ^ y) & 4) ? 64 : 0;
+      xelval r = (xelval)(((x * 128) / _source_size + check + noise) % (maxval + 1));
+      xelval g = (xelval)(((y * 128) / _source_size + check + noise) % (maxval + 1));
+      xelval b = (xelval)((((x + y) * 64) / _source_size + check) % (maxval + 1));
+      _source.set_xel_val(x, y, r, g, b);
+      if (_source.has_alpha()) {
+        _source.set_alpha_val(x, y, (xelval)((x + noise) % (maxval + 1)));
+      }
+    }
+  }
+
+  nout << "Resizing to " << _dest_size << " x " << _dest_size
+       << "; " << _num_threads << " additional threads.\n";
+
+  bool all_match = true;
+  for (int fi = (int)FT_box; fi <= (int)FT_quick; ++fi) {
+    FilterType type = (FilterType)fi;
+    if (!_filter.empty() && _filter != get_filter_name(type)) {
+      continue;
+    }
+
+    PNMImage scalar, simd, threaded;
+    double scalar_time = resize(type, scalar, false, 0);
+    double simd_time = resize(type, simd, true, 0);
+    double threaded_time = resize(type, threaded, true, _num_threads);
+
+    int simd_diffs = count_differences(scalar, simd);
+    int threaded_diffs = count_differences(scalar, threaded);
+    all_match = all_match && (simd_diffs == 0 && threaded_diffs == 0);
+
+    nout << get_filter_name(type) << ":\n"
+         << "  scalar:   " << scalar_time << " s\n"
+         << "  simd:     " << simd_time << " s, "
+         << simd_diffs << " pixels differ\n"
+         << "  threaded: " << threaded_time << " s, "
+         << threaded_diffs << " pixels differ\n";
+  }
+
+  if (!all_match) {
+    exit(1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageResizeBench::handle_args
+//       Access: Protected, Virtual
+//  Description: Does something with the additional arguments on the
+//               command line (after all the -options have been
+//               parsed).  Returns true if the arguments are good,
+//               false otherwise.
+////////////////////////////////////////////////////////////////////
+bool ImageResizeBench::
+handle_args(ProgramBase::Args &args) {
+  if (!args.empty()) {
+    nout << "Unexpected arguments on command line.\n";
+    return false;
+  }
+  if (_source_size < 1 || _dest_size < 1) {
+    nout << "Invalid image size.\n";
+    return false;
+  }
+  if (_num_channels < 1 || _num_channels > 4) {
+    nout << "Invalid number of channels.\n";
+    return false;
+  }
+  if (!_filter.empty() &&
+      _filter != "box" && _filter != "gaussian" &&
+      _filter != "lanczos" && _filter != "quick") {
+    nout << "Unknown filter: " << _filter << "\n";
+    return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageResizeBench::resize
+//       Access: Private
+//  Description: Resizes the source image into dest with the indicated
+//               filter and settings, and returns the elapsed time in
+//               seconds.
+////////////////////////////////////////////////////////////////////
+double ImageResizeBench::
+resize(FilterType type, PNMImage &dest, bool simd, int num_threads) {
+  pnm_filter_simd = simd;
+  pnm_filter_threads = num_threads;
+
+  dest.clear(_dest_size, _dest_size, _source.get_num_channels(),
+             _source.get_maxval());
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+
+  switch (type) {
+  case FT_box:
+    dest.box_filter_from(_radius, _source);
+    break;
+
+  case FT_gaussian:
+    dest.gaussian_filter_from(_radius, _source);
+    break;
+
+  case FT_lanczos:
+    dest.lanczos_filter_from(_radius, _source);
+    break;
+
+  case FT_quick:
+    dest.quick_filter_from(_source);
+    break;
+  }
+
+  return clock->get_short_time() - start;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageResizeBench::count_differences
+//       Access: Private, Static
+//  Description: Returns the number of pixels that are not exactly the
+//               same in the two images, which must be the same size.
+////////////////////////////////////////////////////////////////////
+int ImageResizeBench::
+count_differences(const PNMImage &a, const PNMImage &b) {
+  int count = 0;
+  for (int y = 0; y < a.get_y_size(); ++y) {
+    for (int x = 0; x < a.get_x_size(); ++x) {
+      if (a.get_red_val(x, y) != b.get_red_val(x, y) ||
+          a.get_green_val(x, y) != b.get_green_val(x, y) ||
+          a.get_blue_val(x, y) != b.get_blue_val(x, y) ||
+          (a.has_alpha() && a.get_alpha_val(x, y) != b.get_alpha_val(x, y))) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ImageResizeBench::get_filter_name
+//       Access: Private, Static
+//  Description: Returns the name of the filter as given to -f.
+////////////////////////////////////////////////////////////////////
+const char *ImageResizeBench::
+get_filter_name(FilterType type) {
+  switch (type) {
+  case FT_box:
+    return "box";
+  case FT_gaussian:
+    return "gaussian";
+  case FT_lanczos:
+    return "lanczos";
+  case FT_quick:
+    return "quick";
+  }
+  return "unknown";
+}
+
+
+int main(int argc, char *argv[]) {
+  // A call to pystub() to force libpystub.so to be linked in.
+  pystub();
+
+  ImageResizeBench prog;
+  prog.parse_command_line(argc, argv);
+  prog.run();
+  return 0;
+}
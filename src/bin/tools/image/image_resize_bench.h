@@ -0,0 +1,63 @@
+// Filename: imageResizeBench.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef IMAGERESIZEBENCH_H
+#define IMAGERESIZEBENCH_H
+
+#include "pandatoolbase.h"
+
+#include "programBase.h"
+#include "pnmImage.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : ImageResizeBench
+// Description : A program to measure the time taken by the PNMImage
+//               resampling filters.  It synthesizes a large image,
+//               and resizes it with each filter: first on one thread
+//               with the scalar code, then with the vectorized code,
+//               and then divided among several threads, reporting
+//               the time taken by each and whether the results match.
+////////////////////////////////////////////////////////////////////
+class ImageResizeBench : public ProgramBase {
+public:
+  ImageResizeBench();
+
+  void run();
+
+protected:
+  virtual bool handle_args(Args &args);
+
+private:
+  enum FilterType {
+    FT_box,
+    FT_gaussian,
+    FT_lanczos,
+    FT_quick,
+  };
+
+  double resize(FilterType type, PNMImage &dest, bool simd, int num_threads);
+  static int count_differences(const PNMImage &a, const PNMImage &b);
+  static const char *get_filter_name(FilterType type);
+
+  PNMImage _source;
+
+  int _source_size;
+  int _dest_size;
+  int _num_channels;
+  double _radius;
+  int _num_threads;
+  string _filter;
+};
+
+#endif
@@ -0,0 +1,792 @@
+// Filename: animChannelMatrixCompressed.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "animChannelMatrixCompressed.h"
+#include "animChannelMatrixXfmTable.h"
+#include "animBundle.h"
+#include "config_chan.h"
+
+#include "compose_matrix.h"
+#include "indent.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "bamReader.h"
+#include "bamWriter.h"
+#include "config_linmath.h"
+
+TypeHandle AnimChannelMatrixCompressed::_type_handle;
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::Constructor
+//       Access: Protected
+//  Description: Used only for bam loader.
+////////////////////////////////////////////////////////////////////
+AnimChannelMatrixCompressed::
+AnimChannelMatrixCompressed() :
+  _data(get_class_type()),
+  _new_hpr(temp_hpr_fix)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::Copy Constructor
+//       Access: Protected
+//  Description: Creates a new AnimChannelMatrixCompressed, just like
+//               this one, without copying any children.  The new
+//               copy is added to the indicated parent.  Intended to
+//               be called by make_copy() only.
+////////////////////////////////////////////////////////////////////
+AnimChannelMatrixCompressed::
+AnimChannelMatrixCompressed(AnimGroup *parent, const AnimChannelMatrixCompressed &copy) : 
+  AnimChannelMatrix(parent, copy),
+  _data(copy._data),
+  _new_hpr(copy._new_hpr)
+{
+  for (int i = 0; i < num_matrix_components; i++) {
+    _curves[i] = copy._curves[i];
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::Constructor
+//       Access: Published
+//  Description: Creates a new channel with no tables.  Use
+//               set_table() to fill it in.
+////////////////////////////////////////////////////////////////////
+AnimChannelMatrixCompressed::
+AnimChannelMatrixCompressed(AnimGroup *parent, const string &name) :
+  AnimChannelMatrix(parent, name),
+  _data(get_class_type()),
+  _new_hpr(temp_hpr_fix)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::Constructor
+//       Access: Published
+//  Description: Creates a new channel that reproduces the tables of
+//               the indicated AnimChannelMatrixXfmTable, which has
+//               the same number of frames.  Each frame of the scale,
+//               shear and translate components will be within
+//               tolerance of the original value, and each frame of
+//               the hpr components will be within hpr_tolerance
+//               degrees.  The source channel is not modified, and
+//               its children are not copied.
+////////////////////////////////////////////////////////////////////
+AnimChannelMatrixCompressed::
+AnimChannelMatrixCompressed(AnimGroup *parent,
+                            const AnimChannelMatrixXfmTable &source,
+                            float tolerance, float hpr_tolerance) :
+  AnimChannelMatrix(parent, source.get_name()),
+  _data(get_class_type()),
+  _new_hpr(temp_hpr_fix)
+{
+  for (int i = 0; i < num_matrix_components; i++) {
+    char table_id = get_table_id(i);
+    if (source.has_table(table_id)) {
+      bool is_hpr = (i >= 6 && i < 9);
+      set_table(table_id, source.get_table(table_id),
+                is_hpr ? hpr_tolerance : tolerance);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::Destructor
+//       Access: Published, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+AnimChannelMatrixCompressed::
+~AnimChannelMatrixCompressed() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::has_changed
+//       Access: Public, Virtual
+//  Description: Returns true if the value has changed since the last
+//               call to has_changed().  last_frame is the frame
+//               number of the last call; this_frame is the current
+//               frame number.
+////////////////////////////////////////////////////////////////////
+bool AnimChannelMatrixCompressed::
+has_changed(int last_frame, double last_frac, 
+            int this_frame, double this_frac) {
+  const unsigned char *data = _data.p();
+
+  if (last_frame != this_frame) {
+    for (int i = 0; i < num_matrix_components; i++) {
+      const Curve &curve = _curves[i];
+      if (curve._num_keys > 1) {
+        if (curve.get_value(data, last_frame) != 
+            curve.get_value(data, this_frame)) {
+          return true;
+        }
+      }
+    }
+  }
+
+  if (last_frac != this_frac) {
+    // If we have some fractional changes, also check the next
+    // subsequent frame (since we'll be blending with that).
+    for (int i = 0; i < num_matrix_components; i++) {
+      const Curve &curve = _curves[i];
+      if (curve._num_keys > 1) {
+        if (curve.get_value(data, last_frame) != 
+            curve.get_value(data, this_frame + 1)) {
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_value
+//       Access: Public, Virtual
+//  Description: Gets the value of the channel at the indicated frame.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_value(int frame, LMatrix4f &mat) {
+  float components[num_matrix_components];
+  get_components(frame, components);
+  compose_matrix(mat, components);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_value_no_scale_shear
+//       Access: Public, Virtual
+//  Description: Gets the value of the channel at the indicated frame,
+//               without any scale or shear information.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_value_no_scale_shear(int frame, LMatrix4f &mat) {
+  float components[num_matrix_components];
+  get_components(frame, components);
+  components[0] = 1.0f;
+  components[1] = 1.0f;
+  components[2] = 1.0f;
+  components[3] = 0.0f;
+  components[4] = 0.0f;
+  components[5] = 0.0f;
+
+  compose_matrix(mat, components);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_scale
+//       Access: Public, Virtual
+//  Description: Gets the scale value at the indicated frame.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_scale(int frame, LVecBase3f &scale) {
+  for (int i = 0; i < 3; i++) {
+    scale[i] = get_component(i, frame);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_hpr
+//       Access: Public, Virtual
+//  Description: Returns the h, p, and r components associated
+//               with the current frame.  As above, this only makes
+//               sense for a matrix-type channel.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_hpr(int frame, LVecBase3f &hpr) {
+  get_hpr_components(frame, hpr);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_quat
+//       Access: Public, Virtual
+//  Description: Returns the rotation component associated with the
+//               current frame, expressed as a quaternion.  As above,
+//               this only makes sense for a matrix-type channel.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_quat(int frame, LQuaternionf &quat) {
+  LVecBase3f hpr;
+  get_hpr_components(frame, hpr);
+  quat.set_hpr(hpr);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_pos
+//       Access: Public, Virtual
+//  Description: Returns the x, y, and z translation components
+//               associated with the current frame.  As above, this
+//               only makes sense for a matrix-type channel.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_pos(int frame, LVecBase3f &pos) {
+  for (int i = 0; i < 3; i++) {
+    pos[i] = get_component(i + 9, frame);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_shear
+//       Access: Public, Virtual
+//  Description: Returns the a, b, and c shear components associated
+//               with the current frame.  As above, this only makes
+//               sense for a matrix-type channel.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_shear(int frame, LVecBase3f &shear) {
+  for (int i = 0; i < 3; i++) {
+    shear[i] = get_component(i + 3, frame);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::set_table
+//       Access: Published
+//  Description: Compresses the indicated table into the channel,
+//               replacing any previous table for that component.
+//               table_id is one of 'i', 'j', 'k', for scale, 'a',
+//               'b', 'c' for shear, 'h', 'p', 'r', for rotation, and
+//               'x', 'y', 'z', for translation.  The new table must
+//               have either zero, one, or get_num_frames() frames.
+//
+//               Every frame of the compressed curve will be within
+//               tolerance of the corresponding value of the table.
+//               A tolerance of 0 stores the table losslessly, though
+//               runs of frames that change linearly are still
+//               reduced to keys.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+set_table(char table_id, const CPTA_float &table, float tolerance) {
+  int num_frames = _root->get_num_frames();
+
+  if (table.size() > 1 && (int)table.size() < num_frames) {
+    // The new table has an invalid number of frames--it doesn't match
+    // the bundle's requirement.
+    nassertv(false);
+    return;
+  }
+  nassertv(table.size() <= 0xffff);
+
+  int table_index = get_table_index(table_id);
+  if (table_index < 0) {
+    return;
+  }
+
+  // Rebuild the key data, keeping the keys of the other curves.
+  pvector<unsigned char> data;
+  data.reserve(_data.size() + table.size() * sizeof(float));
+  for (int i = 0; i < num_matrix_components; i++) {
+    Curve &curve = _curves[i];
+    if (i != table_index && curve._num_keys > 1) {
+      while (data.size() % 4 != 0) {
+        data.push_back(0);
+      }
+      size_t num_bytes = (size_t)curve._num_keys * (curve._bits / 8);
+      const unsigned char *p = _data.p() + curve._offset;
+      curve._offset = data.size();
+      data.insert(data.end(), p, p + num_bytes);
+    }
+  }
+
+  const float *values = table.empty() ? (const float *)NULL : table.p();
+  compress_table(_curves[table_index], data, values, (int)table.size(),
+                 max(tolerance, 0.0f));
+
+  PTA_uchar new_data = PTA_uchar::empty_array(data.size(), get_class_type());
+  if (!data.empty()) {
+    memcpy(new_data.p(), &data[0], data.size());
+  }
+  _data = new_data;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_table
+//       Access: Published
+//  Description: Decodes the indicated component into a new table,
+//               with one value for each frame of the original table.
+//               Returns an empty table if the component has no
+//               table.
+////////////////////////////////////////////////////////////////////
+PTA_float AnimChannelMatrixCompressed::
+get_table(char table_id) const {
+  int table_index = get_table_index(table_id);
+  if (table_index < 0) {
+    return PTA_float(get_class_type());
+  }
+
+  const Curve &curve = _curves[table_index];
+  PTA_float table = PTA_float::empty_array(curve._num_frames, get_class_type());
+  for (int f = 0; f < (int)curve._num_frames; ++f) {
+    table[f] = curve.get_value(_data.p(), f);
+  }
+  return table;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::clear_all_tables
+//       Access: Published
+//  Description: Removes all the tables from the channel, and resets
+//               it to its initial state.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+clear_all_tables() {
+  for (int i = 0; i < num_matrix_components; i++) {
+    _curves[i] = Curve();
+  }
+  _data = CPTA_uchar(get_class_type());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_data_size
+//       Access: Published
+//  Description: Returns the number of bytes used to store the
+//               curves, including the description of each curve as
+//               well as the keys.  This is intended for comparing
+//               with the size of the original tables.
+////////////////////////////////////////////////////////////////////
+size_t AnimChannelMatrixCompressed::
+get_data_size() const {
+  return sizeof(_curves) + _data.size();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::write
+//       Access: Public, Virtual
+//  Description: Writes a brief description of the table and all of
+//               its descendants.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+write(ostream &out, int indent_level) const {
+  indent(out, indent_level)
+    << get_type() << " " << get_name() << " ";
+
+  // Write a list of all the sub-tables that have data, with the
+  // number of keys each was reduced to.
+  bool found_any = false;
+  for (int i = 0; i < num_matrix_components; i++) {
+    const Curve &curve = _curves[i];
+    if (curve._num_frames != 0) {
+      out << get_table_id(i) << curve._num_frames << ":" << curve._num_keys;
+      if (curve._num_keys > 1) {
+        out << "/" << (int)curve._bits;
+      }
+      out << " ";
+      found_any = true;
+    }
+  }
+
+  if (!found_any) {
+    out << "(no data)";
+  }
+
+  if (!_children.empty()) {
+    out << " {\n";
+    write_descendants(out, indent_level + 2);
+    indent(out, indent_level) << "}";
+  }
+
+  out << "\n";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::make_copy
+//       Access: Protected, Virtual
+//  Description: Returns a copy of this object, and attaches it to the
+//               indicated parent (which may be NULL only if this is
+//               an AnimBundle).  Intended to be called by
+//               copy_subtree() only.
+////////////////////////////////////////////////////////////////////
+AnimGroup *AnimChannelMatrixCompressed::
+make_copy(AnimGroup *parent) const {
+  return new AnimChannelMatrixCompressed(parent, *this);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_components
+//       Access: Private
+//  Description: Fills in all of the components of the transform at
+//               the indicated frame.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_components(int frame, float components[num_matrix_components]) const {
+  for (int i = 0; i < num_matrix_components; i++) {
+    components[i] = get_component(i, frame);
+  }
+
+  if (_new_hpr != temp_hpr_fix) {
+    LVecBase3f hpr;
+    get_hpr_components(frame, hpr);
+    components[6] = hpr[0];
+    components[7] = hpr[1];
+    components[8] = hpr[2];
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_hpr_components
+//       Access: Private
+//  Description: Returns the h, p, and r components at the indicated
+//               frame, converted to the current hpr convention if
+//               they were computed with the other one.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+get_hpr_components(int frame, LVecBase3f &hpr) const {
+  for (int i = 0; i < 3; i++) {
+    hpr[i] = get_component(i + 6, frame);
+  }
+
+  if (_new_hpr != temp_hpr_fix) {
+    if (temp_hpr_fix) {
+      hpr = old_to_new_hpr(hpr);
+    } else {
+      hpr = new_to_old_hpr(hpr);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::compress_table
+//       Access: Private, Static
+//  Description: Fills in the curve to reproduce the indicated table
+//               of num_frames values within tolerance, appending its
+//               keys to data.
+//
+//               Each of the possible key sizes is tried in turn,
+//               provided its quantization step is within the
+//               tolerance, with the widest spacing of keys that keeps
+//               the interpolated curve within tolerance; whichever
+//               needs the fewest bytes is used.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+compress_table(Curve &curve, pvector<unsigned char> &data,
+               const float *table, int num_frames, float tolerance) {
+  curve = Curve();
+  curve._num_frames = (PN_uint16)num_frames;
+  if (num_frames == 0) {
+    return;
+  }
+
+  float min_value = table[0];
+  float max_value = table[0];
+  for (int f = 1; f < num_frames; ++f) {
+    min_value = min(min_value, table[f]);
+    max_value = max(max_value, table[f]);
+  }
+  float range = max_value - min_value;
+
+  if (num_frames == 1 || range * 0.5f <= tolerance) {
+    // The whole table fits within the tolerance of a single value.
+    curve._num_keys = 1;
+    curve._base = (range == 0.0f) ? min_value : (min_value + max_value) * 0.5f;
+    return;
+  }
+
+  int max_stride = min(num_frames - 1, 0xffff);
+  int best_bits = 32;
+  int best_stride = 1;
+  size_t best_size = (size_t)num_frames * sizeof(float);
+
+  static const int key_bits[] = { 8, 16, 32 };
+  pvector<unsigned char> scratch;
+  Curve trial;
+  for (int bi = 0; bi < 3; ++bi) {
+    int bits = key_bits[bi];
+    if (bits < 32 && range / (float)((1 << bits) - 1) > tolerance) {
+      // The quantization step would be too coarse.
+      continue;
+    }
+
+    // The error generally grows with the stride, so look for the
+    // widest acceptable stride by doubling and then bisecting.
+    scratch.clear();
+    if (make_curve(trial, scratch, table, num_frames, min_value, range,
+                   bits, 1) > tolerance) {
+      continue;
+    }
+    int good = 1;
+    int bad = max_stride + 1;
+    int stride = 2;
+    while (stride <= max_stride) {
+      scratch.clear();
+      if (make_curve(trial, scratch, table, num_frames, min_value, range,
+                     bits, stride) > tolerance) {
+        bad = stride;
+        break;
+      }
+      good = stride;
+      stride *= 2;
+    }
+    while (bad - good > 1) {
+      int mid = (good + bad) / 2;
+      scratch.clear();
+      if (make_curve(trial, scratch, table, num_frames, min_value, range,
+                     bits, mid) > tolerance) {
+        bad = mid;
+      } else {
+        good = mid;
+      }
+    }
+
+    int num_keys = (num_frames - 1 + good - 1) / good + 1;
+    size_t size = (size_t)num_keys * (bits / 8);
+    if (size < best_size) {
+      best_bits = bits;
+      best_stride = good;
+      best_size = size;
+    }
+  }
+
+  make_curve(curve, data, table, num_frames, min_value, range,
+             best_bits, best_stride);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::make_curve
+//       Access: Private, Static
+//  Description: Fills in the curve with keys of the indicated size
+//               every stride frames, appending the keys to data, and
+//               returns the largest difference between the curve
+//               and the original table over all of its frames.
+////////////////////////////////////////////////////////////////////
+float AnimChannelMatrixCompressed::
+make_curve(Curve &curve, pvector<unsigned char> &data,
+           const float *table, int num_frames,
+           float base, float range, int bits, int stride) {
+  curve._num_frames = (PN_uint16)num_frames;
+  curve._num_keys = (PN_uint16)((num_frames - 1 + stride - 1) / stride + 1);
+  curve._stride = (PN_uint16)stride;
+  curve._bits = (PN_uint8)bits;
+  curve._base = base;
+  curve._scale = (bits < 32) ? range / (float)((1 << bits) - 1) : 0.0f;
+  curve.recompute_inverses();
+
+  while (data.size() % 4 != 0) {
+    data.push_back(0);
+  }
+  curve._offset = (PN_uint32)data.size();
+
+  for (int k = 0; k < (int)curve._num_keys; ++k) {
+    int frame = min(k * stride, num_frames - 1);
+    add_key(data, bits, curve._base, curve._scale, table[frame]);
+  }
+
+  float max_error = 0.0f;
+  const unsigned char *p = &data[0];
+  for (int f = 0; f < num_frames; ++f) {
+    max_error = max(max_error, (float)fabs(curve.get_value(p, f) - table[f]));
+  }
+  return max_error;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::add_key
+//       Access: Private, Static
+//  Description: Appends the indicated value to data as a key of the
+//               indicated size.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+add_key(pvector<unsigned char> &data, int bits, float base, float scale,
+        float value) {
+  if (bits == 32) {
+    unsigned char bytes[sizeof(float)];
+    memcpy(bytes, &value, sizeof(float));
+    data.insert(data.end(), bytes, bytes + sizeof(float));
+    return;
+  }
+
+  int max_code = (1 << bits) - 1;
+  int code = 0;
+  if (scale > 0.0f) {
+    code = (int)cfloor((value - base) / scale + 0.5f);
+    code = max(min(code, max_code), 0);
+  }
+
+  if (bits == 8) {
+    data.push_back((unsigned char)code);
+  } else {
+    PN_uint16 key = (PN_uint16)code;
+    unsigned char bytes[sizeof(PN_uint16)];
+    memcpy(bytes, &key, sizeof(PN_uint16));
+    data.insert(data.end(), bytes, bytes + sizeof(PN_uint16));
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::get_table_index
+//       Access: Private, Static
+//  Description: Returns the table index number, a value between 0 and
+//               num_matrix_components, that corresponds to the
+//               indicated table id.  Returns -1 if the table id is
+//               invalid.
+////////////////////////////////////////////////////////////////////
+int AnimChannelMatrixCompressed::
+get_table_index(char table_id) {
+  for (int i = 0; i < num_matrix_components; i++) {
+    if (table_id == get_table_id(i)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::write_datagram
+//       Access: Public
+//  Description: Function to write the important information in
+//               the particular object to a Datagram
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+write_datagram(BamWriter *manager, Datagram &me) {
+  AnimChannelMatrix::write_datagram(manager, me);
+
+  me.add_bool(_new_hpr);
+
+  const unsigned char *data = _data.p();
+  for (int i = 0; i < num_matrix_components; i++) {
+    const Curve &curve = _curves[i];
+    me.add_uint16(curve._num_frames);
+    if (curve._num_frames == 0) {
+      continue;
+    }
+
+    me.add_uint16(curve._num_keys);
+    me.add_uint16(curve._stride);
+    me.add_uint8(curve._bits);
+    me.add_float32(curve._base);
+    me.add_float32(curve._scale);
+
+    if (curve._num_keys > 1) {
+      const unsigned char *p = data + curve._offset;
+      for (int k = 0; k < (int)curve._num_keys; ++k) {
+        switch (curve._bits) {
+        case 8:
+          me.add_uint8(p[k]);
+          break;
+
+        case 16:
+          me.add_uint16(((const PN_uint16 *)p)[k]);
+          break;
+
+        default:
+          me.add_float32(((const float *)p)[k]);
+          break;
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::fillin
+//       Access: Protected
+//  Description: Function that reads out of the datagram (or asks
+//               manager to read) all of the data that is needed to
+//               re-create this object and stores it in the appropiate
+//               place.  The keys are read directly into the same
+//               compact form they were written from.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  AnimChannelMatrix::fillin(scan, manager);
+
+  _new_hpr = scan.get_bool();
+
+  pvector<unsigned char> data;
+  for (int i = 0; i < num_matrix_components; i++) {
+    Curve &curve = _curves[i];
+    curve = Curve();
+    curve._num_frames = scan.get_uint16();
+    if (curve._num_frames == 0) {
+      continue;
+    }
+
+    curve._num_keys = scan.get_uint16();
+    curve._stride = max(scan.get_uint16(), (PN_uint16)1);
+    curve._bits = scan.get_uint8();
+    curve._base = scan.get_float32();
+    curve._scale = scan.get_float32();
+    curve.recompute_inverses();
+
+    if (curve._num_keys > 1) {
+      while (data.size() % 4 != 0) {
+        data.push_back(0);
+      }
+      curve._offset = (PN_uint32)data.size();
+
+      for (int k = 0; k < (int)curve._num_keys; ++k) {
+        switch (curve._bits) {
+        case 8:
+          data.push_back(scan.get_uint8());
+          break;
+
+        case 16:
+          {
+            PN_uint16 key = scan.get_uint16();
+            unsigned char bytes[sizeof(PN_uint16)];
+            memcpy(bytes, &key, sizeof(PN_uint16));
+            data.insert(data.end(), bytes, bytes + sizeof(PN_uint16));
+          }
+          break;
+
+        default:
+          {
+            curve._bits = 32;
+            float key = scan.get_float32();
+            unsigned char bytes[sizeof(float)];
+            memcpy(bytes, &key, sizeof(float));
+            data.insert(data.end(), bytes, bytes + sizeof(float));
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  PTA_uchar new_data = PTA_uchar::empty_array(data.size(), get_class_type());
+  if (!data.empty()) {
+    memcpy(new_data.p(), &data[0], data.size());
+  }
+  _data = new_data;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::make_AnimChannelMatrixCompressed
+//       Access: Protected
+//  Description: Factory method to generate an
+//               AnimChannelMatrixCompressed object.
+////////////////////////////////////////////////////////////////////
+TypedWritable *AnimChannelMatrixCompressed::
+make_AnimChannelMatrixCompressed(const FactoryParams &params) {
+  AnimChannelMatrixCompressed *me = new AnimChannelMatrixCompressed;
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  me->fillin(scan, manager);
+  return me;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AnimChannelMatrixCompressed::register_with_read_factory
+//       Access: Public, Static
+//  Description: Factory method to generate an
+//               AnimChannelMatrixCompressed object.
+////////////////////////////////////////////////////////////////////
+void AnimChannelMatrixCompressed::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_AnimChannelMatrixCompressed);
+}
@@ -0,0 +1,183 @@
+// Filename: animChannelMatrixCompressed.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef ANIMCHANNELMATRIXCOMPRESSED_H
+#define ANIMCHANNELMATRIXCOMPRESSED_H
+
+#include "pandabase.h"
+
+#include "animChannel.h"
+
+#include "pointerToArray.h"
+#include "pta_float.h"
+#include "pta_uchar.h"
+#include "compose_matrix.h"
+#include "numeric_types.h"
+
+class AnimChannelMatrixXfmTable;
+
+////////////////////////////////////////////////////////////////////
+//       Class : AnimChannelMatrixCompressed
+// Description : An animation channel that issues a matrix each
+//               frame, like AnimChannelMatrixXfmTable, but stores
+//               each of the transform components as a compact curve
+//               instead of a table of floats.
+//
+//               Each curve holds keys at evenly-spaced frames, and
+//               the frames in between are linearly interpolated; the
+//               keys are quantized to 8 or 16 bits where that is
+//               precise enough.  The spacing and precision are
+//               chosen separately for each component, as coarse as
+//               possible while still reproducing every frame of the
+//               original table within a given tolerance.  Since the
+//               keys are evenly spaced, any frame may be decoded
+//               directly, in constant time.
+//
+//               The curves are written to and read from the bam file
+//               in the same form, so, unlike the FFT compression of
+//               AnimChannelMatrixXfmTable, this also reduces the
+//               memory footprint of the loaded animation.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_CHAN AnimChannelMatrixCompressed : public AnimChannelMatrix {
+protected:
+  AnimChannelMatrixCompressed();
+  AnimChannelMatrixCompressed(AnimGroup *parent, const AnimChannelMatrixCompressed &copy);
+
+PUBLISHED:
+  AnimChannelMatrixCompressed(AnimGroup *parent, const string &name);
+  AnimChannelMatrixCompressed(AnimGroup *parent, 
+                              const AnimChannelMatrixXfmTable &source,
+                              float tolerance, float hpr_tolerance);
+  virtual ~AnimChannelMatrixCompressed();
+
+public:
+  virtual bool has_changed(int last_frame, double last_frac, 
+                           int this_frame, double this_frac);
+  virtual void get_value(int frame, LMatrix4f &mat);
+
+  virtual void get_value_no_scale_shear(int frame, LMatrix4f &value);
+  virtual void get_scale(int frame, LVecBase3f &scale);
+  virtual void get_hpr(int frame, LVecBase3f &hpr);
+  virtual void get_quat(int frame, LQuaternionf &quat);
+  virtual void get_pos(int frame, LVecBase3f &pos);
+  virtual void get_shear(int frame, LVecBase3f &shear);
+
+PUBLISHED:
+  void set_table(char table_id, const CPTA_float &table, float tolerance);
+  PTA_float get_table(char table_id) const;
+
+  void clear_all_tables();
+  INLINE bool has_table(char table_id) const;
+  INLINE int get_num_keys(char table_id) const;
+  INLINE int get_key_stride(char table_id) const;
+  INLINE int get_key_bits(char table_id) const;
+
+  size_t get_data_size() const;
+
+public:
+  virtual void write(ostream &out, int indent_level) const;
+
+protected:
+  virtual AnimGroup *make_copy(AnimGroup *parent) const;
+
+private:
+  // One of these describes each of the transform components.  The
+  // keys themselves are stored in _data, beginning at _offset.
+  class Curve {
+  public:
+    INLINE Curve();
+    INLINE float get_key(const unsigned char *data, int key) const;
+    INLINE float get_value(const unsigned char *data, int frame) const;
+    INLINE void recompute_inverses();
+
+    // The number of frames in the original table; 0 if there is no
+    // table, in which case the component has its default value.
+    PN_uint16 _num_frames;
+
+    // The number of keys.  If there is only one, it is stored in
+    // _base, and the component is constant.
+    PN_uint16 _num_keys;
+
+    // The number of frames from one key to the next.  The last key
+    // is always on the last frame, so the last interval may be
+    // shorter.
+    PN_uint16 _stride;
+
+    // The size of each key: 8 or 16 for a quantized key, which
+    // represents _base + key * _scale; or 32 for a float.
+    PN_uint8 _bits;
+
+    float _base;
+    float _scale;
+    float _inv_stride;
+    float _inv_last;
+    PN_uint32 _offset;
+  };
+
+  INLINE float get_component(int table_index, int frame) const;
+  void get_components(int frame, float components[num_matrix_components]) const;
+  void get_hpr_components(int frame, LVecBase3f &hpr) const;
+
+  static void compress_table(Curve &curve, pvector<unsigned char> &data,
+                             const float *table, int num_frames,
+                             float tolerance);
+  static float make_curve(Curve &curve, pvector<unsigned char> &data,
+                          const float *table, int num_frames,
+                          float base, float range, int bits, int stride);
+  static void add_key(pvector<unsigned char> &data, int bits, float base,
+                      float scale, float value);
+
+  INLINE static char get_table_id(int table_index);
+  static int get_table_index(char table_id);
+  INLINE static float get_default_value(int table_index);
+
+  Curve _curves[num_matrix_components];
+  CPTA_uchar _data;
+
+  // True if the hpr curves were computed with temp-hpr-fix in
+  // effect.  If this doesn't match the current setting, they are
+  // converted as they are decoded.
+  bool _new_hpr;
+
+public:
+  static void register_with_read_factory();
+  virtual void write_datagram(BamWriter* manager, Datagram &me);
+
+  static TypedWritable *make_AnimChannelMatrixCompressed(const FactoryParams &params);
+
+protected:
+  void fillin(DatagramIterator& scan, BamReader* manager);
+
+public:
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AnimChannelMatrix::init_type();
+    register_type(_type_handle, "AnimChannelMatrixCompressed",
+                  AnimChannelMatrix::get_class_type());
+  }
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "animChannelMatrixCompressed.I"
+
+#endif
@@ -18,6 +18,7 @@
 #include "animBundleNode.h"
 #include "animChannelBase.h"
 #include "animChannelMatrixXfmTable.h"
+#include "animChannelMatrixCompressed.h"
 #include "animChannelMatrixDynamic.h"
 #include "animChannelMatrixFixed.h"
 #include "animChannelScalarTable.h"
@@ -109,6 +110,7 @@ ConfigureFn(config_chan) {
   AnimBundleNode::init_type();
   AnimChannelBase::init_type();
   AnimChannelMatrixXfmTable::init_type();
+  AnimChannelMatrixCompressed::init_type();
   AnimChannelMatrixDynamic::init_type();
   AnimChannelMatrixFixed::init_type();
   AnimChannelScalarTable::init_type();
@@ -141,6 +143,7 @@ ConfigureFn(config_chan) {
   AnimBundle::register_with_read_factory();
   AnimBundleNode::register_with_read_factory();
   AnimChannelMatrixXfmTable::register_with_read_factory();
+  AnimChannelMatrixCompressed::register_with_read_factory();
   AnimChannelMatrixDynamic::register_with_read_factory();
   AnimChannelScalarTable::register_with_read_factory();
   AnimChannelScalarDynamic::register_with_read_factory();
@@ -32,7 +32,8 @@ MovingPartBase::
 MovingPartBase(PartGroup *parent, const string &name) :
   PartGroup(parent, name),
   _num_effective_channels(0),
-  _effective_control(NULL)
+  _effective_control(NULL),
+  _lod_excluded(false)
 {
 }
 
@@ -44,7 +45,8 @@ MovingPartBase(PartGroup *parent, const string &name) :
 MovingPartBase::
 MovingPartBase() :
   _num_effective_channels(0),
-  _effective_control(NULL)
+  _effective_control(NULL),
+  _lod_excluded(false)
 {
 }
 
@@ -136,8 +138,11 @@ do_update(PartBundle *root, const CycleData *root_cdata, PartGroup *parent,
   bool needs_update = anim_changed;
 
   // See if any of the channel values have changed since last time.
+  // If the bundle is animating only its reduced set of joints (see
+  // PartBundle::set_lod_subset()), and this is not one of them, it
+  // keeps its current value.
 
-  if (!needs_update) {
+  if (!needs_update && !(_lod_excluded && root->_lod_reduced)) {
     if (_forced_channel != (AnimChannelBase *)NULL) {
       needs_update = _forced_channel->has_changed(0, 0.0, 0, 0.0);
     
@@ -97,6 +97,11 @@ protected:
   // via set_forced_channel().  It overrides all of the above if set.
   PT(AnimChannelBase) _forced_channel;
 
+  // This is true if the part is not in the bundle's LOD subset, and
+  // so is not animated while the bundle is reduced.  See
+  // PartBundle::set_lod_subset().
+  bool _lod_excluded;
+
 public:
   virtual TypeHandle get_type() const {
     return get_class_type();
@@ -115,6 +120,9 @@ public:
 
 private:
   static TypeHandle _type_handle;
+
+  friend class CharacterBatchEvaluator;
+  friend class PartBundle;
 };
 
 #include "movingPartBase.I"
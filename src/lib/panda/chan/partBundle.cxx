@@ -17,6 +17,7 @@
 #include "animBundle.h"
 #include "animBundleNode.h"
 #include "animControl.h"
+#include "movingPartBase.h"
 #include "loader.h"
 #include "animPreloadTable.h"
 #include "config_chan.h"
@@ -56,6 +57,8 @@ PartBundle(const PartBundle &copy) :
 {
   _anim_preload = copy._anim_preload;
   _update_delay = 0.0;
+  _lod_reduced = false;
+  _lod_frame_blend = false;
 
   CDWriter cdata(_cycler, true);
   CDReader cdata_from(copy._cycler);
@@ -77,6 +80,8 @@ PartBundle(const string &name) :
   PartGroup(name)
 {
   _update_delay = 0.0;
+  _lod_reduced = false;
+  _lod_frame_blend = false;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -552,6 +557,14 @@ update() {
     bool anim_changed = cdata->_anim_changed;
     bool frame_blend_flag = cdata->_frame_blend_flag;
 
+    // If the LOD asks for it, blend between frames for this update
+    // only; see set_lod_frame_blend().
+    bool lod_frame_blend = (_lod_frame_blend && !frame_blend_flag);
+    if (lod_frame_blend) {
+      cdata->_frame_blend_flag = true;
+      frame_blend_flag = true;
+    }
+
     any_changed = do_update(this, cdata, NULL, false, anim_changed, 
                             current_thread);
     
@@ -562,6 +575,9 @@ update() {
       control->mark_channels(frame_blend_flag);
     }
     
+    if (lod_frame_blend) {
+      cdata->_frame_blend_flag = false;
+    }
     cdata->_anim_changed = false;
     cdata->_last_update = now;
   }
@@ -595,6 +611,77 @@ force_update() {
 }
 
 
+////////////////////////////////////////////////////////////////////
+//     Function: PartBundle::set_lod_subset
+//       Access: Public
+//  Description: Specifies the parts that should still be animated
+//               while the bundle is reduced (see set_lod_reduced()),
+//               using the same rules as the subset passed to
+//               bind_anim().  The other parts hold their current
+//               values while the bundle is reduced, though they
+//               still follow their parents.  This is normally used
+//               by Character::set_lod_reduced_joints(), and should
+//               not be called directly.
+////////////////////////////////////////////////////////////////////
+void PartBundle::
+set_lod_subset(const PartSubset &subset) {
+  r_set_lod_subset(this, subset.is_include_empty(), subset);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PartBundle::clear_lod_subset
+//       Access: Public
+//  Description: Undoes the effect of set_lod_subset(), so that all
+//               of the parts are animated even while the bundle is
+//               reduced.
+////////////////////////////////////////////////////////////////////
+void PartBundle::
+clear_lod_subset() {
+  r_set_lod_subset(this, true, PartSubset());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PartBundle::set_lod_reduced
+//       Access: Public
+//  Description: Specifies whether the bundle should animate only the
+//               parts in its LOD subset (see set_lod_subset()).  When
+//               the bundle goes back to animating all of its parts,
+//               the next update() brings all of them up to date.
+//               This is normally used by Character's animation LOD,
+//               and should not be called directly.
+////////////////////////////////////////////////////////////////////
+void PartBundle::
+set_lod_reduced(bool lod_reduced) {
+  if (_lod_reduced != lod_reduced) {
+    _lod_reduced = lod_reduced;
+    if (!lod_reduced) {
+      CDWriter cdata(_cycler);
+      cdata->_anim_changed = true;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PartBundle::set_lod_frame_blend
+//       Access: Public
+//  Description: Specifies whether update() should blend between
+//               sequential frames, as if the frame_blend_flag were
+//               set, even though it isn't.  A character whose updates
+//               are spaced out by its animation LOD uses this so that
+//               each update shows the pose at that precise moment,
+//               rather than the last whole frame.  This is normally
+//               used by Character's animation LOD, and should not be
+//               called directly.
+////////////////////////////////////////////////////////////////////
+void PartBundle::
+set_lod_frame_blend(bool lod_frame_blend) {
+  if (_lod_frame_blend != lod_frame_blend) {
+    _lod_frame_blend = lod_frame_blend;
+    CDWriter cdata(_cycler);
+    cdata->_anim_changed = true;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PartBundle::control_activated
 //       Access: Public, Virtual
@@ -759,6 +846,31 @@ do_get_control_effect(AnimControl *control, const CData *cdata) const {
 }
 
 
+////////////////////////////////////////////////////////////////////
+//     Function: PartBundle::r_set_lod_subset
+//       Access: Private, Static
+//  Description: The recursive implementation of set_lod_subset().
+//               This matches the subset against the part names in
+//               the same way as bind_hierarchy().
+////////////////////////////////////////////////////////////////////
+void PartBundle::
+r_set_lod_subset(PartGroup *part, bool is_included, const PartSubset &subset) {
+  if (subset.matches_include(part->get_name())) {
+    is_included = true;
+  } else if (subset.matches_exclude(part->get_name())) {
+    is_included = false;
+  }
+
+  if (part->is_of_type(MovingPartBase::get_class_type())) {
+    ((MovingPartBase *)part)->_lod_excluded = !is_included;
+  }
+
+  int num_children = part->get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_set_lod_subset(part->get_child(i), is_included, subset);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PartBundle::recompute_net_blend
 //       Access: Private
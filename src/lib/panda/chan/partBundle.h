@@ -150,6 +150,14 @@ public:
   // bunch of friends.
   virtual void control_activated(AnimControl *control);
   INLINE void set_update_delay(double delay);
+  INLINE bool is_update_due(double now, Thread *current_thread) const;
+
+  void set_lod_subset(const PartSubset &subset);
+  void clear_lod_subset();
+  void set_lod_reduced(bool lod_reduced);
+  INLINE bool get_lod_reduced() const;
+  void set_lod_frame_blend(bool lod_frame_blend);
+  INLINE bool get_lod_frame_blend() const;
 
   bool do_bind_anim(AnimControl *control, AnimBundle *anim,
                     int hierarchy_match_flags, const PartSubset &subset);
@@ -165,6 +173,8 @@ private:
   float do_get_control_effect(AnimControl *control, const CData *cdata) const;
   void recompute_net_blend(CData *cdata);
   void clear_and_stop_intersecting(AnimControl *control, CData *cdata);
+  static void r_set_lod_subset(PartGroup *part, bool is_included,
+                               const PartSubset &subset);
 
   COWPT(AnimPreloadTable) _anim_preload;
 
@@ -175,6 +185,8 @@ private:
   AppliedTransforms _applied_transforms;
 
   double _update_delay;
+  bool _lod_reduced;
+  bool _lod_frame_blend;
 
   // This is the data that must be cycled between pipeline stages.
   class CData : public CycleData {
@@ -236,6 +248,7 @@ private:
 
   friend class PartBundleNode;
   friend class Character;
+  friend class CharacterBatchEvaluator;
   friend class MovingPartBase;
   friend class MovingPartMatrix;
   friend class MovingPartScalar;
@@ -28,10 +28,15 @@
 #include "camera.h"
 #include "cullTraverser.h"
 #include "cullTraverserData.h"
+#include "lens.h"
+#include "deg_2_rad.h"
 
 TypeHandle Character::_type_handle;
 
 PStatCollector Character::_animation_pcollector("*:Animation");
+PStatCollector Character::_lod_skipped_pcollector("Animation LOD:Skipped");
+PStatCollector Character::_lod_throttled_pcollector("Animation LOD:Throttled");
+PStatCollector Character::_lod_reduced_pcollector("Animation LOD:Reduced");
 
 ////////////////////////////////////////////////////////////////////
 //     Function: Character::Copy Constructor
@@ -45,7 +50,17 @@ Character(const Character &copy, bool copy_bundles) :
   _lod_far_distance(copy._lod_far_distance),
   _lod_near_distance(copy._lod_near_distance),
   _lod_delay_factor(copy._lod_delay_factor),
+  _has_lod_range(copy._has_lod_range),
   _do_lod_animation(copy._do_lod_animation),
+  _lod_screen_size(copy._lod_screen_size),
+  _lod_radius(copy._lod_radius),
+  _lod_full_size(copy._lod_full_size),
+  _lod_min_size(copy._lod_min_size),
+  _lod_reduced_subset(copy._lod_reduced_subset),
+  _lod_reduced_level(copy._lod_reduced_level),
+  _do_lod_reduced(copy._do_lod_reduced),
+  _lod_interpolate(copy._lod_interpolate),
+  _lod_skip_offscreen(copy._lod_skip_offscreen),
   _joints_pcollector(copy._joints_pcollector),
   _skinning_pcollector(copy._skinning_pcollector)
 {
@@ -69,7 +84,9 @@ Character(const Character &copy, bool copy_bundles) :
   }    
   _last_auto_update = -1.0;
   _view_frame = -1;
-  _view_distance2 = 0.0f;
+  _view_lod_level = 0.0f;
+  _last_visible_frame = -1;
+  _lod_level = 0.0f;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -84,10 +101,15 @@ Character(const string &name) :
   _skinning_pcollector(PStatCollector(_animation_pcollector, name), "Vertices")
 {
   set_cull_callback();
+  _do_lod_reduced = false;
+  _lod_reduced_level = 0.0f;
+  _lod_interpolate = false;
+  _lod_skip_offscreen = false;
   clear_lod_animation();
   _last_auto_update = -1.0;
   _view_frame = -1;
-  _view_distance2 = 0.0f;
+  _view_lod_level = 0.0f;
+  _last_visible_frame = -1;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -195,31 +217,24 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
   // optimization later, to handle characters that might animate
   // themselves in front of the view frustum.
 
-  if (_do_lod_animation) {
-    int this_frame = ClockObject::get_global_clock()->get_frame_count();
+  int this_frame = ClockObject::get_global_clock()->get_frame_count();
+  _last_visible_frame = this_frame;
 
-    CPT(TransformState) rel_transform = get_rel_transform(trav, data);
-    LPoint3f center = _lod_center * rel_transform->get_mat();
-    float dist2 = center.dot(center);
+  if (_do_lod_animation) {
+    float lod_level = compute_lod_level(trav, data);
 
-    if (this_frame != _view_frame || dist2 < _view_distance2) {
+    // If multiple cameras are viewing the character, the one that
+    // sees the most detail counts.
+    if (this_frame != _view_frame || lod_level < _view_lod_level) {
       _view_frame = this_frame;
-      _view_distance2 = dist2;
-
-      // Now compute the lod delay.
-      float dist = sqrt(dist2);
-      double delay = 0.0;
-      if (dist > _lod_near_distance) {
-        delay = _lod_delay_factor * (dist - _lod_near_distance) / (_lod_far_distance - _lod_near_distance);
-        nassertr(delay > 0.0, false);
-      }
-      set_lod_current_delay(delay);
+      _view_lod_level = lod_level;
+      set_lod_current_level(lod_level);
 
       if (char_cat.is_spam()) {
         char_cat.spam() 
-          << "Distance to " << NodePath::any_path(this) << " in frame "
-          << this_frame << " is " << dist << ", computed delay is " << delay
-          << "\n";
+          << "LOD level of " << NodePath::any_path(this) << " in frame "
+          << this_frame << " is " << lod_level << ", computed delay is "
+          << _lod_delay_factor * lod_level << "\n";
       }
     }
   }
@@ -373,10 +388,45 @@ set_lod_animation(const LPoint3f &center,
   _lod_far_distance = far_distance;
   _lod_near_distance = near_distance;
   _lod_delay_factor = delay_factor;
-  _do_lod_animation = (_lod_far_distance > _lod_near_distance && _lod_delay_factor > 0.0);
-  if (!_do_lod_animation) {
-    set_lod_current_delay(0.0);
-  }
+  _lod_screen_size = false;
+  _has_lod_range = (_lod_far_distance > _lod_near_distance);
+  update_do_lod_animation();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Character::set_lod_animation_screen
+//       Access: Published
+//  Description: Activates the same mode as set_lod_animation(), but
+//               the animation rate is chosen according to how large
+//               the character appears onscreen, rather than its
+//               distance from the camera, so that it takes the
+//               camera's field of view into account.
+//
+//               The character is approximated by a sphere of the
+//               indicated radius around center, which is a fixed
+//               point relative to the character node.  Its size is
+//               measured as the fraction of half the height of the
+//               screen that the radius covers.  If this is at least
+//               full_size, the character is animated every frame; if
+//               it is min_size or less, it is animated only every
+//               delay_factor seconds.  In between, the delay is
+//               linearly interpolated.
+////////////////////////////////////////////////////////////////////
+void Character::
+set_lod_animation_screen(const LPoint3f &center, float radius,
+                         float full_size, float min_size,
+                         float delay_factor) {
+  nassertv(full_size >= min_size && min_size >= 0.0f);
+  nassertv(radius > 0.0f);
+  nassertv(delay_factor >= 0.0f);
+  _lod_center = center;
+  _lod_radius = radius;
+  _lod_full_size = full_size;
+  _lod_min_size = min_size;
+  _lod_delay_factor = delay_factor;
+  _lod_screen_size = true;
+  _has_lod_range = (_lod_full_size > _lod_min_size);
+  update_do_lod_animation();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -393,8 +443,81 @@ clear_lod_animation() {
   _lod_far_distance = 0.0f;
   _lod_near_distance = 0.0f;
   _lod_delay_factor = 0.0f;
-  _do_lod_animation = false;
-  set_lod_current_delay(0.0);
+  _lod_screen_size = false;
+  _lod_radius = 0.0f;
+  _lod_full_size = 0.0f;
+  _lod_min_size = 0.0f;
+  _has_lod_range = false;
+  update_do_lod_animation();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Character::set_lod_reduced_joints
+//       Access: Published
+//  Description: Specifies a subset of the character's joints and
+//               sliders that should continue to be animated when the
+//               character is far away, while the rest simply hold
+//               their current pose (though they still follow their
+//               parents).  The subset is matched against the part
+//               names in the same way as the subset passed to
+//               bind_anim().
+//
+//               This takes effect when the LOD level computed by
+//               set_lod_animation() or set_lod_animation_screen()
+//               reaches lod_level; the level is 0 when the character
+//               is animated every frame, and 1 when it is animated
+//               every delay_factor seconds.
+////////////////////////////////////////////////////////////////////
+void Character::
+set_lod_reduced_joints(const PartSubset &subset, float lod_level) {
+  _lod_reduced_subset = subset;
+  _lod_reduced_level = lod_level;
+  _do_lod_reduced = true;
+
+  int num_bundles = get_num_bundles();
+  for (int i = 0; i < num_bundles; ++i) {
+    get_bundle(i)->set_lod_subset(subset);
+  }
+  update_do_lod_animation();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Character::clear_lod_reduced_joints
+//       Access: Published
+//  Description: Undoes the effect of a previous call to
+//               set_lod_reduced_joints().  Henceforth, all of the
+//               joints are animated, however far away the character
+//               is.
+////////////////////////////////////////////////////////////////////
+void Character::
+clear_lod_reduced_joints() {
+  _lod_reduced_subset = PartSubset();
+  _lod_reduced_level = 0.0f;
+  _do_lod_reduced = false;
+
+  int num_bundles = get_num_bundles();
+  for (int i = 0; i < num_bundles; ++i) {
+    get_bundle(i)->clear_lod_subset();
+  }
+  update_do_lod_animation();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Character::set_lod_interpolate
+//       Access: Published
+//  Description: When this is true, a character whose updates are
+//               spaced out by set_lod_animation() blends between
+//               sequential frames of its animations, so that each
+//               update shows the pose at that precise moment instead
+//               of the last whole frame.  This makes the lower update
+//               rate much less noticeable, at the cost of a little
+//               more work per update.  It has no effect on a
+//               character that is animated every frame.
+////////////////////////////////////////////////////////////////////
+void Character::
+set_lod_interpolate(bool lod_interpolate) {
+  _lod_interpolate = lod_interpolate;
+  set_lod_current_level(_lod_level);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -495,6 +618,11 @@ update_to_now() {
 ////////////////////////////////////////////////////////////////////
 void Character::
 update() {
+  if (is_lod_offscreen()) {
+    _lod_skipped_pcollector.add_level(1);
+    return;
+  }
+
   double now = ClockObject::get_global_clock()->get_frame_time();
   if (now != _last_auto_update) {
     _last_auto_update = now;
@@ -650,24 +778,108 @@ do_update() {
       get_bundle(i)->force_update();
     }
   } else {
+    Thread *current_thread = Thread::get_current_thread();
+    double now = ClockObject::get_global_clock()->get_frame_time();
+
     int num_bundles = get_num_bundles();
     for (int i = 0; i < num_bundles; ++i) {
-      get_bundle(i)->update();
+      PartBundle *bundle = get_bundle(i);
+      if (_do_lod_animation) {
+        if (!bundle->is_update_due(now, current_thread)) {
+          _lod_throttled_pcollector.add_level(1);
+        } else if (bundle->get_lod_reduced()) {
+          _lod_reduced_pcollector.add_level(1);
+        }
+      }
+      bundle->update();
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////
-//     Function: Character::set_lod_current_delay
+//     Function: Character::compute_lod_level
 //       Access: Private
-//  Description: Changes the amount of delay we should impose due to
-//               the LOD animation setting.
+//  Description: Computes the animation LOD level of the character as
+//               seen by the current camera, according to the
+//               parameters given to set_lod_animation() or
+//               set_lod_animation_screen().  The result is 0 if the
+//               character should be animated every frame, 1 if it
+//               should be animated every delay_factor seconds, and
+//               something in between (or beyond, in the distance
+//               case) otherwise.
+////////////////////////////////////////////////////////////////////
+float Character::
+compute_lod_level(CullTraverser *trav, CullTraverserData &data) {
+  CPT(TransformState) rel_transform = get_rel_transform(trav, data);
+  LPoint3f center = _lod_center * rel_transform->get_mat();
+  float dist = sqrt(center.dot(center));
+
+  if (!_lod_screen_size) {
+    if (dist <= _lod_near_distance) {
+      return 0.0f;
+    }
+    return (dist - _lod_near_distance) / (_lod_far_distance - _lod_near_distance);
+  }
+
+  // Measure the radius against half the height of the screen at the
+  // character's distance.  The radius is scaled along with the
+  // character.
+  const Lens *lens = trav->get_scene()->get_lens();
+  float radius = _lod_radius * rel_transform->get_mat().get_row3(1).length();
+  float half_height;
+  if (lens->is_linear() && lens->is_perspective()) {
+    half_height = dist * ctan(deg_2_rad(lens->get_fov()[1] * 0.5f));
+  } else {
+    half_height = lens->get_film_size()[1] * 0.5f;
+  }
+  if (half_height <= radius) {
+    return 0.0f;
+  }
+
+  float size = radius / half_height;
+  float lod_level = (_lod_full_size - size) / (_lod_full_size - _lod_min_size);
+  return max(min(lod_level, 1.0f), 0.0f);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Character::set_lod_current_level
+//       Access: Private
+//  Description: Applies the indicated LOD level to the bundles: it
+//               determines the amount of delay we should impose on
+//               their updates, and whether they should animate only
+//               the reduced subset of joints.
 ////////////////////////////////////////////////////////////////////
 void Character::
-set_lod_current_delay(double delay) {
+set_lod_current_level(float lod_level) {
+  _lod_level = lod_level;
+  double delay = _lod_delay_factor * lod_level;
+  bool reduced = (_do_lod_reduced && lod_level > 0.0f &&
+                  lod_level >= _lod_reduced_level);
+  bool frame_blend = (_lod_interpolate && delay > 0.0);
+
   int num_bundles = get_num_bundles();
   for (int i = 0; i < num_bundles; ++i) {
-    get_bundle(i)->set_update_delay(delay);
+    PartBundle *bundle = get_bundle(i);
+    bundle->set_update_delay(delay);
+    bundle->set_lod_reduced(reduced);
+    bundle->set_lod_frame_blend(frame_blend);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Character::update_do_lod_animation
+//       Access: Private
+//  Description: Recomputes _do_lod_animation after one of the LOD
+//               parameters has changed.  If the LOD is no longer in
+//               effect, the character goes back to animating fully,
+//               every frame.
+////////////////////////////////////////////////////////////////////
+void Character::
+update_do_lod_animation() {
+  _do_lod_animation = (_has_lod_range &&
+                       (_lod_delay_factor > 0.0f || _do_lod_reduced));
+  if (!_do_lod_animation) {
+    set_lod_current_level(0.0f);
   }
 }
 
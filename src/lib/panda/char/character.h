@@ -26,6 +26,7 @@
 #include "pointerTo.h"
 #include "geom.h"
 #include "pStatCollector.h"
+#include "partSubset.h"
 #include "transformTable.h"
 #include "transformBlendTable.h"
 #include "sliderTable.h"
@@ -52,6 +53,9 @@ public:
 
   virtual bool cull_callback(CullTraverser *trav, CullTraverserData &data);
 
+  INLINE static void flush_level();
+  INLINE static void clear_level();
+
   virtual CPT(TransformState)
     calc_tight_bounds(LPoint3f &min_point, LPoint3f &max_point,
                       bool &found_any,
@@ -69,7 +73,19 @@ PUBLISHED:
   void set_lod_animation(const LPoint3f &center, 
                          float far_distance, float near_distance,
                          float delay_factor);
+  void set_lod_animation_screen(const LPoint3f &center, float radius,
+                                float full_size, float min_size,
+                                float delay_factor);
   void clear_lod_animation();
+  INLINE float get_lod_level() const;
+
+  void set_lod_reduced_joints(const PartSubset &subset, float lod_level);
+  void clear_lod_reduced_joints();
+
+  void set_lod_interpolate(bool lod_interpolate);
+  INLINE bool get_lod_interpolate() const;
+  INLINE void set_lod_skip_offscreen(bool lod_skip_offscreen);
+  INLINE bool get_lod_skip_offscreen() const;
 
   CharacterJoint *find_joint(const string &name) const;
   CharacterSlider *find_slider(const string &name) const;
@@ -90,7 +106,10 @@ protected:
 
 private:
   void do_update();
-  void set_lod_current_delay(double delay);
+  float compute_lod_level(CullTraverser *trav, CullTraverserData &data);
+  void set_lod_current_level(float lod_level);
+  void update_do_lod_animation();
+  INLINE bool is_lod_offscreen() const;
 
   typedef pmap<const PandaNode *, PandaNode *> NodeMap;
   typedef pmap<const PartGroup *, PartGroup *> JointMap;
@@ -137,18 +156,37 @@ private:
   double _last_auto_update;
 
   int _view_frame;
-  double _view_distance2;
+  float _view_lod_level;
+  int _last_visible_frame;
 
   LPoint3f _lod_center;
   float _lod_far_distance;
   float _lod_near_distance;
   float _lod_delay_factor;
+  bool _has_lod_range;
   bool _do_lod_animation;
 
+  // These are used instead of the distances by
+  // set_lod_animation_screen().
+  bool _lod_screen_size;
+  float _lod_radius;
+  float _lod_full_size;
+  float _lod_min_size;
+
+  PartSubset _lod_reduced_subset;
+  float _lod_reduced_level;
+  bool _do_lod_reduced;
+  bool _lod_interpolate;
+  bool _lod_skip_offscreen;
+  float _lod_level;
+
   // Statistics
   PStatCollector _joints_pcollector;
   PStatCollector _skinning_pcollector;
   static PStatCollector _animation_pcollector;
+  static PStatCollector _lod_skipped_pcollector;
+  static PStatCollector _lod_throttled_pcollector;
+  static PStatCollector _lod_reduced_pcollector;
 
   // This variable is only used temporarily, while reading from the
   // bam file.
@@ -180,6 +218,8 @@ public:
 
 private:
   static TypeHandle _type_handle;
+
+  friend class CharacterBatchEvaluator;
 };
 
 #include "character.I"
@@ -0,0 +1,472 @@
+// Filename: characterBatchEvaluator.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "characterBatchEvaluator.h"
+#include "characterJoint.h"
+#include "characterJointBundle.h"
+#include "partBundle.h"
+#include "animControl.h"
+#include "config_char.h"
+#include "vertexAnimationWorkQueue.h"
+#include "clockObject.h"
+#include "pStatTimer.h"
+
+PStatCollector CharacterBatchEvaluator::_batch_pcollector("*:Animation:Batch");
+PStatCollector CharacterBatchEvaluator::_poses_evaluated_pcollector("Animation poses:Evaluated");
+PStatCollector CharacterBatchEvaluator::_poses_shared_pcollector("Animation poses:Shared");
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::Constructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+CharacterBatchEvaluator::
+CharacterBatchEvaluator() :
+  _num_poses_evaluated(0),
+  _num_poses_shared(0),
+  _num_bundles_fallback(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::Destructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+CharacterBatchEvaluator::
+~CharacterBatchEvaluator() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::add_character
+//       Access: Published
+//  Description: Adds the indicated character to the set that will be
+//               animated by update().  It is not an error to add the
+//               same character twice; the second call is ignored.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::
+add_character(Character *character) {
+  nassertv(character != (Character *)NULL);
+  if (has_character(character)) {
+    return;
+  }
+
+  _characters.push_back(CharacterDef());
+  CharacterDef &def = _characters.back();
+  def._character = character;
+
+  int num_bundles = character->get_num_bundles();
+  def._bundles.resize(num_bundles);
+  for (int i = 0; i < num_bundles; ++i) {
+    def._bundles[i].flatten(character->get_bundle(i));
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::remove_character
+//       Access: Published
+//  Description: Removes the indicated character from the set that
+//               will be animated by update().  Returns true if it
+//               was removed, false if it had not been added.
+////////////////////////////////////////////////////////////////////
+bool CharacterBatchEvaluator::
+remove_character(Character *character) {
+  Characters::iterator ci;
+  for (ci = _characters.begin(); ci != _characters.end(); ++ci) {
+    if ((*ci)._character == character) {
+      _characters.erase(ci);
+      return true;
+    }
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::has_character
+//       Access: Published
+//  Description: Returns true if the indicated character has been
+//               added to the evaluator, false otherwise.
+////////////////////////////////////////////////////////////////////
+bool CharacterBatchEvaluator::
+has_character(Character *character) const {
+  Characters::const_iterator ci;
+  for (ci = _characters.begin(); ci != _characters.end(); ++ci) {
+    if ((*ci)._character == character) {
+      return true;
+    }
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::clear_characters
+//       Access: Published
+//  Description: Removes all of the characters from the evaluator.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::
+clear_characters() {
+  _characters.clear();
+  _poses.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::update
+//       Access: Published
+//  Description: Animates all of the characters for the current
+//               frame, as if Character::update() had been called on
+//               each one.  Characters that have already been
+//               animated this frame are left alone.
+//
+//               This should be called once per frame, after the
+//               AnimControls have been started or adjusted, and
+//               before the frame is rendered.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::
+update() {
+  Thread *current_thread = Thread::get_current_thread();
+  PStatTimer timer(_batch_pcollector, current_thread);
+  double now = ClockObject::get_global_clock()->get_frame_time(current_thread);
+
+  _poses.clear();
+  _num_poses_shared = 0;
+  _num_bundles_fallback = 0;
+
+  // First, decide which bundles need to be animated, and which
+  // distinct poses they need.
+  PoseIndices pose_indices;
+  int num_joints = 0;
+
+  Characters::iterator ci;
+  for (ci = _characters.begin(); ci != _characters.end(); ++ci) {
+    CharacterDef &def = (*ci);
+    Character *character = def._character;
+
+    // If the character's bundles have changed, for instance by
+    // merge_bundles(), flatten them again.
+    int num_bundles = character->get_num_bundles();
+    bool bundles_changed = ((int)def._bundles.size() != num_bundles);
+    for (int i = 0; i < num_bundles && !bundles_changed; ++i) {
+      bundles_changed = (def._bundles[i]._bundle != (PartBundle *)character->get_bundle(i));
+    }
+    if (bundles_changed) {
+      def._bundles.clear();
+      def._bundles.resize(num_bundles);
+      for (int i = 0; i < num_bundles; ++i) {
+        def._bundles[i].flatten(character->get_bundle(i));
+      }
+    }
+
+    if (character->_last_auto_update == now || character->is_lod_offscreen()) {
+      // This character has already been animated this frame, or it
+      // is offscreen and has asked not to be.
+      if (character->_last_auto_update != now) {
+        Character::_lod_skipped_pcollector.add_level(1);
+      }
+      Bundles::iterator bi;
+      for (bi = def._bundles.begin(); bi != def._bundles.end(); ++bi) {
+        (*bi)._state = Bundle::S_idle;
+      }
+      continue;
+    }
+    character->_last_auto_update = now;
+
+    Bundles::iterator bi;
+    for (bi = def._bundles.begin(); bi != def._bundles.end(); ++bi) {
+      Bundle &bundle = (*bi);
+      prepare_bundle(bundle, now, current_thread);
+
+      if (bundle._state == Bundle::S_pose) {
+        pair<PoseIndices::iterator, bool> result =
+          pose_indices.insert(PoseIndices::value_type(PoseKey(&bundle), (int)_poses.size()));
+        if (result.second) {
+          _poses.push_back(Pose());
+          Pose &pose = _poses.back();
+          pose._source = &bundle;
+          pose._frame = bundle._frame;
+          pose._root_xform = bundle._root_xform;
+          num_joints += (int)bundle._joints.size();
+        } else {
+          ++_num_poses_shared;
+        }
+        bundle._pose_index = (*result.first).second;
+
+      } else if (bundle._state == Bundle::S_fallback) {
+        ++_num_bundles_fallback;
+      }
+    }
+  }
+
+  // Now compute each of the distinct poses.  This touches nothing
+  // but the animation channels and the poses themselves, so it may
+  // be done on several threads at once.
+  int num_poses = (int)_poses.size();
+  if (num_poses > 0) {
+    VertexAnimationWorkQueue *queue = NULL;
+    if (num_poses > 1 && num_joints >= anim_batch_min_joints) {
+      queue = VertexAnimationWorkQueue::get_global_ptr();
+    }
+    if (queue != (VertexAnimationWorkQueue *)NULL) {
+      queue->run_parallel(&evaluate_poses, &_poses[0], num_poses);
+    } else {
+      evaluate_poses(&_poses[0], 0, num_poses);
+    }
+  }
+
+  // Finally, hand the poses to the bundles, and update the bundles
+  // we couldn't batch.  This changes nodes in the scene graph, so it
+  // is done on this thread only.
+  for (ci = _characters.begin(); ci != _characters.end(); ++ci) {
+    Bundles::iterator bi;
+    for (bi = (*ci)._bundles.begin(); bi != (*ci)._bundles.end(); ++bi) {
+      Bundle &bundle = (*bi);
+      switch (bundle._state) {
+      case Bundle::S_idle:
+        break;
+
+      case Bundle::S_fallback:
+        if (even_animation) {
+          bundle._bundle->force_update();
+        } else {
+          bundle._bundle->update();
+        }
+        break;
+
+      case Bundle::S_unchanged:
+        apply_pose(bundle, NULL, now, current_thread);
+        break;
+
+      case Bundle::S_pose:
+        apply_pose(bundle, &_poses[bundle._pose_index], now, current_thread);
+        break;
+      }
+    }
+  }
+
+  _num_poses_evaluated = num_poses;
+  _poses_evaluated_pcollector.set_level(_num_poses_evaluated);
+  _poses_shared_pcollector.set_level(_num_poses_shared);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::prepare_bundle
+//       Access: Private, Static
+//  Description: Decides what should be done with the indicated
+//               bundle this frame, and sets its _state accordingly.
+//               If the bundle can be batched, this also records the
+//               channels, frame and root transform that determine
+//               its pose.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::
+prepare_bundle(Bundle &bundle, double now, Thread *current_thread) {
+  PartBundle *part_bundle = bundle._bundle;
+  PartBundle::CDReader cdata(part_bundle->_cycler, current_thread);
+
+  // This is the same test made by PartBundle::update().
+  if (!even_animation && !cdata->_anim_changed &&
+      now <= cdata->_last_update + part_bundle->_update_delay) {
+    if (part_bundle->_update_delay > 0.0) {
+      Character::_lod_throttled_pcollector.add_level(1);
+    }
+    bundle._state = Bundle::S_idle;
+    return;
+  }
+
+  // Only a single animation, without frame blending, is batched.  A
+  // bundle reduced by the character's animation LOD is left to
+  // PartBundle::update() too.
+  if (cdata->_blend.size() != 1 || cdata->_frame_blend_flag ||
+      part_bundle->_lod_frame_blend) {
+    bundle._state = Bundle::S_fallback;
+    return;
+  }
+  if (part_bundle->_lod_reduced) {
+    Character::_lod_reduced_pcollector.add_level(1);
+    bundle._state = Bundle::S_fallback;
+    return;
+  }
+  AnimControl *control = (*cdata->_blend.begin()).first;
+
+  // Each joint must be bound to the animation, and not frozen or
+  // controlled by a node.
+  int num_joints = (int)bundle._joints.size();
+  bundle._channels.resize(num_joints);
+  for (int i = 0; i < num_joints; ++i) {
+    CharacterJoint *joint = bundle._joints[i];
+    if (joint->_forced_channel != (AnimChannelBase *)NULL ||
+        joint->_effective_control != control ||
+        joint->_effective_channel == (AnimChannelBase *)NULL) {
+      bundle._state = Bundle::S_fallback;
+      return;
+    }
+    bundle._channels[i] = DCAST(ChannelType, joint->_effective_channel);
+  }
+
+  bundle._control = control;
+  bundle._frame = control->get_frame();
+  bundle._root_xform = cdata->_root_xform;
+
+  if (!even_animation && !cdata->_anim_changed &&
+      control == bundle._last_control && bundle._frame == bundle._last_frame &&
+      bundle._root_xform.compare_to(bundle._last_root_xform, 0.0f) == 0) {
+    bundle._state = Bundle::S_unchanged;
+  } else {
+    bundle._state = Bundle::S_pose;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::apply_pose
+//       Access: Private, Static
+//  Description: Copies the computed pose into the joints of the
+//               bundle, updating the nodes and vertices that depend
+//               on the joints that have changed, and updates the
+//               bundle's other parts in the normal way.  If pose is
+//               NULL, the bundle is already in the right pose, and
+//               only its bookkeeping is updated.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::
+apply_pose(Bundle &bundle, const Pose *pose, double now,
+           Thread *current_thread) {
+  PartBundle *part_bundle = bundle._bundle;
+  PartBundle::CDWriter cdata(part_bundle->_cycler, false, current_thread);
+  bool anim_changed = cdata->_anim_changed || even_animation;
+
+  if (pose != (Pose *)NULL) {
+    int num_joints = (int)bundle._joints.size();
+    for (int i = 0; i < num_joints; ++i) {
+      CharacterJoint *joint = bundle._joints[i];
+      bool self_changed = anim_changed ||
+        joint->_value.compare_to(pose->_local[i], 0.0f) != 0;
+      bool net_changed = anim_changed ||
+        joint->_net_transform.compare_to(pose->_net[i], 0.0f) != 0;
+      if (self_changed || net_changed) {
+        joint->_value = pose->_local[i];
+        joint->_net_transform = pose->_net[i];
+        joint->propagate_transforms(self_changed, net_changed, current_thread);
+      }
+    }
+
+    int num_others = (int)bundle._others.size();
+    for (int i = 0; i < num_others; ++i) {
+      bundle._others[i]->do_update(part_bundle, cdata, bundle._other_parents[i],
+                                   false, anim_changed, current_thread);
+    }
+
+    bundle._last_control = bundle._control;
+    bundle._last_frame = bundle._frame;
+    bundle._last_root_xform = bundle._root_xform;
+  }
+
+  // This is the same bookkeeping done by PartBundle::update().
+  PartBundle::ChannelBlend::const_iterator cbi;
+  for (cbi = cdata->_blend.begin(); cbi != cdata->_blend.end(); ++cbi) {
+    AnimControl *control = (*cbi).first;
+    control->mark_channels(cdata->_frame_blend_flag);
+  }
+  cdata->_anim_changed = false;
+  cdata->_last_update = now;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::evaluate_poses
+//       Access: Private, Static
+//  Description: The VertexAnimationWorkQueue function that computes
+//               the local and net transforms of each joint of the
+//               poses [begin, end).  Since the joints are stored
+//               parents first, each joint's parent has always been
+//               computed before the joint itself.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::
+evaluate_poses(void *data, int begin, int end) {
+  Pose *poses = (Pose *)data;
+  for (int pi = begin; pi < end; ++pi) {
+    Pose &pose = poses[pi];
+    const Bundle *bundle = pose._source;
+    int num_joints = (int)bundle->_joints.size();
+    pose._local.resize(num_joints);
+    pose._net.resize(num_joints);
+
+    for (int i = 0; i < num_joints; ++i) {
+      bundle->_channels[i]->get_value(pose._frame, pose._local[i]);
+      int parent = bundle->_parents[i];
+      if (parent < 0) {
+        pose._net[i] = pose._local[i] * pose._root_xform;
+      } else {
+        pose._net[i] = pose._local[i] * pose._net[parent];
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::Bundle::flatten
+//       Access: Public
+//  Description: Records the joints of the indicated bundle, in
+//               depth-first order.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::Bundle::
+flatten(PartBundle *bundle) {
+  _bundle = bundle;
+  _joints.clear();
+  _parents.clear();
+  _others.clear();
+  _other_parents.clear();
+  _channels.clear();
+
+  _state = S_idle;
+  _control = NULL;
+  _frame = 0;
+  _root_xform = LMatrix4f::ident_mat();
+  _pose_index = -1;
+
+  _last_control = NULL;
+  _last_frame = -1;
+  _last_root_xform = LMatrix4f::ident_mat();
+
+  r_flatten(bundle, -1);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterBatchEvaluator::Bundle::r_flatten
+//       Access: Public
+//  Description: The recursive implementation of flatten().
+//               parent_index is the index of the joint that is the
+//               parent of the indicated part, or -1 if the part is
+//               not a joint.
+////////////////////////////////////////////////////////////////////
+void CharacterBatchEvaluator::Bundle::
+r_flatten(PartGroup *part, int parent_index) {
+  int num_children = part->get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    PartGroup *child = part->get_child(i);
+    if (child->is_character_joint()) {
+      int index = (int)_joints.size();
+      _joints.push_back(DCAST(CharacterJoint, child));
+      _parents.push_back(parent_index);
+      r_flatten(child, index);
+
+    } else if (child->is_of_type(MovingPartBase::get_class_type())) {
+      // Sliders and the like, along with anything below them, are
+      // updated by their own do_update().
+      _others.push_back(child);
+      _other_parents.push_back(part);
+
+    } else {
+      // A joint below an ordinary group takes its transform from the
+      // root, just as in CharacterJoint::update_internals().
+      r_flatten(child, -1);
+    }
+  }
+}
@@ -0,0 +1,168 @@
+// Filename: characterBatchEvaluator.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef CHARACTERBATCHEVALUATOR_H
+#define CHARACTERBATCHEVALUATOR_H
+
+#include "pandabase.h"
+#include "character.h"
+#include "movingPartMatrix.h"
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "pStatCollector.h"
+#include "pvector.h"
+#include "pmap.h"
+
+class CharacterJoint;
+class AnimControl;
+
+////////////////////////////////////////////////////////////////////
+//       Class : CharacterBatchEvaluator
+// Description : Animates the joints of many Characters at once.
+//
+//               Normally, each Character animates itself when it is
+//               visited by the cull traversal, walking recursively
+//               down its joint hierarchy.  When there are hundreds of
+//               characters on screen, it is faster to add them all to
+//               a CharacterBatchEvaluator and call update() on it
+//               once per frame, before the scene is rendered.
+//
+//               The evaluator keeps the joints of each
+//               CharacterJointBundle in a flat array, parents before
+//               children.  Each frame, the bundles that are playing a
+//               single animation are grouped by animation, frame and
+//               root transform, and the joints of each such pose are
+//               computed just once, in one linear pass over the
+//               animation channels, and then copied to all of the
+//               bundles that share it.  If there are enough joints,
+//               the distinct poses are divided among the
+//               vertex-animation-threads.
+//
+//               Bundles that are blending several animations, or
+//               that have frozen or controlled joints, are simply
+//               updated in the normal way.  Either way, the
+//               characters will not be animated again when they are
+//               culled in the same frame.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_CHAR CharacterBatchEvaluator : public ReferenceCount {
+PUBLISHED:
+  CharacterBatchEvaluator();
+  ~CharacterBatchEvaluator();
+
+  void add_character(Character *character);
+  bool remove_character(Character *character);
+  bool has_character(Character *character) const;
+  void clear_characters();
+
+  INLINE int get_num_characters() const;
+  INLINE Character *get_character(int n) const;
+  MAKE_SEQ(get_characters, get_num_characters, get_character);
+
+  void update();
+
+  INLINE int get_num_poses_evaluated() const;
+  INLINE int get_num_poses_shared() const;
+  INLINE int get_num_bundles_fallback() const;
+
+private:
+  typedef MovingPartMatrix::ChannelType ChannelType;
+
+  // One CharacterJointBundle, with its joints flattened.
+  class Bundle {
+  public:
+    void flatten(PartBundle *bundle);
+    void r_flatten(PartGroup *part, int parent_index);
+
+    PT(PartBundle) _bundle;
+    pvector<CharacterJoint *> _joints;
+    pvector<int> _parents;
+
+    // The parts that aren't joints, usually sliders, with their
+    // parents.  These are updated in the normal way.
+    pvector<PartGroup *> _others;
+    pvector<PartGroup *> _other_parents;
+
+    // These are filled in by update().
+    enum State {
+      S_idle,       // The bundle isn't due for an update.
+      S_fallback,   // The bundle must be updated in the normal way.
+      S_unchanged,  // The bundle is already in the right pose.
+      S_pose,       // The bundle takes _poses[_pose_index].
+    };
+    State _state;
+    pvector<ChannelType *> _channels;
+    AnimControl *_control;
+    int _frame;
+    LMatrix4f _root_xform;
+    int _pose_index;
+
+    // The pose last applied to the bundle.
+    AnimControl *_last_control;
+    int _last_frame;
+    LMatrix4f _last_root_xform;
+  };
+  typedef pvector<Bundle> Bundles;
+
+  class CharacterDef {
+  public:
+    PT(Character) _character;
+    Bundles _bundles;
+  };
+  typedef pvector<CharacterDef> Characters;
+
+  // One distinct pose, computed for the first bundle that needs it
+  // and copied to the others.
+  class Pose {
+  public:
+    const Bundle *_source;
+    int _frame;
+    LMatrix4f _root_xform;
+    pvector<LMatrix4f> _local;
+    pvector<LMatrix4f> _net;
+  };
+  typedef pvector<Pose> Poses;
+
+  // Bundles share a pose if they have the same joint hierarchy,
+  // bound to the same channels, at the same frame, with the same
+  // root transform.
+  class PoseKey {
+  public:
+    INLINE PoseKey(const Bundle *bundle);
+    INLINE bool operator < (const PoseKey &other) const;
+
+    const Bundle *_bundle;
+  };
+  typedef pmap<PoseKey, int> PoseIndices;
+
+  static void prepare_bundle(Bundle &bundle, double now, Thread *current_thread);
+  static void apply_pose(Bundle &bundle, const Pose *pose, double now,
+                         Thread *current_thread);
+  static void evaluate_poses(void *data, int begin, int end);
+
+  Characters _characters;
+  Poses _poses;
+
+  int _num_poses_evaluated;
+  int _num_poses_shared;
+  int _num_bundles_fallback;
+
+  static PStatCollector _batch_pcollector;
+  static PStatCollector _poses_evaluated_pcollector;
+  static PStatCollector _poses_shared_pcollector;
+};
+
+#include "characterBatchEvaluator.I"
+
+#endif
@@ -146,6 +146,23 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
     }
   }
 
+  propagate_transforms(self_changed, net_changed, current_thread);
+  return self_changed || net_changed;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CharacterJoint::propagate_transforms
+//       Access: Private
+//  Description: Passes a new _value and/or _net_transform on to the
+//               nodes and JointVertexTransforms that follow this
+//               joint.  This is the part of update_internals() that
+//               comes after the net transform has been computed; it
+//               is also called by CharacterBatchEvaluator, which
+//               computes the transforms itself.
+////////////////////////////////////////////////////////////////////
+void CharacterJoint::
+propagate_transforms(bool self_changed, bool net_changed,
+                     Thread *current_thread) {
   if (net_changed) {
     if (!_net_transform_nodes.empty()) {
       CPT(TransformState) t = TransformState::make_mat(_net_transform);
@@ -179,8 +196,6 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
       node->set_transform(t, current_thread);
     }
   }
-
-  return self_changed || net_changed;
 }
 
 ////////////////////////////////////////////////////////////////////
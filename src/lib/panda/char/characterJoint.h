@@ -70,6 +70,8 @@ PUBLISHED:
 
 private:
   void set_character(Character *character);
+  void propagate_transforms(bool self_changed, bool net_changed,
+                            Thread *current_thread);
 
 private:
   // Not a reference-counted pointer.
@@ -125,6 +127,7 @@ private:
   static TypeHandle _type_handle;
 
   friend class Character;
+  friend class CharacterBatchEvaluator;
   friend class CharacterJointBundle;
   friend class JointVertexTransform;
 };
@@ -21,6 +21,7 @@
 #include "characterSlider.h"
 #include "characterVertexSlider.h"
 #include "jointVertexTransform.h"
+#include "pStatClient.h"
 #include "dconfig.h"
 
 Configure(config_char);
@@ -38,6 +39,14 @@ ConfigVariableBool even_animation
           "The default is to compute vertices only when they need to be "
           "computed, which can lead to an uneven frame rate."));
 
+ConfigVariableInt anim_batch_min_joints
+("anim-batch-min-joints", 2048,
+ PRC_DESC("The minimum number of joints that a CharacterBatchEvaluator "
+          "must compute in one update(), counting each distinct pose "
+          "only once, before it divides them among the "
+          "vertex-animation-threads.  Below this, the joints are "
+          "computed on the calling thread."));
+
 
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libchar
@@ -72,5 +81,10 @@ init_libchar() {
   CharacterSlider::register_with_read_factory();
   CharacterVertexSlider::register_with_read_factory();
   JointVertexTransform::register_with_read_factory();
+
+  // The GraphicsEngine flushes and clears the "Animation LOD"
+  // counters each frame through these.
+  PStatClient::add_frame_level_funcs(&Character::flush_level,
+                                     &Character::clear_level);
 }
 
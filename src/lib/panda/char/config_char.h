@@ -18,6 +18,7 @@
 #include "pandabase.h"
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
+#include "configVariableInt.h"
 
 // CPPParser can't handle token-pasting to a keyword.
 #ifndef CPPPARSER
@@ -26,6 +27,7 @@ NotifyCategoryDecl(char, EXPCL_PANDA_CHAR, EXPTP_PANDA_CHAR);
 
 // Configure variables for char package.
 extern EXPCL_PANDA_CHAR ConfigVariableBool even_animation;
+extern EXPCL_PANDA_CHAR ConfigVariableInt anim_batch_min_joints;
 
 extern EXPCL_PANDA_CHAR void init_libchar();
 
@@ -0,0 +1,865 @@
+// Filename: collisionBVH.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "collisionBVH.h"
+#include "collisionNode.h"
+#include "collisionPolygon.h"
+#include "config_collide.h"
+#include "geomNode.h"
+#include "geomTriangles.h"
+#include "geomVertexReader.h"
+#include "finiteBoundingVolume.h"
+#include "boundingLine.h"
+#include "lightMutexHolder.h"
+#include "pStatTimer.h"
+#include "bamReader.h"
+#include "bamWriter.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+
+#include <algorithm>
+
+TypeHandle CollisionBVH::_type_handle;
+
+PStatCollector CollisionBVH::_build_pcollector("App:Collisions:Build BVH");
+PStatCollector CollisionBVH::_volume_pcollector("Collision Volumes:BVH");
+
+// The maximum number of items stored in a leaf of the hierarchy.
+static const int max_leaf_items = 4;
+
+// The maximum depth of the hierarchy we can walk.  Since we always
+// split at the median, the depth is bounded by log2 of the number of
+// items, so this is plenty.
+static const int max_stack_depth = 64;
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::Constructor
+//       Access: Protected
+//  Description: Use get_bvh() to create a CollisionBVH.
+////////////////////////////////////////////////////////////////////
+CollisionBVH::
+CollisionBVH() :
+  _num_items(0),
+  _triangles(false),
+  _validated_traversal(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::Destructor
+//       Access: Published, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+CollisionBVH::
+~CollisionBVH() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::build_all
+//       Access: Published, Static
+//  Description: Walks the scene graph beginning at the indicated
+//               node, and builds a BVH for each CollisionNode and
+//               GeomNode that is large enough to benefit from one.
+//               This is normally done lazily, the first time each
+//               node is tested for collisions; calling this
+//               explicitly before the scene graph is written to a
+//               bam file ensures that the BVH's are stored in the
+//               file, so they need not be built at load time.
+//
+//               The return value is the number of nodes that have a
+//               BVH.
+////////////////////////////////////////////////////////////////////
+int CollisionBVH::
+build_all(PandaNode *root) {
+  Thread *current_thread = Thread::get_current_thread();
+  int count = 0;
+
+  pvector<PandaNode *> stack;
+  stack.push_back(root);
+  while (!stack.empty()) {
+    PandaNode *node = stack.back();
+    stack.pop_back();
+
+    if (node->is_of_type(CollisionNode::get_class_type())) {
+      if (get_bvh(DCAST(CollisionNode, node)) != (CollisionBVH *)NULL) {
+        ++count;
+      }
+
+    } else if (node->is_geom_node() &&
+               !node->get_into_collide_mask().is_zero()) {
+      if (get_bvh(DCAST(GeomNode, node), current_thread) != (CollisionBVH *)NULL) {
+        ++count;
+      }
+    }
+
+    PandaNode::Children children = node->get_children(current_thread);
+    int num_children = children.get_num_children();
+    for (int i = 0; i < num_children; ++i) {
+      stack.push_back(children.get_child(i));
+    }
+  }
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::output
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+output(ostream &out) const {
+  out << "CollisionBVH, " << _num_items
+      << (_triangles ? " triangles, " : " solids, ")
+      << _nodes.size() << " nodes";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::get_bvh
+//       Access: Public, Static
+//  Description: Returns the BVH for the solids of the indicated
+//               CollisionNode, building it first if necessary.
+//               Returns NULL if the node is too small to warrant a
+//               BVH, or if BVH's have been disabled via
+//               collide-bvh-min-items.
+////////////////////////////////////////////////////////////////////
+PT(CollisionBVH) CollisionBVH::
+get_bvh(CollisionNode *cnode) {
+  int min_items = collide_bvh_min_items;
+  if (min_items <= 0) {
+    return NULL;
+  }
+
+  int num_solids = cnode->get_num_solids();
+  {
+    LightMutexHolder holder(cnode->_bvh_lock);
+    PT(CollisionBVH) bvh = cnode->_bvh;
+    if (bvh != (CollisionBVH *)NULL && !bvh->_triangles &&
+        bvh->_num_items == num_solids) {
+      return bvh;
+    }
+  }
+
+  if (num_solids < min_items) {
+    return NULL;
+  }
+
+  // We build the BVH without holding the lock, so that other threads
+  // can continue to test against the node in the meantime.  If two
+  // threads happen to build the same BVH at once, one of them is
+  // simply discarded.
+  PT(CollisionBVH) bvh = make_from_solids(cnode);
+
+  LightMutexHolder holder(cnode->_bvh_lock);
+  cnode->_bvh = bvh;
+  return bvh;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::get_bvh
+//       Access: Public, Static
+//  Description: Returns the BVH for the triangles of the indicated
+//               GeomNode, building it first if necessary, or
+//               rebuilding it if the Geoms have changed since it was
+//               built.  Returns NULL if the node is too small to
+//               warrant a BVH, if it contains animated vertices, or
+//               if BVH's have been disabled via
+//               collide-bvh-min-items.
+//
+//               If traversal_id is nonzero, it identifies the
+//               collision traversal making the request; the Geoms are
+//               checked for changes only the first time the BVH is
+//               requested within each traversal.
+////////////////////////////////////////////////////////////////////
+PT(CollisionBVH) CollisionBVH::
+get_bvh(GeomNode *gnode, Thread *current_thread, int traversal_id) {
+  int min_items = collide_bvh_min_items;
+  if (min_items <= 0) {
+    return NULL;
+  }
+
+  PT(TypedWritableReferenceCount) accel = gnode->get_collision_accel();
+  if (accel != (TypedWritableReferenceCount *)NULL &&
+      accel->is_of_type(get_class_type())) {
+    PT(CollisionBVH) bvh = DCAST(CollisionBVH, accel);
+    if (traversal_id != 0 &&
+        AtomicAdjust::get(bvh->_validated_traversal) == traversal_id) {
+      return bvh;
+    }
+    if (bvh->is_valid_for(gnode, current_thread)) {
+      if (traversal_id != 0) {
+        AtomicAdjust::set(bvh->_validated_traversal, traversal_id);
+      }
+      return bvh;
+    }
+  }
+
+  if (count_triangles(gnode, current_thread) < min_items) {
+    if (accel != (TypedWritableReferenceCount *)NULL) {
+      gnode->set_collision_accel(NULL);
+    }
+    return NULL;
+  }
+
+  // As above, if two threads happen to build the same BVH at once,
+  // one of them is simply discarded.
+  PT(CollisionBVH) bvh = make_from_geoms(gnode, current_thread);
+  bvh->_validated_traversal = traversal_id;
+  gnode->set_collision_accel(bvh);
+  return bvh;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::find_candidates
+//       Access: Public
+//  Description: Fills result with the indices of the items whose
+//               bounding boxes intersect the indicated volume, in
+//               increasing order.  For a CollisionNode, these are
+//               indices into the node's list of solids; for a
+//               GeomNode, they may be passed to get_triangle().
+//
+//               Returns true on success, or false if the volume is
+//               of a type the BVH cannot handle, in which case every
+//               item should be tested.
+////////////////////////////////////////////////////////////////////
+bool CollisionBVH::
+find_candidates(const GeometricBoundingVolume *volume, Items &result) const {
+  result.clear();
+  if (volume->is_empty() || volume->is_infinite()) {
+    return false;
+  }
+
+  if (volume->is_of_type(FiniteBoundingVolume::get_class_type())) {
+    const FiniteBoundingVolume *fbv = DCAST(FiniteBoundingVolume, volume);
+    find_overlap_box(fbv->get_min(), fbv->get_max(), result);
+
+  } else if (volume->is_of_type(BoundingLine::get_class_type())) {
+    const BoundingLine *line = DCAST(BoundingLine, volume);
+    LPoint3f origin = line->get_point_a();
+    LVector3f direction = line->get_point_b() - origin;
+    if (direction == LVector3f::zero()) {
+      return false;
+    }
+    find_overlap_line(origin, direction, result);
+
+  } else {
+    return false;
+  }
+
+  if (!_unbounded.empty()) {
+    result.insert(result.end(), _unbounded.begin(), _unbounded.end());
+  }
+  sort(result.begin(), result.end());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::make_from_solids
+//       Access: Private, Static
+//  Description: Builds a new BVH over the solids of the indicated
+//               CollisionNode.
+////////////////////////////////////////////////////////////////////
+PT(CollisionBVH) CollisionBVH::
+make_from_solids(CollisionNode *cnode) {
+  PStatTimer timer(_build_pcollector);
+
+  PT(CollisionBVH) bvh = new CollisionBVH;
+  int num_solids = cnode->get_num_solids();
+  bvh->_num_items = num_solids;
+
+  ItemBoundsList bounds;
+  bounds.reserve(num_solids);
+  for (int s = 0; s < num_solids; ++s) {
+    CPT(CollisionSolid) solid = cnode->get_solid(s);
+    CPT(BoundingVolume) bv = solid->get_bounds();
+    if (bv->is_empty()) {
+      // An empty solid can't be collided with anyway.
+      continue;
+    }
+    if (bv->is_infinite() ||
+        !bv->is_of_type(FiniteBoundingVolume::get_class_type())) {
+      bvh->_unbounded.push_back(s);
+      continue;
+    }
+    const FiniteBoundingVolume *fbv = DCAST(FiniteBoundingVolume, bv);
+    bvh->add_item(fbv->get_min(), fbv->get_max(), s, bounds);
+  }
+
+  bvh->build(bounds);
+
+  if (collide_cat.is_debug()) {
+    collide_cat.debug()
+      << "Built " << *bvh << " for " << *cnode << "\n";
+  }
+  return bvh;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::make_from_geoms
+//       Access: Private, Static
+//  Description: Builds a new BVH over the triangles of the indicated
+//               GeomNode.  The triangles are extracted in exactly the
+//               order the CollisionTraverser would visit them.
+////////////////////////////////////////////////////////////////////
+PT(CollisionBVH) CollisionBVH::
+make_from_geoms(GeomNode *gnode, Thread *current_thread) {
+  PStatTimer timer(_build_pcollector);
+
+  PT(CollisionBVH) bvh = new CollisionBVH;
+  bvh->_triangles = true;
+
+  ItemBoundsList bounds;
+  GeomNode::Geoms geoms = gnode->get_geoms(current_thread);
+  int num_geoms = geoms.get_num_geoms();
+  bvh->_sources.reserve(num_geoms);
+  for (int s = 0; s < num_geoms; ++s) {
+    Source source;
+    source._geom = geoms.get_geom(s);
+    if (source._geom != (Geom *)NULL) {
+      source._geom_modified = source._geom->get_modified(current_thread);
+      source._data = source._geom->get_vertex_data(current_thread);
+      source._data_modified = source._data->get_modified(current_thread);
+    }
+    bvh->_sources.push_back(source);
+
+    const Geom *geom = source._geom;
+    if (geom == (Geom *)NULL ||
+        geom->get_primitive_type() != Geom::PT_polygons) {
+      continue;
+    }
+
+    CPT(GeomVertexData) data = source._data->animate_vertices(true, current_thread);
+    GeomVertexReader vertex(data, InternalName::get_vertex(), current_thread);
+
+    int num_primitives = geom->get_num_primitives();
+    for (int i = 0; i < num_primitives; ++i) {
+      CPT(GeomPrimitive) tris = geom->get_primitive(i)->decompose();
+      nassertr(tris->is_of_type(GeomTriangles::get_class_type()), NULL);
+
+      GeomVertexReader index(current_thread);
+      int num_vertices = tris->get_num_vertices();
+      if (tris->is_indexed()) {
+        index = GeomVertexReader(tris->get_vertices(), 0, current_thread);
+      } else {
+        vertex.set_row(tris->get_first_vertex());
+      }
+
+      for (int vi = 0; vi + 2 < num_vertices; vi += 3) {
+        LPoint3f v[3];
+        for (int k = 0; k < 3; ++k) {
+          if (tris->is_indexed()) {
+            vertex.set_row(index.get_data1i());
+          }
+          v[k] = vertex.get_data3f();
+        }
+
+        if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
+          int item = bvh->_vertices.size() / 3;
+          bvh->_vertices.insert(bvh->_vertices.end(), v, v + 3);
+
+          LPoint3f min_point = v[0];
+          LPoint3f max_point = v[0];
+          for (int k = 1; k < 3; ++k) {
+            min_point.set(min(min_point[0], v[k][0]),
+                          min(min_point[1], v[k][1]),
+                          min(min_point[2], v[k][2]));
+            max_point.set(max(max_point[0], v[k][0]),
+                          max(max_point[1], v[k][1]),
+                          max(max_point[2], v[k][2]));
+          }
+          bvh->add_item(min_point, max_point, item, bounds);
+        }
+      }
+    }
+  }
+
+  bvh->_num_items = bvh->_vertices.size() / 3;
+  bvh->build(bounds);
+
+  if (collide_cat.is_debug()) {
+    collide_cat.debug()
+      << "Built " << *bvh << " for " << *gnode << "\n";
+  }
+  return bvh;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::count_triangles
+//       Access: Private, Static
+//  Description: Returns the approximate number of triangles the
+//               CollisionTraverser would test in the indicated
+//               GeomNode, or -1 if any of its polygon Geoms have
+//               animated vertices, which would invalidate a BVH
+//               every frame.
+////////////////////////////////////////////////////////////////////
+int CollisionBVH::
+count_triangles(GeomNode *gnode, Thread *current_thread) {
+  int count = 0;
+  GeomNode::Geoms geoms = gnode->get_geoms(current_thread);
+  int num_geoms = geoms.get_num_geoms();
+  for (int s = 0; s < num_geoms; ++s) {
+    CPT(Geom) geom = geoms.get_geom(s);
+    if (geom == (Geom *)NULL ||
+        geom->get_primitive_type() != Geom::PT_polygons) {
+      continue;
+    }
+    CPT(GeomVertexData) data = geom->get_vertex_data(current_thread);
+    if (data->get_format()->get_animation().get_animation_type() != Geom::AT_none) {
+      return -1;
+    }
+    int num_primitives = geom->get_num_primitives();
+    for (int i = 0; i < num_primitives; ++i) {
+      count += geom->get_primitive(i)->get_num_faces();
+    }
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::is_valid_for
+//       Access: Private
+//  Description: Returns true if this BVH was built from the current
+//               contents of the indicated GeomNode, and none of its
+//               Geoms have since been modified.
+////////////////////////////////////////////////////////////////////
+bool CollisionBVH::
+is_valid_for(GeomNode *gnode, Thread *current_thread) const {
+  if (!_triangles) {
+    return false;
+  }
+  GeomNode::Geoms geoms = gnode->get_geoms(current_thread);
+  int num_geoms = geoms.get_num_geoms();
+  if (num_geoms != (int)_sources.size()) {
+    return false;
+  }
+  for (int s = 0; s < num_geoms; ++s) {
+    const Source &source = _sources[s];
+    CPT(Geom) geom = geoms.get_geom(s);
+    if (geom != source._geom) {
+      return false;
+    }
+    if (geom != (Geom *)NULL) {
+      if (geom->get_modified(current_thread) != source._geom_modified) {
+        return false;
+      }
+      CPT(GeomVertexData) data = geom->get_vertex_data(current_thread);
+      if (data != source._data ||
+          data->get_modified(current_thread) != source._data_modified) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::add_item
+//       Access: Private
+//  Description: Records the bounding box of the indicated item in
+//               preparation for build().  The box is padded a little,
+//               so that roundoff error can never cause the BVH to
+//               reject an item the traverser's own bounding volume
+//               test would have accepted.
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+add_item(const LPoint3f &min_point, const LPoint3f &max_point, int item,
+         ItemBoundsList &bounds) {
+  float scale = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    scale = max(scale, max(cabs(min_point[i]), cabs(max_point[i])));
+  }
+  float pad = scale * 1.0e-5f + 1.0e-6f;
+  LVector3f pad_vec(pad, pad, pad);
+
+  ItemBounds ib;
+  ib._min = min_point - pad_vec;
+  ib._max = max_point + pad_vec;
+  ib._center = (min_point + max_point) * 0.5f;
+  ib._item = item;
+  bounds.push_back(ib);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::build
+//       Access: Private
+//  Description: Builds the hierarchy from the item bounds collected
+//               by add_item().
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+build(ItemBoundsList &bounds) {
+  _nodes.clear();
+  _items.clear();
+  if (bounds.empty()) {
+    return;
+  }
+
+  _items.reserve(bounds.size());
+  _nodes.reserve((bounds.size() * 2) / max_leaf_items + 1);
+  r_build(bounds, 0, bounds.size());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::r_build
+//       Access: Private
+//  Description: The recursive implementation of build().  Creates a
+//               node for the items in the range [begin, end), and
+//               returns its index.
+////////////////////////////////////////////////////////////////////
+int CollisionBVH::
+r_build(ItemBoundsList &bounds, int begin, int end) {
+  int index = _nodes.size();
+  _nodes.push_back(Node());
+
+  LPoint3f min_point = bounds[begin]._min;
+  LPoint3f max_point = bounds[begin]._max;
+  LPoint3f min_center = bounds[begin]._center;
+  LPoint3f max_center = bounds[begin]._center;
+  for (int i = begin + 1; i < end; ++i) {
+    const ItemBounds &ib = bounds[i];
+    for (int k = 0; k < 3; ++k) {
+      min_point[k] = min(min_point[k], ib._min[k]);
+      max_point[k] = max(max_point[k], ib._max[k]);
+      min_center[k] = min(min_center[k], ib._center[k]);
+      max_center[k] = max(max_center[k], ib._center[k]);
+    }
+  }
+  _nodes[index]._min = min_point;
+  _nodes[index]._max = max_point;
+
+  if (end - begin <= max_leaf_items) {
+    // Make a leaf.
+    _nodes[index]._first = _items.size();
+    _nodes[index]._count = end - begin;
+    for (int i = begin; i < end; ++i) {
+      _items.push_back(bounds[i]._item);
+    }
+    return index;
+  }
+
+  // Split at the median along the axis in which the item centers are
+  // most widely spread.
+  LVector3f extent = max_center - min_center;
+  int axis = 0;
+  if (extent[1] > extent[axis]) {
+    axis = 1;
+  }
+  if (extent[2] > extent[axis]) {
+    axis = 2;
+  }
+
+  int mid = (begin + end) / 2;
+  nth_element(bounds.begin() + begin, bounds.begin() + mid,
+              bounds.begin() + end, CompareCenter(axis));
+
+  r_build(bounds, begin, mid);
+  int second = r_build(bounds, mid, end);
+  _nodes[index]._first = second;
+  _nodes[index]._count = 0;
+  return index;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::find_overlap_box
+//       Access: Private
+//  Description: Appends to result all items whose boxes overlap the
+//               indicated box.
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+find_overlap_box(const LPoint3f &min_point, const LPoint3f &max_point,
+                 Items &result) const {
+  if (_nodes.empty()) {
+    return;
+  }
+
+  int num_visited = 0;
+  int stack[max_stack_depth];
+  int sp = 0;
+  stack[sp++] = 0;
+  while (sp > 0) {
+    int index = stack[--sp];
+    const Node &node = _nodes[index];
+    ++num_visited;
+
+    if (node._min[0] > max_point[0] || node._max[0] < min_point[0] ||
+        node._min[1] > max_point[1] || node._max[1] < min_point[1] ||
+        node._min[2] > max_point[2] || node._max[2] < min_point[2]) {
+      continue;
+    }
+
+    if (node._count != 0) {
+      result.insert(result.end(), _items.begin() + node._first,
+                    _items.begin() + node._first + node._count);
+    } else {
+      nassertv(sp + 2 <= max_stack_depth);
+      stack[sp++] = node._first;
+      stack[sp++] = index + 1;
+    }
+  }
+
+  _volume_pcollector.add_level(num_visited);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::find_overlap_line
+//       Access: Private
+//  Description: Appends to result all items whose boxes are crossed
+//               by the indicated infinite line.
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+find_overlap_line(const LPoint3f &origin, const LVector3f &direction,
+                  Items &result) const {
+  if (_nodes.empty()) {
+    return;
+  }
+
+  int num_visited = 0;
+  int stack[max_stack_depth];
+  int sp = 0;
+  stack[sp++] = 0;
+  while (sp > 0) {
+    int index = stack[--sp];
+    const Node &node = _nodes[index];
+    ++num_visited;
+
+    if (!line_hits_box(origin, direction, node._min, node._max)) {
+      continue;
+    }
+
+    if (node._count != 0) {
+      result.insert(result.end(), _items.begin() + node._first,
+                    _items.begin() + node._first + node._count);
+    } else {
+      nassertv(sp + 2 <= max_stack_depth);
+      stack[sp++] = node._first;
+      stack[sp++] = index + 1;
+    }
+  }
+
+  _volume_pcollector.add_level(num_visited);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::register_with_read_factory
+//       Access: Public, Static
+//  Description: Tells the BamReader how to create objects of type
+//               CollisionBVH.
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::write_datagram
+//       Access: Public, Virtual
+//  Description: Writes the contents of this object to the datagram
+//               for shipping out to a Bam file.
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+write_datagram(BamWriter *manager, Datagram &dg) {
+  TypedWritable::write_datagram(manager, dg);
+
+  // If the Geoms have been modified since the BVH was built, it is
+  // stale; write it out empty, with no sources, so that it will be
+  // rebuilt when the file is loaded.
+  bool stale = false;
+  if (_triangles) {
+    Thread *current_thread = Thread::get_current_thread();
+    Sources::const_iterator si;
+    for (si = _sources.begin(); si != _sources.end() && !stale; ++si) {
+      const Geom *geom = (*si)._geom;
+      if (geom != (Geom *)NULL &&
+          (geom->get_modified(current_thread) != (*si)._geom_modified ||
+           geom->get_vertex_data(current_thread) != (*si)._data ||
+           (*si)._data->get_modified(current_thread) != (*si)._data_modified)) {
+        stale = true;
+      }
+    }
+  }
+
+  dg.add_bool(_triangles);
+  if (stale) {
+    dg.add_int32(0);
+    dg.add_uint32(0);
+    dg.add_uint32(0);
+    dg.add_uint32(0);
+    dg.add_uint32(0);
+    dg.add_uint16(0);
+    return;
+  }
+
+  dg.add_int32(_num_items);
+
+  dg.add_uint32(_nodes.size());
+  Nodes::const_iterator ni;
+  for (ni = _nodes.begin(); ni != _nodes.end(); ++ni) {
+    (*ni)._min.write_datagram(dg);
+    (*ni)._max.write_datagram(dg);
+    dg.add_int32((*ni)._first);
+    dg.add_int32((*ni)._count);
+  }
+
+  dg.add_uint32(_items.size());
+  Items::const_iterator ii;
+  for (ii = _items.begin(); ii != _items.end(); ++ii) {
+    dg.add_int32(*ii);
+  }
+
+  dg.add_uint32(_unbounded.size());
+  for (ii = _unbounded.begin(); ii != _unbounded.end(); ++ii) {
+    dg.add_int32(*ii);
+  }
+
+  dg.add_uint32(_vertices.size());
+  Vertices::const_iterator vi;
+  for (vi = _vertices.begin(); vi != _vertices.end(); ++vi) {
+    (*vi).write_datagram(dg);
+  }
+
+  nassertv(_sources.size() == (size_t)(PN_uint16)_sources.size());
+  dg.add_uint16(_sources.size());
+  Sources::const_iterator si;
+  for (si = _sources.begin(); si != _sources.end(); ++si) {
+    manager->write_pointer(dg, (*si)._geom);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::complete_pointers
+//       Access: Public, Virtual
+//  Description: Receives an array of pointers, one for each time
+//               manager->read_pointer() was called in fillin().
+//               Returns the number of pointers processed.
+////////////////////////////////////////////////////////////////////
+int CollisionBVH::
+complete_pointers(TypedWritable **p_list, BamReader *manager) {
+  int pi = TypedWritable::complete_pointers(p_list, manager);
+
+  Sources::iterator si;
+  for (si = _sources.begin(); si != _sources.end(); ++si) {
+    (*si)._geom = DCAST(Geom, p_list[pi++]);
+  }
+
+  return pi;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::finalize
+//       Access: Public, Virtual
+//  Description: Called by the BamReader to perform any final actions
+//               needed for setting up the object after all objects
+//               have been read and all pointers have been completed.
+//
+//               Here we record the modification stamps of the Geoms
+//               we were built from, as they stand after loading, so
+//               that we can tell later whether they have changed.
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+finalize(BamReader *manager) {
+  Thread *current_thread = Thread::get_current_thread();
+  Sources::iterator si;
+  for (si = _sources.begin(); si != _sources.end(); ++si) {
+    Source &source = (*si);
+    if (source._geom != (Geom *)NULL) {
+      // Make sure the Geom has finished loading first, since
+      // finalizing it may modify it.
+      manager->finalize_now((Geom *)source._geom.p());
+      source._geom_modified = source._geom->get_modified(current_thread);
+      source._data = source._geom->get_vertex_data(current_thread);
+      source._data_modified = source._data->get_modified(current_thread);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::make_from_bam
+//       Access: Protected, Static
+//  Description: This function is called by the BamReader's factory
+//               when a new object of type CollisionBVH is encountered
+//               in the Bam file.  It should create the CollisionBVH
+//               and extract its information from the file.
+////////////////////////////////////////////////////////////////////
+TypedWritable *CollisionBVH::
+make_from_bam(const FactoryParams &params) {
+  CollisionBVH *bvh = new CollisionBVH;
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  bvh->fillin(scan, manager);
+
+  if (!bvh->_sources.empty()) {
+    manager->register_finalize(bvh);
+  }
+
+  return bvh;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionBVH::fillin
+//       Access: Protected
+//  Description: This internal function is called by make_from_bam to
+//               read in all of the relevant data from the BamFile for
+//               the new CollisionBVH.
+////////////////////////////////////////////////////////////////////
+void CollisionBVH::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  TypedWritable::fillin(scan, manager);
+
+  _triangles = scan.get_bool();
+  _num_items = scan.get_int32();
+
+  int num_nodes = scan.get_uint32();
+  _nodes.clear();
+  _nodes.reserve(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    Node node;
+    node._min.read_datagram(scan);
+    node._max.read_datagram(scan);
+    node._first = scan.get_int32();
+    node._count = scan.get_int32();
+    _nodes.push_back(node);
+  }
+
+  int num_items = scan.get_uint32();
+  _items.clear();
+  _items.reserve(num_items);
+  for (int i = 0; i < num_items; ++i) {
+    _items.push_back(scan.get_int32());
+  }
+
+  int num_unbounded = scan.get_uint32();
+  _unbounded.clear();
+  _unbounded.reserve(num_unbounded);
+  for (int i = 0; i < num_unbounded; ++i) {
+    _unbounded.push_back(scan.get_int32());
+  }
+
+  int num_vertices = scan.get_uint32();
+  _vertices.clear();
+  _vertices.reserve(num_vertices);
+  for (int i = 0; i < num_vertices; ++i) {
+    LPoint3f v;
+    v.read_datagram(scan);
+    _vertices.push_back(v);
+  }
+
+  int num_sources = scan.get_uint16();
+  _sources.clear();
+  _sources.reserve(num_sources);
+  for (int i = 0; i < num_sources; ++i) {
+    manager->read_pointer(scan);
+    _sources.push_back(Source());
+  }
+}
@@ -0,0 +1,213 @@
+// Filename: collisionBVH.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef COLLISIONBVH_H
+#define COLLISIONBVH_H
+
+#include "pandabase.h"
+
+#include "typedWritableReferenceCount.h"
+#include "geom.h"
+#include "geomVertexData.h"
+#include "updateSeq.h"
+#include "luse.h"
+#include "atomicAdjust.h"
+#include "pvector.h"
+#include "pointerTo.h"
+#include "pStatCollector.h"
+
+class CollisionNode;
+class GeomNode;
+class PandaNode;
+class GeometricBoundingVolume;
+
+////////////////////////////////////////////////////////////////////
+//       Class : CollisionBVH
+// Description : A bounding-volume hierarchy over the contents of a
+//               single CollisionNode or GeomNode, used by the
+//               CollisionTraverser to quickly find the handful of
+//               solids or triangles that might intersect a collider,
+//               instead of testing each one in turn.
+//
+//               A BVH is built automatically, the first time a node
+//               is tested, for any node that contains at least
+//               collide-bvh-min-items solids or triangles.  For a
+//               CollisionNode, it is discarded whenever the node's
+//               list of solids is changed through the node
+//               interface; note that modifying a solid in-place,
+//               without going through CollisionNode::modify_solid(),
+//               will not be detected.  For a GeomNode, it records
+//               the modification stamps of the Geoms it was built
+//               from, and is rebuilt whenever they change.
+//
+//               The BVH is written to bam files along with its node,
+//               so that it need not be rebuilt when the model is
+//               loaded again; see build_all().
+//
+//               The hierarchy is a binary tree of axis-aligned boxes,
+//               built top-down by splitting each set of items at the
+//               median along its longest axis.  Queries return the
+//               candidate items in their original order, so that
+//               collisions are detected in exactly the same order
+//               as without the BVH.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_COLLIDE CollisionBVH : public TypedWritableReferenceCount {
+protected:
+  CollisionBVH();
+
+PUBLISHED:
+  virtual ~CollisionBVH();
+
+  static int build_all(PandaNode *root);
+
+  INLINE int get_num_items() const;
+  INLINE int get_num_bounded_items() const;
+  INLINE int get_num_nodes() const;
+  INLINE bool is_triangle_bvh() const;
+
+  void output(ostream &out) const;
+
+public:
+  static PT(CollisionBVH) get_bvh(CollisionNode *cnode);
+  static PT(CollisionBVH) get_bvh(GeomNode *gnode, Thread *current_thread,
+                                  int traversal_id = 0);
+
+  typedef pvector<int> Items;
+  bool find_candidates(const GeometricBoundingVolume *volume,
+                       Items &result) const;
+
+  INLINE const LPoint3f *get_triangle(int item) const;
+
+private:
+  class ItemBounds {
+  public:
+    LPoint3f _min;
+    LPoint3f _max;
+    LPoint3f _center;
+    int _item;
+  };
+  typedef pvector<ItemBounds> ItemBoundsList;
+
+  class CompareCenter {
+  public:
+    INLINE CompareCenter(int axis);
+    INLINE bool operator () (const ItemBounds &a, const ItemBounds &b) const;
+    int _axis;
+  };
+
+  static PT(CollisionBVH) make_from_solids(CollisionNode *cnode);
+  static PT(CollisionBVH) make_from_geoms(GeomNode *gnode,
+                                          Thread *current_thread);
+  static int count_triangles(GeomNode *gnode, Thread *current_thread);
+  bool is_valid_for(GeomNode *gnode, Thread *current_thread) const;
+
+  void add_item(const LPoint3f &min_point, const LPoint3f &max_point,
+                int item, ItemBoundsList &bounds);
+  void build(ItemBoundsList &bounds);
+  int r_build(ItemBoundsList &bounds, int begin, int end);
+
+  void find_overlap_box(const LPoint3f &min_point, const LPoint3f &max_point,
+                        Items &result) const;
+  void find_overlap_line(const LPoint3f &origin, const LVector3f &direction,
+                         Items &result) const;
+  INLINE static bool line_hits_box(const LPoint3f &origin,
+                                   const LVector3f &direction,
+                                   const LPoint3f &min_point,
+                                   const LPoint3f &max_point);
+
+private:
+  // Each node of the hierarchy is either an interior node, with
+  // _count == 0, whose first child immediately follows it in the
+  // array and whose second child is at index _first; or a leaf,
+  // whose items are _items[_first] through _items[_first + _count -
+  // 1].
+  class Node {
+  public:
+    LPoint3f _min;
+    LPoint3f _max;
+    int _first;
+    int _count;
+  };
+  typedef pvector<Node> Nodes;
+  Nodes _nodes;
+
+  Items _items;
+
+  // These items have infinite or otherwise unusable bounding
+  // volumes, and are returned by every query.
+  Items _unbounded;
+
+  // The total number of items: solids for a CollisionNode, or
+  // triangles for a GeomNode.
+  int _num_items;
+
+  // For a GeomNode, the three vertices of each triangle, in the node's
+  // coordinate space.
+  typedef pvector<LPoint3f> Vertices;
+  Vertices _vertices;
+
+  // Also for a GeomNode, the Geoms and vertex datas the triangles came
+  // from, with the modification stamps they had at the time.
+  class Source {
+  public:
+    CPT(Geom) _geom;
+    CPT(GeomVertexData) _data;
+    UpdateSeq _geom_modified;
+    UpdateSeq _data_modified;
+  };
+  typedef pvector<Source> Sources;
+  Sources _sources;
+  bool _triangles;
+
+  // The most recent collision traversal in which the BVH was found to
+  // be valid for its GeomNode, so that the Geoms need not be checked
+  // again for the rest of that traversal.
+  mutable AtomicAdjust::Integer _validated_traversal;
+
+  static PStatCollector _build_pcollector;
+  static PStatCollector _volume_pcollector;
+
+public:
+  static void register_with_read_factory();
+  virtual void write_datagram(BamWriter *manager, Datagram &dg);
+  virtual int complete_pointers(TypedWritable **plist, BamReader *manager);
+  virtual void finalize(BamReader *manager);
+
+protected:
+  static TypedWritable *make_from_bam(const FactoryParams &params);
+  void fillin(DatagramIterator &scan, BamReader *manager);
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    TypedWritableReferenceCount::init_type();
+    register_type(_type_handle, "CollisionBVH",
+                  TypedWritableReferenceCount::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+INLINE ostream &operator << (ostream &out, const CollisionBVH &bvh);
+
+#include "collisionBVH.I"
+
+#endif
@@ -33,6 +33,7 @@
 
 class CollisionSolid;
 class CollisionNode;
+class CollisionHandler;
 
 ////////////////////////////////////////////////////////////////////
 //       Class : CollisionLevelStateBase
@@ -51,6 +52,7 @@ public:
     CPT(CollisionSolid) _collider;
     CollisionNode *_node;
     NodePath _node_path;
+    CollisionHandler *_handler;
   };
 
   INLINE CollisionLevelStateBase(const NodePath &node_path);
@@ -71,6 +73,7 @@ public:
   INLINE const CollisionSolid *get_collider(int n) const;
   INLINE CollisionNode *get_collider_node(int n) const;
   INLINE NodePath get_collider_node_path(int n) const;
+  INLINE CollisionHandler *get_collider_handler(int n) const;
   INLINE const GeometricBoundingVolume *get_local_bound(int n) const;
   INLINE const GeometricBoundingVolume *get_parent_bound(int n) const;
 
@@ -43,7 +43,8 @@ CollisionNode::
 CollisionNode(const string &name) :
   PandaNode(name),
   _from_collide_mask(get_default_collide_mask()),
-  _collider_sort(0)
+  _collider_sort(0),
+  _bvh_lock("CollisionNode::_bvh_lock")
 {
   set_cull_callback();
 
@@ -63,7 +64,9 @@ CollisionNode::
 CollisionNode(const CollisionNode &copy) :
   PandaNode(copy),
   _from_collide_mask(copy._from_collide_mask),
-  _solids(copy._solids)
+  _solids(copy._solids),
+  _bvh(copy._bvh),
+  _bvh_lock("CollisionNode::_bvh_lock")
 {
 }
 
@@ -121,6 +124,7 @@ xform(const LMatrix4f &mat) {
     PT(CollisionSolid) solid = (*si).get_write_pointer();
     solid->xform(mat);
   }
+  _bvh.clear();
   mark_internal_bounds_stale();
 }
 
@@ -154,6 +158,7 @@ combine_with(PandaNode *other) {
         const COWPT(CollisionSolid) *solids_begin = &cother->_solids[0];
         const COWPT(CollisionSolid) *solids_end = solids_begin + cother->_solids.size();
         _solids.insert(_solids.end(), solids_begin, solids_end);
+        _bvh.clear();
         mark_internal_bounds_stale();
         return this;
       }
@@ -412,6 +417,10 @@ write_datagram(BamWriter *manager, Datagram &dg) {
   }
 
   dg.add_uint32(_from_collide_mask.get_word());
+
+  // Make sure a large node carries its BVH with it, so it need not be
+  // rebuilt when the file is loaded.
+  manager->write_pointer(dg, CollisionBVH::get_bvh(this));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -430,6 +439,10 @@ complete_pointers(TypedWritable **p_list, BamReader *manager) {
     _solids[i] = DCAST(CollisionSolid, p_list[pi++]);
   }
 
+  if (manager->get_file_minor_ver() >= 20) {
+    _bvh = DCAST(CollisionBVH, p_list[pi++]);
+  }
+
   return pi;
 }
 
@@ -478,4 +491,8 @@ fillin(DatagramIterator &scan, BamReader *manager) {
   }
 
   _from_collide_mask.set_word(scan.get_uint32());
+
+  if (manager->get_file_minor_ver() >= 20) {
+    manager->read_pointer(scan);
+  }
 }
@@ -18,9 +18,11 @@
 #include "pandabase.h"
 
 #include "collisionSolid.h"
+#include "collisionBVH.h"
 
 #include "collideMask.h"
 #include "pandaNode.h"
+#include "lightMutex.h"
 
 ////////////////////////////////////////////////////////////////////
 //       Class : CollisionNode
@@ -88,6 +90,13 @@ private:
 
   typedef pvector< COWPT(CollisionSolid) > Solids;
   Solids _solids;
+
+  // The bounding-volume hierarchy over _solids, if one has been
+  // built.  This is managed by CollisionBVH, and must be cleared
+  // whenever _solids changes.  The lock protects its lazy creation
+  // by the threads that test the node.
+  PT(CollisionBVH) _bvh;
+  LightMutex _bvh_lock;
   
 public:
   static void register_with_read_factory();
@@ -114,6 +123,8 @@ public:
 
 private:
   static TypeHandle _type_handle;
+
+  friend class CollisionBVH;
 };
 
 #include "collisionNode.I"
@@ -0,0 +1,255 @@
+// Filename: collisionResultQueue.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "collisionResultQueue.h"
+#include "mutexHolder.h"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::BufferedHandler::Constructor
+//       Access: Public
+//  Description: Creates a handler that will record the entries for
+//               the ordinalth collider, which would have been
+//               traversed in the indicated pass by a single-threaded
+//               traversal, into the indicated Chunk.
+////////////////////////////////////////////////////////////////////
+CollisionResultQueue::BufferedHandler::
+BufferedHandler(Chunk *chunk, CollisionHandler *handler,
+                int pass, int ordinal) :
+  _chunk(chunk),
+  _handler(handler),
+  _pass(pass),
+  _ordinal(ordinal)
+{
+  // The CollisionEntry asks the handler it is given whether it wants
+  // to hear about the near misses too; we must answer on behalf of
+  // the real handler.
+  _wants_all_potential_collidees = handler->wants_all_potential_collidees();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::BufferedHandler::add_entry
+//       Access: Public, Virtual
+//  Description: Records the entry, to be passed to the real handler
+//               later by CollisionResultQueue::deliver().  This is
+//               called only by the worker thread that owns the
+//               Chunk.
+////////////////////////////////////////////////////////////////////
+void CollisionResultQueue::BufferedHandler::
+add_entry(CollisionEntry *entry) {
+  _chunk->_results.push_back(Result());
+  Result &result = _chunk->_results.back();
+  result._entry = entry;
+  result._handler = _handler;
+  result._pass = _pass;
+  result._ordinal = _ordinal;
+  _chunk->make_node_key(entry->get_into_node_path(), result._node_key);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::Chunk::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+CollisionResultQueue::Chunk::
+Chunk(const NodePath &root) :
+  _root(root)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::Chunk::make_node_key
+//       Access: Public
+//  Description: Fills key with the list of child indices that lead
+//               from the traversal root to the indicated node.
+//
+//               Since a traversal tends to report several entries
+//               against the same node in a row, the most recent key
+//               is remembered and reused.
+////////////////////////////////////////////////////////////////////
+void CollisionResultQueue::Chunk::
+make_node_key(const NodePath &into_node_path, NodeKey &key) {
+  if (into_node_path != _last_into_node_path) {
+    Thread *current_thread = Thread::get_current_thread();
+    _last_node_key.clear();
+    NodePath node_path = into_node_path;
+    while (node_path != _root && node_path.has_parent(current_thread)) {
+      NodePath parent = node_path.get_parent(current_thread);
+      _last_node_key.push_back
+        (parent.node()->find_child(node_path.node(), current_thread));
+      node_path = parent;
+    }
+    reverse(_last_node_key.begin(), _last_node_key.end());
+    _last_into_node_path = into_node_path;
+  }
+
+  key = _last_node_key;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+CollisionResultQueue::
+CollisionResultQueue(const NodePath &root) :
+  _root(root),
+  _lock("CollisionResultQueue::_lock"),
+  _cvar(_lock),
+  _next_chunk(0),
+  _num_working(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::Destructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+CollisionResultQueue::
+~CollisionResultQueue() {
+  Chunks::iterator ci;
+  for (ci = _chunks.begin(); ci != _chunks.end(); ++ci) {
+    delete (*ci);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::add_chunk
+//       Access: Public
+//  Description: Begins a new, empty chunk of colliders.  Chunks must
+//               be added, and filled, in the order of their
+//               colliders.
+////////////////////////////////////////////////////////////////////
+CollisionResultQueue::Chunk *CollisionResultQueue::
+add_chunk() {
+  Chunk *chunk = new Chunk(_root);
+  _chunks.push_back(chunk);
+  return chunk;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::add_collider
+//       Access: Public
+//  Description: Adds the indicated collider to the chunk.  Its
+//               handler is replaced with a BufferedHandler that
+//               records the entries detected for it.
+////////////////////////////////////////////////////////////////////
+void CollisionResultQueue::
+add_collider(Chunk *chunk, CollisionLevelStateBase::ColliderDef def,
+             int pass, int ordinal) {
+  nassertv(def._handler != (CollisionHandler *)NULL);
+  PT(BufferedHandler) handler =
+    new BufferedHandler(chunk, def._handler, pass, ordinal);
+  chunk->_handlers.push_back(handler);
+
+  def._handler = handler;
+  chunk->_defs.push_back(def);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::claim_next
+//       Access: Public
+//  Description: Returns the next chunk that has not yet been claimed
+//               by any worker, or NULL if all of them have been
+//               claimed.
+////////////////////////////////////////////////////////////////////
+CollisionResultQueue::Chunk *CollisionResultQueue::
+claim_next() {
+  MutexHolder holder(_lock);
+  if (_next_chunk >= (int)_chunks.size()) {
+    return NULL;
+  }
+  return _chunks[_next_chunk++];
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::start_tasks
+//       Access: Public
+//  Description: Indicates the number of worker tasks that are about
+//               to be started on this queue.  wait_for_tasks() will
+//               not return until each of them has called
+//               task_done().
+////////////////////////////////////////////////////////////////////
+void CollisionResultQueue::
+start_tasks(int num_tasks) {
+  MutexHolder holder(_lock);
+  _num_working += num_tasks;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::task_done
+//       Access: Public
+//  Description: Called by each worker task when it has run out of
+//               chunks to traverse.
+////////////////////////////////////////////////////////////////////
+void CollisionResultQueue::
+task_done() {
+  MutexHolder holder(_lock);
+  nassertv(_num_working > 0);
+  --_num_working;
+  if (_num_working == 0) {
+    _cvar.notify();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::wait_for_tasks
+//       Access: Public
+//  Description: Blocks until all of the worker tasks started on this
+//               queue have finished.
+////////////////////////////////////////////////////////////////////
+void CollisionResultQueue::
+wait_for_tasks() {
+  MutexHolder holder(_lock);
+  while (_num_working > 0) {
+    _cvar.wait();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionResultQueue::deliver
+//       Access: Public
+//  Description: Passes all of the entries recorded by all of the
+//               chunks to their real handlers, in the order in which
+//               a single-threaded traversal would have detected
+//               them.  This must be called on the thread that called
+//               traverse(), after wait_for_tasks().
+////////////////////////////////////////////////////////////////////
+void CollisionResultQueue::
+deliver() {
+  // The chunks are already in collider order, and each chunk's
+  // results are in the order its traversal found them, so a stable
+  // sort preserves the order of several entries for the same collider
+  // and node.
+  typedef pvector<const Result *> Sorted;
+  Sorted sorted;
+
+  Chunks::const_iterator ci;
+  for (ci = _chunks.begin(); ci != _chunks.end(); ++ci) {
+    const Results &results = (*ci)->_results;
+    Results::const_iterator ri;
+    for (ri = results.begin(); ri != results.end(); ++ri) {
+      sorted.push_back(&(*ri));
+    }
+  }
+
+  stable_sort(sorted.begin(), sorted.end(), CompareResults());
+
+  Sorted::const_iterator si;
+  for (si = sorted.begin(); si != sorted.end(); ++si) {
+    (*si)->_handler->add_entry((*si)->_entry);
+  }
+}
@@ -0,0 +1,134 @@
+// Filename: collisionResultQueue.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef COLLISIONRESULTQUEUE_H
+#define COLLISIONRESULTQUEUE_H
+
+#include "pandabase.h"
+
+#include "collisionHandler.h"
+#include "collisionEntry.h"
+#include "collisionLevelStateBase.h"
+#include "nodePath.h"
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "pmutex.h"
+#include "conditionVar.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : CollisionResultQueue
+// Description : This divides the colliders of a parallel collision
+//               traversal (see collide-num-threads) into Chunks,
+//               each of which is traversed independently by one of
+//               the CollisionWorkerTasks, and collects the resulting
+//               CollisionEntries.
+//
+//               The entries are not passed to the real handlers as
+//               they are detected.  Instead, each one is tagged with
+//               its position in the order a single-threaded traversal
+//               would have detected it: the pass its collider would
+//               have been assigned to, the position of the into node
+//               in the scene graph, and the collider's own position
+//               in the list of colliders.  Once all of the workers
+//               have finished, deliver() sorts the entries by these
+//               keys and passes them along to the handlers, so that
+//               the handlers see exactly the same sequence of calls
+//               they would have seen from a single-threaded traversal.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_COLLIDE CollisionResultQueue : public ReferenceCount {
+public:
+  typedef pvector<int> NodeKey;
+
+  class Result {
+  public:
+    PT(CollisionEntry) _entry;
+    CollisionHandler *_handler;
+    int _pass;
+    int _ordinal;
+    NodeKey _node_key;
+  };
+  typedef pvector<Result> Results;
+
+  class Chunk;
+
+  // This stands in for the real CollisionHandler of each collider
+  // during the traversal, and records the entries it receives in its
+  // Chunk.
+  class BufferedHandler : public CollisionHandler {
+  public:
+    BufferedHandler(Chunk *chunk, CollisionHandler *handler,
+                    int pass, int ordinal);
+
+    virtual void add_entry(CollisionEntry *entry);
+
+  private:
+    Chunk *_chunk;
+    CollisionHandler *_handler;
+    int _pass;
+    int _ordinal;
+  };
+
+  class Chunk {
+  public:
+    Chunk(const NodePath &root);
+
+    void make_node_key(const NodePath &into_node_path, NodeKey &key);
+
+    typedef pvector<CollisionLevelStateBase::ColliderDef> ColliderDefs;
+    ColliderDefs _defs;
+    pvector< PT(BufferedHandler) > _handlers;
+    Results _results;
+
+  private:
+    NodePath _root;
+    NodePath _last_into_node_path;
+    NodeKey _last_node_key;
+  };
+
+  CollisionResultQueue(const NodePath &root);
+  ~CollisionResultQueue();
+
+  Chunk *add_chunk();
+  void add_collider(Chunk *chunk, CollisionLevelStateBase::ColliderDef def,
+                    int pass, int ordinal);
+  INLINE int get_num_chunks() const;
+
+  Chunk *claim_next();
+  void start_tasks(int num_tasks);
+  void task_done();
+  void wait_for_tasks();
+
+  void deliver();
+
+private:
+  class CompareResults {
+  public:
+    INLINE bool operator () (const Result *a, const Result *b) const;
+  };
+
+  NodePath _root;
+
+  typedef pvector<Chunk *> Chunks;
+  Chunks _chunks;
+
+  Mutex _lock;
+  ConditionVar _cvar;
+  int _next_chunk;
+  int _num_working;
+};
+
+#include "collisionResultQueue.I"
+
+#endif
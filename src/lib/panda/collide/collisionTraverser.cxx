@@ -14,11 +14,14 @@
 
 #include "collisionTraverser.h"
 #include "collisionNode.h"
+#include "collisionBVH.h"
 #include "collisionEntry.h"
 #include "collisionPolygon.h"
 #include "collisionGeom.h"
 #include "collisionRecorder.h"
 #include "collisionVisualizer.h"
+#include "collisionResultQueue.h"
+#include "collisionWorkerTask.h"
 #include "collisionSphere.h"
 #include "collisionBox.h"
 #include "collisionTube.h"
@@ -47,6 +50,8 @@ PStatCollector CollisionTraverser::_geom_volume_pcollector("Collision Volumes:Ge
 
 TypeHandle CollisionTraverser::_type_handle;
 
+AtomicAdjust::Integer CollisionTraverser::_next_traversal_id = 1;
+
 // This function object class is used in prepare_colliders(), below.
 class SortByColliderSort {
 public:
@@ -75,6 +80,7 @@ CollisionTraverser(const string &name) :
   _this_pcollector(_collisions_pcollector, name)
 {
   _respect_prev_transform = respect_prev_transform;
+  _traversal_id = 0;
   #ifdef DO_COLLISION_RECORDING
   _recorder = (CollisionRecorder *)NULL;
   #endif
@@ -277,6 +283,13 @@ void CollisionTraverser::
 traverse(const NodePath &root) {
   PStatTimer timer(_this_pcollector);
 
+  AtomicAdjust::Integer id;
+  do {
+    id = AtomicAdjust::get(_next_traversal_id);
+  } while (AtomicAdjust::compare_and_exchange
+           (_next_traversal_id, id, id + 1) != id);
+  _traversal_id = (int)id;
+
   #ifdef DO_COLLISION_RECORDING
   if (has_recorder()) {
     get_recorder()->begin_traversal();
@@ -292,8 +305,21 @@ traverse(const NodePath &root) {
   }
 
   bool traversal_done = false;
-  if ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
-      !allow_collider_multiple) {
+  bool recording = false;
+  #ifdef DO_COLLISION_RECORDING
+  recording = has_recorder();
+  #endif  // DO_COLLISION_RECORDING
+
+  if (!_colliders.empty() && !recording &&
+      CollisionWorkerTask::is_parallel_collide_available()) {
+    // Divide the colliders among the worker threads.
+    parallel_traverse(root);
+    traversal_done = true;
+  }
+
+  if (!traversal_done &&
+      ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
+       !allow_collider_multiple)) {
     // Use the single-word-at-a-time traverser, which might need to make
     // lots of passes.
     LevelStatesSingle level_states;
@@ -511,6 +537,118 @@ write(ostream &out, int indent_level) const {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionTraverser::parallel_traverse
+//       Access: Private
+//  Description: Performs the traversal on the worker threads of the
+//               CollisionWorkerTask (see collide-num-threads).  The
+//               colliders are divided into small chunks, and each
+//               chunk is traversed through the whole scene graph
+//               independently by one of the workers.
+//
+//               The collisions found by the workers are then passed
+//               to the handlers on this thread, sorted back into the
+//               order in which the single-threaded traversal would
+//               have found them: that traversal makes one pass over
+//               the scene graph per group of colliders, and within a
+//               pass tests each node, in depth-first order, against
+//               each collider in the group in turn.  The handlers
+//               therefore cannot tell the difference.
+////////////////////////////////////////////////////////////////////
+void CollisionTraverser::
+parallel_traverse(const NodePath &root) {
+  int num_colliders = _colliders.size();
+
+  // Walk through the colliders in sorted order, exactly as
+  // prepare_colliders_single() does.
+  int *indirect = (int *)alloca(sizeof(int) * num_colliders);
+  int i;
+  for (i = 0; i < num_colliders; ++i) {
+    indirect[i] = i;
+  }
+  sort(indirect, indirect + num_colliders, SortByColliderSort(*this));
+
+  typedef pvector<CollisionLevelStateBase::ColliderDef> ColliderDefs;
+  ColliderDefs defs;
+  defs.reserve(num_colliders);
+
+  for (i = 0; i < num_colliders; ++i) {
+    OrderedColliderDef &ocd = _ordered_colliders[indirect[i]];
+    NodePath cnode_path = ocd._node_path;
+
+    if (!cnode_path.is_same_graph(root)) {
+      if (ocd._in_graph) {
+        // Only report this warning once.
+        collide_cat.info()
+          << "Collider " << cnode_path
+          << " is not in scene graph.  Ignoring.\n";
+        ocd._in_graph = false;
+      }
+
+    } else {
+      ocd._in_graph = true;
+      CollisionNode *cnode = DCAST(CollisionNode, cnode_path.node());
+
+      CollisionLevelStateBase::ColliderDef def;
+      def._node = cnode;
+      def._node_path = cnode_path;
+      def._handler = get_handler(cnode_path);
+
+      int num_solids = cnode->get_num_solids();
+      for (int s = 0; s < num_solids; ++s) {
+        def._collider = cnode->get_solid(s);
+        defs.push_back(def);
+      }
+    }
+  }
+
+  int num_defs = defs.size();
+  if (num_defs == 0) {
+    return;
+  }
+
+  // Work out how many colliders the single-threaded traversal would
+  // have tested in each pass; this mirrors the choice of level state
+  // made in traverse().
+  int single_max = CollisionLevelStateSingle::get_max_colliders();
+  int double_max = CollisionLevelStateDouble::get_max_colliders();
+  int pass_size;
+  if (!allow_collider_multiple) {
+    pass_size = single_max;
+  } else if (num_colliders <= double_max && num_defs <= double_max) {
+    pass_size = num_defs;
+  } else {
+    pass_size = CollisionLevelStateQuad::get_max_colliders();
+  }
+
+  // Make at least two chunks per thread, so that the work is evenly
+  // balanced, but no more colliders per chunk than will fit in a
+  // single-word level state.
+  int num_threads = collide_num_threads;
+  int chunk_size = (num_defs + num_threads * 2 - 1) / (num_threads * 2);
+  chunk_size = max(min(chunk_size, single_max), 1);
+
+  PT(CollisionResultQueue) queue = new CollisionResultQueue(root);
+  CollisionResultQueue::Chunk *chunk = NULL;
+  for (int d = 0; d < num_defs; ++d) {
+    if (d % chunk_size == 0) {
+      chunk = queue->add_chunk();
+    }
+    queue->add_collider(chunk, defs[d], d / pass_size, d);
+  }
+
+  int num_tasks = min(num_threads, queue->get_num_chunks());
+  AsyncTaskManager *task_manager = CollisionWorkerTask::get_task_manager();
+  queue->start_tasks(num_tasks);
+  for (i = 0; i < num_tasks; ++i) {
+    PT(AsyncTask) task = new CollisionWorkerTask(this, queue, root, i);
+    task_manager->add(task);
+  }
+  queue->wait_for_tasks();
+
+  queue->deliver();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CollisionTraverser::prepare_colliders_single
 //       Access: Private
@@ -565,6 +703,7 @@ prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
       CollisionLevelStateSingle::ColliderDef def;
       def._node = cnode;
       def._node_path = cnode_path;
+      def._handler = get_handler(cnode_path);
       
       int num_solids = cnode->get_num_solids();
       for (int s = 0; s < num_solids; ++s) {
@@ -635,7 +774,7 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry, 
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               node_gbv);
@@ -680,7 +819,7 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry, 
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               node_gbv);
@@ -782,6 +921,7 @@ prepare_colliders_double(CollisionTraverser::LevelStatesDouble &level_states,
       CollisionLevelStateDouble::ColliderDef def;
       def._node = cnode;
       def._node_path = cnode_path;
+      def._handler = get_handler(cnode_path);
       
       int num_solids = cnode->get_num_solids();
       for (int s = 0; s < num_solids; ++s) {
@@ -852,7 +992,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry, 
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               node_gbv);
@@ -897,7 +1037,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry, 
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               node_gbv);
@@ -999,6 +1139,7 @@ prepare_colliders_quad(CollisionTraverser::LevelStatesQuad &level_states,
       CollisionLevelStateQuad::ColliderDef def;
       def._node = cnode;
       def._node_path = cnode_path;
+      def._handler = get_handler(cnode_path);
       
       int num_solids = cnode->get_num_solids();
       for (int s = 0; s < num_solids; ++s) {
@@ -1069,7 +1210,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_node(
-              entry, 
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               node_gbv);
@@ -1114,7 +1255,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
           entry._from = level_state.get_collider(c);
 
           compare_collider_to_geom_node(
-              entry, 
+              entry, level_state.get_collider_handler(c),
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
               node_gbv);
@@ -1168,7 +1309,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
 //  Description:
 ////////////////////////////////////////////////////////////////////
 void CollisionTraverser::
-compare_collider_to_node(CollisionEntry &entry,
+compare_collider_to_node(CollisionEntry &entry, CollisionHandler *handler,
                          const GeometricBoundingVolume *from_parent_gbv,
                          const GeometricBoundingVolume *from_node_gbv,
                          const GeometricBoundingVolume *into_node_gbv) {
@@ -1186,24 +1327,27 @@ compare_collider_to_node(CollisionEntry &entry,
     collide_cat.spam()
       << "Colliding against CollisionNode " << entry._into_node
       << " which has " << num_solids << " collision solids.\n";
-    for (int s = 0; s < num_solids; ++s) {
-      entry._into = cnode->get_solid(s);
-      if (entry._from != entry._into) {
-        CPT(BoundingVolume) solid_bv = entry._into->get_bounds();
-        const GeometricBoundingVolume *solid_gbv = NULL;
-        if (num_solids > 1 &&
-            solid_bv->is_of_type(GeometricBoundingVolume::get_class_type())) {
-          // Only bother to test against each solid's bounding
-          // volume if we have more than one solid in the node, as a
-          // slight optimization.  (If the node contains just one
-          // solid, then the node's bounding volume, which we just
-          // tested, is the same as the solid's bounding volume.)
-          DCAST_INTO_V(solid_gbv, solid_bv);
-        }
 
-        compare_collider_to_solid(entry, from_node_gbv, solid_gbv);
+    if (from_node_gbv != (GeometricBoundingVolume *)NULL && num_solids > 1) {
+      // If the node is big enough to have a BVH, use it to find just
+      // the solids that are near the collider.
+      PT(CollisionBVH) bvh = CollisionBVH::get_bvh(cnode);
+      if (bvh != (CollisionBVH *)NULL) {
+        CollisionBVH::Items candidates;
+        if (bvh->find_candidates(from_node_gbv, candidates)) {
+          CollisionBVH::Items::const_iterator ci;
+          for (ci = candidates.begin(); ci != candidates.end(); ++ci) {
+            compare_collider_to_node_solid(entry, handler, cnode, (*ci),
+                                           from_node_gbv);
+          }
+          return;
+        }
       }
     }
+
+    for (int s = 0; s < num_solids; ++s) {
+      compare_collider_to_node_solid(entry, handler, cnode, s, from_node_gbv);
+    }
   }
 }
 
@@ -1214,6 +1358,7 @@ compare_collider_to_node(CollisionEntry &entry,
 ////////////////////////////////////////////////////////////////////
 void CollisionTraverser::
 compare_collider_to_geom_node(CollisionEntry &entry,
+                              CollisionHandler *handler,
                               const GeometricBoundingVolume *from_parent_gbv,
                               const GeometricBoundingVolume *from_node_gbv,
                               const GeometricBoundingVolume *into_node_gbv) {
@@ -1227,6 +1372,28 @@ compare_collider_to_geom_node(CollisionEntry &entry,
   if (within_node_bounds) {
     GeomNode *gnode;
     DCAST_INTO_V(gnode, entry._into_node);
+
+    if (from_node_gbv != (GeometricBoundingVolume *)NULL) {
+      // If the node has enough triangles to have a BVH, use it to
+      // find just the triangles that are near the collider.  The
+      // candidates are returned in the same order we would visit them
+      // below.
+      Thread *current_thread = Thread::get_current_thread();
+      PT(CollisionBVH) bvh =
+        CollisionBVH::get_bvh(gnode, current_thread, _traversal_id);
+      if (bvh != (CollisionBVH *)NULL) {
+        CollisionBVH::Items candidates;
+        if (bvh->find_candidates(from_node_gbv, candidates)) {
+          CollisionBVH::Items::const_iterator ii;
+          for (ii = candidates.begin(); ii != candidates.end(); ++ii) {
+            compare_collider_to_triangle(entry, handler,
+                                         bvh->get_triangle(*ii), from_node_gbv);
+          }
+          return;
+        }
+      }
+    }
+
     int num_geoms = gnode->get_num_geoms();
     for (int s = 0; s < num_geoms; ++s) {
       entry._into = (CollisionSolid *)NULL;
@@ -1244,19 +1411,48 @@ compare_collider_to_geom_node(CollisionEntry &entry,
           DCAST_INTO_V(geom_gbv, geom_bv);
         }
 
-        compare_collider_to_geom(entry, geom, from_node_gbv, geom_gbv);
+        compare_collider_to_geom(entry, handler, geom, from_node_gbv, geom_gbv);
       }
     }
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionTraverser::compare_collider_to_node_solid
+//       Access: Private
+//  Description: Tests the collider against the sth solid of the
+//               indicated CollisionNode.
+////////////////////////////////////////////////////////////////////
+void CollisionTraverser::
+compare_collider_to_node_solid(CollisionEntry &entry,
+                               CollisionHandler *handler,
+                               CollisionNode *cnode, int s,
+                               const GeometricBoundingVolume *from_node_gbv) {
+  entry._into = cnode->get_solid(s);
+  if (entry._from != entry._into) {
+    CPT(BoundingVolume) solid_bv = entry._into->get_bounds();
+    const GeometricBoundingVolume *solid_gbv = NULL;
+    if (cnode->get_num_solids() > 1 &&
+        solid_bv->is_of_type(GeometricBoundingVolume::get_class_type())) {
+      // Only bother to test against each solid's bounding
+      // volume if we have more than one solid in the node, as a
+      // slight optimization.  (If the node contains just one
+      // solid, then the node's bounding volume, which we just
+      // tested, is the same as the solid's bounding volume.)
+      DCAST_INTO_V(solid_gbv, solid_bv);
+    }
+
+    compare_collider_to_solid(entry, handler, from_node_gbv, solid_gbv);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CollisionTraverser::compare_collider_to_solid
 //       Access: Private
 //  Description:
 ////////////////////////////////////////////////////////////////////
 void CollisionTraverser::
-compare_collider_to_solid(CollisionEntry &entry,
+compare_collider_to_solid(CollisionEntry &entry, CollisionHandler *handler,
                           const GeometricBoundingVolume *from_node_gbv,
                           const GeometricBoundingVolume *solid_gbv) {
   bool within_solid_bounds = true;
@@ -1276,10 +1472,7 @@ compare_collider_to_solid(CollisionEntry &entry,
 #endif  // NDEBUG
   }
   if (within_solid_bounds) {
-    Colliders::const_iterator ci;
-    ci = _colliders.find(entry.get_from_node_path());
-    nassertv(ci != _colliders.end());
-    entry.test_intersection((*ci).second, this);
+    entry.test_intersection(handler, this);
   }
 }
 
@@ -1289,7 +1482,8 @@ compare_collider_to_solid(CollisionEntry &entry,
 //  Description:
 ////////////////////////////////////////////////////////////////////
 void CollisionTraverser::
-compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
+compare_collider_to_geom(CollisionEntry &entry, CollisionHandler *handler,
+                         const Geom *geom,
                          const GeometricBoundingVolume *from_node_gbv,
                          const GeometricBoundingVolume *geom_gbv) {
   bool within_geom_bounds = true;
@@ -1299,10 +1493,6 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
     _geom_volume_pcollector.add_level(1);
   }
   if (within_geom_bounds) {
-    Colliders::const_iterator ci;
-    ci = _colliders.find(entry.get_from_node_path());
-    nassertv(ci != _colliders.end());
-
     if (geom->get_primitive_type() == Geom::PT_polygons) {
       Thread *current_thread = Thread::get_current_thread();
       CPT(GeomVertexData) data = geom->get_vertex_data()->animate_vertices(true, current_thread);
@@ -1330,20 +1520,8 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
             // Generate a temporary CollisionGeom on the fly for each
             // triangle in the Geom.
             if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
-              bool within_solid_bounds = true;
-              if (from_node_gbv != (GeometricBoundingVolume *)NULL) {
-                PT(BoundingSphere) sphere = new BoundingSphere;
-                sphere->around(v, v + 3);
-                within_solid_bounds = (sphere->contains(from_node_gbv) != 0);
-#ifdef DO_PSTATS
-                CollisionGeom::_volume_pcollector.add_level(1);
-#endif  // DO_PSTATS
-              }
-              if (within_solid_bounds) {
-                PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
-                entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
-              }
+              compare_collider_to_triangle(entry, handler, v,
+                                           from_node_gbv);
             }
           }
         } else {
@@ -1360,20 +1538,8 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
             // Generate a temporary CollisionGeom on the fly for each
             // triangle in the Geom.
             if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
-              bool within_solid_bounds = true;
-              if (from_node_gbv != (GeometricBoundingVolume *)NULL) {
-                PT(BoundingSphere) sphere = new BoundingSphere;
-                sphere->around(v, v + 3);
-                within_solid_bounds = (sphere->contains(from_node_gbv) != 0);
-#ifdef DO_PSTATS
-                CollisionGeom::_volume_pcollector.add_level(1);
-#endif  // DO_PSTATS
-              }
-              if (within_solid_bounds) {
-                PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
-                entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
-              }
+              compare_collider_to_triangle(entry, handler, v,
+                                           from_node_gbv);
             }
           }
         }
@@ -1382,6 +1548,33 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionTraverser::compare_collider_to_triangle
+//       Access: Private
+//  Description: Tests the collider against a single triangle of a
+//               GeomNode, by generating a temporary CollisionGeom on
+//               the fly.  The triangle has already been validated.
+////////////////////////////////////////////////////////////////////
+void CollisionTraverser::
+compare_collider_to_triangle(CollisionEntry &entry, CollisionHandler *handler,
+                             const LPoint3f v[3],
+                             const GeometricBoundingVolume *from_node_gbv) {
+  bool within_solid_bounds = true;
+  if (from_node_gbv != (GeometricBoundingVolume *)NULL) {
+    PT(BoundingSphere) sphere = new BoundingSphere;
+    sphere->around(v, v + 3);
+    within_solid_bounds = (sphere->contains(from_node_gbv) != 0);
+#ifdef DO_PSTATS
+    CollisionGeom::_volume_pcollector.add_level(1);
+#endif  // DO_PSTATS
+  }
+  if (within_solid_bounds) {
+    PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
+    entry._into = cgeom;
+    entry.test_intersection(handler, this);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CollisionTraverser::remove_handler
 //       Access: Private
@@ -22,6 +22,7 @@
 
 #include "pointerTo.h"
 #include "pStatCollector.h"
+#include "atomicAdjust.h"
 
 #include "pset.h"
 #include "register_type.h"
@@ -79,6 +80,8 @@ PUBLISHED:
   void write(ostream &out, int indent_level) const;
 
 private:
+  void parallel_traverse(const NodePath &root);
+
   typedef pvector<CollisionLevelStateSingle> LevelStatesSingle;
   void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root);
   void r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass);
@@ -92,19 +95,31 @@ private:
   void r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass);
 
   void compare_collider_to_node(CollisionEntry &entry,
+                                CollisionHandler *handler,
                                 const GeometricBoundingVolume *from_parent_gbv,
                                 const GeometricBoundingVolume *from_node_gbv,
                                 const GeometricBoundingVolume *into_node_gbv);
   void compare_collider_to_geom_node(CollisionEntry &entry,
+                                     CollisionHandler *handler,
                                      const GeometricBoundingVolume *from_parent_gbv,
                                      const GeometricBoundingVolume *from_node_gbv,
                                      const GeometricBoundingVolume *into_node_gbv);
+  void compare_collider_to_node_solid(CollisionEntry &entry,
+                                      CollisionHandler *handler,
+                                      CollisionNode *cnode, int s,
+                                      const GeometricBoundingVolume *from_node_gbv);
   void compare_collider_to_solid(CollisionEntry &entry,
+                                 CollisionHandler *handler,
                                  const GeometricBoundingVolume *from_node_gbv,
                                  const GeometricBoundingVolume *solid_gbv);
-  void compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
+  void compare_collider_to_geom(CollisionEntry &entry,
+                                CollisionHandler *handler, const Geom *geom,
                                 const GeometricBoundingVolume *from_node_gbv,
                                 const GeometricBoundingVolume *solid_gbv);
+  void compare_collider_to_triangle(CollisionEntry &entry,
+                                    CollisionHandler *handler,
+                                    const LPoint3f v[3],
+                                    const GeometricBoundingVolume *from_node_gbv);
 
   PStatCollector &get_pass_collector(int pass);
 
@@ -129,6 +144,13 @@ private:
   Handlers::iterator remove_handler(Handlers::iterator hi);
 
   bool _respect_prev_transform;
+
+  // Identifies the traversal in progress to CollisionBVH::get_bvh().
+  // Each call to traverse() takes a new number from
+  // _next_traversal_id, which is shared by all traversers.
+  int _traversal_id;
+  static AtomicAdjust::Integer _next_traversal_id;
+
 #ifdef DO_COLLISION_RECORDING
   CollisionRecorder *_recorder;
   NodePath _collision_visualizer_np;
@@ -160,6 +182,7 @@ private:
   static TypeHandle _type_handle;
 
   friend class SortByColliderSort;
+  friend class CollisionWorkerTask;
 };
 
 INLINE ostream &operator << (ostream &out, const CollisionTraverser &trav) {
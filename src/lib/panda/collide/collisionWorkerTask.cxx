@@ -0,0 +1,139 @@
+// Filename: collisionWorkerTask.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "collisionWorkerTask.h"
+#include "collisionTraverser.h"
+#include "collisionLevelState.h"
+#include "config_collide.h"
+#include "asyncTaskChain.h"
+#include "mutexHolder.h"
+#include "pStatTimer.h"
+#include "string_utils.h"
+
+PT(AsyncTaskManager) CollisionWorkerTask::_task_manager;
+Mutex CollisionWorkerTask::_task_manager_lock("CollisionWorkerTask::_task_manager_lock");
+
+PStatCollector CollisionWorkerTask::_workers_pcollector("App:Collisions:Workers");
+
+TypeHandle CollisionWorkerTask::_type_handle;
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionWorkerTask::Constructor
+//       Access: Public
+//  Description: Creates a new worker task that will traverse the
+//               scene graph at the indicated root for each chunk of
+//               colliders in the queue.  The traverser must remain
+//               valid until the task has finished; it is used only
+//               for its traversal settings.  The index is used only
+//               to identify the task's PStats collector.
+////////////////////////////////////////////////////////////////////
+CollisionWorkerTask::
+CollisionWorkerTask(CollisionTraverser *trav, CollisionResultQueue *queue,
+                    const NodePath &root, int index) :
+  AsyncTask("collide:" + format_string(index)),
+  _trav(trav),
+  _queue(queue),
+  _root(root),
+  _pcollector(_workers_pcollector, "Worker " + format_string(index))
+{
+  set_task_chain(get_task_chain_name());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionWorkerTask::is_parallel_collide_available
+//       Access: Public, Static
+//  Description: Returns true if the parallel collision traversal has
+//               been requested via collide-num-threads, and
+//               threading support is available to implement it.
+////////////////////////////////////////////////////////////////////
+bool CollisionWorkerTask::
+is_parallel_collide_available() {
+  return collide_num_threads > 0 && Thread::is_threading_supported();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionWorkerTask::get_task_manager
+//       Access: Public, Static
+//  Description: Returns the AsyncTaskManager that services the
+//               parallel collision tasks.  This is a private task
+//               manager, separate from the global task manager, so
+//               that a traversal started from within a task on the
+//               global manager cannot wait on its own thread.
+////////////////////////////////////////////////////////////////////
+AsyncTaskManager *CollisionWorkerTask::
+get_task_manager() {
+  // The pointer is read under the lock too; it may be assigned by
+  // another thread at any time until it has been created.
+  MutexHolder holder(_task_manager_lock);
+  if (_task_manager == (AsyncTaskManager *)NULL) {
+    make_task_manager();
+  }
+  return _task_manager;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionWorkerTask::get_task_chain_name
+//       Access: Public, Static
+//  Description: Returns the name of the task chain on which the
+//               worker tasks are run.
+////////////////////////////////////////////////////////////////////
+const string &CollisionWorkerTask::
+get_task_chain_name() {
+  static string name = "collide";
+  return name;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionWorkerTask::do_task
+//       Access: Protected, Virtual
+//  Description: Traverses chunks from the queue until there are no
+//               more left to claim.
+////////////////////////////////////////////////////////////////////
+AsyncTask::DoneStatus CollisionWorkerTask::
+do_task() {
+  Thread *current_thread = Thread::get_current_thread();
+  PStatTimer timer(_pcollector, current_thread);
+
+  CollisionResultQueue::Chunk *chunk = _queue->claim_next();
+  while (chunk != (CollisionResultQueue::Chunk *)NULL) {
+    CollisionLevelStateSingle level_state(_root);
+    level_state.reserve(chunk->_defs.size());
+
+    CollisionResultQueue::Chunk::ColliderDefs::const_iterator di;
+    for (di = chunk->_defs.begin(); di != chunk->_defs.end(); ++di) {
+      level_state.prepare_collider(*di, _root);
+    }
+    _trav->r_traverse_single(level_state, 0);
+
+    chunk = _queue->claim_next();
+  }
+
+  _queue->task_done();
+  return DS_done;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CollisionWorkerTask::make_task_manager
+//       Access: Private, Static
+//  Description: Creates the task manager and its worker threads the
+//               first time it is needed.  The lock should be held.
+////////////////////////////////////////////////////////////////////
+void CollisionWorkerTask::
+make_task_manager() {
+  PT(AsyncTaskManager) task_manager = new AsyncTaskManager("collide");
+  AsyncTaskChain *chain = task_manager->make_task_chain(get_task_chain_name());
+  chain->set_num_threads(collide_num_threads);
+  chain->set_thread_priority(TP_high);
+  _task_manager = task_manager;
+}
@@ -0,0 +1,84 @@
+// Filename: collisionWorkerTask.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef COLLISIONWORKERTASK_H
+#define COLLISIONWORKERTASK_H
+
+#include "pandabase.h"
+
+#include "asyncTask.h"
+#include "asyncTaskManager.h"
+#include "collisionResultQueue.h"
+#include "nodePath.h"
+#include "pStatCollector.h"
+#include "pointerTo.h"
+#include "pmutex.h"
+
+class CollisionTraverser;
+
+////////////////////////////////////////////////////////////////////
+//       Class : CollisionWorkerTask
+// Description : This task is used internally by the
+//               CollisionTraverser to implement the parallel
+//               collision traversal (see collide-num-threads).  Each
+//               task repeatedly pulls the next unclaimed chunk of
+//               colliders from a shared CollisionResultQueue and
+//               traverses the scene graph with just those colliders,
+//               recording the detected collisions in the chunk.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_COLLIDE CollisionWorkerTask : public AsyncTask {
+public:
+  CollisionWorkerTask(CollisionTraverser *trav, CollisionResultQueue *queue,
+                      const NodePath &root, int index);
+  ALLOC_DELETED_CHAIN(CollisionWorkerTask);
+
+  static bool is_parallel_collide_available();
+  static AsyncTaskManager *get_task_manager();
+  static const string &get_task_chain_name();
+
+protected:
+  virtual DoneStatus do_task();
+
+private:
+  static void make_task_manager();
+
+  CollisionTraverser *_trav;
+  PT(CollisionResultQueue) _queue;
+  NodePath _root;
+  PStatCollector _pcollector;
+
+  static PT(AsyncTaskManager) _task_manager;
+  static Mutex _task_manager_lock;
+
+  static PStatCollector _workers_pcollector;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AsyncTask::init_type();
+    register_type(_type_handle, "CollisionWorkerTask",
+                  AsyncTask::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#endif
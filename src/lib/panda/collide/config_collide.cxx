@@ -40,7 +40,9 @@
 #include "collisionTraverser.h"
 #include "collisionTube.h"
 #include "collisionBox.h"
+#include "collisionBVH.h"
 #include "collisionVisualizer.h"
+#include "collisionWorkerTask.h"
 #include "dconfig.h"
 
 Configure(config_collide);
@@ -102,6 +104,28 @@ ConfigVariableInt fluid_cap_amount
 ("fluid-cap-amount", 100,
  PRC_DESC("ensures that fluid pos doesn't check beyond X feet"));
 
+ConfigVariableInt collide_bvh_min_items
+("collide-bvh-min-items", 64,
+ PRC_DESC("The CollisionTraverser builds a bounding-volume hierarchy for "
+          "any CollisionNode with at least this many solids, or any "
+          "GeomNode with at least this many triangles, the first time "
+          "it is tested for collisions, so that only the solids or "
+          "triangles near a collider need be tested individually.  The "
+          "hierarchy is also written to bam files with the node.  Set "
+          "this to 0 to disable the use of these hierarchies altogether."));
+
+ConfigVariableInt collide_num_threads
+("collide-num-threads", 0,
+ PRC_DESC("The number of worker threads that should be used by each "
+          "CollisionTraverser::traverse() call.  When this is 0 (the "
+          "default), the traversal is performed entirely on the calling "
+          "thread, as usual.  When it is greater than 0, the colliders "
+          "are divided among this many threads, each of which traverses "
+          "the scene graph independently.  The detected collisions are "
+          "still passed to the handlers on the calling thread, in exactly "
+          "the same order as a single-threaded traversal.  This is "
+          "disabled while a CollisionRecorder is attached."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libcollide
 //  Description: Initializes the library.  This must be called at
@@ -144,6 +168,8 @@ init_libcollide() {
   CollisionTraverser::init_type();
   CollisionTube::init_type();
   CollisionBox::init_type();
+  CollisionBVH::init_type();
+  CollisionWorkerTask::init_type();
 
 #ifdef DO_COLLISION_RECORDING
   CollisionRecorder::init_type();
@@ -163,4 +189,5 @@ init_libcollide() {
   CollisionSphere::register_with_read_factory();
   CollisionTube::register_with_read_factory();
   CollisionBox::register_with_read_factory();
+  CollisionBVH::register_with_read_factory();
 }
@@ -19,6 +19,7 @@
 #include "cullBinFrontToBack.h"
 #include "cullBinStateSorted.h"
 #include "cullBinUnsorted.h"
+#include "softwareOcclusionCullTraverser.h"
 
 #include "cullBinManager.h"
 #include "dconfig.h"
@@ -26,6 +27,37 @@
 ConfigureDef(config_cull);
 NotifyCategoryDef(cull, "");
 
+ConfigVariableInt software_occlusion_size
+("software-occlusion-size", "256 128",
+ PRC_DESC("Specify the x y size of the depth buffer into which the "
+          "SoftwareOcclusionCullTraverser draws its occluders.  The x "
+          "size is rounded up to a multiple of 4.  It need not match the "
+          "size of the window; a small buffer is faster to fill and to "
+          "test against, at the cost of culling less."));
+
+ConfigVariableInt software_occlusion_min_vertices
+("software-occlusion-min-vertices", 1,
+ PRC_DESC("The minimum number of vertices a node and its descendents must "
+          "contain in order for the SoftwareOcclusionCullTraverser to "
+          "test it against the occluders.  Smaller nodes are left to the "
+          "view-frustum test alone."));
+
+ConfigVariableDouble software_occlusion_depth_bias
+("software-occlusion-depth-bias", 1e-5,
+ PRC_DESC("The amount, in normalized device coordinates, by which the "
+          "nearest point of a node's bounding volume must lie behind the "
+          "occluders before the SoftwareOcclusionCullTraverser considers "
+          "it hidden.  This keeps an occluder from hiding itself through "
+          "roundoff error."));
+
+ConfigVariableBool software_occlusion_simd
+("software-occlusion-simd", true,
+ PRC_DESC("Configure this false to disable the SSE2 implementation of "
+          "the SoftwareOcclusionCullTraverser's rasterizer, which is "
+          "used when the CPU supports it.  It fills four pixels at a "
+          "time, and produces exactly the same depth buffer as the "
+          "scalar implementation."));
+
 ConfigureFn(config_cull) {
   init_libcull();
 }
@@ -51,6 +83,7 @@ init_libcull() {
   CullBinFrontToBack::init_type();
   CullBinStateSorted::init_type();
   CullBinUnsorted::init_type();
+  SoftwareOcclusionCullTraverser::init_type();
 
   CullBinManager *bin_manager = CullBinManager::get_global_ptr();
   bin_manager->register_bin_type(CullBinManager::BT_unsorted,
@@ -27,6 +27,11 @@ class DSearchPath;
 ConfigureDecl(config_cull, EXPCL_PANDA_CULL, EXPTP_PANDA_CULL);
 NotifyCategoryDecl(cull, EXPCL_PANDA_CULL, EXPTP_PANDA_CULL);
 
+extern ConfigVariableInt software_occlusion_size;
+extern ConfigVariableInt software_occlusion_min_vertices;
+extern ConfigVariableDouble software_occlusion_depth_bias;
+extern ConfigVariableBool software_occlusion_simd;
+
 extern EXPCL_PANDA_CULL void init_libcull();
 
 #endif
@@ -0,0 +1,524 @@
+// Filename: occlusionDepthBuffer.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "occlusionDepthBuffer.h"
+#include "config_cull.h"
+#include "geom.h"
+#include "geomPrimitive.h"
+#include "geomVertexData.h"
+#include "geomVertexReader.h"
+#include "internalName.h"
+#include "lsimd.h"
+#include "thread.h"
+#include "cmath.h"
+
+// A triangle ready to be filled: the coefficients of its three edge
+// functions and of its depth plane, each of the form a * x + b * y +
+// c in pixel coordinates.  A pixel is filled if all three edge
+// functions are non-negative at its center.
+struct TriangleSetup {
+  float _ea[3];
+  float _eb[3];
+  float _ec[3];
+  float _za;
+  float _zb;
+  float _zc;
+};
+
+// fill_row() draws the pixels from x_begin up to (but not including)
+// x_end of the row whose centers lie at fy, keeping the nearer of the
+// triangle's depth and the depth already there.
+static void
+fill_row(float *row, int x_begin, int x_end, float fy,
+         const TriangleSetup &t) {
+  float e0 = t._eb[0] * fy + t._ec[0];
+  float e1 = t._eb[1] * fy + t._ec[1];
+  float e2 = t._eb[2] * fy + t._ec[2];
+  float zrow = t._zb * fy + t._zc;
+
+  for (int x = x_begin; x < x_end; ++x) {
+    float fx = (float)x + 0.5f;
+    if (t._ea[0] * fx + e0 >= 0.0f &&
+        t._ea[1] * fx + e1 >= 0.0f &&
+        t._ea[2] * fx + e2 >= 0.0f) {
+      float z = t._za * fx + zrow;
+      if (z < row[x]) {
+        row[x] = z;
+      }
+    }
+  }
+}
+
+// reduce_row() computes one row of a pyramid level from the two rows
+// of the level beneath it, each texel taking the farthest of the (up
+// to) four texels it covers.
+static void
+reduce_row(float *dest, int x_begin, int dest_x_size,
+           const float *src0, const float *src1, int src_x_size) {
+  for (int x = x_begin; x < dest_x_size; ++x) {
+    int s0 = x * 2;
+    int s1 = min(s0 + 1, src_x_size - 1);
+    dest[x] = max(max(src0[s0], src0[s1]), max(src1[s0], src1[s1]));
+  }
+}
+
+// fill_row_4() and reduce_row_4() are the same, but do four pixels at
+// a time with SSE2, where it is available.  fill_row_4() works on
+// whole groups of four pixels, which is why the buffer's width is a
+// multiple of four; it masks off the pixels outside the span, so it
+// writes exactly what fill_row() would.
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define OCCLUSION_SSE2 __attribute__((target("sse2")))
+#include <emmintrin.h>
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef OCCLUSION_SSE2
+static OCCLUSION_SSE2 void
+fill_row_4(float *row, int x_begin, int x_end, float fy,
+           const TriangleSetup &t) {
+  __m128 e0 = _mm_set1_ps(t._eb[0] * fy + t._ec[0]);
+  __m128 e1 = _mm_set1_ps(t._eb[1] * fy + t._ec[1]);
+  __m128 e2 = _mm_set1_ps(t._eb[2] * fy + t._ec[2]);
+  __m128 zrow = _mm_set1_ps(t._zb * fy + t._zc);
+  __m128 a0 = _mm_set1_ps(t._ea[0]);
+  __m128 a1 = _mm_set1_ps(t._ea[1]);
+  __m128 a2 = _mm_set1_ps(t._ea[2]);
+  __m128 za = _mm_set1_ps(t._za);
+  __m128 zero = _mm_setzero_ps();
+
+  __m128i first = _mm_set1_epi32(x_begin - 1);
+  __m128i last = _mm_set1_epi32(x_end);
+
+  for (int x = x_begin & ~3; x < x_end; x += 4) {
+    __m128i xi = _mm_setr_epi32(x, x + 1, x + 2, x + 3);
+    __m128 fx = _mm_add_ps(_mm_cvtepi32_ps(xi), _mm_set1_ps(0.5f));
+
+    __m128 in = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(xi, first),
+                                               _mm_cmplt_epi32(xi, last)));
+    in = _mm_and_ps(in, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, fx), e0), zero));
+    in = _mm_and_ps(in, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, fx), e1), zero));
+    in = _mm_and_ps(in, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, fx), e2), zero));
+
+    __m128 z = _mm_add_ps(_mm_mul_ps(za, fx), zrow);
+    __m128 old = _mm_loadu_ps(row + x);
+    in = _mm_and_ps(in, _mm_cmplt_ps(z, old));
+    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(in, z), _mm_andnot_ps(in, old)));
+  }
+}
+
+static OCCLUSION_SSE2 void
+reduce_row_4(float *dest, int dest_x_size,
+             const float *src0, const float *src1, int src_x_size) {
+  int x = 0;
+  for (; x * 2 + 8 <= src_x_size && x + 4 <= dest_x_size; x += 4) {
+    __m128 a = _mm_max_ps(_mm_loadu_ps(src0 + x * 2), _mm_loadu_ps(src1 + x * 2));
+    __m128 b = _mm_max_ps(_mm_loadu_ps(src0 + x * 2 + 4), _mm_loadu_ps(src1 + x * 2 + 4));
+    __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(dest + x, _mm_max_ps(even, odd));
+  }
+  reduce_row(dest, x, dest_x_size, src0, src1, src_x_size);
+}
+
+#else  // OCCLUSION_SSE2
+static void
+fill_row_4(float *row, int x_begin, int x_end, float fy,
+           const TriangleSetup &t) {
+  fill_row(row, x_begin, x_end, fy, t);
+}
+
+static void
+reduce_row_4(float *dest, int dest_x_size,
+             const float *src0, const float *src1, int src_x_size) {
+  reduce_row(dest, 0, dest_x_size, src0, src1, src_x_size);
+}
+#endif  // OCCLUSION_SSE2
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::Constructor
+//       Access: Published
+//  Description: Creates a depth buffer of the indicated size, along
+//               with its pyramid.  The width is rounded up to a
+//               multiple of 4.
+////////////////////////////////////////////////////////////////////
+OcclusionDepthBuffer::
+OcclusionDepthBuffer(int x_size, int y_size) {
+  x_size = (max(x_size, 1) + 3) & ~3;
+  y_size = max(y_size, 1);
+
+  while (true) {
+    Level level;
+    level._x_size = x_size;
+    level._y_size = y_size;
+    level._depth.resize(x_size * y_size, 1.0f);
+    _levels.push_back(level);
+    if (x_size == 1 && y_size == 1) {
+      break;
+    }
+    x_size = (x_size + 1) / 2;
+    y_size = (y_size + 1) / 2;
+  }
+
+  _use_simd = use_simd();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::clear
+//       Access: Published
+//  Description: Resets the whole buffer to the far plane, in
+//               preparation for drawing a new set of occluders.
+////////////////////////////////////////////////////////////////////
+void OcclusionDepthBuffer::
+clear() {
+  Levels::iterator li;
+  for (li = _levels.begin(); li != _levels.end(); ++li) {
+    fill((*li)._depth.begin(), (*li)._depth.end(), 1.0f);
+  }
+  _use_simd = use_simd();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::draw_triangle
+//       Access: Published
+//  Description: Draws the indicated triangle, whose vertices are
+//               given in clip space, into the full-resolution buffer.
+//               Either winding is accepted.  The part of the triangle
+//               in front of the near plane is clipped away.
+////////////////////////////////////////////////////////////////////
+void OcclusionDepthBuffer::
+draw_triangle(const LVecBase4f &a, const LVecBase4f &b,
+              const LVecBase4f &c) {
+  // Discard the triangle quickly if it is entirely outside any one
+  // plane of the view frustum.
+  for (int i = 0; i < 3; ++i) {
+    if ((a[i] > a[3] && b[i] > b[3] && c[i] > c[3]) ||
+        (a[i] < -a[3] && b[i] < -b[3] && c[i] < -c[3])) {
+      return;
+    }
+  }
+
+  LVecBase4f verts[3] = { a, b, c };
+  clip_and_draw(verts, 3);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::draw_geom
+//       Access: Published
+//  Description: Draws all of the polygons of the indicated Geom into
+//               the full-resolution buffer, after transforming its
+//               vertices by the indicated matrix, which should take
+//               them into clip space.  Points and lines are ignored.
+////////////////////////////////////////////////////////////////////
+void OcclusionDepthBuffer::
+draw_geom(const Geom *geom, const LMatrix4f &mat, Thread *current_thread) {
+  CPT(GeomVertexData) vdata = geom->get_vertex_data(current_thread);
+  vdata = vdata->animate_vertices(true, current_thread);
+
+  GeomVertexReader vertex(vdata, InternalName::get_vertex(), current_thread);
+  if (!vertex.has_column()) {
+    return;
+  }
+
+  // Transform each vertex just once, even if it is shared by several
+  // triangles.
+  int num_rows = vdata->get_num_rows();
+  pvector<LVecBase4f> clip;
+  clip.reserve(num_rows);
+  while (!vertex.is_at_end()) {
+    const LVecBase3f &p = vertex.get_data3f();
+    clip.push_back(mat.xform(LVecBase4f(p[0], p[1], p[2], 1.0f)));
+  }
+
+  int num_primitives = geom->get_num_primitives();
+  for (int i = 0; i < num_primitives; ++i) {
+    CPT(GeomPrimitive) prim = geom->get_primitive(i);
+    if (prim->get_primitive_type() != GeomPrimitive::PT_polygons) {
+      continue;
+    }
+    CPT(GeomPrimitive) tris = prim->decompose();
+    int num_vertices = tris->get_num_vertices();
+    for (int vi = 0; vi + 2 < num_vertices; vi += 3) {
+      int v0 = tris->get_vertex(vi);
+      int v1 = tris->get_vertex(vi + 1);
+      int v2 = tris->get_vertex(vi + 2);
+      nassertv(v0 < num_rows && v1 < num_rows && v2 < num_rows);
+      draw_triangle(clip[v0], clip[v1], clip[v2]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::build_pyramid
+//       Access: Published
+//  Description: Fills in the coarser levels of the pyramid from the
+//               full-resolution buffer.  This must be called after
+//               all of the occluders have been drawn, and before
+//               is_box_occluded() is called.
+////////////////////////////////////////////////////////////////////
+void OcclusionDepthBuffer::
+build_pyramid() {
+  for (size_t li = 1; li < _levels.size(); ++li) {
+    const Level &src = _levels[li - 1];
+    Level &dest = _levels[li];
+    for (int y = 0; y < dest._y_size; ++y) {
+      const float *src0 = &src._depth[(y * 2) * src._x_size];
+      const float *src1 = &src._depth[min(y * 2 + 1, src._y_size - 1) * src._x_size];
+      float *row = &dest._depth[y * dest._x_size];
+      if (_use_simd) {
+        reduce_row_4(row, dest._x_size, src0, src1, src._x_size);
+      } else {
+        reduce_row(row, 0, dest._x_size, src0, src1, src._x_size);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::is_box_occluded
+//       Access: Published
+//  Description: Returns true if the indicated axis-aligned box,
+//               transformed into clip space by the indicated matrix,
+//               lies entirely behind the occluders that have been
+//               drawn, by at least depth_bias; or false if any part
+//               of it might be visible.
+//
+//               A box that reaches in front of the near plane, or
+//               that lies entirely off the screen, is never
+//               considered occluded; the latter is the business of
+//               the view-frustum test.
+////////////////////////////////////////////////////////////////////
+bool OcclusionDepthBuffer::
+is_box_occluded(const LPoint3f &min_point, const LPoint3f &max_point,
+                const LMatrix4f &mat, float depth_bias) const {
+  float min_x = 1.0f, max_x = -1.0f;
+  float min_y = 1.0f, max_y = -1.0f;
+  float min_z = 1.0f;
+
+  for (int i = 0; i < 8; ++i) {
+    LVecBase4f corner((i & 1) ? max_point[0] : min_point[0],
+                      (i & 2) ? max_point[1] : min_point[1],
+                      (i & 4) ? max_point[2] : min_point[2],
+                      1.0f);
+    LVecBase4f p = mat.xform(corner);
+    if (p[3] <= 0.0f || p[2] < -p[3]) {
+      return false;
+    }
+    float iw = 1.0f / p[3];
+    float x = p[0] * iw;
+    float y = p[1] * iw;
+    float z = p[2] * iw;
+    if (i == 0) {
+      min_x = max_x = x;
+      min_y = max_y = y;
+      min_z = z;
+    } else {
+      min_x = min(min_x, x);
+      max_x = max(max_x, x);
+      min_y = min(min_y, y);
+      max_y = max(max_y, y);
+      min_z = min(min_z, z);
+    }
+  }
+
+  if (max_x < -1.0f || min_x > 1.0f || max_y < -1.0f || min_y > 1.0f) {
+    return false;
+  }
+
+  // Find the range of full-resolution pixels covered.
+  const Level &base = _levels[0];
+  float fx_size = (float)base._x_size;
+  float fy_size = (float)base._y_size;
+  int x0 = (int)cfloor(max(min_x * 0.5f + 0.5f, 0.0f) * fx_size);
+  int x1 = (int)cfloor(min(max_x * 0.5f + 0.5f, 1.0f) * fx_size);
+  int y0 = (int)cfloor(max(min_y * 0.5f + 0.5f, 0.0f) * fy_size);
+  int y1 = (int)cfloor(min(max_y * 0.5f + 0.5f, 1.0f) * fy_size);
+  x1 = min(x1, base._x_size - 1);
+  y1 = min(y1, base._y_size - 1);
+
+  // Go up the pyramid until that range is no more than four texels
+  // wide and high.
+  int li = 0;
+  while (li + 1 < (int)_levels.size() &&
+         ((x1 >> li) - (x0 >> li) > 3 || (y1 >> li) - (y0 >> li) > 3)) {
+    ++li;
+  }
+
+  const Level &level = _levels[li];
+  float limit = min_z - depth_bias;
+  for (int y = (y0 >> li); y <= (y1 >> li); ++y) {
+    const float *row = &level._depth[y * level._x_size];
+    for (int x = (x0 >> li); x <= (x1 >> li); ++x) {
+      if (row[x] >= limit) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::use_simd
+//       Access: Public, Static
+//  Description: Returns true if the SSE2 rasterizer should be used,
+//               according to software-occlusion-simd and the
+//               capabilities of the CPU.
+////////////////////////////////////////////////////////////////////
+bool OcclusionDepthBuffer::
+use_simd() {
+#ifdef OCCLUSION_SSE2
+  return software_occlusion_simd && LSimd::get_supported_level() >= LSimd::L_sse2;
+#else
+  return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::clip_and_draw
+//       Access: Private
+//  Description: Clips the indicated convex polygon, given in clip
+//               space, against the near plane, and draws what
+//               remains as a fan of triangles.
+////////////////////////////////////////////////////////////////////
+void OcclusionDepthBuffer::
+clip_and_draw(const LVecBase4f verts[], int num_verts) {
+  // Clipping a triangle against one plane yields at most four
+  // vertices.
+  LVecBase4f clipped[4];
+  int num_clipped = 0;
+
+  for (int i = 0; i < num_verts; ++i) {
+    const LVecBase4f &p = verts[i];
+    const LVecBase4f &q = verts[(i + 1) % num_verts];
+    float dp = p[2] + p[3];
+    float dq = q[2] + q[3];
+    if (dp >= 0.0f) {
+      clipped[num_clipped++] = p;
+    }
+    if ((dp >= 0.0f) != (dq >= 0.0f)) {
+      float t = dp / (dp - dq);
+      clipped[num_clipped++] = p + (q - p) * t;
+    }
+  }
+  if (num_clipped < 3) {
+    return;
+  }
+
+  const Level &base = _levels[0];
+  LPoint3f screen[4];
+  for (int i = 0; i < num_clipped; ++i) {
+    const LVecBase4f &p = clipped[i];
+    if (p[3] <= 0.0f) {
+      // Only a strange lens would put anything behind the eye on the
+      // far side of the near plane, but let's not divide by it.
+      return;
+    }
+    float iw = 1.0f / p[3];
+    screen[i].set((p[0] * iw * 0.5f + 0.5f) * (float)base._x_size,
+                  (p[1] * iw * 0.5f + 0.5f) * (float)base._y_size,
+                  p[2] * iw);
+  }
+
+  for (int i = 2; i < num_clipped; ++i) {
+    draw_screen_triangle(screen[0], screen[i - 1], screen[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: OcclusionDepthBuffer::draw_screen_triangle
+//       Access: Private
+//  Description: Fills the pixels that lie entirely within the
+//               indicated triangle, whose vertices are given in
+//               pixel coordinates with depth in the z component.
+////////////////////////////////////////////////////////////////////
+void OcclusionDepthBuffer::
+draw_screen_triangle(const LPoint3f &a, const LPoint3f &b,
+                     const LPoint3f &c) {
+  const LPoint3f *v[3] = { &a, &b, &c };
+  float area = (b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]);
+  if (area < 0.0f) {
+    swap(v[1], v[2]);
+    area = -area;
+  }
+  if (!(area > 0.0f)) {
+    // Degenerate, or not a number.
+    return;
+  }
+
+  // Edge i runs from vertex i to vertex i + 1; its function is
+  // positive on the inside of the triangle.
+  TriangleSetup t;
+  for (int i = 0; i < 3; ++i) {
+    const LPoint3f &p = *v[i];
+    const LPoint3f &q = *v[(i + 1) % 3];
+    t._ea[i] = p[1] - q[1];
+    t._eb[i] = q[0] - p[0];
+    t._ec[i] = -(t._ea[i] * p[0] + t._eb[i] * p[1]);
+  }
+
+  // Each vertex's barycentric weight is the function of the opposite
+  // edge, divided by the area.
+  float z0 = (*v[0])[2] / area;
+  float z1 = (*v[1])[2] / area;
+  float z2 = (*v[2])[2] / area;
+  t._za = t._ea[1] * z0 + t._ea[2] * z1 + t._ea[0] * z2;
+  t._zb = t._eb[1] * z0 + t._eb[2] * z1 + t._eb[0] * z2;
+  t._zc = t._ec[1] * z0 + t._ec[2] * z1 + t._ec[0] * z2;
+
+  // We must never claim that a pixel is hidden when some part of it
+  // isn't, so we only fill the pixels that the triangle covers
+  // entirely, and with the farthest depth it has within each of them.
+  // Both amount to evaluating the functions at whichever corner of
+  // the pixel is worst, instead of at its center.
+  for (int i = 0; i < 3; ++i) {
+    t._ec[i] -= 0.5f * (cabs(t._ea[i]) + cabs(t._eb[i]));
+  }
+  t._zc += 0.5f * (cabs(t._za) + cabs(t._zb));
+
+  // The range of pixels whose centers might be covered.
+  const Level &base = _levels[0];
+  float min_x = min(min(a[0], b[0]), c[0]);
+  float max_x = max(max(a[0], b[0]), c[0]);
+  float min_y = min(min(a[1], b[1]), c[1]);
+  float max_y = max(max(a[1], b[1]), c[1]);
+  min_x = max(min_x, 0.0f);
+  min_y = max(min_y, 0.0f);
+  max_x = min(max_x, (float)base._x_size);
+  max_y = min(max_y, (float)base._y_size);
+
+  int x_begin = (int)cceil(min_x - 0.5f);
+  int x_end = min((int)cfloor(max_x - 0.5f) + 1, base._x_size);
+  int y_begin = (int)cceil(min_y - 0.5f);
+  int y_end = min((int)cfloor(max_y - 0.5f) + 1, base._y_size);
+  if (x_begin >= x_end || y_begin >= y_end) {
+    return;
+  }
+
+  float *depth = &_levels[0]._depth[0];
+  for (int y = y_begin; y < y_end; ++y) {
+    float *row = depth + y * base._x_size;
+    float fy = (float)y + 0.5f;
+    if (_use_simd) {
+      fill_row_4(row, x_begin, x_end, fy, t);
+    } else {
+      fill_row(row, x_begin, x_end, fy, t);
+    }
+  }
+}
@@ -0,0 +1,92 @@
+// Filename: occlusionDepthBuffer.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef OCCLUSIONDEPTHBUFFER_H
+#define OCCLUSIONDEPTHBUFFER_H
+
+#include "pandabase.h"
+#include "luse.h"
+#include "pvector.h"
+
+class Geom;
+class Thread;
+
+////////////////////////////////////////////////////////////////////
+//       Class : OcclusionDepthBuffer
+// Description : A small depth buffer in main memory, into which the
+//               SoftwareOcclusionCullTraverser draws its occluders
+//               each frame, along with a hierarchy of successively
+//               coarser copies of it (the hierarchical Z pyramid),
+//               each texel of which holds the farthest depth of the
+//               four texels beneath it.
+//
+//               A bounding box may be tested against the pyramid by
+//               reading just a handful of texels at whichever level
+//               its projection covers only a few of; if its nearest
+//               point is farther than all of them, it is entirely
+//               hidden behind the occluders.
+//
+//               The depths stored are z / w in clip space, as
+//               computed by Lens::get_projection_mat(), so that they
+//               may be interpolated linearly across the screen.  Only
+//               the pixels that an occluder covers entirely are
+//               filled, each with the farthest depth the occluder has
+//               within it, so that a box is never reported hidden
+//               when any part of it might be seen.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_CULL OcclusionDepthBuffer {
+PUBLISHED:
+  OcclusionDepthBuffer(int x_size, int y_size);
+
+  INLINE int get_x_size() const;
+  INLINE int get_y_size() const;
+  INLINE int get_num_levels() const;
+  INLINE int get_level_x_size(int level) const;
+  INLINE int get_level_y_size(int level) const;
+  INLINE float get_depth(int x, int y, int level = 0) const;
+
+  void clear();
+  void draw_triangle(const LVecBase4f &a, const LVecBase4f &b,
+                     const LVecBase4f &c);
+  void draw_geom(const Geom *geom, const LMatrix4f &mat,
+                 Thread *current_thread);
+  void build_pyramid();
+
+  bool is_box_occluded(const LPoint3f &min_point, const LPoint3f &max_point,
+                       const LMatrix4f &mat, float depth_bias) const;
+
+public:
+  static bool use_simd();
+
+private:
+  void clip_and_draw(const LVecBase4f verts[], int num_verts);
+  void draw_screen_triangle(const LPoint3f &a, const LPoint3f &b,
+                            const LPoint3f &c);
+
+  class Level {
+  public:
+    int _x_size;
+    int _y_size;
+    pvector<float> _depth;
+  };
+  typedef pvector<Level> Levels;
+  Levels _levels;
+
+  bool _use_simd;
+};
+
+#include "occlusionDepthBuffer.I"
+
+#endif
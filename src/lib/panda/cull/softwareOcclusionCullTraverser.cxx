@@ -0,0 +1,300 @@
+// Filename: softwareOcclusionCullTraverser.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "softwareOcclusionCullTraverser.h"
+#include "config_cull.h"
+#include "cullTraverserData.h"
+#include "cullableObject.h"
+#include "sceneSetup.h"
+#include "lens.h"
+#include "boundingVolume.h"
+#include "finiteBoundingVolume.h"
+#include "graphicsStateGuardianBase.h"
+#include "pStatTimer.h"
+
+PStatCollector SoftwareOcclusionCullTraverser::_setup_occlusion_pcollector("Cull:Occlusion:Setup");
+PStatCollector SoftwareOcclusionCullTraverser::_draw_occlusion_pcollector("Cull:Occlusion:Occluders");
+
+PStatCollector SoftwareOcclusionCullTraverser::_occlusion_passed_pcollector("Occlusion results:Visible");
+PStatCollector SoftwareOcclusionCullTraverser::_occlusion_failed_pcollector("Occlusion results:Occluded");
+PStatCollector SoftwareOcclusionCullTraverser::_occlusion_tests_pcollector("Occlusion tests");
+
+TypeHandle SoftwareOcclusionCullTraverser::_type_handle;
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::Constructor
+//       Access: Published
+//  Description: 
+////////////////////////////////////////////////////////////////////
+SoftwareOcclusionCullTraverser::
+SoftwareOcclusionCullTraverser() :
+  _occlusion_mask(DrawMask::all_off()),
+  _dr_incomplete_render(false),
+  _occluders_pending(false),
+  _live(false),
+  _depth_bias(0.0f),
+  _min_vertices(0),
+  _tested_count(0),
+  _occluded_count(0),
+  _num_tested(0),
+  _num_occluded(0)
+{
+  if (software_occlusion_size.get_num_words() < 2) {
+    _buffer = new OcclusionDepthBuffer(software_occlusion_size, software_occlusion_size);
+  } else {
+    _buffer = new OcclusionDepthBuffer(software_occlusion_size[0], software_occlusion_size[1]);
+  }
+  _internal_trav = new CullTraverser;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::Copy Constructor
+//       Access: Published
+//  Description: 
+////////////////////////////////////////////////////////////////////
+SoftwareOcclusionCullTraverser::
+SoftwareOcclusionCullTraverser(const SoftwareOcclusionCullTraverser &copy) :
+  CullTraverser(copy),
+  _occlusion_mask(copy._occlusion_mask),
+  _dr_incomplete_render(false),
+  _occluders_pending(false),
+  _live(false),
+  _depth_bias(0.0f),
+  _min_vertices(0),
+  _tested_count(0),
+  _occluded_count(0),
+  _num_tested(0),
+  _num_occluded(0)
+{
+  _buffer = new OcclusionDepthBuffer(copy._buffer->get_x_size(),
+                                     copy._buffer->get_y_size());
+  _internal_trav = new CullTraverser;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::Destructor
+//       Access: Published, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+SoftwareOcclusionCullTraverser::
+~SoftwareOcclusionCullTraverser() {
+  delete _buffer;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::set_scene
+//       Access: Published, Virtual
+//  Description: Sets the SceneSetup object that indicates the initial
+//               camera position, etc.  This must be called before
+//               traversal begins.
+//
+//               The occluders aren't drawn until the traversal
+//               begins, since the view frustum isn't known until
+//               then.
+////////////////////////////////////////////////////////////////////
+void SoftwareOcclusionCullTraverser::
+set_scene(SceneSetup *scene_setup, GraphicsStateGuardianBase *gsg,
+          bool dr_incomplete_render) {
+  CullTraverser::set_scene(scene_setup, gsg, dr_incomplete_render);
+  _dr_incomplete_render = dr_incomplete_render;
+  _occluders_pending = !_occlusion_mask.is_zero() &&
+    scene_setup->get_lens() != (Lens *)NULL;
+  _live = false;
+  _tested_count = 0;
+  _occluded_count = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::end_traverse
+//       Access: Published, Virtual
+//  Description: Should be called when the traverser has finished
+//               traversing its scene, this gives it a chance to do
+//               any necessary finalization.
+////////////////////////////////////////////////////////////////////
+void SoftwareOcclusionCullTraverser::
+end_traverse() {
+  CullTraverser::end_traverse();
+
+  _num_tested = (int)AtomicAdjust::get(_tested_count);
+  _num_occluded = (int)AtomicAdjust::get(_occluded_count);
+  _occluders_pending = false;
+  _live = false;
+
+  _occlusion_tests_pcollector.add_level(_num_tested);
+  _occlusion_passed_pcollector.add_level(_num_tested - _num_occluded);
+  _occlusion_failed_pcollector.add_level(_num_occluded);
+
+  _occlusion_passed_pcollector.flush_level();
+  _occlusion_failed_pcollector.flush_level();
+  _occlusion_tests_pcollector.flush_level();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::is_occlusion_culling
+//       Access: Public, Virtual
+//  Description: Returns true if this traverser prunes nodes that are
+//               hidden behind the occluders, which it does once an
+//               occlusion mask has been set.
+////////////////////////////////////////////////////////////////////
+bool SoftwareOcclusionCullTraverser::
+is_occlusion_culling() const {
+  return !_occlusion_mask.is_zero();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::is_in_view
+//       Access: Protected, Virtual
+//  Description: Returns true if the current node is fully or
+//               partially within the viewing area and should be
+//               drawn, or false if it (and all of its children)
+//               should be pruned.
+//
+//               In addition to the usual tests, the node's bounding
+//               volume is tested against the occluders.
+////////////////////////////////////////////////////////////////////
+bool SoftwareOcclusionCullTraverser::
+is_in_view(CullTraverserData &data) {
+  if (_occluders_pending) {
+    // This is the first node of the traversal, which is always
+    // visited by the thread that began it, before any others.
+    _occluders_pending = false;
+    draw_occluders();
+  }
+
+  if (!CullTraverser::is_in_view(data)) {
+    return false;
+  }
+  if (!_live) {
+    return true;
+  }
+
+  PandaNodePipelineReader *node_reader = data.node_reader();
+  if (node_reader->get_nested_vertices() < _min_vertices) {
+    return true;
+  }
+
+  CPT(BoundingVolume) vol = node_reader->get_bounds();
+  if (vol->is_empty() || vol->is_infinite()) {
+    return true;
+  }
+  const FiniteBoundingVolume *fbv = vol->as_finite_bounding_volume();
+  if (fbv == (FiniteBoundingVolume *)NULL) {
+    return true;
+  }
+
+  // The node's bounding volume is in its parent's space, and so is
+  // the net transform at this point.
+  LMatrix4f mat = data.get_net_transform(this)->get_mat() * _world_to_clip;
+
+  AtomicAdjust::inc(_tested_count);
+  if (_buffer->is_box_occluded(fbv->get_min(), fbv->get_max(), mat, _depth_bias)) {
+    AtomicAdjust::inc(_occluded_count);
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::draw_occluders
+//       Access: Private
+//  Description: Traverses the scene with the occlusion mask, drawing
+//               each of the occluders found into the depth buffer,
+//               and then builds the pyramid from it.
+////////////////////////////////////////////////////////////////////
+void SoftwareOcclusionCullTraverser::
+draw_occluders() {
+  SceneSetup *scene_setup = get_scene();
+  GraphicsStateGuardianBase *gsg = get_gsg();
+  const LMatrix4f &proj_mat = scene_setup->get_lens()->get_projection_mat();
+
+  _world_to_clip = scene_setup->get_world_transform()->get_mat() * proj_mat;
+  _depth_bias = software_occlusion_depth_bias;
+  _min_vertices = software_occlusion_min_vertices;
+
+  // The objects found by the internal traversal have been transformed
+  // into the GSG's coordinate system, which we must undo before
+  // applying the lens.
+  LMatrix4f internal_to_clip = 
+    invert(gsg->get_cs_transform()->get_mat()) * proj_mat;
+  OccluderHandler handler(_buffer, internal_to_clip);
+
+  {
+    PStatTimer timer(_draw_occlusion_pcollector);
+    _buffer->clear();
+
+    _internal_trav->set_cull_handler(&handler);
+    _internal_trav->set_scene(scene_setup, gsg, _dr_incomplete_render);
+    _internal_trav->set_view_frustum(get_view_frustum());
+    _internal_trav->set_camera_mask(_occlusion_mask);
+    _internal_trav->traverse(scene_setup->get_scene_root());
+    _internal_trav->end_traverse();
+    _internal_trav->set_cull_handler(NULL);
+  }
+
+  if (handler._num_occluders != 0) {
+    PStatTimer timer(_setup_occlusion_pcollector);
+    _buffer->build_pyramid();
+    _live = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::OccluderHandler::Constructor
+//       Access: Public
+//  Description: 
+////////////////////////////////////////////////////////////////////
+SoftwareOcclusionCullTraverser::OccluderHandler::
+OccluderHandler(OcclusionDepthBuffer *buffer, const LMatrix4f &internal_to_clip) :
+  _buffer(buffer),
+  _internal_to_clip(internal_to_clip),
+  _num_occluders(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SoftwareOcclusionCullTraverser::OccluderHandler::record_object
+//       Access: Public, Virtual
+//  Description: Draws the indicated object, and any decals or
+//               instances that go with it, into the depth buffer.
+////////////////////////////////////////////////////////////////////
+void SoftwareOcclusionCullTraverser::OccluderHandler::
+record_object(CullableObject *object, const CullTraverser *traverser) {
+  Thread *current_thread = traverser->get_current_thread();
+
+  for (const CullableObject *obj = object; 
+       obj != (CullableObject *)NULL; 
+       obj = obj->get_next()) {
+    if (obj->_geom == (Geom *)NULL) {
+      continue;
+    }
+    const CullableObject::InstanceTransforms *transforms = 
+      obj->get_instance_transforms();
+    if (transforms != (CullableObject::InstanceTransforms *)NULL) {
+      CullableObject::InstanceTransforms::const_iterator ti;
+      for (ti = transforms->begin(); ti != transforms->end(); ++ti) {
+        _buffer->draw_geom(obj->_geom, (*ti)->get_mat() * _internal_to_clip,
+                           current_thread);
+      }
+    } else {
+      _buffer->draw_geom(obj->_geom, 
+                         obj->_internal_transform->get_mat() * _internal_to_clip,
+                         current_thread);
+    }
+    ++_num_occluders;
+  }
+
+  delete object;
+}
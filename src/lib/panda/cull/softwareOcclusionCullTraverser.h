@@ -0,0 +1,141 @@
+// Filename: softwareOcclusionCullTraverser.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef SOFTWAREOCCLUSIONCULLTRAVERSER_H
+#define SOFTWAREOCCLUSIONCULLTRAVERSER_H
+
+#include "pandabase.h"
+#include "cullTraverser.h"
+#include "cullHandler.h"
+#include "occlusionDepthBuffer.h"
+#include "atomicAdjust.h"
+#include "pStatCollector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : SoftwareOcclusionCullTraverser
+// Description : This specialization of CullTraverser performs
+//               occlusion culling entirely on the CPU, without any
+//               help from the graphics pipe, so that it works just as
+//               well with tinydisplay, or with no graphics hardware
+//               at all.
+//
+//               At the start of each traversal, the occluders are
+//               drawn into a small OcclusionDepthBuffer, and its
+//               hierarchical Z pyramid is built.  Then, as each node
+//               is visited, its bounding volume is tested against the
+//               pyramid, and if it lies entirely behind the
+//               occluders, the node and all of its children are
+//               pruned, just as if they had failed the view-frustum
+//               test.
+//
+//               The occluders are the polygons that are visible to
+//               the occlusion mask; see set_occlusion_mask().  They
+//               should be large, simple shapes, like the walls of
+//               buildings or a terrain's hills, or invisible proxies
+//               of those shapes.  Occlusion culling is disabled until
+//               an occlusion mask is set.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_CULL SoftwareOcclusionCullTraverser : public CullTraverser {
+PUBLISHED:
+  SoftwareOcclusionCullTraverser();
+  SoftwareOcclusionCullTraverser(const SoftwareOcclusionCullTraverser &copy);
+  virtual ~SoftwareOcclusionCullTraverser();
+
+  virtual void set_scene(SceneSetup *scene_setup,
+                         GraphicsStateGuardianBase *gsg,
+                         bool dr_incomplete_render);
+  virtual void end_traverse();
+
+  INLINE void set_occlusion_mask(const DrawMask &occlusion_mask);
+  INLINE const DrawMask &get_occlusion_mask() const;
+
+  INLINE const OcclusionDepthBuffer *get_depth_buffer() const;
+  INLINE int get_num_tested() const;
+  INLINE int get_num_occluded() const;
+
+public:
+  virtual bool is_occlusion_culling() const;
+
+protected:
+  virtual bool is_in_view(CullTraverserData &data);
+
+private:
+  void draw_occluders();
+
+  // The CullHandler for the internal traversal of the occluders.
+  // It draws each object it receives into the depth buffer.
+  class OccluderHandler : public CullHandler {
+  public:
+    OccluderHandler(OcclusionDepthBuffer *buffer, const LMatrix4f &internal_to_clip);
+
+    virtual void record_object(CullableObject *object, 
+                               const CullTraverser *traverser);
+
+    OcclusionDepthBuffer *_buffer;
+    LMatrix4f _internal_to_clip;
+    int _num_occluders;
+  };
+
+  DrawMask _occlusion_mask;
+  OcclusionDepthBuffer *_buffer;
+  PT(CullTraverser) _internal_trav;
+  bool _dr_incomplete_render;
+
+  // True after set_scene(), until the occluders have been drawn at
+  // the start of the traversal.
+  bool _occluders_pending;
+
+  // True if there are occluders to test against this frame.
+  bool _live;
+
+  LMatrix4f _world_to_clip;
+  float _depth_bias;
+  int _min_vertices;
+
+  // Counted during the traversal, which may be spread across
+  // several threads, and copied to the published values at the end.
+  AtomicAdjust::Integer _tested_count;
+  AtomicAdjust::Integer _occluded_count;
+  int _num_tested;
+  int _num_occluded;
+
+  static PStatCollector _setup_occlusion_pcollector;
+  static PStatCollector _draw_occlusion_pcollector;
+
+  static PStatCollector _occlusion_passed_pcollector;
+  static PStatCollector _occlusion_failed_pcollector;
+  static PStatCollector _occlusion_tests_pcollector;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    CullTraverser::init_type();
+    register_type(_type_handle, "SoftwareOcclusionCullTraverser",
+                  CullTraverser::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "softwareOcclusionCullTraverser.I"
+
+#endif
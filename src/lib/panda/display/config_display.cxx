@@ -433,6 +433,13 @@ ConfigVariableBool basic_shaders_only
           "flaky becomes reliable, we may expand the definition of what "
           "constitutes 'basic' shaders."));
 
+ConfigVariableInt munge_cache_min_vertices
+("munge-cache-min-vertices", 256,
+ PRC_DESC("When model-cache-munged-geoms is true, vertex data with fewer than "
+          "this many vertices is converted for the GSG each time, rather "
+          "than being stored in the model cache.  Small vertex data may be "
+          "converted more quickly than it can be read from disk."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libdisplay
 //  Description: Initializes the library.  This must be called at
@@ -466,6 +473,7 @@ init_libdisplay() {
   NativeWindowHandle::init_type();
   ParasiteBuffer::init_type();
   StandardMunger::init_type();
+  StandardMunger::init_munge_cache();
   StereoDisplayRegion::init_type();
 #ifdef SUPPORT_SUBPROCESS_WINDOW
   SubprocessWindow::init_type();
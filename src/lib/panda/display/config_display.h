@@ -102,6 +102,7 @@ extern EXPCL_PANDA_DISPLAY ConfigVariableDouble pixel_zoom;
 extern EXPCL_PANDA_DISPLAY ConfigVariableDouble background_color;
 extern EXPCL_PANDA_DISPLAY ConfigVariableBool sync_video;
 extern EXPCL_PANDA_DISPLAY ConfigVariableBool basic_shaders_only;
+extern EXPCL_PANDA_DISPLAY ConfigVariableInt munge_cache_min_vertices;
 
 extern EXPCL_PANDA_DISPLAY void init_libdisplay();
 
@@ -31,6 +31,7 @@
 #include "cullFaceAttrib.h"
 #include "string_utils.h"
 #include "geomCacheManager.h"
+#include "textureStreamManager.h"
 #include "renderState.h"
 #include "transformState.h"
 #include "thread.h"
@@ -38,6 +39,7 @@
 #include "throw_event.h"
 #include "bamCache.h"
 #include "cullableObject.h"
+#include "cullCacheNode.h"
 #include "geomVertexArrayData.h"
 #include "vertexDataSaveFile.h"
 #include "vertexDataBook.h"
@@ -641,6 +643,10 @@ render_frame() {
   BamCache *cache = BamCache::get_global_ptr();
   cache->consider_flush_index();
 
+  // Likewise, decide which mipmap levels the streamed textures need,
+  // now that the last frame's cull traversal has measured them.
+  TextureStreamManager::get_global_ptr()->update();
+
   // Anything that happens outside of GraphicsEngine::render_frame()
   // is deemed to be App.
 #ifdef DO_PSTATS
@@ -765,6 +771,10 @@ render_frame() {
     RenderState::flush_level();
     TransformState::flush_level();
     CullableObject::flush_level();
+    TextureStreamManager::flush_level();
+    PandaNode::flush_level();
+    CullCacheNode::flush_level();
+    PStatClient::flush_frame_levels();
     
     // Now cycle the pipeline and officially begin the next frame.
 #ifdef THREADED_PIPELINE
@@ -790,6 +800,11 @@ render_frame() {
     GeomCacheManager::_geom_cache_record_pcollector.clear_level();
     GeomCacheManager::_geom_cache_erase_pcollector.clear_level();
     GeomCacheManager::_geom_cache_evict_pcollector.clear_level();
+    TextureStreamManager::_request_pcollector.clear_level();
+    TextureStreamManager::_evict_pcollector.clear_level();
+    PandaNode::clear_level();
+    CullCacheNode::clear_level();
+    PStatClient::clear_frame_levels();
     
     GraphicsStateGuardian::init_frame_pstats();
     
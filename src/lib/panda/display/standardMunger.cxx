@@ -17,9 +17,20 @@
 #include "graphicsStateGuardian.h"
 #include "dcast.h"
 #include "config_gobj.h"
+#include "config_display.h"
 #include "displayRegion.h"
+#include "bamCache.h"
+#include "bamCacheRecord.h"
+#include "lightMutexHolder.h"
+#include "hashVal.h"
+
+#ifdef HAVE_OPENSSL
+#include "openssl/md5.h"
+#endif  // HAVE_OPENSSL
 
 TypeHandle StandardMunger::_type_handle;
+CacheStats StandardMunger::_munge_cache_stats;
+LightMutex StandardMunger::_munge_cache_lock;
 
 ////////////////////////////////////////////////////////////////////
 //     Function: StandardMunger::Constructor
@@ -160,8 +171,200 @@ munge_data_impl(const GeomVertexData *data) {
     return new_data;
   }
 
-  return new_data->convert_to(new_format);
+  return convert_data(new_data, new_format, "munge");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: StandardMunger::premunge_data_impl
+//       Access: Protected, Virtual
+//  Description: Given a source GeomVertexData, converts it as
+//               necessary for rendering.
+////////////////////////////////////////////////////////////////////
+CPT(GeomVertexData) StandardMunger::
+premunge_data_impl(const GeomVertexData *data) {
+  nassertr(is_registered(), NULL);
+
+  CPT(GeomVertexFormat) orig_format = data->get_format();
+  CPT(GeomVertexFormat) new_format = premunge_format(orig_format);
+
+  if (new_format == orig_format) {
+    // Trivial case.
+    return data;
+  }
+
+  return convert_data(data, new_format, "premunge");
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: StandardMunger::init_munge_cache
+//       Access: Public, Static
+//  Description: Initializes the statistics for the on-disk munge
+//               cache.  This is called once, by init_libdisplay().
+////////////////////////////////////////////////////////////////////
+void StandardMunger::
+init_munge_cache() {
+  _munge_cache_stats.init();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: StandardMunger::convert_data
+//       Access: Private
+//  Description: Returns the indicated vertex data converted to
+//               new_format.  If BamCache::get_cache_munged_geoms()
+//               is true, the converted data is read from the model
+//               cache if it has been stored there before, and stored
+//               there if it has not.
+//
+//               Only static vertex data is cached this way.  Vertex
+//               data with a TransformTable, TransformBlendTable, or
+//               SliderTable shares those tables with the rest of the
+//               scene graph, which a copy read from disk would not.
+//
+//               Without OpenSSL there is no digest strong enough to
+//               identify vertex data by its contents, so nothing is
+//               cached.
+////////////////////////////////////////////////////////////////////
+CPT(GeomVertexData) StandardMunger::
+convert_data(const GeomVertexData *data, const GeomVertexFormat *new_format,
+             const char *kind) {
+#ifndef HAVE_OPENSSL
+  return data->convert_to(new_format);
+
+#else  // HAVE_OPENSSL
+  BamCache *cache = BamCache::get_global_ptr();
+  if (!cache->get_cache_munged_geoms() ||
+      data->get_num_rows() < munge_cache_min_vertices ||
+      data->get_transform_table() != (TransformTable *)NULL ||
+      data->get_transform_blend_table() != (TransformBlendTable *)NULL ||
+      data->get_slider_table() != (SliderTable *)NULL) {
+    return data->convert_to(new_format);
+  }
+
+  Filename source_filename = get_munge_cache_filename(data, new_format, kind);
+  PT(BamCacheRecord) record = cache->lookup(source_filename, "vdo");
+
+  if (record != (BamCacheRecord *)NULL && record->has_data() &&
+      record->get_data()->is_of_type(GeomVertexData::get_class_type())) {
+    CPT(GeomVertexData) cached_data = DCAST(GeomVertexData, record->get_data());
+    if (cached_data->get_format() == new_format &&
+        cached_data->get_num_rows() == data->get_num_rows()) {
+      // We have munged this data before, on this or a previous run.
+      LightMutexHolder holder(_munge_cache_lock);
+      _munge_cache_stats.inc_hits();
+      _munge_cache_stats.maybe_report("Munge disk");
+      return cached_data;
+    }
+  }
+
+  CPT(GeomVertexData) new_data = data->convert_to(new_format);
+
+  bool stored = false;
+  if (record != (BamCacheRecord *)NULL) {
+    GeomVertexData *store_data = (GeomVertexData *)new_data.p();
+    record->set_data(store_data, store_data);
+    stored = cache->store(record);
+  }
+
+  LightMutexHolder holder(_munge_cache_lock);
+  _munge_cache_stats.inc_misses();
+  if (stored) {
+    // The size and state counts both mean the number of entries this
+    // process has written to the cache.
+    _munge_cache_stats.inc_adds(false);
+    _munge_cache_stats.add_total_size(1);
+    _munge_cache_stats.add_num_states(1);
+  }
+  _munge_cache_stats.maybe_report("Munge disk");
+
+  return new_data;
+#endif  // HAVE_OPENSSL
+}
+
+#ifdef HAVE_OPENSSL
+
+////////////////////////////////////////////////////////////////////
+//     Function: StandardMunger::get_munge_cache_filename
+//       Access: Private
+//  Description: Returns the name under which the result of
+//               converting the indicated vertex data to new_format is
+//               stored in the model cache.  This is not the name of
+//               an actual file; BamCache hashes it to choose the
+//               name of the cache file, and records it there to
+//               detect collisions.
+//
+//               The name is built from the MD5 digest of the target
+//               format, which encodes the capabilities of the GSG
+//               that the munger was built for, and two independent
+//               hashes of the format and contents of the source data:
+//               its MD5 digest, and its 64-bit FNV-1a hash.  Since
+//               BamCache compares the whole name on lookup, a hit
+//               requires both to match.  The data has already had any
+//               color changes applied by this munger by this point,
+//               so nothing else about the munger affects the result.
+////////////////////////////////////////////////////////////////////
+Filename StandardMunger::
+get_munge_cache_filename(const GeomVertexData *data,
+                         const GeomVertexFormat *new_format,
+                         const char *kind) const {
+  // The offset basis of the 64-bit FNV-1a hash.
+  static const PN_uint64 hash_basis = ((PN_uint64)0xcbf29ce4 << 32) | 0x84222325;
+
+  ostringstream format_strm;
+  new_format->write(format_strm, 0);
+  HashVal format_hash;
+  format_hash.hash_string(format_strm.str());
+
+  ostringstream source_strm;
+  data->get_format()->write(source_strm, 0);
+  source_strm << data->get_name() << "\n" << (int)data->get_usage_hint() << "\n"
+              << data->get_num_rows() << "\n";
+  string source_text = source_strm.str();
+
+  MD5_CTX md5;
+  MD5_Init(&md5);
+  MD5_Update(&md5, source_text.data(), source_text.size());
+  PN_uint64 data_hash = hash_bytes(hash_basis, source_text.data(), source_text.size());
+
+  for (int i = 0; i < data->get_num_arrays(); ++i) {
+    CPT(GeomVertexArrayDataHandle) handle = data->get_array(i)->get_handle();
+    const unsigned char *p = handle->get_read_pointer(true);
+    size_t size = handle->get_data_size_bytes();
+    MD5_Update(&md5, p, size);
+    data_hash = hash_bytes(data_hash, p, size);
+  }
+
+  unsigned char md[16];
+  MD5_Final(md, &md5);
+
+  ostringstream strm;
+  strm << "/munged_geoms/" << kind << "/" << get_gsg()->get_type() << "/";
+  format_hash.output_hex(strm);
+  strm << "/" << hex << setfill('0');
+  for (int i = 0; i < 16; ++i) {
+    strm << setw(2) << (int)md[i];
+  }
+  strm << "/" << setw(16) << data_hash;
+  return Filename(strm.str());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: StandardMunger::hash_bytes
+//       Access: Private, Static
+//  Description: Folds the indicated bytes, one at a time, into a
+//               64-bit FNV-1a hash, and returns the new hash value.
+////////////////////////////////////////////////////////////////////
+PN_uint64 StandardMunger::
+hash_bytes(PN_uint64 hash, const void *data, size_t size) {
+  static const PN_uint64 hash_prime = ((PN_uint64)0x100 << 32) | 0x1b3;
+
+  const unsigned char *p = (const unsigned char *)data;
+  const unsigned char *end = p + size;
+  for (; p < end; ++p) {
+    hash = (hash ^ *p) * hash_prime;
+  }
+  return hash;
 }
+#endif  // HAVE_OPENSSL
 
 ////////////////////////////////////////////////////////////////////
 //     Function: StandardMunger::munge_geom_impl
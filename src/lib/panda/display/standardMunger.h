@@ -23,6 +23,11 @@
 #include "renderModeAttrib.h"
 #include "pointerTo.h"
 #include "weakPointerTo.h"
+#include "cacheStats.h"
+#include "lightMutex.h"
+#include "numeric_types.h"
+
+class Filename;
 
 ////////////////////////////////////////////////////////////////////
 //       Class : StandardMunger
@@ -40,8 +45,11 @@ public:
 
   INLINE GraphicsStateGuardian *get_gsg() const;
 
+  static void init_munge_cache();
+
 protected:
   virtual CPT(GeomVertexData) munge_data_impl(const GeomVertexData *data);
+  virtual CPT(GeomVertexData) premunge_data_impl(const GeomVertexData *data);
   virtual int compare_to_impl(const GeomMunger *other) const;
   virtual void munge_geom_impl(CPT(Geom) &geom, CPT(GeomVertexData) &data,
                                Thread *current_thread);
@@ -49,6 +57,17 @@ protected:
   virtual int geom_compare_to_impl(const GeomMunger *other) const;
   virtual CPT(RenderState) munge_state_impl(const RenderState *state);
 
+private:
+  CPT(GeomVertexData) convert_data(const GeomVertexData *data,
+                                   const GeomVertexFormat *new_format,
+                                   const char *kind);
+#ifdef HAVE_OPENSSL
+  Filename get_munge_cache_filename(const GeomVertexData *data,
+                                    const GeomVertexFormat *new_format,
+                                    const char *kind) const;
+  static PN_uint64 hash_bytes(PN_uint64 hash, const void *data, size_t size);
+#endif  // HAVE_OPENSSL
+
 private:
   int _num_components;
   NumericType _numeric_type;
@@ -61,6 +80,9 @@ private:
   Colorf _color;
   LVecBase4f _color_scale;
 
+  static CacheStats _munge_cache_stats;
+  static LightMutex _munge_cache_lock;
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
@@ -46,6 +46,8 @@ EggXfmSAnim(const EggXfmAnimData &convert_from)
   : EggGroupNode(convert_from.get_name())
 {
   _has_fps = false;
+  _has_tolerance = false;
+  _has_hpr_tolerance = false;
   _coordsys = convert_from.get_coordinate_system();
 
   if (convert_from.has_order()) {
@@ -179,6 +181,16 @@ write(ostream &out, int indent_level) const {
       << "<Char*> order { " << get_order() << " }\n";
   }
 
+  if (has_tolerance()) {
+    indent(out, indent_level + 2)
+      << "<Scalar> tolerance { " << get_tolerance() << " }\n";
+  }
+
+  if (has_hpr_tolerance()) {
+    indent(out, indent_level + 2)
+      << "<Scalar> hpr_tolerance { " << get_hpr_tolerance() << " }\n";
+  }
+
   // Rather than calling EggGroupNode::write() to write out the
   // children, we do it directly here so we can control the order.  We
   // write out all the non-table children first, then write out the
@@ -50,6 +50,16 @@ PUBLISHED:
   INLINE const string &get_order() const;
   INLINE static const string &get_standard_order();
 
+  INLINE void set_tolerance(double tolerance);
+  INLINE void clear_tolerance();
+  INLINE bool has_tolerance() const;
+  INLINE double get_tolerance() const;
+
+  INLINE void set_hpr_tolerance(double hpr_tolerance);
+  INLINE void clear_hpr_tolerance();
+  INLINE bool has_hpr_tolerance() const;
+  INLINE double get_hpr_tolerance() const;
+
   INLINE CoordinateSystem get_coordinate_system() const;
 
   void optimize();
@@ -90,6 +100,10 @@ private:
   double _fps;
   bool _has_fps;
   string _order;
+  double _tolerance;
+  bool _has_tolerance;
+  double _hpr_tolerance;
+  bool _has_hpr_tolerance;
   CoordinateSystem _coordsys;
 
   static const string _standard_order_legacy;
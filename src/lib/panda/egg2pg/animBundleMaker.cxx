@@ -24,6 +24,7 @@
 #include "animBundle.h"
 #include "animBundleNode.h"
 #include "animChannelMatrixXfmTable.h"
+#include "animChannelMatrixCompressed.h"
 #include "animChannelScalarTable.h"
 
 ////////////////////////////////////////////////////////////////////
@@ -255,7 +256,7 @@ create_s_channel(EggSAnimData *egg_anim, const string &name,
 //  Description: Creates an AnimChannelMatrixXfmTable corresponding to
 //               the given EggNode structure, if possible.
 ////////////////////////////////////////////////////////////////////
-AnimChannelMatrixXfmTable *AnimBundleMaker::
+AnimGroup *AnimBundleMaker::
 create_xfm_channel(EggNode *egg_node, const string &name,
                    AnimGroup *parent) {
   if (egg_node->is_of_type(EggXfmAnimData::get_class_type())) {
@@ -279,17 +280,34 @@ create_xfm_channel(EggNode *egg_node, const string &name,
 //     Function: AnimBundleMaker::create_xfm_channel (EggXfmSAnim)
 //       Access: Private
 //  Description: Creates an AnimChannelMatrixXfmTable corresponding to
-//               the given EggXfmSAnim structure.
+//               the given EggXfmSAnim structure, or an
+//               AnimChannelMatrixCompressed if a tolerance has been
+//               specified for it (see egg-anim-tolerance).
 ////////////////////////////////////////////////////////////////////
-AnimChannelMatrixXfmTable *AnimBundleMaker::
+AnimGroup *AnimBundleMaker::
 create_xfm_channel(EggXfmSAnim *egg_anim, const string &name,
                    AnimGroup *parent) {
   // Ensure that the anim table is optimal and that it is standard
   // order.
   egg_anim->optimize_to_standard_order();
 
-  AnimChannelMatrixXfmTable *table
-    = new AnimChannelMatrixXfmTable(parent, name);
+  // If a tolerance has been specified, either for this table or
+  // globally, we store the table compressed.
+  double tolerance = egg_anim->has_tolerance() ?
+    egg_anim->get_tolerance() : egg_anim_tolerance.get_value();
+  double hpr_tolerance = egg_anim->has_hpr_tolerance() ?
+    egg_anim->get_hpr_tolerance() : egg_anim_hpr_tolerance.get_value();
+
+  AnimChannelMatrixXfmTable *table = NULL;
+  AnimChannelMatrixCompressed *compressed = NULL;
+  AnimGroup *channel;
+  if (tolerance > 0.0 || hpr_tolerance > 0.0) {
+    compressed = new AnimChannelMatrixCompressed(parent, name);
+    channel = compressed;
+  } else {
+    table = new AnimChannelMatrixXfmTable(parent, name);
+    channel = table;
+  }
 
   // The EggXfmSAnim structure has a number of children which are
   // EggSAnimData tables.  Each of these represents a separate
@@ -308,12 +326,14 @@ create_xfm_channel(EggXfmSAnim *egg_anim, const string &name,
         char table_id = child->get_name()[0];
 
         if (child->get_name().length() > 1 ||
-            !table->is_valid_id(table_id)) {
+            !AnimChannelMatrixXfmTable::is_valid_id(table_id)) {
           egg2pg_cat.warning()
             << "Unexpected table name " << child->get_name()
             << ", child of " << name << "\n";
 
-        } else if (table->has_table(table_id)) {
+        } else if (table != (AnimChannelMatrixXfmTable *)NULL ?
+                   table->has_table(table_id) :
+                   compressed->has_table(table_id)) {
           egg2pg_cat.warning()
             << "Duplicate table definition for " << table_id
             << " under " << name << "\n";
@@ -323,17 +343,23 @@ create_xfm_channel(EggXfmSAnim *egg_anim, const string &name,
           // Now we have to copy the table data from PTA_double to
           // PTA_float.
           PTA_float new_data=PTA_float::empty_array(child->get_num_rows(),
-                                                    table->get_class_type());
+                                                    channel->get_type());
           for (int i = 0; i < child->get_num_rows(); i++) {
             new_data[i] = (float)child->get_value(i);
           }
 
           // Now we can assign the table.
-          table->set_table(table_id, new_data);
+          if (table != (AnimChannelMatrixXfmTable *)NULL) {
+            table->set_table(table_id, new_data);
+          } else {
+            bool is_hpr = (strchr("hpr", table_id) != (char *)NULL);
+            compressed->set_table(table_id, new_data,
+                                  (float)(is_hpr ? hpr_tolerance : tolerance));
+          }
         }
       }
     }
   }
 
-  return table;
+  return channel;
 }
@@ -27,7 +27,6 @@ class AnimGroup;
 class AnimBundle;
 class AnimBundleNode;
 class AnimChannelScalarTable;
-class AnimChannelMatrixXfmTable;
 
 ////////////////////////////////////////////////////////////////////
 //       Class : AnimBundleMaker
@@ -49,10 +48,10 @@ private:
   AnimChannelScalarTable *
   create_s_channel(EggSAnimData *egg_anim, const string &name,
                    AnimGroup *parent);
-  AnimChannelMatrixXfmTable *
+  AnimGroup *
   create_xfm_channel(EggNode *egg_node, const string &name,
                      AnimGroup *parent);
-  AnimChannelMatrixXfmTable *
+  AnimGroup *
   create_xfm_channel(EggXfmSAnim *egg_anim, const string &name,
                      AnimGroup *parent);
 
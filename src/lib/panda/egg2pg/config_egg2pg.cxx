@@ -156,6 +156,27 @@ ConfigVariableBool egg_preload_simple_textures
           "fact, the egg loader will generate simple texture images if "
           "either this or preload-simple-textures is true."));
 
+ConfigVariableDouble egg_anim_tolerance
+("egg-anim-tolerance", 0.0,
+ PRC_DESC("If this or egg-anim-hpr-tolerance is greater than zero, the "
+          "egg loader stores transform "
+          "animation tables as compressed channels, made of quantized "
+          "keys at evenly-spaced frames, rather than as tables of floats.  "
+          "The value is how far each frame of the scale, shear and "
+          "translate components may stray from the original table.  "
+          "This reduces the memory used by the animation, both when it "
+          "is loaded from the egg file and from a bam file written by "
+          "egg2bam.  A table that specifies its own tolerance, for "
+          "instance via egg-optchar -ca, uses that instead."));
+
+ConfigVariableDouble egg_anim_hpr_tolerance
+("egg-anim-hpr-tolerance", 0.0,
+ PRC_DESC("This is the counterpart of egg-anim-tolerance for the hpr "
+          "components of a transform animation table, in degrees.  If "
+          "this is zero but egg-anim-tolerance is not, the hpr components "
+          "are stored losslessly, but the other components are still "
+          "compressed."));
+
 ConfigureFn(config_egg2pg) {
   init_libegg2pg();
 }
@@ -16,6 +16,7 @@
 #include "asyncTaskManager.h"
 #include "event.h"
 #include "mutexHolder.h"
+#include "lightMutexHolder.h"
 #include "indent.h"
 #include "pStatClient.h"
 #include "pStatTimer.h"
@@ -28,6 +29,8 @@ TypeHandle AsyncTaskChain::_type_handle;
 
 PStatCollector AsyncTaskChain::_task_pcollector("Task");
 PStatCollector AsyncTaskChain::_wait_pcollector("Wait");
+PStatCollector AsyncTaskChain::_steal_pcollector("Task steals");
+PStatCollector AsyncTaskChain::_queue_depth_pcollector("Task queue depth");
 
 ////////////////////////////////////////////////////////////////////
 //     Function: AsyncTaskChain::Constructor
@@ -41,6 +44,7 @@ AsyncTaskChain(AsyncTaskManager *manager, const string &name) :
   _cvar(manager->_lock),
   _tick_clock(false),
   _timeslice_priority(false),
+  _work_stealing(task_work_stealing),
   _num_threads(0),
   _thread_priority(TP_normal),
   _frame_budget(-1.0),
@@ -51,7 +55,10 @@ AsyncTaskChain(AsyncTaskManager *manager, const string &name) :
   _pickup_mode(false),
   _needs_cleanup(false),
   _current_frame(0),
-  _time_in_frame(0.0)
+  _time_in_frame(0.0),
+  _num_queued(0),
+  _num_steals(0),
+  _submitted(NULL)
 {
 }
 
@@ -69,6 +76,7 @@ AsyncTaskChain::
     MutexHolder holder(_manager->_lock);
     do_cleanup();
   }
+  clear_submissions();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -261,6 +269,60 @@ get_timeslice_priority() const {
   return _timeslice_priority;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::set_work_stealing
+//       Access: Published
+//  Description: Sets the work_stealing flag.  This changes the way
+//               the threads of this chain pick up their tasks; it
+//               has no effect on a chain with no threads.
+//
+//               When this flag is false, each thread takes the next
+//               task from the shared task list, under the task
+//               manager's lock, one at a time.
+//
+//               When it is true, all of the tasks with the current
+//               sort value are dealt out among the threads at once,
+//               in priority order, when that sort value begins.
+//               Each thread then runs through its own share without
+//               taking the manager's lock, and when it runs out, it
+//               steals the lowest-priority remaining tasks from
+//               another thread.  The threads return the tasks to the
+//               task lists together when they are done.  Tasks with
+//               different sort values are still never run in
+//               parallel, but the frame budget is checked only
+//               between sort values, and stop_threads() will wait
+//               for the current sort value to finish.
+//
+//               This is a good choice for a chain with many short
+//               tasks and several threads.  The default is set by
+//               the task-work-stealing config variable.  Changing
+//               it restarts the threads.
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+set_work_stealing(bool work_stealing) {
+  MutexHolder holder(_manager->_lock);
+  if (_work_stealing != work_stealing) {
+    do_stop_threads();
+    _work_stealing = work_stealing;
+
+    if (_num_tasks != 0) {
+      do_start_threads();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::get_work_stealing
+//       Access: Published
+//  Description: Returns the work_stealing flag.  See
+//               set_work_stealing().
+////////////////////////////////////////////////////////////////////
+bool AsyncTaskChain::
+get_work_stealing() const {
+  MutexHolder holder(_manager->_lock);
+  return _work_stealing;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: AsyncTaskChain::stop_threads
 //       Access: Published
@@ -317,6 +379,45 @@ has_task(AsyncTask *task) const {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::submit
+//       Access: Published
+//  Description: Queues the indicated task to be added to this chain,
+//               without waiting for the task manager's lock.  This
+//               may be called from any thread, and is intended for
+//               code that spawns many small tasks at once.
+//
+//               The task is not added immediately; it is added by
+//               the chain's threads (or by poll()) at the next
+//               boundary between sort values, exactly as if
+//               AsyncTaskManager::add() had been called at that
+//               time, and has_task() will not return true until
+//               then.  The task's chain name is changed to this
+//               chain.  The task must not already be added to a task
+//               manager, nor submitted twice.
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+submit(AsyncTask *task) {
+  nassertv(task != (AsyncTask *)NULL);
+  SubmittedTask *submitted = new SubmittedTask;
+  submitted->_task = task;
+
+  void *old_head;
+  do {
+    old_head = AtomicAdjust::get_ptr(_submitted);
+    submitted->_next = (SubmittedTask *)old_head;
+  } while (AtomicAdjust::compare_and_exchange_ptr(_submitted, old_head, submitted) != old_head);
+
+  if (old_head == NULL) {
+    // This is the first task submitted since the list was last
+    // drained, so the threads might all be asleep.  Wake them up.
+    // Subsequent submissions before the next drain needn't bother.
+    MutexHolder holder(_manager->_lock);
+    do_start_threads();
+    _cvar.notify_all();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: AsyncTaskChain::wait_for_tasks
 //       Access: Published
@@ -565,6 +666,7 @@ do_remove(AsyncTask *task) {
 ////////////////////////////////////////////////////////////////////
 void AsyncTaskChain::
 do_wait_for_tasks() {
+  drain_submissions();
   do_start_threads();
 
   if (_threads.empty()) {
@@ -733,73 +835,239 @@ service_one_task(AsyncTaskChain::AsyncTaskChainThread *thread) {
     }
     task->_servicing_thread = NULL;
 
-    if (task->_chain == this) {
-      if (task->_state == AsyncTask::S_servicing_removed) {
-        // This task wants to kill itself.
-        cleanup_task(task, true, false);
+    finish_task(task, ds);
 
-      } else if (task->_chain_name != get_name()) {
-        // The task wants to jump to a different chain.
-        PT(AsyncTask) hold_task = task;
-        cleanup_task(task, false, false);
-        task->jump_to_task_chain(_manager);
+    if (task_cat.is_spam()) {
+      task_cat.spam()
+        << "Done servicing " << *task << " in "
+        << *Thread::get_current_thread() << "\n";
+    }
+  }
+}
 
-      } else {
-        switch (ds) {
-        case AsyncTask::DS_cont:
-          // The task is still alive; put it on the next frame's active
-          // queue.
-          task->_state = AsyncTask::S_active;
-          _next_active.push_back(task);
-          _cvar.notify_all();
-          break;
-          
-        case AsyncTask::DS_again:
-          // The task wants to sleep again.
-          {
-            double now = _manager->_clock->get_frame_time();
-            task->_wake_time = now + task->get_delay();
-            task->_start_time = task->_wake_time;
-            task->_state = AsyncTask::S_sleeping;
-            _sleeping.push_back(task);
-            push_heap(_sleeping.begin(), _sleeping.end(), AsyncTaskSortWakeTime());
-            if (task_cat.is_spam()) {
-              task_cat.spam()
-                << "Sleeping " << *task << ", wake time at " 
-                << task->_wake_time - now << "\n";
-            }
-            _cvar.notify_all();
-          }
-          break;
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::finish_task
+//       Access: Protected
+//  Description: Called after a task has been serviced, to return it
+//               to the appropriate task list according to its
+//               DoneStatus, or to clean it up.  The caller is
+//               responsible for notifying _cvar afterwards.  Assumes
+//               the lock is already held.
+//
+//               Note that the lock may be temporarily released by
+//               this method.
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+finish_task(AsyncTask *task, AsyncTask::DoneStatus ds) {
+  if (task->_chain == this) {
+    if (task->_state == AsyncTask::S_servicing_removed) {
+      // This task wants to kill itself.
+      cleanup_task(task, true, false);
+
+    } else if (task->_chain_name != get_name()) {
+      // The task wants to jump to a different chain.
+      PT(AsyncTask) hold_task = task;
+      cleanup_task(task, false, false);
+      task->jump_to_task_chain(_manager);
 
-        case AsyncTask::DS_pickup:
-          // The task wants to run again this frame if possible.
-          task->_state = AsyncTask::S_active;
-          _this_active.push_back(task);
-          _cvar.notify_all();
-          break;
-
-        case AsyncTask::DS_interrupt:
-          // The task had an exception and wants to raise a big flag.
-          task->_state = AsyncTask::S_active;
-          _next_active.push_back(task);
-          if (_state == S_started) {
-            _state = S_interrupted;
-            _cvar.notify_all();
+    } else {
+      switch (ds) {
+      case AsyncTask::DS_cont:
+        // The task is still alive; put it on the next frame's active
+        // queue.
+        task->_state = AsyncTask::S_active;
+        _next_active.push_back(task);
+        break;
+        
+      case AsyncTask::DS_again:
+        // The task wants to sleep again.
+        {
+          double now = _manager->_clock->get_frame_time();
+          task->_wake_time = now + task->get_delay();
+          task->_start_time = task->_wake_time;
+          task->_state = AsyncTask::S_sleeping;
+          _sleeping.push_back(task);
+          push_heap(_sleeping.begin(), _sleeping.end(), AsyncTaskSortWakeTime());
+          if (task_cat.is_spam()) {
+            task_cat.spam()
+              << "Sleeping " << *task << ", wake time at " 
+              << task->_wake_time - now << "\n";
           }
-          break;
-          
-        default:
-          // The task has finished.
-          cleanup_task(task, true, true);
         }
+        break;
+
+      case AsyncTask::DS_pickup:
+        // The task wants to run again this frame if possible.
+        task->_state = AsyncTask::S_active;
+        _this_active.push_back(task);
+        break;
+
+      case AsyncTask::DS_interrupt:
+        // The task had an exception and wants to raise a big flag.
+        task->_state = AsyncTask::S_active;
+        _next_active.push_back(task);
+        if (_state == S_started) {
+          _state = S_interrupted;
+          _cvar.notify_all();
+        }
+        break;
+        
+      default:
+        // The task has finished.
+        cleanup_task(task, true, true);
       }
-    } else {
-      task_cat.error()
-        << "Task is no longer on chain " << get_name() 
-        << ": " << *task << "\n";
+    }
+  } else {
+    task_cat.error()
+      << "Task is no longer on chain " << get_name() 
+      << ": " << *task << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::distribute_sort_group
+//       Access: Protected
+//  Description: Called in work-stealing mode when a new sort value
+//               begins, to pull all of the tasks with the current
+//               sort value off the active queue and deal them out
+//               among the threads' queues.  Since the tasks come off
+//               the heap in priority order, and are dealt out
+//               round-robin, each thread's queue is also in priority
+//               order.  Assumes the lock is held, and that no
+//               threads are busy.
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+distribute_sort_group() {
+  nassertv(_num_busy_threads == 0 && !_threads.empty());
+  nassertv(AtomicAdjust::get(_num_queued) == 0);
+
+  _queued.clear();
+  while (!_active.empty() && _active.front()->get_sort() == _current_sort) {
+    PT(AsyncTask) task = _active.front();
+    pop_heap(_active.begin(), _active.end(), AsyncTaskSortPriority());
+    _active.pop_back();
+    _queued.push_back(task);
+  }
+
+  int num_threads = (int)_threads.size();
+  int num_queued = (int)_queued.size();
+  for (int i = 0; i < num_queued; ++i) {
+    AsyncTask *task = _queued[i];
+    nassertv(task->_state == AsyncTask::S_active);
+
+    // From here until the thread returns it to the task lists, the
+    // task is considered to be in service, so that remove() and
+    // set_task_chain() will defer to finish_task().
+    AsyncTaskChainThread *thread = _threads[i % num_threads];
+    task->_state = AsyncTask::S_servicing;
+    task->_servicing_thread = thread;
+
+    LightMutexHolder holder(thread->_queue_lock);
+    thread->_queue.push_back(task);
+  }
+
+  if (task_cat.is_spam()) {
+    do_output(task_cat.spam());
+    task_cat.spam(false)
+      << ": distributed " << num_queued << " tasks with sort "
+      << _current_sort << "\n";
+  }
+
+  _queue_depth_pcollector.set_level((num_queued + num_threads - 1) / num_threads);
+  AtomicAdjust::set(_num_queued, num_queued);
+  _cvar.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::service_queued_tasks
+//       Access: Protected
+//  Description: Called in work-stealing mode by each thread to run
+//               the tasks on its own queue, and then any tasks it can
+//               steal from the other threads' queues, until there is
+//               nothing left of the current sort group.  The lock
+//               must *not* be held.
+//
+//               The results are recorded in thread->_finished, to be
+//               processed later by finish_queued_tasks().
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+service_queued_tasks(AsyncTaskChain::AsyncTaskChainThread *thread) {
+  ClockObject *clock = _manager->get_clock();
+
+  while (true) {
+    PT(AsyncTask) task = thread->pop_queued_task();
+    if (task == (AsyncTask *)NULL) {
+      task = thread->steal_queued_task();
+      if (task == (AsyncTask *)NULL) {
+        return;
+      }
+    }
+    AtomicAdjust::dec(_num_queued);
+
+    AsyncTaskChainThread::FinishedTask finished;
+    finished._task = task;
+    finished._dt = 0.0;
+
+    if (task->_state == AsyncTask::S_servicing_removed) {
+      // The task was removed while it was waiting on the queue; don't
+      // run it.  We peek at the state without the lock, but at worst
+      // a task removed at this very moment gets to run one last time,
+      // just as if it had been removed while it was being serviced.
+      finished._status = AsyncTask::DS_done;
+      thread->_finished.push_back(finished);
+      continue;
     }
 
+    if (task_cat.is_spam()) {
+      task_cat.spam()
+        << "Servicing " << *task << " in "
+        << *Thread::get_current_thread() << "\n";
+    }
+
+    // This is the equivalent of AsyncTask::unlock_and_do_task(),
+    // except that the bookkeeping is left for finish_queued_tasks().
+    double start = clock->get_real_time();
+    task->_task_pcollector.start();
+    AsyncTask::DoneStatus ds = task->do_task();
+    task->_task_pcollector.stop();
+    double end = clock->get_real_time();
+
+    finished._status = ds;
+    finished._dt = end - start;
+    thread->_finished.push_back(finished);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::finish_queued_tasks
+//       Access: Protected
+//  Description: Called in work-stealing mode by each thread after
+//               service_queued_tasks() returns, to return all of the
+//               tasks it ran to the appropriate task lists.  Assumes
+//               the lock is held.
+//
+//               Note that the lock may be temporarily released by
+//               this method.
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+finish_queued_tasks(AsyncTaskChain::AsyncTaskChainThread *thread) {
+  _num_steals += thread->_num_steals;
+  thread->_num_steals = 0;
+
+  AsyncTaskChainThread::FinishedTasks finished;
+  finished.swap(thread->_finished);
+
+  AsyncTaskChainThread::FinishedTasks::iterator fi;
+  for (fi = finished.begin(); fi != finished.end(); ++fi) {
+    AsyncTask *task = (*fi)._task;
+    task->_servicing_thread = NULL;
+    task->_dt = (*fi)._dt;
+    task->_max_dt = max(task->_dt, task->_max_dt);
+    task->_total_dt += task->_dt;
+    _time_in_frame += task->_dt;
+
+    finish_task(task, (*fi)._status);
+
     if (task_cat.is_spam()) {
       task_cat.spam()
         << "Done servicing " << *task << " in "
@@ -808,6 +1076,66 @@ service_one_task(AsyncTaskChain::AsyncTaskChainThread *thread) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::drain_submissions
+//       Access: Protected
+//  Description: Adds all of the tasks that have been passed to
+//               submit() since the last call.  This is called at the
+//               boundary between sort values.  Assumes the lock is
+//               held.
+//
+//               Note that the lock is temporarily released by this
+//               method, if there are any tasks to add; the chain is
+//               marked busy in the meantime, so that no other thread
+//               will move on to the next sort value.
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+drain_submissions() {
+  if (AtomicAdjust::get_ptr(_submitted) == NULL) {
+    return;
+  }
+  SubmittedTask *head = (SubmittedTask *)AtomicAdjust::set_ptr(_submitted, NULL);
+
+  // The list is in reverse order of submission; put it right.
+  TaskHeap tasks;
+  while (head != (SubmittedTask *)NULL) {
+    tasks.push_back(head->_task);
+    SubmittedTask *next = head->_next;
+    delete head;
+    head = next;
+  }
+  reverse(tasks.begin(), tasks.end());
+
+  _num_busy_threads++;
+  _manager->_lock.release();
+  TaskHeap::iterator ti;
+  for (ti = tasks.begin(); ti != tasks.end(); ++ti) {
+    AsyncTask *task = (*ti);
+    task->set_task_chain(get_name());
+    _manager->add(task);
+  }
+  _manager->_lock.acquire();
+  _num_busy_threads--;
+  _cvar.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::clear_submissions
+//       Access: Protected
+//  Description: Discards any tasks that have been passed to submit()
+//               but not yet added.  This is called only on
+//               destruction.
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::
+clear_submissions() {
+  SubmittedTask *head = (SubmittedTask *)AtomicAdjust::set_ptr(_submitted, NULL);
+  while (head != (SubmittedTask *)NULL) {
+    SubmittedTask *next = head->_next;
+    delete head;
+    head = next;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: AsyncTaskChain::cleanup_task
 //       Access: Protected
@@ -971,6 +1299,12 @@ finish_sort_group() {
 
   _current_sort = -INT_MAX;
 
+  if (_work_stealing && !_threads.empty()) {
+    // Report the number of tasks that changed threads this epoch.
+    _steal_pcollector.set_level(_num_steals);
+    _num_steals = 0;
+  }
+
   if (!_active.empty()) {
     // Signal the threads to start executing the first task again.
     _cvar.notify_all();
@@ -1106,6 +1440,7 @@ do_stop_threads() {
     _manager->_lock.acquire();
     
     _state = S_initial;
+    _queued.clear();
 
     // There might be one busy "thread" still: the main thread.
     nassertv(_num_busy_threads == 0 || _num_busy_threads == 1);
@@ -1138,11 +1473,23 @@ do_start_threads() {
       for (int i = 0; i < _num_threads; ++i) {
         ostringstream strm;
         strm << _manager->get_name() << "_" << get_name() << "_" << i;
-        PT(AsyncTaskChainThread) thread = new AsyncTaskChainThread(strm.str(), this);
+        PT(AsyncTaskChainThread) thread = new AsyncTaskChainThread(strm.str(), this, (int)_threads.size());
         if (thread->start(_thread_priority, true)) {
           _threads.push_back(thread);
         }
       }
+
+      // Each thread keeps its own list of the others to steal from,
+      // since it walks the list without holding the lock.  This is
+      // safe because none of the threads can proceed until we
+      // release the lock.
+      Threads::iterator ti;
+      for (ti = _threads.begin(); ti != _threads.end(); ++ti) {
+        Threads::iterator pi;
+        for (pi = _threads.begin(); pi != _threads.end(); ++pi) {
+          (*ti)->_peers.push_back(*pi);
+        }
+      }
     }
   }
 }
@@ -1166,6 +1513,16 @@ do_get_active_tasks() const {
     }
   }
   TaskHeap::const_iterator ti;
+  for (ti = _queued.begin(); ti != _queued.end(); ++ti) {
+    // In work-stealing mode, the tasks of the current sort group are
+    // in service until they have been returned to the task lists.
+    AsyncTask *task = (*ti);
+    if (task->_chain == this &&
+        (task->_state == AsyncTask::S_servicing ||
+         task->_state == AsyncTask::S_servicing_removed)) {
+      result.add_task(task);
+    }
+  }
   for (ti = _active.begin(); ti != _active.end(); ++ti) {
     AsyncTask *task = (*ti);
     result.add_task(task);
@@ -1210,6 +1567,7 @@ do_get_sleeping_tasks() const {
 ////////////////////////////////////////////////////////////////////
 void AsyncTaskChain::
 do_poll() {
+  drain_submissions();
   if (_num_tasks == 0) {
     return;
   }
@@ -1357,6 +1715,15 @@ do_write(ostream &out, int indent_level) const {
       tasks.push_back(task);
     }
   }
+  TaskHeap::const_iterator qi;
+  for (qi = _queued.begin(); qi != _queued.end(); ++qi) {
+    AsyncTask *task = (*qi);
+    if (task->_chain == this &&
+        (task->_state == AsyncTask::S_servicing ||
+         task->_state == AsyncTask::S_servicing_removed)) {
+      tasks.push_back(task);
+    }
+  }
 
   double now = _manager->_clock->get_frame_time();
 
@@ -1447,10 +1814,13 @@ write_task_line(ostream &out, int indent_level, AsyncTask *task, double now) con
 //  Description: 
 ////////////////////////////////////////////////////////////////////
 AsyncTaskChain::AsyncTaskChainThread::
-AsyncTaskChainThread(const string &name, AsyncTaskChain *chain) :
+AsyncTaskChainThread(const string &name, AsyncTaskChain *chain,
+                     int index) :
   Thread(name, chain->get_name()),
   _chain(chain),
-  _servicing(NULL)
+  _servicing(NULL),
+  _index(index),
+  _num_steals(0)
 {
 }
 
@@ -1461,6 +1831,11 @@ AsyncTaskChainThread(const string &name, AsyncTaskChain *chain) :
 ////////////////////////////////////////////////////////////////////
 void AsyncTaskChain::AsyncTaskChainThread::
 thread_main() {
+  if (_chain->_work_stealing) {
+    work_stealing_main();
+    return;
+  }
+
   MutexHolder holder(_chain->_manager->_lock);
   while (_chain->_state != S_shutdown && _chain->_state != S_interrupted) {
     thread_consider_yield();
@@ -1501,7 +1876,16 @@ thread_main() {
       // value.  We can't pick up a new task until all of the threads
       // finish the tasks with the same sort value.
       if (_chain->_num_busy_threads == 0) {
-        // We're the last thread to finish.  Update _current_sort.
+        // We're the last thread to finish.  Pick up any submitted
+        // tasks, then update _current_sort.
+        _chain->drain_submissions();
+        if (_chain->_num_busy_threads != 0 ||
+            (!_chain->_active.empty() &&
+             _chain->_active.front()->get_sort() == _chain->_current_sort)) {
+          // Another thread got in while we were adding them, or one
+          // of them belongs to the current sort group.
+          continue;
+        }
         if (!_chain->finish_sort_group()) {
           // Nothing to do.  Wait for more tasks to be added.
           if (_chain->_sleeping.empty()) {
@@ -1526,3 +1910,130 @@ thread_main() {
   }
 }
 
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::AsyncTaskChainThread::work_stealing_main
+//       Access: Public
+//  Description: The body of thread_main() when the chain is in
+//               work-stealing mode.  See set_work_stealing().
+////////////////////////////////////////////////////////////////////
+void AsyncTaskChain::AsyncTaskChainThread::
+work_stealing_main() {
+  MutexHolder holder(_chain->_manager->_lock);
+  while (_chain->_state != S_shutdown && _chain->_state != S_interrupted) {
+    thread_consider_yield();
+    if (AtomicAdjust::get(_chain->_num_queued) != 0) {
+      // There are still tasks of the current sort group waiting on
+      // the queues.  Go and run them, without the lock.
+      PStatTimer timer(_task_pcollector);
+      _chain->_num_busy_threads++;
+      _chain->_manager->_lock.release();
+      _chain->service_queued_tasks(this);
+      _chain->_manager->_lock.acquire();
+      _chain->finish_queued_tasks(this);
+      _chain->_num_busy_threads--;
+      if (_chain->_num_busy_threads == 0) {
+        _chain->_cvar.notify_all();
+      }
+
+    } else if (_chain->_num_busy_threads == 0) {
+      // We're the last thread to finish the current sort group.  Pick
+      // up any submitted tasks, then start the next one.
+      _chain->_queued.clear();
+      _chain->drain_submissions();
+      if (_chain->_num_busy_threads != 0) {
+        continue;
+      }
+
+      if (!_chain->_active.empty() &&
+          _chain->_active.front()->get_sort() == _chain->_current_sort) {
+        int frame = _chain->_manager->_clock->get_frame_count();
+        if (_chain->_current_frame != frame) {
+          _chain->_current_frame = frame;
+          _chain->_time_in_frame = 0.0;
+        }
+
+        // If we've exceeded our frame budget, sleep until the next
+        // frame.
+        if (_chain->_frame_budget >= 0.0 && _chain->_time_in_frame >= _chain->_frame_budget) {
+          while (_chain->_frame_budget >= 0.0 && _chain->_time_in_frame >= _chain->_frame_budget &&
+                 _chain->_state != S_shutdown && _chain->_state != S_interrupted) {
+            _chain->cleanup_pickup_mode();
+            _chain->_manager->_frame_cvar.wait();
+            frame = _chain->_manager->_clock->get_frame_count();
+            if (_chain->_current_frame != frame) {
+              _chain->_current_frame = frame;
+              _chain->_time_in_frame = 0.0;
+            }
+          }
+          continue;
+        }
+
+        _chain->distribute_sort_group();
+
+      } else if (!_chain->finish_sort_group()) {
+        // Nothing to do.  Wait for more tasks to be added.
+        if (_chain->_sleeping.empty()) {
+          PStatTimer timer(_wait_pcollector);
+          _chain->_cvar.wait();
+        } else {
+          double wake_time = _chain->do_get_next_wake_time();
+          double now = _chain->_manager->_clock->get_frame_time();
+          double timeout = max(wake_time - now, 0.0);
+          PStatTimer timer(_wait_pcollector);
+          _chain->_cvar.wait(timeout);
+        }
+      }
+
+    } else {
+      // Wait for the other threads to finish their share of the
+      // current sort group before we continue.
+      PStatTimer timer(_wait_pcollector);
+      _chain->_cvar.wait();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::AsyncTaskChainThread::pop_queued_task
+//       Access: Public
+//  Description: Removes and returns the highest-priority task from
+//               this thread's own queue, or NULL if the queue is
+//               empty.
+////////////////////////////////////////////////////////////////////
+PT(AsyncTask) AsyncTaskChain::AsyncTaskChainThread::
+pop_queued_task() {
+  LightMutexHolder holder(_queue_lock);
+  if (_queue.empty()) {
+    return NULL;
+  }
+  PT(AsyncTask) task = _queue.front();
+  _queue.pop_front();
+  return task;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: AsyncTaskChain::AsyncTaskChainThread::steal_queued_task
+//       Access: Public
+//  Description: Removes and returns the lowest-priority task from
+//               the queue of one of the other threads, or NULL if all
+//               of the queues are empty.  The threads are visited
+//               starting with the one after this one, so that
+//               several idle threads don't all converge on the same
+//               victim.
+////////////////////////////////////////////////////////////////////
+PT(AsyncTask) AsyncTaskChain::AsyncTaskChainThread::
+steal_queued_task() {
+  int num_peers = (int)_peers.size();
+  for (int i = 1; i < num_peers; ++i) {
+    AsyncTaskChainThread *victim = _peers[(_index + i) % num_peers];
+    LightMutexHolder holder(victim->_queue_lock);
+    if (!victim->_queue.empty()) {
+      PT(AsyncTask) task = victim->_queue.back();
+      victim->_queue.pop_back();
+      ++_num_steals;
+      return task;
+    }
+  }
+  return NULL;
+}
@@ -22,6 +22,8 @@
 #include "typedReferenceCount.h"
 #include "thread.h"
 #include "conditionVarFull.h"
+#include "lightMutex.h"
+#include "atomicAdjust.h"
 #include "pvector.h"
 #include "pdeque.h"
 #include "pStatCollector.h"
@@ -53,6 +55,13 @@ class AsyncTaskManager;
 //               never run in parallel together, but tasks with
 //               different priority values might be (if there is more
 //               than one thread).
+//
+//               If work stealing is enabled, the tasks of each sort
+//               value are dealt out among the threads all at once,
+//               and each thread then runs through its own share
+//               without touching the shared task lists, taking work
+//               from the other threads when it runs out.  See
+//               set_work_stealing().
 ////////////////////////////////////////////////////////////////////
 class EXPCL_PANDA_EVENT AsyncTaskChain : public TypedReferenceCount, public Namable {
 public:
@@ -76,11 +85,15 @@ PUBLISHED:
   void set_timeslice_priority(bool timeslice_priority);
   bool get_timeslice_priority() const;
 
+  BLOCKING void set_work_stealing(bool work_stealing);
+  bool get_work_stealing() const;
+
   BLOCKING void stop_threads();
   void start_threads();
   INLINE bool is_started() const;
 
   bool has_task(AsyncTask *task) const;
+  void submit(AsyncTask *task);
 
   BLOCKING void wait_for_tasks();
 
@@ -108,6 +121,12 @@ protected:
   int find_task_on_heap(const TaskHeap &heap, AsyncTask *task) const;
 
   void service_one_task(AsyncTaskChainThread *thread);
+  void finish_task(AsyncTask *task, AsyncTask::DoneStatus ds);
+  void distribute_sort_group();
+  void service_queued_tasks(AsyncTaskChainThread *thread);
+  void finish_queued_tasks(AsyncTaskChainThread *thread);
+  void drain_submissions();
+  void clear_submissions();
   void cleanup_task(AsyncTask *task, bool upon_death, bool clean_exit);
   bool finish_sort_group();
   void filter_timeslice_priority();
@@ -127,11 +146,49 @@ protected:
 protected:
   class AsyncTaskChainThread : public Thread {
   public:
-    AsyncTaskChainThread(const string &name, AsyncTaskChain *chain);
+    AsyncTaskChainThread(const string &name, AsyncTaskChain *chain,
+                         int index);
     virtual void thread_main();
+    void work_stealing_main();
+
+    PT(AsyncTask) pop_queued_task();
+    PT(AsyncTask) steal_queued_task();
 
     AsyncTaskChain *_chain;
     AsyncTask *_servicing;
+
+    // The remaining members are used only in work-stealing mode.
+    // The queue holds this thread's share of the current sort group,
+    // in priority order; the owning thread takes from the front, and
+    // other threads steal from the back.
+    typedef pdeque< PT(AsyncTask) > Queue;
+    int _index;
+    LightMutex _queue_lock;
+    Queue _queue;
+
+    // The tasks this thread has run, waiting to be returned to the
+    // task lists under the manager's lock.  This is touched only by
+    // the owning thread.
+    class FinishedTask {
+    public:
+      PT(AsyncTask) _task;
+      AsyncTask::DoneStatus _status;
+      double _dt;
+    };
+    typedef pvector<FinishedTask> FinishedTasks;
+    FinishedTasks _finished;
+    int _num_steals;
+
+    typedef pvector<AsyncTaskChainThread *> Peers;
+    Peers _peers;
+  };
+
+  // A task passed to submit(), waiting to be added at the next sort
+  // group boundary.
+  class SubmittedTask {
+  public:
+    PT(AsyncTask) _task;
+    SubmittedTask *_next;
   };
 
   class AsyncTaskSortWakeTime {
@@ -169,6 +226,7 @@ protected:
 
   bool _tick_clock;
   bool _timeslice_priority;
+  bool _work_stealing;
   int _num_threads;
   ThreadPriority _thread_priority;
   Threads _threads;
@@ -186,9 +244,21 @@ protected:
 
   int _current_frame;
   double _time_in_frame;
+
+  // The tasks of the current sort group that have been dealt out to
+  // the thread queues in work-stealing mode, and the number of those
+  // that have not yet been picked up by a thread.
+  TaskHeap _queued;
+  TVOLATILE AtomicAdjust::Integer _num_queued;
+  int _num_steals;
+
+  // A lock-free stack of SubmittedTask objects.
+  void * TVOLATILE _submitted;
   
   static PStatCollector _task_pcollector;
   static PStatCollector _wait_pcollector;
+  static PStatCollector _steal_pcollector;
+  static PStatCollector _queue_depth_pcollector;
 
 public:
   static TypeHandle get_class_type() {
@@ -32,6 +32,16 @@ Configure(config_event);
 NotifyCategoryDef(event, "");
 NotifyCategoryDef(task, "");
 
+ConfigVariableBool task_work_stealing
+("task-work-stealing", false,
+ PRC_DESC("Set this true to make new AsyncTaskChains use work stealing "
+          "by default: the tasks of each sort value are dealt out among "
+          "the chain's threads all at once, and each thread runs its "
+          "own share without the task manager's lock, taking work from "
+          "the other threads when it runs out.  This reduces lock "
+          "contention on chains with many short tasks and several "
+          "threads.  See AsyncTaskChain::set_work_stealing()."));
+
 ConfigureFn(config_event) {
   AsyncTask::init_type();
   AsyncTaskChain::init_type();
@@ -18,8 +18,11 @@
 #include "pandabase.h"
 
 #include "notifyCategoryProxy.h"
+#include "configVariableBool.h"
 
 NotifyCategoryDecl(event, EXPCL_PANDA_EVENT, EXPTP_PANDA_EVENT);
 NotifyCategoryDecl(task, EXPCL_PANDA_EVENT, EXPTP_PANDA_EVENT);
 
+extern EXPCL_PANDA_EVENT ConfigVariableBool task_work_stealing;
+
 #endif
@@ -55,3 +55,54 @@ streampos DatagramGenerator::
 get_file_pos() {
   return 0;
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramGenerator::supports_raw_data
+//       Access: Public, Virtual
+//  Description: Returns true if this generator can also return
+//               unframed bytes between datagrams, via get_raw_data()
+//               and skip_raw_data(), or false if it only deals in
+//               whole datagrams.
+////////////////////////////////////////////////////////////////////
+bool DatagramGenerator::
+supports_raw_data() {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramGenerator::get_raw_pos
+//       Access: Public, Virtual
+//  Description: Returns the number of bytes consumed from the source
+//               so far, including the length prefix of each datagram
+//               and any raw data.  This is only meaningful if
+//               supports_raw_data() returns true.
+////////////////////////////////////////////////////////////////////
+streamoff DatagramGenerator::
+get_raw_pos() {
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramGenerator::get_raw_data
+//       Access: Public, Virtual
+//  Description: Reads the indicated number of bytes, which were
+//               written with DatagramSink::put_raw_data(), into the
+//               buffer.  Returns true on success, false on failure or
+//               if raw data is not supported.
+////////////////////////////////////////////////////////////////////
+bool DatagramGenerator::
+get_raw_data(unsigned char *, size_t) {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramGenerator::skip_raw_data
+//       Access: Public, Virtual
+//  Description: Skips over the indicated number of raw bytes without
+//               reading them, if possible.  Returns true on success,
+//               false on failure or if raw data is not supported.
+////////////////////////////////////////////////////////////////////
+bool DatagramGenerator::
+skip_raw_data(size_t) {
+  return false;
+}
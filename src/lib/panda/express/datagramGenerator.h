@@ -38,6 +38,12 @@ PUBLISHED:
 
   virtual VirtualFile *get_file();
   virtual streampos get_file_pos();
+
+public:
+  virtual bool supports_raw_data();
+  virtual streamoff get_raw_pos();
+  virtual bool get_raw_data(unsigned char *buffer, size_t size);
+  virtual bool skip_raw_data(size_t size);
 };
 
 #include "datagramGenerator.I"
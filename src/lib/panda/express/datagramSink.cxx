@@ -22,3 +22,43 @@
 ////////////////////////////////////////////////////////////////////
 DatagramSink::~DatagramSink(){
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramSink::supports_raw_data
+//       Access: Public, Virtual
+//  Description: Returns true if this sink can also write unframed
+//               bytes between datagrams, via put_raw_data(), or false
+//               if it only deals in whole datagrams.
+////////////////////////////////////////////////////////////////////
+bool DatagramSink::
+supports_raw_data() {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramSink::get_raw_pos
+//       Access: Public, Virtual
+//  Description: Returns the number of bytes written to the sink so
+//               far, including the length prefix of each datagram
+//               and any raw data.  This is only meaningful if
+//               supports_raw_data() returns true.
+////////////////////////////////////////////////////////////////////
+streamoff DatagramSink::
+get_raw_pos() {
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramSink::put_raw_data
+//       Access: Public, Virtual
+//  Description: Writes the indicated bytes to the sink as-is, with no
+//               datagram framing.  The reader must know how many
+//               bytes to expect; see
+//               DatagramGenerator::get_raw_data().  Returns true on
+//               success, false on failure or if raw data is not
+//               supported.
+////////////////////////////////////////////////////////////////////
+bool DatagramSink::
+put_raw_data(const unsigned char *, size_t) {
+  return false;
+}
@@ -32,6 +32,11 @@ PUBLISHED:
 
   virtual bool put_datagram(const Datagram &data) = 0;
   virtual bool is_error() = 0;
+
+public:
+  virtual bool supports_raw_data();
+  virtual streamoff get_raw_pos();
+  virtual bool put_raw_data(const unsigned char *data, size_t size);
 };
 
 #include "datagramSink.I"
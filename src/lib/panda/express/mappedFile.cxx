@@ -0,0 +1,167 @@
+// Filename: mappedFile.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "mappedFile.h"
+#include "virtualFileSimple.h"
+#include "virtualFileMountSystem.h"
+#include "config_express.h"
+#include "dcast.h"
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // WIN32
+
+////////////////////////////////////////////////////////////////////
+//     Function: MappedFile::Constructor
+//       Access: Private
+//  Description: Use map_file() or map_virtual_file() to create a
+//               MappedFile.
+////////////////////////////////////////////////////////////////////
+MappedFile::
+MappedFile(const Filename &filename, const unsigned char *data,
+           size_t size) :
+  _filename(filename),
+  _data(data),
+  _size(size)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: MappedFile::Destructor
+//       Access: Published
+//  Description: Unmaps the file.
+////////////////////////////////////////////////////////////////////
+MappedFile::
+~MappedFile() {
+#ifdef WIN32
+  UnmapViewOfFile((LPCVOID)_data);
+#else
+  munmap((void *)_data, _size);
+#endif  // WIN32
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: MappedFile::map_file
+//       Access: Published, Static
+//  Description: Maps the indicated file from the OS filesystem
+//               read-only into memory.  Returns NULL if the file
+//               cannot be opened or mapped, or if it is empty.
+////////////////////////////////////////////////////////////////////
+PT(MappedFile) MappedFile::
+map_file(const Filename &filename) {
+  string os_specific = filename.to_os_specific();
+
+#ifdef WIN32
+  HANDLE file = CreateFile(os_specific.c_str(), GENERIC_READ,
+                           FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return NULL;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 ||
+      (ULONGLONG)file_size.QuadPart > (ULONGLONG)(size_t)-1) {
+    CloseHandle(file);
+    return NULL;
+  }
+
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (mapping == NULL) {
+    return NULL;
+  }
+
+  // The view keeps its own reference to the mapping object.
+  LPVOID data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == NULL) {
+    express_cat.warning()
+      << "Unable to map " << filename << "\n";
+    return NULL;
+  }
+  size_t size = (size_t)file_size.QuadPart;
+
+#else
+  int fd = open(os_specific.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+      (unsigned long long)st.st_size > (unsigned long long)(size_t)-1) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = (size_t)st.st_size;
+
+  // The mapping stays valid after the descriptor is closed.
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    express_cat.warning()
+      << "Unable to map " << filename << "\n";
+    return NULL;
+  }
+#endif  // WIN32
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped " << size << " bytes of " << filename << "\n";
+  }
+  return new MappedFile(filename, (const unsigned char *)data, size);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: MappedFile::map_virtual_file
+//       Access: Published, Static
+//  Description: Maps the indicated file, if its contents are stored
+//               verbatim in a file on the OS filesystem: that is, if
+//               it is a file within a directory mounted with
+//               VirtualFileMountSystem, and it is not a compressed
+//               .pz file.  Returns NULL if the file is stored in some
+//               other way, for instance within a Multifile, or if it
+//               cannot be mapped.
+////////////////////////////////////////////////////////////////////
+PT(MappedFile) MappedFile::
+map_virtual_file(VirtualFile *file) {
+  if (file == (VirtualFile *)NULL ||
+      !file->is_of_type(VirtualFileSimple::get_class_type())) {
+    return NULL;
+  }
+  VirtualFileSimple *simple = DCAST(VirtualFileSimple, file);
+  if (simple->is_implicit_pz_file() ||
+      simple->get_local_filename().get_extension() == "pz") {
+    return NULL;
+  }
+
+  VirtualFileMount *mount = simple->get_mount();
+  if (!mount->is_of_type(VirtualFileMountSystem::get_class_type())) {
+    return NULL;
+  }
+  VirtualFileMountSystem *system = DCAST(VirtualFileMountSystem, mount);
+
+  Filename pathname(system->get_physical_filename(),
+                    simple->get_local_filename());
+  pathname.set_binary();
+  return map_file(pathname);
+}
@@ -0,0 +1,64 @@
+// Filename: mappedFile.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "filename.h"
+
+class VirtualFile;
+
+////////////////////////////////////////////////////////////////////
+//       Class : MappedFile
+// Description : A read-only view of an entire file on the OS
+//               filesystem, mapped into the address space of the
+//               process.  The operating system pages the contents in
+//               on demand as they are touched, and may discard them
+//               again under memory pressure, since they are always
+//               backed by the file itself.
+//
+//               The mapping remains valid for as long as the
+//               MappedFile exists; anything that holds a pointer into
+//               the data should also hold a reference to the
+//               MappedFile.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDAEXPRESS MappedFile : public ReferenceCount {
+private:
+  MappedFile(const Filename &filename, const unsigned char *data,
+             size_t size);
+
+PUBLISHED:
+  ~MappedFile();
+
+  static PT(MappedFile) map_file(const Filename &filename);
+  static PT(MappedFile) map_virtual_file(VirtualFile *file);
+
+  INLINE const Filename &get_filename() const;
+  INLINE size_t get_size() const;
+
+public:
+  INLINE const unsigned char *get_data() const;
+
+private:
+  Filename _filename;
+  const unsigned char *_data;
+  size_t _size;
+};
+
+#include "mappedFile.I"
+
+#endif
@@ -62,6 +62,8 @@ public:
   INLINE void weak_unref(WeakPointerToVoid *ptv);
 
 protected:
+  INLINE bool unref_if_above(int limit) const;
+
   bool do_test_ref_count_integrity() const;
   bool do_test_ref_count_nonzero() const;
 
@@ -183,6 +183,32 @@ ConfigVariableBool hardware_animated_vertices
           "necessary on your computer's bus.  However, in some cases it "
           "may actually reduce performance."));
 
+ConfigVariableBool vertex_animation_simd
+("vertex-animation-simd", true,
+ PRC_DESC("Configure this false to disable the SSE2 implementation of "
+          "soft-skinning on the CPU, which is used for 3-component float32 "
+          "vertices and normals when the CPU supports it.  It computes "
+          "exactly the same vertices as the scalar implementation."));
+
+ConfigVariableInt vertex_animation_threads
+("vertex-animation-threads", 0,
+ PRC_DESC("When this is nonzero (and Panda has been compiled with thread "
+          "support), this number of sub-threads will be spawned to share "
+          "the work of soft-skinning animated vertices on the CPU, along "
+          "with the thread that requested it.  The rows of a single large "
+          "GeomVertexData are divided among them (see "
+          "vertex-animation-min-rows), as are the GeomVertexDatas passed "
+          "together to GeomVertexData::animate_vertices_batch(), and the "
+          "joint poses computed by a CharacterBatchEvaluator.  When "
+          "this is 0, all of the work is done on the requesting thread."));
+
+ConfigVariableInt vertex_animation_min_rows
+("vertex-animation-min-rows", 8192,
+ PRC_DESC("The smallest number of animated rows in a GeomVertexData for "
+          "which the skinning will be divided among the "
+          "vertex-animation-threads.  Smaller tables are animated on the "
+          "requesting thread."));
+
 ConfigVariableBool hardware_point_sprites
 ("hardware-point-sprites", true,
  PRC_DESC("Set this true to allow the use of hardware extensions when "
@@ -311,6 +337,71 @@ ConfigVariableDouble simple_image_threshold
           "simple images.  Generally the value should be considerably "
           "less than 1."));
 
+ConfigVariableInt texture_work_threads
+("texture-work-threads", 0,
+ PRC_DESC("When this is nonzero (and Panda has been compiled with thread "
+          "support), this number of sub-threads will be spawned to share "
+          "the work of generating mipmap levels and compressing RAM "
+          "images with libsquish, along with the thread that requested it.  "
+          "This applies equally to textures loaded at runtime and to "
+          "textures written out by egg2bam.  The images produced are the "
+          "same either way.  When this is 0, all of the work is done on "
+          "the requesting thread."));
+
+ConfigVariableInt texture_work_min_size
+("texture-work-min-size", 262144,
+ PRC_DESC("The smallest mipmap level, in bytes, whose processing will be "
+          "divided among the texture-work-threads.  Smaller levels are "
+          "processed on the requesting thread."));
+
+ConfigVariableBool texture_streaming
+("texture-streaming", false,
+ PRC_DESC("Set this true to stream the 2-d textures loaded through the "
+          "TexturePool.  A streamed texture initially keeps only its "
+          "smallest mipmap levels (see texture-stream-tail-size); the "
+          "finer levels are loaded asynchronously as the texture is seen "
+          "at a larger size on screen, and discarded again, finest first, "
+          "when texture-stream-budget is exceeded.  Individual textures "
+          "may also be streamed with Texture::set_streaming()."));
+
+ConfigVariableInt64 texture_stream_budget
+("texture-stream-budget", -1,
+ PRC_DESC("The number of bytes that the mipmap levels of all of the "
+          "streamed textures together may occupy.  When this is "
+          "exceeded, the finest levels of the textures that need them "
+          "least are discarded.  Set it to -1 for no limit."));
+
+ConfigVariableInt texture_stream_tail_size
+("texture-stream-tail-size", 64,
+ PRC_DESC("The size, in texels along its larger side, of the largest "
+          "mipmap level of a streamed texture that is loaded along with "
+          "the texture and is never discarded."));
+
+ConfigVariableDouble texture_stream_scale
+("texture-stream-scale", 1.0,
+ PRC_DESC("The number of texels a streamed texture should have for each "
+          "pixel it covers on screen.  Larger numbers load finer mipmap "
+          "levels than are strictly needed, to allow for textures that "
+          "are repeated across a surface or seen at an angle."));
+
+ConfigVariableInt texture_stream_threads
+("texture-stream-threads", 1,
+ PRC_DESC("The number of threads that load the finer mipmap levels of "
+          "streamed textures.  If this is 0, or Panda is compiled without "
+          "threads, the levels are loaded when the global "
+          "AsyncTaskManager is polled."));
+
+ConfigVariableInt texture_stream_max_requests
+("texture-stream-max-requests", 8,
+ PRC_DESC("The maximum number of finer mipmap levels of streamed textures "
+          "that may be waiting to load at any one time."));
+
+ConfigVariableInt texture_stream_idle_frames
+("texture-stream-idle-frames", 60,
+ PRC_DESC("The number of frames after a streamed texture was last seen on "
+          "screen before its finer mipmap levels are the first to be "
+          "discarded when texture-stream-budget is exceeded."));
+
 ConfigVariableEnum<ShaderUtilization> shader_utilization
 ("shader-utilization", SUT_none,
  PRC_DESC("At times, panda may generate shaders.  This variable controls what "
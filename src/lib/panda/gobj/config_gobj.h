@@ -19,6 +19,7 @@
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
 #include "configVariableInt.h"
+#include "configVariableInt64.h"
 #include "configVariableEnum.h"
 #include "configVariableDouble.h"
 #include "configVariableFilename.h"
@@ -63,6 +64,9 @@ extern EXPCL_PANDA_GOBJ ConfigVariableBool vertex_buffers;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool vertex_arrays;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool display_lists;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool hardware_animated_vertices;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool vertex_animation_simd;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt vertex_animation_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt vertex_animation_min_rows;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool hardware_point_sprites;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool hardware_points;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool singular_points;
@@ -79,6 +83,15 @@ extern EXPCL_PANDA_GOBJ ConfigVariableBool textures_auto_power_2;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool textures_header_only;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt simple_image_size;
 extern EXPCL_PANDA_GOBJ ConfigVariableDouble simple_image_threshold;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_work_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_work_min_size;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool texture_streaming;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt64 texture_stream_budget;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_stream_tail_size;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble texture_stream_scale;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_stream_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_stream_max_requests;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_stream_idle_frames;
 
 extern EXPCL_PANDA_GOBJ ConfigVariableEnum<ShaderUtilization> shader_utilization;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool shader_auto_utilization;
@@ -891,25 +891,7 @@ request_resident() const {
 void Geom::
 transform_vertices(const LMatrix4f &mat) {
   PT(GeomVertexData) new_data = modify_vertex_data();
-  CPT(GeomVertexFormat) format = new_data->get_format();
-  
-  int ci;
-  for (ci = 0; ci < format->get_num_points(); ci++) {
-    GeomVertexRewriter data(new_data, format->get_point(ci));
-    
-    while (!data.is_at_end()) {
-      const LPoint3f &point = data.get_data3f();
-      data.set_data3f(point * mat);
-    }
-  }
-  for (ci = 0; ci < format->get_num_vectors(); ci++) {
-    GeomVertexRewriter data(new_data, format->get_vector(ci));
-    
-    while (!data.is_at_end()) {
-      const LVector3f &vector = data.get_data3f();
-      data.set_data3f(normalize(vector * mat));
-    }
-  }
+  new_data->transform_vertices(mat);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -610,17 +610,15 @@ write_datagram(BamWriter *manager, Datagram &dg, void *extra_data) const {
   GeomVertexArrayData *array_data = (GeomVertexArrayData *)extra_data;
   dg.add_uint8(_usage_hint);
 
-  dg.add_uint32(_buffer.get_size());
-
   if (manager->get_file_endian() == BE_native) {
     // For native endianness, we only have to write the data directly.
-    dg.append_data(_buffer.get_read_pointer(true), _buffer.get_size());
+    manager->write_payload(dg, _buffer.get_read_pointer(true), _buffer.get_size());
 
   } else {
     // Otherwise, we have to convert it.
     unsigned char *new_data = (unsigned char *)alloca(_buffer.get_size());
     array_data->reverse_data_endianness(new_data, _buffer.get_read_pointer(true), _buffer.get_size());
-    dg.append_data(new_data, _buffer.get_size());
+    manager->write_payload(dg, new_data, _buffer.get_size());
   }
 }
 
@@ -645,13 +643,27 @@ fillin(DatagramIterator &scan, BamReader *manager, void *extra_data) {
 
   } else {
     // Now, the array data is just stored directly.
-    size_t size = scan.get_uint32();
-    _buffer.unclean_realloc(size);
+    BamReader::Payload payload;
+    manager->read_payload(scan, payload);
+
+    if (payload.is_mapped() && manager->get_file_endian() == BE_native) {
+      // The data lies in the mapped bam file, ready to use; reference
+      // it there.
+      _buffer.map_data(payload.get_mapped_file(), payload.get_mapped_start(),
+                       payload.get_size());
+
+    } else if ((manager->get_loader_options().get_flags() & LoaderOptions::LF_parallel_decode) != 0 &&
+               (manager->get_file_endian() == BE_native ||
+                array_data->_array_format == (GeomVertexArrayFormat *)NULL)) {
+      // Since there is no conversion to do here, we may let the
+      // BamReader copy it out when convenient, on another thread.
+      PT(BamDecodeJob) job = new BamDecodeJob(array_data, payload);
+      manager->queue_decode(array_data, job, payload.get_size());
 
-    const unsigned char *source_data = 
-      (const unsigned char *)scan.get_datagram().get_data();
-    memcpy(_buffer.get_write_pointer(), source_data + scan.get_current_index(), size);
-    scan.skip_bytes(size);
+    } else {
+      _buffer.unclean_realloc(payload.get_size());
+      payload.extract_data(_buffer.get_write_pointer());
+    }
   }
 
   bool endian_reversed = false;
@@ -684,6 +696,46 @@ fillin(DatagramIterator &scan, BamReader *manager, void *extra_data) {
   _modified = Geom::get_next_modified();
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GeomVertexArrayData::BamDecodeJob::Constructor
+//       Access: Public
+//  Description: Prepares to copy the payload.  The payload's data
+//               is referenced, not copied.
+////////////////////////////////////////////////////////////////////
+GeomVertexArrayData::BamDecodeJob::
+BamDecodeJob(GeomVertexArrayData *array_data,
+             const BamReader::Payload &payload) :
+  _array_data(array_data),
+  _payload(payload),
+  _buffer(payload.get_size())
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GeomVertexArrayData::BamDecodeJob::decode
+//       Access: Public, Virtual
+//  Description: Copies the array data into the job's own buffer.
+//               This may be called on any thread.
+////////////////////////////////////////////////////////////////////
+void GeomVertexArrayData::BamDecodeJob::
+decode() {
+  _payload.extract_data(_buffer.get_write_pointer());
+  _payload.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GeomVertexArrayData::BamDecodeJob::complete
+//       Access: Public, Virtual
+//  Description: Moves the decoded buffer into the array.  Until now,
+//               the array has been empty.
+////////////////////////////////////////////////////////////////////
+void GeomVertexArrayData::BamDecodeJob::
+complete(BamReader *) {
+  CDWriter cdata(_array_data->_cycler, true);
+  cdata->_buffer.swap(_buffer);
+  _array_data->set_lru_size(cdata->_buffer.get_size());
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GeomVertexArrayDataHandle::get_write_pointer
 //       Access: Public
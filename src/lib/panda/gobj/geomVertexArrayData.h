@@ -142,6 +142,21 @@ private:
     bool _endian_reversed;
   };
 
+  // This copies a large array out of the bam datagram, possibly on
+  // another thread; see BamReader::queue_decode().
+  class BamDecodeJob : public BamReader::DecodeJob {
+  public:
+    BamDecodeJob(GeomVertexArrayData *array_data,
+                 const BamReader::Payload &payload);
+    virtual void decode();
+    virtual void complete(BamReader *manager);
+
+  private:
+    GeomVertexArrayData *_array_data;
+    BamReader::Payload _payload;
+    VertexDataBuffer _buffer;
+  };
+
   // This is the data that must be cycled between pipeline stages.
   class EXPCL_PANDA_GOBJ CData : public CycleData {
   public:
@@ -17,6 +17,9 @@
 #include "geomVertexReader.h"
 #include "geomVertexWriter.h"
 #include "geomVertexRewriter.h"
+#include "vertexAnimationWorkQueue.h"
+#include "config_gobj.h"
+#include "lsimd.h"
 #include "pStatTimer.h"
 #include "bamReader.h"
 #include "bamWriter.h"
@@ -987,6 +990,27 @@ reverse_normals() const {
   return new_data;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GeomVertexData::transform_vertices
+//       Access: Published
+//  Description: Transforms all of the point and vector columns of
+//               this vertex data in place by the indicated matrix.
+//               Vectors (e.g. normals) are renormalized after
+//               transforming.
+////////////////////////////////////////////////////////////////////
+void GeomVertexData::
+transform_vertices(const LMatrix4f &mat) {
+  CPT(GeomVertexFormat) format = get_format();
+
+  int ci;
+  for (ci = 0; ci < format->get_num_points(); ci++) {
+    do_transform_point_column(format, format->get_point(ci), mat);
+  }
+  for (ci = 0; ci < format->get_num_vectors(); ci++) {
+    do_transform_vector_column(format, format->get_vector(ci), mat);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GeomVertexData::animate_vertices
 //       Access: Published
@@ -1076,6 +1100,71 @@ clear_animated_vertices() {
   cdata->_animated_vertices.clear();
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GeomVertexData::do_transform_point_column
+//       Access: Private
+//  Description: Transforms the indicated point column in place.  The
+//               common case of a 3-component float32 column is
+//               handed to LMatrix4f::xform_point_data() to transform
+//               the whole column at once; anything else goes through
+//               a GeomVertexRewriter.
+////////////////////////////////////////////////////////////////////
+void GeomVertexData::
+do_transform_point_column(const GeomVertexFormat *format,
+                          const InternalName *name, const LMatrix4f &mat) {
+  const GeomVertexColumn *column = format->get_column(name);
+  if (column->get_numeric_type() == NT_float32 &&
+      column->get_num_components() == 3) {
+    int array_index = format->get_array_with(name);
+    int stride = format->get_array(array_index)->get_stride();
+    PT(GeomVertexArrayDataHandle) handle = 
+      modify_array(array_index)->modify_handle();
+    float *data = (float *)(handle->get_write_pointer() + column->get_start());
+    mat.xform_point_data(data, stride, data, stride, handle->get_num_rows());
+    return;
+  }
+
+  GeomVertexRewriter data(this, name);
+  while (!data.is_at_end()) {
+    const LPoint3f &point = data.get_data3f();
+    data.set_data3f(point * mat);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GeomVertexData::do_transform_vector_column
+//       Access: Private
+//  Description: Transforms and renormalizes the indicated vector
+//               column in place.  See do_transform_point_column().
+////////////////////////////////////////////////////////////////////
+void GeomVertexData::
+do_transform_vector_column(const GeomVertexFormat *format,
+                           const InternalName *name, const LMatrix4f &mat) {
+  const GeomVertexColumn *column = format->get_column(name);
+  if (column->get_numeric_type() == NT_float32 &&
+      column->get_num_components() == 3) {
+    int array_index = format->get_array_with(name);
+    int stride = format->get_array(array_index)->get_stride();
+    PT(GeomVertexArrayDataHandle) handle = 
+      modify_array(array_index)->modify_handle();
+    unsigned char *data = handle->get_write_pointer() + column->get_start();
+    int num_rows = handle->get_num_rows();
+    mat.xform_vec_data((float *)data, stride, (float *)data, stride, num_rows);
+
+    for (int i = 0; i < num_rows; ++i) {
+      ((LVector3f *)data)->normalize();
+      data += stride;
+    }
+    return;
+  }
+
+  GeomVertexRewriter data(this, name);
+  while (!data.is_at_end()) {
+    const LVector3f &vector = data.get_data3f();
+    data.set_data3f(normalize(vector * mat));
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GeomVertexData::bytewise_copy
 //       Access: Private, Static
@@ -1335,6 +1424,256 @@ uint8_rgba_to_packed_argb(unsigned char *to, int to_stride,
   }
 }
 
+// The skinning of 3-component float32 points and vectors indexed by
+// a table of ushort blend indices, which is how the egg loader sets
+// up every soft-skinned model, is done by the functions below rather
+// than through TransformBlend::transform_point() and
+// transform_vector().  The matrix of each blend is copied into a
+// SkinJob first, so the vertices may be transformed without
+// consulting the blends' cyclers, and on several threads at once.
+
+class SkinJob {
+public:
+  class Column {
+  public:
+    unsigned char *_data;
+    size_t _stride;
+    bool _is_point;
+  };
+  typedef pvector<Column> Columns;
+  typedef pmap<int, PT(GeomVertexArrayDataHandle) > Handles;
+
+  const SparseArray *_rows;
+  const unsigned short *_blendt;
+  pvector<LMatrix4f> _matrices;
+  Columns _columns;
+  Handles _handles;
+  bool _use_simd;
+};
+
+// skin_points() and skin_vectors() transform the rows [begin, end)
+// of one column by the matrices of their blends, exactly as
+// LMatrix4f::xform_point() and xform_vec() do.
+static void
+skin_points(unsigned char *datat, size_t stride, const unsigned short *blendt,
+            const LMatrix4f *matrices, int begin, int end) {
+  for (int j = begin; j < end; ++j) {
+    LPoint3f &vertex = *(LPoint3f *)(&datat[j * stride]);
+    vertex = matrices[blendt[j]].xform_point(vertex);
+  }
+}
+
+static void
+skin_vectors(unsigned char *datat, size_t stride, const unsigned short *blendt,
+             const LMatrix4f *matrices, int begin, int end) {
+  for (int j = begin; j < end; ++j) {
+    LVector3f &vector = *(LVector3f *)(&datat[j * stride]);
+    vector = matrices[blendt[j]].xform_vec(vector);
+  }
+}
+
+// skin_points_sse2() and skin_vectors_sse2() are the same, but
+// compute all three components of each vertex at once with SSE2,
+// where it is available.  The products are summed in the same order
+// as in the scalar code, so the results are identical.  Consecutive
+// vertices usually share a blend, so its matrix is only reloaded when
+// the blend changes.
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SKIN_SSE2 __attribute__((target("sse2")))
+#include <emmintrin.h>
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define SKIN_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef SKIN_SSE2
+static SKIN_SSE2 void
+skin_points_sse2(unsigned char *datat, size_t stride, const unsigned short *blendt,
+                 const LMatrix4f *matrices, int begin, int end) {
+  int last_bi = -1;
+  __m128 r0 = _mm_setzero_ps(), r1 = r0, r2 = r0, r3 = r0;
+  for (int j = begin; j < end; ++j) {
+    int bi = blendt[j];
+    if (bi != last_bi) {
+      const float *m = matrices[bi].get_data();
+      r0 = _mm_loadu_ps(m);
+      r1 = _mm_loadu_ps(m + 4);
+      r2 = _mm_loadu_ps(m + 8);
+      r3 = _mm_loadu_ps(m + 12);
+      last_bi = bi;
+    }
+    float *v = (float *)(&datat[j * stride]);
+    __m128 result = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), r0),
+                                                     _mm_mul_ps(_mm_set1_ps(v[1]), r1)),
+                                          _mm_mul_ps(_mm_set1_ps(v[2]), r2)),
+                               r3);
+    _mm_storel_pi((__m64 *)v, result);
+    _mm_store_ss(v + 2, _mm_movehl_ps(result, result));
+  }
+}
+
+static SKIN_SSE2 void
+skin_vectors_sse2(unsigned char *datat, size_t stride, const unsigned short *blendt,
+                  const LMatrix4f *matrices, int begin, int end) {
+  int last_bi = -1;
+  __m128 r0 = _mm_setzero_ps(), r1 = r0, r2 = r0;
+  for (int j = begin; j < end; ++j) {
+    int bi = blendt[j];
+    if (bi != last_bi) {
+      const float *m = matrices[bi].get_data();
+      r0 = _mm_loadu_ps(m);
+      r1 = _mm_loadu_ps(m + 4);
+      r2 = _mm_loadu_ps(m + 8);
+      last_bi = bi;
+    }
+    float *v = (float *)(&datat[j * stride]);
+    __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), r0),
+                                          _mm_mul_ps(_mm_set1_ps(v[1]), r1)),
+                               _mm_mul_ps(_mm_set1_ps(v[2]), r2));
+    _mm_storel_pi((__m64 *)v, result);
+    _mm_store_ss(v + 2, _mm_movehl_ps(result, result));
+  }
+}
+
+#else  // SKIN_SSE2
+static void
+skin_points_sse2(unsigned char *datat, size_t stride, const unsigned short *blendt,
+                 const LMatrix4f *matrices, int begin, int end) {
+  skin_points(datat, stride, blendt, matrices, begin, end);
+}
+
+static void
+skin_vectors_sse2(unsigned char *datat, size_t stride, const unsigned short *blendt,
+                  const LMatrix4f *matrices, int begin, int end) {
+  skin_vectors(datat, stride, blendt, matrices, begin, end);
+}
+#endif  // SKIN_SSE2
+
+// use_skin_sse2() returns true if skin_points_sse2() and
+// skin_vectors_sse2() should be used.
+static bool
+use_skin_sse2() {
+#ifdef SKIN_SSE2
+  return vertex_animation_simd && LSimd::get_supported_level() >= LSimd::L_sse2;
+#else
+  return false;
+#endif
+}
+
+// skin_rows() is the VertexAnimationWorkQueue function that skins
+// the animated rows within [begin, end) of all of the columns of a
+// SkinJob.
+static void
+skin_rows(void *data, int begin, int end) {
+  const SkinJob *job = (const SkinJob *)data;
+  const LMatrix4f *matrices = &job->_matrices[0];
+
+  int num_subranges = job->_rows->get_num_subranges();
+  for (int i = 0; i < num_subranges; ++i) {
+    int row_begin = max(job->_rows->get_subrange_begin(i), begin);
+    int row_end = min(job->_rows->get_subrange_end(i), end);
+    if (row_begin >= row_end) {
+      continue;
+    }
+    SkinJob::Columns::const_iterator ci;
+    for (ci = job->_columns.begin(); ci != job->_columns.end(); ++ci) {
+      const SkinJob::Column &column = (*ci);
+      if (column._is_point) {
+        if (job->_use_simd) {
+          skin_points_sse2(column._data, column._stride, job->_blendt, matrices, row_begin, row_end);
+        } else {
+          skin_points(column._data, column._stride, job->_blendt, matrices, row_begin, row_end);
+        }
+      } else {
+        if (job->_use_simd) {
+          skin_vectors_sse2(column._data, column._stride, job->_blendt, matrices, row_begin, row_end);
+        } else {
+          skin_vectors(column._data, column._stride, job->_blendt, matrices, row_begin, row_end);
+        }
+      }
+    }
+  }
+}
+
+// add_skin_column() adds the indicated 3-component float32 column of
+// new_data to the job.
+static void
+add_skin_column(SkinJob &job, GeomVertexData *new_data,
+                const GeomVertexFormat *new_format,
+                const InternalName *name, bool is_point) {
+  int data_index = new_format->get_array_with(name);
+  const GeomVertexColumn *data_column = new_format->get_column(name);
+  nassertv(data_index >= 0 && data_column != (GeomVertexColumn *)NULL);
+
+  // Each array is modified through just one handle, which is kept
+  // until the job is done.
+  SkinJob::Handles::iterator hi = job._handles.find(data_index);
+  if (hi == job._handles.end()) {
+    PT(GeomVertexArrayData) data_array = new_data->modify_array(data_index);
+    hi = job._handles.insert(SkinJob::Handles::value_type(data_index, data_array->modify_handle())).first;
+  }
+  GeomVertexArrayDataHandle *handle = (*hi).second;
+
+  SkinJob::Column column;
+  column._data = handle->get_write_pointer() + data_column->get_start();
+  column._stride = handle->get_array_format()->get_stride();
+  column._is_point = is_point;
+  job._columns.push_back(column);
+}
+
+// The VertexAnimationWorkQueue function used by
+// animate_vertices_batch().
+static void
+animate_batch_range(void *data, int begin, int end) {
+  const GeomVertexData *const *vdatas = (const GeomVertexData *const *)data;
+  Thread *current_thread = Thread::get_current_thread();
+  for (int i = begin; i < end; ++i) {
+    vdatas[i]->animate_vertices(true, current_thread);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GeomVertexData::animate_vertices_batch
+//       Access: Public, Static
+//  Description: Calls animate_vertices() on each of the indicated
+//               GeomVertexDatas, dividing them among the
+//               vertex-animation-threads if there are enough vertices
+//               altogether to be worth it.  The results are kept, so
+//               that subsequent calls to animate_vertices() in the
+//               same frame, such as the ones made when the Geoms are
+//               rendered, return them immediately.
+//
+//               This is useful for applications that animate a great
+//               many characters, each of which is too small for its
+//               own vertices to be divided among threads.
+////////////////////////////////////////////////////////////////////
+void GeomVertexData::
+animate_vertices_batch(const pvector<const GeomVertexData *> &vdatas,
+                       Thread *current_thread) {
+  if (vdatas.empty()) {
+    return;
+  }
+
+  int num_rows = 0;
+  pvector<const GeomVertexData *>::const_iterator vi;
+  for (vi = vdatas.begin(); vi != vdatas.end(); ++vi) {
+    num_rows += (*vi)->get_num_rows();
+  }
+
+  if (num_rows < max((int)vertex_animation_min_rows, 0) ||
+      !VertexAnimationWorkQueue::is_parallel_work_available()) {
+    for (vi = vdatas.begin(); vi != vdatas.end(); ++vi) {
+      (*vi)->animate_vertices(true, current_thread);
+    }
+    return;
+  }
+
+  VertexAnimationWorkQueue::run(&animate_batch_range, (void *)&vdatas[0],
+                                (int)vdatas.size(), num_rows);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GeomVertexData::update_animated_vertices
 //       Access: Private
@@ -1491,32 +1830,34 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
       CPT(GeomVertexArrayDataHandle) blend_array_handle = cdata->_arrays[blend_array_index].get_read_pointer()->get_handle(current_thread);
       const unsigned short *blendt = (const unsigned short *)blend_array_handle->get_read_pointer(true);
 
+      // Tables of LPoint3f's and LVector3f's are gathered into a
+      // SkinJob.  Optimize this common case.
+      SkinJob job;
+      job._rows = &rows;
+      job._blendt = blendt;
+      job._use_simd = use_skin_sse2();
+      job._matrices.resize(num_blends);
+      for (bi = 0; bi < num_blends; bi++) {
+        const TransformBlend &blend = tb_table->get_blend(bi);
+        if (blend.get_num_transforms() == 0) {
+          // transform_point() leaves the vertex alone in this case.
+          job._matrices[bi] = LMatrix4f::ident_mat();
+        } else {
+          blend.get_blend(job._matrices[bi], current_thread);
+        }
+      }
+
       int ci;
       for (ci = 0; ci < new_format->get_num_points(); ci++) {
-        GeomVertexRewriter data(new_data, new_format->get_point(ci));
-        const GeomVertexColumn *data_column = data.get_column();
+        const GeomVertexColumn *data_column = new_format->get_column(new_format->get_point(ci));
         if (data_column->get_num_values() == 3 &&
             data_column->get_numeric_type() == NT_float32) {
-          // Table of points is a table of LPoint3f's.  Optimize this
-          // common case.
-          int data_index = new_format->get_array_with(new_format->get_point(ci));
-          PT(GeomVertexArrayData) data_array = new_data->modify_array(data_index);
-          PT(GeomVertexArrayDataHandle) data_handle = data_array->modify_handle();
-          unsigned char *datat = data_handle->get_write_pointer();
-          datat += data_column->get_start();
-          size_t stride = data_array->get_array_format()->get_stride();
-
-          for (int i = 0; i < num_subranges; ++i) {
-            int begin = rows.get_subrange_begin(i);
-            int end = rows.get_subrange_end(i);
-            for (int j = begin; j < end; ++j) {
-              LPoint3f &vertex = *(LPoint3f *)(&datat[j * stride]);
-              int bi = blendt[j];
-              tb_table->get_blend(bi).transform_point(vertex, current_thread);
-            }
-          }
+          add_skin_column(job, new_data, new_format, new_format->get_point(ci), true);
+          continue;
+        }
 
-        } else if (data_column->get_num_values() == 4) {
+        GeomVertexRewriter data(new_data, new_format->get_point(ci));
+        if (data_column->get_num_values() == 4) {
           // Use the GeomVertexRewriter to adjust the 4-component
           // points.
           for (int i = 0; i < num_subranges; ++i) {
@@ -1550,46 +1891,36 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
 
       // Also process vectors: normals, etc.
       for (ci = 0; ci < new_format->get_num_vectors(); ci++) {
-        GeomVertexRewriter data(new_data, new_format->get_vector(ci));
-        const GeomVertexColumn *data_column = data.get_column();
+        const GeomVertexColumn *data_column = new_format->get_column(new_format->get_vector(ci));
         if (data_column->get_num_values() == 3 &&
             data_column->get_numeric_type() == NT_float32) {
-          // Table of vectors is a table of LVector3f's.  Optimize this
-          // common case.
-          int data_index = new_format->get_array_with(new_format->get_vector(ci));
-          PT(GeomVertexArrayData) data_array = new_data->modify_array(data_index);
-          PT(GeomVertexArrayDataHandle) data_handle = data_array->modify_handle();
-          unsigned char *datat = data_handle->get_write_pointer();
-          datat += data_column->get_start();
-          size_t stride = data_array->get_array_format()->get_stride();
-
-          for (int i = 0; i < num_subranges; ++i) {
-            int begin = rows.get_subrange_begin(i);
-            int end = rows.get_subrange_end(i);
-            for (int j = begin; j < end; ++j) {
-              LVector3f &vertex = *(LVector3f *)(&datat[j * stride]);
-              int bi = blendt[j];
-              tb_table->get_blend(bi).transform_vector(vertex, current_thread);
-            }
-          }
-          
-        } else {
-          // Use the GeomVertexRewriter to adjust the vectors.
+          add_skin_column(job, new_data, new_format, new_format->get_vector(ci), false);
+          continue;
+        }
 
-          for (int i = 0; i < num_subranges; ++i) {
-            int begin = rows.get_subrange_begin(i);
-            int end = rows.get_subrange_end(i);
-            data.set_row(begin);
-            for (int j = begin; j < end; ++j) {
-              LVector3f vertex = data.get_data3f();
-              int bi = blendt[j];
-              tb_table->get_blend(bi).transform_vector(vertex, current_thread);
-              data.set_data3f(vertex);
-            }
+        // Use the GeomVertexRewriter to adjust the vectors.
+        GeomVertexRewriter data(new_data, new_format->get_vector(ci));
+        for (int i = 0; i < num_subranges; ++i) {
+          int begin = rows.get_subrange_begin(i);
+          int end = rows.get_subrange_end(i);
+          data.set_row(begin);
+          for (int j = begin; j < end; ++j) {
+            LVector3f vertex = data.get_data3f();
+            int bi = blendt[j];
+            tb_table->get_blend(bi).transform_vector(vertex, current_thread);
+            data.set_data3f(vertex);
           }
         }
       }
 
+      // Now skin all of the LPoint3f's and LVector3f's, dividing the
+      // rows among the vertex-animation-threads if there are enough
+      // of them.
+      if (!job._columns.empty()) {
+        int num_rows = get_num_rows();
+        VertexAnimationWorkQueue::run(&skin_rows, &job, num_rows, num_rows);
+      }
+
     } else {
       // The blend indices are anything else.  Use the
       // GeomVertexReader to iterate through them.
@@ -148,6 +148,7 @@ PUBLISHED:
               NumericType numeric_type, Contents contents) const;
 
   CPT(GeomVertexData) reverse_normals() const;
+  void transform_vertices(const LMatrix4f &mat);
 
   CPT(GeomVertexData) animate_vertices(bool force, Thread *current_thread) const;
   void clear_animated_vertices();
@@ -163,6 +164,9 @@ PUBLISHED:
   void clear_cache_stage();
 
 public:
+  static void animate_vertices_batch(const pvector<const GeomVertexData *> &vdatas,
+                                     Thread *current_thread);
+
   static INLINE PN_uint32 pack_abcd(unsigned int a, unsigned int b,
                                     unsigned int c, unsigned int d);
   static INLINE unsigned int unpack_abcd_a(PN_uint32 data);
@@ -171,6 +175,13 @@ public:
   static INLINE unsigned int unpack_abcd_d(PN_uint32 data);
 
 private:
+  void do_transform_point_column(const GeomVertexFormat *format,
+                                 const InternalName *name,
+                                 const LMatrix4f &mat);
+  void do_transform_vector_column(const GeomVertexFormat *format,
+                                  const InternalName *name,
+                                  const LMatrix4f &mat);
+
   static void bytewise_copy(unsigned char *to, int to_stride,
                             const unsigned char *from, int from_stride,
                             const GeomVertexColumn *from_type,
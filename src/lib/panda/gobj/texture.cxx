@@ -39,6 +39,8 @@
 #include "pbitops.h"
 #include "streamReader.h"
 #include "texturePeeker.h"
+#include "textureWorkQueue.h"
+#include "textureStreamManager.h"
 
 #ifdef HAVE_SQUISH
 #include <squish.h>
@@ -208,6 +210,12 @@ Texture(const string &name) :
   _orig_file_x_size = 0;
   _orig_file_y_size = 0;
 
+  _streaming = false;
+  _stream_level = -1;
+  _stream_full_x_size = 0;
+  _stream_full_y_size = 0;
+  _stream_screen_size = 0;
+
   _loaded_from_image = false;
   _loaded_from_txo = false;
   _has_read_pages = false;
@@ -233,6 +241,7 @@ Texture(const Texture &copy) :
 {
   _reloading = false;
   _num_mipmap_levels_read = 0;
+  _stream_screen_size = 0;
 
   operator = (copy);
 }
@@ -983,11 +992,163 @@ set_ram_image_as(CPTA_uchar image, const string &supplied_format) {
 //  Description: Returns the flag that indicates whether this Texture
 //               is eligible to have its main RAM copy of the texture
 //               memory dumped when the texture is prepared for
-//               rendering.  See set_keep_ram_image().
+//               rendering.  See set_keep_ram_image().  This is
+//               always true for a streamed texture.
 ////////////////////////////////////////////////////////////////////
 bool Texture::
 get_keep_ram_image() const {
-  return _keep_ram_image;
+  return _keep_ram_image || _streaming;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::set_streaming
+//       Access: Published
+//  Description: Sets the flag that indicates whether this texture is
+//               streamed.  A streamed texture keeps only some of its
+//               mipmap levels in memory: initially, just the tail of
+//               the mipmap chain, the levels no larger than
+//               texture-stream-tail-size, which are small enough to
+//               be loaded along with the texture.  The
+//               TextureStreamManager then loads the finer levels
+//               asynchronously as the texture is seen at a larger
+//               size on screen, and discards them again, finest
+//               first, to keep all of the streamed textures within
+//               texture-stream-budget.
+//
+//               While levels are missing, get_x_size() and
+//               get_y_size() report the size of the finest level
+//               that is loaded, and the RAM image begins with that
+//               level; so the texture is rendered, at a lower
+//               resolution, exactly as if it were that size.  The
+//               RAM image of a streamed texture is always kept.
+//
+//               Only 2-d textures loaded from an image file, with
+//               integer components and no padding, may be streamed.
+//               The texture pool streams all such textures if
+//               texture-streaming is true.
+//
+//               Returns true if the texture is now streamed (or not
+//               streamed, as requested), false if it cannot be.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+set_streaming(bool streaming) {
+  {
+    MutexHolder holder(_lock);
+    while (_reloading) {
+      _cvar.wait();
+    }
+    if (streaming == _streaming) {
+      return true;
+    }
+    if (streaming && !do_can_stream()) {
+      if (gobj_cat.is_debug()) {
+        gobj_cat.debug()
+          << "Texture " << get_name() << " cannot be streamed.\n";
+      }
+      return false;
+    }
+
+    if (streaming) {
+      _streaming = true;
+      _stream_level = -1;
+      if (do_has_ram_image()) {
+        do_stream_trim();
+        if (_stream_level > 0) {
+          ++_properties_modified;
+          ++_image_modified;
+        }
+      } else if (_x_size != 0 && do_can_reload()) {
+        // The full image may already have been loaded and sent to
+        // the graphics card; make sure it gets reloaded, trimmed to
+        // the tail.
+        ++_image_modified;
+      }
+
+    } else {
+      _streaming = false;
+      if (_stream_level > 0) {
+        // Get the full image back.
+        do_clear_ram_image();
+        _x_size = _stream_full_x_size;
+        _y_size = _stream_full_y_size;
+        ++_properties_modified;
+        ++_image_modified;
+      }
+      _stream_level = -1;
+    }
+  }
+
+  TextureStreamManager *manager = TextureStreamManager::get_global_ptr();
+  if (streaming) {
+    manager->add_texture(this);
+  } else {
+    manager->remove_texture(this);
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::set_stream_level
+//       Access: Published
+//  Description: Changes the number of the finest mipmap levels of a
+//               streamed texture that are not loaded.  The level is
+//               limited to the range 0 (the full image) to
+//               get_stream_tail_level().  If the new level is coarser
+//               than the current one, the finer levels are discarded
+//               immediately; if it is finer, the texture is reloaded
+//               from disk (or from the model cache) first, which may
+//               take some time.  Other threads may continue to use
+//               the texture, at its present level, in the meantime.
+//
+//               This is normally called by the TextureStreamManager,
+//               via a TextureReloadRequest when the level is finer.
+//               Returns true if the texture is now at the requested
+//               level, false if it is not streamed, has not yet been
+//               loaded, or could not be reloaded.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+set_stream_level(int level) {
+  MutexHolder holder(_lock);
+  while (_reloading) {
+    _cvar.wait();
+  }
+  if (!_streaming || _stream_level < 0) {
+    return false;
+  }
+
+  level = max(min(level, do_get_stream_tail_level()), 0);
+  if (level > _stream_level) {
+    do_stream_drop_levels(level - _stream_level);
+    ++_properties_modified;
+    ++_image_modified;
+
+  } else if (level < _stream_level) {
+    return do_unlock_and_load_stream_level(level);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::get_stream_resident_size
+//       Access: Published
+//  Description: Returns the number of bytes occupied by the mipmap
+//               levels of the texture that are currently held in
+//               RAM.  For a streamed texture, this is the amount
+//               counted against texture-stream-budget.
+////////////////////////////////////////////////////////////////////
+size_t Texture::
+get_stream_resident_size() const {
+  MutexHolder holder(_lock);
+  if (!do_has_ram_image()) {
+    return 0;
+  }
+
+  size_t size = 0;
+  for (size_t n = 0; n < _ram_images.size(); ++n) {
+    size += _ram_images[n]._page_size * _z_size;
+  }
+  return size;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -3752,6 +3913,9 @@ do_unlock_and_reload_ram_image(bool allow_compression) {
     // texture.
     _orig_file_x_size = tex->_orig_file_x_size;
     _orig_file_y_size = tex->_orig_file_y_size;
+    _stream_level = tex->_stream_level;
+    _stream_full_x_size = tex->_stream_full_x_size;
+    _stream_full_y_size = tex->_stream_full_y_size;
 
     // If any of *these* properties have changed, the texture has
     // changed in some fundamental way.  Update it appropriately.
@@ -3877,6 +4041,7 @@ do_reload_ram_image(bool allow_compression) {
             }
           }
 
+          do_stream_trim();
           return;
         }
       }
@@ -3922,6 +4087,173 @@ do_reload_ram_image(bool allow_compression) {
       cache->store(record);
     }
   }
+
+  // The full image has been stored in the cache; now a streamed
+  // texture may discard the levels it doesn't want.
+  do_stream_trim();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_can_stream
+//       Access: Protected
+//  Description: Returns true if the texture is of a kind that may be
+//               streamed; see set_streaming().
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_can_stream() const {
+  return (_texture_type == TT_2d_texture &&
+          _pad_x_size == 0 && _pad_y_size == 0 &&
+          (_component_type == T_unsigned_byte ||
+           _component_type == T_unsigned_short));
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_get_stream_tail_level
+//       Access: Protected
+//  Description: The protected implementation of
+//               get_stream_tail_level().
+////////////////////////////////////////////////////////////////////
+int Texture::
+do_get_stream_tail_level() const {
+  int x_size = _stream_full_x_size;
+  int y_size = _stream_full_y_size;
+  if (x_size <= 0 || y_size <= 0) {
+    return 0;
+  }
+
+  int tail_size = max((int)texture_stream_tail_size, 1);
+  int level = 0;
+  while ((x_size > tail_size || y_size > tail_size) &&
+         (x_size > 1 || y_size > 1)) {
+    x_size = max(x_size >> 1, 1);
+    y_size = max(y_size >> 1, 1);
+    ++level;
+  }
+  return level;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_stream_trim
+//       Access: Protected
+//  Description: Called when the full image of a streamed texture has
+//               just been loaded into RAM, to discard the mipmap
+//               levels finer than _stream_level (or, if that is -1,
+//               all but the tail levels).  Mipmap levels are
+//               generated first if necessary.  If the texture has a
+//               compressed image without enough mipmap levels, it is
+//               trimmed as far as it can be.
+//
+//               Assumes the lock is already held.
+////////////////////////////////////////////////////////////////////
+void Texture::
+do_stream_trim() {
+  if (!_streaming || !do_can_stream() || !do_has_ram_image()) {
+    return;
+  }
+
+  _stream_full_x_size = _x_size;
+  _stream_full_y_size = _y_size;
+
+  int level = _stream_level;
+  if (level < 0) {
+    level = do_get_stream_tail_level();
+  }
+  if (level > 0 && (int)_ram_images.size() <= level &&
+      _ram_image_compression == CM_off) {
+    do_generate_ram_mipmap_images();
+  }
+  level = min(level, (int)_ram_images.size() - 1);
+
+  _stream_level = 0;
+  do_stream_drop_levels(level);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_stream_drop_levels
+//       Access: Protected
+//  Description: Discards the indicated number of the finest mipmap
+//               levels of a streamed texture, and adjusts the size
+//               of the texture to match the new finest level.  If
+//               there aren't enough mipmap levels in RAM, the whole
+//               RAM image is dropped instead, to be reloaded (at the
+//               new level) when it is next needed.
+//
+//               Assumes the lock is already held.  The caller is
+//               responsible for updating the modified counters.
+////////////////////////////////////////////////////////////////////
+void Texture::
+do_stream_drop_levels(int num_levels) {
+  if (num_levels <= 0) {
+    return;
+  }
+
+  if ((int)_ram_images.size() > num_levels) {
+    _ram_images.erase(_ram_images.begin(), _ram_images.begin() + num_levels);
+  } else {
+    do_clear_ram_image();
+  }
+
+  _stream_level += num_levels;
+  _x_size = max(_stream_full_x_size >> _stream_level, 1);
+  _y_size = max(_stream_full_y_size >> _stream_level, 1);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::do_unlock_and_load_stream_level
+//       Access: Protected
+//  Description: Reloads a streamed texture at a finer level than it
+//               has now.  As in do_unlock_and_reload_ram_image(), the
+//               lock is released while the image is read, and the
+//               texture keeps its present image until the new one is
+//               ready.  Returns true on success.
+//
+//               Assumes the lock is held on entry, and that no
+//               reload is in progress.  It will be held again on
+//               return.
+////////////////////////////////////////////////////////////////////
+bool Texture::
+do_unlock_and_load_stream_level(int level) {
+  if (!do_can_reload()) {
+    return false;
+  }
+
+  nassertr(!_reloading, false);
+  _reloading = true;
+
+  PT(Texture) tex = do_make_copy();
+  tex->_stream_level = level;
+  _lock.release();
+
+  tex->do_reload_ram_image(true);
+
+  _lock.acquire();
+
+  bool loaded = (_streaming && tex->do_has_ram_image() &&
+                 tex->_stream_level >= 0);
+  if (loaded) {
+    _orig_file_x_size = tex->_orig_file_x_size;
+    _orig_file_y_size = tex->_orig_file_y_size;
+    _x_size = tex->_x_size;
+    _y_size = tex->_y_size;
+    _num_components = tex->_num_components;
+    _component_width = tex->_component_width;
+    _format = tex->_format;
+    _component_type = tex->_component_type;
+    _ram_image_compression = tex->_ram_image_compression;
+    _ram_images = tex->_ram_images;
+    _stream_level = tex->_stream_level;
+    _stream_full_x_size = tex->_stream_full_x_size;
+    _stream_full_y_size = tex->_stream_full_y_size;
+
+    ++_properties_modified;
+    ++_image_modified;
+  }
+
+  nassertr(_reloading, loaded);
+  _reloading = false;
+  _cvar.notify_all();
+
+  return loaded;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -4399,6 +4731,10 @@ do_assign(const Texture &copy) {
   _pad_z_size = copy._pad_z_size;
   _orig_file_x_size = copy._orig_file_x_size;
   _orig_file_y_size = copy._orig_file_y_size;
+  _streaming = copy._streaming;
+  _stream_level = copy._stream_level;
+  _stream_full_x_size = copy._stream_full_x_size;
+  _stream_full_y_size = copy._stream_full_y_size;
   _num_components = copy._num_components;
   _component_width = copy._component_width;
   _texture_type = copy._texture_type;
@@ -6130,73 +6466,69 @@ filter_2d_mipmap_pages(Texture::RamImage &to, const Texture::RamImage &from,
   to._page_size = (size_t)to_y_size * to_row_size;
   to._image = PTA_uchar::empty_array(to._page_size * _z_size, get_class_type());
 
-  Filter2DComponent *filter_component = (_component_type == T_unsigned_byte ? &filter_2d_unsigned_byte : filter_2d_unsigned_short);
-
-  for (int z = 0; z < _z_size; ++z) {
-    // For each level.
-    unsigned char *p = to._image.p() + z * to._page_size;
-    const unsigned char *q = from._image.p() + z * from._page_size;
-    if (y_size != 1) {
-      int y;
-      for (y = 0; y < y_size - 1; y += 2) {
-        // For each row.
-        nassertv(p == to._image.p() + z * to._page_size + (y / 2) * to_row_size);
-        nassertv(q == from._image.p() + z * from._page_size + y * row_size);
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < _num_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, row_size);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < _num_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, row_size);
-          }
+  MipmapJob job;
+  job._to = to._image.p();
+  job._from = from._image.p();
+  job._num_components = _num_components;
+  job._x_size = x_size;
+  job._y_size = y_size;
+  job._z_size = _z_size;
+  job._to_y_size = to_y_size;
+  job._pixel_size = pixel_size;
+  job._row_size = row_size;
+  job._page_size = from._page_size;
+  job._to_row_size = to_row_size;
+  job._to_page_size = to._page_size;
+  job._filter_2d = (_component_type == T_unsigned_byte ? &filter_2d_unsigned_byte : filter_2d_unsigned_short);
+  job._filter_3d = NULL;
+
+  // Each row of each page of the new level is independent of the
+  // others, so they may be shared among the texture-work-threads.
+  TextureWorkQueue::run(&filter_2d_mipmap_rows, &job, to_y_size * _z_size,
+                        from._image.size());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::filter_2d_mipmap_rows
+//       Access: Private, Static
+//  Description: Generates the rows [begin, end) of the next mipmap
+//               level for filter_2d_mipmap_pages(), counting the rows
+//               of each page consecutively.  data is a MipmapJob.
+////////////////////////////////////////////////////////////////////
+void Texture::
+filter_2d_mipmap_rows(void *data, int begin, int end) {
+  const MipmapJob &job = *(const MipmapJob *)data;
+  Filter2DComponent *filter_component = job._filter_2d;
+
+  // If there is only one row, we filter it with itself.
+  size_t row_size = (job._y_size != 1) ? job._row_size : 0;
+
+  for (int i = begin; i < end; ++i) {
+    // For each row.
+    int z = i / job._to_y_size;
+    int y = (i % job._to_y_size) * 2;
+    unsigned char *p = job._to + z * job._to_page_size + (y / 2) * job._to_row_size;
+    const unsigned char *q = job._from + z * job._page_size + y * job._row_size;
+    if (job._x_size != 1) {
+      int x;
+      for (x = 0; x < job._x_size - 1; x += 2) {
+        // For each pixel.
+        for (int c = 0; c < job._num_components; ++c) {
+          // For each component.
+          filter_component(p, q, job._pixel_size, row_size);
         }
-        q += row_size;
-        Thread::consider_yield();
-      }
-      if (y < y_size) {
-        // Skip the last odd row.
-        q += row_size;
+        q += job._pixel_size;
       }
     } else {
-      // Just one row.
-      if (x_size != 1) {
-        int x;
-        for (x = 0; x < x_size - 1; x += 2) {
-          // For each pixel.
-          for (int c = 0; c < _num_components; ++c) {
-            // For each component.
-            filter_component(p, q, pixel_size, 0);
-          }
-          q += pixel_size;
-        }
-        if (x < x_size) {
-          // Skip the last odd pixel.
-          q += pixel_size;
-        }
-      } else {
-        // Just one pixel.
-        for (int c = 0; c < _num_components; ++c) {
-          // For each component.
-          filter_component(p, q, 0, 0);
-        }
+      // Just one pixel.
+      for (int c = 0; c < job._num_components; ++c) {
+        // For each component.
+        filter_component(p, q, 0, row_size);
       }
     }
 
-    nassertv(p == to._image.p() + (z + 1) * to._page_size);
-    nassertv(q == from._image.p() + (z + 1) * from._page_size);
+    nassertv(p == job._to + z * job._to_page_size + (y / 2 + 1) * job._to_row_size);
+    Thread::consider_yield();
   }
 }
 
@@ -6229,144 +6561,69 @@ filter_3d_mipmap_level(Texture::RamImage &to, const Texture::RamImage &from,
   to._page_size = to_page_size;
   to._image = PTA_uchar::empty_array(to_page_size * to_z_size, get_class_type());
 
-  Filter3DComponent *filter_component = (_component_type == T_unsigned_byte ? &filter_3d_unsigned_byte : filter_3d_unsigned_short);
-
-  unsigned char *p = to._image.p();
-  const unsigned char *q = from._image.p();
-  if (z_size != 1) {
-    int z;
-    for (z = 0; z < z_size - 1; z += 2) {
-      // For each level.
-      nassertv(p == to._image.p() + (z / 2) * to_page_size);
-      nassertv(q == from._image.p() + z * page_size);
-      if (y_size != 1) {
-        int y;
-        for (y = 0; y < y_size - 1; y += 2) {
-          // For each row.
-          nassertv(p == to._image.p() + (z / 2) * to_page_size + (y / 2) * to_row_size);
-          nassertv(q == from._image.p() + z * page_size + y * row_size);
-          if (x_size != 1) {
-            int x;
-            for (x = 0; x < x_size - 1; x += 2) {
-              // For each pixel.
-              for (int c = 0; c < _num_components; ++c) {
-                // For each component.
-                filter_component(p, q, pixel_size, row_size, page_size);
-              }
-              q += pixel_size;
-            }
-            if (x < x_size) {
-              // Skip the last odd pixel.
-              q += pixel_size;
-            }
-          } else {
-            // Just one pixel.
-            for (int c = 0; c < _num_components; ++c) {
-              // For each component.
-              filter_component(p, q, 0, row_size, page_size);
-            }
-          }
-          q += row_size;
-          Thread::consider_yield();
-        }
-        if (y < y_size) {
-          // Skip the last odd row.
-          q += row_size;
-        }
-      } else {
-        // Just one row.
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < _num_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, 0, page_size);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < _num_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, 0, page_size);
-          }
-        }
-      }
-      q += page_size;
-    }
-    if (z < z_size) {
-      // Skip the last odd page.
-      q += page_size;
-    }
-  } else {
-    // Just one page.
-    if (y_size != 1) {
-      int y;
-      for (y = 0; y < y_size - 1; y += 2) {
-        // For each row.
-        nassertv(p == to._image.p() + (y / 2) * to_row_size);
-        nassertv(q == from._image.p() + y * row_size);
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < _num_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, row_size, 0);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < _num_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, row_size, 0);
-          }
+  MipmapJob job;
+  job._to = to._image.p();
+  job._from = from._image.p();
+  job._num_components = _num_components;
+  job._x_size = x_size;
+  job._y_size = y_size;
+  job._z_size = z_size;
+  job._to_y_size = to_y_size;
+  job._pixel_size = pixel_size;
+  job._row_size = row_size;
+  job._page_size = page_size;
+  job._to_row_size = to_row_size;
+  job._to_page_size = to_page_size;
+  job._filter_2d = NULL;
+  job._filter_3d = (_component_type == T_unsigned_byte ? &filter_3d_unsigned_byte : filter_3d_unsigned_short);
+
+  TextureWorkQueue::run(&filter_3d_mipmap_rows, &job, to_y_size * to_z_size,
+                        from._image.size());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::filter_3d_mipmap_rows
+//       Access: Private, Static
+//  Description: Generates the rows [begin, end) of the next mipmap
+//               level for filter_3d_mipmap_level(), counting the rows
+//               of each page consecutively.  data is a MipmapJob.
+////////////////////////////////////////////////////////////////////
+void Texture::
+filter_3d_mipmap_rows(void *data, int begin, int end) {
+  const MipmapJob &job = *(const MipmapJob *)data;
+  Filter3DComponent *filter_component = job._filter_3d;
+
+  // If there is only one row or page, we filter it with itself.
+  size_t row_size = (job._y_size != 1) ? job._row_size : 0;
+  size_t page_size = (job._z_size != 1) ? job._page_size : 0;
+
+  for (int i = begin; i < end; ++i) {
+    // For each row.
+    int z = (i / job._to_y_size) * 2;
+    int y = (i % job._to_y_size) * 2;
+    unsigned char *p = job._to + (z / 2) * job._to_page_size + (y / 2) * job._to_row_size;
+    const unsigned char *q = job._from + z * job._page_size + y * job._row_size;
+    if (job._x_size != 1) {
+      int x;
+      for (x = 0; x < job._x_size - 1; x += 2) {
+        // For each pixel.
+        for (int c = 0; c < job._num_components; ++c) {
+          // For each component.
+          filter_component(p, q, job._pixel_size, row_size, page_size);
         }
-        q += row_size;
-        Thread::consider_yield();
-      }
-      if (y < y_size) {
-        // Skip the last odd row.
-        q += row_size;
+        q += job._pixel_size;
       }
     } else {
-      // Just one row.
-      if (x_size != 1) {
-        int x;
-        for (x = 0; x < x_size - 1; x += 2) {
-          // For each pixel.
-          for (int c = 0; c < _num_components; ++c) {
-            // For each component.
-            filter_component(p, q, pixel_size, 0, 0);
-          }
-          q += pixel_size;
-        }
-        if (x < x_size) {
-          // Skip the last odd pixel.
-          q += pixel_size;
-        }
-      } else {
-        // Just one pixel.
-        for (int c = 0; c < _num_components; ++c) {
-          // For each component.
-          filter_component(p, q, 0, 0, 0);
-        }
+      // Just one pixel.
+      for (int c = 0; c < job._num_components; ++c) {
+        // For each component.
+        filter_component(p, q, 0, row_size, page_size);
       }
     }
-  }
 
-  nassertv(p == to._image.p() + to_z_size * to_page_size);
-  nassertv(q == from._image.p() + z_size * page_size);
+    nassertv(p == job._to + (z / 2) * job._to_page_size + (y / 2 + 1) * job._to_row_size);
+    Thread::consider_yield();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -6471,6 +6728,15 @@ do_squish(Texture::CompressionMode compression, int squish_flags) {
     do_generate_ram_mipmap_images();
   }
 
+  // Each row of 4x4 cells is compressed independently, so all of the
+  // rows of all of the levels may be shared among the
+  // texture-work-threads.
+  SquishJob job;
+  job._num_components = _num_components;
+  job._squish_flags = squish_flags;
+  job._cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+  size_t num_bytes = 0;
+
   RamImages compressed_ram_images;
   compressed_ram_images.reserve(_ram_images.size());
   for (size_t n = 0; n < _ram_images.size(); ++n) {
@@ -6479,67 +6745,29 @@ do_squish(Texture::CompressionMode compression, int squish_flags) {
     int y_size = do_get_expected_mipmap_y_size(n);
     int z_size = do_get_expected_mipmap_z_size(n);
     int page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
-    int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+    int row_size = ((x_size + 3) / 4) * job._cell_size;
 
     compressed_image._page_size = page_size;
     compressed_image._image = PTA_uchar::empty_array(page_size * z_size);
     for (int z = 0; z < z_size; ++z) {
       unsigned char *dest_page = compressed_image._image.p() + z * page_size;
       unsigned const char *source_page = _ram_images[n]._image.p() + z * _ram_images[n]._page_size;
-      unsigned const char *source_page_end = source_page + _ram_images[n]._page_size;
-      // Convert one 4 x 4 cell at a time.
-      unsigned char *d = dest_page;
       for (int y = 0; y < y_size; y += 4) {
-        for (int x = 0; x < x_size; x += 4) {
-          unsigned char tb[16 * 4];
-          int mask = 0;
-          unsigned char *t = tb;
-          for (int i = 0; i < 16; ++i) {
-            int xi = x + i % 4;
-            int yi = y + i / 4;
-            unsigned const char *s = source_page + (yi * x_size + xi) * _num_components;
-            if (s < source_page_end) {
-              switch (_num_components) {
-              case 1:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
-
-              case 2:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = s[1];   // a
-                break;
-
-              case 3:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
-
-              case 4:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = s[3];   // a
-                break;
-              }
-              mask |= (1 << i);
-            }
-            t += 4;
-          }
-          squish::CompressMasked(tb, mask, d, squish_flags);
-          d += cell_size;
-          Thread::consider_yield();
-        }
+        SquishRow row;
+        row._dest = dest_page + (y / 4) * row_size;
+        row._source_page = source_page;
+        row._source_page_end = source_page + _ram_images[n]._page_size;
+        row._x_size = x_size;
+        row._y = y;
+        job._rows.push_back(row);
       }
     }
+    num_bytes += _ram_images[n]._image.size();
     compressed_ram_images.push_back(compressed_image);
   }
+
+  TextureWorkQueue::run(&squish_rows, &job, (int)job._rows.size(), num_bytes);
+
   _ram_images.swap(compressed_ram_images);
   _ram_image_compression = compression;
   return true;
@@ -6550,6 +6778,77 @@ do_squish(Texture::CompressionMode compression, int squish_flags) {
 #endif  // HAVE_SQUISH
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Texture::squish_rows
+//       Access: Private, Static
+//  Description: Compresses the rows [begin, end) of 4x4 cells for
+//               do_squish().  data is a SquishJob.
+////////////////////////////////////////////////////////////////////
+void Texture::
+squish_rows(void *data, int begin, int end) {
+#ifdef HAVE_SQUISH
+  const SquishJob &job = *(const SquishJob *)data;
+  int num_components = job._num_components;
+
+  for (int ri = begin; ri < end; ++ri) {
+    const SquishRow &row = job._rows[ri];
+    unsigned const char *source_page = row._source_page;
+    unsigned const char *source_page_end = row._source_page_end;
+    int x_size = row._x_size;
+    int y = row._y;
+
+    // Convert one 4 x 4 cell at a time.
+    unsigned char *d = row._dest;
+    for (int x = 0; x < x_size; x += 4) {
+      unsigned char tb[16 * 4];
+      int mask = 0;
+      unsigned char *t = tb;
+      for (int i = 0; i < 16; ++i) {
+        int xi = x + i % 4;
+        int yi = y + i / 4;
+        unsigned const char *s = source_page + (yi * x_size + xi) * num_components;
+        if (s < source_page_end) {
+          switch (num_components) {
+          case 1:
+            t[0] = s[0];   // r
+            t[1] = s[0];   // g
+            t[2] = s[0];   // b
+            t[3] = 255;    // a
+            break;
+
+          case 2:
+            t[0] = s[0];   // r
+            t[1] = s[0];   // g
+            t[2] = s[0];   // b
+            t[3] = s[1];   // a
+            break;
+
+          case 3:
+            t[0] = s[2];   // r
+            t[1] = s[1];   // g
+            t[2] = s[0];   // b
+            t[3] = 255;    // a
+            break;
+
+          case 4:
+            t[0] = s[2];   // r
+            t[1] = s[1];   // g
+            t[2] = s[0];   // b
+            t[3] = s[3];   // a
+            break;
+          }
+          mask |= (1 << i);
+        }
+        t += 4;
+      }
+      squish::CompressMasked(tb, mask, d, job._squish_flags);
+      d += job._cell_size;
+      Thread::consider_yield();
+    }
+  }
+#endif  // HAVE_SQUISH
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Texture::do_unsquish
 //       Access: Private
@@ -6644,6 +6943,32 @@ register_with_read_factory() {
   BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
 }
 
+////////////////////////////////////////////////////////////////////
+//       Class : BamRamImageDecodeJob
+// Description : Copies a RAM image out of the bam file, possibly
+//               on another thread, directly into the image array the
+//               Texture already holds; see BamReader::queue_decode().
+////////////////////////////////////////////////////////////////////
+class BamRamImageDecodeJob : public BamReader::DecodeJob {
+public:
+  BamRamImageDecodeJob(const PTA_uchar &image,
+                       const BamReader::Payload &payload) :
+    _image(image),
+    _payload(payload)
+  {
+  }
+
+  virtual void decode() {
+    _payload.extract_data(_image.p());
+    _payload.clear();
+    _image.clear();
+  }
+
+private:
+  PTA_uchar _image;
+  BamReader::Payload _payload;
+};
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Texture::make_from_bam
 //       Access: Protected, Static
@@ -6833,13 +7158,16 @@ fillin(DatagramIterator &scan, BamReader *manager, bool has_rawdata) {
         _ram_images[n]._page_size = scan.get_uint32();
       }
 
-      size_t u_size = scan.get_uint32();
+      BamReader::Payload payload;
+      manager->read_payload(scan, payload);
+      size_t u_size = payload.get_size();
 
-      // fill the _image buffer with image data
+      // fill the _image buffer with image data.  The BamReader may
+      // have this copied on another thread.  Even if the payload is
+      // mapped, we copy it, since a RAM image must be a PTA_uchar.
       PTA_uchar image = PTA_uchar::empty_array(u_size, get_class_type());
-      for (size_t u_idx = 0; u_idx < u_size; ++u_idx) {
-        image[(int)u_idx] = scan.get_uint8();
-      }
+      PT(BamRamImageDecodeJob) job = new BamRamImageDecodeJob(image, payload);
+      manager->queue_decode(this, job, u_size);
       _ram_images[n]._image = image;
     }
     _loaded_from_image = true;
@@ -7044,8 +7372,7 @@ write_datagram(BamWriter *manager, Datagram &me) {
     me.add_uint8(_ram_images.size());
     for (size_t n = 0; n < _ram_images.size(); ++n) {
       me.add_uint32(_ram_images[n]._page_size);
-      me.add_uint32(_ram_images[n]._image.size());
-      me.append_data(_ram_images[n]._image, _ram_images[n]._image.size());
+      manager->write_payload(me, _ram_images[n]._image.p(), _ram_images[n]._image.size());
     }
   }
 }
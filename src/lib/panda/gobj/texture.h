@@ -32,6 +32,7 @@
 #include "conditionVarFull.h"
 #include "loaderOptions.h"
 #include "string_utils.h"
+#include "atomicAdjust.h"
 
 class PNMImage;
 class TextureContext;
@@ -302,6 +303,18 @@ PUBLISHED:
   INLINE QualityLevel get_quality_level() const;
   INLINE QualityLevel get_effective_quality_level() const;
 
+  bool set_streaming(bool streaming);
+  INLINE bool get_streaming() const;
+  INLINE int get_stream_level() const;
+  INLINE int get_stream_tail_level() const;
+  INLINE int get_stream_full_x_size() const;
+  INLINE int get_stream_full_y_size() const;
+  bool set_stream_level(int level);
+  size_t get_stream_resident_size() const;
+  INLINE void note_stream_screen_size(int pixels);
+  INLINE int get_stream_screen_size() const;
+  INLINE int clear_stream_screen_size();
+
   INLINE int get_expected_num_mipmap_levels() const;
   INLINE int get_expected_mipmap_x_size(int n) const;
   INLINE int get_expected_mipmap_y_size(int n) const;
@@ -585,6 +598,12 @@ protected:
   virtual bool do_can_reload();
   bool do_reload();
 
+  bool do_can_stream() const;
+  int do_get_stream_tail_level() const;
+  void do_stream_trim();
+  void do_stream_drop_levels(int num_levels);
+  bool do_unlock_and_load_stream_level(int level);
+
   // This nested class declaration is used below.
   class RamImage {
   public:
@@ -676,7 +695,45 @@ private:
                                        const unsigned char *&q,
                                        size_t pixel_size, size_t row_size,
                                        size_t page_size);
-  
+
+  // The parameters of filter_2d_mipmap_pages() or
+  // filter_3d_mipmap_level(), shared by the threads of a
+  // TextureWorkQueue, each of which filters some of the rows of the
+  // new level.
+  class MipmapJob {
+  public:
+    unsigned char *_to;
+    const unsigned char *_from;
+    int _num_components;
+    int _x_size, _y_size, _z_size;
+    int _to_y_size;
+    size_t _pixel_size, _row_size, _page_size;
+    size_t _to_row_size, _to_page_size;
+    Filter2DComponent *_filter_2d;
+    Filter3DComponent *_filter_3d;
+  };
+  static void filter_2d_mipmap_rows(void *data, int begin, int end);
+  static void filter_3d_mipmap_rows(void *data, int begin, int end);
+
+  // Similarly, the parameters of do_squish(), which compresses each
+  // row of 4x4 cells of each page of each level independently.
+  class SquishRow {
+  public:
+    unsigned char *_dest;
+    const unsigned char *_source_page;
+    const unsigned char *_source_page_end;
+    int _x_size;
+    int _y;
+  };
+  class SquishJob {
+  public:
+    pvector<SquishRow> _rows;
+    int _num_components;
+    int _squish_flags;
+    int _cell_size;
+  };
+  static void squish_rows(void *data, int begin, int end);
+
   bool do_squish(CompressionMode compression, int squish_flags);
   bool do_unsquish(int squish_flags);
 
@@ -737,6 +794,19 @@ protected:
 
   int _orig_file_x_size;
   int _orig_file_y_size;
+
+  // If _streaming is true, only the mipmap levels from _stream_level
+  // down are kept: _x_size and _y_size describe level _stream_level
+  // of the full image, which is _stream_full_x_size by
+  // _stream_full_y_size.  A _stream_level of -1 means the tail level,
+  // to be determined when the image is loaded.
+  // _stream_screen_size is the largest size, in pixels, at which the
+  // texture has been seen since the TextureStreamManager last looked.
+  bool _streaming;
+  int _stream_level;
+  int _stream_full_x_size;
+  int _stream_full_y_size;
+  AtomicAdjust::Integer _stream_screen_size;
   
   // A Texture keeps a list (actually, a map) of all the
   // PreparedGraphicsObjects tables that it has been prepared into.
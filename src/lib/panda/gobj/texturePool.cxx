@@ -329,7 +329,11 @@ ns_load_texture(const Filename &orig_filename, int primary_file_num_channels,
     cache->store(record);
   }
 
-  if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
+  if (texture_streaming && tex->set_streaming(true)) {
+    // A streamed texture keeps just the tail of its mipmap chain in
+    // RAM; the TextureStreamManager loads the rest when it is needed.
+
+  } else if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
     // And now drop the RAM until we need it.
     tex->clear_ram_image();
   }
@@ -461,7 +465,11 @@ ns_load_texture(const Filename &orig_filename,
     cache->store(record);
   }
 
-  if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
+  if (texture_streaming && tex->set_streaming(true)) {
+    // A streamed texture keeps just the tail of its mipmap chain in
+    // RAM; the TextureStreamManager loads the rest when it is needed.
+
+  } else if (!(options.get_texture_flags() & LoaderOptions::TF_preload)) {
     // And now drop the RAM until we need it.
     tex->clear_ram_image();
   }
@@ -24,8 +24,14 @@ TypeHandle TextureReloadRequest::_type_handle;
 ////////////////////////////////////////////////////////////////////
 AsyncTask::DoneStatus TextureReloadRequest::
 do_task() {
-  // Don't reload the texture if it doesn't need it.
-  if (_texture->was_image_modified(_pgo)) {
+  if (_stream_level >= 0) {
+    // Load the finer mipmap levels of a streamed texture.  The
+    // texture is then re-prepared on each GSG the next time it is
+    // rendered, like any other texture whose image has changed.
+    _texture->set_stream_level(_stream_level);
+
+  } else if (_texture->was_image_modified(_pgo)) {
+    // Don't reload the texture if it doesn't need it.
     double delay = async_load_delay;
     if (delay != 0.0) {
       Thread::sleep(delay);
@@ -30,6 +30,10 @@
 //               the texture's image to be re-read from disk.  It is
 //               used by GraphicsStateGuardian::async_reload_texture(),
 //               when get_incomplete_render() is true.
+//
+//               It is also used by the TextureStreamManager to load
+//               the finer mipmap levels of a streamed texture, by
+//               calling Texture::set_stream_level() in a sub-thread.
 ////////////////////////////////////////////////////////////////////
 class EXPCL_PANDA_GOBJ TextureReloadRequest : public AsyncTask {
 public:
@@ -39,10 +43,13 @@ PUBLISHED:
   INLINE TextureReloadRequest(const string &name,
                               PreparedGraphicsObjects *pgo, Texture *texture,
                               bool allow_compressed);
+  INLINE TextureReloadRequest(const string &name, Texture *texture,
+                              int stream_level);
   
   INLINE PreparedGraphicsObjects *get_prepared_graphics_objects() const;
   INLINE Texture *get_texture() const;
   INLINE bool get_allow_compressed() const;
+  INLINE int get_stream_level() const;
   INLINE bool is_ready() const;
   
 protected:
@@ -52,6 +59,7 @@ private:
   PT(PreparedGraphicsObjects) _pgo;
   PT(Texture) _texture;
   bool _allow_compressed;
+  int _stream_level;
   bool _is_ready;
   
 public:
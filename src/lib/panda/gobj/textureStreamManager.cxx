@@ -0,0 +1,369 @@
+// Filename: textureStreamManager.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "textureStreamManager.h"
+#include "config_gobj.h"
+#include "clockObject.h"
+#include "mutexHolder.h"
+#include <algorithm>
+
+TextureStreamManager *TextureStreamManager::_global_ptr = NULL;
+Mutex TextureStreamManager::_global_lock("TextureStreamManager::_global_lock");
+
+PStatCollector TextureStreamManager::_resident_pcollector("Texture streaming:Resident");
+PStatCollector TextureStreamManager::_textures_pcollector("Texture streaming:Textures");
+PStatCollector TextureStreamManager::_pending_pcollector("Texture streaming:Pending");
+PStatCollector TextureStreamManager::_request_pcollector("Texture streaming operations:request");
+PStatCollector TextureStreamManager::_evict_pcollector("Texture streaming operations:evict");
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::Constructor
+//       Access: Protected
+//  Description: Sets up the "texture_stream" task chain, on which the
+//               finer mipmap levels are loaded.
+////////////////////////////////////////////////////////////////////
+TextureStreamManager::
+TextureStreamManager() :
+  _lock("TextureStreamManager::_lock"),
+  _budget(texture_stream_budget),
+  _resident_size(0),
+  _num_pending(0)
+{
+  _task_manager = AsyncTaskManager::get_global_ptr();
+  _task_chain = "texture_stream";
+
+  PT(AsyncTaskChain) chain = _task_manager->make_task_chain(_task_chain);
+  chain->set_num_threads(texture_stream_threads);
+  chain->set_thread_priority(TP_low);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::update
+//       Access: Published
+//  Description: Decides which mipmap levels each streamed texture
+//               should have, based on the sizes at which the textures
+//               have been seen on screen since the last call, and
+//               discards levels or issues requests to load them
+//               accordingly.  This is called once per frame by the
+//               GraphicsEngine.
+////////////////////////////////////////////////////////////////////
+void TextureStreamManager::
+update() {
+  Evictions evictions;
+  do_update(evictions);
+  if (!evictions.empty()) {
+    apply_evictions(evictions);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::do_update
+//       Access: Private
+//  Description: The implementation of update(), less the discarding
+//               of mipmap levels, which are instead added to the
+//               indicated list to be discarded by apply_evictions()
+//               after the lock has been released.
+////////////////////////////////////////////////////////////////////
+void TextureStreamManager::
+do_update(Evictions &evictions) {
+  Thread *current_thread = Thread::get_current_thread();
+  int frame = ClockObject::get_global_clock()->get_frame_count(current_thread);
+
+  MutexHolder holder(_lock);
+  if (_entries.empty()) {
+    return;
+  }
+
+  _resident_size = 0;
+  _num_pending = 0;
+
+  Candidates candidates;
+  candidates.reserve(_entries.size());
+
+  Entries::iterator ei = _entries.begin();
+  while (ei != _entries.end()) {
+    Entry &entry = (*ei).second;
+    Texture *tex = entry._texture;
+
+    if (entry._request != (TextureReloadRequest *)NULL &&
+        entry._request->is_ready()) {
+      if (tex->get_stream_level() > entry._request->get_stream_level()) {
+        // The texture couldn't be reloaded; don't keep trying.
+        entry._failed = true;
+      }
+      entry._request = NULL;
+    }
+    if (entry._request == (TextureReloadRequest *)NULL &&
+        (tex->get_ref_count() == 1 || !tex->get_streaming())) {
+      // No one else is using this texture any more, or it is no
+      // longer streamed.
+      Entries::iterator enext = ei;
+      ++enext;
+      _entries.erase(ei);
+      ei = enext;
+      continue;
+    }
+
+    entry._level = tex->get_stream_level();
+    entry._tail_level = tex->get_stream_tail_level();
+    entry._resident_size = tex->get_stream_resident_size();
+    _resident_size += entry._resident_size;
+
+    if (entry._wanted_level < 0 && entry._level >= 0) {
+      // Until it is seen, a texture needs only its tail.
+      entry._wanted_level = entry._tail_level;
+    }
+
+    int screen_size = tex->clear_stream_screen_size();
+    if (screen_size > 0) {
+      entry._last_seen_frame = frame;
+      entry._wanted_level =
+        compute_wanted_level(tex, entry._tail_level, screen_size);
+    } else if (frame - entry._last_seen_frame > texture_stream_idle_frames) {
+      entry._wanted_level = entry._tail_level;
+    }
+
+    if (entry._request != (TextureReloadRequest *)NULL) {
+      // While the finer levels are loading, count them against the
+      // budget, and leave the texture alone.
+      ++_num_pending;
+      int level = entry._request->get_stream_level();
+      _resident_size += (entry._resident_size << (2 * (entry._level - level))) - entry._resident_size;
+
+    } else if (entry._level >= 0) {
+      candidates.push_back(&entry);
+    }
+    ++ei;
+  }
+
+  if (_budget >= 0 && (PN_int64)_resident_size > _budget) {
+    sort(candidates.begin(), candidates.end(), CompareEvict());
+    evict(candidates, true, evictions);
+    if ((PN_int64)_resident_size > _budget) {
+      evict(candidates, false, evictions);
+    }
+  }
+
+  sort(candidates.begin(), candidates.end(), CompareRequest());
+  request(candidates);
+
+  _resident_pcollector.set_level(_resident_size);
+  _textures_pcollector.set_level(_entries.size());
+  _pending_pcollector.set_level(_num_pending);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::get_global_ptr
+//       Access: Published, Static
+//  Description: Returns the pointer to the global TextureStreamManager
+//               object.
+////////////////////////////////////////////////////////////////////
+TextureStreamManager *TextureStreamManager::
+get_global_ptr() {
+  MutexHolder holder(_global_lock);
+  if (_global_ptr == (TextureStreamManager *)NULL) {
+    _global_ptr = new TextureStreamManager;
+  }
+  return _global_ptr;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::add_texture
+//       Access: Public
+//  Description: Begins to manage the indicated texture.  This is
+//               called by Texture::set_streaming().
+////////////////////////////////////////////////////////////////////
+void TextureStreamManager::
+add_texture(Texture *tex) {
+  int frame = ClockObject::get_global_clock()->get_frame_count();
+
+  MutexHolder holder(_lock);
+  Entry &entry = _entries[tex];
+  if (entry._texture == (Texture *)NULL) {
+    entry._texture = tex;
+    entry._last_seen_frame = frame;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::remove_texture
+//       Access: Public
+//  Description: Stops managing the indicated texture.  This is
+//               called by Texture::set_streaming().  If a request to
+//               load its levels is still pending, the texture is
+//               dropped by the next update() after it is done.
+////////////////////////////////////////////////////////////////////
+void TextureStreamManager::
+remove_texture(Texture *tex) {
+  MutexHolder holder(_lock);
+  Entries::iterator ei = _entries.find(tex);
+  if (ei != _entries.end() &&
+      (*ei).second._request == (TextureReloadRequest *)NULL) {
+    _entries.erase(ei);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::compute_wanted_level
+//       Access: Private, Static
+//  Description: Returns the coarsest stream level of the texture
+//               whose finest mipmap level still has at least
+//               texture-stream-scale texels for each of the
+//               indicated number of pixels along its larger side.
+////////////////////////////////////////////////////////////////////
+int TextureStreamManager::
+compute_wanted_level(Texture *tex, int tail_level, int screen_size) {
+  int full_size = max(tex->get_stream_full_x_size(),
+                      tex->get_stream_full_y_size());
+  double wanted_size = screen_size * texture_stream_scale;
+
+  int level = 0;
+  while (level < tail_level && (full_size >> (level + 1)) >= wanted_size) {
+    ++level;
+  }
+  return level;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::evict
+//       Access: Private
+//  Description: Chooses mipmap levels to discard from the candidate
+//               textures, in order, one level at a time, until the
+//               resident size is within the budget, and adds them to
+//               the indicated list.  If wanted_only is true, only the
+//               levels finer than each texture needs are chosen;
+//               otherwise, all the levels finer than the tail are.
+//
+//               The entries are updated as if the levels had already
+//               been discarded, estimating that discarding a level
+//               leaves a quarter of the size behind, as request()
+//               estimates the reverse; apply_evictions() then
+//               corrects them.
+//
+//               Assumes the lock is held.
+////////////////////////////////////////////////////////////////////
+void TextureStreamManager::
+evict(Candidates &candidates, bool wanted_only, Evictions &evictions) {
+  Candidates::iterator ci;
+  for (ci = candidates.begin();
+       ci != candidates.end() && (PN_int64)_resident_size > _budget;
+       ++ci) {
+    Entry &entry = *(*ci);
+    int limit = wanted_only ? entry._wanted_level : entry._tail_level;
+
+    int from_level = entry._level;
+    while (entry._level < limit && (PN_int64)_resident_size > _budget) {
+      size_t size = entry._resident_size / 4;
+      _resident_size -= entry._resident_size - size;
+      entry._resident_size = size;
+      ++entry._level;
+    }
+
+    if (entry._level != from_level) {
+      Eviction eviction;
+      eviction._texture = entry._texture;
+      eviction._from_level = from_level;
+      eviction._level = entry._level;
+      evictions.push_back(eviction);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::apply_evictions
+//       Access: Private
+//  Description: Discards the mipmap levels chosen by evict(), and
+//               then replaces the estimated sizes of the textures
+//               with their actual sizes.
+//
+//               Assumes the lock is not held.
+////////////////////////////////////////////////////////////////////
+void TextureStreamManager::
+apply_evictions(const Evictions &evictions) {
+  Evictions::const_iterator vi;
+  for (vi = evictions.begin(); vi != evictions.end(); ++vi) {
+    if ((*vi)._texture->set_stream_level((*vi)._level)) {
+      _evict_pcollector.add_level((*vi)._level - (*vi)._from_level);
+    }
+  }
+
+  MutexHolder holder(_lock);
+  for (vi = evictions.begin(); vi != evictions.end(); ++vi) {
+    Entries::iterator ei = _entries.find((*vi)._texture);
+    if (ei == _entries.end()) {
+      // The texture was removed in the meantime.
+      continue;
+    }
+    Entry &entry = (*ei).second;
+    if (entry._request != (TextureReloadRequest *)NULL) {
+      // A request has been issued in the meantime; its levels are
+      // already counted.
+      continue;
+    }
+    size_t size = entry._texture->get_stream_resident_size();
+    _resident_size += size - entry._resident_size;
+    entry._resident_size = size;
+    entry._level = entry._texture->get_stream_level();
+  }
+
+  _resident_pcollector.set_level(_resident_size);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureStreamManager::request
+//       Access: Private
+//  Description: Issues requests to load the finer mipmap levels
+//               needed by the candidate textures, in order, as far
+//               as texture-stream-max-requests and the budget allow.
+//               A texture that cannot have all the levels it needs
+//               within the budget is given as many as fit.
+//
+//               Assumes the lock is held.
+////////////////////////////////////////////////////////////////////
+void TextureStreamManager::
+request(Candidates &candidates) {
+  Candidates::iterator ci;
+  for (ci = candidates.begin();
+       ci != candidates.end() && _num_pending < texture_stream_max_requests;
+       ++ci) {
+    Entry &entry = *(*ci);
+    if (entry._level <= entry._wanted_level || entry._failed) {
+      continue;
+    }
+
+    // Each finer level is four times the size of all of the levels
+    // below it, near enough.
+    int level = entry._level;
+    size_t size = entry._resident_size;
+    while (level > entry._wanted_level &&
+           (_budget < 0 ||
+            (PN_int64)(_resident_size - entry._resident_size + size * 4) <= _budget)) {
+      --level;
+      size *= 4;
+    }
+    if (level == entry._level) {
+      continue;
+    }
+
+    entry._request = new TextureReloadRequest
+      ("stream:" + entry._texture->get_name(), entry._texture, level);
+    entry._request->set_task_chain(_task_chain);
+    _task_manager->add(entry._request);
+
+    _resident_size += size - entry._resident_size;
+    ++_num_pending;
+    _request_pcollector.add_level(1);
+  }
+}
@@ -0,0 +1,141 @@
+// Filename: textureStreamManager.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef TEXTURESTREAMMANAGER_H
+#define TEXTURESTREAMMANAGER_H
+
+#include "pandabase.h"
+#include "texture.h"
+#include "textureReloadRequest.h"
+#include "asyncTaskManager.h"
+#include "pStatCollector.h"
+#include "pmutex.h"
+#include "pmap.h"
+#include "pointerTo.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : TextureStreamManager
+// Description : This keeps track of all of the streamed textures (see
+//               Texture::set_streaming()), and decides, once per
+//               frame, which of their mipmap levels should be in
+//               memory.
+//
+//               Each frame, the CullTraverser records the size on
+//               screen of each streamed texture it encounters.  From
+//               this, update() works out the finest mipmap level each
+//               texture needs, and issues a TextureReloadRequest, on
+//               the "texture_stream" task chain, for each texture
+//               that needs finer levels than it has.  If the total
+//               size of the levels in memory exceeds
+//               texture-stream-budget, it discards levels, finest
+//               first: first the levels that the textures no longer
+//               need, and then, from the textures seen least
+//               recently, the levels they do; but never the tail of
+//               the mipmap chain.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_GOBJ TextureStreamManager {
+protected:
+  TextureStreamManager();
+
+PUBLISHED:
+  INLINE void set_budget(PN_int64 budget);
+  INLINE PN_int64 get_budget() const;
+
+  INLINE int get_num_textures() const;
+  INLINE size_t get_resident_size() const;
+  INLINE int get_num_pending_requests() const;
+
+  void update();
+
+  static TextureStreamManager *get_global_ptr();
+
+public:
+  void add_texture(Texture *tex);
+  void remove_texture(Texture *tex);
+
+  INLINE static void flush_level();
+
+private:
+  class Entry {
+  public:
+    INLINE Entry();
+
+    PT(Texture) _texture;
+    PT(TextureReloadRequest) _request;
+    int _level;
+    int _tail_level;
+    int _wanted_level;
+    int _last_seen_frame;
+    size_t _resident_size;
+    bool _failed;
+  };
+  typedef pvector<Entry *> Candidates;
+
+  // The mipmap levels to be discarded from a texture.  These are
+  // chosen with the lock held, but discarded only after it has been
+  // released, since Texture::set_stream_level() may have to wait for
+  // a reload of the same texture to finish.
+  class Eviction {
+  public:
+    PT(Texture) _texture;
+    int _from_level;
+    int _level;
+  };
+  typedef pvector<Eviction> Evictions;
+
+  void do_update(Evictions &evictions);
+  static int compute_wanted_level(Texture *tex, int tail_level,
+                                  int screen_size);
+  void evict(Candidates &candidates, bool wanted_only,
+             Evictions &evictions);
+  void apply_evictions(const Evictions &evictions);
+  void request(Candidates &candidates);
+
+  class CompareEvict {
+  public:
+    INLINE bool operator () (const Entry *a, const Entry *b) const;
+  };
+  class CompareRequest {
+  public:
+    INLINE bool operator () (const Entry *a, const Entry *b) const;
+  };
+
+  // _lock protects all of the following members.
+  Mutex _lock;
+
+  typedef pmap<Texture *, Entry> Entries;
+  Entries _entries;
+
+  PN_int64 _budget;
+  size_t _resident_size;
+  int _num_pending;
+
+  PT(AsyncTaskManager) _task_manager;
+  string _task_chain;
+
+  static TextureStreamManager *_global_ptr;
+  static Mutex _global_lock;
+
+public:
+  static PStatCollector _resident_pcollector;
+  static PStatCollector _textures_pcollector;
+  static PStatCollector _pending_pcollector;
+  static PStatCollector _request_pcollector;
+  static PStatCollector _evict_pcollector;
+};
+
+#include "textureStreamManager.I"
+
+#endif
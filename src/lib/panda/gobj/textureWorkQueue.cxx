@@ -0,0 +1,212 @@
+// Filename: textureWorkQueue.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "textureWorkQueue.h"
+#include "config_gobj.h"
+#include "mutexHolder.h"
+
+#include <algorithm>
+
+TextureWorkQueue *TextureWorkQueue::_global_ptr = NULL;
+Mutex TextureWorkQueue::_global_lock("TextureWorkQueue::_global_lock");
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::WorkThread::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+TextureWorkQueue::WorkThread::
+WorkThread(TextureWorkQueue *queue, const string &name) :
+  Thread(name, name),
+  _queue(queue)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::WorkThread::thread_main
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+void TextureWorkQueue::WorkThread::
+thread_main() {
+  _queue->thread_run();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::Constructor
+//       Access: Protected
+//  Description: Starts the indicated number of worker threads, with
+//               the indicated name.  The threads are never stopped;
+//               they sleep while there is nothing to do.
+////////////////////////////////////////////////////////////////////
+TextureWorkQueue::
+TextureWorkQueue(int num_threads, const string &thread_name) :
+  _lock("TextureWorkQueue::_lock"),
+  _cvar(_lock)
+{
+  for (int i = 0; i < num_threads; ++i) {
+    PT(WorkThread) thread = new WorkThread(this, thread_name);
+    _threads.push_back(thread);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    _threads[i]->start(TP_normal, false);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::get_global_ptr
+//       Access: Public, Static
+//  Description: Returns the queue shared by all Textures, creating it
+//               and its threads the first time it is needed.  Returns
+//               NULL if parallel work is not available; see
+//               is_parallel_work_available().
+////////////////////////////////////////////////////////////////////
+TextureWorkQueue *TextureWorkQueue::
+get_global_ptr() {
+  if (!is_parallel_work_available()) {
+    return NULL;
+  }
+
+  MutexHolder holder(_global_lock);
+  if (_global_ptr == (TextureWorkQueue *)NULL) {
+    _global_ptr = new TextureWorkQueue(texture_work_threads, "TextureWorkThread");
+  }
+  return _global_ptr;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::is_parallel_work_available
+//       Access: Public, Static
+//  Description: Returns true if texture work may be shared with
+//               worker threads: that is, if threading is supported
+//               and texture-work-threads is greater than zero.
+////////////////////////////////////////////////////////////////////
+bool TextureWorkQueue::
+is_parallel_work_available() {
+  return Thread::is_true_threads() && texture_work_threads > 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::run
+//       Access: Public, Static
+//  Description: Calls func(data, begin, end) for consecutive ranges
+//               [begin, end) covering the items [0, num_items), and
+//               returns when all of them are done.  num_bytes is the
+//               size of the image being processed; if it is smaller
+//               than texture-work-min-size, or if parallel work is
+//               not available, func is simply called once on the
+//               calling thread for all of the items.  Otherwise, the
+//               ranges may be processed in any order, on any
+//               threads, so each item must be independent of the
+//               others.
+////////////////////////////////////////////////////////////////////
+void TextureWorkQueue::
+run(WorkFunc *func, void *data, int num_items, size_t num_bytes) {
+  if (num_items > 1 && num_bytes >= (size_t)max((int)texture_work_min_size, 0)) {
+    TextureWorkQueue *queue = get_global_ptr();
+    if (queue != (TextureWorkQueue *)NULL) {
+      queue->run_parallel(func, data, num_items);
+      return;
+    }
+  }
+
+  if (num_items > 0) {
+    (*func)(data, 0, num_items);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::run_parallel
+//       Access: Public
+//  Description: Divides the items [0, num_items) among the worker
+//               threads and the calling thread, as described in
+//               run(), regardless of the amount of work.
+////////////////////////////////////////////////////////////////////
+void TextureWorkQueue::
+run_parallel(WorkFunc *func, void *data, int num_items) {
+  if (num_items <= 0) {
+    return;
+  }
+
+  // Hand out the items in several chunks per thread, so that the
+  // threads finish at about the same time even if some items take
+  // longer than others.
+  Batch batch;
+  batch._func = func;
+  batch._data = data;
+  batch._num_items = num_items;
+  batch._chunk_size = max(num_items / ((get_num_threads() + 1) * 4), 1);
+  batch._next_item = 0;
+  batch._num_done = 0;
+
+  MutexHolder holder(_lock);
+  _batches.push_back(&batch);
+  _cvar.notify_all();
+
+  // The calling thread works on its own batch until there is nothing
+  // left to hand out, and then waits for the workers to finish theirs.
+  while (batch._next_item < batch._num_items) {
+    run_chunk(&batch);
+  }
+  while (batch._num_done < batch._num_items) {
+    _cvar.wait();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::thread_run
+//       Access: Private
+//  Description: The main loop of each worker thread.
+////////////////////////////////////////////////////////////////////
+void TextureWorkQueue::
+thread_run() {
+  MutexHolder holder(_lock);
+  while (true) {
+    while (_batches.empty()) {
+      _cvar.wait();
+    }
+    run_chunk(_batches.front());
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TextureWorkQueue::run_chunk
+//       Access: Private
+//  Description: Processes the next chunk of items from the batch,
+//               which must have some left to hand out.  _lock must be
+//               held on entry; it is released while the items are
+//               processed.
+////////////////////////////////////////////////////////////////////
+void TextureWorkQueue::
+run_chunk(Batch *batch) {
+  int begin = batch->_next_item;
+  int end = min(begin + batch->_chunk_size, batch->_num_items);
+  batch->_next_item = end;
+  if (end == batch->_num_items) {
+    // Nothing more to hand out; the batch itself lives on until its
+    // owner sees that it is done.
+    Batches::iterator bi = find(_batches.begin(), _batches.end(), batch);
+    nassertv(bi != _batches.end());
+    _batches.erase(bi);
+  }
+
+  _lock.release();
+  (*batch->_func)(batch->_data, begin, end);
+  _lock.acquire();
+
+  batch->_num_done += end - begin;
+  if (batch->_num_done == batch->_num_items) {
+    _cvar.notify_all();
+  }
+}
@@ -0,0 +1,102 @@
+// Filename: textureWorkQueue.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTUREWORKQUEUE_H
+#define TEXTUREWORKQUEUE_H
+
+#include "pandabase.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "conditionVarFull.h"
+#include "pdeque.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : TextureWorkQueue
+// Description : The pool of worker threads, shared by all Textures in
+//               the process, that help generate mipmap levels and
+//               compress RAM images.  Each piece of work is a range
+//               of independent items, such as the rows of a mipmap
+//               level or of a compressed image; the items are handed
+//               out in chunks to the workers and to the thread that
+//               requested the work, which returns only when all of
+//               them are done.  Several threads may submit work at
+//               once.
+//
+//               The number of threads is given by
+//               texture-work-threads.  Texture should normally use
+//               this class through run(), which does the work on
+//               the calling thread when the pool isn't available or
+//               isn't worthwhile.
+//
+//               VertexAnimationWorkQueue is a separate pool of the
+//               same kind, for computing animated vertices.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_GOBJ TextureWorkQueue {
+protected:
+  TextureWorkQueue(int num_threads, const string &thread_name);
+
+public:
+  typedef void WorkFunc(void *data, int begin, int end);
+
+  static TextureWorkQueue *get_global_ptr();
+  static bool is_parallel_work_available();
+
+  INLINE int get_num_threads() const;
+
+  static void run(WorkFunc *func, void *data, int num_items,
+                  size_t num_bytes);
+  void run_parallel(WorkFunc *func, void *data, int num_items);
+
+private:
+  class Batch {
+  public:
+    WorkFunc *_func;
+    void *_data;
+    int _num_items;
+    int _chunk_size;
+    int _next_item;
+    int _num_done;
+  };
+
+  void thread_run();
+  void run_chunk(Batch *batch);
+
+  class WorkThread : public Thread {
+  public:
+    WorkThread(TextureWorkQueue *queue, const string &name);
+    virtual void thread_main();
+
+    TextureWorkQueue *_queue;
+  };
+
+  // The batches that still have items not yet handed out.
+  typedef pdeque<Batch *> Batches;
+  Batches _batches;
+
+  typedef pvector< PT(WorkThread) > Threads;
+  Threads _threads;
+
+  // _lock protects _batches and the members of every Batch.  _cvar
+  // is notified both when a batch is added and when one is done.
+  Mutex _lock;
+  ConditionVarFull _cvar;
+
+  static TextureWorkQueue *_global_ptr;
+  static Mutex _global_lock;
+};
+
+#include "textureWorkQueue.I"
+
+#endif
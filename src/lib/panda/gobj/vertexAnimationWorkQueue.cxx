@@ -0,0 +1,94 @@
+// Filename: vertexAnimationWorkQueue.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "vertexAnimationWorkQueue.h"
+#include "config_gobj.h"
+#include "mutexHolder.h"
+
+VertexAnimationWorkQueue *VertexAnimationWorkQueue::_global_ptr = NULL;
+Mutex VertexAnimationWorkQueue::_global_lock("VertexAnimationWorkQueue::_global_lock");
+
+////////////////////////////////////////////////////////////////////
+//     Function: VertexAnimationWorkQueue::Constructor
+//       Access: Protected
+//  Description: Starts the indicated number of worker threads.
+////////////////////////////////////////////////////////////////////
+VertexAnimationWorkQueue::
+VertexAnimationWorkQueue(int num_threads) :
+  TextureWorkQueue(num_threads, "VertexAnimationThread")
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: VertexAnimationWorkQueue::get_global_ptr
+//       Access: Public, Static
+//  Description: Returns the queue shared by all GeomVertexDatas,
+//               creating it and its threads the first time it is
+//               needed.  Returns NULL if parallel work is not
+//               available; see is_parallel_work_available().
+////////////////////////////////////////////////////////////////////
+VertexAnimationWorkQueue *VertexAnimationWorkQueue::
+get_global_ptr() {
+  if (!is_parallel_work_available()) {
+    return NULL;
+  }
+
+  MutexHolder holder(_global_lock);
+  if (_global_ptr == (VertexAnimationWorkQueue *)NULL) {
+    _global_ptr = new VertexAnimationWorkQueue(vertex_animation_threads);
+  }
+  return _global_ptr;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: VertexAnimationWorkQueue::is_parallel_work_available
+//       Access: Public, Static
+//  Description: Returns true if vertex animation may be shared with
+//               worker threads: that is, if threading is supported
+//               and vertex-animation-threads is greater than zero.
+////////////////////////////////////////////////////////////////////
+bool VertexAnimationWorkQueue::
+is_parallel_work_available() {
+  return Thread::is_true_threads() && vertex_animation_threads > 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: VertexAnimationWorkQueue::run
+//       Access: Public, Static
+//  Description: Calls func(data, begin, end) for consecutive ranges
+//               [begin, end) covering the items [0, num_items), and
+//               returns when all of them are done.  num_rows is the
+//               total number of vertices to be animated; if it is
+//               smaller than vertex-animation-min-rows, or if
+//               parallel work is not available, func is simply
+//               called once on the calling thread for all of the
+//               items.  Otherwise, the ranges may be processed in any
+//               order, on any threads, so each item must be
+//               independent of the others.
+////////////////////////////////////////////////////////////////////
+void VertexAnimationWorkQueue::
+run(WorkFunc *func, void *data, int num_items, int num_rows) {
+  if (num_items > 1 && num_rows >= max((int)vertex_animation_min_rows, 0)) {
+    VertexAnimationWorkQueue *queue = get_global_ptr();
+    if (queue != (VertexAnimationWorkQueue *)NULL) {
+      queue->run_parallel(func, data, num_items);
+      return;
+    }
+  }
+
+  if (num_items > 0) {
+    (*func)(data, 0, num_items);
+  }
+}
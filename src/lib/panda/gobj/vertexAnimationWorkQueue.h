@@ -0,0 +1,48 @@
+// Filename: vertexAnimationWorkQueue.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef VERTEXANIMATIONWORKQUEUE_H
+#define VERTEXANIMATIONWORKQUEUE_H
+
+#include "pandabase.h"
+#include "textureWorkQueue.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : VertexAnimationWorkQueue
+// Description : The pool of worker threads, shared by all
+//               GeomVertexDatas in the process, that help compute
+//               soft-skinned vertices on the CPU, and the joint
+//               poses of a CharacterBatchEvaluator.  It works just like
+//               the TextureWorkQueue, but has its own threads, given
+//               by vertex-animation-threads, so that skinning and
+//               texture processing don't wait for each other.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_GOBJ VertexAnimationWorkQueue : public TextureWorkQueue {
+protected:
+  VertexAnimationWorkQueue(int num_threads);
+
+public:
+  static VertexAnimationWorkQueue *get_global_ptr();
+  static bool is_parallel_work_available();
+
+  static void run(WorkFunc *func, void *data, int num_items,
+                  int num_rows);
+
+private:
+  static VertexAnimationWorkQueue *_global_ptr;
+  static Mutex _global_lock;
+};
+
+#endif
@@ -43,6 +43,36 @@ operator = (const VertexDataBuffer &copy) {
   _block = copy._block;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: VertexDataBuffer::map_data
+//       Access: Public
+//  Description: Replaces the contents of the buffer with a view of
+//               size bytes of the indicated mapped file, beginning at
+//               start.  The data is not copied: the buffer goes
+//               straight to paged state, on a page of its own (see
+//               VertexDataPage::map_block()).  As with any paged
+//               buffer, a later attempt to modify it will copy it
+//               back into independent memory.
+////////////////////////////////////////////////////////////////////
+void VertexDataBuffer::
+map_data(MappedFile *mapped_file, size_t start, size_t size) {
+  LightMutexHolder holder(_lock);
+
+  if (_resident_data != (unsigned char *)NULL) {
+    get_class_type().dec_memory_usage(TypeHandle::MC_array, (int)_size);
+    PANDA_FREE_ARRAY(_resident_data);
+    _resident_data = NULL;
+  }
+  _block = NULL;
+  _size = 0;
+
+  if (size != 0) {
+    _block = VertexDataPage::map_block(mapped_file, start, size);
+    nassertv(_block != (VertexDataBlock *)NULL);
+    _size = size;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: VertexDataBuffer::do_clean_realloc
 //       Access: Private
@@ -18,6 +18,7 @@
 #include "pandabase.h"
 #include "vertexDataBook.h"
 #include "vertexDataBlock.h"
+#include "mappedFile.h"
 #include "pointerTo.h"
 #include "virtualFile.h"
 #include "pStatCollector.h"
@@ -42,6 +43,10 @@
 //               from the block.  However, this memory is considered
 //               read-only.
 //
+//               A buffer may also be put directly into paged state
+//               with map_data(), on a page that views a file mapped
+//               into memory.
+//
 //               VertexDataBuffers start out in independent state.
 //               They get moved to paged state when their owning
 //               GeomVertexArrayData objects get evicted from the
@@ -73,6 +78,7 @@ public:
   INLINE void clear();
 
   INLINE void page_out(VertexDataBook &book);
+  void map_data(MappedFile *mapped_file, size_t start, size_t size);
 
   INLINE void swap(VertexDataBuffer &other);
 
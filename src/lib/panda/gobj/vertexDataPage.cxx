@@ -76,6 +76,7 @@ VertexDataSaveFile *VertexDataPage::_save_file;
 // This mutex is (mostly) unused.  We just need a Mutex to pass
 // to the Book Constructor, below.
 Mutex VertexDataPage::_unused_mutex;
+Mutex VertexDataPage::_mapped_lock;
 
 PStatCollector VertexDataPage::_vdata_compress_pcollector("*:Vertex Data:Compress");
 PStatCollector VertexDataPage::_vdata_decompress_pcollector("*:Vertex Data:Decompress");
@@ -144,6 +145,32 @@ VertexDataPage(VertexDataBook *book, size_t page_size, size_t block_size) :
   set_ram_class(RC_resident);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: VertexDataPage::Mapped Constructor
+//       Access: Private
+//  Description: This constructor is used only by map_block(), to
+//               create a page that views size bytes of the mapped
+//               file, beginning at start.
+////////////////////////////////////////////////////////////////////
+VertexDataPage::
+VertexDataPage(MappedFile *mapped_file, size_t start, size_t size) :
+  SimpleAllocator(size, _mapped_lock),
+  SimpleLruPage(size),
+  _book_size(size),
+  _block_size(1),
+  _book(NULL),
+  _mapped_file(mapped_file)
+{
+  nassertv(start + size <= mapped_file->get_size());
+  _page_data = (unsigned char *)mapped_file->get_data() + start;
+  _size = size;
+  _allocated_size = 0;
+
+  _uncompressed_size = _size;
+  _ram_class = RC_resident;
+  _pending_ram_class = RC_resident;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: VertexDataPage::Destructor
 //       Access: Private, Virtual
@@ -164,7 +191,7 @@ VertexDataPage::
     }
   }
 
-  if (_page_data != NULL) {
+  if (_page_data != NULL && _mapped_file == (MappedFile *)NULL) {
     free_page_data(_page_data, _allocated_size);
     _size = 0;
   }
@@ -242,6 +269,28 @@ write(ostream &out, int indent_level) const {
   SimpleAllocator::write(out);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: VertexDataPage::map_block
+//       Access: Public, Static
+//  Description: Returns a new block that views size bytes of the
+//               mapped file, beginning at start, without copying
+//               them.  The block lies on a page of its own, which
+//               holds a reference to the file; the page goes away
+//               when the block is freed.
+//
+//               The block's data is read-only.
+////////////////////////////////////////////////////////////////////
+VertexDataBlock *VertexDataPage::
+map_block(MappedFile *mapped_file, size_t start, size_t size) {
+  nassertr(size != 0, NULL);
+  VertexDataPage *page = new VertexDataPage(mapped_file, start, size);
+
+  MutexHolder holder(_mapped_lock);
+  VertexDataBlock *block = page->do_alloc(size);
+  nassertr(block != (VertexDataBlock *)NULL && block->get_start() == 0, block);
+  return block;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: VertexDataPage::make_block
 //       Access: Protected, Virtual
@@ -262,6 +311,13 @@ make_block(size_t start, size_t size) {
 ////////////////////////////////////////////////////////////////////
 void VertexDataPage::
 changed_contiguous() {
+  if (do_is_empty() && _mapped_file != (MappedFile *)NULL) {
+    // A mapped page holds just the one block; when it is freed, the
+    // page goes too.
+    delete this;
+    return;
+  }
+
   if (do_is_empty()) {
     // If the page is now empty, delete it.
     VertexDataBook::Pages::iterator pi = _book->_pages.find(this);
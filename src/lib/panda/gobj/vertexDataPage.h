@@ -26,6 +26,7 @@
 #include "thread.h"
 #include "mutexHolder.h"
 #include "pdeque.h"
+#include "mappedFile.h"
 
 class VertexDataBook;
 class VertexDataBlock;
@@ -41,6 +42,7 @@ class EXPCL_PANDA_GOBJ VertexDataPage : public SimpleAllocator, public SimpleLru
 private:
   VertexDataPage(size_t book_size);
   VertexDataPage(VertexDataBook *book, size_t page_size, size_t block_size);
+  VertexDataPage(MappedFile *mapped_file, size_t start, size_t size);
   virtual ~VertexDataPage();
 
 PUBLISHED:
@@ -63,6 +65,7 @@ PUBLISHED:
   INLINE VertexDataBlock *get_first_block() const;
 
   INLINE VertexDataBook *get_book() const;
+  INLINE bool is_mapped() const;
 
   INLINE static SimpleLru *get_global_lru(RamClass rclass);
   INLINE static SimpleLru *get_pending_lru();
@@ -80,6 +83,9 @@ PUBLISHED:
   virtual void write(ostream &out, int indent_level) const;
 
 public:
+  static VertexDataBlock *map_block(MappedFile *mapped_file,
+                                    size_t start, size_t size);
+
   INLINE unsigned char *get_page_data(bool force);
   INLINE bool operator < (const VertexDataPage &other) const;
 
@@ -172,6 +178,11 @@ private:
 
   VertexDataBook *_book;  // never changes.
 
+  // If this is not NULL, the page is a view of part of a file mapped
+  // into memory, and _page_data points within it.  Such a page
+  // belongs to no book and no LRU, and is never evicted.
+  PT(MappedFile) _mapped_file;  // never changes.
+
   enum { deflate_page_size = 1024, inflate_page_size = 1024 };
 
   // We build up a temporary linked list of these while deflating
@@ -209,6 +220,7 @@ private:
   static VertexDataSaveFile *_save_file;
 
   static Mutex _unused_mutex;
+  static Mutex _mapped_lock;
 
   static PStatCollector _vdata_compress_pcollector;
   static PStatCollector _vdata_decompress_pcollector;
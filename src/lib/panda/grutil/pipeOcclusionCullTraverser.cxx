@@ -296,6 +296,17 @@ get_texture() {
   return _texture;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PipeOcclusionCullTraverser::is_occlusion_culling
+//       Access: Public, Virtual
+//  Description: Returns true if this traverser prunes nodes that are
+//               hidden behind other geometry.  This one always does.
+////////////////////////////////////////////////////////////////////
+bool PipeOcclusionCullTraverser::
+is_occlusion_culling() const {
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PipeOcclusionCullTraverser::is_in_view
 //       Access: Protected, Virtual
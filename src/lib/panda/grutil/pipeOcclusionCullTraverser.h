@@ -61,6 +61,9 @@ PUBLISHED:
   INLINE void set_occlusion_mask(const DrawMask &occlusion_mask);
   INLINE const DrawMask &get_occlusion_mask() const;
 
+public:
+  virtual bool is_occlusion_culling() const;
+
 protected:
   virtual bool is_in_view(CullTraverserData &data);
   virtual void traverse_below(CullTraverserData &data);
@@ -15,6 +15,7 @@
 #include "config_linmath.h"
 #include "luse.h"
 #include "coordinateSystem.h"
+#include "lsimd.h"
 
 #include "dconfig.h"
 
@@ -38,6 +39,14 @@ ConfigVariableBool temp_hpr_fix
           "to the other two.  Set this false if you need compatibility with "
           "Panda's old hpr calculations."));
 
+ConfigVariableString linmath_simd
+("linmath-simd", "auto",
+ PRC_DESC("Specifies which vectorized implementation of the core "
+          "single-precision matrix operations should be used.  This may "
+          "be \"sse2\", or \"none\" to use the original scalar code.  "
+          "The default, \"auto\", selects the best implementation that "
+          "the CPU supports."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_liblinmath
 //  Description: Initializes the library.  This must be called at
@@ -85,4 +94,6 @@ init_liblinmath() {
   LQuaterniond::init_type();
   LRotationd::init_type();
   LOrientationd::init_type();
+
+  LSimd::init();
 }
@@ -18,11 +18,13 @@
 #include "pandabase.h"
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
+#include "configVariableString.h"
 
 NotifyCategoryDecl(linmath, EXPCL_PANDA_LINMATH, EXPTP_PANDA_LINMATH);
 
 extern EXPCL_PANDA_LINMATH ConfigVariableBool paranoid_hpr_quat;
 extern EXPCL_PANDA_LINMATH ConfigVariableBool temp_hpr_fix;
+extern EXPCL_PANDA_LINMATH ConfigVariableString linmath_simd;
 
 extern EXPCL_PANDA_LINMATH void init_liblinmath();
 
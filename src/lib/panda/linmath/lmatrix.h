@@ -31,6 +31,7 @@
 #include "lvecBase4.h"
 #include "lvecBase3.h"
 #include "lvecBase2.h"
+#include "lsimd.h"
 
 #include "fltnames.h"
 // lmatrix3_src.h includes lmatrix4_src.h.
@@ -240,6 +240,29 @@ public:
   INLINE_LINMATH void generate_hash(ChecksumHashGenerator &hashgen) const;
   void generate_hash(ChecksumHashGenerator &hashgen, FLOATTYPE scale) const;
 
+public:
+  // These transform an array of points or vectors in one call, which
+  // allows the use of the vectorized kernels in LSimd.  The _data
+  // flavors accept arbitrary byte strides, e.g. for a column of
+  // vertex data; dest may be the same as source.
+  INLINE_LINMATH void
+  xform_point_array(FLOATNAME(LVecBase3) *dest,
+                    const FLOATNAME(LVecBase3) *source, int num_points) const;
+  INLINE_LINMATH void
+  xform_vec_array(FLOATNAME(LVecBase3) *dest,
+                  const FLOATNAME(LVecBase3) *source, int num_points) const;
+  INLINE_LINMATH void
+  xform_array(FLOATNAME(LVecBase4) *dest,
+              const FLOATNAME(LVecBase4) *source, int num_points) const;
+  INLINE_LINMATH void
+  xform_point_data(FLOATTYPE *dest, int dest_stride,
+                   const FLOATTYPE *source, int source_stride,
+                   int num_points) const;
+  INLINE_LINMATH void
+  xform_vec_data(FLOATTYPE *dest, int dest_stride,
+                 const FLOATTYPE *source, int source_stride,
+                 int num_points) const;
+
 public:
   union {
     struct {
@@ -0,0 +1,482 @@
+// Filename: lsimd.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "lsimd.h"
+#include "config_linmath.h"
+#include "string_utils.h"
+
+// The vectorized kernels are only compiled for x86 targets.  The
+// individual functions are tagged with the instruction set they
+// need, so that this file may be compiled without -msse2, and the
+// kernels are only called if the CPU supports them.
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define LSIMD_X86
+#define LSIMD_SSE2 __attribute__((target("sse2")))
+#include <cpuid.h>
+#include <emmintrin.h>
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define LSIMD_X86
+#define LSIMD_SSE2
+#include <intrin.h>
+#include <emmintrin.h>
+#endif
+
+LSimd::MultFunc *LSimd::_mult_mat4 = NULL;
+LSimd::InvertFunc *LSimd::_invert_mat4 = NULL;
+LSimd::MultFunc *LSimd::_mult_quat = NULL;
+LSimd::XformFunc *LSimd::_xform_points3 = NULL;
+LSimd::XformFunc *LSimd::_xform_vecs3 = NULL;
+LSimd::XformFunc *LSimd::_xform4 = NULL;
+LSimd::Level LSimd::_level = LSimd::L_none;
+
+#ifdef LSIMD_X86
+
+// Steps a strided float pointer to the next element.
+#define NEXT_ELEMENT(ptr, stride) \
+  ptr = (float *)((unsigned char *)(ptr) + (stride))
+#define NEXT_CONST_ELEMENT(ptr, stride) \
+  ptr = (const float *)((const unsigned char *)(ptr) + (stride))
+
+// Stores the first three components of v at dest, without touching
+// dest[3].
+#define STORE3(dest, v) { \
+  _mm_storel_pi((__m64 *)(dest), v); \
+  _mm_store_ss((dest) + 2, _mm_movehl_ps(v, v)); \
+}
+
+// Loads the next four 3-component elements from source, and returns
+// their x, y and z components in separate vectors.
+#define GATHER4(x, y, z, source, stride) { \
+  const float *s0 = source; NEXT_CONST_ELEMENT(source, stride); \
+  const float *s1 = source; NEXT_CONST_ELEMENT(source, stride); \
+  const float *s2 = source; NEXT_CONST_ELEMENT(source, stride); \
+  const float *s3 = source; NEXT_CONST_ELEMENT(source, stride); \
+  x = _mm_setr_ps(s0[0], s1[0], s2[0], s3[0]); \
+  y = _mm_setr_ps(s0[1], s1[1], s2[1], s3[1]); \
+  z = _mm_setr_ps(s0[2], s1[2], s2[2], s3[2]); \
+}
+
+// The inverse of GATHER4: transposes the x, y and z vectors back into
+// four 3-component elements, and stores them at dest.
+#define SCATTER4(dest, stride, x, y, z) { \
+  __m128 w = _mm_setzero_ps(); \
+  _MM_TRANSPOSE4_PS(x, y, z, w); \
+  STORE3(dest, x); NEXT_ELEMENT(dest, stride); \
+  STORE3(dest, y); NEXT_ELEMENT(dest, stride); \
+  STORE3(dest, z); NEXT_ELEMENT(dest, stride); \
+  STORE3(dest, w); NEXT_ELEMENT(dest, stride); \
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: sse2_mult_mat4
+//  Description: The SSE2 implementation of LSimd::mult_mat4().  Each
+//               row of the result is computed as a linear combination
+//               of the rows of b, summed in the same order as the
+//               scalar code, so the results are identical.
+////////////////////////////////////////////////////////////////////
+static LSIMD_SSE2 void
+sse2_mult_mat4(float *result, const float *a, const float *b) {
+  __m128 b0 = _mm_loadu_ps(b);
+  __m128 b1 = _mm_loadu_ps(b + 4);
+  __m128 b2 = _mm_loadu_ps(b + 8);
+  __m128 b3 = _mm_loadu_ps(b + 12);
+
+  for (int i = 0; i < 16; i += 4) {
+    __m128 r = _mm_mul_ps(_mm_set1_ps(a[i]), b0);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[i + 1]), b1));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[i + 2]), b2));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[i + 3]), b3));
+    _mm_storeu_ps(result + i, r);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: sse2_invert_mat4
+//  Description: The SSE2 implementation of LSimd::try_invert_mat4().
+//               This computes the adjugate by Cramer's rule, on the
+//               transposed matrix, and scales it by the reciprocal of
+//               the determinant.  Returns false if the matrix is
+//               singular, in which case result is unchanged.
+////////////////////////////////////////////////////////////////////
+static LSIMD_SSE2 bool
+sse2_invert_mat4(float *result, const float *src) {
+  __m128 minor0, minor1, minor2, minor3;
+  __m128 row0, row1, row2, row3;
+  __m128 det, tmp1;
+
+  // Load the matrix, transposing it on the way in.
+  __m128 s0 = _mm_loadu_ps(src);
+  __m128 s1 = _mm_loadu_ps(src + 4);
+  __m128 s2 = _mm_loadu_ps(src + 8);
+  __m128 s3 = _mm_loadu_ps(src + 12);
+
+  tmp1 = _mm_movelh_ps(s0, s1);
+  row1 = _mm_movelh_ps(s2, s3);
+  row0 = _mm_shuffle_ps(tmp1, row1, 0x88);
+  row1 = _mm_shuffle_ps(row1, tmp1, 0xDD);
+  tmp1 = _mm_movehl_ps(s1, s0);
+  row3 = _mm_movehl_ps(s3, s2);
+  row2 = _mm_shuffle_ps(tmp1, row3, 0x88);
+  row3 = _mm_shuffle_ps(row3, tmp1, 0xDD);
+
+  tmp1 = _mm_mul_ps(row2, row3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor0 = _mm_mul_ps(row1, tmp1);
+  minor1 = _mm_mul_ps(row0, tmp1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0);
+  minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
+  minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+  tmp1 = _mm_mul_ps(row1, row2);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0);
+  minor3 = _mm_mul_ps(row0, tmp1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1));
+  minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
+  minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+  tmp1 = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+  minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0);
+  minor2 = _mm_mul_ps(row0, tmp1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1));
+  minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
+  minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+  tmp1 = _mm_mul_ps(row0, row1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
+  minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
+  minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+
+  tmp1 = _mm_mul_ps(row0, row3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
+  minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
+  minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+
+  tmp1 = _mm_mul_ps(row0, row2);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
+  minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
+  minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
+
+  // The determinant is the dot product of the first row with its
+  // cofactors.
+  det = _mm_mul_ps(row0, minor0);
+  det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+  det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
+
+  // Like the scalar LU decomposition, we only reject a matrix that
+  // is exactly singular; a matrix with a tiny but nonzero determinant
+  // (e.g. a small uniform scale) is still perfectly invertible.
+  float det_value = _mm_cvtss_f32(det);
+  if (det_value == 0.0f) {
+    return false;
+  }
+
+  det = _mm_set1_ps(1.0f / det_value);
+  _mm_storeu_ps(result, _mm_mul_ps(det, minor0));
+  _mm_storeu_ps(result + 4, _mm_mul_ps(det, minor1));
+  _mm_storeu_ps(result + 8, _mm_mul_ps(det, minor2));
+  _mm_storeu_ps(result + 12, _mm_mul_ps(det, minor3));
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: sse2_mult_quat
+//  Description: The SSE2 implementation of LSimd::mult_quat().  Each
+//               component of the result is a signed sum of products
+//               of one component of a with a permutation of b.
+////////////////////////////////////////////////////////////////////
+static LSIMD_SSE2 void
+sse2_mult_quat(float *result, const float *a, const float *b) {
+  __m128 qb = _mm_loadu_ps(b);
+
+  // Column 0: a0 * (b0, b1, b2, b3)
+  __m128 r = _mm_mul_ps(_mm_set1_ps(a[0]), qb);
+
+  // Column 1: a1 * (-b1, b0, b3, -b2)
+  __m128 t = _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(2, 3, 0, 1));
+  t = _mm_mul_ps(t, _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[1]), t));
+
+  // Column 2: a2 * (-b2, -b3, b0, b1)
+  t = _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(1, 0, 3, 2));
+  t = _mm_mul_ps(t, _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[2]), t));
+
+  // Column 3: a3 * (-b3, b2, -b1, b0)
+  t = _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(0, 1, 2, 3));
+  t = _mm_mul_ps(t, _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[3]), t));
+
+  _mm_storeu_ps(result, r);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: sse2_xform_points3
+//  Description: The SSE2 implementation of LSimd::xform_points3().
+//               The points are processed four at a time: they are
+//               gathered into separate x, y and z vectors, so that
+//               each multiply-add operates on four points at once,
+//               and the results are transposed back on the way out.
+////////////////////////////////////////////////////////////////////
+static LSIMD_SSE2 void
+sse2_xform_points3(const float *mat, float *dest, int dest_stride,
+                   const float *source, int source_stride, int num_points) {
+  __m128 m00 = _mm_set1_ps(mat[0]);
+  __m128 m01 = _mm_set1_ps(mat[1]);
+  __m128 m02 = _mm_set1_ps(mat[2]);
+  __m128 m10 = _mm_set1_ps(mat[4]);
+  __m128 m11 = _mm_set1_ps(mat[5]);
+  __m128 m12 = _mm_set1_ps(mat[6]);
+  __m128 m20 = _mm_set1_ps(mat[8]);
+  __m128 m21 = _mm_set1_ps(mat[9]);
+  __m128 m22 = _mm_set1_ps(mat[10]);
+  __m128 m30 = _mm_set1_ps(mat[12]);
+  __m128 m31 = _mm_set1_ps(mat[13]);
+  __m128 m32 = _mm_set1_ps(mat[14]);
+
+  int n = 0;
+  for (; n + 4 <= num_points; n += 4) {
+    __m128 x, y, z;
+    GATHER4(x, y, z, source, source_stride);
+
+    __m128 rx = _mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10));
+    __m128 ry = _mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11));
+    __m128 rz = _mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12));
+    rx = _mm_add_ps(_mm_add_ps(rx, _mm_mul_ps(z, m20)), m30);
+    ry = _mm_add_ps(_mm_add_ps(ry, _mm_mul_ps(z, m21)), m31);
+    rz = _mm_add_ps(_mm_add_ps(rz, _mm_mul_ps(z, m22)), m32);
+
+    SCATTER4(dest, dest_stride, rx, ry, rz);
+  }
+
+  LSimd::scalar_xform_points3(mat, dest, dest_stride, source, source_stride,
+                              num_points - n);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: sse2_xform_vecs3
+//  Description: The SSE2 implementation of LSimd::xform_vecs3().
+//               This works like sse2_xform_points3().
+////////////////////////////////////////////////////////////////////
+static LSIMD_SSE2 void
+sse2_xform_vecs3(const float *mat, float *dest, int dest_stride,
+                 const float *source, int source_stride, int num_points) {
+  __m128 m00 = _mm_set1_ps(mat[0]);
+  __m128 m01 = _mm_set1_ps(mat[1]);
+  __m128 m02 = _mm_set1_ps(mat[2]);
+  __m128 m10 = _mm_set1_ps(mat[4]);
+  __m128 m11 = _mm_set1_ps(mat[5]);
+  __m128 m12 = _mm_set1_ps(mat[6]);
+  __m128 m20 = _mm_set1_ps(mat[8]);
+  __m128 m21 = _mm_set1_ps(mat[9]);
+  __m128 m22 = _mm_set1_ps(mat[10]);
+
+  int n = 0;
+  for (; n + 4 <= num_points; n += 4) {
+    __m128 x, y, z;
+    GATHER4(x, y, z, source, source_stride);
+
+    __m128 rx = _mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10));
+    __m128 ry = _mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11));
+    __m128 rz = _mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12));
+    rx = _mm_add_ps(rx, _mm_mul_ps(z, m20));
+    ry = _mm_add_ps(ry, _mm_mul_ps(z, m21));
+    rz = _mm_add_ps(rz, _mm_mul_ps(z, m22));
+
+    SCATTER4(dest, dest_stride, rx, ry, rz);
+  }
+
+  LSimd::scalar_xform_vecs3(mat, dest, dest_stride, source, source_stride,
+                            num_points - n);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: sse2_xform4
+//  Description: The SSE2 implementation of LSimd::xform4().
+////////////////////////////////////////////////////////////////////
+static LSIMD_SSE2 void
+sse2_xform4(const float *mat, float *dest, int dest_stride,
+            const float *source, int source_stride, int num_points) {
+  __m128 m0 = _mm_loadu_ps(mat);
+  __m128 m1 = _mm_loadu_ps(mat + 4);
+  __m128 m2 = _mm_loadu_ps(mat + 8);
+  __m128 m3 = _mm_loadu_ps(mat + 12);
+
+  for (int n = 0; n < num_points; ++n) {
+    __m128 r = _mm_mul_ps(_mm_set1_ps(source[0]), m0);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(source[1]), m1));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(source[2]), m2));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(source[3]), m3));
+    _mm_storeu_ps(dest, r);
+    NEXT_CONST_ELEMENT(source, source_stride);
+    NEXT_ELEMENT(dest, dest_stride);
+  }
+}
+
+#endif  // LSIMD_X86
+
+////////////////////////////////////////////////////////////////////
+//     Function: LSimd::get_supported_level
+//       Access: Public, Static
+//  Description: Returns the highest level of vectorization that the
+//               current CPU supports, and for which kernels have been
+//               compiled in.
+////////////////////////////////////////////////////////////////////
+LSimd::Level LSimd::
+get_supported_level() {
+  static Level supported_level = detect_level();
+  return supported_level;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: LSimd::set_level
+//       Access: Public, Static
+//  Description: Selects the set of kernels to use for the
+//               single-precision operations.  If the requested level
+//               is not supported, the highest supported level below
+//               it is used instead.
+//
+//               This is intended to be called at startup (it is
+//               called by init()), or by benchmarks that wish to
+//               compare the different implementations; it is not
+//               safe to call while other threads are using linmath.
+////////////////////////////////////////////////////////////////////
+void LSimd::
+set_level(Level level) {
+  if (level > get_supported_level()) {
+    level = get_supported_level();
+  }
+
+  _mult_mat4 = NULL;
+  _invert_mat4 = NULL;
+  _mult_quat = NULL;
+  _xform_points3 = NULL;
+  _xform_vecs3 = NULL;
+  _xform4 = NULL;
+
+#ifdef LSIMD_X86
+  switch (level) {
+  case L_sse2:
+    _mult_mat4 = &sse2_mult_mat4;
+    _invert_mat4 = &sse2_invert_mat4;
+    _mult_quat = &sse2_mult_quat;
+    _xform_points3 = &sse2_xform_points3;
+    _xform_vecs3 = &sse2_xform_vecs3;
+    _xform4 = &sse2_xform4;
+    break;
+
+  case L_none:
+    break;
+  }
+#endif  // LSIMD_X86
+
+  _level = level;
+
+  if (linmath_cat.is_debug()) {
+    linmath_cat.debug()
+      << "Using " << get_level_name(_level) << " linmath kernels.\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: LSimd::get_level_name
+//       Access: Public, Static
+//  Description: Returns a human-readable name for the indicated
+//               level, as accepted by the linmath-simd config
+//               variable.
+////////////////////////////////////////////////////////////////////
+const char *LSimd::
+get_level_name(Level level) {
+  switch (level) {
+  case L_none:
+    return "none";
+
+  case L_sse2:
+    return "sse2";
+  }
+
+  return "**invalid**";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: LSimd::init
+//       Access: Public, Static
+//  Description: Selects the kernels according to the linmath-simd
+//               config variable and the capabilities of the CPU.
+//               This is called by init_liblinmath().
+////////////////////////////////////////////////////////////////////
+void LSimd::
+init() {
+  string name = downcase(linmath_simd.get_value());
+  Level level = get_supported_level();
+
+  if (name == "none" || name == "0" || name == "#f" || name == "false") {
+    level = L_none;
+  } else if (name == "sse2" || name == "auto" || name.empty()) {
+    level = min(level, L_sse2);
+  } else {
+    linmath_cat.warning()
+      << "Invalid linmath-simd value: " << linmath_simd.get_value() << "\n";
+  }
+
+  set_level(level);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: LSimd::detect_level
+//       Access: Private, Static
+//  Description: Queries the CPU for the instruction sets it supports.
+////////////////////////////////////////////////////////////////////
+LSimd::Level LSimd::
+detect_level() {
+#ifdef LSIMD_X86
+  unsigned int ecx, edx;
+
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  ecx = (unsigned int)info[2];
+  edx = (unsigned int)info[3];
+#else
+  unsigned int eax, ebx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return L_none;
+  }
+#endif
+
+  // Bit 26 of edx advertises SSE2.
+  if ((edx & (1 << 26)) != 0) {
+    return L_sse2;
+  }
+  return L_none;
+
+#else  // LSIMD_X86
+  return L_none;
+#endif  // LSIMD_X86
+}
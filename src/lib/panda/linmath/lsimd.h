@@ -0,0 +1,133 @@
+// Filename: lsimd.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef LSIMD_H
+#define LSIMD_H
+
+#include "pandabase.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : LSimd
+// Description : This class collects the handful of low-level kernels
+//               in linmath that have hand-vectorized implementations:
+//               the 4x4 matrix product and inverse, quaternion
+//               products, and transforming arrays of points and
+//               vectors by a matrix.
+//
+//               The vectorized implementations operate only on
+//               single-precision data, and are selected at runtime
+//               according to the capabilities of the CPU (and the
+//               linmath-simd config variable).  Only SSE2 kernels are
+//               provided: with 4x4 matrices and interleaved vertex
+//               data, 256-bit AVX kernels spend more time moving data
+//               between lanes than they save, and measured slower.
+//               The double-precision overloads, and the
+//               single-precision overloads when no vectorized
+//               implementation is available, are simply the original
+//               scalar code.
+//
+//               The matrix functions all operate on 16-element arrays
+//               in row-major order, with the row-vector convention
+//               used throughout linmath; the quaternion functions
+//               operate on 4-element arrays in (r, i, j, k) order.
+//               Strides are given in bytes.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_LINMATH LSimd {
+public:
+  enum Level {
+    L_none,
+    L_sse2
+  };
+
+  static Level get_supported_level();
+  INLINE static Level get_level();
+  static void set_level(Level level);
+  static const char *get_level_name(Level level);
+
+  static void init();
+
+  INLINE static void mult_mat4(float *result, const float *a, const float *b);
+  INLINE static void mult_mat4(double *result, const double *a, const double *b);
+
+  INLINE static bool try_invert_mat4(float *result, const float *mat,
+                                     bool &invertible);
+  INLINE static bool try_invert_mat4(double *result, const double *mat,
+                                     bool &invertible);
+
+  INLINE static void mult_quat(float *result, const float *a, const float *b);
+  INLINE static void mult_quat(double *result, const double *a, const double *b);
+
+  INLINE static void xform_points3(const float *mat, float *dest, int dest_stride,
+                                   const float *source, int source_stride,
+                                   int num_points);
+  INLINE static void xform_points3(const double *mat, double *dest, int dest_stride,
+                                   const double *source, int source_stride,
+                                   int num_points);
+  INLINE static void xform_vecs3(const float *mat, float *dest, int dest_stride,
+                                 const float *source, int source_stride,
+                                 int num_points);
+  INLINE static void xform_vecs3(const double *mat, double *dest, int dest_stride,
+                                 const double *source, int source_stride,
+                                 int num_points);
+  INLINE static void xform4(const float *mat, float *dest, int dest_stride,
+                            const float *source, int source_stride,
+                            int num_points);
+  INLINE static void xform4(const double *mat, double *dest, int dest_stride,
+                            const double *source, int source_stride,
+                            int num_points);
+
+public:
+  // The scalar implementations.  These are also used to finish off
+  // the few elements left over by the vectorized kernels.
+  template<class Type>
+  INLINE static void scalar_mult_mat4(Type *result, const Type *a, const Type *b);
+  template<class Type>
+  INLINE static void scalar_mult_quat(Type *result, const Type *a, const Type *b);
+  template<class Type>
+  INLINE static void scalar_xform_points3(const Type *mat, Type *dest, int dest_stride,
+                                          const Type *source, int source_stride,
+                                          int num_points);
+  template<class Type>
+  INLINE static void scalar_xform_vecs3(const Type *mat, Type *dest, int dest_stride,
+                                        const Type *source, int source_stride,
+                                        int num_points);
+  template<class Type>
+  INLINE static void scalar_xform4(const Type *mat, Type *dest, int dest_stride,
+                                   const Type *source, int source_stride,
+                                   int num_points);
+
+private:
+  static Level detect_level();
+
+  typedef void MultFunc(float *result, const float *a, const float *b);
+  typedef bool InvertFunc(float *result, const float *mat);
+  typedef void XformFunc(const float *mat, float *dest, int dest_stride,
+                         const float *source, int source_stride,
+                         int num_points);
+
+  // These are NULL when no vectorized implementation is selected, in
+  // which case the inline scalar code is used instead.
+  static MultFunc *_mult_mat4;
+  static InvertFunc *_invert_mat4;
+  static MultFunc *_mult_quat;
+  static XformFunc *_xform_points3;
+  static XformFunc *_xform_vecs3;
+  static XformFunc *_xform4;
+
+  static Level _level;
+};
+
+#include "lsimd.I"
+
+#endif
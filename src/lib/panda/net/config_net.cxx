@@ -116,3 +116,24 @@ get_max_poll_cycle() {
 
   return *max_poll_cycle;
 }
+
+bool
+get_net_use_epoll() {
+  static ConfigVariableBool *net_use_epoll = NULL;
+
+  if (net_use_epoll == (ConfigVariableBool *)NULL) {
+    net_use_epoll = new ConfigVariableBool
+      ("net-use-epoll", false,
+       PRC_DESC("Set this true to make each new ConnectionReader use "
+                "epoll, rather than select(), to wait for activity on "
+                "its sockets.  This is only available on Linux, and is "
+                "recommended for servers that need to handle more "
+                "connections than fit in a select() set (normally "
+                "1024), or that need to handle many connections "
+                "efficiently.  Each reader thread then runs its own "
+                "event loop over a share of the sockets.  This must be "
+                "set before the ConnectionReader is created."));
+  }
+
+  return *net_use_epoll;
+}
@@ -28,6 +28,7 @@ extern int get_net_max_write_queue();
 extern int get_net_max_response_queue();
 extern bool get_net_error_abort();
 extern double get_max_poll_cycle();
+extern bool get_net_use_epoll();
 
 extern EXPCL_PANDA_NET void init_libnet();
 
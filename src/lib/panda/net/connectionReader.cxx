@@ -27,10 +27,18 @@
 #include "atomicAdjust.h"
 #include "dcast.h"
 
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#include <errno.h>
+#endif  // HAVE_EPOLL
+
 static const int read_buffer_size = maximum_udp_datagram + datagram_udp_header_size;
 
 static const int max_timeout_ms = 100;
 
+// The number of events collected by a single epoll_wait() call.
+static const int max_epoll_events = 256;
+
 ////////////////////////////////////////////////////////////////////
 //     Function: ConnectionReader::SocketInfo::Constructor
 //       Access: Public
@@ -42,6 +50,9 @@ SocketInfo(const PT(Connection) &connection) :
 {
   _busy = false;
   _error = false;
+  _loop_index = 0;
+  _stream = false;
+  _rearm = false;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -123,6 +134,34 @@ ConnectionReader(ConnectionManager *manager, int num_threads) :
 
   _currently_polling_thread = -1;
 
+  _use_epoll = false;
+#ifdef HAVE_EPOLL
+  _next_loop_index = 0;
+  if (get_net_use_epoll()) {
+    // Each thread gets its own event loop; a polling reader needs
+    // just one.
+    int num_loops = max(num_threads, 1);
+    _use_epoll = true;
+    for (int li = 0; li < num_loops; ++li) {
+      int fd = epoll_create1(EPOLL_CLOEXEC);
+      if (fd == -1) {
+        net_cat.warning()
+          << "Unable to create epoll instance, using select() instead.\n";
+        _use_epoll = false;
+        break;
+      }
+      _epoll_fds.push_back(fd);
+    }
+    if (!_use_epoll) {
+      EpollFds::iterator fi;
+      for (fi = _epoll_fds.begin(); fi != _epoll_fds.end(); ++fi) {
+        close(*fi);
+      }
+      _epoll_fds.clear();
+    }
+  }
+#endif  // HAVE_EPOLL
+
   int i;
   for (i = 0; i < num_threads; i++) {
     PT(ReaderThread) thread = new ReaderThread(this, i);
@@ -148,6 +187,14 @@ ConnectionReader::
 
   shutdown();
 
+#ifdef HAVE_EPOLL
+  EpollFds::iterator fi;
+  for (fi = _epoll_fds.begin(); fi != _epoll_fds.end(); ++fi) {
+    close(*fi);
+  }
+  _epoll_fds.clear();
+#endif  // HAVE_EPOLL
+
   // Delete all of our old sockets.
   Sockets::iterator si;
   for (si = _sockets.begin(); si != _sockets.end(); ++si) {
@@ -200,7 +247,14 @@ add_connection(Connection *connection) {
     }
   }
 
-  _sockets.push_back(new SocketInfo(connection));
+  SocketInfo *sinfo = new SocketInfo(connection);
+#ifdef HAVE_EPOLL
+  if (_use_epoll && !epoll_add(sinfo)) {
+    delete sinfo;
+    return false;
+  }
+#endif  // HAVE_EPOLL
+  _sockets.push_back(sinfo);
 
   return true;
 }
@@ -230,6 +284,12 @@ remove_connection(Connection *connection) {
     return false;
   }
 
+#ifdef HAVE_EPOLL
+  if (_use_epoll) {
+    epoll_remove(*si);
+  }
+#endif  // HAVE_EPOLL
+
   _removed_sockets.push_back(*si);
   _sockets.erase(si);
 
@@ -287,6 +347,23 @@ poll() {
     return;
   }
 
+#ifdef HAVE_EPOLL
+  if (_use_epoll) {
+    double max_poll_cycle = get_max_poll_cycle();
+    TrueClock *global_clock = TrueClock::get_global_ptr();
+    double stop = global_clock->get_short_time() + max_poll_cycle;
+
+    // Keep collecting events until there are none left, or we run
+    // out of time.
+    while (epoll_service(0, 0) > 0) {
+      if (max_poll_cycle >= 0.0 && global_clock->get_short_time() >= stop) {
+        return;
+      }
+    }
+    return;
+  }
+#endif  // HAVE_EPOLL
+
   SocketInfo *sinfo = get_next_available_socket(false, -2);
   if (sinfo != (SocketInfo *)NULL) {
     double max_poll_cycle = get_max_poll_cycle();
@@ -750,6 +827,17 @@ thread_run(int thread_index) {
   nassertv(!_polling);
   nassertv(_threads[thread_index] == Thread::get_current_thread());
 
+#ifdef HAVE_EPOLL
+  if (_use_epoll) {
+    // We never wait indefinitely, so we can check the shutdown flag
+    // every once in a while.
+    while (!_shutdown) {
+      epoll_service(thread_index, max_timeout_ms);
+    }
+    return;
+  }
+#endif  // HAVE_EPOLL
+
   while (!_shutdown) {
     SocketInfo *sinfo =
       get_next_available_socket(false, thread_index);
@@ -875,8 +963,21 @@ rebuild_select_list() {
 
   // This is also a fine time to delete the contents of the
   // _removed_sockets list.
+  delete_removed_sockets();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::delete_removed_sockets
+//       Access: Private
+//  Description: Deletes the SocketInfo objects on the
+//               _removed_sockets list that are no longer busy.
+//               Assumes _sockets_mutex is held.
+////////////////////////////////////////////////////////////////////
+void ConnectionReader::
+delete_removed_sockets() {
   if (!_removed_sockets.empty()) {
     Sockets still_busy_sockets;
+    Sockets::const_iterator si;
     for (si = _removed_sockets.begin(); si != _removed_sockets.end(); ++si) {
       SocketInfo *sinfo = (*si);
       if (sinfo->_busy) {
@@ -888,3 +989,251 @@ rebuild_select_list() {
     _removed_sockets.swap(still_busy_sockets);
   }
 }
+
+#ifdef HAVE_EPOLL
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::epoll_add
+//       Access: Private
+//  Description: Assigns the indicated socket to one of the event
+//               loops and registers it with that loop's epoll
+//               descriptor.  Returns true on success, false on
+//               failure.  Assumes _sockets_mutex is held.
+////////////////////////////////////////////////////////////////////
+bool ConnectionReader::
+epoll_add(SocketInfo *sinfo) {
+  int fd = sinfo->get_socket()->GetSocket();
+
+  // An ordinary TCP connection is read with edge-triggered,
+  // non-blocking reads; see process_incoming_tcp_stream().  Anything
+  // else (a UDP socket, or a rendezvous socket on a
+  // ConnectionListener) is read one event at a time with
+  // process_incoming_data(), as with select().
+  sinfo->_stream = sinfo->get_socket()->is_exact_type(Socket_TCP::get_class_type());
+  sinfo->_loop_index = _next_loop_index;
+  _next_loop_index = (_next_loop_index + 1) % (int)_epoll_fds.size();
+
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  if (sinfo->_stream) {
+    event.events |= EPOLLRDHUP | EPOLLET;
+  }
+  event.data.fd = fd;
+
+  if (epoll_ctl(_epoll_fds[sinfo->_loop_index], EPOLL_CTL_ADD, fd, &event) != 0) {
+    net_cat.error()
+      << "Unable to add socket " << fd << " to epoll set: "
+      << strerror(errno) << "\n";
+    return false;
+  }
+
+  _epoll_sockets[fd] = sinfo;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::epoll_remove
+//       Access: Private
+//  Description: Removes the indicated socket from its event loop.
+//               Assumes _sockets_mutex is held.
+////////////////////////////////////////////////////////////////////
+void ConnectionReader::
+epoll_remove(SocketInfo *sinfo) {
+  int fd = sinfo->get_socket()->GetSocket();
+
+  // This may fail harmlessly if the socket has already been closed,
+  // which removes it from the set implicitly.
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  epoll_ctl(_epoll_fds[sinfo->_loop_index], EPOLL_CTL_DEL, fd, &event);
+
+  EpollSockets::iterator ei = _epoll_sockets.find(fd);
+  if (ei != _epoll_sockets.end() && (*ei).second == sinfo) {
+    _epoll_sockets.erase(ei);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::epoll_service
+//       Access: Private
+//  Description: Waits up to timeout_ms milliseconds for activity on
+//               the sockets of the indicated event loop, and
+//               processes all of the sockets that have any.  Returns
+//               the number of events collected, or -1 on error.
+////////////////////////////////////////////////////////////////////
+int ConnectionReader::
+epoll_service(int loop_index, int timeout_ms) {
+  nassertr(loop_index >= 0 && loop_index < (int)_epoll_fds.size(), -1);
+
+  struct epoll_event events[max_epoll_events];
+  int num_events = epoll_wait(_epoll_fds[loop_index], events, max_epoll_events, timeout_ms);
+  if (num_events < 0) {
+    if (errno != EINTR) {
+      net_cat.error()
+        << "epoll_wait failed: " << strerror(errno) << "\n";
+      return -1;
+    }
+    return 0;
+  }
+
+  for (int i = 0; i < num_events && !_shutdown; ++i) {
+    SocketInfo *sinfo;
+    {
+      LightMutexHolder holder(_sockets_mutex);
+      EpollSockets::iterator ei = _epoll_sockets.find(events[i].data.fd);
+      if (ei == _epoll_sockets.end()) {
+        // The socket has been removed since the event was queued.
+        continue;
+      }
+      sinfo = (*ei).second;
+      if (sinfo->_busy || sinfo->_error) {
+        // Another thread is already reading this socket (which can
+        // happen only if its descriptor was recycled from a socket on
+        // another loop).  Tell that thread to go around again.
+        sinfo->_rearm = true;
+        continue;
+      }
+      sinfo->_busy = true;
+    }
+
+    if (sinfo->_stream) {
+      process_incoming_tcp_stream(sinfo);
+    } else {
+      process_incoming_data(sinfo);
+    }
+  }
+
+  {
+    LightMutexHolder holder(_sockets_mutex);
+    delete_removed_sockets();
+  }
+
+  return num_events;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::process_incoming_tcp_stream
+//       Access: Private
+//  Description: This is the epoll equivalent of
+//               process_incoming_tcp_data() (or
+//               process_raw_incoming_tcp_data(), in raw mode).  Since
+//               the socket is edge-triggered, we must read everything
+//               that is available, without blocking, before we
+//               return; any partial datagram at the end is saved in
+//               the SocketInfo until the rest of it arrives.
+////////////////////////////////////////////////////////////////////
+void ConnectionReader::
+process_incoming_tcp_stream(SocketInfo *sinfo) {
+  Socket_TCP *socket;
+  DCAST_INTO_V(socket, sinfo->get_socket());
+  int fd = socket->GetSocket();
+  NetAddress address(socket->GetPeerName());
+
+  char buffer[read_buffer_size];
+  bool closed = false;
+
+  while (!closed) {
+    while (!_shutdown) {
+      int bytes_read = recv(fd, buffer, read_buffer_size, MSG_DONTWAIT);
+      if (bytes_read > 0) {
+        if (_raw_mode || _tcp_header_size == 0) {
+          // In raw mode, each read is a datagram.
+          NetDatagram datagram(buffer, bytes_read);
+          datagram.set_connection(sinfo->_connection);
+          datagram.set_address(address);
+          receive_datagram(datagram);
+        } else {
+          sinfo->_stream_data.append(buffer, bytes_read);
+          if (!extract_stream_datagrams(sinfo, address)) {
+            // The stream is corrupt; there's no way to resynchronize.
+            closed = true;
+            break;
+          }
+        }
+
+      } else if (bytes_read < 0 && errno == EINTR) {
+        continue;
+
+      } else if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        // We've read everything there is.
+        break;
+
+      } else {
+        // The socket was closed, or failed.
+        closed = true;
+        break;
+      }
+    }
+
+    if (!closed) {
+      // Before we let go of the socket, make sure no other event came
+      // in for it that we might have missed.
+      LightMutexHolder holder(_sockets_mutex);
+      if (!sinfo->_rearm || _shutdown) {
+        sinfo->_busy = false;
+        return;
+      }
+      sinfo->_rearm = false;
+    }
+  }
+
+  // The socket was closed.  Report that and return.
+  sinfo->_stream_data = string();
+  if (_manager != (ConnectionManager *)NULL) {
+    _manager->connection_reset(sinfo->_connection, 0);
+  }
+  finish_socket(sinfo);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: ConnectionReader::extract_stream_datagrams
+//       Access: Private
+//  Description: Delivers all of the complete datagrams that have
+//               accumulated in the SocketInfo's stream buffer, and
+//               leaves any trailing partial datagram in the buffer.
+//               Returns true on success, or false if a datagram
+//               header is invalid, in which case the connection
+//               should be closed.
+////////////////////////////////////////////////////////////////////
+bool ConnectionReader::
+extract_stream_datagrams(SocketInfo *sinfo, const NetAddress &address) {
+  string &data = sinfo->_stream_data;
+  size_t pos = 0;
+
+  while (data.size() - pos >= (size_t)_tcp_header_size) {
+    DatagramTCPHeader header(data.data() + pos, _tcp_header_size);
+    int size = header.get_datagram_size(_tcp_header_size);
+    if (size < 0) {
+      net_cat.error()
+        << "Invalid TCP datagram size " << size << "; closing connection.\n";
+      data = string();
+      return false;
+    }
+    if (data.size() - pos - _tcp_header_size < (size_t)size) {
+      // We don't have all of this one yet.
+      break;
+    }
+
+    NetDatagram datagram(data.data() + pos + _tcp_header_size, size);
+    pos += _tcp_header_size + size;
+
+    if (_shutdown) {
+      break;
+    }
+
+    if (!header.verify_datagram(datagram, _tcp_header_size)) {
+      net_cat.error()
+        << "Ignoring invalid TCP datagram.\n";
+    } else {
+      datagram.set_connection(sinfo->_connection);
+      datagram.set_address(address);
+      receive_datagram(datagram);
+    }
+  }
+
+  if (pos != 0) {
+    data.erase(0, pos);
+  }
+  return true;
+}
+#endif  // HAVE_EPOLL
@@ -24,10 +24,19 @@
 #include "lightMutex.h"
 #include "pvector.h"
 #include "pset.h"
+#include "pmap.h"
 #include "socket_fdset.h"
 #include "atomicAdjust.h"
 
+// On Linux, the ConnectionReader may use epoll instead of select() to
+// wait for activity; see net-use-epoll.  This isn't useful with
+// SIMPLE_THREADS, which can't block in epoll_wait().
+#if defined(__linux__) && !defined(SIMPLE_THREADS)
+#define HAVE_EPOLL 1
+#endif
+
 class NetDatagram;
+class NetAddress;
 class ConnectionManager;
 class Socket_Address;
 class Socket_IP;
@@ -53,6 +62,15 @@ class Socket_IP;
 //               ConnectionListener derives from this class, extending
 //               it to accept connections on a rendezvous socket
 //               rather than read datagrams.
+//
+//               On Linux, if net-use-epoll is true, the sockets are
+//               monitored with epoll instead of select(), which
+//               scales to many thousands of connections.  In this
+//               case each thread runs its own event loop over its
+//               own share of the sockets, and TCP datagrams are read
+//               with edge-triggered, non-blocking reads, so that a
+//               slow or partial datagram on one connection never
+//               holds up the others.
 ////////////////////////////////////////////////////////////////////
 class EXPCL_PANDA_NET ConnectionReader {
 PUBLISHED:
@@ -98,6 +116,16 @@ protected:
     PT(Connection) _connection;
     bool _busy;
     bool _error;
+
+    // The remaining members are used only by the epoll
+    // implementation.  _stream is true for a TCP socket that is read
+    // with edge-triggered reads; _stream_data holds the bytes of any
+    // partially-received datagram.  _rearm is set if another event
+    // arrives for the socket while it is busy.
+    int _loop_index;
+    bool _stream;
+    bool _rearm;
+    string _stream_data;
   };
   typedef pvector<SocketInfo *> Sockets;
 
@@ -130,6 +158,15 @@ private:
                                         int current_thread_index);
 
   void rebuild_select_list();
+  void delete_removed_sockets();
+
+#ifdef HAVE_EPOLL
+  bool epoll_add(SocketInfo *sinfo);
+  void epoll_remove(SocketInfo *sinfo);
+  int epoll_service(int loop_index, int timeout_ms);
+  void process_incoming_tcp_stream(SocketInfo *sinfo);
+  bool extract_stream_datagrams(SocketInfo *sinfo, const NetAddress &address);
+#endif  // HAVE_EPOLL
 
 private:
   bool _raw_mode;
@@ -164,6 +201,21 @@ private:
   // contains -1 if no thread is so waiting.
   AtomicAdjust::Integer _currently_polling_thread;
 
+  // True if the sockets are monitored with epoll rather than select().
+  bool _use_epoll;
+
+#ifdef HAVE_EPOLL
+  // One epoll descriptor per thread (or just one, in polling mode).
+  // Each socket is assigned to one of these when it is added, and is
+  // looked up again by its descriptor in _epoll_sockets, which is
+  // protected by _sockets_mutex.
+  typedef pvector<int> EpollFds;
+  EpollFds _epoll_fds;
+  typedef pmap<int, SocketInfo *> EpollSockets;
+  EpollSockets _epoll_sockets;
+  int _next_loop_index;
+#endif  // HAVE_EPOLL
+
   friend class ConnectionManager;
   friend class ReaderThread;
 };
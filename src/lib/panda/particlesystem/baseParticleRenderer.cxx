@@ -18,6 +18,7 @@
 #include "transparencyAttrib.h"
 #include "colorAttrib.h"
 #include "compassEffect.h"
+#include "config_particlesystem.h"
 
 ////////////////////////////////////////////////////////////////////
 //    Function : BaseParticleRender::BaseParticleRenderer
@@ -115,6 +116,36 @@ write(ostream &out, int indent) const {
   #endif //] NDEBUG
 }
 
+////////////////////////////////////////////////////////////////////
+//    Function : BaseParticleRender::supports_packed_pool
+//      Access : Public, Virtual
+// Description : Returns true if this renderer can render the
+//               particles of a ParticleSystem in packed-pool mode.
+//               See ParticleSystem::set_packed_pool_flag().
+////////////////////////////////////////////////////////////////////
+bool BaseParticleRenderer::
+supports_packed_pool() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : BaseParticleRender::render_pool
+//      Access : Private, Virtual
+// Description : Renders the particles of a ParticleSystem in
+//               packed-pool mode.  Renderers that do not support
+//               this mode render nothing.
+////////////////////////////////////////////////////////////////////
+void BaseParticleRenderer::
+render_pool(const ParticlePool &) {
+  static bool reported = false;
+  if (!reported) {
+    particlesystem_cat.error()
+      << "This particle renderer cannot render a packed particle pool; "
+      << "use a PointParticleRenderer.\n";
+    reported = true;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //    Function : BaseParticleRender::update_alpha_state
 //      Access : Private
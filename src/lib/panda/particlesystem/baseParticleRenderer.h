@@ -24,6 +24,7 @@
 #include "nodePath.h"
 #include "particleCommonFuncs.h"
 #include "baseParticle.h"
+#include "particlePool.h"
 
 #include "pvector.h"
 
@@ -69,6 +70,7 @@ PUBLISHED:
 
 public:
   virtual BaseParticleRenderer *make_copy() = 0;
+  virtual bool supports_packed_pool() const;
 
 protected:
   ParticleRendererAlphaMode _alpha_mode;
@@ -109,6 +111,11 @@ private:
   virtual void render(pvector< PT(PhysicsObject) >& po_vector,
                       int ttl_particles) = 0;
 
+  // This is called instead of render() for a ParticleSystem in
+  // packed-pool mode.  Renderers that support it return true from
+  // supports_packed_pool().
+  virtual void render_pool(const ParticlePool &pool);
+
   friend class ParticleSystem;
 };
 
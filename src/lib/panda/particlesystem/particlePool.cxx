@@ -0,0 +1,386 @@
+// Filename: particlePool.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "particlePool.h"
+#include "lsimd.h"
+
+// As in linmath's lsimd.cxx, the vectorized loops are tagged with the
+// instruction set they need, and are only called when LSimd reports
+// that the CPU supports it.
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define PPOOL_X86
+#define PPOOL_SSE2 __attribute__((target("sse2")))
+#include <emmintrin.h>
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define PPOOL_X86
+#define PPOOL_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef PPOOL_X86
+
+////////////////////////////////////////////////////////////////////
+//    Function : sse2_integrate
+// Description : The SSE2 version of the integration loop in
+//               ParticlePool::integrate().  Handles the particles in
+//               groups of four, and returns the number handled; the
+//               caller finishes off the remainder.  The arithmetic is
+//               performed in the same order as the scalar loop, so
+//               the results are identical.
+////////////////////////////////////////////////////////////////////
+static PPOOL_SSE2 int
+sse2_integrate(int num_particles, float *x, float *y, float *z,
+               float *vx, float *vy, float *vz, const float *inv_mass,
+               float dt, float half_dt2, const LVector3f &md_force,
+               const LVector3f &accel, float damper) {
+  __m128 vdt = _mm_set1_ps(dt);
+  __m128 vhalf_dt2 = _mm_set1_ps(half_dt2);
+  __m128 vdamper = _mm_set1_ps(damper);
+  __m128 mdx = _mm_set1_ps(md_force[0]);
+  __m128 mdy = _mm_set1_ps(md_force[1]);
+  __m128 mdz = _mm_set1_ps(md_force[2]);
+  __m128 acx = _mm_set1_ps(accel[0]);
+  __m128 acy = _mm_set1_ps(accel[1]);
+  __m128 acz = _mm_set1_ps(accel[2]);
+
+  int i = 0;
+  for (; i + 4 <= num_particles; i += 4) {
+    __m128 im = _mm_loadu_ps(inv_mass + i);
+    __m128 ax = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(mdx, im), acx), vdamper);
+    __m128 ay = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(mdy, im), acy), vdamper);
+    __m128 az = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(mdz, im), acz), vdamper);
+
+    __m128 px = _mm_loadu_ps(x + i);
+    __m128 py = _mm_loadu_ps(y + i);
+    __m128 pz = _mm_loadu_ps(z + i);
+    __m128 qx = _mm_loadu_ps(vx + i);
+    __m128 qy = _mm_loadu_ps(vy + i);
+    __m128 qz = _mm_loadu_ps(vz + i);
+
+    __m128 nx = _mm_add_ps(px, _mm_add_ps(_mm_mul_ps(qx, vdt), _mm_mul_ps(ax, vhalf_dt2)));
+    __m128 ny = _mm_add_ps(py, _mm_add_ps(_mm_mul_ps(qy, vdt), _mm_mul_ps(ay, vhalf_dt2)));
+    __m128 nz = _mm_add_ps(pz, _mm_add_ps(_mm_mul_ps(qz, vdt), _mm_mul_ps(az, vhalf_dt2)));
+    __m128 wx = _mm_add_ps(qx, _mm_mul_ps(ax, vdt));
+    __m128 wy = _mm_add_ps(qy, _mm_mul_ps(ay, vdt));
+    __m128 wz = _mm_add_ps(qz, _mm_mul_ps(az, vdt));
+
+    // A lane is kept only where none of its three components is NaN.
+    __m128 pok = _mm_and_ps(_mm_and_ps(_mm_cmpord_ps(nx, nx), _mm_cmpord_ps(ny, ny)),
+                            _mm_cmpord_ps(nz, nz));
+    __m128 vok = _mm_and_ps(_mm_and_ps(_mm_cmpord_ps(wx, wx), _mm_cmpord_ps(wy, wy)),
+                            _mm_cmpord_ps(wz, wz));
+    px = _mm_or_ps(_mm_and_ps(pok, nx), _mm_andnot_ps(pok, px));
+    py = _mm_or_ps(_mm_and_ps(pok, ny), _mm_andnot_ps(pok, py));
+    pz = _mm_or_ps(_mm_and_ps(pok, nz), _mm_andnot_ps(pok, pz));
+    qx = _mm_or_ps(_mm_and_ps(vok, wx), _mm_andnot_ps(vok, qx));
+    qy = _mm_or_ps(_mm_and_ps(vok, wy), _mm_andnot_ps(vok, qy));
+    qz = _mm_or_ps(_mm_and_ps(vok, wz), _mm_andnot_ps(vok, qz));
+
+    _mm_storeu_ps(x + i, px);
+    _mm_storeu_ps(y + i, py);
+    _mm_storeu_ps(z + i, pz);
+    _mm_storeu_ps(vx + i, qx);
+    _mm_storeu_ps(vy + i, qy);
+    _mm_storeu_ps(vz + i, qz);
+  }
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : sse2_advance_age
+// Description : The SSE2 version of the loop in
+//               ParticlePool::advance_age().  Returns the number of
+//               particles handled.
+////////////////////////////////////////////////////////////////////
+static PPOOL_SSE2 int
+sse2_advance_age(int num_particles, float *age, const float *lifespan,
+                 const float *z, float dt, float floor_z,
+                 pvector<int> &expired) {
+  __m128 vdt = _mm_set1_ps(dt);
+  __m128 vfloor = _mm_set1_ps(floor_z);
+
+  int i = 0;
+  for (; i + 4 <= num_particles; i += 4) {
+    __m128 a = _mm_add_ps(_mm_loadu_ps(age + i), vdt);
+    _mm_storeu_ps(age + i, a);
+
+    __m128 dead = _mm_or_ps(_mm_cmpge_ps(a, _mm_loadu_ps(lifespan + i)),
+                            _mm_cmple_ps(_mm_loadu_ps(z + i), vfloor));
+    int mask = _mm_movemask_ps(dead);
+    if (mask != 0) {
+      for (int j = 0; j < 4; ++j) {
+        if (mask & (1 << j)) {
+          expired.push_back(i + j);
+        }
+      }
+    }
+  }
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : sse2_min_max
+// Description : Computes the minimum and maximum of the first
+//               (num_values & ~3) values of the array, which must
+//               contain at least 4 values.
+////////////////////////////////////////////////////////////////////
+static PPOOL_SSE2 void
+sse2_min_max(const float *values, int num_values,
+             float &min_value, float &max_value) {
+  __m128 vmin = _mm_loadu_ps(values);
+  __m128 vmax = vmin;
+  int i = 4;
+  for (; i + 4 <= num_values; i += 4) {
+    __m128 v = _mm_loadu_ps(values + i);
+    vmin = _mm_min_ps(vmin, v);
+    vmax = _mm_max_ps(vmax, v);
+  }
+
+  float mins[4], maxs[4];
+  _mm_storeu_ps(mins, vmin);
+  _mm_storeu_ps(maxs, vmax);
+  min_value = min(min(mins[0], mins[1]), min(mins[2], mins[3]));
+  max_value = max(max(maxs[0], maxs[1]), max(maxs[2], maxs[3]));
+}
+
+#endif  // PPOOL_X86
+
+////////////////////////////////////////////////////////////////////
+//    Function : ParticlePool
+//      Access : Public
+// Description : Constructor
+////////////////////////////////////////////////////////////////////
+ParticlePool::
+ParticlePool() :
+  _num_particles(0),
+  _max_particles(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : set_max_particles
+//      Access : Public
+// Description : Changes the number of particles the pool has room
+//               for.  If there are more living particles than this,
+//               the excess are removed.
+////////////////////////////////////////////////////////////////////
+void ParticlePool::
+set_max_particles(int max_particles) {
+  nassertv(max_particles >= 0);
+  _max_particles = max_particles;
+  _num_particles = min(_num_particles, max_particles);
+
+  _x.resize(max_particles);
+  _y.resize(max_particles);
+  _z.resize(max_particles);
+  _vx.resize(max_particles);
+  _vy.resize(max_particles);
+  _vz.resize(max_particles);
+  _age.resize(max_particles);
+  _lifespan.resize(max_particles);
+  _inv_mass.resize(max_particles);
+  _terminal_velocity.resize(max_particles);
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : add_particle
+//      Access : Public
+// Description : Adds a new particle with an age of zero, and returns
+//               its index, or -1 if the pool is full.
+////////////////////////////////////////////////////////////////////
+int ParticlePool::
+add_particle(const LPoint3f &position, const LVector3f &velocity,
+             float lifespan, float mass, float terminal_velocity) {
+  if (_num_particles >= _max_particles) {
+    return -1;
+  }
+  nassertr(mass != 0.0f, -1);
+
+  int n = _num_particles++;
+  _x[n] = position[0];
+  _y[n] = position[1];
+  _z[n] = position[2];
+  _vx[n] = velocity[0];
+  _vy[n] = velocity[1];
+  _vz[n] = velocity[2];
+  _age[n] = 0.0f;
+  _lifespan[n] = lifespan;
+  _inv_mass[n] = 1.0f / mass;
+  _terminal_velocity[n] = terminal_velocity;
+  return n;
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : remove_particle
+//      Access : Public
+// Description : Removes the nth particle.  The last living particle
+//               is moved into its place, so to remove several
+//               particles at once, remove them in decreasing order
+//               of index.
+////////////////////////////////////////////////////////////////////
+void ParticlePool::
+remove_particle(int n) {
+  nassertv(n >= 0 && n < _num_particles);
+  int last = --_num_particles;
+  if (n != last) {
+    _x[n] = _x[last];
+    _y[n] = _y[last];
+    _z[n] = _z[last];
+    _vx[n] = _vx[last];
+    _vy[n] = _vy[last];
+    _vz[n] = _vz[last];
+    _age[n] = _age[last];
+    _lifespan[n] = _lifespan[last];
+    _inv_mass[n] = _inv_mass[last];
+    _terminal_velocity[n] = _terminal_velocity[last];
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : integrate
+//      Access : Public
+// Description : Steps the position and velocity of every particle
+//               forward by dt, as the LinearEulerIntegrator does.
+//               md_force is the sum of the mass-dependent forces,
+//               which is divided by each particle's own mass, and
+//               accel is the sum of the remaining forces; the total
+//               acceleration is then scaled by damper, which is one
+//               minus the viscosity.
+//
+//               Also as in the LinearEulerIntegrator, a position or
+//               velocity that comes out NaN is not stored, so that
+//               one bad particle can't spoil the bounds of the pool.
+////////////////////////////////////////////////////////////////////
+void ParticlePool::
+integrate(float dt, const LVector3f &md_force, const LVector3f &accel,
+          float damper) {
+  if (_num_particles == 0) {
+    return;
+  }
+
+  float *x = &_x[0], *y = &_y[0], *z = &_z[0];
+  float *vx = &_vx[0], *vy = &_vy[0], *vz = &_vz[0];
+  const float *inv_mass = &_inv_mass[0];
+  float half_dt2 = 0.5f * dt * dt;
+
+  int i = 0;
+#ifdef PPOOL_X86
+  if (LSimd::get_level() >= LSimd::L_sse2) {
+    i = sse2_integrate(_num_particles, x, y, z, vx, vy, vz, inv_mass,
+                       dt, half_dt2, md_force, accel, damper);
+  }
+#endif
+
+  for (; i < _num_particles; ++i) {
+    float ax = (md_force[0] * inv_mass[i] + accel[0]) * damper;
+    float ay = (md_force[1] * inv_mass[i] + accel[1]) * damper;
+    float az = (md_force[2] * inv_mass[i] + accel[2]) * damper;
+
+    // x = x + v * t + 0.5 * a * t * t
+    float nx = x[i] + (vx[i] * dt + ax * half_dt2);
+    float ny = y[i] + (vy[i] * dt + ay * half_dt2);
+    float nz = z[i] + (vz[i] * dt + az * half_dt2);
+    // v = v + a * t
+    float wx = vx[i] + ax * dt;
+    float wy = vy[i] + ay * dt;
+    float wz = vz[i] + az * dt;
+
+    // and store them back.
+    if (!cnan(nx) && !cnan(ny) && !cnan(nz)) {
+      x[i] = nx;
+      y[i] = ny;
+      z[i] = nz;
+    }
+    if (!cnan(wx) && !cnan(wy) && !cnan(wz)) {
+      vx[i] = wx;
+      vy[i] = wy;
+      vz[i] = wz;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : advance_age
+//      Access : Public
+// Description : Adds dt to the age of every particle, and appends to
+//               expired, in increasing order, the index of each
+//               particle that has reached the end of its lifespan or
+//               fallen to floor_z.  The particles are not removed.
+////////////////////////////////////////////////////////////////////
+void ParticlePool::
+advance_age(float dt, float floor_z, pvector<int> &expired) {
+  if (_num_particles == 0) {
+    return;
+  }
+
+  float *age = &_age[0];
+  const float *lifespan = &_lifespan[0];
+  const float *z = &_z[0];
+
+  int i = 0;
+#ifdef PPOOL_X86
+  if (LSimd::get_level() >= LSimd::L_sse2) {
+    i = sse2_advance_age(_num_particles, age, lifespan, z, dt, floor_z,
+                         expired);
+  }
+#endif
+
+  for (; i < _num_particles; ++i) {
+    age[i] += dt;
+    if (age[i] >= lifespan[i] || z[i] <= floor_z) {
+      expired.push_back(i);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : get_bounds
+//      Access : Public
+// Description : Computes the axis-aligned box around the positions
+//               of all the living particles.  Returns false if there
+//               are no living particles.
+////////////////////////////////////////////////////////////////////
+bool ParticlePool::
+get_bounds(LPoint3f &min_point, LPoint3f &max_point) const {
+  if (_num_particles == 0) {
+    return false;
+  }
+
+  const float *columns[3] = { &_x[0], &_y[0], &_z[0] };
+  for (int c = 0; c < 3; ++c) {
+    const float *values = columns[c];
+    float min_value = values[0];
+    float max_value = values[0];
+
+    int i = 1;
+#ifdef PPOOL_X86
+    if (LSimd::get_level() >= LSimd::L_sse2 && _num_particles >= 4) {
+      sse2_min_max(values, _num_particles, min_value, max_value);
+      i = _num_particles & ~3;
+    }
+#endif
+
+    for (; i < _num_particles; ++i) {
+      min_value = min(min_value, values[i]);
+      max_value = max(max_value, values[i]);
+    }
+    min_point[c] = min_value;
+    max_point[c] = max_value;
+  }
+
+  return true;
+}
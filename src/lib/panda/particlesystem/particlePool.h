@@ -0,0 +1,80 @@
+// Filename: particlePool.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef PARTICLEPOOL_H
+#define PARTICLEPOOL_H
+
+#include "pandabase.h"
+#include "luse.h"
+#include "nearly_zero.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : ParticlePool
+// Description : The storage for the particles of a ParticleSystem
+//               in packed-pool mode (see
+//               ParticleSystem::set_packed_pool_flag()).
+//
+//               Rather than one heap-allocated BaseParticle per
+//               particle, each attribute of the particles is kept in
+//               its own contiguous array, and the living particles
+//               always occupy the first get_num_particles() elements
+//               of each array; a dead particle is replaced by the
+//               last living one.  This allows the whole system to be
+//               aged, integrated and rendered with a few tight loops,
+//               which are vectorized where the CPU supports it.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDAPHYSICS ParticlePool {
+public:
+  ParticlePool();
+
+  void set_max_particles(int max_particles);
+  INLINE int get_max_particles() const;
+  INLINE int get_num_particles() const;
+  INLINE void clear();
+
+  int add_particle(const LPoint3f &position, const LVector3f &velocity,
+                   float lifespan, float mass, float terminal_velocity);
+  void remove_particle(int n);
+
+  INLINE LPoint3f get_position(int n) const;
+  INLINE LVector3f get_velocity(int n) const;
+  INLINE float get_age(int n) const;
+  INLINE float get_lifespan(int n) const;
+  INLINE float get_mass(int n) const;
+  INLINE float get_terminal_velocity(int n) const;
+  INLINE float get_parameterized_age(int n) const;
+  INLINE float get_parameterized_vel(int n) const;
+
+  void integrate(float dt, const LVector3f &md_force,
+                 const LVector3f &accel, float damper);
+  void advance_age(float dt, float floor_z, pvector<int> &expired);
+  bool get_bounds(LPoint3f &min_point, LPoint3f &max_point) const;
+
+private:
+  typedef pvector<float> Floats;
+  Floats _x, _y, _z;
+  Floats _vx, _vy, _vz;
+  Floats _age;
+  Floats _lifespan;
+  Floats _inv_mass;
+  Floats _terminal_velocity;
+
+  int _num_particles;
+  int _max_particles;
+};
+
+#include "particlePool.I"
+
+#endif // PARTICLEPOOL_H
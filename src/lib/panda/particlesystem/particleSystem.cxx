@@ -19,6 +19,7 @@
 #include "clockObject.h"
 #include "physicsManager.h"
 #include "physicalNode.h"
+#include "linearVectorForce.h"
 #include "nearly_zero.h"
 #include "transformState.h"
 #include "nodePath.h"
@@ -59,6 +60,7 @@ ParticleSystem(int pool_size) :
   _i_was_spawned_flag = false;
   _particle_pool_size = 0;
   _floor_z = -HUGE_VAL;
+  _packed_pool_flag = false;
 
   // just in case someone tries to do something that requires the
   // use of an emitter, renderer, or factory before they've actually
@@ -111,6 +113,7 @@ ParticleSystem(const ParticleSystem& copy) :
   _tics_since_birth = 0.0;
   _system_lifespan = copy._system_lifespan;
   _living_particles = 0;
+  _packed_pool_flag = copy._packed_pool_flag;
 
   set_pool_size(copy._particle_pool_size);
 }
@@ -215,12 +218,66 @@ birth_litter() {
   if (_litter_spread != 0)
     litter_size += I_SPREAD(_litter_spread);
 
+  if (_packed_pool_flag) {
+    for (i = 0; i < litter_size; ++i) {
+      if (birth_packed_particle() == false)
+        return;
+    }
+    return;
+  }
+
   for (i = 0; i < litter_size; ++i) {
     if (birth_particle() == false)
       return;
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//    Function : birth_packed_particle
+//      Access : Private
+// Description : As birth_particle(), for a system in packed-pool
+//               mode.  The factory is asked only for the lifespan,
+//               mass and terminal velocity; the packed pool does not
+//               store any of the other BaseParticle properties.
+////////////////////////////////////////////////////////////////////
+bool ParticleSystem::
+birth_packed_particle() {
+  if (_pool.get_num_particles() >= _pool.get_max_particles()) {
+    return false;
+  }
+
+  LPoint3f new_pos, world_pos;
+  LVector3f new_vel;
+
+  _emitter->generate(new_pos, new_vel);
+
+  // go from birth space to render space
+  NodePath physical_np = get_physical_node_path();
+  NodePath render_np = _renderer->get_render_node_path();
+
+  CPT(TransformState) transform = physical_np.get_transform(render_np);
+  const LMatrix4f &birth_to_render_xform = transform->get_mat();
+  world_pos = new_pos * birth_to_render_xform;
+
+  if (_local_velocity_flag == false)
+    new_vel = new_vel * birth_to_render_xform;
+
+  float lifespan = _factory->get_lifespan_base() +
+    SPREAD(_factory->get_lifespan_spread());
+  float mass = _factory->get_mass_base() +
+    SPREAD(_factory->get_mass_spread());
+  float terminal_velocity = _factory->get_terminal_velocity_base() +
+    SPREAD(_factory->get_terminal_velocity_spread());
+
+  if (_pool.add_particle(world_pos, new_vel, lifespan, mass,
+                         terminal_velocity) < 0) {
+    return false;
+  }
+
+  ++_living_particles;
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////
 //    Function : spawn_child_system
 //      Access : private
@@ -229,7 +286,7 @@ birth_litter() {
 //               managers
 ////////////////////////////////////////////////////////////////////
 void ParticleSystem::
-spawn_child_system(BaseParticle *bp) {
+spawn_child_system(const LMatrix4f &lcs) {
   // first, make sure that the system exists in the graph via a
   // physicalnode reference.
   PhysicalNode *this_pn = get_physical_node();
@@ -277,8 +334,7 @@ spawn_child_system(BaseParticle *bp) {
   CPT(TransformState) transform = physical_np.get_transform(parent_np);
   const LMatrix4f &old_system_to_parent_xform = transform->get_mat();
 
-  LMatrix4f child_space_xform = old_system_to_parent_xform *
-    bp->get_lcs();
+  LMatrix4f child_space_xform = old_system_to_parent_xform * lcs;
 
   new_pn->set_transform(TransformState::make_mat(child_space_xform));
 
@@ -300,7 +356,7 @@ kill_particle(int pool_index) {
 
   // create a new system where this one died, maybe.
   if (_spawn_on_death_flag == true) {
-    spawn_child_system(bp);
+    spawn_child_system(bp->get_lcs());
   }
 
   // tell everyone that it's dead
@@ -316,6 +372,62 @@ kill_particle(int pool_index) {
   _living_particles--;
 }
 
+////////////////////////////////////////////////////////////////////
+//    Function : kill_packed_particle
+//      Access : Private
+// Description : As kill_particle(), for a system in packed-pool
+//               mode.  The last living particle takes the place of
+//               the dead one, so when killing several particles at
+//               once, kill them in decreasing order of n.
+////////////////////////////////////////////////////////////////////
+void ParticleSystem::
+kill_packed_particle(int n) {
+  if (_spawn_on_death_flag == true) {
+    spawn_child_system(LMatrix4f::translate_mat(_pool.get_position(n)));
+  }
+
+  _pool.remove_particle(n);
+  _living_particles--;
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : set_packed_pool_flag
+//      Access : Published
+// Description : Puts the system into, or takes it out of, packed-pool
+//               mode.  In this mode the particles are not stored as
+//               BaseParticles, but in a ParticlePool, which keeps
+//               each of their attributes in its own array; the
+//               system then moves, ages and renders all of its
+//               particles in a few tight loops, rather than one
+//               particle at a time through the PhysicsManager.  This
+//               is much faster for large systems.
+//
+//               The restrictions are that only LinearVectorForces
+//               (forces that are the same for every particle, like
+//               gravity) act on the particles, and the renderer must
+//               support it; presently only the PointParticleRenderer
+//               does.  Changing the mode kills all of the living
+//               particles.
+////////////////////////////////////////////////////////////////////
+void ParticleSystem::
+set_packed_pool_flag(bool packed_pool) {
+  if (packed_pool == _packed_pool_flag) {
+    return;
+  }
+
+  if (packed_pool && !_renderer->supports_packed_pool()) {
+    particlesystem_cat.error()
+      << "ParticleSystem::set_packed_pool_flag: the renderer cannot "
+      << "render a packed particle pool.\n";
+    return;
+  }
+
+  int pool_size = _particle_pool_size;
+  resize_pool(0);
+  _packed_pool_flag = packed_pool;
+  resize_pool(pool_size);
+}
+
 ////////////////////////////////////////////////////////////////////
 //    Function : resize_pool
 //      Access : Private
@@ -347,6 +459,18 @@ resize_pool(int size) {
     return;
   }
 
+  if (_packed_pool_flag) {
+    // Particles beyond the new size are lost.
+    for (i = _pool.get_num_particles() - 1; i >= size; --i) {
+      kill_packed_particle(i);
+    }
+    _pool.set_max_particles(size);
+    _particle_pool_size = size;
+    _living_particles = _pool.get_num_particles();
+    _renderer->resize_pool(_particle_pool_size);
+    return;
+  }
+
   _particle_pool_size = size;
 
   // make sure the physics_objects array is OK
@@ -468,6 +592,11 @@ void ParticleSystem::
 update(float dt) {
   PStatTimer t1(_update_collector);
 
+  if (_packed_pool_flag) {
+    update_packed_pool(dt);
+    return;
+  }
+
   int ttl_updates_left = _living_particles;
   int current_index = 0, index_counter = 0;
   BaseParticle *bp;
@@ -545,6 +674,97 @@ update(float dt) {
 
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: accumulate_packed_forces
+//  Description: Adds the indicated forces, transformed into the
+//               particles' space, into md_force (the mass-dependent
+//               ones) and accel (the rest).  Since only
+//               LinearVectorForces are allowed in packed-pool mode,
+//               each force is the same for every particle.
+////////////////////////////////////////////////////////////////////
+static void
+accumulate_packed_forces(const Physical::LinearForceVector &forces,
+                         const NodePath &parent_np,
+                         LVector3f &md_force, LVector3f &accel) {
+  static bool warned = false;
+
+  Physical::LinearForceVector::const_iterator fi;
+  for (fi = forces.begin(); fi != forces.end(); ++fi) {
+    LinearForce *cur_force = *fi;
+    if (cur_force->get_active() == false) {
+      continue;
+    }
+
+    if (!cur_force->is_of_type(LinearVectorForce::get_class_type())) {
+      if (!warned) {
+        particlesystem_cat.warning()
+          << "A particle system in packed-pool mode ignores "
+          << cur_force->get_type() << "; only LinearVectorForces are "
+          << "applied.\n";
+        warned = true;
+      }
+      continue;
+    }
+
+    NodePath force_np = cur_force->get_force_node_path();
+    LVector3f f = cur_force->get_vector((const PhysicsObject *)NULL) *
+      force_np.get_transform(parent_np)->get_mat();
+
+    if (cur_force->get_mass_dependent() == true) {
+      md_force += f;
+    } else {
+      accel += f;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+//    Function : update_packed_pool
+//      Access : Private
+// Description : The update() of a system in packed-pool mode.  Since
+//               the PhysicsManager has no PhysicsObjects to move, the
+//               system integrates its own particles here, with the
+//               same equations the LinearEulerIntegrator uses, before
+//               aging them.
+//////////////////////////////////////////////////////////////////////
+void ParticleSystem::
+update_packed_pool(float dt) {
+  PhysicsManager *manager = get_physics_manager();
+  PhysicalNode *physical_node = get_physical_node();
+  if (manager != (PhysicsManager *)NULL &&
+      physical_node != (PhysicalNode *)NULL) {
+    NodePath parent_np = get_physical_node_path().get_parent();
+
+    LVector3f md_force(0.0f, 0.0f, 0.0f);
+    LVector3f accel(0.0f, 0.0f, 0.0f);
+    accumulate_packed_forces(manager->get_linear_forces(), parent_np,
+                             md_force, accel);
+    accumulate_packed_forces(get_linear_forces(), parent_np,
+                             md_force, accel);
+
+    float viscosity_damper = 1.0f - get_viscosity();
+    _pool.integrate(dt, md_force, accel, viscosity_damper);
+  }
+
+  _expired.clear();
+  _pool.advance_age(dt, get_floor_z(), _expired);
+
+  // The expired list is in increasing order; kill from the end, so
+  // the particles moved into the freed slots are all still alive.
+  pvector<int>::reverse_iterator ei;
+  for (ei = _expired.rbegin(); ei != _expired.rend(); ++ei) {
+    kill_packed_particle(*ei);
+  }
+
+  // generate new particles if necessary.
+  _tics_since_birth += dt;
+
+  while (_tics_since_birth >= _cur_birth_rate) {
+    birth_litter();
+    _tics_since_birth -= _cur_birth_rate;
+  }
+}
+
 #ifdef PSSANITYCHECK
 //////////////////////////////////////////////////////////////////////
 //    Function : sanity_check
@@ -773,6 +993,7 @@ write(ostream &out, int indent) const {
   out.width(indent+2); out<<""; out<<"_spawn_on_death_flag "<<_spawn_on_death_flag<<"\n";
   out.width(indent+2); out<<""; out<<"_spawn_render_node "<<_spawn_render_node_path<<"\n";
   out.width(indent+2); out<<""; out<<"_i_was_spawned_flag "<<_i_was_spawned_flag<<"\n";
+  out.width(indent+2); out<<""; out<<"_packed_pool_flag "<<_packed_pool_flag<<"\n";
   write_free_particle_fifo(out, indent+2);
   write_spawn_templates(out, indent+2);
   Physical::write(out, indent+2);
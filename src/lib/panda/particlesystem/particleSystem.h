@@ -32,6 +32,7 @@
 #include "baseParticleRenderer.h"
 #include "baseParticleEmitter.h"
 #include "baseParticleFactory.h"
+#include "particlePool.h"
 
 class ParticleSystemManager;
 
@@ -70,6 +71,7 @@ PUBLISHED:
   INLINE void set_floor_z(float z);
   
   INLINE void clear_floor_z();
+  void set_packed_pool_flag(bool packed_pool);
 
   INLINE int get_pool_size() const;
   INLINE float get_birth_rate() const;
@@ -91,6 +93,7 @@ PUBLISHED:
   INLINE BaseParticleEmitter *get_emitter() const;
   INLINE BaseParticleFactory *get_factory() const;
   INLINE float get_floor_z() const;
+  INLINE bool get_packed_pool_flag() const;
 
   // particle template vector
 
@@ -121,6 +124,10 @@ private:
   void birth_litter();
   void resize_pool(int size);
 
+  bool birth_packed_particle();
+  void kill_packed_particle(int n);
+  void update_packed_pool(float dt);
+
   pdeque< int > _free_particle_fifo;
 
   int _particle_pool_size;
@@ -152,13 +159,19 @@ private:
   bool _local_velocity_flag;
   bool _system_grows_older_flag;
 
+  // information for systems in packed-pool mode
+
+  bool _packed_pool_flag;
+  ParticlePool _pool;
+  pvector<int> _expired;
+
   // information for systems that will spawn
 
   bool _spawn_on_death_flag;
   NodePath _spawn_render_node_path;
   pvector< PT(ParticleSystem) > _spawn_templates;
 
-  void spawn_child_system(BaseParticle *bp);
+  void spawn_child_system(const LMatrix4f &lcs);
 
   // information for spawned systems
   bool _i_was_spawned_flag;
@@ -17,6 +17,7 @@
 #include "geomNode.h"
 #include "geom.h"
 #include "geomVertexWriter.h"
+#include "geomVertexArrayData.h"
 #include "indent.h"
 #include "pStatTimer.h"
 
@@ -210,6 +211,67 @@ create_color(const BaseParticle *p) {
   return color;
 }
 
+////////////////////////////////////////////////////////////////////
+//    Function : create_pool_color
+//      Access : Private
+// Description : Generates the point color of the nth particle of a
+//               packed pool, as create_color() does for a
+//               BaseParticle.
+////////////////////////////////////////////////////////////////////
+
+INLINE Colorf PointParticleRenderer::
+create_pool_color(const ParticlePool &pool, int n) const {
+  Colorf color;
+  float life_t, vel_t;
+  float parameterized_age = 1.0f;
+  bool have_alpha_t = false;
+
+  switch (_blend_type) {
+  case PP_ONE_COLOR:
+    color = _start_color;
+    break;
+
+  case PP_BLEND_LIFE:
+    parameterized_age = pool.get_parameterized_age(n);
+    life_t = parameterized_age;
+    have_alpha_t = true;
+
+    if (_blend_method == PP_BLEND_CUBIC)
+      life_t = CUBIC_T(life_t);
+
+    color = LERP(life_t, _start_color, _end_color);
+    break;
+
+  case PP_BLEND_VEL:
+    vel_t = pool.get_parameterized_vel(n);
+
+    if (_blend_method == PP_BLEND_CUBIC)
+      vel_t = CUBIC_T(vel_t);
+
+    color = LERP(vel_t, _start_color, _end_color);
+    break;
+  }
+
+  if(_alpha_mode != PR_ALPHA_NONE) {
+    if(_alpha_mode == PR_ALPHA_USER) {
+      parameterized_age = 1.0;
+    } else {
+      if(!have_alpha_t)
+        parameterized_age = pool.get_parameterized_age(n);
+
+      if(_alpha_mode==PR_ALPHA_OUT) {
+        parameterized_age = 1.0f - parameterized_age;
+      } else if(_alpha_mode==PR_ALPHA_IN_OUT) {
+        parameterized_age = 2.0f * min(parameterized_age,
+                                      1.0f - parameterized_age);
+      }
+    }
+    color[3] = parameterized_age * get_user_alpha();
+  }
+
+  return color;
+}
+
 ////////////////////////////////////////////////////////////////////
 //    Function : render
 //      Access : Public
@@ -289,6 +351,83 @@ render(pvector< PT(PhysicsObject) >& po_vector, int ttl_particles) {
   get_render_node()->mark_internal_bounds_stale();
 }
 
+////////////////////////////////////////////////////////////////////
+//    Function : supports_packed_pool
+//      Access : Public, virtual
+// Description : Returns true: this renderer can render a
+//               ParticleSystem in packed-pool mode.
+////////////////////////////////////////////////////////////////////
+
+bool PointParticleRenderer::
+supports_packed_pool() const {
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//    Function : render_pool
+//      Access : Private, virtual
+// Description : Renders a ParticleSystem in packed-pool mode.  This
+//               computes the same colors as render(), but writes the
+//               vertices directly into the vertex array, rather than
+//               through a GeomVertexWriter.
+////////////////////////////////////////////////////////////////////
+
+void PointParticleRenderer::
+render_pool(const ParticlePool &pool) {
+  PStatTimer t1(_render_collector);
+
+  int num_particles = pool.get_num_particles();
+  _vdata->unclean_set_num_rows(num_particles);
+
+  const GeomVertexArrayFormat *format = _vdata->get_format()->get_array(0);
+  int stride = format->get_stride();
+  int vertex_start = format->get_column(InternalName::get_vertex())->get_start();
+  int color_start = format->get_column(InternalName::get_color())->get_start();
+
+  PT(GeomVertexArrayDataHandle) handle = _vdata->modify_array(0)->modify_handle();
+  unsigned char *pointer = handle->get_write_pointer();
+
+  for (int i = 0; i < num_particles; ++i) {
+    LPoint3f position = pool.get_position(i);
+    float *vertex = (float *)(pointer + vertex_start);
+    vertex[0] = position[0];
+    vertex[1] = position[1];
+    vertex[2] = position[2];
+
+    Colorf color = create_pool_color(pool, i);
+    for (int c = 0; c < 4; ++c) {
+      color[c] = max(min(color[c], 1.0f), 0.0f);
+    }
+    *(PN_uint32 *)(pointer + color_start) = GeomVertexData::pack_abcd
+      ((unsigned int)(color[3] * 255.0f),
+       (unsigned int)(color[0] * 255.0f),
+       (unsigned int)(color[1] * 255.0f),
+       (unsigned int)(color[2] * 255.0f));
+
+    pointer += stride;
+  }
+  handle.clear();
+
+  _points->clear_vertices();
+  _points->add_next_vertices(num_particles);
+
+  // done filling geompoint node, now do the bb stuff
+
+  LPoint3f aabb_min, aabb_max;
+  if (!pool.get_bounds(aabb_min, aabb_max)) {
+    aabb_min = aabb_max = LPoint3f::zero();
+  }
+  _aabb_min = aabb_min;
+  _aabb_max = aabb_max;
+
+  LPoint3f aabb_center = _aabb_min + ((_aabb_max - _aabb_min) * 0.5f);
+  float radius = (aabb_center - _aabb_min).length();
+
+  BoundingSphere sphere(aabb_center, radius);
+  _point_primitive->set_bounds(&sphere);
+  get_render_node()->mark_internal_bounds_stale();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function : output
 //       Access : Public
@@ -68,6 +68,9 @@ PUBLISHED:
   virtual void output(ostream &out) const;
   virtual void write(ostream &out, int indent_level = 0) const;
 
+public:
+  virtual bool supports_packed_pool() const;
+
 private:
   Colorf _start_color;
   Colorf _end_color;
@@ -87,12 +90,14 @@ private:
   LPoint3f _aabb_max;
 
   Colorf create_color(const BaseParticle *p);
+  INLINE Colorf create_pool_color(const ParticlePool &pool, int n) const;
 
   virtual void birth_particle(int index);
   virtual void kill_particle(int index);
   virtual void init_geoms();
   virtual void render(pvector< PT(PhysicsObject) >& po_vector,
                       int ttl_particles);
+  virtual void render_pool(const ParticlePool &pool);
   virtual void resize_pool(int new_size);
 
   static PStatCollector _render_collector;
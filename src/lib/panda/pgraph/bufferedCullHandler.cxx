@@ -0,0 +1,72 @@
+// Filename: bufferedCullHandler.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "bufferedCullHandler.h"
+#include "cullableObject.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: BufferedCullHandler::Destructor
+//       Access: Public, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+BufferedCullHandler::
+~BufferedCullHandler() {
+  clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BufferedCullHandler::record_object
+//       Access: Public, Virtual
+//  Description: This callback function is intended to be overridden
+//               by a derived class.  This is called as each Geom is
+//               discovered by the CullTraverser.
+//
+//               The object is simply saved for a later replay().
+////////////////////////////////////////////////////////////////////
+void BufferedCullHandler::
+record_object(CullableObject *object, const CullTraverser *) {
+  _objects.push_back(object);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BufferedCullHandler::replay
+//       Access: Public
+//  Description: Passes each of the recorded objects, in the order
+//               they were recorded, to the indicated CullHandler.
+//               Ownership of the objects is transferred to the
+//               handler, and the list of recorded objects is emptied.
+////////////////////////////////////////////////////////////////////
+void BufferedCullHandler::
+replay(CullHandler *handler, const CullTraverser *traverser) {
+  Objects::iterator oi;
+  for (oi = _objects.begin(); oi != _objects.end(); ++oi) {
+    handler->record_object(*oi, traverser);
+  }
+  _objects.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BufferedCullHandler::clear
+//       Access: Public
+//  Description: Deletes all of the recorded objects without passing
+//               them along.
+////////////////////////////////////////////////////////////////////
+void BufferedCullHandler::
+clear() {
+  Objects::iterator oi;
+  for (oi = _objects.begin(); oi != _objects.end(); ++oi) {
+    delete (*oi);
+  }
+  _objects.clear();
+}
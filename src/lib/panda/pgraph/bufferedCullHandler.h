@@ -0,0 +1,55 @@
+// Filename: bufferedCullHandler.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef BUFFEREDCULLHANDLER_H
+#define BUFFEREDCULLHANDLER_H
+
+#include "pandabase.h"
+#include "cullHandler.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : BufferedCullHandler
+// Description : This CullHandler simply stores each CullableObject
+//               it receives, in the order it receives them, so that
+//               they may be passed along to another CullHandler
+//               later, via replay().
+//
+//               This is used to implement the parallel cull
+//               traversal: each subtree of the scene graph is culled
+//               into its own BufferedCullHandler, and the results are
+//               replayed into the real CullHandler in the original
+//               scene graph order once all of the subtrees have been
+//               culled.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH BufferedCullHandler : public CullHandler {
+public:
+  INLINE BufferedCullHandler();
+  virtual ~BufferedCullHandler();
+
+  virtual void record_object(CullableObject *object, 
+                             const CullTraverser *traverser);
+
+  INLINE int get_num_objects() const;
+  void replay(CullHandler *handler, const CullTraverser *traverser);
+  void clear();
+
+private:
+  typedef pvector<CullableObject *> Objects;
+  Objects _objects;
+};
+
+#include "bufferedCullHandler.I"
+
+#endif
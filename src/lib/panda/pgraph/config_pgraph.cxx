@@ -30,7 +30,9 @@
 #include "cullFaceAttrib.h"
 #include "cullBin.h"
 #include "cullBinAttrib.h"
+#include "cullCacheNode.h"
 #include "cullTraverser.h"
+#include "cullWorkerTask.h"
 #include "cullableObject.h"
 #include "decalEffect.h"
 #include "depthOffsetAttrib.h"
@@ -45,6 +47,8 @@
 #include "geomDrawCallbackData.h"
 #include "geomNode.h"
 #include "geomTransformer.h"
+#include "instanceList.h"
+#include "instancedNode.h"
 #include "lensNode.h"
 #include "light.h"
 #include "lightAttrib.h"
@@ -127,6 +131,39 @@ ConfigVariableBool debug_portal_cull
           "(You first need to enable portal culling, using the allow-portal-cull"
           "variable.)"));
 
+ConfigVariableInt cull_num_threads
+("cull-num-threads", 0,
+ PRC_DESC("The number of worker threads that should be used to perform the "
+          "cull traversal of a single DisplayRegion in parallel.  When this "
+          "is 0 (the default), the traversal is performed entirely on the "
+          "cull thread, as usual.  When it is greater than 0, the scene "
+          "graph is split into independent subtrees at cull-split-depth, "
+          "and those subtrees are culled on this many threads.  The "
+          "resulting objects are still delivered to the CullResult in the "
+          "same order as a single-threaded traversal.  Any cull callbacks "
+          "within the scene graph must be thread-safe to use this."));
+
+ConfigVariableInt cull_split_depth
+("cull-split-depth", 2,
+ PRC_DESC("When cull-num-threads is nonzero, this specifies the depth below "
+          "the scene root at which the cull traversal is split into "
+          "subtrees to be handed to the worker threads.  Nodes above this "
+          "depth are traversed by the cull thread itself."));
+
+ConfigVariableBool cull_cache
+("cull-cache", true,
+ PRC_DESC("Set this false to disable the caching performed by CullCacheNode, "
+          "so that the subgraph below each CullCacheNode is traversed "
+          "every frame, as if it were an ordinary PandaNode.  This is "
+          "intended as a debugging aid."));
+
+ConfigVariableInt cull_cache_max_age
+("cull-cache-max-age", 30,
+ PRC_DESC("The number of frames for which a CullCacheNode keeps the objects "
+          "it recorded for a particular camera after the camera stops "
+          "viewing it.  The objects are discarded sooner if the camera, "
+          "its lens or its GSG is destructed."));
+
 
 ConfigVariableBool unambiguous_graph
 ("unambiguous-graph", false,
@@ -202,6 +239,15 @@ ConfigVariableBool state_cache
           "similar to the TransformState cache controlled via "
           "transform-cache."));
 
+ConfigVariableInt thread_composition_cache_size
+("thread-composition-cache-size", 256,
+ PRC_DESC("The number of recent TransformState and RenderState "
+          "compositions that each thread remembers privately, in addition "
+          "to the shared composition cache.  A hit in this per-thread "
+          "cache does not need to take the global state lock, which "
+          "reduces contention when several threads are composing states "
+          "at once.  Set this to 0 to disable the per-thread caches."));
+
 ConfigVariableBool uniquify_transforms
 ("uniquify-transforms", true,
  PRC_DESC("Set this true to ensure that equivalent TransformStates "
@@ -295,6 +341,17 @@ ConfigVariableBool flatten_geoms
           "only the NodePath interfaces; you may still make the lower-level "
           "SceneGraphReducer calls directly."));
 
+ConfigVariableInt flatten_threads
+("flatten-threads", 0,
+ PRC_DESC("The number of additional threads that a SceneGraphReducer "
+          "will use to apply attribs, flatten, collect vertex data and "
+          "unify.  Independent subtrees of the scene graph (subtrees that "
+          "share no nodes and no vertex data with each other) are "
+          "processed concurrently, and the result is the same as that of "
+          "a serial flatten.  Set this to 0 to flatten on the calling "
+          "thread only.  This has no effect unless Panda is compiled with "
+          "true threads."));
+
 ConfigVariableInt max_lenses
 ("max-lenses", 100,
  PRC_DESC("Specifies an upper limit on the maximum number of lenses "
@@ -304,6 +361,26 @@ ConfigVariableInt max_lenses
           "this can be used as a simple sanity check.  Set it larger or "
           "smaller to suit your needs."));
 
+ConfigVariableBool bounds_incremental
+("bounds-incremental", false,
+ PRC_DESC("Set this true to have each PandaNode remember the bounding "
+          "volumes and masks of each of its children, and the children "
+          "whose bounds have changed since they were last computed.  When "
+          "a node's bounds are next requested, only the changed children "
+          "are examined, and the node's bounding volume is only grown, if "
+          "necessary, to enclose their new bounds.  This saves time when "
+          "a few of many children are animated, at the cost of some memory "
+          "per node and of bounding volumes that may be larger than "
+          "necessary.  This only affects nodes created while it is set, "
+          "and only with a single-stage pipeline."));
+
+ConfigVariableInt bounds_incremental_refresh
+("bounds-incremental-refresh", 30,
+ PRC_DESC("When bounds-incremental is in effect, this is the number of "
+          "times a node's bounding volume may be updated incrementally "
+          "before it is recomputed from scratch, to tighten it up "
+          "again."));
+
 ConfigVariableBool polylight_info
 ("polylight-info", false,
  PRC_DESC("Set this true to view some info statements regarding the polylight. "
@@ -430,7 +507,9 @@ init_libpgraph() {
   CullFaceAttrib::init_type();
   CullBin::init_type();
   CullBinAttrib::init_type();
+  CullCacheNode::init_type();
   CullTraverser::init_type();
+  CullWorkerTask::init_type();
   CullableObject::init_type();
   DecalEffect::init_type();
   DepthOffsetAttrib::init_type();
@@ -445,6 +524,8 @@ init_libpgraph() {
   GeomDrawCallbackData::init_type();
   GeomNode::init_type();
   GeomTransformer::init_type();
+  InstanceList::init_type();
+  InstancedNode::init_type();
   LensNode::init_type();
   Light::init_type();
   LightAttrib::init_type();
@@ -510,6 +591,7 @@ init_libpgraph() {
   ColorScaleAttrib::register_with_read_factory();
   ColorWriteAttrib::register_with_read_factory();
   CullBinAttrib::register_with_read_factory();
+  CullCacheNode::register_with_read_factory();
   CullFaceAttrib::register_with_read_factory();
   DecalEffect::register_with_read_factory();
   DepthOffsetAttrib::register_with_read_factory();
@@ -519,6 +601,8 @@ init_libpgraph() {
   Fog::register_with_read_factory();
   FogAttrib::register_with_read_factory();
   GeomNode::register_with_read_factory();
+  InstanceList::register_with_read_factory();
+  InstancedNode::register_with_read_factory();
   LensNode::register_with_read_factory();
   LightAttrib::register_with_read_factory();
   LightRampAttrib::register_with_read_factory();
@@ -35,6 +35,10 @@ extern ConfigVariableBool fake_view_frustum_cull;
 extern ConfigVariableBool clip_plane_cull;
 extern ConfigVariableBool allow_portal_cull;
 extern ConfigVariableBool debug_portal_cull;
+extern ConfigVariableInt cull_num_threads;
+extern ConfigVariableInt cull_split_depth;
+extern ConfigVariableBool cull_cache;
+extern ConfigVariableInt cull_cache_max_age;
 extern ConfigVariableBool unambiguous_graph;
 extern ConfigVariableBool detect_graph_cycles;
 extern ConfigVariableBool no_unsupported_copy;
@@ -46,6 +50,7 @@ extern ConfigVariableBool paranoid_const;
 extern ConfigVariableBool auto_break_cycles;
 extern ConfigVariableBool transform_cache;
 extern ConfigVariableBool state_cache;
+extern ConfigVariableInt thread_composition_cache_size;
 extern ConfigVariableBool uniquify_transforms;
 extern ConfigVariableBool uniquify_states;
 extern ConfigVariableBool uniquify_attribs;
@@ -57,7 +62,10 @@ extern ConfigVariableInt max_collect_indices;
 extern EXPCL_PANDA_PGRAPH ConfigVariableBool premunge_data;
 extern ConfigVariableBool preserve_geom_nodes;
 extern ConfigVariableBool flatten_geoms;
+extern EXPCL_PANDA_PGRAPH ConfigVariableInt flatten_threads;
 extern EXPCL_PANDA_PGRAPH ConfigVariableInt max_lenses;
+extern ConfigVariableBool bounds_incremental;
+extern ConfigVariableInt bounds_incremental_refresh;
 
 extern ConfigVariableBool polylight_info;
 extern ConfigVariableDouble lod_fade_time;
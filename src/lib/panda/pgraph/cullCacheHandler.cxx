@@ -0,0 +1,121 @@
+// Filename: cullCacheHandler.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "cullCacheHandler.h"
+#include "cullableObject.h"
+#include "callbackObject.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheHandler::Constructor
+//       Access: Public
+//  Description: Each object recorded will be passed along to the
+//               indicated CullHandler, in addition to being kept.
+////////////////////////////////////////////////////////////////////
+CullCacheHandler::
+CullCacheHandler(CullHandler *next) :
+  _next(next),
+  _next_recorder(NULL)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheHandler::Destructor
+//       Access: Public, Virtual
+//  Description: Deletes any objects that have not been taken by
+//               take_results().
+////////////////////////////////////////////////////////////////////
+CullCacheHandler::
+~CullCacheHandler() {
+  Objects::iterator oi;
+  for (oi = _objects.begin(); oi != _objects.end(); ++oi) {
+    delete (*oi);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheHandler::record_object
+//       Access: Public, Virtual
+//  Description: This callback function is intended to be overridden
+//               by a derived class.  This is called as each Geom is
+//               discovered by the CullTraverser.
+//
+//               The object is copied before it is passed along, since
+//               the next CullHandler may modify it, for instance by
+//               munging its Geom.
+////////////////////////////////////////////////////////////////////
+void CullCacheHandler::
+record_object(CullableObject *object, const CullTraverser *traverser) {
+  _objects.push_back(copy_object(object));
+  _next->record_object(object, traverser);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheHandler::note_stream_texture
+//       Access: Public
+//  Description: Called by the CullTraverser when it notes the size
+//               on screen of a streamed texture; see
+//               CullTraverser::note_stream_textures().
+////////////////////////////////////////////////////////////////////
+void CullCacheHandler::
+note_stream_texture(Texture *tex, int screen_size) {
+  _stream_notes.push_back(StreamNotes::value_type(tex, screen_size));
+  if (_next_recorder != (CullCacheHandler *)NULL) {
+    // We are nested within another CullCacheNode, which also needs
+    // to know.
+    _next_recorder->note_stream_texture(tex, screen_size);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheHandler::take_results
+//       Access: Public
+//  Description: Moves the recorded objects and stream notes into the
+//               indicated lists, which should be empty, leaving this
+//               handler empty.  The caller becomes responsible for
+//               deleting the objects.
+////////////////////////////////////////////////////////////////////
+void CullCacheHandler::
+take_results(Objects &objects, StreamNotes &stream_notes) {
+  nassertv(objects.empty() && stream_notes.empty());
+  objects.swap(_objects);
+  stream_notes.swap(_stream_notes);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheHandler::copy_object
+//       Access: Public, Static
+//  Description: Returns a newly-allocated copy of the indicated
+//               object, including its decals, draw callback, and
+//               instance transforms.
+////////////////////////////////////////////////////////////////////
+CullableObject *CullCacheHandler::
+copy_object(const CullableObject *object) {
+  CullableObject *result = new CullableObject(*object);
+
+  if (object->get_draw_callback() != (CallbackObject *)NULL) {
+    result->set_draw_callback(object->get_draw_callback());
+  }
+  const CullableObject::InstanceTransforms *transforms = 
+    object->get_instance_transforms();
+  if (transforms != (CullableObject::InstanceTransforms *)NULL) {
+    result->set_instance_transforms
+      (new CullableObject::InstanceTransforms(*transforms));
+  }
+  const CullableObject *next = object->get_next();
+  if (next != (CullableObject *)NULL) {
+    result->set_next(copy_object(next));
+  }
+  return result;
+}
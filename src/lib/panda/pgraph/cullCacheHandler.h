@@ -0,0 +1,65 @@
+// Filename: cullCacheHandler.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef CULLCACHEHANDLER_H
+#define CULLCACHEHANDLER_H
+
+#include "pandabase.h"
+#include "cullHandler.h"
+#include "texture.h"
+#include "pointerTo.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : CullCacheHandler
+// Description : This CullHandler is used while the CullTraverser
+//               visits the children of a CullCacheNode whose cached
+//               results can't be used.  Each CullableObject found is
+//               passed along to the next CullHandler, and a copy of
+//               it is kept, along with the sizes on screen noted for
+//               any streamed textures, so that the CullCacheNode can
+//               replay them in later frames without traversing its
+//               children.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH CullCacheHandler : public CullHandler {
+public:
+  CullCacheHandler(CullHandler *next);
+  virtual ~CullCacheHandler();
+
+  virtual void record_object(CullableObject *object, 
+                             const CullTraverser *traverser);
+  void note_stream_texture(Texture *tex, int screen_size);
+
+  typedef pvector<CullableObject *> Objects;
+  typedef pvector< pair<PT(Texture), int> > StreamNotes;
+
+  INLINE int get_num_objects() const;
+  void take_results(Objects &objects, StreamNotes &stream_notes);
+
+  static CullableObject *copy_object(const CullableObject *object);
+
+private:
+  CullHandler *_next;
+  CullCacheHandler *_next_recorder;
+
+  Objects _objects;
+  StreamNotes _stream_notes;
+
+  friend class CullTraverser;
+};
+
+#include "cullCacheHandler.I"
+
+#endif
@@ -0,0 +1,361 @@
+// Filename: cullCacheNode.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "cullCacheNode.h"
+#include "cullTraverser.h"
+#include "cullTraverserData.h"
+#include "cullHandler.h"
+#include "cullableObject.h"
+#include "cullPlanes.h"
+#include "sceneSetup.h"
+#include "lens.h"
+#include "clockObject.h"
+#include "lightMutexHolder.h"
+#include "config_pgraph.h"
+#include "bamReader.h"
+#include "datagramIterator.h"
+
+PStatCollector CullCacheNode::_hits_pcollector("Cull cache:Hits");
+PStatCollector CullCacheNode::_misses_pcollector("Cull cache:Misses");
+PStatCollector CullCacheNode::_expired_pcollector("Cull cache:Expired");
+
+TypeHandle CullCacheNode::_type_handle;
+
+// Returns true if the two transforms are equivalent.  They are
+// usually the same pointer, if the camera and the node have not
+// moved, but if they were recomputed they might not be.
+static bool
+same_transform(const TransformState *a, const TransformState *b) {
+  return (a == b) || (!(*a < *b) && !(*b < *a));
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::Key::operator ==
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+bool CullCacheNode::Key::
+operator == (const Key &other) const {
+  return (_gsg == other._gsg &&
+          _camera == other._camera &&
+          _lens == other._lens &&
+          _lens_change == other._lens_change &&
+          _state == other._state &&
+          _draw_mask == other._draw_mask &&
+          _camera_mask == other._camera_mask &&
+          _has_view_frustum == other._has_view_frustum &&
+          _bounds_seq == other._bounds_seq &&
+          same_transform(_world_transform, other._world_transform) &&
+          same_transform(_net_transform, other._net_transform));
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::Key::was_deleted
+//       Access: Public
+//  Description: Returns true if the camera, lens or GSG for which
+//               this key was made has since been destructed.
+////////////////////////////////////////////////////////////////////
+bool CullCacheNode::Key::
+was_deleted() const {
+  return (_gsg.was_deleted() || _camera.was_deleted() || 
+          _lens.was_deleted());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::Entry::Destructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+CullCacheNode::Entry::
+~Entry() {
+  clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::Entry::clear
+//       Access: Public
+//  Description: Deletes the recorded objects.
+////////////////////////////////////////////////////////////////////
+void CullCacheNode::Entry::
+clear() {
+  CullCacheHandler::Objects::iterator oi;
+  for (oi = _objects.begin(); oi != _objects.end(); ++oi) {
+    delete (*oi);
+  }
+  _objects.clear();
+  _stream_notes.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::Constructor
+//       Access: Published
+//  Description:
+////////////////////////////////////////////////////////////////////
+CullCacheNode::
+CullCacheNode(const string &name) :
+  PandaNode(name),
+  _lock("CullCacheNode::_lock")
+{
+  set_cull_callback();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::Copy Constructor
+//       Access: Protected
+//  Description: The cache itself is not copied.
+////////////////////////////////////////////////////////////////////
+CullCacheNode::
+CullCacheNode(const CullCacheNode &copy) :
+  PandaNode(copy),
+  _lock("CullCacheNode::_lock")
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::Destructor
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+CullCacheNode::
+~CullCacheNode() {
+  clear_cache();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::make_copy
+//       Access: Public, Virtual
+//  Description: Returns a newly-allocated Node that is a shallow copy
+//               of this one.  It will be a different Node pointer,
+//               but its internal data may or may not be shared with
+//               that of the original Node.
+////////////////////////////////////////////////////////////////////
+PandaNode *CullCacheNode::
+make_copy() const {
+  return new CullCacheNode(*this);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::cull_callback
+//       Access: Public, Virtual
+//  Description: This function will be called during the cull
+//               traversal to perform any additional operations that
+//               should be performed at cull time.
+//
+//               If the objects recorded for this camera the last time
+//               are still good, they are passed to the CullHandler
+//               again, and false is returned, since there is no need
+//               to traverse the children.  Otherwise, the children
+//               are traversed here, and the objects found are
+//               recorded for next time.
+////////////////////////////////////////////////////////////////////
+bool CullCacheNode::
+cull_callback(CullTraverser *trav, CullTraverserData &data) {
+  if (!cull_cache || !data._cull_planes->is_empty() ||
+      trav->is_occlusion_culling()) {
+    // The clip planes and occluders in effect are different each
+    // frame, so we don't try to cache anything beneath them.  Nor do
+    // we cache the result of occlusion culling, which depends on
+    // geometry outside this node.
+    return true;
+  }
+
+  Thread *current_thread = trav->get_current_thread();
+  SceneSetup *scene = trav->get_scene();
+
+  Key key;
+  key._gsg = trav->get_gsg();
+  key._camera = scene->get_camera_node();
+  key._lens = scene->get_lens();
+  if (key._lens != (Lens *)NULL) {
+    key._lens_change = key._lens->get_last_change();
+  }
+  key._world_transform = trav->get_world_transform();
+  key._net_transform = data.get_net_transform(trav);
+  key._state = data._state;
+  key._draw_mask = data._draw_mask;
+  key._camera_mask = trav->get_camera_mask();
+  key._has_view_frustum = (data._view_frustum != (GeometricBoundingVolume *)NULL);
+
+  // This changes whenever anything at all below this node changes.
+  get_bounds(key._bounds_seq, current_thread);
+
+  ClockObject *clock = ClockObject::get_global_clock();
+  int frame = clock->get_frame_count(current_thread);
+
+  {
+    LightMutexHolder holder(_lock);
+    expire_entries(frame);
+
+    Entry *entry = find_entry(key);
+    if (entry != (Entry *)NULL && entry->_key == key) {
+      _hits_pcollector.add_level(1);
+      entry->_last_frame = frame;
+
+      CullHandler *handler = trav->get_cull_handler();
+      CullCacheHandler::Objects::const_iterator oi;
+      for (oi = entry->_objects.begin(); oi != entry->_objects.end(); ++oi) {
+        handler->record_object(CullCacheHandler::copy_object(*oi), trav);
+      }
+
+      if (trav->get_stream_textures()) {
+        CullCacheHandler::StreamNotes::const_iterator si;
+        for (si = entry->_stream_notes.begin(); 
+             si != entry->_stream_notes.end(); 
+             ++si) {
+          trav->note_stream_texture((*si).first, (*si).second);
+        }
+      }
+      return false;
+    }
+  }
+
+  _misses_pcollector.add_level(1);
+
+  CullCacheHandler recorder(trav->get_cull_handler());
+  trav->traverse_cached(data, &recorder);
+
+  LightMutexHolder holder(_lock);
+  Entry *entry = find_entry(key);
+  if (entry == (Entry *)NULL) {
+    entry = new Entry;
+    _entries.push_back(entry);
+  } else {
+    entry->clear();
+  }
+  entry->_key = key;
+  entry->_last_frame = frame;
+  recorder.take_results(entry->_objects, entry->_stream_notes);
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::clear_cache
+//       Access: Published
+//  Description: Discards all of the recorded objects, so that the
+//               children will be traversed again the next time the
+//               node is rendered.  This should be called after making
+//               a change below the node that it can't detect by
+//               itself; see the class description.
+////////////////////////////////////////////////////////////////////
+void CullCacheNode::
+clear_cache() {
+  LightMutexHolder holder(_lock);
+  Entries::iterator ei;
+  for (ei = _entries.begin(); ei != _entries.end(); ++ei) {
+    delete (*ei);
+  }
+  _entries.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::get_num_cached_objects
+//       Access: Published
+//  Description: Returns the total number of objects recorded for all
+//               of the cameras that have viewed this node.
+////////////////////////////////////////////////////////////////////
+int CullCacheNode::
+get_num_cached_objects() const {
+  LightMutexHolder holder(_lock);
+  int num_objects = 0;
+  Entries::const_iterator ei;
+  for (ei = _entries.begin(); ei != _entries.end(); ++ei) {
+    num_objects += (int)(*ei)->_objects.size();
+  }
+  return num_objects;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::find_entry
+//       Access: Private
+//  Description: Returns the entry recorded for the camera, GSG and
+//               camera mask indicated in the key, or NULL if there is
+//               none.  The lock should be held, and expire_entries()
+//               should have been called first, so that an entry for a
+//               deleted camera or GSG can't match a new one that
+//               happens to have been allocated at the same address.
+//
+//               The camera mask distinguishes the traversals that a
+//               single camera may make of the same scene in one
+//               frame, for instance to find the occluders for a
+//               SoftwareOcclusionCullTraverser.
+////////////////////////////////////////////////////////////////////
+CullCacheNode::Entry *CullCacheNode::
+find_entry(const Key &key) const {
+  Entries::const_iterator ei;
+  for (ei = _entries.begin(); ei != _entries.end(); ++ei) {
+    if ((*ei)->_key._gsg == key._gsg && (*ei)->_key._camera == key._camera &&
+        (*ei)->_key._camera_mask == key._camera_mask) {
+      return (*ei);
+    }
+  }
+  return NULL;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::expire_entries
+//       Access: Private
+//  Description: Deletes the entries whose camera, lens or GSG has
+//               been destructed, and those that have not been used
+//               for more than cull-cache-max-age frames.  The lock
+//               should be held.
+////////////////////////////////////////////////////////////////////
+void CullCacheNode::
+expire_entries(int frame) {
+  Entries::iterator ei = _entries.begin();
+  while (ei != _entries.end()) {
+    Entry *entry = (*ei);
+    if (entry->_key.was_deleted() || 
+        frame - entry->_last_frame > cull_cache_max_age) {
+      _expired_pcollector.add_level(1);
+      delete entry;
+      ei = _entries.erase(ei);
+    } else {
+      ++ei;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::register_with_read_factory
+//       Access: Public, Static
+//  Description: Tells the BamReader how to create objects of type
+//               CullCacheNode.
+////////////////////////////////////////////////////////////////////
+void CullCacheNode::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullCacheNode::make_from_bam
+//       Access: Protected, Static
+//  Description: This function is called by the BamReader's factory
+//               when a new object of type CullCacheNode is
+//               encountered in the Bam file.  It should create the
+//               CullCacheNode and extract its information from the
+//               file.
+////////////////////////////////////////////////////////////////////
+TypedWritable *CullCacheNode::
+make_from_bam(const FactoryParams &params) {
+  CullCacheNode *node = new CullCacheNode("");
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  node->fillin(scan, manager);
+
+  return node;
+}
@@ -0,0 +1,155 @@
+// Filename: cullCacheNode.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef CULLCACHENODE_H
+#define CULLCACHENODE_H
+
+#include "pandabase.h"
+
+#include "pandaNode.h"
+#include "cullCacheHandler.h"
+#include "lightMutex.h"
+#include "updateSeq.h"
+#include "weakPointerTo.h"
+#include "pStatCollector.h"
+
+class Lens;
+class GraphicsStateGuardianBase;
+
+////////////////////////////////////////////////////////////////////
+//       Class : CullCacheNode
+// Description : A node that remembers, for each camera that views
+//               it, the CullableObjects that the cull traversal found
+//               below it in the last frame.  As long as neither the
+//               camera, its lens, the net transform and state of the
+//               node, nor anything at all below the node has changed
+//               since then, those objects are handed to the
+//               CullHandler again without traversing the node's
+//               children or testing any of their bounding volumes.
+//
+//               This is intended for large static parts of the scene,
+//               like buildings and terrain, viewed from a camera that
+//               is often still.  Parent such a subgraph to a
+//               CullCacheNode to enable the cache for it.
+//
+//               Changes below the node are detected by way of its
+//               bounding volume, which is recomputed whenever a node
+//               below it is changed, moved, added or removed.  Things
+//               that change without affecting the bounding volume,
+//               like the vertices of a Geom modified in place, or the
+//               visible child of a SequenceNode, are not detected;
+//               call clear_cache() after making such a change.
+//               Subgraphs affected by clip planes or occluders are
+//               not cached.
+//
+//               The objects recorded for a camera are discarded when
+//               the camera, its lens or its GSG is destructed, or
+//               when the camera has not viewed the node for
+//               cull-cache-max-age frames.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH CullCacheNode : public PandaNode {
+PUBLISHED:
+  CullCacheNode(const string &name);
+
+protected:
+  CullCacheNode(const CullCacheNode &copy);
+
+public:
+  virtual ~CullCacheNode();
+  virtual PandaNode *make_copy() const;
+
+  virtual bool cull_callback(CullTraverser *trav, CullTraverserData &data);
+
+  INLINE static void flush_level();
+  INLINE static void clear_level();
+
+PUBLISHED:
+  void clear_cache();
+  int get_num_cached_objects() const;
+
+private:
+  // The circumstances under which a set of objects was recorded.
+  // The camera, lens and GSG are held by weak pointers, so that we
+  // can tell when one of them has been destructed (and its address
+  // possibly reused by a new object) without keeping it alive.
+  class Key {
+  public:
+    INLINE Key();
+    bool operator == (const Key &other) const;
+    bool was_deleted() const;
+
+    WPT(GraphicsStateGuardianBase) _gsg;
+    WCPT(PandaNode) _camera;
+    WCPT(Lens) _lens;
+    UpdateSeq _lens_change;
+    CPT(TransformState) _world_transform;
+    CPT(TransformState) _net_transform;
+    CPT(RenderState) _state;
+    DrawMask _draw_mask;
+    DrawMask _camera_mask;
+    bool _has_view_frustum;
+    UpdateSeq _bounds_seq;
+  };
+
+  // The objects recorded for one camera.
+  class Entry {
+  public:
+    ~Entry();
+    void clear();
+
+    Key _key;
+    int _last_frame;
+    CullCacheHandler::Objects _objects;
+    CullCacheHandler::StreamNotes _stream_notes;
+  };
+  typedef pvector<Entry *> Entries;
+
+  Entry *find_entry(const Key &key) const;
+  void expire_entries(int frame);
+
+  Entries _entries;
+  LightMutex _lock;
+
+  static PStatCollector _hits_pcollector;
+  static PStatCollector _misses_pcollector;
+  static PStatCollector _expired_pcollector;
+
+public:
+  static void register_with_read_factory();
+
+protected:
+  static TypedWritable *make_from_bam(const FactoryParams &params);
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    PandaNode::init_type();
+    register_type(_type_handle, "CullCacheNode",
+                  PandaNode::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "cullCacheNode.I"
+
+#endif
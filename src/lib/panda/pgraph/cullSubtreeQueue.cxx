@@ -0,0 +1,155 @@
+// Filename: cullSubtreeQueue.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "cullSubtreeQueue.h"
+#include "cullTraverserData.h"
+#include "mutexHolder.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::Constructor
+//       Access: Public
+//  Description: 
+////////////////////////////////////////////////////////////////////
+CullSubtreeQueue::
+CullSubtreeQueue() :
+  _lock("CullSubtreeQueue::_lock"),
+  _cvar(_lock),
+  _next_deferred(0),
+  _num_working(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::Destructor
+//       Access: Public
+//  Description: 
+////////////////////////////////////////////////////////////////////
+CullSubtreeQueue::
+~CullSubtreeQueue() {
+  Subtrees::iterator si;
+  for (si = _subtrees.begin(); si != _subtrees.end(); ++si) {
+    delete (*si);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::add_segment
+//       Access: Public
+//  Description: Begins a new run of objects emitted directly by the
+//               cull thread, and returns the handler that should
+//               receive them.
+////////////////////////////////////////////////////////////////////
+BufferedCullHandler *CullSubtreeQueue::
+add_segment() {
+  Subtree *subtree = new Subtree;
+  _subtrees.push_back(subtree);
+  return &subtree->_handler;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::add_deferred
+//       Access: Public
+//  Description: Records the indicated node, which has been
+//               constructed but not yet traversed, as a subtree to be
+//               culled later by one of the worker tasks.
+////////////////////////////////////////////////////////////////////
+void CullSubtreeQueue::
+add_deferred(const CullTraverserData &data) {
+  Subtree *subtree = new Subtree;
+  subtree->_deferred = true;
+  subtree->_node_path = data._node_path.get_node_path();
+  subtree->_net_transform = data._net_transform;
+  subtree->_state = data._state;
+  subtree->_view_frustum = data._view_frustum;
+  subtree->_cull_planes = data._cull_planes;
+  subtree->_draw_mask = data._draw_mask;
+  _subtrees.push_back(subtree);
+  _deferred.push_back(subtree);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::claim_next
+//       Access: Public
+//  Description: Returns the next deferred subtree that has not yet
+//               been claimed by any worker, or NULL if all of them
+//               have been claimed.
+////////////////////////////////////////////////////////////////////
+CullSubtreeQueue::Subtree *CullSubtreeQueue::
+claim_next() {
+  MutexHolder holder(_lock);
+  if (_next_deferred >= (int)_deferred.size()) {
+    return NULL;
+  }
+  return _deferred[_next_deferred++];
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::start_tasks
+//       Access: Public
+//  Description: Indicates the number of worker tasks that are about
+//               to be started on this queue.  wait_for_tasks() will
+//               not return until each of them has called
+//               task_done().
+////////////////////////////////////////////////////////////////////
+void CullSubtreeQueue::
+start_tasks(int num_tasks) {
+  MutexHolder holder(_lock);
+  _num_working += num_tasks;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::task_done
+//       Access: Public
+//  Description: Called by each worker task when it has run out of
+//               subtrees to cull.
+////////////////////////////////////////////////////////////////////
+void CullSubtreeQueue::
+task_done() {
+  MutexHolder holder(_lock);
+  nassertv(_num_working > 0);
+  --_num_working;
+  if (_num_working == 0) {
+    _cvar.notify();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::wait_for_tasks
+//       Access: Public
+//  Description: Blocks until all of the worker tasks started on this
+//               queue have finished.
+////////////////////////////////////////////////////////////////////
+void CullSubtreeQueue::
+wait_for_tasks() {
+  MutexHolder holder(_lock);
+  while (_num_working > 0) {
+    _cvar.wait();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullSubtreeQueue::replay
+//       Access: Public
+//  Description: Passes all of the objects recorded in all of the
+//               subtrees to the indicated CullHandler, in the order
+//               in which a single-threaded traversal would have
+//               produced them.
+////////////////////////////////////////////////////////////////////
+void CullSubtreeQueue::
+replay(CullHandler *handler, const CullTraverser *traverser) {
+  Subtrees::iterator si;
+  for (si = _subtrees.begin(); si != _subtrees.end(); ++si) {
+    (*si)->_handler.replay(handler, traverser);
+  }
+}
@@ -0,0 +1,94 @@
+// Filename: cullSubtreeQueue.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef CULLSUBTREEQUEUE_H
+#define CULLSUBTREEQUEUE_H
+
+#include "pandabase.h"
+
+#include "bufferedCullHandler.h"
+#include "cullPlanes.h"
+#include "nodePath.h"
+#include "transformState.h"
+#include "renderState.h"
+#include "geometricBoundingVolume.h"
+#include "drawMask.h"
+#include "referenceCount.h"
+#include "pvector.h"
+#include "pmutex.h"
+#include "conditionVar.h"
+
+class CullTraverser;
+class CullTraverserData;
+
+////////////////////////////////////////////////////////////////////
+//       Class : CullSubtreeQueue
+// Description : This collects the output of a parallel cull
+//               traversal (see cull-num-threads), in scene graph
+//               order.  The output is divided into a sequence of
+//               Subtrees: each one is either a subtree of the scene
+//               graph that has been deferred to be culled by one of
+//               the CullWorkerTasks, or the run of objects that were
+//               emitted directly by the cull thread between two
+//               deferred subtrees.
+//
+//               Once all of the workers have finished, replay()
+//               passes the objects along to the real CullHandler in
+//               the same order a single-threaded traversal would
+//               have produced them.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH CullSubtreeQueue : public ReferenceCount {
+public:
+  class Subtree {
+  public:
+    INLINE Subtree();
+
+    bool _deferred;
+    NodePath _node_path;
+    CPT(TransformState) _net_transform;
+    CPT(RenderState) _state;
+    PT(GeometricBoundingVolume) _view_frustum;
+    CPT(CullPlanes) _cull_planes;
+    DrawMask _draw_mask;
+    BufferedCullHandler _handler;
+  };
+
+  CullSubtreeQueue();
+  ~CullSubtreeQueue();
+
+  BufferedCullHandler *add_segment();
+  void add_deferred(const CullTraverserData &data);
+  INLINE int get_num_deferred() const;
+
+  Subtree *claim_next();
+  void start_tasks(int num_tasks);
+  void task_done();
+  void wait_for_tasks();
+
+  void replay(CullHandler *handler, const CullTraverser *traverser);
+
+private:
+  typedef pvector<Subtree *> Subtrees;
+  Subtrees _subtrees;
+  Subtrees _deferred;
+
+  Mutex _lock;
+  ConditionVar _cvar;
+  int _next_deferred;
+  int _num_working;
+};
+
+#include "cullSubtreeQueue.I"
+
+#endif
@@ -28,17 +28,28 @@
 #include "boundingSphere.h"
 #include "boundingBox.h"
 #include "boundingHexahedron.h"
+#include "finiteBoundingVolume.h"
 #include "portalClipper.h"
 #include "geom.h"
 #include "geomTristrips.h"
 #include "geomTriangles.h"
 #include "geomLinestrips.h"
 #include "geomVertexWriter.h"
+#include "cullSubtreeQueue.h"
+#include "cullWorkerTask.h"
+#include "instanceCullHandler.h"
+#include "cullCacheHandler.h"
+#include "instanceList.h"
+#include "textureAttrib.h"
+#include "textureStreamManager.h"
+#include "lens.h"
+#include "deg_2_rad.h"
 
 PStatCollector CullTraverser::_nodes_pcollector("Nodes");
 PStatCollector CullTraverser::_geom_nodes_pcollector("Nodes:GeomNodes");
 PStatCollector CullTraverser::_geoms_pcollector("Geoms");
 PStatCollector CullTraverser::_geoms_occluded_pcollector("Geoms:Occluded");
+PStatCollector CullTraverser::_instances_pcollector("Geoms:Instances");
 
 TypeHandle CullTraverser::_type_handle;
 
@@ -58,6 +69,10 @@ CullTraverser() :
   _cull_handler = (CullHandler *)NULL;
   _portal_clipper = (PortalClipper *)NULL;
   _effective_incomplete_render = true;
+  _stream_textures = false;
+  _cull_cache_handler = (CullCacheHandler *)NULL;
+  _split_queue = (CullSubtreeQueue *)NULL;
+  _split_depth = 0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -78,7 +93,11 @@ CullTraverser(const CullTraverser &copy) :
   _view_frustum(copy._view_frustum),
   _cull_handler(copy._cull_handler),
   _portal_clipper(copy._portal_clipper),
-  _effective_incomplete_render(copy._effective_incomplete_render)
+  _effective_incomplete_render(copy._effective_incomplete_render),
+  _stream_textures(copy._stream_textures),
+  _cull_cache_handler(NULL),
+  _split_queue(NULL),
+  _split_depth(0)
 {
 }
 
@@ -106,6 +125,8 @@ set_scene(SceneSetup *scene_setup, GraphicsStateGuardianBase *gsg,
   _camera_mask = camera->get_camera_mask();
 
   _effective_incomplete_render = _gsg->get_incomplete_render() && dr_incomplete_render;
+
+  _stream_textures = (TextureStreamManager::get_global_ptr()->get_num_textures() != 0);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -154,6 +175,12 @@ traverse(const NodePath &root) {
     my_data._net_transform = my_data._net_transform->compose(transform);
     traverse(my_data);
 
+  } else if (CullWorkerTask::is_parallel_cull_available() &&
+             get_type() == CullTraverser::get_class_type()) {
+    // Only the base CullTraverser may be split across threads, since
+    // the worker threads each traverse with a copy of this object.
+    parallel_traverse(root);
+
   } else {
     CullTraverserData data(root, TransformState::make_identity(),
                            _initial_state, _view_frustum, 
@@ -172,6 +199,28 @@ traverse(const NodePath &root) {
 ////////////////////////////////////////////////////////////////////
 void CullTraverser::
 traverse(CullTraverserData &data) {
+  if (_split_queue != (CullSubtreeQueue *)NULL) {
+    // We are in the single-threaded portion of a parallel traversal.
+    if (_split_depth >= cull_split_depth) {
+      defer_subtree(data);
+    } else {
+      ++_split_depth;
+      do_traverse(data);
+      --_split_depth;
+    }
+    return;
+  }
+
+  do_traverse(data);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::do_traverse
+//       Access: Private
+//  Description: The implementation of traverse(), above.
+////////////////////////////////////////////////////////////////////
+void CullTraverser::
+do_traverse(CullTraverserData &data) {
   if (is_in_view(data)) {
     if (pgraph_cat.is_spam()) {
       pgraph_cat.spam() 
@@ -286,6 +335,83 @@ traverse_below(CullTraverserData &data) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::traverse_instanced
+//       Access: Public
+//  Description: Traverses the children of the indicated node, which
+//               has already been converted into the node's space,
+//               once, and renders everything found there once for
+//               each of the indicated instances.  This is normally
+//               called by InstancedNode::cull_callback(), which has
+//               already culled the instances against the view
+//               frustum.
+//
+//               The children are not view-frustum culled themselves,
+//               since they may be visible in one instance and not in
+//               another.
+////////////////////////////////////////////////////////////////////
+void CullTraverser::
+traverse_instanced(CullTraverserData &data, const InstanceList *instances) {
+  int num_instances = instances->get_num_instances();
+  if (num_instances == 0) {
+    return;
+  }
+  _instances_pcollector.add_level(num_instances);
+
+  InstanceCullHandler handler(_cull_handler, this, 
+                              data.get_net_transform(this), instances);
+
+  // The subtree must be traversed entirely within this call, since
+  // the handler lives on the stack; so it may not be split off for a
+  // parallel cull.
+  CullHandler *save_handler = _cull_handler;
+  CullSubtreeQueue *save_split_queue = _split_queue;
+  PT(GeometricBoundingVolume) save_view_frustum = data._view_frustum;
+  CPT(CullPlanes) save_cull_planes = data._cull_planes;
+
+  _cull_handler = &handler;
+  _split_queue = NULL;
+  data._view_frustum = NULL;
+  data._cull_planes = CullPlanes::make_empty();
+
+  traverse_below(data);
+
+  _cull_handler = save_handler;
+  _split_queue = save_split_queue;
+  data._view_frustum = save_view_frustum;
+  data._cull_planes = save_cull_planes;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::traverse_cached
+//       Access: Public
+//  Description: Traverses the children of the indicated node, which
+//               has already been converted into the node's space,
+//               passing each object found to the indicated handler
+//               instead of the current one.  This is called by
+//               CullCacheNode::cull_callback() to record the objects
+//               below the node; the handler passes them along to the
+//               current handler in turn.
+////////////////////////////////////////////////////////////////////
+void CullTraverser::
+traverse_cached(CullTraverserData &data, CullCacheHandler *handler) {
+  // As in traverse_instanced(), the subtree must be traversed
+  // entirely within this call.
+  CullHandler *save_handler = _cull_handler;
+  CullSubtreeQueue *save_split_queue = _split_queue;
+  handler->_next_recorder = _cull_cache_handler;
+
+  _cull_handler = handler;
+  _split_queue = NULL;
+  _cull_cache_handler = handler;
+
+  traverse_below(data);
+
+  _cull_handler = save_handler;
+  _split_queue = save_split_queue;
+  _cull_cache_handler = handler->_next_recorder;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CullTraverser::end_traverse
 //       Access: Published, Virtual
@@ -298,6 +424,118 @@ end_traverse() {
   _cull_handler->end_traverse();
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::note_stream_textures
+//       Access: Public
+//  Description: Records the size on screen of the node being
+//               traversed with each of the streamed textures applied
+//               by the indicated state; see
+//               Texture::note_stream_screen_size().  screen_size
+//               should be initialized to -1 for each node; the size
+//               is computed, and stored there, only when the first
+//               streamed texture is encountered.
+////////////////////////////////////////////////////////////////////
+void CullTraverser::
+note_stream_textures(const RenderState *state, CullTraverserData &data,
+                     const TransformState *modelview_transform,
+                     int &screen_size) {
+  const RenderAttrib *attrib = state->get_attrib(TextureAttrib::get_class_slot());
+  if (attrib == (const RenderAttrib *)NULL) {
+    return;
+  }
+  const TextureAttrib *ta = DCAST(TextureAttrib, attrib);
+
+  int num_stages = ta->get_num_on_stages();
+  for (int i = 0; i < num_stages; ++i) {
+    Texture *tex = ta->get_on_texture(ta->get_on_stage(i));
+    if (tex->get_streaming()) {
+      if (screen_size < 0) {
+        screen_size = compute_screen_size(data, modelview_transform);
+      }
+      if (screen_size > 0) {
+        note_stream_texture(tex, screen_size);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::note_stream_texture
+//       Access: Public
+//  Description: Records the size on screen of one streamed texture;
+//               see note_stream_textures().  If a CullCacheNode is
+//               recording the objects below it, it is told as well,
+//               so that it can note the same size again when it
+//               replays them.
+////////////////////////////////////////////////////////////////////
+void CullTraverser::
+note_stream_texture(Texture *tex, int screen_size) {
+  tex->note_stream_screen_size(screen_size);
+  if (_cull_cache_handler != (CullCacheHandler *)NULL) {
+    _cull_cache_handler->note_stream_texture(tex, screen_size);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::compute_screen_size
+//       Access: Public
+//  Description: Returns the approximate diameter, in pixels, of the
+//               bounding volume of the node being traversed, as
+//               projected by the current lens onto the current
+//               viewport.  A node whose bounds are infinite, or that
+//               surrounds the camera, is deemed to fill the
+//               viewport.  Returns 0 if the size cannot be
+//               determined.
+////////////////////////////////////////////////////////////////////
+int CullTraverser::
+compute_screen_size(CullTraverserData &data,
+                    const TransformState *modelview_transform) const {
+  const Lens *lens = _scene_setup->get_lens();
+  int viewport_size = max(_scene_setup->get_viewport_width(),
+                          _scene_setup->get_viewport_height());
+  if (lens == (const Lens *)NULL || viewport_size <= 0) {
+    return 0;
+  }
+
+  CPT(BoundingVolume) bounds = data.node_reader()->get_bounds();
+  if (bounds->is_infinite()) {
+    return viewport_size;
+  }
+  if (bounds->is_empty() ||
+      !bounds->is_of_type(FiniteBoundingVolume::get_class_type())) {
+    return 0;
+  }
+  const FiniteBoundingVolume *fbv = DCAST(FiniteBoundingVolume, bounds);
+  LPoint3f min_point = fbv->get_min();
+  LPoint3f max_point = fbv->get_max();
+
+  // Take the bounding sphere of the volume into camera space.
+  const LMatrix4f &mat = modelview_transform->get_mat();
+  LPoint3f center = LPoint3f((min_point + max_point) * 0.5f) * mat;
+  float scale = max(mat.get_row3(0).length(),
+                    max(mat.get_row3(1).length(), mat.get_row3(2).length()));
+  float radius = (max_point - min_point).length() * 0.5f * scale;
+
+  // The lens's field of view spans the viewport's height.
+  float pixels;
+  if (lens->is_perspective()) {
+    float distance = center.length();
+    if (distance <= radius) {
+      return viewport_size;
+    }
+    float tan_half_fov = ctan(deg_2_rad(lens->get_fov()[1] * 0.5f));
+    pixels = radius / (distance * tan_half_fov) * _scene_setup->get_viewport_height();
+  } else {
+    float film_height = lens->get_film_size()[1];
+    if (film_height <= 0.0f) {
+      return 0;
+    }
+    pixels = 2.0f * radius / film_height * _scene_setup->get_viewport_height();
+  }
+
+  return (int)min(pixels + 0.5f, (float)viewport_size);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CullTraverser::draw_bounding_volume
 //       Access: Published
@@ -324,6 +562,20 @@ draw_bounding_volume(const BoundingVolume *vol,
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::is_occlusion_culling
+//       Access: Public, Virtual
+//  Description: Returns true if this traverser prunes nodes that are
+//               hidden behind other geometry, in addition to those
+//               outside the view frustum.  Whether a node survives
+//               this test depends on things elsewhere in the scene,
+//               so a CullCacheNode doesn't cache its results.
+////////////////////////////////////////////////////////////////////
+bool CullTraverser::
+is_occlusion_culling() const {
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CullTraverser::is_in_view
 //       Access: Protected, Virtual
@@ -337,6 +589,66 @@ is_in_view(CullTraverserData &data) {
   return data.is_in_view(_camera_mask);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::parallel_traverse
+//       Access: Private
+//  Description: Performs the traversal from the indicated root node
+//               using multiple threads.  The top cull-split-depth
+//               levels of the scene graph are traversed on the
+//               current thread as usual, but each node found at that
+//               depth is deferred to be traversed later by one of the
+//               CullWorkerTasks.  When all of the workers have
+//               finished, the objects they have collected are passed
+//               along to the CullHandler in the same order as a
+//               single-threaded traversal.
+////////////////////////////////////////////////////////////////////
+void CullTraverser::
+parallel_traverse(const NodePath &root) {
+  CullHandler *cull_handler = _cull_handler;
+
+  PT(CullSubtreeQueue) queue = new CullSubtreeQueue;
+  _split_queue = queue;
+  _split_depth = 0;
+  _cull_handler = queue->add_segment();
+
+  CullTraverserData data(root, TransformState::make_identity(),
+                         _initial_state, _view_frustum, 
+                         _current_thread);
+  traverse(data);
+
+  _split_queue = (CullSubtreeQueue *)NULL;
+  _cull_handler = cull_handler;
+
+  int num_tasks = min((int)cull_num_threads, queue->get_num_deferred());
+  if (num_tasks > 0) {
+    AsyncTaskManager *task_manager = CullWorkerTask::get_task_manager();
+    queue->start_tasks(num_tasks);
+    for (int i = 0; i < num_tasks; ++i) {
+      PT(AsyncTask) task = new CullWorkerTask(this, queue, i);
+      task_manager->add(task);
+    }
+    queue->wait_for_tasks();
+  }
+
+  queue->replay(_cull_handler, this);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullTraverser::defer_subtree
+//       Access: Private
+//  Description: Called during the single-threaded portion of a
+//               parallel traversal to hand off the indicated node,
+//               and everything below it, to the worker threads.
+//               Any objects subsequently recorded by this thread go
+//               into a new segment that follows the deferred
+//               subtree.
+////////////////////////////////////////////////////////////////////
+void CullTraverser::
+defer_subtree(CullTraverserData &data) {
+  _split_queue->add_deferred(data);
+  _cull_handler = _split_queue->add_segment();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CullTraverser::show_bounds
 //       Access: Private
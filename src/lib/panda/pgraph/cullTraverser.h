@@ -35,6 +35,11 @@ class CullableObject;
 class CullTraverserData;
 class PortalClipper;
 class NodePath;
+class CullWorkerTask;
+class CullSubtreeQueue;
+class InstanceList;
+class CullCacheHandler;
+class Texture;
 
 ////////////////////////////////////////////////////////////////////
 //       Class : CullTraverser
@@ -95,13 +100,33 @@ protected:
   virtual bool is_in_view(CullTraverserData &data);
 
 public:
+  virtual bool is_occlusion_culling() const;
+
+  INLINE bool get_stream_textures() const;
+  void note_stream_textures(const RenderState *state,
+                            CullTraverserData &data,
+                            const TransformState *modelview_transform,
+                            int &screen_size);
+  void note_stream_texture(Texture *tex, int screen_size);
+  int compute_screen_size(CullTraverserData &data,
+                          const TransformState *modelview_transform) const;
+
+  void traverse_instanced(CullTraverserData &data,
+                          const InstanceList *instances);
+  void traverse_cached(CullTraverserData &data, CullCacheHandler *handler);
+
   // Statistics
   static PStatCollector _nodes_pcollector;
   static PStatCollector _geom_nodes_pcollector;
   static PStatCollector _geoms_pcollector;
   static PStatCollector _geoms_occluded_pcollector;
+  static PStatCollector _instances_pcollector;
 
 private:
+  void do_traverse(CullTraverserData &data);
+  void parallel_traverse(const NodePath &root);
+  void defer_subtree(CullTraverserData &data);
+
   void show_bounds(CullTraverserData &data, bool tight);
   PT(Geom) make_bounds_viz(const BoundingVolume *vol);
   PT(Geom) make_tight_bounds_viz(PandaNode *node);
@@ -126,6 +151,13 @@ private:
   CullHandler *_cull_handler;
   PortalClipper *_portal_clipper;
   bool _effective_incomplete_render;
+  bool _stream_textures;
+  CullCacheHandler *_cull_cache_handler;
+
+  // These are only used during the single-threaded portion of a
+  // parallel cull traversal; see parallel_traverse().
+  CullSubtreeQueue *_split_queue;
+  int _split_depth;
   
 public:
   static TypeHandle get_class_type() {
@@ -143,6 +175,8 @@ public:
 
 private:
   static TypeHandle _type_handle;
+
+  friend class CullWorkerTask;
 };
 
 #include "cullTraverser.I"
@@ -0,0 +1,138 @@
+// Filename: cullWorkerTask.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "cullWorkerTask.h"
+#include "cullTraverserData.h"
+#include "config_pgraph.h"
+#include "asyncTaskChain.h"
+#include "mutexHolder.h"
+#include "pStatTimer.h"
+#include "string_utils.h"
+
+PT(AsyncTaskManager) CullWorkerTask::_task_manager;
+Mutex CullWorkerTask::_task_manager_lock("CullWorkerTask::_task_manager_lock");
+
+PStatCollector CullWorkerTask::_workers_pcollector("Cull:Workers");
+
+TypeHandle CullWorkerTask::_type_handle;
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullWorkerTask::Constructor
+//       Access: Public
+//  Description: Creates a new worker task that will cull subtrees
+//               from the indicated queue, using a private copy of the
+//               indicated traverser.  The index is used only to
+//               identify the task's PStats collector.
+////////////////////////////////////////////////////////////////////
+CullWorkerTask::
+CullWorkerTask(const CullTraverser *trav, CullSubtreeQueue *queue,
+               int index) :
+  AsyncTask("cull:" + format_string(index)),
+  _trav(new CullTraverser(*trav)),
+  _queue(queue),
+  _pcollector(_workers_pcollector, "Worker " + format_string(index))
+{
+  set_task_chain(get_task_chain_name());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullWorkerTask::is_parallel_cull_available
+//       Access: Public, Static
+//  Description: Returns true if the parallel cull traversal has been
+//               requested via cull-num-threads, and threading support
+//               is available to implement it.
+////////////////////////////////////////////////////////////////////
+bool CullWorkerTask::
+is_parallel_cull_available() {
+  return cull_num_threads > 0 && Thread::is_threading_supported();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullWorkerTask::get_task_manager
+//       Access: Public, Static
+//  Description: Returns the AsyncTaskManager that services the
+//               parallel cull tasks.  This is a private task manager,
+//               separate from the global task manager, so that the
+//               cull workers do not compete with the application's
+//               own tasks for the manager's lock.
+////////////////////////////////////////////////////////////////////
+AsyncTaskManager *CullWorkerTask::
+get_task_manager() {
+  // The pointer is read under the lock too; it may be assigned by
+  // another thread at any time until it has been created.
+  MutexHolder holder(_task_manager_lock);
+  if (_task_manager == (AsyncTaskManager *)NULL) {
+    make_task_manager();
+  }
+  return _task_manager;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullWorkerTask::get_task_chain_name
+//       Access: Public, Static
+//  Description: Returns the name of the task chain on which the
+//               worker tasks are run.
+////////////////////////////////////////////////////////////////////
+const string &CullWorkerTask::
+get_task_chain_name() {
+  static string name = "cull";
+  return name;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullWorkerTask::do_task
+//       Access: Protected, Virtual
+//  Description: Culls subtrees from the queue until there are no more
+//               left to claim.
+////////////////////////////////////////////////////////////////////
+AsyncTask::DoneStatus CullWorkerTask::
+do_task() {
+  Thread *current_thread = Thread::get_current_thread();
+  PStatTimer timer(_pcollector, current_thread);
+
+  _trav->_current_thread = current_thread;
+
+  CullSubtreeQueue::Subtree *subtree = _queue->claim_next();
+  while (subtree != (CullSubtreeQueue::Subtree *)NULL) {
+    _trav->set_cull_handler(&subtree->_handler);
+
+    CullTraverserData data(subtree->_node_path, subtree->_net_transform,
+                           subtree->_state, subtree->_view_frustum,
+                           current_thread);
+    data._cull_planes = subtree->_cull_planes;
+    data._draw_mask = subtree->_draw_mask;
+    _trav->traverse(data);
+
+    subtree = _queue->claim_next();
+  }
+
+  _trav->set_cull_handler(NULL);
+  _queue->task_done();
+  return DS_done;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: CullWorkerTask::make_task_manager
+//       Access: Private, Static
+//  Description: Creates the task manager and its worker threads the
+//               first time it is needed.  The lock should be held.
+////////////////////////////////////////////////////////////////////
+void CullWorkerTask::
+make_task_manager() {
+  PT(AsyncTaskManager) task_manager = new AsyncTaskManager("cull");
+  AsyncTaskChain *chain = task_manager->make_task_chain(get_task_chain_name());
+  chain->set_num_threads(cull_num_threads);
+  chain->set_thread_priority(TP_high);
+  _task_manager = task_manager;
+}
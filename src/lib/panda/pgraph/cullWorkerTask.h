@@ -0,0 +1,81 @@
+// Filename: cullWorkerTask.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef CULLWORKERTASK_H
+#define CULLWORKERTASK_H
+
+#include "pandabase.h"
+
+#include "asyncTask.h"
+#include "asyncTaskManager.h"
+#include "cullSubtreeQueue.h"
+#include "cullTraverser.h"
+#include "pStatCollector.h"
+#include "pointerTo.h"
+#include "pmutex.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : CullWorkerTask
+// Description : This task is used internally by the CullTraverser to
+//               implement the parallel cull traversal (see
+//               cull-num-threads).  Each task owns a private copy of
+//               the CullTraverser, and repeatedly pulls the next
+//               unclaimed subtree from a shared CullSubtreeQueue and
+//               culls it into that subtree's own
+//               BufferedCullHandler.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH CullWorkerTask : public AsyncTask {
+public:
+  CullWorkerTask(const CullTraverser *trav, CullSubtreeQueue *queue,
+                 int index);
+  ALLOC_DELETED_CHAIN(CullWorkerTask);
+
+  static bool is_parallel_cull_available();
+  static AsyncTaskManager *get_task_manager();
+  static const string &get_task_chain_name();
+
+protected:
+  virtual DoneStatus do_task();
+
+private:
+  static void make_task_manager();
+
+  PT(CullTraverser) _trav;
+  PT(CullSubtreeQueue) _queue;
+  PStatCollector _pcollector;
+
+  static PT(AsyncTaskManager) _task_manager;
+  static Mutex _task_manager_lock;
+
+  static PStatCollector _workers_pcollector;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AsyncTask::init_type();
+    register_type(_type_handle, "CullWorkerTask",
+                  AsyncTask::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#endif
@@ -208,6 +208,7 @@ CullableObject::
       delete _next;
     }
     set_draw_callback(NULL);
+    delete _instance_transforms;
   }
 }
 
@@ -798,6 +799,10 @@ draw_fancy(GraphicsStateGuardianBase *gsg, bool force,
     // It has decals.
     draw_with_decals(gsg, force, current_thread);
 
+  } else if (_instance_transforms != (InstanceTransforms *)NULL) {
+    // It is to be drawn several times.
+    draw_instances(gsg, force, current_thread);
+
   } else {
     // Huh, nothing fancy after all.  Somehow the _fancy flag got set
     // incorrectly; that's a bug.
@@ -807,6 +812,33 @@ draw_fancy(GraphicsStateGuardianBase *gsg, bool force,
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: CullableObject::draw_instances
+//       Access: Private
+//  Description: Draws the current CullableObject once for each of
+//               its instance transforms.
+//
+//               None of the GSG's can yet draw instances with a
+//               single call, so each instance is issued as a
+//               separate draw call.  This still saves the cull
+//               traversal and the sorting of one CullableObject per
+//               instance, and since the state doesn't change between
+//               instances, the GSG only needs to load a new matrix
+//               each time.
+////////////////////////////////////////////////////////////////////
+void CullableObject::
+draw_instances(GraphicsStateGuardianBase *gsg, bool force, 
+               Thread *current_thread) {
+  nassertv(_fancy && _instance_transforms != (InstanceTransforms *)NULL);
+  InstanceTransforms::const_iterator ti;
+  for (ti = _instance_transforms->begin(); 
+       ti != _instance_transforms->end(); 
+       ++ti) {
+    gsg->set_state_and_transform(_state, (*ti));
+    draw_inline(gsg, force, current_thread);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: CullableObject::draw_with_decals
 //       Access: Private
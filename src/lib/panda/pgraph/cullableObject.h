@@ -31,6 +31,7 @@
 #include "graphicsStateGuardianBase.h"
 #include "lightMutex.h"
 #include "callbackObject.h"
+#include "pvector.h"
 
 class CullTraverser;
 
@@ -69,9 +70,14 @@ public:
   INLINE static void flush_level();
 
   INLINE void set_draw_callback(CallbackObject *draw_callback);
+  INLINE CallbackObject *get_draw_callback() const;
   INLINE void set_next(CullableObject *next);
   INLINE CullableObject *get_next() const;
 
+  typedef pvector< CPT(TransformState) > InstanceTransforms;
+  INLINE void set_instance_transforms(InstanceTransforms *instance_transforms);
+  INLINE const InstanceTransforms *get_instance_transforms() const;
+
 public:
   ~CullableObject();
   ALLOC_DELETED_CHAIN(CullableObject);
@@ -94,6 +100,7 @@ private:
   // _fancy, above, is true.
   CallbackObject *_draw_callback;
   CullableObject *_next;  // for decals
+  InstanceTransforms *_instance_transforms;  // for InstancedNode
 
 private:
   INLINE void make_fancy();
@@ -109,6 +116,8 @@ private:
                   Thread *current_thread);
   void draw_with_decals(GraphicsStateGuardianBase *gsg, bool force, 
                         Thread *current_thread);
+  void draw_instances(GraphicsStateGuardianBase *gsg, bool force, 
+                      Thread *current_thread);
 
 private:
   // This class is used internally by munge_points_to_quads().
@@ -47,7 +47,8 @@ TypeHandle GeomNode::_type_handle;
 ////////////////////////////////////////////////////////////////////
 GeomNode::
 GeomNode(const string &name) :
-  PandaNode(name)
+  PandaNode(name),
+  _collision_accel_lock("GeomNode::_collision_accel_lock")
 {
   _preserved = preserve_geom_nodes;
 
@@ -64,6 +65,7 @@ GeomNode::
 GeomNode(const GeomNode &copy) :
   PandaNode(copy),
   _preserved(copy._preserved),
+  _collision_accel_lock("GeomNode::_collision_accel_lock"),
   _cycler(copy._cycler)
 {
 }
@@ -505,6 +507,11 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
   CPT(TransformState) modelview_transform = data.get_modelview_transform(trav);
   CPT(TransformState) internal_transform = trav->get_gsg()->get_cs_transform()->compose(modelview_transform);
 
+  // The size of this node on screen, for streamed textures; computed
+  // when it is first needed.
+  bool stream_textures = trav->get_stream_textures();
+  int screen_size = -1;
+
   for (int i = 0; i < num_geoms; i++) {
     const Geom *geom = geoms.get_geom(i);
     if (geom->is_empty()) {
@@ -549,6 +556,10 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
       }
     }
     
+    if (stream_textures) {
+      trav->note_stream_textures(state, data, modelview_transform, screen_size);
+    }
+
     CullableObject *object = 
       new CullableObject(geom, state, net_transform, 
                          modelview_transform, internal_transform);
@@ -1028,6 +1039,25 @@ void GeomNode::
 write_datagram(BamWriter *manager, Datagram &dg) {
   PandaNode::write_datagram(manager, dg);
   manager->write_cdata(dg, _cycler);
+  manager->write_pointer(dg, get_collision_accel());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: GeomNode::complete_pointers
+//       Access: Public, Virtual
+//  Description: Receives an array of pointers, one for each time
+//               manager->read_pointer() was called in fillin().
+//               Returns the number of pointers processed.
+////////////////////////////////////////////////////////////////////
+int GeomNode::
+complete_pointers(TypedWritable **p_list, BamReader *manager) {
+  int pi = PandaNode::complete_pointers(p_list, manager);
+
+  if (manager->get_file_minor_ver() >= 20) {
+    _collision_accel = DCAST(TypedWritableReferenceCount, p_list[pi++]);
+  }
+
+  return pi;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -1122,6 +1152,10 @@ void GeomNode::
 fillin(DatagramIterator &scan, BamReader *manager) {
   PandaNode::fillin(scan, manager);
   manager->read_cdata(scan, _cycler);
+
+  if (manager->get_file_minor_ver() >= 20) {
+    manager->read_pointer(scan);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -24,6 +24,9 @@
 #include "cycleData.h"
 #include "pvector.h"
 #include "copyOnWritePointer.h"
+#include "typedWritableReferenceCount.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
 
 class GraphicsStateGuardianBase;
 
@@ -100,6 +103,9 @@ public:
                    const RenderState *node_state,
                    GeomTransformer &transformer);
 
+  INLINE PT(TypedWritableReferenceCount) get_collision_accel() const;
+  INLINE void set_collision_accel(TypedWritableReferenceCount *accel);
+
 protected:
   virtual void r_mark_geom_bounds_stale(Thread *current_thread);
   virtual void compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
@@ -120,6 +126,13 @@ public:
 private:
 
   bool _preserved;
+
+  // A structure to accelerate collision tests against this node's
+  // triangles.  It is created and interpreted by the collide library;
+  // it is not cycled, but it is protected by its own lock, since it
+  // may be created by any of the threads that test the node.
+  PT(TypedWritableReferenceCount) _collision_accel;
+  mutable LightMutex _collision_accel_lock;
   typedef CopyOnWriteObj< pvector<GeomEntry> > GeomList;
   typedef pmap<const InternalName *, int> NameCount;
 
@@ -187,6 +200,7 @@ public:
 public:
   static void register_with_read_factory();
   virtual void write_datagram(BamWriter *manager, Datagram &dg);
+  virtual int complete_pointers(TypedWritable **plist, BamReader *manager);
 
   virtual void finalize(BamReader *manager);
 
@@ -49,7 +49,8 @@ TypeHandle GeomTransformer::NewCollectedData::_type_handle;
 GeomTransformer::
 GeomTransformer() :
   // The default value here comes from the Config file.
-  _max_collect_vertices(max_collect_vertices)
+  _max_collect_vertices(max_collect_vertices),
+  _num_threads(0)
 {
 }
 
@@ -60,7 +61,8 @@ GeomTransformer() :
 ////////////////////////////////////////////////////////////////////
 GeomTransformer::
 GeomTransformer(const GeomTransformer &copy) :
-  _max_collect_vertices(copy._max_collect_vertices)
+  _max_collect_vertices(copy._max_collect_vertices),
+  _num_threads(copy._num_threads)
 {
 }
 
@@ -133,25 +135,7 @@ transform_vertices(Geom *geom, const LMatrix4f &mat) {
   if (new_data._vdata.is_null()) {
     // We have not yet converted these vertices.  Do so now.
     PT(GeomVertexData) new_vdata = new GeomVertexData(*sv._vertex_data);
-    CPT(GeomVertexFormat) format = new_vdata->get_format();
-    
-    int ci;
-    for (ci = 0; ci < format->get_num_points(); ci++) {
-      GeomVertexRewriter data(new_vdata, format->get_point(ci));
-      
-      while (!data.is_at_end()) {
-        const LPoint3f &point = data.get_data3f();
-        data.set_data3f(point * mat);
-      }
-    }
-    for (ci = 0; ci < format->get_num_vectors(); ci++) {
-      GeomVertexRewriter data(new_vdata, format->get_vector(ci));
-      
-      while (!data.is_at_end()) {
-        const LVector3f &vector = data.get_data3f();
-        data.set_data3f(normalize(vector * mat));
-      }
-    }
+    new_vdata->transform_vertices(mat);
     new_data._vdata = new_vdata;
   }
   
@@ -1006,6 +990,22 @@ reverse(GeomNode *node) {
   return (num_geoms != 0);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GeomTransformer::is_apply_empty
+//       Access: Public
+//  Description: Returns true if no apply operations have been
+//               recorded since the last call to finish_apply(): that
+//               is, if there are no converted vertices that a
+//               subsequent operation might share.
+////////////////////////////////////////////////////////////////////
+bool GeomTransformer::
+is_apply_empty() const {
+  return (_vdata_assoc.empty() && _vertices.empty() && 
+          _texcoords.empty() && _fcolors.empty() && _tcolors.empty() &&
+          _tex_colors.empty() && _format.empty() && 
+          _reversed_normals.empty());
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GeomTransformer::finish_apply
 //       Access: Public
@@ -1215,12 +1215,29 @@ int GeomTransformer::
 finish_collect(bool format_only) {
   int num_adjusted = 0;
 
+  int num_collected = (int)_new_collected_list.size();
+  if (_num_threads > 0 && num_collected >= 2) {
+    // Each NewCollectedData has its own source vertices and its own
+    // Geoms, so they can all be built at once.
+    FinishCollect fc;
+    fc._list = &_new_collected_list;
+    fc._format_only = format_only;
+    fc._num_adjusted.insert(fc._num_adjusted.end(), num_collected, 0);
+    SceneGraphReducer::run_parallel(&finish_collect_job, &fc, num_collected,
+                                    _num_threads);
+    for (int i = 0; i < num_collected; ++i) {
+      num_adjusted += fc._num_adjusted[i];
+    }
+  }
+
   NewCollectedList::iterator nci;
   for (nci = _new_collected_list.begin(); 
        nci != _new_collected_list.end();
        ++nci) {
     NewCollectedData *ncd = (*nci);
-    if (format_only) {
+    if (_num_threads > 0 && num_collected >= 2) {
+      // Already applied, above.
+    } else if (format_only) {
       num_adjusted += ncd->apply_format_only_changes();
     } else {
       num_adjusted += ncd->apply_collect_changes();
@@ -1235,6 +1252,23 @@ finish_collect(bool format_only) {
   return num_adjusted;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: GeomTransformer::finish_collect_job
+//       Access: Private, Static
+//  Description: Applies the changes for one NewCollectedData, on
+//               behalf of a parallel finish_collect().
+////////////////////////////////////////////////////////////////////
+void GeomTransformer::
+finish_collect_job(void *data, int index) {
+  FinishCollect *fc = (FinishCollect *)data;
+  NewCollectedData *ncd = (*fc->_list)[index];
+  if (fc->_format_only) {
+    fc->_num_adjusted[index] = ncd->apply_format_only_changes();
+  } else {
+    fc->_num_adjusted[index] = ncd->apply_collect_changes();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: GeomTransformer::premunge_geom
 //       Access: Public
@@ -53,6 +53,9 @@ public:
   INLINE int get_max_collect_vertices() const;
   INLINE void set_max_collect_vertices(int max_collect_vertices);
 
+  INLINE int get_num_threads() const;
+  INLINE void set_num_threads(int num_threads);
+
   void register_vertices(Geom *geom, bool might_have_unused);
   void register_vertices(GeomNode *node, bool might_have_unused);
 
@@ -87,6 +90,7 @@ public:
   bool doubleside(GeomNode *node);
   bool reverse(GeomNode *node);
 
+  bool is_apply_empty() const;
   void finish_apply();
 
   int collect_vertex_data(Geom *geom, int collect_bits, bool format_only);
@@ -101,8 +105,12 @@ private:
                               int x_size, int y_size);
 
 
+private:
+  static void finish_collect_job(void *data, int index);
+
 private:
   int _max_collect_vertices;
+  int _num_threads;
 
   typedef pvector<PT(Geom) > GeomList;
 
@@ -269,6 +277,14 @@ private:
   NewCollectedList _new_collected_list;
   NewCollectedMap _new_collected_map;
 
+  // The work shared by the threads of a parallel finish_collect().
+  class FinishCollect {
+  public:
+    NewCollectedList *_list;
+    bool _format_only;
+    vector_int _num_adjusted;
+  };
+
   class AlreadyCollectedData {
   public:
     NewCollectedData *_ncd;
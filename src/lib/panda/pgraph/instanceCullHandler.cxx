@@ -0,0 +1,194 @@
+// Filename: instanceCullHandler.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "instanceCullHandler.h"
+#include "instanceList.h"
+#include "cullTraverser.h"
+#include "cullableObject.h"
+#include "transparencyAttrib.h"
+#include "geom.h"
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceCullHandler::Constructor
+//       Access: Public
+//  Description: Prepares to pass along objects found below an
+//               InstancedNode, whose net transform is node_transform,
+//               to the indicated CullHandler, once for each of the
+//               indicated instances.
+////////////////////////////////////////////////////////////////////
+InstanceCullHandler::
+InstanceCullHandler(CullHandler *next, const CullTraverser *traverser,
+                    const TransformState *node_transform,
+                    const InstanceList *instances) :
+  _next(next)
+{
+  if (node_transform->is_singular()) {
+    // Everything below the node is scaled to nothing anyway.
+    return;
+  }
+
+  // An object below the node has the net transform node * local; the
+  // same object in instance i has the transform node * inst * local.
+  // Since these are row-vector matrices, that is local * inst * node,
+  // or (local * node) * (node^-1 * inst * node).  The internal
+  // transform has the cs and world transforms composed on the end in
+  // the same way.
+  const TransformState *cs_transform = traverser->get_gsg()->get_cs_transform();
+  CPT(TransformState) view = cs_transform->compose(traverser->get_world_transform());
+
+  const LMatrix4f &node_mat = node_transform->get_mat();
+  LMatrix4f inv_node_mat = invert(node_mat);
+  const LMatrix4f &view_mat = view->get_mat();
+  LMatrix4f inv_view_mat = invert(view_mat);
+
+  const InstanceList::Instances &transforms = instances->get_instance_transforms();
+  _rebases.resize(transforms.size());
+  for (size_t i = 0; i < transforms.size(); ++i) {
+    Rebase &rebase = _rebases[i];
+    rebase._net = inv_node_mat * transforms[i]->get_mat() * node_mat;
+    rebase._internal = inv_view_mat * rebase._net * view_mat;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceCullHandler::Destructor
+//       Access: Public, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+InstanceCullHandler::
+~InstanceCullHandler() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceCullHandler::record_object
+//       Access: Public, Virtual
+//  Description: Passes the object along to the next CullHandler, once
+//               for each instance, either as a single object with
+//               instance transforms attached or as a separate copy of
+//               the object for each instance.
+////////////////////////////////////////////////////////////////////
+void InstanceCullHandler::
+record_object(CullableObject *object, const CullTraverser *traverser) {
+  if (_rebases.empty()) {
+    delete object;
+    return;
+  }
+
+  Rebases::const_iterator ri;
+  const CullableObject::InstanceTransforms *transforms = 
+    object->get_instance_transforms();
+
+  if (transforms != (CullableObject::InstanceTransforms *)NULL &&
+      object->get_draw_callback() == (CallbackObject *)NULL &&
+      !object->has_decals()) {
+    // This object was already batched by a nested InstancedNode.
+    // Each of its instances appears in each of our instances.
+    CullableObject::InstanceTransforms *new_transforms = 
+      new CullableObject::InstanceTransforms;
+    new_transforms->reserve(transforms->size() * _rebases.size());
+    for (ri = _rebases.begin(); ri != _rebases.end(); ++ri) {
+      CullableObject::InstanceTransforms::const_iterator ti;
+      for (ti = transforms->begin(); ti != transforms->end(); ++ti) {
+        new_transforms->push_back
+          (TransformState::make_mat((*ti)->get_mat() * (*ri)._internal));
+      }
+    }
+    object->set_instance_transforms(new_transforms);
+    _next->record_object(object, traverser);
+
+  } else if (!object->is_fancy() && is_batchable(object)) {
+    CullableObject::InstanceTransforms *new_transforms = 
+      new CullableObject::InstanceTransforms;
+    new_transforms->reserve(_rebases.size());
+    const LMatrix4f &internal_mat = object->_internal_transform->get_mat();
+    for (ri = _rebases.begin(); ri != _rebases.end(); ++ri) {
+      new_transforms->push_back
+        (TransformState::make_mat(internal_mat * (*ri)._internal));
+    }
+    object->set_instance_transforms(new_transforms);
+    _next->record_object(object, traverser);
+
+  } else {
+    for (ri = _rebases.begin(); ri != _rebases.end(); ++ri) {
+      _next->record_object(rebase_object(object, (*ri)._net, traverser), 
+                           traverser);
+    }
+    delete object;
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceCullHandler::is_batchable
+//       Access: Private, Static
+//  Description: Returns true if the object may be drawn in all of its
+//               instances by a single CullableObject, or false if
+//               something about it depends on its net transform, so
+//               that each instance must be a separate object.
+////////////////////////////////////////////////////////////////////
+bool InstanceCullHandler::
+is_batchable(const CullableObject *object) {
+  if (object->_geom == (Geom *)NULL) {
+    return false;
+  }
+
+  // Sprites and light vectors are computed on the CPU from the
+  // modelview or net transform at munge time.
+  int geom_rendering = object->_geom->get_geom_rendering();
+  geom_rendering = object->_state->get_geom_rendering(geom_rendering);
+  geom_rendering = object->_modelview_transform->get_geom_rendering(geom_rendering);
+  if ((geom_rendering & (Geom::GR_point_bits | Geom::GR_texcoord_light_vector)) != 0) {
+    return false;
+  }
+
+  // Transparent objects are sorted back-to-front by their transform.
+  const TransparencyAttrib *ta = DCAST(TransparencyAttrib, object->_state->get_attrib(TransparencyAttrib::get_class_slot()));
+  if (ta != (const TransparencyAttrib *)NULL &&
+      (ta->get_mode() == TransparencyAttrib::M_alpha ||
+       ta->get_mode() == TransparencyAttrib::M_dual)) {
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceCullHandler::rebase_object
+//       Access: Private, Static
+//  Description: Returns a newly-allocated copy of the object, and of
+//               the decals chained to it, moved into the frame of one
+//               instance.
+////////////////////////////////////////////////////////////////////
+CullableObject *InstanceCullHandler::
+rebase_object(const CullableObject *object, const LMatrix4f &net_rebase,
+              const CullTraverser *traverser) {
+  CullableObject *result = new CullableObject(*object);
+  if (object->_net_transform != (TransformState *)NULL) {
+    result->_net_transform = 
+      TransformState::make_mat(object->_net_transform->get_mat() * net_rebase);
+    result->_modelview_transform = 
+      traverser->get_world_transform()->compose(result->_net_transform);
+    result->_internal_transform = 
+      traverser->get_gsg()->get_cs_transform()->compose(result->_modelview_transform);
+  }
+
+  if (object->get_draw_callback() != (CallbackObject *)NULL) {
+    result->set_draw_callback(object->get_draw_callback());
+  }
+  const CullableObject *next = object->get_next();
+  if (next != (CullableObject *)NULL) {
+    result->set_next(rebase_object(next, net_rebase, traverser));
+  }
+  return result;
+}
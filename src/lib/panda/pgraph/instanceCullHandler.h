@@ -0,0 +1,76 @@
+// Filename: instanceCullHandler.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef INSTANCECULLHANDLER_H
+#define INSTANCECULLHANDLER_H
+
+#include "pandabase.h"
+#include "cullHandler.h"
+#include "luse.h"
+#include "pvector.h"
+
+class InstanceList;
+
+////////////////////////////////////////////////////////////////////
+//       Class : InstanceCullHandler
+// Description : This CullHandler is used while the CullTraverser
+//               visits the children of an InstancedNode.  The
+//               children are traversed only once, as if there were
+//               only one instance, with the node's own transform;
+//               each CullableObject found is then passed along to the
+//               next CullHandler with one transform for each of the
+//               visible instances.
+//
+//               Where possible, the object is passed along only once,
+//               with a list of instance transforms attached to it;
+//               objects that must be handled individually for each
+//               instance, like decals, sprites and transparent
+//               geometry that must be sorted, are instead copied once
+//               for each instance.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH InstanceCullHandler : public CullHandler {
+public:
+  InstanceCullHandler(CullHandler *next, const CullTraverser *traverser,
+                      const TransformState *node_transform,
+                      const InstanceList *instances);
+  virtual ~InstanceCullHandler();
+
+  virtual void record_object(CullableObject *object, 
+                             const CullTraverser *traverser);
+
+  INLINE int get_num_instances() const;
+
+private:
+  static bool is_batchable(const CullableObject *object);
+  static CullableObject *rebase_object(const CullableObject *object,
+                                       const LMatrix4f &net_rebase,
+                                       const CullTraverser *traverser);
+
+  // This moves a net transform, or an internal transform, from the
+  // InstancedNode's own frame into the frame of one instance.
+  class Rebase {
+  public:
+    LMatrix4f _net;
+    LMatrix4f _internal;
+  };
+  typedef pvector<Rebase> Rebases;
+  Rebases _rebases;
+
+  CullHandler *_next;
+};
+
+#include "instanceCullHandler.I"
+
+#endif
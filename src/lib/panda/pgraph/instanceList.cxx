@@ -0,0 +1,129 @@
+// Filename: instanceList.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "instanceList.h"
+#include "bamReader.h"
+#include "bamWriter.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+
+TypeHandle InstanceList::_type_handle;
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceList::Destructor
+//       Access: Published, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+InstanceList::
+~InstanceList() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceList::output
+//       Access: Published
+//  Description: 
+////////////////////////////////////////////////////////////////////
+void InstanceList::
+output(ostream &out) const {
+  out << _instances.size() << " instances";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceList::register_with_read_factory
+//       Access: Public, Static
+//  Description: Tells the BamReader how to create objects of type
+//               InstanceList.
+////////////////////////////////////////////////////////////////////
+void InstanceList::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceList::write_datagram
+//       Access: Public, Virtual
+//  Description: Writes the contents of this object to the datagram
+//               for shipping out to a Bam file.
+////////////////////////////////////////////////////////////////////
+void InstanceList::
+write_datagram(BamWriter *manager, Datagram &dg) {
+  TypedWritable::write_datagram(manager, dg);
+
+  dg.add_uint32(_instances.size());
+  Instances::const_iterator ii;
+  for (ii = _instances.begin(); ii != _instances.end(); ++ii) {
+    manager->write_pointer(dg, (*ii));
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceList::complete_pointers
+//       Access: Public, Virtual
+//  Description: Receives an array of pointers, one for each time
+//               manager->read_pointer() was called in fillin().
+//               Returns the number of pointers processed.
+////////////////////////////////////////////////////////////////////
+int InstanceList::
+complete_pointers(TypedWritable **p_list, BamReader *manager) {
+  int pi = TypedWritable::complete_pointers(p_list, manager);
+
+  Instances::iterator ii;
+  for (ii = _instances.begin(); ii != _instances.end(); ++ii) {
+    (*ii) = DCAST(TransformState, p_list[pi++]);
+  }
+
+  return pi;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceList::make_from_bam
+//       Access: Protected, Static
+//  Description: This function is called by the BamReader's factory
+//               when a new object of type InstanceList is
+//               encountered in the Bam file.  It should create the
+//               InstanceList and extract its information from the
+//               file.
+////////////////////////////////////////////////////////////////////
+TypedWritable *InstanceList::
+make_from_bam(const FactoryParams &params) {
+  InstanceList *list = new InstanceList;
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  list->fillin(scan, manager);
+
+  return list;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstanceList::fillin
+//       Access: Protected
+//  Description: This internal function is called by make_from_bam to
+//               read in all of the relevant data from the BamFile for
+//               the new InstanceList.
+////////////////////////////////////////////////////////////////////
+void InstanceList::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  TypedWritable::fillin(scan, manager);
+
+  int num_instances = scan.get_uint32();
+  _instances.clear();
+  _instances.reserve(num_instances);
+  for (int i = 0; i < num_instances; ++i) {
+    manager->read_pointer(scan);
+    _instances.push_back(NULL);
+  }
+}
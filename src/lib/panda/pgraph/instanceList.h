@@ -0,0 +1,95 @@
+// Filename: instanceList.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef INSTANCELIST_H
+#define INSTANCELIST_H
+
+#include "pandabase.h"
+#include "typedWritableReferenceCount.h"
+#include "transformState.h"
+#include "pointerTo.h"
+#include "pvector.h"
+
+class FactoryParams;
+
+////////////////////////////////////////////////////////////////////
+//       Class : InstanceList
+// Description : A list of transforms, one for each copy of a subgraph
+//               that is to be rendered by an InstancedNode.  Each
+//               transform is relative to the InstancedNode itself.
+//
+//               An InstanceList may be shared between several
+//               InstancedNodes; use InstancedNode::modify_instances()
+//               to get a copy that may be safely changed.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH InstanceList : public TypedWritableReferenceCount {
+PUBLISHED:
+  INLINE InstanceList();
+  INLINE InstanceList(const InstanceList &copy);
+  virtual ~InstanceList();
+
+  INLINE int get_num_instances() const;
+  INLINE const TransformState *get_instance(int n) const;
+  MAKE_SEQ(get_instances, get_num_instances, get_instance);
+  INLINE void set_instance(int n, const TransformState *transform);
+  INLINE int add_instance(const TransformState *transform);
+  INLINE void remove_instance(int n);
+  INLINE void reserve(int num_instances);
+  INLINE void clear();
+
+  void output(ostream &out) const;
+
+public:
+  typedef pvector< CPT(TransformState) > Instances;
+  INLINE const Instances &get_instance_transforms() const;
+
+private:
+  Instances _instances;
+
+public:
+  static void register_with_read_factory();
+  virtual void write_datagram(BamWriter *manager, Datagram &dg);
+  virtual int complete_pointers(TypedWritable **plist, BamReader *manager);
+
+protected:
+  static TypedWritable *make_from_bam(const FactoryParams &params);
+  void fillin(DatagramIterator &scan, BamReader *manager);
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    TypedWritableReferenceCount::init_type();
+    register_type(_type_handle, "InstanceList",
+                  TypedWritableReferenceCount::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+INLINE ostream &operator << (ostream &out, const InstanceList &instances) {
+  instances.output(out);
+  return out;
+}
+
+#include "instanceList.I"
+
+#endif
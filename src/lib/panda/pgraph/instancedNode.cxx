@@ -0,0 +1,409 @@
+// Filename: instancedNode.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#include "instancedNode.h"
+#include "cullTraverser.h"
+#include "cullTraverserData.h"
+#include "boundingSphere.h"
+#include "boundingBox.h"
+#include "pStatTimer.h"
+#include "bamReader.h"
+#include "bamWriter.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+
+PStatCollector InstancedNode::_cull_instances_pcollector("Cull:Instances");
+
+TypeHandle InstancedNode::_type_handle;
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::CData::make_copy
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+CycleData *InstancedNode::CData::
+make_copy() const {
+  return new CData(*this);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::CData::write_datagram
+//       Access: Public, Virtual
+//  Description: Writes the contents of this object to the datagram
+//               for shipping out to a Bam file.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::CData::
+write_datagram(BamWriter *manager, Datagram &dg) const {
+  manager->write_pointer(dg, _instances);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::CData::complete_pointers
+//       Access: Public, Virtual
+//  Description: Receives an array of pointers, one for each time
+//               manager->read_pointer() was called in fillin().
+//               Returns the number of pointers processed.
+////////////////////////////////////////////////////////////////////
+int InstancedNode::CData::
+complete_pointers(TypedWritable **p_list, BamReader *manager) {
+  int pi = CycleData::complete_pointers(p_list, manager);
+
+  _instances = DCAST(InstanceList, p_list[pi++]);
+  if (_instances == (InstanceList *)NULL) {
+    _instances = new InstanceList;
+  }
+
+  return pi;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::CData::fillin
+//       Access: Public, Virtual
+//  Description: This internal function is called by make_from_bam to
+//               read in all of the relevant data from the BamFile for
+//               the new InstancedNode.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::CData::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  manager->read_pointer(scan);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::Constructor
+//       Access: Published
+//  Description: Creates a new InstancedNode with no instances.  Its
+//               children will not be rendered until at least one
+//               instance has been added.
+////////////////////////////////////////////////////////////////////
+InstancedNode::
+InstancedNode(const string &name) :
+  PandaNode(name)
+{
+  set_cull_callback();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::Copy Constructor
+//       Access: Protected
+//  Description: The new node shares the same InstanceList as the
+//               original, until one of them is modified.
+////////////////////////////////////////////////////////////////////
+InstancedNode::
+InstancedNode(const InstancedNode &copy) :
+  PandaNode(copy),
+  _cycler(copy._cycler)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::Destructor
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+InstancedNode::
+~InstancedNode() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::make_copy
+//       Access: Public, Virtual
+//  Description: Returns a newly-allocated Node that is a shallow copy
+//               of this one.  It will be a different Node pointer,
+//               but its internal data may or may not be shared with
+//               that of the original Node.
+////////////////////////////////////////////////////////////////////
+PandaNode *InstancedNode::
+make_copy() const {
+  return new InstancedNode(*this);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::safe_to_flatten
+//       Access: Public, Virtual
+//  Description: Returns true if it is generally safe to flatten out
+//               this particular kind of PandaNode by duplicating
+//               instances (by calling dupe_for_flatten()), false
+//               otherwise (for instance, a Camera cannot be safely
+//               flattened, because the Camera pointer itself is
+//               meaningful).
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+safe_to_flatten() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::safe_to_transform
+//       Access: Public, Virtual
+//  Description: Returns true if it is generally safe to transform
+//               this particular kind of PandaNode by calling the
+//               xform() method, false otherwise.
+//
+//               A transform above an InstancedNode can't be pushed
+//               down to its children, since it must be applied after
+//               the instance transforms, not before.
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+safe_to_transform() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::safe_to_combine
+//       Access: Public, Virtual
+//  Description: Returns true if it is generally safe to combine this
+//               particular kind of PandaNode with other kinds of
+//               PandaNodes of compatible type, adding children or
+//               whatever.
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+safe_to_combine() const {
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::cull_callback
+//       Access: Public, Virtual
+//  Description: This function will be called during the cull
+//               traversal to perform any additional operations that
+//               should be performed at cull time.
+//
+//               Each instance is tested against the view frustum by
+//               transforming the bounding sphere of the node's
+//               children into the instance's frame, and then the
+//               children are traversed once for all of the instances
+//               that remain.  The return value is always false, since
+//               the traversal of the children has been done here.
+////////////////////////////////////////////////////////////////////
+bool InstancedNode::
+cull_callback(CullTraverser *trav, CullTraverserData &data) {
+  Thread *current_thread = trav->get_current_thread();
+  CPT(InstanceList) instances;
+  {
+    CDReader cdata(_cycler, current_thread);
+    instances = cdata->_instances;
+  }
+  if (instances->get_num_instances() == 0) {
+    return false;
+  }
+
+  if (data._view_frustum != (GeometricBoundingVolume *)NULL) {
+    PStatTimer timer(_cull_instances_pcollector, current_thread);
+
+    // Compute the sphere that encloses the children, in the frame of
+    // a single instance.
+    Children children = get_children(current_thread);
+    int num_children = children.get_num_children();
+    pvector<CPT(BoundingVolume)> child_bounds;
+    pvector<const BoundingVolume *> child_volumes;
+    child_bounds.reserve(num_children);
+    child_volumes.reserve(num_children);
+    for (int i = 0; i < num_children; ++i) {
+      child_bounds.push_back(children.get_child(i)->get_bounds(current_thread));
+      child_volumes.push_back(child_bounds.back());
+    }
+
+    BoundingSphere bounds;
+    if (!child_volumes.empty()) {
+      const BoundingVolume **child_begin = &child_volumes[0];
+      const BoundingVolume **child_end = child_begin + child_volumes.size();
+      ((BoundingVolume &)bounds).around(child_begin, child_end);
+    }
+    if (bounds.is_empty()) {
+      return false;
+    }
+
+    if (!bounds.is_infinite()) {
+      const LPoint3f &center = bounds.get_center();
+      float radius = bounds.get_radius();
+
+      const InstanceList::Instances &transforms = instances->get_instance_transforms();
+      PT(InstanceList) visible = new InstanceList;
+      visible->reserve(transforms.size());
+
+      InstanceList::Instances::const_iterator ti;
+      for (ti = transforms.begin(); ti != transforms.end(); ++ti) {
+        const LMatrix4f &mat = (*ti)->get_mat();
+        float scale = max(mat.get_row3(0).length(), 
+                          max(mat.get_row3(1).length(), 
+                              mat.get_row3(2).length()));
+        BoundingSphere sphere(center * mat, radius * scale);
+        if (data._view_frustum->contains(&sphere) != BoundingVolume::IF_no_intersection) {
+          visible->add_instance(*ti);
+        }
+      }
+      instances = visible;
+    }
+  }
+
+  trav->traverse_instanced(data, instances);
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::output
+//       Access: Public, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+output(ostream &out) const {
+  PandaNode::output(out);
+  out << " (" << get_num_instances() << " instances)";
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::modify_instances
+//       Access: Published
+//  Description: Returns a modifiable pointer to the list of instance
+//               transforms.  If the list is shared with another node,
+//               or is otherwise referenced, a new copy is made first.
+////////////////////////////////////////////////////////////////////
+PT(InstanceList) InstancedNode::
+modify_instances() {
+  Thread *current_thread = Thread::get_current_thread();
+  PT(InstanceList) instances;
+  {
+    CDWriter cdata(_cycler, true, current_thread);
+    if (cdata->_instances->get_ref_count() > 1) {
+      cdata->_instances = new InstanceList(*cdata->_instances);
+    }
+    instances = cdata->_instances;
+  }
+  mark_bounds_stale(current_thread);
+  return instances;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::set_instances
+//       Access: Published
+//  Description: Replaces the list of instance transforms.  The list
+//               is shared, not copied; if it is subsequently
+//               modified, the node's bounding volume must be marked
+//               stale.  Prefer to use modify_instances() to change
+//               the list.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+set_instances(const InstanceList *instances) {
+  nassertv(instances != (const InstanceList *)NULL);
+  Thread *current_thread = Thread::get_current_thread();
+  {
+    CDWriter cdata(_cycler, true, current_thread);
+    cdata->_instances = (InstanceList *)instances;
+  }
+  mark_bounds_stale(current_thread);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::adjust_external_bounds
+//       Access: Protected, Virtual
+//  Description: Replaces the volume around the children with the
+//               union of that volume in each of the instances.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+adjust_external_bounds(PT(GeometricBoundingVolume) &external_bounds,
+                       int pipeline_stage, Thread *current_thread) const {
+  CDStageReader cdata(_cycler, pipeline_stage, current_thread);
+  const InstanceList::Instances &transforms = cdata->_instances->get_instance_transforms();
+
+  if (external_bounds->is_empty() || external_bounds->is_infinite()) {
+    return;
+  }
+
+  PT(GeometricBoundingVolume) result;
+  if (external_bounds->is_of_type(BoundingBox::get_class_type())) {
+    result = new BoundingBox;
+  } else {
+    result = new BoundingSphere;
+  }
+
+  if (!transforms.empty()) {
+    pvector<PT(GeometricBoundingVolume)> instance_bounds;
+    pvector<const BoundingVolume *> instance_volumes;
+    instance_bounds.reserve(transforms.size());
+    instance_volumes.reserve(transforms.size());
+
+    InstanceList::Instances::const_iterator ti;
+    for (ti = transforms.begin(); ti != transforms.end(); ++ti) {
+      PT(GeometricBoundingVolume) volume = 
+        DCAST(GeometricBoundingVolume, external_bounds->make_copy());
+      volume->xform((*ti)->get_mat());
+      instance_bounds.push_back(volume);
+      instance_volumes.push_back(volume);
+    }
+
+    const BoundingVolume **begin = &instance_volumes[0];
+    const BoundingVolume **end = begin + instance_volumes.size();
+    ((BoundingVolume *)result)->around(begin, end);
+  }
+
+  external_bounds = result;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::register_with_read_factory
+//       Access: Public, Static
+//  Description: Tells the BamReader how to create objects of type
+//               InstancedNode.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+register_with_read_factory() {
+  BamReader::get_factory()->register_factory(get_class_type(), make_from_bam);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::write_datagram
+//       Access: Public, Virtual
+//  Description: Writes the contents of this object to the datagram
+//               for shipping out to a Bam file.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+write_datagram(BamWriter *manager, Datagram &dg) {
+  PandaNode::write_datagram(manager, dg);
+  manager->write_cdata(dg, _cycler);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::make_from_bam
+//       Access: Protected, Static
+//  Description: This function is called by the BamReader's factory
+//               when a new object of type InstancedNode is
+//               encountered in the Bam file.  It should create the
+//               InstancedNode and extract its information from the
+//               file.
+////////////////////////////////////////////////////////////////////
+TypedWritable *InstancedNode::
+make_from_bam(const FactoryParams &params) {
+  InstancedNode *node = new InstancedNode("");
+  DatagramIterator scan;
+  BamReader *manager;
+
+  parse_params(params, scan, manager);
+  node->fillin(scan, manager);
+
+  return node;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: InstancedNode::fillin
+//       Access: Protected
+//  Description: This internal function is called by make_from_bam to
+//               read in all of the relevant data from the BamFile for
+//               the new InstancedNode.
+////////////////////////////////////////////////////////////////////
+void InstancedNode::
+fillin(DatagramIterator &scan, BamReader *manager) {
+  PandaNode::fillin(scan, manager);
+  manager->read_cdata(scan, _cycler);
+}
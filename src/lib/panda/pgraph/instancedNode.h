@@ -0,0 +1,135 @@
+// Filename: instancedNode.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+
+#ifndef INSTANCEDNODE_H
+#define INSTANCEDNODE_H
+
+#include "pandabase.h"
+
+#include "pandaNode.h"
+#include "instanceList.h"
+#include "pStatCollector.h"
+#include "cycleData.h"
+#include "cycleDataReader.h"
+#include "cycleDataWriter.h"
+#include "cycleDataStageReader.h"
+#include "pipelineCycler.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : InstancedNode
+// Description : A node that renders its children several times, once
+//               for each of the transforms in an InstanceList.  This
+//               is useful for scattering many copies of the same
+//               model, like trees or rocks, over a scene.
+//
+//               Each instance is culled against the view frustum
+//               individually, by transforming the bounding sphere of
+//               the children into each instance's frame; the children
+//               themselves are traversed only once per frame,
+//               regardless of the number of instances that are
+//               visible, and each Geom below the node is normally
+//               passed to the CullHandler as a single
+//               CullableObject, carrying the transforms of all of the
+//               visible instances.
+//
+//               The instance transforms are relative to the
+//               InstancedNode; the node's own transform is applied
+//               on top of each of them.
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PGRAPH InstancedNode : public PandaNode {
+PUBLISHED:
+  InstancedNode(const string &name);
+
+protected:
+  InstancedNode(const InstancedNode &copy);
+
+public:
+  virtual ~InstancedNode();
+  virtual PandaNode *make_copy() const;
+
+  virtual bool safe_to_flatten() const;
+  virtual bool safe_to_transform() const;
+  virtual bool safe_to_combine() const;
+
+  virtual bool cull_callback(CullTraverser *trav, CullTraverserData &data);
+
+  virtual void output(ostream &out) const;
+
+PUBLISHED:
+  INLINE int get_num_instances() const;
+  INLINE CPT(InstanceList) get_instances() const;
+  PT(InstanceList) modify_instances();
+  void set_instances(const InstanceList *instances);
+  INLINE int add_instance(const TransformState *transform);
+  INLINE void clear_instances();
+
+protected:
+  virtual void adjust_external_bounds(PT(GeometricBoundingVolume) &external_bounds,
+                                      int pipeline_stage,
+                                      Thread *current_thread) const;
+
+private:
+  // This is the data that must be cycled between pipeline stages.
+  class EXPCL_PANDA_PGRAPH CData : public CycleData {
+  public:
+    INLINE CData();
+    INLINE CData(const CData &copy);
+    virtual CycleData *make_copy() const;
+    virtual void write_datagram(BamWriter *manager, Datagram &dg) const;
+    virtual int complete_pointers(TypedWritable **plist, BamReader *manager);
+    virtual void fillin(DatagramIterator &scan, BamReader *manager);
+    virtual TypeHandle get_parent_type() const {
+      return InstancedNode::get_class_type();
+    }
+
+    PT(InstanceList) _instances;
+  };
+
+  PipelineCycler<CData> _cycler;
+  typedef CycleDataReader<CData> CDReader;
+  typedef CycleDataWriter<CData> CDWriter;
+  typedef CycleDataStageReader<CData> CDStageReader;
+
+  static PStatCollector _cull_instances_pcollector;
+
+public:
+  static void register_with_read_factory();
+  virtual void write_datagram(BamWriter *manager, Datagram &dg);
+
+protected:
+  static TypedWritable *make_from_bam(const FactoryParams &params);
+  void fillin(DatagramIterator &scan, BamReader *manager);
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    PandaNode::init_type();
+    register_type(_type_handle, "InstancedNode",
+                  PandaNode::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "instancedNode.I"
+
+#endif
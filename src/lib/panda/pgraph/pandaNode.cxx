@@ -28,6 +28,8 @@
 #include "config_mathutil.h"
 #include "lightReMutexHolder.h"
 #include "graphicsStateGuardianBase.h"
+#include "lightMutexHolder.h"
+#include "pipeline.h"
 
 // This category is just temporary for debugging convenience.
 NotifyCategoryDecl(drawmask, EXPCL_PANDA_PGRAPH, EXPTP_PANDA_PGRAPH);
@@ -40,11 +42,243 @@ DrawMask PandaNode::_overall_bit = DrawMask::bit(31);
 
 PStatCollector PandaNode::_reset_prev_pcollector("App:Collisions:Reset");
 PStatCollector PandaNode::_update_bounds_pcollector("*:Bounds");
+PStatCollector PandaNode::_full_bounds_pcollector("Bounds updates:Full");
+PStatCollector PandaNode::_incremental_bounds_pcollector("Bounds updates:Incremental");
+PStatCollector PandaNode::_bounds_child_reads_pcollector("Bounds updates:Child reads");
+
+AtomicAdjust::Integer PandaNode::_num_full_bounds_updates = 0;
+AtomicAdjust::Integer PandaNode::_num_incremental_bounds_updates = 0;
+AtomicAdjust::Integer PandaNode::_num_bounds_child_reads = 0;
 
 TypeHandle PandaNode::_type_handle;
 TypeHandle PandaNode::CData::_type_handle;
 TypeHandle PandaNodePipelineReader::_type_handle;
 
+////////////////////////////////////////////////////////////////////
+//       Class : PandaNode::ChildBounds
+// Description : The values read from one child of a node by
+//               update_bounds().
+////////////////////////////////////////////////////////////////////
+class PandaNode::ChildBounds {
+public:
+  PandaNode *_child;
+  CollideMask _net_collide_mask;
+  DrawMask _net_draw_control_mask, _net_draw_show_mask;
+  CPT(RenderAttrib) _off_clip_planes;
+  CPT(BoundingVolume) _external_bounds;
+  int _nested_vertices;
+};
+
+////////////////////////////////////////////////////////////////////
+//       Class : PandaNode::BoundsCache
+// Description : This is allocated for each node created while
+//               bounds-incremental is set.  It remembers what
+//               update_bounds() last read from each of the node's
+//               children, and what it accumulated from them, so that
+//               when only a few of the children have changed since
+//               then, only those few need to be read again.
+//
+//               A child that is marked stale adds itself to the
+//               _dirty list of each of its parents.  Any change to
+//               the node itself, or to its list of children,
+//               invalidates the cache entirely.
+//
+//               _num_marked counts the children marked stale, whether
+//               or not the cache is valid at the time.  A child that
+//               is marked while update_bounds() is running finds the
+//               node already stale, so doesn't mark it stale again;
+//               update_bounds() compares _num_marked before and after
+//               reading the children to catch this case.
+//
+//               The accumulated bounding volume is only ever
+//               extended, never shrunk, so the bounds computed
+//               incrementally may be larger than necessary; they are
+//               computed again from scratch every
+//               bounds-incremental-refresh updates.
+////////////////////////////////////////////////////////////////////
+class PandaNode::BoundsCache {
+public:
+  BoundsCache();
+
+  bool start_incremental(const Children &children, pvector<int> &dirty_index,
+                         int &seq);
+  bool apply_incremental(const ChildBoundsList &child_bounds,
+                         const pvector<int> &dirty_index, int seq);
+  void invalidate();
+
+  typedef pmap<PandaNode *, int> Index;
+  typedef pvector<PandaNode *> Dirty;
+
+  LightMutex _lock;
+  bool _valid;
+  int _seq;
+  int _num_incremental;
+  int _num_marked;
+
+  ChildBoundsList _entries;
+  Index _index;
+  Dirty _dirty;
+
+  // These are the values accumulated from the node and all of its
+  // children, before the node's own draw mask, its transform, and
+  // adjust_external_bounds() have been applied.
+  CollideMask _net_collide_mask;
+  DrawMask _net_draw_control_mask, _net_draw_show_mask;
+  bool _renderable;
+  CPT(RenderAttrib) _off_clip_planes;
+  int _nested_vertices;
+  PT(GeometricBoundingVolume) _bounds;
+};
+
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::BoundsCache::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+PandaNode::BoundsCache::
+BoundsCache() :
+  _lock("PandaNode::BoundsCache::_lock"),
+  _valid(false),
+  _seq(0),
+  _num_incremental(0),
+  _num_marked(0),
+  _renderable(false),
+  _nested_vertices(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::BoundsCache::start_incremental
+//       Access: Public
+//  Description: Called by update_bounds(), with the lock held,
+//               before it reads any of the children.  Empties the
+//               _dirty list.  If the cache may be used to compute the
+//               node's bounds incrementally, fills dirty_index with
+//               the index of each child that must be read again, and
+//               returns true; otherwise, returns false, and all of
+//               the children must be read.
+//
+//               seq is filled with the current state of the cache,
+//               to be passed to apply_incremental() later.
+////////////////////////////////////////////////////////////////////
+bool PandaNode::BoundsCache::
+start_incremental(const Children &children, pvector<int> &dirty_index,
+                  int &seq) {
+  seq = _seq;
+  Dirty dirty;
+  dirty.swap(_dirty);
+
+  if (!_valid || _num_incremental >= bounds_incremental_refresh) {
+    return false;
+  }
+
+  int num_children = children.get_num_children();
+  if ((int)_entries.size() != num_children) {
+    return false;
+  }
+  for (int i = 0; i < num_children; ++i) {
+    if (_entries[i]._child != children.get_child(i)) {
+      return false;
+    }
+  }
+
+  // A child that isn't in the index must have been stashed or
+  // removed since it marked itself dirty; we're not interested in it
+  // any more.
+  Dirty::const_iterator di;
+  for (di = dirty.begin(); di != dirty.end(); ++di) {
+    Index::const_iterator ii = _index.find(*di);
+    if (ii != _index.end()) {
+      dirty_index.push_back((*ii).second);
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::BoundsCache::apply_incremental
+//       Access: Public
+//  Description: Called by update_bounds(), with the lock held, after
+//               it has read again each of the children indicated by
+//               start_incremental().  Folds the new values into the
+//               accumulated values, and returns true if successful.
+//
+//               Returns false if the children have changed in some
+//               way that can't be accumulated incrementally, or if
+//               the cache has changed since start_incremental(); in
+//               this case the cache is left invalid, and the bounds
+//               must be computed from scratch.
+////////////////////////////////////////////////////////////////////
+bool PandaNode::BoundsCache::
+apply_incremental(const ChildBoundsList &child_bounds,
+                  const pvector<int> &dirty_index, int seq) {
+  if (!_valid || _seq != seq) {
+    invalidate();
+    return false;
+  }
+
+  nassertr(child_bounds.size() == dirty_index.size(), false);
+  for (size_t i = 0; i < dirty_index.size(); ++i) {
+    ChildBounds &entry = _entries[dirty_index[i]];
+    const ChildBounds &now = child_bounds[i];
+
+    // The masks and clip planes can't be "subtracted" out of the
+    // accumulated values, so if any of them have changed, we have to
+    // start over.  Fortunately, they change much less often than the
+    // bounding volume.
+    if (now._net_collide_mask != entry._net_collide_mask ||
+        now._net_draw_control_mask != entry._net_draw_control_mask ||
+        now._net_draw_show_mask != entry._net_draw_show_mask ||
+        now._off_clip_planes != entry._off_clip_planes) {
+      invalidate();
+      return false;
+    }
+
+    // Nor can we change the type of the accumulated volume, which
+    // depends on whether all of the children's volumes are boxes.
+    bool was_box = (entry._external_bounds->is_empty() ||
+                    entry._external_bounds->as_bounding_box() != NULL);
+    bool is_box = (now._external_bounds->is_empty() ||
+                   now._external_bounds->as_bounding_box() != NULL);
+    if (was_box != is_box) {
+      invalidate();
+      return false;
+    }
+
+    const BoundingVolume *vol = now._external_bounds;
+    if (!vol->is_empty()) {
+      BoundingVolume *bounds = (BoundingVolume *)_bounds;
+      if ((bounds->contains(vol) & BoundingVolume::IF_all) == 0) {
+        if (!bounds->extend_by(vol)) {
+          invalidate();
+          return false;
+        }
+      }
+    }
+
+    _nested_vertices += now._nested_vertices - entry._nested_vertices;
+    entry = now;
+  }
+
+  ++_num_incremental;
+  ++_seq;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::BoundsCache::invalidate
+//       Access: Public
+//  Description: Marks the cache unusable, so that the next call to
+//               update_bounds() will read all of the children.  The
+//               lock should be held.
+////////////////////////////////////////////////////////////////////
+void PandaNode::BoundsCache::
+invalidate() {
+  _valid = false;
+  _dirty.clear();
+  ++_seq;
+}
+
 //
 // There are two different interfaces here for making and breaking
 // parent-child connections: the fundamental PandaNode interface, via
@@ -79,7 +313,8 @@ PandaNode::
 PandaNode(const string &name) :
   Namable(name),
   _paths_lock("PandaNode::_paths_lock"),
-  _dirty_prev_transform(false)
+  _dirty_prev_transform(false),
+  _bounds_cache(NULL)
 {
   if (pgraph_cat.is_debug()) {
     pgraph_cat.debug()
@@ -89,6 +324,10 @@ PandaNode(const string &name) :
   _unexpected_change_flags = 0;
 #endif // !NDEBUG
 
+  if (bounds_incremental) {
+    _bounds_cache = new BoundsCache;
+  }
+
 #ifdef DO_MEMORY_USAGE
   MemoryUsage::update_type(this, this);
 #endif
@@ -117,6 +356,10 @@ PandaNode::
 #endif  // NDEBUG
 
   remove_all_children();
+
+  if (_bounds_cache != (BoundsCache *)NULL) {
+    delete _bounds_cache;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -132,7 +375,8 @@ PandaNode(const PandaNode &copy) :
   TypedWritable(copy),
   Namable(copy),
   _paths_lock("PandaNode::_paths_lock"),
-  _dirty_prev_transform(false)
+  _dirty_prev_transform(false),
+  _bounds_cache(NULL)
 {
   if (pgraph_cat.is_debug()) {
     pgraph_cat.debug()
@@ -146,6 +390,10 @@ PandaNode(const PandaNode &copy) :
   _unexpected_change_flags = 0;
 #endif // !NDEBUG
 
+  if (bounds_incremental) {
+    _bounds_cache = new BoundsCache;
+  }
+
   // Copy the other node's state.
   {
     CDReader copy_cdata(copy._cycler);
@@ -2677,6 +2925,22 @@ force_bounds_stale(Thread *current_thread) {
 ////////////////////////////////////////////////////////////////////
 void PandaNode::
 force_bounds_stale(int pipeline_stage, Thread *current_thread) {
+  if (_bounds_cache != (BoundsCache *)NULL) {
+    invalidate_bounds_cache();
+  }
+  do_force_bounds_stale(pipeline_stage, current_thread);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::do_force_bounds_stale
+//       Access: Private
+//  Description: The implementation of force_bounds_stale(), without
+//               invalidating this node's BoundsCache.  This is also
+//               called when one of the node's children has changed,
+//               which the BoundsCache accounts for already.
+////////////////////////////////////////////////////////////////////
+void PandaNode::
+do_force_bounds_stale(int pipeline_stage, Thread *current_thread) {
   {
     CDStageWriter cdata(_cycler, pipeline_stage, current_thread);
     ++cdata->_next_update;
@@ -2697,10 +2961,62 @@ force_bounds_stale(int pipeline_stage, Thread *current_thread) {
   int num_parents = parents.get_num_parents();
   for (int i = 0; i < num_parents; ++i) {
     PandaNode *parent = parents.get_parent(i);
-    parent->mark_bounds_stale(pipeline_stage, current_thread);
+    parent->mark_child_bounds_stale(this, pipeline_stage, current_thread);
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::mark_child_bounds_stale
+//       Access: Private
+//  Description: Called by a child of this node when its bounding
+//               volume, or anything else stored in its CData that
+//               this node accumulates, may have changed.  This is
+//               like mark_bounds_stale(), except that the node's
+//               BoundsCache, if any, merely notes that the child must
+//               be read again.
+////////////////////////////////////////////////////////////////////
+void PandaNode::
+mark_child_bounds_stale(PandaNode *child, int pipeline_stage,
+                        Thread *current_thread) {
+  if (_bounds_cache != (BoundsCache *)NULL && pipeline_stage == 0) {
+    LightMutexHolder holder(_bounds_cache->_lock);
+    ++_bounds_cache->_num_marked;
+    if (_bounds_cache->_valid) {
+      _bounds_cache->_dirty.push_back(child);
+
+      // If most of the children are dirty anyway (or if the node's
+      // bounds haven't been asked for in a while), there's nothing to
+      // be gained by keeping track of them.
+      if (_bounds_cache->_dirty.size() > _bounds_cache->_entries.size()) {
+        _bounds_cache->invalidate();
+      }
+    }
+  }
+
+  bool is_stale_bounds;
+  {
+    CDStageReader cdata(_cycler, pipeline_stage, current_thread);
+    is_stale_bounds = (cdata->_last_update != cdata->_next_update);
+  }
+  if (!is_stale_bounds) {
+    do_force_bounds_stale(pipeline_stage, current_thread);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::invalidate_bounds_cache
+//       Access: Private
+//  Description: Called when something about the node itself has
+//               changed, to ensure that the next call to
+//               update_bounds() reads all of the children again.
+////////////////////////////////////////////////////////////////////
+void PandaNode::
+invalidate_bounds_cache() const {
+  nassertv(_bounds_cache != (BoundsCache *)NULL);
+  LightMutexHolder holder(_bounds_cache->_lock);
+  _bounds_cache->invalidate();
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PandaNode::r_mark_geom_bounds_stale
 //       Access: Protected, Virtual
@@ -2741,6 +3057,24 @@ compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
   internal_vertices = 0;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::adjust_external_bounds
+//       Access: Protected, Virtual
+//  Description: Called by update_bounds() with the volume that
+//               encloses the node's internal bounds and the bounds of
+//               all of its children, before the node's own transform
+//               has been applied to it.  A derived class may replace
+//               or enlarge the volume; the default implementation
+//               leaves it alone.
+//
+//               This is called while the node's CData is locked for
+//               writing, so it must not attempt to read or modify
+//               the PandaNode's own cycled data.
+////////////////////////////////////////////////////////////////////
+void PandaNode::
+adjust_external_bounds(PT(GeometricBoundingVolume) &, int, Thread *) const {
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PandaNode::parents_changed
 //       Access: Protected, Virtual
@@ -3759,6 +4093,7 @@ update_bounds(int pipeline_stage, PandaNode::CDLockedStageReader &cdata) {
     Children children(cdata);
 
     int num_vertices = cdata->_internal_vertices;
+    BoundingVolume::BoundsType btype = cdata->_bounds_type;
 
     // Now that we've got all the data we need from the node, we can
     // release the lock.
@@ -3766,54 +4101,70 @@ update_bounds(int pipeline_stage, PandaNode::CDLockedStageReader &cdata) {
 
     int num_children = children.get_num_children();
 
-    // We need to keep references to the bounding volumes, since in a
-    // threaded environment the pointers might go away while we're
-    // working (since we're not holding a lock on our set of children
-    // right now).  But we also need the regular pointers, to pass to
-    // BoundingVolume::around().
-#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
-    pvector<CPT(BoundingVolume) > child_volumes_ref;
-    child_volumes_ref.reserve(num_children + 1);
-#endif
-    const BoundingVolume **child_volumes = (const BoundingVolume **)alloca(sizeof(BoundingVolume *) * (num_children + 1));
-    int child_volumes_i = 0;
-  
-    bool all_box = true;
-    CPT(BoundingVolume) internal_bounds = 
-      get_internal_bounds(pipeline_stage, current_thread);
+    // If the node has a BoundsCache, and only some of the children
+    // have changed since the last time, we only need to read those
+    // children again.  This is only attempted with a single-stage
+    // pipeline, since the cache only describes one stage.
+    BoundsCache *cache = NULL;
+    bool incremental = false;
+    int cache_seq = 0;
+    int cache_marked = 0;
+    pvector<int> dirty_index;
+    if (_bounds_cache != (BoundsCache *)NULL && pipeline_stage == 0 &&
+        Pipeline::get_render_pipeline()->get_num_stages() == 1) {
+      cache = _bounds_cache;
+      LightMutexHolder holder(cache->_lock);
+      incremental = cache->start_incremental(children, dirty_index, cache_seq);
+      cache_marked = cache->_num_marked;
+    }
 
-    if (!internal_bounds->is_empty()) {
-#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
-      child_volumes_ref.push_back(internal_bounds);
-#endif
-      nassertr(child_volumes_i < num_children + 1, CDStageWriter(_cycler, pipeline_stage, cdata));
-      child_volumes[child_volumes_i++] = internal_bounds;
-      if (internal_bounds->as_bounding_box() == NULL) {
-        all_box = false;
+    ChildBoundsList child_bounds;
+    PT(GeometricBoundingVolume) gbv;
+
+    if (incremental) {
+      child_bounds.resize(dirty_index.size());
+      for (size_t i = 0; i < dirty_index.size(); ++i) {
+        read_child_bounds(child_bounds[i], children.get_child(dirty_index[i]),
+                          pipeline_stage, current_thread);
       }
-    }
 
-    // Now expand those contents to include all of our children.
+    } else {
+      child_bounds.resize(num_children);
+      for (int i = 0; i < num_children; ++i) {
+        read_child_bounds(child_bounds[i], children.get_child(i),
+                          pipeline_stage, current_thread);
+      }
 
-    for (int i = 0; i < num_children; ++i) {
-      PandaNode *child = children.get_child(i);
+      // The ChildBounds keep references to the bounding volumes, so
+      // they won't go away while we're working, but we also need the
+      // regular pointers, to pass to BoundingVolume::around().
+      const BoundingVolume **child_volumes = (const BoundingVolume **)alloca(sizeof(BoundingVolume *) * (num_children + 1));
+      int child_volumes_i = 0;
 
-      const ClipPlaneAttrib *orig_cp = DCAST(ClipPlaneAttrib, off_clip_planes);
-      
-      CDLockedStageReader child_cdata(child->_cycler, pipeline_stage, current_thread);
-      if (child_cdata->_last_update != child_cdata->_next_update) {
-        // Child needs update.
-        CDStageWriter child_cdataw = child->update_bounds(pipeline_stage, child_cdata);
-      
-        net_collide_mask |= child_cdataw->_net_collide_mask;
+      bool all_box = true;
+      CPT(BoundingVolume) internal_bounds = 
+        get_internal_bounds(pipeline_stage, current_thread);
+
+      if (!internal_bounds->is_empty()) {
+        child_volumes[child_volumes_i++] = internal_bounds;
+        if (internal_bounds->as_bounding_box() == NULL) {
+          all_box = false;
+        }
+      }
+
+      // Now expand those contents to include all of our children.
+
+      for (int i = 0; i < num_children; ++i) {
+        const ChildBounds &child = child_bounds[i];
+        net_collide_mask |= child._net_collide_mask;
 
         if (drawmask_cat.is_debug()) {
           drawmask_cat.debug(false)
-            << "\nchild update " << *child << ":\n";
+            << "\nchild " << *child._child << ":\n";
         }
 
-        DrawMask child_control_mask = child_cdataw->_net_draw_control_mask;
-        DrawMask child_show_mask = child_cdataw->_net_draw_show_mask;
+        DrawMask child_control_mask = child._net_draw_control_mask;
+        DrawMask child_show_mask = child._net_draw_show_mask;
         if (!(child_control_mask | child_show_mask).is_zero()) {
           // This child includes a renderable node or subtree.  Thus,
           // we should propagate its draw masks.
@@ -3875,71 +4226,40 @@ update_bounds(int pipeline_stage, PandaNode::CDLockedStageReader &cdata) {
             << "\nnet_draw_show_mask = " << net_draw_show_mask
             << "\n";
         }
-            
-        off_clip_planes = orig_cp->compose_off(child_cdataw->_off_clip_planes);
-        if (!child_cdataw->_external_bounds->is_empty()) {
-#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
-          child_volumes_ref.push_back(child_cdataw->_external_bounds);
-#endif
+
+        const ClipPlaneAttrib *orig_cp = DCAST(ClipPlaneAttrib, off_clip_planes);
+        off_clip_planes = orig_cp->compose_off(child._off_clip_planes);
+        if (!child._external_bounds->is_empty()) {
           nassertr(child_volumes_i < num_children + 1, CDStageWriter(_cycler, pipeline_stage, cdata));
-          child_volumes[child_volumes_i++] = child_cdataw->_external_bounds;
-          if (child_cdataw->_external_bounds->as_bounding_box() == NULL) {
+          child_volumes[child_volumes_i++] = child._external_bounds;
+          if (child._external_bounds->as_bounding_box() == NULL) {
             all_box = false;
           }
         }
-        num_vertices += child_cdataw->_nested_vertices;
-
-      } else {
-        // Child is good.
-        net_collide_mask |= child_cdata->_net_collide_mask;
-
-        // See comments in similar block above.
-        if (drawmask_cat.is_debug()) {
-          drawmask_cat.debug(false)
-            << "\nchild fresh " << *child << ":\n";
-        }
-        DrawMask child_control_mask = child_cdata->_net_draw_control_mask;
-        DrawMask child_show_mask = child_cdata->_net_draw_show_mask;
-        if (!(child_control_mask | child_show_mask).is_zero()) {
-          renderable = true;
-
-          DrawMask exception_mask = (net_draw_control_mask ^ child_control_mask) & (net_draw_show_mask ^ child_show_mask);
-          exception_mask &= (net_draw_control_mask ^ net_draw_show_mask);
-
-          if (drawmask_cat.is_debug()) {
-            drawmask_cat.debug(false)
-              << "exception_mask = " << exception_mask << "\n";
-          }
-
-          // Now compute the union, applying the above exception.
-          net_draw_control_mask |= child_control_mask;
-          net_draw_show_mask |= child_show_mask;
-          
-          net_draw_control_mask &= ~exception_mask;
-          net_draw_show_mask |= exception_mask;
-        }
+        num_vertices += child._nested_vertices;
+      }
 
-        if (drawmask_cat.is_debug()) {
-          drawmask_cat.debug(false)
-            << "child_control_mask = " << child_control_mask
-            << "\nchild_show_mask = " << child_show_mask
-            << "\nnet_draw_control_mask = " << net_draw_control_mask
-            << "\nnet_draw_show_mask = " << net_draw_show_mask
-            << "\n";
-        }
+      CPT(TransformState) transform = get_transform(current_thread);
+      if (btype == BoundingVolume::BT_default) {
+        btype = bounds_type;
+      }
 
-        off_clip_planes = orig_cp->compose_off(child_cdata->_off_clip_planes);
-        if (!child_cdata->_external_bounds->is_empty()) {
-#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
-          child_volumes_ref.push_back(child_cdata->_external_bounds);
-#endif
-          nassertr(child_volumes_i < num_children + 1, CDStageWriter(_cycler, pipeline_stage, cdata));
-          child_volumes[child_volumes_i++] = child_cdata->_external_bounds;
-          if (child_cdata->_external_bounds->as_bounding_box() == NULL) {
-            all_box = false;
-          }
-        }
-        num_vertices += child_cdata->_nested_vertices;
+      if (btype == BoundingVolume::BT_box ||
+          (btype != BoundingVolume::BT_sphere && all_box && transform->is_identity())) {
+        // If all of the child volumes are a BoundingBox, and we
+        // have no transform, then our volume is also a
+        // BoundingBox.
+        
+        gbv = new BoundingBox;
+      } else {
+        // Otherwise, it's a sphere.
+        gbv = new BoundingSphere;
+      }
+      
+      if (child_volumes_i > 0) {
+        const BoundingVolume **child_begin = &child_volumes[0];
+        const BoundingVolume **child_end = child_begin + child_volumes_i;
+        ((BoundingVolume *)gbv)->around(child_begin, child_end);
       }
     }
 
@@ -3950,87 +4270,135 @@ update_bounds(int pipeline_stage, PandaNode::CDLockedStageReader &cdata) {
           next_update == cdataw->_next_update) {
         // Great, no one has monkeyed with these while we were computing
         // the cache.  Safe to store the computed values and return.
-        cdataw->_net_collide_mask = net_collide_mask;
-
-        if (renderable) {
-          // Any explicit draw control mask on this node trumps anything
-          // inherited from below, except a show-through.
-          DrawMask draw_control_mask = cdataw->_draw_control_mask;
-          DrawMask draw_show_mask = cdataw->_draw_show_mask;
-
-          DrawMask show_through_mask = net_draw_control_mask & net_draw_show_mask;
-          
-          net_draw_control_mask |= draw_control_mask;
-          net_draw_show_mask = (net_draw_show_mask & ~draw_control_mask) | (draw_show_mask & draw_control_mask);
-
-          net_draw_show_mask |= show_through_mask;
-          
-          // There are renderable nodes below, so the implicit draw
-          // bits are all on.
-          cdataw->_net_draw_control_mask = net_draw_control_mask;
-          cdataw->_net_draw_show_mask = net_draw_show_mask | ~net_draw_control_mask;
-          if (drawmask_cat.is_debug()) {
-            drawmask_cat.debug(false)
-              << "renderable, set mask " << cdataw->_net_draw_show_mask << "\n";
+        bool ok = true;
+
+        if (incremental) {
+          // Fold the children we just read into what we accumulated
+          // last time.
+          LightMutexHolder holder(cache->_lock);
+          if (cache->apply_incremental(child_bounds, dirty_index, cache_seq)) {
+            net_collide_mask = cache->_net_collide_mask;
+            net_draw_control_mask = cache->_net_draw_control_mask;
+            net_draw_show_mask = cache->_net_draw_show_mask;
+            renderable = cache->_renderable;
+            off_clip_planes = cache->_off_clip_planes;
+            num_vertices = cache->_nested_vertices;
+            gbv = DCAST(GeometricBoundingVolume, cache->_bounds->make_copy());
+
+            _incremental_bounds_pcollector.add_level(1);
+            AtomicAdjust::inc(_num_incremental_bounds_updates);
+          } else {
+            // Something changed that we can't handle incrementally.
+            // The cache is now invalid, so we'll read all of the
+            // children next time around.
+            ok = false;
           }
+
         } else {
-          // There are no renderable nodes below, so the implicit draw
-          // bits are all off.  Also, we don't care about the draw
-          // mask on this particular node (since nothing below it is
-          // renderable anyway).
-          cdataw->_net_draw_control_mask = net_draw_control_mask;
-          cdataw->_net_draw_show_mask = net_draw_show_mask;
-          if (drawmask_cat.is_debug()) {
-            drawmask_cat.debug(false)
-              << "not renderable, set mask " << cdataw->_net_draw_show_mask << "\n";
+          if (cache != (BoundsCache *)NULL) {
+            // Remember what we read, for next time.
+            LightMutexHolder holder(cache->_lock);
+            cache->_entries.swap(child_bounds);
+            cache->_index.clear();
+            for (int i = 0; i < num_children; ++i) {
+              cache->_index[cache->_entries[i]._child] = i;
+            }
+            cache->_net_collide_mask = net_collide_mask;
+            cache->_net_draw_control_mask = net_draw_control_mask;
+            cache->_net_draw_show_mask = net_draw_show_mask;
+            cache->_renderable = renderable;
+            cache->_off_clip_planes = off_clip_planes;
+            cache->_nested_vertices = num_vertices;
+            cache->_bounds = DCAST(GeometricBoundingVolume, gbv->make_copy());
+            cache->_valid = true;
+            cache->_num_incremental = 0;
+            ++cache->_seq;
           }
+
+          _full_bounds_pcollector.add_level(1);
+          AtomicAdjust::inc(_num_full_bounds_updates);
         }
 
-        cdataw->_off_clip_planes = off_clip_planes;
-        cdataw->_nested_vertices = num_vertices;
+        if (ok) {
+          cdataw->_net_collide_mask = net_collide_mask;
 
-        CPT(TransformState) transform = get_transform(current_thread);
-        PT(GeometricBoundingVolume) gbv;
+          if (renderable) {
+            // Any explicit draw control mask on this node trumps anything
+            // inherited from below, except a show-through.
+            DrawMask draw_control_mask = cdataw->_draw_control_mask;
+            DrawMask draw_show_mask = cdataw->_draw_show_mask;
 
-        BoundingVolume::BoundsType btype = cdataw->_bounds_type;
-        if (btype == BoundingVolume::BT_default) {
-          btype = bounds_type;
-        }
+            DrawMask show_through_mask = net_draw_control_mask & net_draw_show_mask;
+            
+            net_draw_control_mask |= draw_control_mask;
+            net_draw_show_mask = (net_draw_show_mask & ~draw_control_mask) | (draw_show_mask & draw_control_mask);
+
+            net_draw_show_mask |= show_through_mask;
+            
+            // There are renderable nodes below, so the implicit draw
+            // bits are all on.
+            cdataw->_net_draw_control_mask = net_draw_control_mask;
+            cdataw->_net_draw_show_mask = net_draw_show_mask | ~net_draw_control_mask;
+            if (drawmask_cat.is_debug()) {
+              drawmask_cat.debug(false)
+                << "renderable, set mask " << cdataw->_net_draw_show_mask << "\n";
+            }
+          } else {
+            // There are no renderable nodes below, so the implicit draw
+            // bits are all off.  Also, we don't care about the draw
+            // mask on this particular node (since nothing below it is
+            // renderable anyway).
+            cdataw->_net_draw_control_mask = net_draw_control_mask;
+            cdataw->_net_draw_show_mask = net_draw_show_mask;
+            if (drawmask_cat.is_debug()) {
+              drawmask_cat.debug(false)
+                << "not renderable, set mask " << cdataw->_net_draw_show_mask << "\n";
+            }
+          }
+
+          cdataw->_off_clip_planes = off_clip_planes;
+          cdataw->_nested_vertices = num_vertices;
 
-        if (btype == BoundingVolume::BT_box ||
-            (btype != BoundingVolume::BT_sphere && all_box && transform->is_identity())) {
-          // If all of the child volumes are a BoundingBox, and we
-          // have no transform, then our volume is also a
-          // BoundingBox.
+          // Give a derived class the chance to enlarge the volume, for
+          // instance if it renders its children more than once.
+          adjust_external_bounds(gbv, pipeline_stage, current_thread);
           
-          gbv = new BoundingBox;
-        } else {
-          // Otherwise, it's a sphere.
-          gbv = new BoundingSphere;
-        }
-        
-        if (child_volumes_i > 0) {
-          const BoundingVolume **child_begin = &child_volumes[0];
-          const BoundingVolume **child_end = child_begin + child_volumes_i;
-          ((BoundingVolume *)gbv)->around(child_begin, child_end);
-        }
-        
-        // If we have a transform, apply it to the bounding volume we
-        // just computed.
-        if (!transform->is_identity()) {
-          gbv->xform(transform->get_mat());
-        }
+          // If we have a transform, apply it to the bounding volume we
+          // just computed.
+          CPT(TransformState) transform = get_transform(current_thread);
+          if (!transform->is_identity()) {
+            gbv->xform(transform->get_mat());
+          }
 
-        cdataw->_external_bounds = gbv;
-        cdataw->_last_update = next_update;
+          cdataw->_external_bounds = gbv;
+
+          // A child marked stale since we read it found this node
+          // stale already, and so didn't mark it stale again; if we
+          // stored next_update now, the child's change would never be
+          // seen.  Check for this and store next_update together,
+          // under the cache lock, so that any child marked after this
+          // point finds the node fresh, and marks it stale again.
+          bool fresh = true;
+          if (cache != (BoundsCache *)NULL) {
+            LightMutexHolder holder(cache->_lock);
+            fresh = (cache->_num_marked == cache_marked);
+            if (fresh) {
+              cdataw->_last_update = next_update;
+            }
+          } else {
+            cdataw->_last_update = next_update;
+          }
 
-        if (drawmask_cat.is_debug()) {
-          drawmask_cat.debug(false)
-            << "} " << *this << "::update_bounds();\n";
-        }
+          if (fresh) {
+            if (drawmask_cat.is_debug()) {
+              drawmask_cat.debug(false)
+                << "} " << *this << "::update_bounds();\n";
+            }
 
-        nassertr(cdataw->_last_update == cdataw->_next_update, cdataw)
-        return cdataw;
+            nassertr(cdataw->_last_update == cdataw->_next_update, cdataw)
+            return cdataw;
+          }
+        }
       }
       
       if (cdataw->_last_update == cdataw->_next_update) {
@@ -4041,6 +4409,11 @@ update_bounds(int pipeline_stage, PandaNode::CDLockedStageReader &cdata) {
 
     // We need to go around again.  Release the write lock, and grab
     // the read lock back.
+    if (cache != (BoundsCache *)NULL) {
+      // Anything we took from the dirty list is forgotten now.
+      LightMutexHolder holder(cache->_lock);
+      cache->invalidate();
+    }
     cdata = CDLockedStageReader(_cycler, pipeline_stage, current_thread);
 
     if (cdata->_last_update == cdata->_next_update) {
@@ -4052,6 +4425,44 @@ update_bounds(int pipeline_stage, PandaNode::CDLockedStageReader &cdata) {
   } while (true);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PandaNode::read_child_bounds
+//       Access: Private
+//  Description: Called by update_bounds() to fill child_bounds with
+//               the values it needs from the indicated child,
+//               updating the child's own bounds first if they are
+//               stale.
+////////////////////////////////////////////////////////////////////
+void PandaNode::
+read_child_bounds(ChildBounds &child_bounds, PandaNode *child,
+                  int pipeline_stage, Thread *current_thread) {
+  child_bounds._child = child;
+
+  CDLockedStageReader child_cdata(child->_cycler, pipeline_stage, current_thread);
+  if (child_cdata->_last_update != child_cdata->_next_update) {
+    // Child needs update.
+    CDStageWriter child_cdataw = child->update_bounds(pipeline_stage, child_cdata);
+    child_bounds._net_collide_mask = child_cdataw->_net_collide_mask;
+    child_bounds._net_draw_control_mask = child_cdataw->_net_draw_control_mask;
+    child_bounds._net_draw_show_mask = child_cdataw->_net_draw_show_mask;
+    child_bounds._off_clip_planes = child_cdataw->_off_clip_planes;
+    child_bounds._external_bounds = child_cdataw->_external_bounds;
+    child_bounds._nested_vertices = child_cdataw->_nested_vertices;
+
+  } else {
+    // Child is good.
+    child_bounds._net_collide_mask = child_cdata->_net_collide_mask;
+    child_bounds._net_draw_control_mask = child_cdata->_net_draw_control_mask;
+    child_bounds._net_draw_show_mask = child_cdata->_net_draw_show_mask;
+    child_bounds._off_clip_planes = child_cdata->_off_clip_planes;
+    child_bounds._external_bounds = child_cdata->_external_bounds;
+    child_bounds._nested_vertices = child_cdata->_nested_vertices;
+  }
+
+  _bounds_child_reads_pcollector.add_level(1);
+  AtomicAdjust::inc(_num_bounds_child_reads);
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PandaNode::set_scene_root_func
 //       Access: Public, Static
@@ -45,6 +45,7 @@
 #include "copyOnWriteObject.h"
 #include "copyOnWritePointer.h"
 #include "lightReMutex.h"
+#include "atomicAdjust.h"
 
 #ifdef HAVE_PYTHON
 
@@ -61,6 +62,7 @@ class FactoryParams;
 class AccumulatedAttribs;
 class GeomTransformer;
 class GraphicsStateGuardianBase;
+class GeometricBoundingVolume;
 
 ////////////////////////////////////////////////////////////////////
 //       Class : PandaNode
@@ -281,6 +283,10 @@ PUBLISHED:
   void mark_internal_bounds_stale(Thread *current_thread = Thread::get_current_thread());
   INLINE bool is_bounds_stale() const;
 
+  INLINE static int get_num_full_bounds_updates();
+  INLINE static int get_num_incremental_bounds_updates();
+  INLINE static int get_num_bounds_child_reads();
+
   INLINE void set_final(bool flag);
   INLINE bool is_final(Thread *current_thread = Thread::get_current_thread()) const;
 
@@ -318,6 +324,9 @@ protected:
                                        int &internal_vertices,
                                        int pipeline_stage,
                                        Thread *current_thread) const;
+  virtual void adjust_external_bounds(PT(GeometricBoundingVolume) &external_bounds,
+                                      int pipeline_stage,
+                                      Thread *current_thread) const;
   virtual void parents_changed();
   virtual void children_changed();
   virtual void transform_changed();
@@ -624,10 +633,32 @@ private:
   int do_find_child(PandaNode *node, const Down *down) const;
   CDStageWriter update_bounds(int pipeline_stage, CDLockedStageReader &cdata);
 
+  // These are used to recompute the bounds incrementally, when only
+  // some of the children have changed.  See bounds-incremental.
+  class ChildBounds;
+  class BoundsCache;
+  typedef pvector<ChildBounds> ChildBoundsList;
+
+  void read_child_bounds(ChildBounds &child_bounds, PandaNode *child,
+                         int pipeline_stage, Thread *current_thread);
+  void mark_child_bounds_stale(PandaNode *child, int pipeline_stage,
+                               Thread *current_thread);
+  void do_force_bounds_stale(int pipeline_stage, Thread *current_thread);
+  void invalidate_bounds_cache() const;
+
+  BoundsCache *_bounds_cache;
+
   static DrawMask _overall_bit;
 
   static PStatCollector _reset_prev_pcollector;
   static PStatCollector _update_bounds_pcollector;
+  static PStatCollector _full_bounds_pcollector;
+  static PStatCollector _incremental_bounds_pcollector;
+  static PStatCollector _bounds_child_reads_pcollector;
+
+  static AtomicAdjust::Integer _num_full_bounds_updates;
+  static AtomicAdjust::Integer _num_incremental_bounds_updates;
+  static AtomicAdjust::Integer _num_bounds_child_reads;
 
 public:
   // This class is returned from get_children().  Use it to walk
@@ -690,6 +721,9 @@ public:
   typedef bool SceneRootFunc(const PandaNode *);
   static void set_scene_root_func(SceneRootFunc *func);
 
+  INLINE static void flush_level();
+  INLINE static void clear_level();
+
 private:
   static SceneRootFunc *_scene_root_func;
 
@@ -39,6 +39,9 @@
 #include "py_panda.h"
   
 LightReMutex *RenderState::_states_lock = NULL;
+int RenderState::_thread_cache_slot = -1;
+ThreadCompositionCache<RenderState>::Registry *RenderState::_thread_caches =
+  NULL;
 RenderState::States *RenderState::_states = NULL;
 CPT(RenderState) RenderState::_empty_state;
 CPT(RenderState) RenderState::_full_default_state;
@@ -425,6 +428,34 @@ compose(const RenderState *other) const {
   }
 #endif  // NDEBUG
 
+  ThreadCompositionCache<RenderState> *thread_cache = 
+    ThreadCompositionCache<RenderState>::get_cache
+    (_thread_cache_slot, thread_composition_cache_size, _thread_caches);
+  if (thread_cache != (ThreadCompositionCache<RenderState> *)NULL) {
+    CPT(RenderState) result = thread_cache->find_compose(this, other);
+    if (result != (const RenderState *)NULL) {
+      return result;
+    }
+  }
+
+  CPT(RenderState) result = do_shared_compose(other);
+
+  if (thread_cache != (ThreadCompositionCache<RenderState> *)NULL) {
+    thread_cache->store_compose(this, other, result);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: RenderState::do_shared_compose
+//       Access: Private
+//  Description: The part of compose() that consults and updates
+//               the shared composition cache, under _states_lock.
+//               This is called only when the result is not found in
+//               the current thread's private cache.
+////////////////////////////////////////////////////////////////////
+CPT(RenderState) RenderState::
+do_shared_compose(const RenderState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   // Is this composition already cached?
@@ -522,6 +553,35 @@ invert_compose(const RenderState *other) const {
   }
 #endif  // NDEBUG
 
+  ThreadCompositionCache<RenderState> *thread_cache = 
+    ThreadCompositionCache<RenderState>::get_cache
+    (_thread_cache_slot, thread_composition_cache_size, _thread_caches);
+  if (thread_cache != (ThreadCompositionCache<RenderState> *)NULL) {
+    CPT(RenderState) result = 
+      thread_cache->find_invert_compose(this, other);
+    if (result != (const RenderState *)NULL) {
+      return result;
+    }
+  }
+
+  CPT(RenderState) result = do_shared_invert_compose(other);
+
+  if (thread_cache != (ThreadCompositionCache<RenderState> *)NULL) {
+    thread_cache->store_invert_compose(this, other, result);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: RenderState::do_shared_invert_compose
+//       Access: Private
+//  Description: The part of invert_compose() that consults and updates
+//               the shared composition cache, under _states_lock.
+//               This is called only when the result is not found in
+//               the current thread's private cache.
+////////////////////////////////////////////////////////////////////
+CPT(RenderState) RenderState::
+do_shared_invert_compose(const RenderState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   // Is this composition already cached?
@@ -706,8 +766,20 @@ adjust_all_priorities(int adjustment) const {
 ////////////////////////////////////////////////////////////////////
 bool RenderState::
 unref() const {
-  // We always have to grab the lock, since we will definitely need to
-  // be holding it if we happen to drop the reference count to 0.
+  // We only need to grab the lock if we might be about to drop the
+  // reference count to 0, or to the point where only the cache holds
+  // references (see below).  The cache's share of the count may
+  // change under us while we don't hold the lock, so we can't safely
+  // compare against it here; when cycles are not being broken, though,
+  // only the drop to 0 matters, and any higher count may be
+  // decremented without the lock.
+  if (!(auto_break_cycles && uniquify_states) && unref_if_above(1)) {
+    return true;
+  }
+
+  // Otherwise, we have to grab the lock, since we will definitely
+  // need to be holding it if we happen to drop the reference count
+  // to 0.
   LightReMutexHolder holder(*_states_lock);
 
   if (auto_break_cycles && uniquify_states) {
@@ -1087,6 +1159,13 @@ clear_cache() {
   if (_states == (States *)NULL) {
     return 0;
   }
+
+  // Empty the per-thread caches of all threads first, so that any
+  // states held only by them can be freed below.  This must be done
+  // before we take _states_lock, since the caches release their
+  // states only after dropping their own locks.
+  _thread_caches->clear_all();
+
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_cache_update_pcollector);
@@ -2111,6 +2190,8 @@ init_states() {
   // one thread in the world.
   _states_lock = new LightReMutex("RenderState::_states_lock");
   _cache_stats.init();
+  _thread_cache_slot = Thread::allocate_cache_slot();
+  _thread_caches = new ThreadCompositionCache<RenderState>::Registry;
   nassertv(Thread::get_current_thread() == Thread::get_main_thread());
 }
 
@@ -33,6 +33,7 @@
 #include "simpleHashMap.h"
 #include "cacheStats.h"
 #include "renderAttribRegistry.h"
+#include "threadCompositionCache.h"
 
 class GraphicsStateGuardianBase;
 class FactoryParams;
@@ -180,6 +181,8 @@ private:
   static CPT(RenderState) return_unique(RenderState *state);
   CPT(RenderState) do_compose(const RenderState *other) const;
   CPT(RenderState) do_invert_compose(const RenderState *other) const;
+  CPT(RenderState) do_shared_compose(const RenderState *other) const;
+  CPT(RenderState) do_shared_invert_compose(const RenderState *other) const;
   static bool r_detect_cycles(const RenderState *start_state,
                               const RenderState *current_state,
                               int length, UpdateSeq this_seq,
@@ -259,6 +262,13 @@ private:
   Mungers _mungers;
   Mungers::const_iterator _last_mi;
 
+  // Each thread also keeps a small private cache of its recent
+  // compositions, so that a hit need not take _states_lock at all.
+  // See ThreadCompositionCache.  All of these caches are listed in
+  // _thread_caches, so that clear_cache() can empty them.
+  static int _thread_cache_slot;
+  static ThreadCompositionCache<RenderState>::Registry *_thread_caches;
+
   // This is used to mark nodes as we visit them to detect cycles.
   UpdateSeq _cycle_detect;
   static UpdateSeq _last_cycle_detect;
@@ -23,6 +23,7 @@
 #include "geomNode.h"
 #include "config_gobj.h"
 #include "thread.h"
+#include "mutexHolder.h"
 
 PStatCollector SceneGraphReducer::_flatten_collector("*:Flatten:flatten");
 PStatCollector SceneGraphReducer::_apply_collector("*:Flatten:apply");
@@ -34,6 +35,36 @@ PStatCollector SceneGraphReducer::_unify_collector("*:Flatten:unify");
 PStatCollector SceneGraphReducer::_remove_unused_collector("*:Flatten:remove unused vertices");
 PStatCollector SceneGraphReducer::_premunge_collector("*:Premunge");
 
+// The work shared by the threads of a parallel apply_attribs(),
+// flatten() or unify().  Each job processes one element of _groups,
+// or one element of _nodes.
+class ApplyAttribsJob {
+public:
+  SceneGraphReducer *_reducer;
+  PandaNode *_node;
+  const AccumulatedAttribs *_attribs;
+  int _attrib_types;
+  pvector<vector_int> _groups;
+};
+
+class FlattenJob {
+public:
+  SceneGraphReducer *_reducer;
+  PandaNode *_parent_node;
+  const PandaNode::Children *_children;
+  int _combine_siblings_bits;
+  pvector<vector_int> _groups;
+  vector_int _num_nodes;
+};
+
+class UnifyJob {
+public:
+  int _max_indices;
+  bool _preserve_order;
+  pvector<GeomNode *> _nodes;
+  pmap<GeomNode *, int> _counts;
+};
+
 ////////////////////////////////////////////////////////////////////
 //     Function: SceneGraphReducer::set_gsg
 //       Access: Published
@@ -104,18 +135,7 @@ flatten(PandaNode *root, int combine_siblings_bits) {
   int num_pass_nodes;
 
   do {
-    num_pass_nodes = 0;
-
-    // Get a copy of the children list, so we don't have to worry
-    // about self-modifications.
-    PandaNode::Children cr = root->get_children();
-
-    // Now visit each of the children in turn.
-    int num_children = cr.get_num_children();
-    for (int i = 0; i < num_children; i++) {
-      PT(PandaNode) child_node = cr.get_child(i);
-      num_pass_nodes += r_flatten(root, child_node, combine_siblings_bits);
-    }
+    num_pass_nodes = flatten_children(root, combine_siblings_bits);
 
     if (combine_siblings_bits != 0 && 
         root->get_num_children() >= 2 && 
@@ -212,6 +232,33 @@ unify(PandaNode *root, bool preserve_order) {
   if (_gsg != (GraphicsStateGuardianBase *)NULL) {
     max_indices = min(max_indices, _gsg->get_max_vertices_per_primitive());
   }
+
+  int num_threads = get_num_parallel_threads();
+  if (num_threads > 0) {
+    // Each GeomNode is unified independently of the others, so they
+    // may all be unified at once.  A GeomNode that appears more than
+    // once in the graph is unified once for each appearance, as
+    // r_unify() would do, but always on the same thread.
+    UnifyJob job;
+    job._max_indices = max_indices;
+    job._preserve_order = preserve_order;
+    r_find_geom_nodes(root, job._nodes, job._counts);
+
+    // Unifying a GeomNode marks its parents' bounds stale, and a
+    // parent may be shared by GeomNodes on different threads.  Mark
+    // them stale first, so that the threads need only read them.
+    pvector<GeomNode *>::const_iterator ni;
+    for (ni = job._nodes.begin(); ni != job._nodes.end(); ++ni) {
+      PandaNode::Parents parents = (*ni)->get_parents();
+      int num_parents = parents.get_num_parents();
+      for (int i = 0; i < num_parents; ++i) {
+        parents.get_parent(i)->mark_bounds_stale();
+      }
+    }
+    run_parallel(&unify_job, &job, (int)job._nodes.size(), num_threads);
+    return;
+  }
+
   r_unify(root, max_indices, preserve_order);
 }
 
@@ -398,6 +445,18 @@ r_apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
 
   // Now it's safe to traverse through all of our children.
   nassertv(num_children == node->get_num_children());
+  if (_fan_out_pending && num_children >= 2) {
+    // This is the first node we have encountered with more than one
+    // child, so nothing else remains to be done after its children
+    // have been traversed.  If the transformer hasn't recorded
+    // anything yet, the children can be divided among threads.
+    _fan_out_pending = false;
+    if (&transformer == &_transformer && transformer.is_apply_empty() &&
+        apply_children_parallel(node, next_attribs, attrib_types)) {
+      return;
+    }
+  }
+
   for (i = 0; i < num_children; i++) {
     PandaNode *child_node = node->get_child(i);
     r_apply_attribs(child_node, next_attribs, attrib_types, transformer);
@@ -454,14 +513,7 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
     }
 
     // First, recurse on each of the children.
-    {
-      PandaNode::Children cr = parent_node->get_children();
-      int num_children = cr.get_num_children();
-      for (int i = 0; i < num_children; i++) {
-        PT(PandaNode) child_node = cr.get_child(i);
-        num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
-      }
-    }
+    num_nodes += flatten_children(parent_node, combine_siblings_bits);
     
     // Now that the above loop has removed some children, the child
     // list saved above is no longer accurate, so hereafter we must
@@ -523,6 +575,63 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
   return num_nodes;
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::flatten_children
+//       Access: Protected
+//  Description: Calls r_flatten() on each of the children of the
+//               indicated node, dividing them among threads if
+//               possible.  Returns the number of nodes removed.
+////////////////////////////////////////////////////////////////////
+int SceneGraphReducer::
+flatten_children(PandaNode *parent_node, int combine_siblings_bits) {
+  int num_nodes = 0;
+
+  // Get a copy of the children list, so we don't have to worry
+  // about self-modifications.
+  PandaNode::Children cr = parent_node->get_children();
+  int num_children = cr.get_num_children();
+
+  int num_threads = get_num_parallel_threads();
+  if (num_threads > 0 && num_children >= 2 && _fan_out_node == NULL) {
+    FlattenJob job;
+    job._reducer = this;
+    job._parent_node = parent_node;
+    job._children = &cr;
+    job._combine_siblings_bits = combine_siblings_bits;
+    find_groups(cr, false, job._groups);
+
+    int num_groups = (int)job._groups.size();
+    if (num_groups >= 2) {
+      // Only the children's own subtrees are modified, apart from
+      // parent_node's child list, which do_flatten_child() protects.
+      // Flattening is not divided further below this point.
+      job._num_nodes.insert(job._num_nodes.end(), num_groups, 0);
+
+      // Each change to a child marks parent_node's bounds stale.
+      // Without a threaded pipeline, the CData isn't locked for
+      // writing, so mark it stale here first; then the threads will
+      // find it stale already, and need only read it.
+      parent_node->mark_bounds_stale();
+      _fan_out_node = parent_node;
+      run_parallel(&flatten_job, &job, num_groups, num_threads);
+      _fan_out_node = NULL;
+
+      for (int gi = 0; gi < num_groups; ++gi) {
+        num_nodes += job._num_nodes[gi];
+      }
+      return num_nodes;
+    }
+  }
+
+  // Now visit each of the children in turn.
+  for (int i = 0; i < num_children; i++) {
+    PT(PandaNode) child_node = cr.get_child(i);
+    num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
+  }
+
+  return num_nodes;
+}
+
 class SortByState {
 public:
   INLINE bool
@@ -715,8 +824,16 @@ do_flatten_child(PandaNode *grandparent_node, PandaNode *parent_node,
 
   choose_name(new_parent, parent_node, child_node);
 
-  new_parent->replace_node(child_node);
-  new_parent->replace_node(parent_node);
+  if (grandparent_node == _fan_out_node) {
+    // Other threads may be replacing other children of the
+    // grandparent at the same time.
+    MutexHolder holder(_fan_out_lock);
+    new_parent->replace_node(child_node);
+    new_parent->replace_node(parent_node);
+  } else {
+    new_parent->replace_node(child_node);
+    new_parent->replace_node(parent_node);
+  }
 
   return true;
 }
@@ -1048,3 +1165,320 @@ r_premunge(PandaNode *node, const RenderState *state) {
     r_premunge(stashed.get_stashed(i), next_state);
   }
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::run_parallel
+//       Access: Public, Static
+//  Description: Calls func(data, i) for each i from 0 to count - 1,
+//               using up to num_threads additional threads as well as
+//               the calling thread.  The jobs are handed out in
+//               order, to whichever thread is free next, so each
+//               call must be independent of the others.  Returns
+//               when all of the jobs have finished.
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+run_parallel(ParallelFunction *func, void *data, int count, int num_threads) {
+  Mutex lock("SceneGraphReducer::run_parallel");
+  int next_index = 0;
+
+  typedef pvector< PT(ParallelThread) > Threads;
+  Threads threads;
+  int num_started = min(num_threads, count - 1);
+  for (int i = 0; i < num_started; ++i) {
+    PT(ParallelThread) thread = 
+      new ParallelThread(func, data, count, &next_index, &lock);
+    if (thread->start(TP_normal, true)) {
+      threads.push_back(thread);
+    }
+  }
+
+  // The calling thread does its share too, and any work left over if
+  // a thread couldn't be started.
+  run_jobs(func, data, count, &next_index, &lock);
+
+  Threads::iterator ti;
+  for (ti = threads.begin(); ti != threads.end(); ++ti) {
+    (*ti)->join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::run_jobs
+//       Access: Private, Static
+//  Description: Runs jobs from the list shared by run_parallel()
+//               until there are none left.
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+run_jobs(ParallelFunction *func, void *data, int count,
+         int *next_index, Mutex *lock) {
+  while (true) {
+    int index;
+    {
+      MutexHolder holder(*lock);
+      index = (*next_index);
+      if (index >= count) {
+        return;
+      }
+      ++(*next_index);
+    }
+    (*func)(data, index);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::find_groups
+//       Access: Protected
+//  Description: Divides the indicated children into groups whose
+//               subtrees may be processed independently of each
+//               other.  Two children fall into the same group if
+//               their subtrees share a node, or, if share_vertices is
+//               true, a GeomVertexData.  Each group lists its
+//               children in increasing order, and the groups are
+//               sorted by their first child.
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+find_groups(const PandaNode::Children &cr, bool share_vertices,
+            Groups &groups) {
+  int num_children = cr.get_num_children();
+
+  // leaders is a union-find forest over the children; each group is
+  // led by its lowest-numbered child.
+  vector_int leaders;
+  leaders.reserve(num_children);
+  int i;
+  for (i = 0; i < num_children; ++i) {
+    leaders.push_back(i);
+  }
+
+  SharedOwners owners;
+  for (i = 0; i < num_children; ++i) {
+    r_find_shared(cr.get_child(i), i, share_vertices, owners, leaders);
+  }
+
+  vector_int group_index(num_children, -1);
+  for (i = 0; i < num_children; ++i) {
+    int leader = find_group(leaders, i);
+    if (group_index[leader] < 0) {
+      group_index[leader] = (int)groups.size();
+      groups.push_back(vector_int());
+    }
+    groups[group_index[leader]].push_back(i);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::find_group
+//       Access: Private, Static
+//  Description: Returns the leader of the group that the indicated
+//               child belongs to.  See find_groups().
+////////////////////////////////////////////////////////////////////
+int SceneGraphReducer::
+find_group(vector_int &leaders, int index) {
+  while (leaders[index] != index) {
+    leaders[index] = leaders[leaders[index]];
+    index = leaders[index];
+  }
+  return index;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::note_shared
+//       Access: Private, Static
+//  Description: Records that the indicated child's subtree uses the
+//               indicated node or vertex data, joining its group with
+//               that of any child that used it first.
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+note_shared(const void *key, int index, SharedOwners &owners,
+            vector_int &leaders) {
+  pair<SharedOwners::iterator, bool> result = 
+    owners.insert(SharedOwners::value_type(key, index));
+  if (!result.second) {
+    int a = find_group(leaders, (*result.first).second);
+    int b = find_group(leaders, index);
+    if (a < b) {
+      leaders[b] = a;
+    } else if (b < a) {
+      leaders[a] = b;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::r_find_shared
+//       Access: Private
+//  Description: The recursive implementation of find_groups().
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+r_find_shared(PandaNode *node, int index, bool share_vertices,
+              SharedOwners &owners, vector_int &leaders) {
+  if (node->get_num_parents() > 1) {
+    if (owners.find(node) != owners.end()) {
+      // We have already been here, so everything below has already
+      // been recorded.
+      note_shared(node, index, owners, leaders);
+      return;
+    }
+    note_shared(node, index, owners, leaders);
+  }
+
+  if (share_vertices && node->is_geom_node()) {
+    GeomNode *geom_node = DCAST(GeomNode, node);
+    int num_geoms = geom_node->get_num_geoms();
+    for (int gi = 0; gi < num_geoms; ++gi) {
+      CPT(GeomVertexData) vdata = geom_node->get_geom(gi)->get_vertex_data();
+      note_shared(vdata, index, owners, leaders);
+    }
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_find_shared(children.get_child(i), index, share_vertices, 
+                  owners, leaders);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::apply_children_parallel
+//       Access: Private
+//  Description: Applies the indicated attribs to the children of the
+//               indicated node, dividing them among threads.  Each
+//               thread has its own GeomTransformer; since the groups
+//               share no vertex data, the transformers would not have
+//               shared any results anyway.  Returns true if this was
+//               done, or false if the children cannot be divided and
+//               the caller should traverse them itself.
+////////////////////////////////////////////////////////////////////
+bool SceneGraphReducer::
+apply_children_parallel(PandaNode *node, const AccumulatedAttribs &attribs,
+                        int attrib_types) {
+  ApplyAttribsJob job;
+  job._reducer = this;
+  job._node = node;
+  job._attribs = &attribs;
+  job._attrib_types = attrib_types;
+  find_groups(node->get_children(), true, job._groups);
+
+  int num_groups = (int)job._groups.size();
+  if (num_groups < 2) {
+    return false;
+  }
+
+  // As in flatten_children(), the threads must find the node's
+  // bounds stale already, so that none of them writes to its CData.
+  node->mark_bounds_stale();
+  run_parallel(&apply_attribs_job, &job, num_groups, 
+               get_num_parallel_threads());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::apply_attribs_job
+//       Access: Private, Static
+//  Description: Applies attribs to one group of children, on behalf
+//               of apply_children_parallel().
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+apply_attribs_job(void *data, int index) {
+  ApplyAttribsJob *job = (ApplyAttribsJob *)data;
+  GeomTransformer transformer(job->_reducer->_transformer);
+
+  const vector_int &group = job->_groups[index];
+  vector_int::const_iterator ci;
+  for (ci = group.begin(); ci != group.end(); ++ci) {
+    PandaNode *child_node = job->_node->get_child(*ci);
+    job->_reducer->r_apply_attribs(child_node, *job->_attribs,
+                                   job->_attrib_types, transformer);
+  }
+  transformer.finish_apply();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::flatten_job
+//       Access: Private, Static
+//  Description: Flattens one group of children, on behalf of
+//               flatten_children().
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+flatten_job(void *data, int index) {
+  FlattenJob *job = (FlattenJob *)data;
+
+  int num_nodes = 0;
+  const vector_int &group = job->_groups[index];
+  vector_int::const_iterator ci;
+  for (ci = group.begin(); ci != group.end(); ++ci) {
+    PT(PandaNode) child_node = job->_children->get_child(*ci);
+    num_nodes += job->_reducer->r_flatten(job->_parent_node, child_node,
+                                          job->_combine_siblings_bits);
+  }
+  job->_num_nodes[index] = num_nodes;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::unify_job
+//       Access: Private, Static
+//  Description: Unifies one GeomNode, on behalf of unify().
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+unify_job(void *data, int index) {
+  UnifyJob *job = (UnifyJob *)data;
+  GeomNode *geom_node = job->_nodes[index];
+  int count = (*job->_counts.find(geom_node)).second;
+  for (int i = 0; i < count; ++i) {
+    geom_node->unify(job->_max_indices, job->_preserve_order);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::r_find_geom_nodes
+//       Access: Private
+//  Description: Lists the GeomNodes at the indicated node and below,
+//               in the order r_unify() would visit them, along with
+//               the number of times each one would be visited.
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::
+r_find_geom_nodes(PandaNode *node, pvector<GeomNode *> &nodes,
+                  pmap<GeomNode *, int> &counts) {
+  if (node->is_geom_node()) {
+    GeomNode *geom_node = DCAST(GeomNode, node);
+    int &count = counts[geom_node];
+    if (count == 0) {
+      nodes.push_back(geom_node);
+    }
+    ++count;
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_find_geom_nodes(children.get_child(i), nodes, counts);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::ParallelThread::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+SceneGraphReducer::ParallelThread::
+ParallelThread(ParallelFunction *func, void *data, int count,
+               int *next_index, Mutex *lock) :
+  Thread("FlattenThread", "FlattenThread"),
+  _func(func),
+  _data(data),
+  _count(count),
+  _next_index(next_index),
+  _lock(lock)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: SceneGraphReducer::ParallelThread::thread_main
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+void SceneGraphReducer::ParallelThread::
+thread_main() {
+  run_jobs(_func, _data, _count, _next_index, _lock);
+}
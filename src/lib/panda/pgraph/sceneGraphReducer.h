@@ -26,8 +26,15 @@
 #include "typedObject.h"
 #include "pointerTo.h"
 #include "graphicsStateGuardianBase.h"
+#include "pandaNode.h"
+#include "pmutex.h"
+#include "thread.h"
+#include "pvector.h"
+#include "pmap.h"
+#include "vector_int.h"
+#include "config_pgraph.h"
 
-class PandaNode;
+class GeomNode;
 
 ////////////////////////////////////////////////////////////////////
 //       Class : SceneGraphReducer
@@ -127,6 +134,9 @@ PUBLISHED:
   INLINE void set_combine_radius(float combine_radius);
   INLINE float get_combine_radius() const;
 
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
   INLINE void apply_attribs(PandaNode *node, int attrib_types = ~(TT_clip_plane | TT_cull_face | TT_apply_texture_color));
   INLINE void apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                             int attrib_types, GeomTransformer &transformer);
@@ -148,12 +158,26 @@ PUBLISHED:
   INLINE void premunge(PandaNode *root, const RenderState *initial_state);
   bool check_live_flatten(PandaNode *node);
 
+public:
+  typedef void ParallelFunction(void *data, int index);
+  static void run_parallel(ParallelFunction *func, void *data, int count,
+                           int num_threads);
+
 protected:
+  INLINE int get_num_parallel_threads() const;
+
+  // Each element lists the indices of a group of children that must
+  // be processed together, on the same thread.
+  typedef pvector<vector_int> Groups;
+  void find_groups(const PandaNode::Children &cr, bool share_vertices,
+                   Groups &groups);
+
   void r_apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                        int attrib_types, GeomTransformer &transformer);
 
   int r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
                 int combine_siblings_bits);
+  int flatten_children(PandaNode *parent_node, int combine_siblings_bits);
   int flatten_siblings(PandaNode *parent_node,
                        int combine_siblings_bits);
 
@@ -182,16 +206,54 @@ protected:
                             GeomTransformer &transformer, bool format_only);
   int r_make_nonindexed(PandaNode *node, int collect_bits);
   void r_unify(PandaNode *node, int max_indices, bool preserve_order);
+  void r_find_geom_nodes(PandaNode *node, pvector<GeomNode *> &nodes,
+                         pmap<GeomNode *, int> &counts);
   void r_register_vertices(PandaNode *node, GeomTransformer &transformer);
   void r_decompose(PandaNode *node);
 
   void r_premunge(PandaNode *node, const RenderState *state);
 
 private:
+  class ParallelThread : public Thread {
+  public:
+    ParallelThread(ParallelFunction *func, void *data, int count,
+                   int *next_index, Mutex *lock);
+    virtual void thread_main();
+
+    ParallelFunction *_func;
+    void *_data;
+    int _count;
+    int *_next_index;
+    Mutex *_lock;
+  };
+
+  typedef pmap<const void *, int> SharedOwners;
+  static int find_group(vector_int &leaders, int index);
+  static void note_shared(const void *key, int index, SharedOwners &owners,
+                          vector_int &leaders);
+  void r_find_shared(PandaNode *node, int index, bool share_vertices,
+                     SharedOwners &owners, vector_int &leaders);
+
+  static void run_jobs(ParallelFunction *func, void *data, int count,
+                       int *next_index, Mutex *lock);
+  bool apply_children_parallel(PandaNode *node,
+                               const AccumulatedAttribs &attribs,
+                               int attrib_types);
+  static void apply_attribs_job(void *data, int index);
+  static void flatten_job(void *data, int index);
+  static void unify_job(void *data, int index);
+
   PT(GraphicsStateGuardianBase) _gsg;
   float _combine_radius;
+  int _num_threads;
   GeomTransformer _transformer;
 
+  // These are used by the parallel forms of apply_attribs() and
+  // flatten().  See find_groups().
+  bool _fan_out_pending;
+  PandaNode *_fan_out_node;
+  Mutex _fan_out_lock;
+
   static PStatCollector _flatten_collector;
   static PStatCollector _apply_collector;
   static PStatCollector _remove_column_collector;
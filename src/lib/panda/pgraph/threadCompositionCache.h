@@ -0,0 +1,103 @@
+// Filename: threadCompositionCache.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef THREADCOMPOSITIONCACHE_H
+#define THREADCOMPOSITIONCACHE_H
+
+#include "pandabase.h"
+#include "thread.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : ThreadCompositionCache
+// Description : This is a small, fixed-size, direct-mapped cache of
+//               recent compose() and invert_compose() results, kept
+//               privately by each thread for TransformState and
+//               RenderState.  A hit in this cache takes only the
+//               cache's own lock, which no other thread contends for
+//               in normal operation; only a miss falls through to the
+//               shared composition cache, which is protected by the
+//               global _states_lock.
+//
+//               Each entry holds a reference to both operands as well
+//               as the result, so a cached pointer can never refer to
+//               a deleted (and possibly reallocated) state.  The
+//               price is that up to thread-composition-cache-size
+//               states per thread may be kept alive somewhat longer
+//               than they otherwise would be.
+//
+//               Every cache is listed in a Registry kept by the
+//               owning class, so that clear_cache() can empty the
+//               caches of all threads at once, including threads
+//               that have gone idle.
+////////////////////////////////////////////////////////////////////
+template<class State>
+class ThreadCompositionCache : public Thread::CacheData {
+public:
+  class Registry {
+  public:
+    INLINE Registry();
+    void clear_all();
+
+  private:
+    typedef pvector<ThreadCompositionCache<State> *> Caches;
+    Caches _caches;
+    LightMutex _lock;
+
+    friend class ThreadCompositionCache<State>;
+  };
+
+  ThreadCompositionCache(int size, Registry *registry);
+  virtual ~ThreadCompositionCache();
+
+  INLINE static ThreadCompositionCache<State> *
+  get_cache(int slot, int size, Registry *registry);
+
+  INLINE CPT(State) find_compose(const State *a, const State *b) const;
+  INLINE CPT(State) find_invert_compose(const State *a, const State *b) const;
+  INLINE void store_compose(const State *a, const State *b,
+                            const State *result);
+  INLINE void store_invert_compose(const State *a, const State *b,
+                                   const State *result);
+
+private:
+  class Entry {
+  public:
+    CPT(State) _a;
+    CPT(State) _b;
+    CPT(State) _result;
+  };
+  typedef pvector<Entry> Entries;
+
+  INLINE int get_index(const State *a, const State *b) const;
+  INLINE CPT(State) find(const Entries &entries, int index,
+                         const State *a, const State *b) const;
+  INLINE void store(Entries &entries, int index,
+                    const State *a, const State *b,
+                    const State *result);
+  void take_entries(Entries &released);
+
+  Entries _compose;
+  Entries _invert_compose;
+  int _mask;
+  Registry *_registry;
+  mutable LightMutex _lock;
+};
+
+#include "threadCompositionCache.I"
+
+#endif
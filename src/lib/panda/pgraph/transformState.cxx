@@ -27,6 +27,9 @@
 #include "py_panda.h"
 
 LightReMutex *TransformState::_states_lock = NULL;
+int TransformState::_thread_cache_slot = -1;
+ThreadCompositionCache<TransformState>::Registry *TransformState::_thread_caches =
+  NULL;
 TransformState::States *TransformState::_states = NULL;
 CPT(TransformState) TransformState::_identity_state;
 CPT(TransformState) TransformState::_invalid_state;
@@ -605,6 +608,34 @@ compose(const TransformState *other) const {
   }
 #endif  // NDEBUG
 
+  ThreadCompositionCache<TransformState> *thread_cache = 
+    ThreadCompositionCache<TransformState>::get_cache
+    (_thread_cache_slot, thread_composition_cache_size, _thread_caches);
+  if (thread_cache != (ThreadCompositionCache<TransformState> *)NULL) {
+    CPT(TransformState) result = thread_cache->find_compose(this, other);
+    if (result != (const TransformState *)NULL) {
+      return result;
+    }
+  }
+
+  CPT(TransformState) result = do_shared_compose(other);
+
+  if (thread_cache != (ThreadCompositionCache<TransformState> *)NULL) {
+    thread_cache->store_compose(this, other, result);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TransformState::do_shared_compose
+//       Access: Private
+//  Description: The part of compose() that consults and updates
+//               the shared composition cache, under _states_lock.
+//               This is called only when the result is not found in
+//               the current thread's private cache.
+////////////////////////////////////////////////////////////////////
+CPT(TransformState) TransformState::
+do_shared_compose(const TransformState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   // Is this composition already cached?
@@ -710,6 +741,35 @@ invert_compose(const TransformState *other) const {
   }
 #endif  // NDEBUG
 
+  ThreadCompositionCache<TransformState> *thread_cache = 
+    ThreadCompositionCache<TransformState>::get_cache
+    (_thread_cache_slot, thread_composition_cache_size, _thread_caches);
+  if (thread_cache != (ThreadCompositionCache<TransformState> *)NULL) {
+    CPT(TransformState) result = 
+      thread_cache->find_invert_compose(this, other);
+    if (result != (const TransformState *)NULL) {
+      return result;
+    }
+  }
+
+  CPT(TransformState) result = do_shared_invert_compose(other);
+
+  if (thread_cache != (ThreadCompositionCache<TransformState> *)NULL) {
+    thread_cache->store_invert_compose(this, other, result);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TransformState::do_shared_invert_compose
+//       Access: Private
+//  Description: The part of invert_compose() that consults and updates
+//               the shared composition cache, under _states_lock.
+//               This is called only when the result is not found in
+//               the current thread's private cache.
+////////////////////////////////////////////////////////////////////
+CPT(TransformState) TransformState::
+do_shared_invert_compose(const TransformState *other) const {
   LightReMutexHolder holder(*_states_lock);
 
   // Is this composition already cached?
@@ -788,8 +848,20 @@ invert_compose(const TransformState *other) const {
 ////////////////////////////////////////////////////////////////////
 bool TransformState::
 unref() const {
-  // We always have to grab the lock, since we will definitely need to
-  // be holding it if we happen to drop the reference count to 0.
+  // We only need to grab the lock if we might be about to drop the
+  // reference count to 0, or to the point where only the cache holds
+  // references (see below).  The cache's share of the count may
+  // change under us while we don't hold the lock, so we can't safely
+  // compare against it here; when cycles are not being broken, though,
+  // only the drop to 0 matters, and any higher count may be
+  // decremented without the lock.
+  if (!(auto_break_cycles && uniquify_transforms) && unref_if_above(1)) {
+    return true;
+  }
+
+  // Otherwise, we have to grab the lock, since we will definitely
+  // need to be holding it if we happen to drop the reference count
+  // to 0.
   LightReMutexHolder holder(*_states_lock);
 
   if (auto_break_cycles && uniquify_transforms) {
@@ -1219,6 +1291,13 @@ clear_cache() {
   if (_states == (States *)NULL) {
     return 0;
   }
+
+  // Empty the per-thread caches of all threads first, so that any
+  // states held only by them can be freed below.  This must be done
+  // before we take _states_lock, since the caches release their
+  // states only after dropping their own locks.
+  _thread_caches->clear_all();
+
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_cache_update_pcollector);
@@ -1506,6 +1585,8 @@ init_states() {
   // one thread in the world.
   _states_lock = new LightReMutex("TransformState::_states_lock");
   _cache_stats.init();
+  _thread_cache_slot = Thread::allocate_cache_slot();
+  _thread_caches = new ThreadCompositionCache<TransformState>::Registry;
   nassertv(Thread::get_current_thread() == Thread::get_main_thread());
 }
   
@@ -33,6 +33,7 @@
 #include "deletedChain.h"
 #include "simpleHashMap.h"
 #include "cacheStats.h"
+#include "threadCompositionCache.h"
 
 class GraphicsStateGuardianBase;
 class FactoryParams;
@@ -235,6 +236,8 @@ private:
 
   CPT(TransformState) do_compose(const TransformState *other) const;
   CPT(TransformState) do_invert_compose(const TransformState *other) const;
+  CPT(TransformState) do_shared_compose(const TransformState *other) const;
+  CPT(TransformState) do_shared_invert_compose(const TransformState *other) const;
   static bool r_detect_cycles(const TransformState *start_state,
                               const TransformState *current_state,
                               int length, UpdateSeq this_seq,
@@ -286,6 +289,13 @@ private:
   CompositionCache _composition_cache;
   CompositionCache _invert_composition_cache;
 
+  // Each thread also keeps a small private cache of its recent
+  // compositions, so that a hit need not take _states_lock at all.
+  // See ThreadCompositionCache.  All of these caches are listed in
+  // _thread_caches, so that clear_cache() can empty them.
+  static int _thread_cache_slot;
+  static ThreadCompositionCache<TransformState>::Registry *_thread_caches;
+
   // This is used to mark nodes as we visit them to detect cycles.
   UpdateSeq _cycle_detect;
   static UpdateSeq _last_cycle_detect;
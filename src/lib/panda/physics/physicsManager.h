@@ -84,6 +84,8 @@ PUBLISHED:
   virtual void debug_output(ostream &out, unsigned int indent=0) const;
 
 public:
+  INLINE const LinearForceVector &get_linear_forces() const;
+
   friend class Physical;
   static ConfigVariableInt _random_seed;
 
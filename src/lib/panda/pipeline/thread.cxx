@@ -22,6 +22,7 @@
 
 Thread *Thread::_main_thread;
 Thread *Thread::_external_thread;
+AtomicAdjust::Integer Thread::_num_cache_slots = 0;
 TypeHandle Thread::_type_handle;
 
 ////////////////////////////////////////////////////////////////////
@@ -88,6 +89,13 @@ Thread::
            _waiting_on_cvar == NULL &&
            _waiting_on_cvar_full == NULL);
 #endif
+
+  CacheSlots::iterator ci;
+  for (ci = _cache_data.begin(); ci != _cache_data.end(); ++ci) {
+    if ((*ci) != (CacheData *)NULL) {
+      delete (*ci);
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -493,6 +501,53 @@ init_external_thread() {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: Thread::allocate_cache_slot
+//       Access: Public, Static
+//  Description: Reserves a new slot number for use with
+//               get_cache_data() and set_cache_data().  Each client
+//               should call this only once, and save the result.
+////////////////////////////////////////////////////////////////////
+int Thread::
+allocate_cache_slot() {
+  AtomicAdjust::Integer slot = AtomicAdjust::get(_num_cache_slots);
+  AtomicAdjust::Integer result;
+  result = AtomicAdjust::compare_and_exchange(_num_cache_slots, slot, slot + 1);
+  while (result != slot) {
+    slot = result;
+    result = AtomicAdjust::compare_and_exchange(_num_cache_slots, slot, slot + 1);
+  }
+  return slot;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: Thread::set_cache_data
+//       Access: Public
+//  Description: Stores the indicated CacheData object in the
+//               indicated slot, which must have been returned by
+//               allocate_cache_slot().  The Thread takes ownership of
+//               the object, and will delete it when the Thread
+//               destructs, or when another object is stored in the
+//               same slot.
+//
+//               This should normally only be called by the thread
+//               itself; there is no locking around the slots.
+////////////////////////////////////////////////////////////////////
+void Thread::
+set_cache_data(int slot, CacheData *data) {
+  nassertv(slot >= 0 && slot < AtomicAdjust::get(_num_cache_slots));
+  if (slot >= (int)_cache_data.size()) {
+    _cache_data.insert(_cache_data.end(), slot + 1 - _cache_data.size(),
+                       (CacheData *)NULL);
+  }
+  if (_cache_data[slot] != data) {
+    if (_cache_data[slot] != (CacheData *)NULL) {
+      delete _cache_data[slot];
+    }
+    _cache_data[slot] = data;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: Thread::PStatsCallback::Destructor
 //       Access: Public, Virtual
@@ -528,3 +583,12 @@ deactivate_hook(Thread *) {
 void Thread::PStatsCallback::
 activate_hook(Thread *) {
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: Thread::CacheData::Destructor
+//       Access: Public, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+Thread::CacheData::
+~CacheData() {
+}
@@ -23,6 +23,7 @@
 #include "threadImpl.h"
 #include "pnotify.h"
 #include "config_pipeline.h"
+#include "pvector.h"
 
 #ifdef HAVE_PYTHON
 #undef _POSIX_C_SOURCE
@@ -116,6 +117,21 @@ public:
   INLINE void set_pstats_callback(PStatsCallback *pstats_callback);
   INLINE PStatsCallback *get_pstats_callback() const;
 
+  // This class allows higher-level code to store its own private
+  // per-thread data (typically caches) on the Thread object.  Each
+  // client allocates a slot number once, with allocate_cache_slot(),
+  // and then stores a CacheData object in that slot of each Thread
+  // that needs one.  The Thread deletes its CacheData objects when it
+  // destructs.
+  class EXPCL_PANDA_PIPELINE CacheData {
+  public:
+    virtual ~CacheData();
+  };
+
+  static int allocate_cache_slot();
+  INLINE CacheData *get_cache_data(int slot) const;
+  void set_cache_data(int slot, CacheData *data);
+
 #ifdef HAVE_PYTHON
   // Integration with Python.
   PyObject *call_python_func(PyObject *function, PyObject *args);
@@ -137,6 +153,9 @@ private:
   PStatsCallback *_pstats_callback;
   bool _joinable;
 
+  typedef pvector<CacheData *> CacheSlots;
+  CacheSlots _cache_data;
+
 #ifdef HAVE_PYTHON
   PyObject *_python_data;
 #endif
@@ -150,6 +169,7 @@ private:
 private:
   static Thread *_main_thread;
   static Thread *_external_thread;
+  static AtomicAdjust::Integer _num_cache_slots;
 
 public:
   static TypeHandle get_class_type() {
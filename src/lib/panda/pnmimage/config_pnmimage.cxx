@@ -20,6 +20,30 @@
 Configure(config_pnmimage);
 NotifyCategoryDef(pnmimage, "");
 
+ConfigVariableInt pnm_filter_threads
+("pnm-filter-threads", 0,
+ PRC_DESC("The number of worker threads that should be used by "
+          "PNMImage::box_filter_from(), gaussian_filter_from(), "
+          "lanczos_filter_from() and quick_filter_from().  When this is "
+          "0 (the default), the image is filtered entirely on the calling "
+          "thread.  When it is greater than 0, the rows of the image are "
+          "divided among this many threads in addition to the calling "
+          "thread.  The result is the same either way."));
+
+ConfigVariableInt pnm_filter_min_size
+("pnm-filter-min-size", 65536,
+ PRC_DESC("The smallest image, in pixels, that will be divided among the "
+          "pnm-filter-threads.  Smaller images are filtered on the "
+          "calling thread, since the cost of starting the threads would "
+          "outweigh the benefit."));
+
+ConfigVariableBool pnm_filter_simd
+("pnm-filter-simd", true,
+ PRC_DESC("Configure this false to disable the SSE2 implementation of "
+          "the PNMImage box, gaussian and lanczos filters, which is used "
+          "when the CPU supports it.  It filters four rows at a time, and "
+          "produces exactly the same image as the scalar implementation."));
+
 ConfigureFn(config_pnmimage) {
   init_libpnmimage();
 }
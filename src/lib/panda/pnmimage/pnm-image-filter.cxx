@@ -37,7 +37,11 @@
 #include "cmath.h"
 
 #include "pnmImage.h"
+#include "config_pnmimage.h"
 #include "thread.h"
+#include "lsimd.h"
+#include "mathNumbers.h"
+#include "pvector.h"
 
 // WorkType is an abstraction that allows the filtering process to be
 // recompiled to use either floating-point or integer arithmetic.  On SGI
@@ -95,22 +99,43 @@ static const WorkType filter_max = 255;
 
 
 
-// filter_row() filters a single row by convolving with a one-dimensional
-// kernel filter.  The kernel is defined by an array of weights in filter[],
-// where the ith element of filter corresponds to abs(d * scale), if scale>1.0,
-// and abs(d), if scale<=1.0, where d is the offset from the center and varies
-// from -filter_width to filter_width.
+// The rows are filtered by convolving with a one-dimensional kernel
+// filter.  The kernel is defined by an array of weights in filter[], where
+// the ith element of filter corresponds to abs(d * scale), if scale>1.0,
+// and abs(d), if scale<=1.0, where d is the offset from the center and
+// varies from -filter_width to filter_width.
 
 // Note that filter_width is not necessarily the length of the array; it is
 // the radius of interest of the filter function.  The array may need to be
 // larger (by a factor of scale), to adequately cover all the values.
 
+// Which elements of the kernel apply to which source values depends only
+// on the lengths of the rows and on the filter, not on the values being
+// filtered, so compute_taps() works this out once for each pass, and the
+// FilterTaps it fills in are then applied to every row in the pass.  For
+// each element of the destination row, it records the first source
+// element that contributes to it, the weight of that and each of the
+// following contributing elements, and the sum of those weights.
+
+struct FilterTaps {
+  int _dest_len;
+  pvector<int> _left;
+  pvector<int> _count;
+  pvector<WorkType> _weights;
+  pvector<WorkType> _net_weight;
+};
+
 static void
-filter_row(StoreType dest[], int dest_len,
-           const StoreType source[], int source_len,
-           double scale,                    //  == dest_len / source_len
-           const WorkType filter[],
-           double filter_width) {
+compute_taps(FilterTaps &taps, int dest_len, int source_len,
+             double scale,                    //  == dest_len / source_len
+             const WorkType filter[],
+             double filter_width) {
+  taps._dest_len = dest_len;
+  taps._left.resize(dest_len);
+  taps._count.resize(dest_len);
+  taps._net_weight.resize(dest_len);
+  taps._weights.clear();
+
   // If we are expanding the row (scale>1.0), we need to look at a fractional
   // granularity.  Hence, we scale our filter index by scale.  If we are
   // compressing (scale<1.0), we don't need to fiddle with the filter index, so
@@ -136,7 +161,6 @@ filter_row(StoreType dest[], int dest_len,
     int right_center = (int)cceil(center);
 
     WorkType net_weight = 0;
-    WorkType net_value = 0;
 
     int index, source_x;
 
@@ -145,25 +169,236 @@ filter_row(StoreType dest[], int dest_len,
     // each time through the loop.
     for (source_x=left; source_x<right_center; source_x++) {
       index = (int)(iscale*(center-source_x));
-      net_value += filter[index] * source[source_x];
+      taps._weights.push_back(filter[index]);
       net_weight += filter[index];
     }
 
     for (; source_x<=right; source_x++) {
       index = (int)(iscale*(source_x-center));
-      net_value += filter[index] * source[source_x];
+      taps._weights.push_back(filter[index]);
       net_weight += filter[index];
     }
 
+    taps._left[dest_x] = left;
+    taps._count[dest_x] = max(source_x - left, 0);
+    taps._net_weight[dest_x] = net_weight;
+  }
+}
+
+// filter_row() filters a single row, using taps computed for rows of
+// this length.
+static void
+filter_row(StoreType dest[], const StoreType source[],
+           const FilterTaps &taps) {
+  const WorkType *weight = taps._weights.empty() ? NULL : &taps._weights[0];
+
+  for (int dest_x=0; dest_x<taps._dest_len; dest_x++) {
+    const StoreType *sp = source + taps._left[dest_x];
+    int count = taps._count[dest_x];
+
+    WorkType net_value = 0;
+    for (int i=0; i<count; i++) {
+      net_value += weight[i] * sp[i];
+    }
+    weight += count;
+
+    WorkType net_weight = taps._net_weight[dest_x];
     if (net_weight>0) {
       dest[dest_x] = (StoreType)(net_value / net_weight);
     } else {
       dest[dest_x] = 0;
     }
   }
-  Thread::consider_yield();
 }
 
+// filter_rows_4() filters four rows at once, which are interleaved in
+// source[] and dest[]: the xth element of row k is at [x * 4 + k].  The
+// source values have already been widened to WorkType.  It uses SSE2
+// where it is available, performing exactly the same sequence of
+// double-precision operations on each row as filter_row(), so the result
+// is identical.  It assumes the floating-point WorkType and StoreType
+// selected above.  (The x87 code that some 32-bit compilers generate for
+// filter_row() may keep extra precision in the intermediate sums, in which
+// case the two may occasionally differ in the last bit of a StoreType.)
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define PNM_FILTER_SSE2 __attribute__((target("sse2")))
+#include <emmintrin.h>
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define PNM_FILTER_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef PNM_FILTER_SSE2
+static PNM_FILTER_SSE2 void
+filter_rows_4(StoreType dest[], const WorkType source[],
+              const FilterTaps &taps) {
+  const WorkType *weight = taps._weights.empty() ? NULL : &taps._weights[0];
+
+  for (int dest_x=0; dest_x<taps._dest_len; dest_x++) {
+    const WorkType *sp = source + taps._left[dest_x] * 4;
+    int count = taps._count[dest_x];
+
+    // Rows 0 and 1 are in lo, rows 2 and 3 in hi.
+    __m128d lo = _mm_setzero_pd();
+    __m128d hi = _mm_setzero_pd();
+    for (int i=0; i<count; i++) {
+      __m128d w = _mm_set1_pd(weight[i]);
+      lo = _mm_add_pd(lo, _mm_mul_pd(w, _mm_loadu_pd(sp + i * 4)));
+      hi = _mm_add_pd(hi, _mm_mul_pd(w, _mm_loadu_pd(sp + i * 4 + 2)));
+    }
+    weight += count;
+
+    WorkType net_weight = taps._net_weight[dest_x];
+    if (net_weight>0) {
+      __m128d div = _mm_set1_pd(net_weight);
+      __m128 result = _mm_movelh_ps(_mm_cvtpd_ps(_mm_div_pd(lo, div)),
+                                    _mm_cvtpd_ps(_mm_div_pd(hi, div)));
+      _mm_storeu_ps(dest + dest_x * 4, result);
+    } else {
+      _mm_storeu_ps(dest + dest_x * 4, _mm_setzero_ps());
+    }
+  }
+}
+
+#else  // PNM_FILTER_SSE2
+static void
+filter_rows_4(StoreType dest[], const WorkType source[],
+              const FilterTaps &taps) {
+  const WorkType *weight = taps._weights.empty() ? NULL : &taps._weights[0];
+
+  for (int dest_x=0; dest_x<taps._dest_len; dest_x++) {
+    const WorkType *sp = source + taps._left[dest_x] * 4;
+    int count = taps._count[dest_x];
+
+    WorkType net_value[4] = { 0, 0, 0, 0 };
+    for (int i=0; i<count; i++) {
+      for (int k=0; k<4; k++) {
+        net_value[k] += weight[i] * sp[i * 4 + k];
+      }
+    }
+    weight += count;
+
+    WorkType net_weight = taps._net_weight[dest_x];
+    for (int k=0; k<4; k++) {
+      if (net_weight>0) {
+        dest[dest_x * 4 + k] = (StoreType)(net_value[k] / net_weight);
+      } else {
+        dest[dest_x * 4 + k] = 0;
+      }
+    }
+  }
+}
+#endif  // PNM_FILTER_SSE2
+
+// use_filter_rows_4() returns true if filter_rows_4() should be used in
+// preference to filter_row().
+static bool
+use_filter_rows_4() {
+#ifdef PNM_FILTER_SSE2
+  return pnm_filter_simd && LSimd::get_supported_level() >= LSimd::L_sse2;
+#else
+  return false;
+#endif
+}
+
+
+// The rows (or columns) of each pass are independent of each other, so
+// if pnm-filter-threads is set, run_filter_range() divides them among
+// that many threads, in addition to the calling thread.  Each thread
+// receives a contiguous range of rows, a multiple of four rows long so
+// that filter_rows_4() may be used throughout.
+
+typedef void FilterRangeFunction(void *data, int begin, int end);
+
+class FilterThread : public Thread {
+public:
+  FilterThread(FilterRangeFunction *func, void *data, int begin, int end);
+  virtual void thread_main();
+
+  FilterRangeFunction *_func;
+  void *_data;
+  int _begin;
+  int _end;
+};
+
+FilterThread::
+FilterThread(FilterRangeFunction *func, void *data, int begin, int end) :
+  Thread("PNMFilterThread", "PNMFilterThread"),
+  _func(func),
+  _data(data),
+  _begin(begin),
+  _end(end)
+{
+}
+
+void FilterThread::
+thread_main() {
+  (*_func)(_data, _begin, _end);
+}
+
+// Returns the number of additional threads that should be used to filter
+// an image of the indicated size.
+static int
+get_num_filter_threads(int num_pixels) {
+  int num_threads = pnm_filter_threads;
+  if (num_threads <= 0 || num_pixels < pnm_filter_min_size ||
+      !Thread::is_true_threads()) {
+    return 0;
+  }
+  return num_threads;
+}
+
+static void
+run_filter_range(FilterRangeFunction *func, void *data, int count,
+                 int num_threads) {
+  int num_ranges = min(num_threads + 1, (count + 3) / 4);
+  if (num_ranges <= 1) {
+    (*func)(data, 0, count);
+    return;
+  }
+
+  int per_range = ((count + num_ranges - 1) / num_ranges + 3) & ~3;
+
+  typedef pvector< PT(FilterThread) > Threads;
+  Threads threads;
+  int begin = per_range;
+  while (begin < count) {
+    int end = min(begin + per_range, count);
+    PT(FilterThread) thread = new FilterThread(func, data, begin, end);
+    if (thread->start(TP_normal, true)) {
+      threads.push_back(thread);
+    } else {
+      // Couldn't start it; do the work here instead.
+      (*func)(data, begin, end);
+    }
+    begin = end;
+  }
+
+  (*func)(data, 0, min(per_range, count));
+
+  Threads::iterator ti;
+  for (ti = threads.begin(); ti != threads.end(); ++ti) {
+    (*ti)->join();
+  }
+}
+
+// The state of one channel being filtered by one of the functions defined
+// in pnm-image-filter-core.T, shared by all of the threads that work on
+// it.
+struct FilterJob {
+  PNMImage *_dest;
+  const PNMImage *_source;
+  StoreType **_matrix;
+  FilterTaps _taps;
+  bool _rows_4;
+};
+
+// Expands to the name of a function defined along with FUNCTION_NAME.
+#define FILTER_CONCAT2(a, b) a ## b
+#define FILTER_CONCAT(a, b) FILTER_CONCAT2(a, b)
+
 
 // The various filter functions are called before each axis scaling to build
 // an kernel array suitable for the given scaling factor.  Given a scaling
@@ -242,6 +477,49 @@ gaussian_filter_impl(double scale, double width,
   }
 }
 
+static void
+lanczos_filter_impl(double scale, double width,
+                    WorkType *&filter, double &filter_width) {
+  double fscale;
+  if (scale < 1.0) {
+    // If we are compressing the image, the kernel must be stretched to
+    // cover the same number of destination pixels on either side of the
+    // center, which is width / scale source pixels; otherwise it would
+    // no longer remove the frequencies above the new Nyquist rate.
+    fscale = 1.0 / scale;
+    filter_width = width * fscale;
+  } else {
+
+    // If we are expanding the image, we want to increase the granularity
+    // of the filter function since we will need to access fractional cel
+    // values.  Hence, we multiply by scale.
+    fscale = scale;
+    filter_width = width;
+  }
+  int actual_width = (int)cceil((filter_width+1) * max(scale, 1.0)) + 1;
+
+  // L(x) = sinc(x) * sinc(x / a), for |x| < a, where sinc(x) = sin(pi x) /
+  // (pi x), and a is the number of lobes on either side of the center.
+  // The kernel goes negative between the lobes; the resulting values
+  // outside the range 0..1 are clamped when they are stored in the image.
+
+  filter = (WorkType *)PANDA_MALLOC_ARRAY(actual_width * sizeof(WorkType));
+
+  for (int i=0; i<actual_width; i++) {
+    double x = i/fscale;
+    double value;
+    if (x == 0.0) {
+      value = 1.0;
+    } else if (x < width) {
+      double px = MathNumbers::pi * x;
+      value = width * sin(px) * sin(px / width) / (px * px);
+    } else {
+      value = 0.0;
+    }
+    filter[i] = (WorkType)(filter_max * value);
+  }
+}
+
 
 // We have a function, defined in pnm-image-filter-core.T, that will scale
 // an image in both X and Y directions for a particular channel, by setting
@@ -396,34 +674,37 @@ gaussian_filter_impl(double scale, double width,
 static void
 filter_image(PNMImage &dest, const PNMImage &source,
              double width, FilterFunction *make_filter) {
+  int num_threads =
+    get_num_filter_threads(max(dest.get_x_size() * dest.get_y_size(),
+                               source.get_x_size() * source.get_y_size()));
 
   // We want to scale by the smallest destination axis first, for a
   // slight performance gain.
 
   if (dest.get_x_size() <= dest.get_y_size()) {
     if (dest.is_grayscale() || source.is_grayscale()) {
-      filter_gray_xy(dest, source, width, make_filter);
+      filter_gray_xy(dest, source, width, make_filter, num_threads);
     } else {
-      filter_red_xy(dest, source, width, make_filter);
-      filter_green_xy(dest, source, width, make_filter);
-      filter_blue_xy(dest, source, width, make_filter);
+      filter_red_xy(dest, source, width, make_filter, num_threads);
+      filter_green_xy(dest, source, width, make_filter, num_threads);
+      filter_blue_xy(dest, source, width, make_filter, num_threads);
     }
 
     if (dest.has_alpha() && source.has_alpha()) {
-      filter_alpha_xy(dest, source, width, make_filter);
+      filter_alpha_xy(dest, source, width, make_filter, num_threads);
     }
 
   } else {
     if (dest.is_grayscale() || source.is_grayscale()) {
-      filter_gray_yx(dest, source, width, make_filter);
+      filter_gray_yx(dest, source, width, make_filter, num_threads);
     } else {
-      filter_red_yx(dest, source, width, make_filter);
-      filter_green_yx(dest, source, width, make_filter);
-      filter_blue_yx(dest, source, width, make_filter);
+      filter_red_yx(dest, source, width, make_filter, num_threads);
+      filter_green_yx(dest, source, width, make_filter, num_threads);
+      filter_blue_yx(dest, source, width, make_filter, num_threads);
     }
 
     if (dest.has_alpha() && source.has_alpha()) {
-      filter_alpha_yx(dest, source, width, make_filter);
+      filter_alpha_yx(dest, source, width, make_filter, num_threads);
     }
   }
 }
@@ -458,6 +739,21 @@ gaussian_filter_from(double width, const PNMImage &copy) {
   filter_image(*this, copy, width, &gaussian_filter_impl);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PNMImage::lanczos_filter_from
+//       Access: Public
+//  Description: Makes a resized copy of the indicated image into this
+//               one using a Lanczos filter with the indicated number
+//               of lobes on either side of the center.  This keeps
+//               more of the detail of the original than
+//               gaussian_filter_from(), at the cost of some ringing
+//               around sharp edges.
+////////////////////////////////////////////////////////////////////
+void PNMImage::
+lanczos_filter_from(double width, const PNMImage &copy) {
+  filter_image(*this, copy, width, &lanczos_filter_impl);
+}
+
 
 //
 // The following functions are support for quick_box_filter().
@@ -549,6 +845,53 @@ box_filter_region(const PNMImage &image,
   alpha_result = (xelval)(alpha / pixel_count + 0.5);
 }
 
+// The state of a quick_filter_from() operation, shared by all of the
+// threads that work on it.
+struct QuickFilterJob {
+  PNMImage *_dest;
+  const PNMImage *_from;
+  int _to_xoff, _to_yoff;
+  int _to_x_begin, _to_x_end;
+  int _to_y_begin;
+  double _x_scale, _y_scale;
+};
+
+// Filters the rows to_y_begin + [begin, end) of the destination image.
+static void
+quick_filter_rows(void *data, int begin, int end) {
+  QuickFilterJob &job = *(QuickFilterJob *)data;
+  PNMImage &dest = *job._dest;
+  bool has_alpha = dest.has_alpha();
+
+  for (int to_y = job._to_y_begin + begin;
+       to_y < job._to_y_begin + end;
+       to_y++) {
+    // Each row begins where the previous one ended, so this is
+    // computed the same way as the previous row's from_y1.
+    double from_y0 = to_y * job._y_scale;
+    double from_y1 = (to_y+1) * job._y_scale;
+
+    double from_x0 = job._to_x_begin * job._x_scale;
+    for (int to_x = job._to_x_begin; to_x < job._to_x_end; to_x++) {
+      double from_x1 = (to_x+1) * job._x_scale;
+
+      // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
+      // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
+      xelval alpha_result;
+      box_filter_region(*job._from,
+                        from_x0, from_y0, from_x1, from_y1,
+                        dest[job._to_yoff + to_y][job._to_xoff + to_x],
+                        alpha_result);
+      if (has_alpha) {
+        dest.set_alpha_val(job._to_xoff+to_x, job._to_yoff+to_y, alpha_result);
+      }
+
+      from_x0 = from_x1;
+    }
+    Thread::consider_yield();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PNMImage::quick_filter_from
 //       Access: Public
@@ -569,41 +912,30 @@ quick_filter_from(const PNMImage &from, int xborder, int yborder) {
   int to_xs = get_x_size() - xborder;
   int to_ys = get_y_size() - yborder;
 
-  int to_xoff = xborder / 2;
-  int to_yoff = yborder / 2;
-
-  double from_x0, from_x1, from_y0, from_y1;
-  int to_x, to_y;
-
-  double x_scale = (double)from_xs / (double)to_xs;
-  double y_scale = (double)from_ys / (double)to_ys;
-
-  from_y0 = max(0, -to_yoff) * y_scale;
-  for (to_y = max(0, -to_yoff);
-       to_y < min(to_ys, get_y_size()-to_yoff);
-       to_y++) {
-    from_y1 = (to_y+1) * y_scale;
-
-    from_x0 = max(0, -to_xoff) * x_scale;
-    for (to_x = max(0, -to_xoff);
-         to_x < min(to_xs, get_x_size()-to_xoff);
-         to_x++) {
-      from_x1 = (to_x+1) * x_scale;
-
-      // Now the box from (from_x0, from_y0) - (from_x1, from_y1)
-      // but not including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-      xelval alpha_result;
-      box_filter_region(from,
-                        from_x0, from_y0, from_x1, from_y1,
-                        (*this)[to_yoff + to_y][to_xoff + to_x],
-                        alpha_result);
-      if (has_alpha()) {
-        set_alpha_val(to_xoff+to_x, to_yoff+to_y, alpha_result);
-      }
+  QuickFilterJob job;
+  job._dest = this;
+  job._from = &from;
+  job._to_xoff = xborder / 2;
+  job._to_yoff = yborder / 2;
+  job._to_x_begin = max(0, -job._to_xoff);
+  job._to_x_end = min(to_xs, get_x_size()-job._to_xoff);
+  job._to_y_begin = max(0, -job._to_yoff);
+  job._x_scale = (double)from_xs / (double)to_xs;
+  job._y_scale = (double)from_ys / (double)to_ys;
+
+  int to_y_end = min(to_ys, get_y_size()-job._to_yoff);
+  if (to_y_end <= job._to_y_begin) {
+    return;
+  }
 
-      from_x0 = from_x1;
-    }
-    from_y0 = from_y1;
-    Thread::consider_yield();
+  // The rows may only be divided among threads if each of them reads
+  // only the source image, which isn't the case if it is also the
+  // destination.
+  int num_threads = 0;
+  if (&from != this) {
+    num_threads = get_num_filter_threads(get_x_size() * get_y_size());
   }
+
+  run_filter_range(&quick_filter_rows, &job, to_y_end - job._to_y_begin,
+                   num_threads);
 }
@@ -218,6 +218,7 @@ PUBLISHED:
 
   void box_filter_from(double radius, const PNMImage &copy);
   void gaussian_filter_from(double radius, const PNMImage &copy);
+  void lanczos_filter_from(double radius, const PNMImage &copy);
   void quick_filter_from(const PNMImage &copy,
                          int xborder = 0, int yborder = 0);
 
@@ -47,6 +47,7 @@ PStatCollector PStatClient::_clock_busy_wait_pcollector("Wait:Clock Wait:Spin");
 PStatCollector PStatClient::_thread_block_pcollector("Wait:Thread block");
 
 PStatClient *PStatClient::_global_pstats = NULL;
+PStatClient::FrameLevelFuncsList *PStatClient::_frame_level_funcs = NULL;
 
 
 // This class is used to report memory usage per TypeHandle.  We
@@ -198,6 +199,70 @@ get_current_thread() const {
   return PStatThread(Thread::get_current_thread(), (PStatClient *)this);
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: PStatClient::add_frame_level_funcs
+//       Access: Public, Static
+//  Description: Registers a pair of functions that flush and clear
+//               the level collectors with which a library counts
+//               events each frame.  flush_func is called by
+//               flush_frame_levels(), before each frame is reported,
+//               and clear_func by clear_frame_levels(), after it has
+//               been.
+//
+//               This is intended to be called from a library's
+//               init_lib function, while there is still only one
+//               thread.
+////////////////////////////////////////////////////////////////////
+void PStatClient::
+add_frame_level_funcs(FrameLevelFunc *flush_func,
+                      FrameLevelFunc *clear_func) {
+  if (_frame_level_funcs == (FrameLevelFuncsList *)NULL) {
+    _frame_level_funcs = new FrameLevelFuncsList;
+  }
+  FrameLevelFuncs funcs;
+  funcs._flush_func = flush_func;
+  funcs._clear_func = clear_func;
+  _frame_level_funcs->push_back(funcs);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PStatClient::flush_frame_levels
+//       Access: Public, Static
+//  Description: Calls each flush_func registered with
+//               add_frame_level_funcs().  This is called by the
+//               GraphicsEngine at the end of each frame.
+////////////////////////////////////////////////////////////////////
+void PStatClient::
+flush_frame_levels() {
+  if (_frame_level_funcs != (FrameLevelFuncsList *)NULL) {
+    FrameLevelFuncsList::const_iterator fi;
+    for (fi = _frame_level_funcs->begin(); 
+         fi != _frame_level_funcs->end(); 
+         ++fi) {
+      (*(*fi)._flush_func)();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: PStatClient::clear_frame_levels
+//       Access: Public, Static
+//  Description: Calls each clear_func registered with
+//               add_frame_level_funcs().  This is called by the
+//               GraphicsEngine after each frame has been reported.
+////////////////////////////////////////////////////////////////////
+void PStatClient::
+clear_frame_levels() {
+  if (_frame_level_funcs != (FrameLevelFuncsList *)NULL) {
+    FrameLevelFuncsList::const_iterator fi;
+    for (fi = _frame_level_funcs->begin(); 
+         fi != _frame_level_funcs->end(); 
+         ++fi) {
+      (*(*fi)._clear_func)();
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: PStatClient::main_tick
 //       Access: Published, Static
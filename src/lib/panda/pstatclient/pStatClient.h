@@ -103,6 +103,16 @@ PUBLISHED:
 
   static PStatClient *get_global_pstats();
 
+public:
+  // A library whose per-frame counters can't be named by the
+  // GraphicsEngine (because the library is built above it) registers
+  // a pair of these instead.  See add_frame_level_funcs().
+  typedef void FrameLevelFunc();
+  static void add_frame_level_funcs(FrameLevelFunc *flush_func,
+                                    FrameLevelFunc *clear_func);
+  static void flush_frame_levels();
+  static void clear_frame_levels();
+
 private:
   INLINE bool has_impl() const;
   INLINE PStatClientImpl *get_impl();
@@ -244,6 +254,14 @@ private:
 
   static PStatClient *_global_pstats;
 
+  class FrameLevelFuncs {
+  public:
+    FrameLevelFunc *_flush_func;
+    FrameLevelFunc *_clear_func;
+  };
+  typedef pvector<FrameLevelFuncs> FrameLevelFuncsList;
+  static FrameLevelFuncsList *_frame_level_funcs;
+
   friend class Collector;
   friend class PStatCollector;
   friend class PStatThread;
@@ -267,6 +285,12 @@ PUBLISHED:
 
   INLINE static void main_tick() { }
   INLINE static void thread_tick(const string &) { }
+
+public:
+  typedef void FrameLevelFunc();
+  INLINE static void add_frame_level_funcs(FrameLevelFunc *, FrameLevelFunc *) { }
+  INLINE static void flush_frame_levels() { }
+  INLINE static void clear_frame_levels() { }
 };
 
 #endif  // DO_PSTATS
@@ -169,6 +169,13 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "Geom cache operations:record",     { 0.2, 0.4, 0.8 } },
   { 1, "Geom cache operations:erase",      { 0.4, 0.8, 0.2 } },
   { 1, "Geom cache operations:evict",      { 0.8, 0.2, 0.4 } },
+  { 1, "Texture streaming",                { 0.7, 0.3, 0.9 },  "", 500 },
+  { 1, "Texture streaming:Resident",       { 0.9, 0.6, 0.2 },  "MB", 64, 1048576 },
+  { 1, "Texture streaming:Textures",       { 0.3, 0.7, 0.9 } },
+  { 1, "Texture streaming:Pending",        { 0.9, 0.9, 0.3 } },
+  { 1, "Texture streaming operations",     { 0.5, 0.9, 0.7 },  "", 50 },
+  { 1, "Texture streaming operations:request", { 0.2, 0.4, 0.8 } },
+  { 1, "Texture streaming operations:evict",   { 0.8, 0.2, 0.4 } },
   { 1, "Data transferred",                 { 0.0, 0.2, 0.4 },  "MB", 12, 1048576 },
   { 1, "Primitive batches",                { 0.2, 0.5, 0.9 },  "", 500 },
   { 1, "Primitive batches:Other",          { 0.2, 0.2, 0.2 } },
@@ -197,6 +204,20 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "State changes:Textures",           { 0.8, 0.2, 0.2 } },
   { 1, "Occlusion tests",                  { 0.9, 0.8, 0.3 },  "", 500.0 },
   { 1, "Occlusion results",                { 0.3, 0.9, 0.8 },  "", 500.0 },
+  { 1, "Cull cache",                       { 0.6, 0.9, 0.4 },  "", 50.0 },
+  { 1, "Cull cache:Hits",                  { 0.2, 0.8, 0.2 } },
+  { 1, "Cull cache:Misses",                { 0.9, 0.3, 0.1 } },
+  { 1, "Cull cache:Expired",               { 0.4, 0.4, 0.8 } },
+  { 1, "Bounds updates",                   { 0.8, 0.6, 0.2 },  "", 500.0 },
+  { 1, "Bounds updates:Full",              { 0.9, 0.3, 0.2 } },
+  { 1, "Bounds updates:Incremental",       { 0.3, 0.8, 0.3 } },
+  { 1, "Bounds updates:Child reads",       { 0.3, 0.5, 0.9 } },
+  { 1, "Animation LOD",                    { 0.9, 0.5, 0.9 },  "", 200.0 },
+  { 1, "Animation poses",                  { 0.5, 0.9, 0.9 },  "", 200.0 },
+  { 1, "Animation poses:Evaluated",        { 0.2, 0.6, 0.9 } },
+  { 1, "Animation poses:Shared",           { 0.9, 0.7, 0.2 } },
+  { 1, "Task steals",                      { 0.7, 0.3, 0.5 },  "", 100.0 },
+  { 1, "Task queue depth",                 { 0.3, 0.7, 0.7 },  "", 50.0 },
   { 1, "System memory",                    { 0.5, 1.0, 0.5 },  "MB", 64, 1048576 },
   { 1, "System memory:Heap",               { 0.2, 0.2, 1.0 } },
   { 1, "System memory:Heap:Overhead",      { 0.3, 0.4, 0.6 } },
@@ -74,6 +74,14 @@ BamCache() :
               "by the GSG.  This may be set in conjunction with "
               "model-cache-textures, or it may be independent."));
 
+  ConfigVariableBool model_cache_munged_geoms
+    ("model-cache-munged-geoms", false,
+     PRC_DESC("If this is set to true, the vertex data of static geometry "
+              "will be cached in the model cache after it has been "
+              "converted into the format preferred by the GSG, so that it "
+              "need not be converted again the next time the same model is "
+              "rendered on the same kind of GSG."));
+
   ConfigVariableInt model_cache_max_kbytes
     ("model-cache-max-kbytes", 1048576,
      PRC_DESC("This is the maximum size of the model cache, in kilobytes."));
@@ -81,6 +89,7 @@ BamCache() :
   _cache_models = model_cache_models;
   _cache_textures = model_cache_textures;
   _cache_compressed_textures = model_cache_compressed_textures;
+  _cache_munged_geoms = model_cache_munged_geoms;
 
   _flush_time = model_cache_flush;
   _max_kbytes = model_cache_max_kbytes;
@@ -59,6 +59,9 @@ PUBLISHED:
   INLINE void set_cache_compressed_textures(bool flag);
   INLINE bool get_cache_compressed_textures() const;
 
+  INLINE void set_cache_munged_geoms(bool flag);
+  INLINE bool get_cache_munged_geoms() const;
+
   void set_root(const Filename &root);
   INLINE Filename get_root() const;
 
@@ -113,6 +116,7 @@ private:
   bool _cache_models;
   bool _cache_textures;
   bool _cache_compressed_textures;
+  bool _cache_munged_geoms;
   bool _read_only;
   Filename _root;
   int _flush_time;
@@ -0,0 +1,183 @@
+// Filename: bamDecodeQueue.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "bamDecodeQueue.h"
+#include "config_util.h"
+#include "mutexHolder.h"
+
+BamDecodeQueue *BamDecodeQueue::_global_ptr = NULL;
+Mutex BamDecodeQueue::_global_lock("BamDecodeQueue::_global_lock");
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::DecodeThread::Constructor
+//       Access: Public
+//  Description:
+////////////////////////////////////////////////////////////////////
+BamDecodeQueue::DecodeThread::
+DecodeThread(BamDecodeQueue *queue) :
+  Thread("BamDecodeThread", "BamDecodeThread"),
+  _queue(queue)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::DecodeThread::thread_main
+//       Access: Public, Virtual
+//  Description:
+////////////////////////////////////////////////////////////////////
+void BamDecodeQueue::DecodeThread::
+thread_main() {
+  _queue->thread_run();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::Constructor
+//       Access: Protected
+//  Description: Starts the indicated number of worker threads.  The
+//               threads are never stopped; they sleep while there is
+//               nothing to decode.
+////////////////////////////////////////////////////////////////////
+BamDecodeQueue::
+BamDecodeQueue(int num_threads) :
+  _lock("BamDecodeQueue::_lock"),
+  _cvar(_lock)
+{
+  for (int i = 0; i < num_threads; ++i) {
+    PT(DecodeThread) thread = new DecodeThread(this);
+    _threads.push_back(thread);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    _threads[i]->start(TP_normal, false);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::get_global_ptr
+//       Access: Public, Static
+//  Description: Returns the queue shared by all BamReaders, creating
+//               it and its threads the first time it is needed.
+//               Returns NULL if parallel decoding is not available;
+//               see is_parallel_decode_available().
+////////////////////////////////////////////////////////////////////
+BamDecodeQueue *BamDecodeQueue::
+get_global_ptr() {
+  if (!is_parallel_decode_available()) {
+    return NULL;
+  }
+
+  MutexHolder holder(_global_lock);
+  if (_global_ptr == (BamDecodeQueue *)NULL) {
+    _global_ptr = new BamDecodeQueue(bam_decode_threads);
+  }
+  return _global_ptr;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::is_parallel_decode_available
+//       Access: Public, Static
+//  Description: Returns true if the payloads of a bam file may be
+//               decoded on worker threads: that is, if threading is
+//               supported and bam-decode-threads is greater than
+//               zero.
+////////////////////////////////////////////////////////////////////
+bool BamDecodeQueue::
+is_parallel_decode_available() {
+  return Thread::is_threading_supported() && bam_decode_threads > 0;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::add_job
+//       Access: Public
+//  Description: Adds the job to the end of the queue.  The next idle
+//               worker thread will decode it.
+////////////////////////////////////////////////////////////////////
+void BamDecodeQueue::
+add_job(BamReader::DecodeJob *job) {
+  MutexHolder holder(_lock);
+  nassertv(job->_state == BamReader::DecodeJob::S_new);
+  job->_state = BamReader::DecodeJob::S_queued;
+  _jobs.push_back(job);
+  _cvar.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::wait_for_job
+//       Access: Public
+//  Description: Blocks until the indicated job, which must have been
+//               added with add_job(), has been decoded.  If no worker
+//               has started on it yet, the calling thread decodes it
+//               itself rather than waiting.
+////////////////////////////////////////////////////////////////////
+void BamDecodeQueue::
+wait_for_job(BamReader::DecodeJob *job) {
+  MutexHolder holder(_lock);
+  if (job->_state == BamReader::DecodeJob::S_queued) {
+    // The job stays in _jobs; the workers will skip it.
+    run_job(job);
+  }
+  while (job->_state != BamReader::DecodeJob::S_done) {
+    _cvar.wait();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::is_job_done
+//       Access: Public
+//  Description: Returns true if the indicated job, which must have
+//               been added with add_job(), has finished decoding, so
+//               that wait_for_job() would return immediately.
+////////////////////////////////////////////////////////////////////
+bool BamDecodeQueue::
+is_job_done(BamReader::DecodeJob *job) {
+  MutexHolder holder(_lock);
+  return (job->_state == BamReader::DecodeJob::S_done);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::thread_run
+//       Access: Private
+//  Description: The main loop of each worker thread.
+////////////////////////////////////////////////////////////////////
+void BamDecodeQueue::
+thread_run() {
+  MutexHolder holder(_lock);
+  while (true) {
+    while (_jobs.empty()) {
+      _cvar.wait();
+    }
+
+    PT(BamReader::DecodeJob) job = _jobs.front();
+    _jobs.pop_front();
+    if (job->_state == BamReader::DecodeJob::S_queued) {
+      run_job(job);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamDecodeQueue::run_job
+//       Access: Private
+//  Description: Decodes the job, which must be in the queued state.
+//               _lock must be held on entry; it is released while the
+//               job is decoding.
+////////////////////////////////////////////////////////////////////
+void BamDecodeQueue::
+run_job(BamReader::DecodeJob *job) {
+  job->_state = BamReader::DecodeJob::S_running;
+  _lock.release();
+  job->decode();
+  _lock.acquire();
+  job->_state = BamReader::DecodeJob::S_done;
+  _cvar.notify_all();
+}
@@ -0,0 +1,82 @@
+// Filename: bamDecodeQueue.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef BAMDECODEQUEUE_H
+#define BAMDECODEQUEUE_H
+
+#include "pandabase.h"
+#include "bamReader.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "conditionVarFull.h"
+#include "pdeque.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : BamDecodeQueue
+// Description : The pool of worker threads, shared by all BamReaders
+//               in the process, that decode the large payloads of
+//               objects (vertex arrays, texture images) read from a
+//               bam file with LoaderOptions::LF_parallel_decode,
+//               while the reading thread goes on reading and
+//               resolving the rest of the file.
+//
+//               The number of threads is given by bam-decode-threads.
+//               A BamReader should not normally use this class
+//               directly; see BamReader::queue_decode().
+////////////////////////////////////////////////////////////////////
+class EXPCL_PANDA_PUTIL BamDecodeQueue {
+protected:
+  BamDecodeQueue(int num_threads);
+
+public:
+  static BamDecodeQueue *get_global_ptr();
+  static bool is_parallel_decode_available();
+
+  INLINE int get_num_threads() const;
+
+  void add_job(BamReader::DecodeJob *job);
+  void wait_for_job(BamReader::DecodeJob *job);
+  bool is_job_done(BamReader::DecodeJob *job);
+
+private:
+  void thread_run();
+  void run_job(BamReader::DecodeJob *job);
+
+  class DecodeThread : public Thread {
+  public:
+    DecodeThread(BamDecodeQueue *queue);
+    virtual void thread_main();
+
+    BamDecodeQueue *_queue;
+  };
+
+  typedef pdeque< PT(BamReader::DecodeJob) > Jobs;
+  Jobs _jobs;
+
+  typedef pvector< PT(DecodeThread) > Threads;
+  Threads _threads;
+
+  // _lock protects _jobs and the _state of every job.  _cvar is
+  // notified both when a job is added and when a job is done.
+  Mutex _lock;
+  ConditionVarFull _cvar;
+
+  static BamDecodeQueue *_global_ptr;
+  static Mutex _global_lock;
+};
+
+#include "bamDecodeQueue.I"
+
+#endif
@@ -17,6 +17,7 @@
 
 #include "bam.h"
 #include "bamReader.h"
+#include "bamDecodeQueue.h"
 #include "datagramIterator.h"
 #include "config_util.h"
 #include "pipelineCyclerBase.h"
@@ -48,6 +49,9 @@ BamReader(DatagramGenerator *generator, const Filename &name)
   _pta_id = -1;
   _long_object_id = false;
   _long_pta_id = false;
+  _decode_queue = (BamDecodeQueue *)NULL;
+  _tried_mapping = false;
+  _payload_end = 0;
 }
 
 
@@ -58,6 +62,10 @@ BamReader(DatagramGenerator *generator, const Filename &name)
 ////////////////////////////////////////////////////////////////////
 BamReader::
 ~BamReader() {
+  // Finish any jobs not yet completed, in case the file was not
+  // finalized, so that their objects are not left with missing data
+  // and no worker is left decoding into them.
+  wait_for_all_decode();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -235,6 +243,11 @@ read_object() {
     _num_extra_objects--;
   }
 
+  // Hand over the data of any objects whose decoding has finished
+  // in the meantime, rather than holding it until the file is
+  // finalized.
+  complete_finished_decodes();
+
   // Now look up the pointer of the object we read first.  It should
   // be available now.
   if (object_id == 0) {
@@ -709,6 +722,7 @@ register_change_this(ChangeThisFunc func, TypedWritable *object) {
 void BamReader::
 finalize_now(TypedWritable *whom) {
   nassertv(whom != (TypedWritable *)NULL);
+  wait_for_decode(whom);
 
   Finalize::iterator fi = _finalize_list.find(whom);
   if (fi != _finalize_list.end()) {
@@ -722,6 +736,166 @@ finalize_now(TypedWritable *whom) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::read_payload
+//       Access: Public
+//  Description: Should be called by an object's fillin() function to
+//               read a block of raw data that was written with
+//               BamWriter::write_payload().  The payload references
+//               the data where it lies; call payload.extract_data()
+//               to copy it out.
+//
+//               If the payload was written in an aligned section and
+//               the bam file could be mapped into memory (see
+//               bam-map-payloads), the payload refers directly to the
+//               mapped file; otherwise the section is read from the
+//               file now.
+//
+//               Files older than bam 6.21 stored such data as a
+//               32-bit size followed by the bytes; read_payload()
+//               reads that form too.  Returns true on success, false
+//               if the data could not be read.
+////////////////////////////////////////////////////////////////////
+bool BamReader::
+read_payload(DatagramIterator &scan, BamReader::Payload &payload) {
+  payload.clear();
+
+  PayloadMode mode = PM_inline;
+  if (_file_minor >= 21) {
+    mode = (PayloadMode)scan.get_uint8();
+  }
+  size_t size = scan.get_uint32();
+
+  if (mode == PM_inline) {
+    nassertr((size_t)scan.get_remaining_size() >= size, false);
+    payload._datagram = scan.get_datagram();
+    payload._start = scan.get_current_index();
+    payload._size = size;
+    scan.skip_bytes(size);
+    return true;
+  }
+
+  nassertr(mode == PM_aligned, false);
+  size_t alignment = scan.get_uint32();
+  nassertr(alignment != 0, false);
+
+  if (!_source->supports_raw_data()) {
+    bam_cat.error()
+      << "Bam source cannot read aligned payload sections.\n";
+    return false;
+  }
+
+  streamoff source_pos = _source->get_raw_pos();
+  streamoff pos = max(source_pos, _payload_end);
+  streamoff start = ((pos + (streamoff)alignment - 1) / (streamoff)alignment) * (streamoff)alignment;
+
+  MappedFile *mapped_file = get_mapped_file();
+  if (mapped_file != (MappedFile *)NULL) {
+    if ((size_t)start + size > mapped_file->get_size()) {
+      bam_cat.error()
+        << "Payload extends beyond the end of " << mapped_file->get_filename()
+        << ".\n";
+      return false;
+    }
+
+    // Reference the section in place.  get_datagram() will skip over
+    // it before reading the next object.
+    payload._mapped_file = mapped_file;
+    payload._start = (size_t)start;
+    payload._size = size;
+    _payload_end = start + (streamoff)size;
+    return true;
+  }
+
+  // We can't map the file, so read the section now.
+  if (!skip_payloads() ||
+      !_source->skip_raw_data((size_t)(start - _source->get_raw_pos()))) {
+    return false;
+  }
+  PTA_uchar data = PTA_uchar::empty_array(size);
+  if (size != 0 && !_source->get_raw_data(data.p(), size)) {
+    bam_cat.error()
+      << "Unable to read payload of " << size << " bytes.\n";
+    return false;
+  }
+  payload._datagram.set_array(data);
+  payload._start = 0;
+  payload._size = size;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::queue_decode
+//       Access: Public
+//  Description: Should be called by an object's fillin() function to
+//               hand off the decoding of a large block of its data,
+//               of the indicated size in bytes.
+//
+//               If the LoaderOptions include LF_parallel_decode, and
+//               the block is at least bam-decode-min-size bytes, the
+//               job is decoded on one of the BamDecodeQueue's worker
+//               threads while this thread goes on reading the file;
+//               its complete() will be called by the first
+//               read_object() call to find it finished, or, if it has
+//               not finished by then, just before the object's
+//               complete_pointers() or finalize(), or at the latest
+//               when the file is finalized.  Otherwise, the
+//               job is decoded immediately; but since the object is
+//               still being read, it is completed at the same point
+//               it would have been had it been decoded on another
+//               thread.
+////////////////////////////////////////////////////////////////////
+void BamReader::
+queue_decode(TypedWritable *whom, BamReader::DecodeJob *job,
+             size_t num_bytes) {
+  PT(DecodeJob) job_ref = job;
+
+  if ((_loader_options.get_flags() & LoaderOptions::LF_parallel_decode) != 0 &&
+      num_bytes >= (size_t)bam_decode_min_size) {
+    if (_decode_queue == (BamDecodeQueue *)NULL) {
+      _decode_queue = BamDecodeQueue::get_global_ptr();
+    }
+    if (_decode_queue != (BamDecodeQueue *)NULL) {
+      _decode_queue->add_job(job);
+      _decode_jobs[whom].push_back(job);
+      return;
+    }
+  }
+
+  job->decode();
+  job->_state = DecodeJob::S_done;
+  _decode_jobs[whom].push_back(job);
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::wait_for_decode
+//       Access: Public
+//  Description: Waits for all of the jobs queued via queue_decode()
+//               for the indicated object to finish decoding, and
+//               completes them.  An object that needs its data
+//               earlier than its complete_pointers() may call this
+//               explicitly.
+////////////////////////////////////////////////////////////////////
+void BamReader::
+wait_for_decode(TypedWritable *whom) {
+  DecodeJobs::iterator di = _decode_jobs.find(whom);
+  if (di == _decode_jobs.end()) {
+    return;
+  }
+
+  DecodeJobList jobs;
+  jobs.swap((*di).second);
+  _decode_jobs.erase(di);
+
+  DecodeJobList::iterator ji;
+  for (ji = jobs.begin(); ji != jobs.end(); ++ji) {
+    if (_decode_queue != (BamDecodeQueue *)NULL) {
+      _decode_queue->wait_for_job(*ji);
+    }
+    (*ji)->complete(this);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: BamReader::get_pta
 //       Access: Public
@@ -975,6 +1149,7 @@ p_read_object() {
       // immediately.
       ObjectPointers::const_iterator ri = _object_pointers.find(object_id);
       if (ri == _object_pointers.end()) {
+        wait_for_decode(object);
         object = created_obj._change_this(object, this);
         created_obj._ptr = object;
         created_obj._change_this = NULL;
@@ -1121,6 +1296,10 @@ resolve_object_pointers(TypedWritable *object,
         << " (" << object->get_type() << "), " << references.size()
         << " pointers.\n";
     }
+    // The object may not look at its own data until that has been
+    // decoded.
+    wait_for_decode(object);
+
     int num_completed = 0;
     if (!references.empty()) {
       num_completed = object->complete_pointers(&references[0], this);
@@ -1235,6 +1414,8 @@ finalize() {
       << "Finalizing bam source\n";
   }
 
+  wait_for_all_decode();
+
   Finalize::iterator fi = _finalize_list.begin();
   while (fi != _finalize_list.end()) {
     TypedWritable *object = (*fi);
@@ -1270,6 +1451,104 @@ finalize() {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::wait_for_all_decode
+//       Access: Private
+//  Description: Waits for and completes all of the outstanding jobs
+//               queued via queue_decode().
+////////////////////////////////////////////////////////////////////
+void BamReader::
+wait_for_all_decode() {
+  while (!_decode_jobs.empty()) {
+    wait_for_decode((*_decode_jobs.begin()).first);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::complete_finished_decodes
+//       Access: Private
+//  Description: Completes the jobs queued via queue_decode() that
+//               have already finished decoding, without waiting for
+//               the others.  The jobs for each object are completed
+//               in the order they were queued.
+////////////////////////////////////////////////////////////////////
+void BamReader::
+complete_finished_decodes() {
+  DecodeJobList done;
+
+  DecodeJobs::iterator di = _decode_jobs.begin();
+  while (di != _decode_jobs.end()) {
+    DecodeJobList &jobs = (*di).second;
+    DecodeJobList::iterator ji = jobs.begin();
+    while (ji != jobs.end()) {
+      bool is_done;
+      if (_decode_queue != (BamDecodeQueue *)NULL) {
+        is_done = _decode_queue->is_job_done(*ji);
+      } else {
+        is_done = ((*ji)->_state == DecodeJob::S_done);
+      }
+      if (!is_done) {
+        break;
+      }
+      done.push_back(*ji);
+      ++ji;
+    }
+    jobs.erase(jobs.begin(), ji);
+
+    if (jobs.empty()) {
+      DecodeJobs::iterator dnext = di;
+      ++dnext;
+      _decode_jobs.erase(di);
+      di = dnext;
+    } else {
+      ++di;
+    }
+  }
+
+  DecodeJobList::iterator ji;
+  for (ji = done.begin(); ji != done.end(); ++ji) {
+    (*ji)->complete(this);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::skip_payloads
+//       Access: Private
+//  Description: Advances the source past any mapped payload sections
+//               that read_payload() has referenced but not read.
+//               Returns true on success, false on failure.
+////////////////////////////////////////////////////////////////////
+bool BamReader::
+skip_payloads() {
+  streamoff source_pos = _source->get_raw_pos();
+  if (_payload_end > source_pos &&
+      !_source->skip_raw_data((size_t)(_payload_end - source_pos))) {
+    bam_cat.error()
+      << "Unable to skip payload data.\n";
+    return false;
+  }
+  _payload_end = 0;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::get_mapped_file
+//       Access: Private
+//  Description: Returns the bam file mapped into memory, mapping it
+//               the first time this is called, or NULL if the file
+//               cannot or should not be mapped.
+////////////////////////////////////////////////////////////////////
+MappedFile *BamReader::
+get_mapped_file() {
+  if (!_tried_mapping) {
+    _tried_mapping = true;
+    if (bam_map_payloads) {
+      _mapped_file = MappedFile::map_virtual_file(_source->get_file());
+    }
+  }
+  return _mapped_file;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: BamReader::AuxData::Destructor
 //       Access: Public, Virtual
@@ -1279,3 +1558,24 @@ BamReader::AuxData::
 ~AuxData() {
 }
 
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::DecodeJob::Destructor
+//       Access: Public, Virtual
+//  Description: 
+////////////////////////////////////////////////////////////////////
+BamReader::DecodeJob::
+~DecodeJob() {
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: BamReader::DecodeJob::complete
+//       Access: Public, Virtual
+//  Description: Called on the reading thread after decode() has
+//               finished, to store the decoded data into the object.
+//               The default does nothing, for jobs that decode
+//               directly into storage they share with the object.
+////////////////////////////////////////////////////////////////////
+void BamReader::DecodeJob::
+complete(BamReader *) {
+}
@@ -30,9 +30,11 @@
 #include "pmap.h"
 #include "dcast.h"
 #include "pipelineCyclerBase.h"
+#include "mappedFile.h"
 
 #include <algorithm>
 
+class BamDecodeQueue;
 
 // A handy macro for reading PointerToArrays.
 #define READ_PTA(Manager, source, Read_func, array)   \
@@ -131,6 +133,13 @@ public:
 
   void register_finalize(TypedWritable *whom);
 
+  class Payload;
+  bool read_payload(DatagramIterator &scan, Payload &payload);
+
+  class DecodeJob;
+  void queue_decode(TypedWritable *whom, DecodeJob *job, size_t num_bytes);
+  void wait_for_decode(TypedWritable *whom);
+
   typedef TypedWritable *(*ChangeThisFunc)(TypedWritable *object, BamReader *manager);
   void register_change_this(ChangeThisFunc func, TypedWritable *whom);
 
@@ -160,8 +169,12 @@ private:
   bool resolve_cycler_pointers(PipelineCyclerBase *cycler, const vector_int &pointer_ids,
                                bool require_fully_complete);
   void finalize();
+  void wait_for_all_decode();
+  void complete_finished_decodes();
 
   INLINE bool get_datagram(Datagram &datagram);
+  bool skip_payloads();
+  MappedFile *get_mapped_file();
 
 public:
   // This special TypeHandle is written to the bam file to indicate an
@@ -177,6 +190,67 @@ public:
     virtual ~AuxData();
   };
 
+  // These values are written by BamWriter::write_payload() to
+  // indicate where a payload's data is stored.
+  enum PayloadMode {
+    PM_inline,   // In the object's datagram, following the size.
+    PM_aligned,  // Following the object's datagram, aligned.
+  };
+
+  // A large block of raw data, such as a vertex array, read via
+  // read_payload().  It references the data where it already lies,
+  // either in the datagram or in the memory-mapped bam file, so it may
+  // be kept and copied out later, on any thread.
+  class EXPCL_PANDA_PUTIL Payload {
+  public:
+    INLINE Payload();
+
+    INLINE size_t get_size() const;
+    INLINE const unsigned char *get_data() const;
+    INLINE void extract_data(unsigned char *dest) const;
+
+    INLINE bool is_mapped() const;
+    INLINE MappedFile *get_mapped_file() const;
+    INLINE size_t get_mapped_start() const;
+
+    INLINE void clear();
+
+  private:
+    Datagram _datagram;
+    PT(MappedFile) _mapped_file;
+    size_t _start;
+    size_t _size;
+
+    friend class BamReader;
+  };
+
+  // Inherit from this class to decode a large part of an object's
+  // data, such as a vertex array or a texture image, off the reading
+  // thread (via queue_decode()).  decode() may be called on any
+  // thread; it should touch only data owned by the job itself.
+  // complete() is then called on the reading thread, before the
+  // object's pointers are completed.
+  class EXPCL_PANDA_PUTIL DecodeJob : public ReferenceCount {
+  public:
+    INLINE DecodeJob();
+    virtual ~DecodeJob();
+
+    virtual void decode()=0;
+    virtual void complete(BamReader *manager);
+
+  private:
+    enum State {
+      S_new,
+      S_queued,
+      S_running,
+      S_done,
+    };
+    State _state;
+
+    friend class BamReader;
+    friend class BamDecodeQueue;
+  };
+
 private:
   static WritableFactory *_factory;
 
@@ -258,6 +332,20 @@ private:
   typedef phash_map<TypedWritable *, AuxDataNames, pointer_hash> AuxDataTable;
   AuxDataTable _aux_data;
 
+  // The DecodeJobs queued for each object that have not yet been
+  // completed.  _decode_queue is NULL until the first job is queued.
+  typedef pvector<PT(DecodeJob)> DecodeJobList;
+  typedef phash_map<TypedWritable *, DecodeJobList, pointer_hash> DecodeJobs;
+  DecodeJobs _decode_jobs;
+  BamDecodeQueue *_decode_queue;
+
+  // The bam file mapped into memory, if its payloads are to be
+  // referenced in place.  _payload_end is the raw position just past
+  // the last payload read; get_datagram() first skips up to it.
+  PT(MappedFile) _mapped_file;
+  bool _tried_mapping;
+  streamoff _payload_end;
+
   int _file_major, _file_minor;
   BamEndian _file_endian;
   static const int _cur_major;
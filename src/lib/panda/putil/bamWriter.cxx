@@ -78,6 +78,7 @@ init() {
 
   _file_endian = bam_endian;
   _file_texture_mode = bam_texture_mode;
+  _aligned_payloads = bam_aligned_payloads;
 
   // Write out the current major and minor BAM file version numbers.
   Datagram header;
@@ -214,6 +215,12 @@ write_object(const TypedWritable *object) {
         << "Unable to write data to output.\n";
       return false;
     }
+
+    if (!_pending_payloads.empty() && !write_pending_payloads()) {
+      util_cat.error()
+        << "Unable to write data to output.\n";
+      return false;
+    }
   }
 
   return true;
@@ -407,6 +414,37 @@ write_handle(Datagram &packet, TypeHandle type) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: BamWriter::write_payload
+//       Access: Public
+//  Description: Writes a large block of raw data, such as a vertex
+//               array or a texture image, on behalf of the object
+//               currently being written.  It should be read back
+//               with BamReader::read_payload().
+//
+//               If set_aligned_payloads() is in effect and the
+//               BamWriter is writing to a file, the data itself is
+//               written after the object's record, starting on an
+//               aligned boundary in the file, and only its size is
+//               added to the datagram.  Otherwise, the data is
+//               appended to the datagram.  Either way, the data is
+//               copied before this method returns.
+////////////////////////////////////////////////////////////////////
+void BamWriter::
+write_payload(Datagram &packet, const unsigned char *data, size_t size) {
+  if (_aligned_payloads && _target->supports_raw_data()) {
+    packet.add_uint8(BamReader::PM_aligned);
+    packet.add_uint32(size);
+    packet.add_uint32(max((int)bam_payload_alignment, 1));
+    _pending_payloads.push_back(Datagram(data, size));
+
+  } else {
+    packet.add_uint8(BamReader::PM_inline);
+    packet.add_uint32(size);
+    packet.append_data(data, size);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: BamWriter::object_destructs
 //       Access: Private
@@ -471,6 +509,39 @@ write_pta_id(Datagram &dg, int pta_id) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: BamWriter::write_pending_payloads
+//       Access: Private
+//  Description: Writes the payloads queued by write_payload() while
+//               writing the object whose datagram was just written,
+//               each padded to begin on a bam-payload-alignment
+//               boundary.  Returns true on success, false on failure.
+////////////////////////////////////////////////////////////////////
+bool BamWriter::
+write_pending_payloads() {
+  size_t alignment = (size_t)max((int)bam_payload_alignment, 1);
+  static const unsigned char zeros[1024] = { 0 };
+
+  bool success = true;
+  Payloads::const_iterator pi;
+  for (pi = _pending_payloads.begin(); pi != _pending_payloads.end() && success; ++pi) {
+    size_t padding = (alignment - (size_t)(_target->get_raw_pos() % alignment)) % alignment;
+    while (padding > 0 && success) {
+      size_t count = min(padding, sizeof(zeros));
+      success = _target->put_raw_data(zeros, count);
+      padding -= count;
+    }
+
+    const Datagram &payload = (*pi);
+    if (success && payload.get_length() != 0) {
+      success = _target->put_raw_data((const unsigned char *)payload.get_data(),
+                                      payload.get_length());
+    }
+  }
+  _pending_payloads.clear();
+  return success;
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: BamWriter::enqueue_object
 //       Access: Private
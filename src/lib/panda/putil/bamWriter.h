@@ -22,6 +22,7 @@
 #include "typedWritable.h"
 #include "datagramSink.h"
 #include "pdeque.h"
+#include "pvector.h"
 #include "pset.h"
 #include "pmap.h"
 #include "vector_int.h"
@@ -86,6 +87,9 @@ PUBLISHED:
   INLINE BamTextureMode get_file_texture_mode() const;
   INLINE void set_file_texture_mode(BamTextureMode file_texture_mode);
 
+  INLINE bool get_aligned_payloads() const;
+  INLINE void set_aligned_payloads(bool aligned_payloads);
+
 public:
   // Functions to support classes that write themselves to the Bam.
 
@@ -95,6 +99,7 @@ public:
                    void *extra_data);
   bool register_pta(Datagram &packet, const void *ptr);
   void write_handle(Datagram &packet, TypeHandle type);
+  void write_payload(Datagram &packet, const unsigned char *data, size_t size);
 
 private:
   void object_destructs(TypedWritable *object);
@@ -102,12 +107,14 @@ private:
   void write_object_id(Datagram &dg, int object_id);
   void write_pta_id(Datagram &dg, int pta_id);
   int enqueue_object(const TypedWritable *object);
+  bool write_pending_payloads();
 
   // This is the filename of the BAM, or null string if not in a file.
   Filename _filename;
 
   BamEndian _file_endian;
   BamTextureMode _file_texture_mode;
+  bool _aligned_payloads;
 
   // This is the set of all TypeHandles already written.
   pset<int, int_hash> _types_written;
@@ -148,6 +155,11 @@ private:
   bool _long_pta_id;
 
   // The destination to write all the output to.
+  // The payloads added by write_payload() to the object currently
+  // being written, which will follow its datagram in the file.
+  typedef pvector<Datagram> Payloads;
+  Payloads _pending_payloads;
+
   DatagramSink *_target;
 
   friend class TypedWritable;
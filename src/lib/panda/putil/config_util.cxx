@@ -133,6 +133,52 @@ ConfigVariableBool preload_simple_textures
           "in a sub-thread.  It's not generally necessary if you are "
           "loading bam files that were generated via egg2bam."));
 
+ConfigVariableBool bam_parallel_decode
+("bam-parallel-decode", false,
+ PRC_DESC("When this is true, LoaderOptions include LF_parallel_decode "
+          "by default, so that the large vertex arrays and texture "
+          "images in a bam file are decoded on the bam-decode-threads "
+          "while the rest of the file is read."));
+
+ConfigVariableInt bam_decode_threads
+("bam-decode-threads", 4,
+ PRC_DESC("The number of worker threads shared by all bam files loaded "
+          "with LF_parallel_decode.  Set this to 0 to decode everything "
+          "on the loading thread."));
+
+ConfigVariableInt bam_decode_min_size
+("bam-decode-min-size", 65536,
+ PRC_DESC("The smallest block of data, in bytes, that will be handed to "
+          "a bam decode thread when LF_parallel_decode is in effect.  "
+          "Smaller blocks are decoded on the loading thread, since the "
+          "handoff would cost more than it saves."));
+
+ConfigVariableBool bam_aligned_payloads
+("bam-aligned-payloads", false,
+ PRC_DESC("When this is true, bam files are written with the large "
+          "vertex arrays and texture images stored outside of their "
+          "objects' records, each starting on a bam-payload-alignment "
+          "boundary within the file.  Such files may be loaded by "
+          "mapping those sections directly into memory; see "
+          "bam-map-payloads.  This setting is used only when writing "
+          "a bam file."));
+
+ConfigVariableInt bam_payload_alignment
+("bam-payload-alignment", 4096,
+ PRC_DESC("The alignment, in bytes, of each payload section written when "
+          "bam-aligned-payloads is in effect.  This should be a multiple "
+          "of the virtual memory page size."));
+
+ConfigVariableBool bam_map_payloads
+("bam-map-payloads", true,
+ PRC_DESC("When this is true, a bam file written with bam-aligned-payloads "
+          "that is read from a plain file on disk is mapped into memory, "
+          "and its vertex arrays reference the mapped file in place "
+          "rather than being copied; the operating system pages them "
+          "in as they are used.  When this is false, or the file is "
+          "compressed or within a multifile, the payloads are read and "
+          "copied as usual."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libputil
 //  Description: Initializes the library.  This must be called at
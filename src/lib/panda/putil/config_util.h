@@ -20,6 +20,7 @@
 #include "configVariableSearchPath.h"
 #include "configVariableEnum.h"
 #include "configVariableDouble.h"
+#include "configVariableInt.h"
 #include "bamEndian.h"
 #include "bamTextureMode.h"
 #include "dconfig.h"
@@ -49,6 +50,13 @@ extern ConfigVariableDouble sleep_precision;
 extern EXPCL_PANDA_PUTIL ConfigVariableBool preload_textures;
 extern EXPCL_PANDA_PUTIL ConfigVariableBool preload_simple_textures;
 
+extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_parallel_decode;
+extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_decode_threads;
+extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_decode_min_size;
+extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_aligned_payloads;
+extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_payload_alignment;
+extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_map_payloads;
+
 extern EXPCL_PANDA_PUTIL void init_libputil();
 
 #endif /* __CONFIG_UTIL_H__ */
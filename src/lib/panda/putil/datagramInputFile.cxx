@@ -84,6 +84,7 @@ close() {
 
   _read_first_datagram = false;
   _error = false;
+  _raw_pos = 0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -109,6 +110,7 @@ read_header(string &header, size_t num_bytes) {
   }
 
   header = string(buffer, num_bytes);
+  _raw_pos += num_bytes;
   Thread::consider_yield();
   return true;
 }
@@ -131,6 +133,7 @@ get_datagram(Datagram &data) {
   if (_in->fail() || _in->eof()) {
     return false;
   }
+  _raw_pos += sizeof(num_bytes);
 
   if (num_bytes == 0) {
     // A special case for a zero-length datagram: no need to try to
@@ -170,6 +173,7 @@ get_datagram(Datagram &data) {
 
     data = Datagram(buffer, num_bytes);
   }
+  _raw_pos += num_bytes;
   Thread::consider_yield();
 
   return true;
@@ -236,3 +240,80 @@ get_file_pos() {
   }
   return _in->tellg();
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramInputFile::supports_raw_data
+//       Access: Public, Virtual
+//  Description: Returns true: a DatagramInputFile can read raw data
+//               between datagrams.
+////////////////////////////////////////////////////////////////////
+bool DatagramInputFile::
+supports_raw_data() {
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramInputFile::get_raw_pos
+//       Access: Public, Virtual
+//  Description: Returns the number of bytes read so far, including
+//               the header.  Unlike get_file_pos(), this counts
+//               uncompressed bytes if the file is a .pz file, so it
+//               always matches DatagramOutputFile::get_raw_pos() at
+//               the same point when the file was written.
+////////////////////////////////////////////////////////////////////
+streamoff DatagramInputFile::
+get_raw_pos() {
+  return _raw_pos;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramInputFile::get_raw_data
+//       Access: Public, Virtual
+//  Description: Reads the indicated number of bytes, written with
+//               DatagramOutputFile::put_raw_data(), into the buffer.
+//               Returns true on success, false on failure.
+////////////////////////////////////////////////////////////////////
+bool DatagramInputFile::
+get_raw_data(unsigned char *buffer, size_t size) {
+  nassertr(_in != (istream *)NULL, false);
+  _read_first_datagram = true;
+
+  _in->read((char *)buffer, size);
+  if (_in->fail() || _in->eof()) {
+    _error = true;
+    return false;
+  }
+  _raw_pos += size;
+  Thread::consider_yield();
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramInputFile::skip_raw_data
+//       Access: Public, Virtual
+//  Description: Skips over the indicated number of raw bytes.  For a
+//               plain file this is a seek; the skipped bytes are not
+//               read.  Returns true on success, false on failure.
+////////////////////////////////////////////////////////////////////
+bool DatagramInputFile::
+skip_raw_data(size_t size) {
+  nassertr(_in != (istream *)NULL, false);
+  if (size == 0) {
+    return true;
+  }
+  _read_first_datagram = true;
+
+  _in->seekg((streamoff)size, ios::cur);
+  if (_in->fail()) {
+    // Not every stream can seek (a decompression stream can't, for
+    // instance), so fall back to reading the bytes.
+    _in->clear();
+    _in->ignore((streamsize)size);
+    if (_in->fail() || (size_t)_in->gcount() != size) {
+      _error = true;
+      return false;
+    }
+  }
+  _raw_pos += size;
+  return true;
+}
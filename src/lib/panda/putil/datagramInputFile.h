@@ -44,6 +44,11 @@ public:
   virtual VirtualFile *get_file();
   virtual streampos get_file_pos();
 
+  virtual bool supports_raw_data();
+  virtual streamoff get_raw_pos();
+  virtual bool get_raw_data(unsigned char *buffer, size_t size);
+  virtual bool skip_raw_data(size_t size);
+
 private:
   bool _read_first_datagram;
   bool _error;
@@ -51,6 +56,7 @@ private:
   pifstream _in_file;
   istream *_in;
   bool _owns_in;
+  streamoff _raw_pos;
 };
 
 #include "datagramInputFile.I"
@@ -80,6 +80,7 @@ close() {
 
   _wrote_first_datagram = false;
   _error = false;
+  _raw_pos = 0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -97,6 +98,7 @@ write_header(const string &header) {
   nassertr(!_wrote_first_datagram, false);
 
   _out->write(header.data(), header.size());
+  _raw_pos += header.size();
   thread_consider_yield();
   return !_out->fail();
 }
@@ -118,6 +120,7 @@ put_datagram(const Datagram &data) {
 
   // Now, write the datagram itself.
   _out->write((const char *)data.get_data(), data.get_length());
+  _raw_pos += sizeof(PN_uint32) + data.get_length();
   thread_consider_yield();
 
   return !_out->fail();
@@ -140,3 +143,44 @@ is_error() {
   }
   return _error;
 }
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramOutputFile::supports_raw_data
+//       Access: Public, Virtual
+//  Description: Returns true: a DatagramOutputFile can write raw data
+//               between datagrams.
+////////////////////////////////////////////////////////////////////
+bool DatagramOutputFile::
+supports_raw_data() {
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramOutputFile::get_raw_pos
+//       Access: Public, Virtual
+//  Description: Returns the number of bytes written so far, including
+//               the header, before any compression.
+////////////////////////////////////////////////////////////////////
+streamoff DatagramOutputFile::
+get_raw_pos() {
+  return _raw_pos;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: DatagramOutputFile::put_raw_data
+//       Access: Public, Virtual
+//  Description: Writes the indicated bytes to the file as-is, with no
+//               length prefix.  Returns true on success, false if
+//               there is an error.
+////////////////////////////////////////////////////////////////////
+bool DatagramOutputFile::
+put_raw_data(const unsigned char *data, size_t size) {
+  nassertr(_out != (ostream *)NULL, false);
+  _wrote_first_datagram = true;
+
+  _out->write((const char *)data, size);
+  _raw_pos += size;
+  thread_consider_yield();
+
+  return !_out->fail();
+}
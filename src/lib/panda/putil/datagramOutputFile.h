@@ -39,12 +39,17 @@ public:
   virtual bool put_datagram(const Datagram &data);
   virtual bool is_error();
 
+  virtual bool supports_raw_data();
+  virtual streamoff get_raw_pos();
+  virtual bool put_raw_data(const unsigned char *data, size_t size);
+
 private:
   bool _wrote_first_datagram;
   bool _error;
   pofstream _out_file;
   ostream *_out;
   bool _owns_out;
+  streamoff _raw_pos;
 };
 
 #include "datagramOutputFile.I"
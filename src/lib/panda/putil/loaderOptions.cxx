@@ -31,6 +31,9 @@ LoaderOptions(int flags) :
   if (preload_simple_textures) {
     _texture_flags |= TF_preload_simple;
   }
+  if (bam_parallel_decode) {
+    _flags |= LF_parallel_decode;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -58,6 +61,7 @@ output(ostream &out) const {
     write_flag(out, sep, "LF_no_ram_cache", LF_no_ram_cache);
   }
   write_flag(out, sep, "LF_allow_instance", LF_allow_instance);
+  write_flag(out, sep, "LF_parallel_decode", LF_parallel_decode);
   if (sep.empty()) {
     out << "0";
   }
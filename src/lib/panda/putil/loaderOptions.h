@@ -36,6 +36,7 @@ PUBLISHED:
     LF_no_cache          = 0x0030,  // no_disk + no_ram
     LF_cache_only        = 0x0040,  // fail if not in cache
     LF_allow_instance    = 0x0080,  // returned pointer might be shared
+    LF_parallel_decode   = 0x0100,  // decode bam payloads on threads
   };
 
   // Flags for loading texture files.
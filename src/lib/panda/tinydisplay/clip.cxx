@@ -1,4 +1,5 @@
 #include "zgl.h"
+#include "tinyTileRasterizer.h"
 #include <limits.h>
 
 /* fill triangle profile */
@@ -67,6 +68,7 @@ void gl_transform_to_viewport(GLContext *c,GLVertex *v)
 
 void gl_draw_point(GLContext *c,GLVertex *p0)
 {
+  gl_flush_tiles(c);
   if (p0->clip_code == 0) {
     ZB_plot(c->zb,&p0->zp);
   }
@@ -116,6 +118,8 @@ void gl_draw_line(GLContext *c,GLVertex *p1,GLVertex *p2)
   GLVertex q1,q2;
   int cc1,cc2;
   
+  gl_flush_tiles(c);
+
   cc1=p1->clip_code;
   cc2=p2->clip_code;
 
@@ -397,7 +401,11 @@ void gl_draw_triangle_fill(GLContext *c,
   }
 #endif
 
-  (*c->zb_fill_tri)(c->zb,&p0->zp,&p1->zp,&p2->zp);
+  if (c->tiles != NULL) {
+    c->tiles->add_triangle(c->zb, c->zb_fill_tri, &p0->zp, &p1->zp, &p2->zp);
+  } else {
+    (*c->zb_fill_tri)(c->zb,&p0->zp,&p1->zp,&p2->zp);
+  }
 }
 
 /* Render a clipped triangle in line mode */  
@@ -405,6 +413,7 @@ void gl_draw_triangle_fill(GLContext *c,
 void gl_draw_triangle_line(GLContext *c,
                            GLVertex *p0,GLVertex *p1,GLVertex *p2)
 {
+    gl_flush_tiles(c);
     if (c->depth_test) {
         if (p0->edge_flag) ZB_line_z(c->zb,&p0->zp,&p1->zp);
         if (p1->edge_flag) ZB_line_z(c->zb,&p1->zp,&p2->zp);
@@ -422,11 +431,21 @@ void gl_draw_triangle_line(GLContext *c,
 void gl_draw_triangle_point(GLContext *c,
                             GLVertex *p0,GLVertex *p1,GLVertex *p2)
 {
+  gl_flush_tiles(c);
   if (p0->edge_flag) ZB_plot(c->zb,&p0->zp);
   if (p1->edge_flag) ZB_plot(c->zb,&p1->zp);
   if (p2->edge_flag) ZB_plot(c->zb,&p2->zp);
 }
 
+/* Draws any triangles that have been binned for the tile rasterizer,
+   before something else writes to the frame buffer directly. */
+void gl_flush_tiles(GLContext *c)
+{
+  if (c->tiles != NULL) {
+    c->tiles->flush();
+  }
+}
+
 
 
 
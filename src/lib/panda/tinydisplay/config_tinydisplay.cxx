@@ -26,6 +26,7 @@
 #include "tinyGraphicsStateGuardian.h"
 #include "tinyGeomMunger.h"
 #include "tinyTextureContext.h"
+#include "tinyTileTask.h"
 #include "graphicsPipeSelection.h"
 #include "dconfig.h"
 #include "pandaSystem.h"
@@ -74,6 +75,31 @@ ConfigVariableBool td_perspective_textures
             "textures on the tinydisplay software renderer, for a small "
             "performance gain."));
 
+ConfigVariableBool td_simd
+  ("td-simd", true,
+   PRC_DESC("Configure this false to disable the SSE2 versions of the "
+            "tinydisplay triangle fillers, which are used for the most "
+            "common combinations of smooth shading, texturing, depth "
+            "test and alpha blending when the CPU supports them.  They "
+            "produce exactly the same image as the scalar fillers."));
+
+ConfigVariableInt td_num_threads
+  ("td-num-threads", 0,
+   PRC_DESC("Set this to a number greater than 0 to have the tinydisplay "
+            "software renderer sort filled triangles into bands of "
+            "screen rows, and rasterize the bands in parallel on this "
+            "many worker threads, in addition to the draw thread.  The "
+            "rendered image is identical to the single-threaded result.  "
+            "This has no effect if threading support is not available."));
+
+ConfigVariableInt td_tile_rows
+  ("td-tile-rows", 32,
+   PRC_DESC("The number of screen rows in each band of the tile "
+            "rasterizer enabled by td-num-threads.  Smaller bands "
+            "balance the work more evenly among the threads, but "
+            "large triangles are set up once for each band they "
+            "touch."));
+
 ////////////////////////////////////////////////////////////////////
 //     Function: init_libtinydisplay
 //  Description: Initializes the library.  This must be called at
@@ -94,6 +120,7 @@ init_libtinydisplay() {
   TinyGraphicsStateGuardian::init_type();
   TinyGeomMunger::init_type();
   TinyTextureContext::init_type();
+  TinyTileTask::init_type();
 
   PandaSystem *ps = PandaSystem::get_global_ptr();
   ps->add_system("TinyPanda");
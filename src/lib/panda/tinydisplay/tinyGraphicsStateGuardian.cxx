@@ -15,6 +15,7 @@
 #include "tinyGraphicsStateGuardian.h"
 #include "tinyGeomMunger.h"
 #include "tinyTextureContext.h"
+#include "tinyTileRasterizer.h"
 #include "config_tinydisplay.h"
 #include "pStatTimer.h"
 #include "geomVertexReader.h"
@@ -34,6 +35,7 @@
 #include "lightAttrib.h"
 #include "scissorAttrib.h"
 #include "bitMask.h"
+#include "lsimd.h"
 #include "zgl.h"
 #include "zmath.h"
 #include "ztriangle_table.h"
@@ -69,6 +71,7 @@ TinyGraphicsStateGuardian(GraphicsEngine *engine, GraphicsPipe *pipe,
   _current_frame_buffer = NULL;
   _aux_frame_buffer = NULL;
   _c = NULL;
+  _tiles = NULL;
   _vertices = NULL;
   _vertices_size = 0;
 }
@@ -152,6 +155,11 @@ reset() {
 ////////////////////////////////////////////////////////////////////
 void TinyGraphicsStateGuardian::
 free_pointers() {
+  if (_tiles != (TinyTileRasterizer *)NULL) {
+    delete _tiles;
+    _tiles = NULL;
+  }
+
   if (_aux_frame_buffer != (ZBuffer *)NULL) {
     ZB_close(_aux_frame_buffer);
     _aux_frame_buffer = NULL;
@@ -176,6 +184,11 @@ void TinyGraphicsStateGuardian::
 close_gsg() {
   GraphicsStateGuardian::close_gsg();
 
+  if (_tiles != (TinyTileRasterizer *)NULL) {
+    delete _tiles;
+    _tiles = NULL;
+  }
+
   if (_c != (GLContext *)NULL) {
     glClose(_c);
     _c = NULL;
@@ -250,6 +263,7 @@ clear(DrawableRegion *clearable) {
     clear_z = true;
   }
 
+  flush_tiles();
   ZB_clear_viewport(_c->zb, clear_z, z,
                     clear_color, r, g, b, a,
                     _c->viewport.xmin, _c->viewport.ymin,
@@ -268,6 +282,9 @@ prepare_display_region(DisplayRegionPipelineReader *dr,
   nassertv(dr != (DisplayRegionPipelineReader *)NULL);
   GraphicsStateGuardian::prepare_display_region(dr, stereo_channel);
 
+  // The aux frame buffer may be resized below.
+  flush_tiles();
+
   int xmin, ymin, xsize, ysize;
   dr->get_region_pixels_i(xmin, ymin, xsize, ysize);
 
@@ -385,6 +402,7 @@ begin_frame(Thread *current_thread) {
   }
 
   _c->zb = _current_frame_buffer;
+  update_tiles();
 
 #ifdef DO_PSTATS
   _vertices_immediate_pcollector.clear_level();
@@ -436,6 +454,8 @@ begin_scene() {
 ////////////////////////////////////////////////////////////////////
 void TinyGraphicsStateGuardian::
 end_scene() {
+  flush_tiles();
+
   if (_c->zb == _aux_frame_buffer) {
     // Copy the aux frame buffer into the main scene now, zooming it
     // up to the appropriate size.
@@ -469,6 +489,7 @@ end_scene() {
 ////////////////////////////////////////////////////////////////////
 void TinyGraphicsStateGuardian::
 end_frame(Thread *current_thread) {
+  flush_tiles();
   GraphicsStateGuardian::end_frame(current_thread);
 
 #ifndef NDEBUG
@@ -927,20 +948,16 @@ begin_draw_primitives(const GeomPipelineReader *geom_reader,
   }
 
   _c->zb_fill_tri = fill_tri_funcs[depth_write_state][color_write_state][alpha_test_state][depth_test_state][texfilter_state][shade_model_state][texturing_state];
+  if (td_simd && LSimd::get_supported_level() >= LSimd::L_sse2) {
+    // Use the vectorized version of the filler, if there is one for
+    // this combination of options.
+    ZB_fillTriangleFunc simd_fill_tri = simd_fill_tri_funcs[depth_write_state][color_write_state][alpha_test_state][depth_test_state][texfilter_state][shade_model_state][texturing_state];
+    if (simd_fill_tri != (ZB_fillTriangleFunc)NULL) {
+      _c->zb_fill_tri = simd_fill_tri;
+    }
+  }
 
-#ifdef DO_PSTATS
-  pixel_count_white_untextured = 0;
-  pixel_count_flat_untextured = 0;
-  pixel_count_smooth_untextured = 0;
-  pixel_count_white_textured = 0;
-  pixel_count_flat_textured = 0;
-  pixel_count_smooth_textured = 0;
-  pixel_count_white_perspective = 0;
-  pixel_count_flat_perspective = 0;
-  pixel_count_smooth_perspective = 0;
-  pixel_count_smooth_multitex2 = 0;
-  pixel_count_smooth_multitex3 = 0;
-#endif  // DO_PSTATS
+  reset_pixel_counts();
   
   return true;
 }
@@ -1324,20 +1341,7 @@ draw_points(const GeomPrimitivePipelineReader *reader, bool force) {
 ////////////////////////////////////////////////////////////////////
 void TinyGraphicsStateGuardian::
 end_draw_primitives() {
-
-#ifdef DO_PSTATS
-  _pixel_count_white_untextured_pcollector.add_level(pixel_count_white_untextured);
-  _pixel_count_flat_untextured_pcollector.add_level(pixel_count_flat_untextured);
-  _pixel_count_smooth_untextured_pcollector.add_level(pixel_count_smooth_untextured);
-  _pixel_count_white_textured_pcollector.add_level(pixel_count_white_textured);
-  _pixel_count_flat_textured_pcollector.add_level(pixel_count_flat_textured);
-  _pixel_count_smooth_textured_pcollector.add_level(pixel_count_smooth_textured);
-  _pixel_count_white_perspective_pcollector.add_level(pixel_count_white_perspective);
-  _pixel_count_flat_perspective_pcollector.add_level(pixel_count_flat_perspective);
-  _pixel_count_smooth_perspective_pcollector.add_level(pixel_count_smooth_perspective);
-  _pixel_count_smooth_multitex2_pcollector.add_level(pixel_count_smooth_multitex2);
-  _pixel_count_smooth_multitex3_pcollector.add_level(pixel_count_smooth_multitex3);
-#endif  // DO_PSTATS
+  add_pixel_counts();
 
   GraphicsStateGuardian::end_draw_primitives();
 }
@@ -1355,6 +1359,7 @@ bool TinyGraphicsStateGuardian::
 framebuffer_copy_to_texture(Texture *tex, int z, const DisplayRegion *dr,
                             const RenderBuffer &rb) {
   nassertr(tex != NULL && dr != NULL, false);
+  flush_tiles();
   
   int xo, yo, w, h;
   dr->get_region_pixels_i(xo, yo, w, h);
@@ -1405,6 +1410,7 @@ bool TinyGraphicsStateGuardian::
 framebuffer_copy_to_ram(Texture *tex, int z, const DisplayRegion *dr,
                         const RenderBuffer &rb) {
   nassertr(tex != NULL && dr != NULL, false);
+  flush_tiles();
   
   int xo, yo, w, h;
   dr->get_region_pixels_i(xo, yo, w, h);
@@ -1737,6 +1743,7 @@ update_texture(TextureContext *tc, bool force, int stage_index) {
 void TinyGraphicsStateGuardian::
 release_texture(TextureContext *tc) {
   TinyTextureContext *gtc = DCAST(TinyTextureContext, tc);
+  flush_tiles();
 
   _texturing_state = 0;  // just in case
 
@@ -2416,6 +2423,100 @@ set_scissor(float left, float right, float bottom, float top) {
   }
 }
 
+////////////////////////////////////////////////////////////////////
+//     Function: TinyGraphicsStateGuardian::update_tiles
+//       Access: Private
+//  Description: Creates, replaces, or removes the tile rasterizer
+//               according to the current values of td-num-threads
+//               and td-tile-rows.  Called at the beginning of each
+//               frame, when no triangles are pending.
+////////////////////////////////////////////////////////////////////
+void TinyGraphicsStateGuardian::
+update_tiles() {
+  int num_threads = 0;
+  if (Thread::is_threading_supported()) {
+    num_threads = max((int)td_num_threads, 0);
+  }
+  int tile_rows = max((int)td_tile_rows, 1);
+
+  if (_tiles != (TinyTileRasterizer *)NULL &&
+      (_tiles->get_num_threads() != num_threads ||
+       _tiles->get_tile_rows() != tile_rows)) {
+    delete _tiles;
+    _tiles = NULL;
+  }
+  if (_tiles == (TinyTileRasterizer *)NULL && num_threads > 0) {
+    _tiles = new TinyTileRasterizer(num_threads, tile_rows);
+  }
+  _c->tiles = _tiles;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyGraphicsStateGuardian::flush_tiles
+//       Access: Private
+//  Description: Draws any triangles that are pending in the tile
+//               rasterizer.  This must be called before the frame
+//               buffer is accessed other than by drawing triangles,
+//               or before a texture image is changed.  It should not
+//               be called between begin_draw_primitives() and
+//               end_draw_primitives().
+////////////////////////////////////////////////////////////////////
+void TinyGraphicsStateGuardian::
+flush_tiles() {
+  if (_tiles != (TinyTileRasterizer *)NULL) {
+    // The pixels drawn now have not been counted by any
+    // end_draw_primitives() call.
+    reset_pixel_counts();
+    _tiles->flush();
+    add_pixel_counts();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyGraphicsStateGuardian::reset_pixel_counts
+//       Access: Private
+//  Description: Zeroes the per-fill-function pixel counters.
+////////////////////////////////////////////////////////////////////
+void TinyGraphicsStateGuardian::
+reset_pixel_counts() {
+#ifdef DO_PSTATS
+  AtomicAdjust::set(pixel_count_white_untextured, 0);
+  AtomicAdjust::set(pixel_count_flat_untextured, 0);
+  AtomicAdjust::set(pixel_count_smooth_untextured, 0);
+  AtomicAdjust::set(pixel_count_white_textured, 0);
+  AtomicAdjust::set(pixel_count_flat_textured, 0);
+  AtomicAdjust::set(pixel_count_smooth_textured, 0);
+  AtomicAdjust::set(pixel_count_white_perspective, 0);
+  AtomicAdjust::set(pixel_count_flat_perspective, 0);
+  AtomicAdjust::set(pixel_count_smooth_perspective, 0);
+  AtomicAdjust::set(pixel_count_smooth_multitex2, 0);
+  AtomicAdjust::set(pixel_count_smooth_multitex3, 0);
+#endif  // DO_PSTATS
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyGraphicsStateGuardian::add_pixel_counts
+//       Access: Private
+//  Description: Adds the per-fill-function pixel counters to their
+//               PStats collectors.
+////////////////////////////////////////////////////////////////////
+void TinyGraphicsStateGuardian::
+add_pixel_counts() {
+#ifdef DO_PSTATS
+  _pixel_count_white_untextured_pcollector.add_level(AtomicAdjust::get(pixel_count_white_untextured));
+  _pixel_count_flat_untextured_pcollector.add_level(AtomicAdjust::get(pixel_count_flat_untextured));
+  _pixel_count_smooth_untextured_pcollector.add_level(AtomicAdjust::get(pixel_count_smooth_untextured));
+  _pixel_count_white_textured_pcollector.add_level(AtomicAdjust::get(pixel_count_white_textured));
+  _pixel_count_flat_textured_pcollector.add_level(AtomicAdjust::get(pixel_count_flat_textured));
+  _pixel_count_smooth_textured_pcollector.add_level(AtomicAdjust::get(pixel_count_smooth_textured));
+  _pixel_count_white_perspective_pcollector.add_level(AtomicAdjust::get(pixel_count_white_perspective));
+  _pixel_count_flat_perspective_pcollector.add_level(AtomicAdjust::get(pixel_count_flat_perspective));
+  _pixel_count_smooth_perspective_pcollector.add_level(AtomicAdjust::get(pixel_count_smooth_perspective));
+  _pixel_count_smooth_multitex2_pcollector.add_level(AtomicAdjust::get(pixel_count_smooth_multitex2));
+  _pixel_count_smooth_multitex3_pcollector.add_level(AtomicAdjust::get(pixel_count_smooth_multitex3));
+#endif  // DO_PSTATS
+}
+
 ////////////////////////////////////////////////////////////////////
 //     Function: TinyGraphicsStateGuardian::apply_texture
 //       Access: Protected
@@ -2465,6 +2566,9 @@ upload_texture(TinyTextureContext *gtc, bool force) {
     return false;
   }
 
+  // Pending triangles may still refer to the old image.
+  flush_tiles();
+
   if (tinydisplay_cat.is_debug()) {
     tinydisplay_cat.debug()
       << "loading texture " << tex->get_name() << "\n";
@@ -2592,6 +2696,8 @@ upload_simple_texture(TinyTextureContext *gtc) {
       << "loading simple image for " << tex->get_name() << "\n";
   }
 
+  flush_tiles();
+
   if (!setup_gltex(gltex, width, height, 1)) {
     return false;
   }
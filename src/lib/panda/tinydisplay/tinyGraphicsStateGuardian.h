@@ -115,6 +115,11 @@ private:
 
   void set_scissor(float left, float right, float bottom, float top);
 
+  void update_tiles();
+  void flush_tiles();
+  void reset_pixel_counts();
+  void add_pixel_counts();
+
   bool apply_texture(TextureContext *tc);
   bool upload_texture(TinyTextureContext *gtc, bool force);
   bool upload_simple_texture(TinyTextureContext *gtc);
@@ -161,6 +166,9 @@ private:
 
   GLContext *_c;
 
+  // Non-NULL when td-num-threads is in effect.
+  TinyTileRasterizer *_tiles;
+
   enum ColorMaterialFlags {
     CMF_ambient   = 0x001,
     CMF_diffuse   = 0x002,
@@ -0,0 +1,298 @@
+// Filename: tinyTileRasterizer.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "tinyTileRasterizer.h"
+#include "tinyTileTask.h"
+#include "asyncTaskChain.h"
+#include "mutexHolder.h"
+#include "pStatTimer.h"
+
+// The triangles are flushed automatically after this many have been
+// recorded, to limit the memory used by the tiles.
+static const size_t max_triangles = 16384;
+
+// Smaller flushes than this are not worth waking up the worker
+// threads for; they are rasterized on the calling thread.
+static const size_t min_parallel_triangles = 16;
+
+PStatCollector TinyTileRasterizer::_flush_pcollector("Draw:Flush tiles");
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::Constructor
+//       Access: Public
+//  Description: Creates a rasterizer that will sort triangles into
+//               tiles of the indicated number of rows, and draw them
+//               with the indicated number of worker threads.  If
+//               threading support is not available, the tiles are
+//               all drawn on the thread that calls flush().
+////////////////////////////////////////////////////////////////////
+TinyTileRasterizer::
+TinyTileRasterizer(int num_threads, int tile_rows) :
+  _num_threads(max(num_threads, 0)),
+  _tile_rows(max(tile_rows, 1)),
+  _lock("TinyTileRasterizer::_lock"),
+  _cvar(_lock),
+  _next_tile(0),
+  _num_working(0)
+{
+  if (_num_threads > 0 && Thread::is_threading_supported()) {
+    _task_manager = new AsyncTaskManager("tinydisplay");
+    AsyncTaskChain *chain = _task_manager->make_task_chain(TinyTileTask::get_task_chain_name());
+    chain->set_num_threads(_num_threads);
+    chain->set_thread_priority(TP_high);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::Destructor
+//       Access: Public
+//  Description: Draws any triangles still pending, and stops the
+//               worker threads.
+////////////////////////////////////////////////////////////////////
+TinyTileRasterizer::
+~TinyTileRasterizer() {
+  flush();
+  if (_task_manager != (AsyncTaskManager *)NULL) {
+    _task_manager->cleanup();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::add_triangle
+//       Access: Public
+//  Description: Records a clipped, screen-space triangle, to be drawn
+//               into the indicated ZBuffer with the indicated fill
+//               function at the next flush().  The ZBuffer's current
+//               state (textures, blending, alpha test) is copied, so
+//               it may be changed freely after this call; but the
+//               frame buffer and texture images it refers to must
+//               remain valid until the flush.
+////////////////////////////////////////////////////////////////////
+void TinyTileRasterizer::
+add_triangle(const ZBuffer *zb, ZB_fillTriangleFunc fill_tri,
+             const ZBufferPoint *p0, const ZBufferPoint *p1,
+             const ZBufferPoint *p2) {
+  if (!_batches.empty()) {
+    const ZBuffer &last = _batches.back()._zb;
+    if (last.pbuf != zb->pbuf || last.ysize != zb->ysize) {
+      // The tiles are laid out for a different frame buffer.
+      do_flush();
+    }
+  }
+
+  if (_batches.empty() || !same_state(_batches.back(), zb, fill_tri)) {
+    if (_batches.empty()) {
+      _tiles.resize((zb->ysize + _tile_rows - 1) / _tile_rows);
+    }
+    _batches.push_back(Batch());
+    Batch &batch = _batches.back();
+    batch._zb = *zb;
+    batch._fill_tri = fill_tri;
+  }
+
+  int index = (int)_triangles.size();
+  _triangles.push_back(Triangle());
+  Triangle &tri = _triangles.back();
+  tri._p0 = *p0;
+  tri._p1 = *p1;
+  tri._p2 = *p2;
+  tri._batch = (int)_batches.size() - 1;
+
+  int ymin = min(p0->y, min(p1->y, p2->y));
+  int ymax = max(p0->y, max(p1->y, p2->y));
+  int first_tile = max(ymin, 0) / _tile_rows;
+  int last_tile = min(ymax / _tile_rows, (int)_tiles.size() - 1);
+  for (int ti = first_tile; ti <= last_tile; ++ti) {
+    _tiles[ti].push_back(index);
+  }
+
+  if (_triangles.size() >= max_triangles) {
+    do_flush();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::rasterize_tiles
+//       Access: Public
+//  Description: Draws tiles until there are no more left to claim.
+//               This is called by each worker task, and by the
+//               thread that calls flush().
+////////////////////////////////////////////////////////////////////
+void TinyTileRasterizer::
+rasterize_tiles() {
+  int ti = claim_next();
+  while (ti >= 0) {
+    draw_tile(ti);
+    ti = claim_next();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::task_done
+//       Access: Public
+//  Description: Called by each worker task when it has run out of
+//               tiles to draw.
+////////////////////////////////////////////////////////////////////
+void TinyTileRasterizer::
+task_done() {
+  MutexHolder holder(_lock);
+  nassertv(_num_working > 0);
+  --_num_working;
+  if (_num_working == 0) {
+    _cvar.notify();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::do_flush
+//       Access: Private
+//  Description: The implementation of flush().
+////////////////////////////////////////////////////////////////////
+void TinyTileRasterizer::
+do_flush() {
+  PStatTimer timer(_flush_pcollector);
+
+  int num_tasks = 0;
+  if (_task_manager != (AsyncTaskManager *)NULL &&
+      _triangles.size() >= min_parallel_triangles) {
+    num_tasks = min(_num_threads, (int)_tiles.size() - 1);
+  }
+
+  {
+    MutexHolder holder(_lock);
+    _next_tile = 0;
+    _num_working = max(num_tasks, 0);
+  }
+  for (int i = 0; i < num_tasks; ++i) {
+    _task_manager->add(new TinyTileTask(this, i));
+  }
+
+  rasterize_tiles();
+
+  if (num_tasks > 0) {
+    MutexHolder holder(_lock);
+    while (_num_working > 0) {
+      _cvar.wait();
+    }
+  }
+
+  _batches.clear();
+  _triangles.clear();
+  Tiles::iterator ti;
+  for (ti = _tiles.begin(); ti != _tiles.end(); ++ti) {
+    (*ti).clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::claim_next
+//       Access: Private
+//  Description: Returns the index of the next tile that has not yet
+//               been claimed by any thread, or -1 if all of the
+//               tiles have been claimed.
+////////////////////////////////////////////////////////////////////
+int TinyTileRasterizer::
+claim_next() {
+  MutexHolder holder(_lock);
+  while (_next_tile < (int)_tiles.size()) {
+    int ti = _next_tile;
+    ++_next_tile;
+    if (!_tiles[ti].empty()) {
+      return ti;
+    }
+  }
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::draw_tile
+//       Access: Private
+//  Description: Draws all of the triangles that touch the indicated
+//               tile, in the order they were added, limiting the
+//               drawing to the tile's rows.
+////////////////////////////////////////////////////////////////////
+void TinyTileRasterizer::
+draw_tile(int ti) {
+  const TileTriangles &triangles = _tiles[ti];
+
+  ZBuffer zb;
+  int ymin = ti * _tile_rows;
+  int last_batch = -1;
+
+  TileTriangles::const_iterator ii;
+  for (ii = triangles.begin(); ii != triangles.end(); ++ii) {
+    const Triangle &tri = _triangles[*ii];
+    const Batch &batch = _batches[tri._batch];
+    if (tri._batch != last_batch) {
+      zb = batch._zb;
+      zb.ymin = ymin;
+      zb.ymax = min(ymin + _tile_rows, zb.ysize);
+      last_batch = tri._batch;
+    }
+
+    // The fill functions scribble on the points, so each tile needs
+    // its own copy.
+    ZBufferPoint p0 = tri._p0;
+    ZBufferPoint p1 = tri._p1;
+    ZBufferPoint p2 = tri._p2;
+    (*batch._fill_tri)(&zb, &p0, &p1, &p2);
+  }
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileRasterizer::same_state
+//       Access: Private, Static
+//  Description: Returns true if the batch was recorded with the same
+//               fill function and the same ZBuffer state that the
+//               fill function would see in the indicated ZBuffer, so
+//               that the next triangle may be added to the same
+//               batch.
+////////////////////////////////////////////////////////////////////
+bool TinyTileRasterizer::
+same_state(const Batch &batch, const ZBuffer *zb,
+           ZB_fillTriangleFunc fill_tri) {
+  const ZBuffer &bzb = batch._zb;
+  if (batch._fill_tri != fill_tri ||
+      bzb.pbuf != zb->pbuf ||
+      bzb.zbuf != zb->zbuf ||
+      bzb.linesize != zb->linesize ||
+      bzb.xsize != zb->xsize ||
+      bzb.reference_alpha != zb->reference_alpha ||
+      bzb.blend_r != zb->blend_r ||
+      bzb.blend_g != zb->blend_g ||
+      bzb.blend_b != zb->blend_b ||
+      bzb.blend_a != zb->blend_a ||
+      bzb.store_pix_func != zb->store_pix_func) {
+    return false;
+  }
+
+  for (int i = 0; i < MAX_TEXTURE_STAGES; ++i) {
+    const ZTextureDef &a = bzb.current_textures[i];
+    const ZTextureDef &b = zb->current_textures[i];
+    if (a.levels != b.levels ||
+        a.tex_minfilter_func != b.tex_minfilter_func ||
+        a.tex_magfilter_func != b.tex_magfilter_func ||
+        a.tex_minfilter_func_impl != b.tex_minfilter_func_impl ||
+        a.tex_magfilter_func_impl != b.tex_magfilter_func_impl ||
+        a.tex_wrap_u_func != b.tex_wrap_u_func ||
+        a.tex_wrap_v_func != b.tex_wrap_v_func ||
+        a.s_max != b.s_max ||
+        a.t_max != b.t_max ||
+        a.border_color != b.border_color) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,111 @@
+// Filename: tinyTileRasterizer.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef TINYTILERASTERIZER_H
+#define TINYTILERASTERIZER_H
+
+#include "pandabase.h"
+#include "zbuffer.h"
+#include "asyncTaskManager.h"
+#include "pointerTo.h"
+#include "pmutex.h"
+#include "conditionVar.h"
+#include "pStatCollector.h"
+#include "pvector.h"
+
+////////////////////////////////////////////////////////////////////
+//       Class : TinyTileRasterizer
+// Description : This is used internally by the
+//               TinyGraphicsStateGuardian to implement the parallel
+//               rasterizer (see td-num-threads).  Filled triangles are
+//               recorded here, after transform and clipping, along
+//               with a copy of the ZBuffer state they are to be drawn
+//               with, and sorted into bands of td-tile-rows screen
+//               rows.  When flush() is called, the bands are
+//               rasterized independently by a pool of worker threads
+//               and the calling thread.
+//
+//               Each band is drawn by the ordinary triangle fillers,
+//               with the ZBuffer limited to the band's rows.  The
+//               fillers still step each triangle's edges through
+//               every row from its top, so every pixel is computed
+//               exactly as the serial rasterizer would compute it,
+//               and since each band draws its triangles in the order
+//               they were added, the result is bit-identical.
+//
+//               flush() must be called before anything else reads or
+//               writes the frame buffer, or modifies the texture
+//               images that the recorded triangles refer to.
+////////////////////////////////////////////////////////////////////
+class EXPCL_TINYDISPLAY TinyTileRasterizer {
+public:
+  TinyTileRasterizer(int num_threads, int tile_rows);
+  ~TinyTileRasterizer();
+
+  INLINE int get_num_threads() const;
+  INLINE int get_tile_rows() const;
+
+  void add_triangle(const ZBuffer *zb, ZB_fillTriangleFunc fill_tri,
+                    const ZBufferPoint *p0, const ZBufferPoint *p1,
+                    const ZBufferPoint *p2);
+  INLINE void flush();
+
+  void rasterize_tiles();
+  void task_done();
+
+private:
+  void do_flush();
+  int claim_next();
+  void draw_tile(int ti);
+
+  class Batch {
+  public:
+    ZBuffer _zb;
+    ZB_fillTriangleFunc _fill_tri;
+  };
+
+  class Triangle {
+  public:
+    ZBufferPoint _p0, _p1, _p2;
+    int _batch;
+  };
+
+  static bool same_state(const Batch &batch, const ZBuffer *zb,
+                         ZB_fillTriangleFunc fill_tri);
+
+  typedef pvector<Batch> Batches;
+  typedef pvector<Triangle> Triangles;
+  typedef pvector<int> TileTriangles;
+  typedef pvector<TileTriangles> Tiles;
+
+  int _num_threads;
+  int _tile_rows;
+
+  Batches _batches;
+  Triangles _triangles;
+  Tiles _tiles;
+
+  PT(AsyncTaskManager) _task_manager;
+
+  Mutex _lock;
+  ConditionVar _cvar;
+  int _next_tile;
+  int _num_working;
+
+  static PStatCollector _flush_pcollector;
+};
+
+#include "tinyTileRasterizer.I"
+
+#endif
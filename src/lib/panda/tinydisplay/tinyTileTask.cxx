@@ -0,0 +1,59 @@
+// Filename: tinyTileTask.cxx
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#include "tinyTileTask.h"
+#include "tinyTileRasterizer.h"
+#include "string_utils.h"
+
+TypeHandle TinyTileTask::_type_handle;
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileTask::Constructor
+//       Access: Public
+//  Description: Creates a new task that will draw tiles from the
+//               indicated rasterizer.  The rasterizer must remain
+//               valid until the task has called task_done(); the
+//               index is used only to name the task.
+////////////////////////////////////////////////////////////////////
+TinyTileTask::
+TinyTileTask(TinyTileRasterizer *tiles, int index) :
+  AsyncTask("tinydisplay:" + format_string(index)),
+  _tiles(tiles)
+{
+  set_task_chain(get_task_chain_name());
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileTask::get_task_chain_name
+//       Access: Public, Static
+//  Description: Returns the name of the task chain on which the
+//               tile tasks are run.
+////////////////////////////////////////////////////////////////////
+const string &TinyTileTask::
+get_task_chain_name() {
+  static string name = "tinydisplay";
+  return name;
+}
+
+////////////////////////////////////////////////////////////////////
+//     Function: TinyTileTask::do_task
+//       Access: Protected, Virtual
+//  Description: Draws tiles until there are no more left to claim.
+////////////////////////////////////////////////////////////////////
+AsyncTask::DoneStatus TinyTileTask::
+do_task() {
+  _tiles->rasterize_tiles();
+  _tiles->task_done();
+  return DS_done;
+}
@@ -0,0 +1,61 @@
+// Filename: tinyTileTask.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef TINYTILETASK_H
+#define TINYTILETASK_H
+
+#include "pandabase.h"
+#include "asyncTask.h"
+
+class TinyTileRasterizer;
+
+////////////////////////////////////////////////////////////////////
+//       Class : TinyTileTask
+// Description : This task is used internally by the
+//               TinyTileRasterizer.  Each task draws tiles until
+//               there are none left to claim, and then reports back
+//               to the rasterizer.
+////////////////////////////////////////////////////////////////////
+class EXPCL_TINYDISPLAY TinyTileTask : public AsyncTask {
+public:
+  TinyTileTask(TinyTileRasterizer *tiles, int index);
+  ALLOC_DELETED_CHAIN(TinyTileTask);
+
+  static const string &get_task_chain_name();
+
+protected:
+  virtual DoneStatus do_task();
+
+private:
+  TinyTileRasterizer *_tiles;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AsyncTask::init_type();
+    register_type(_type_handle, "TinyTileTask",
+                  AsyncTask::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#endif
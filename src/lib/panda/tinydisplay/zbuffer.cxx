@@ -11,17 +11,17 @@
 #include "pnotify.h"
 
 #ifdef DO_PSTATS
-int pixel_count_white_untextured;
-int pixel_count_flat_untextured;
-int pixel_count_smooth_untextured;
-int pixel_count_white_textured;
-int pixel_count_flat_textured;
-int pixel_count_smooth_textured;
-int pixel_count_white_perspective;
-int pixel_count_flat_perspective;
-int pixel_count_smooth_perspective;
-int pixel_count_smooth_multitex2;
-int pixel_count_smooth_multitex3;
+TVOLATILE AtomicAdjust::Integer pixel_count_white_untextured;
+TVOLATILE AtomicAdjust::Integer pixel_count_flat_untextured;
+TVOLATILE AtomicAdjust::Integer pixel_count_smooth_untextured;
+TVOLATILE AtomicAdjust::Integer pixel_count_white_textured;
+TVOLATILE AtomicAdjust::Integer pixel_count_flat_textured;
+TVOLATILE AtomicAdjust::Integer pixel_count_smooth_textured;
+TVOLATILE AtomicAdjust::Integer pixel_count_white_perspective;
+TVOLATILE AtomicAdjust::Integer pixel_count_flat_perspective;
+TVOLATILE AtomicAdjust::Integer pixel_count_smooth_perspective;
+TVOLATILE AtomicAdjust::Integer pixel_count_smooth_multitex2;
+TVOLATILE AtomicAdjust::Integer pixel_count_smooth_multitex3;
 #endif  // DO_PSTATS
 
 ZBuffer *
@@ -43,6 +43,8 @@ ZB_open(int xsize, int ysize, int mode,
 
   zb->xsize = xsize;
   zb->ysize = ysize;
+  zb->ymin = 0;
+  zb->ymax = ysize;
   zb->mode = mode;
   zb->linesize = (xsize * PSZB + 3) & ~3;
 
@@ -112,6 +114,8 @@ ZB_resize(ZBuffer * zb, void *frame_buffer, int xsize, int ysize) {
 
   zb->xsize = xsize;
   zb->ysize = ysize;
+  zb->ymin = 0;
+  zb->ymax = ysize;
   zb->linesize = (xsize * PSZB + 3) & ~3;
 
   size = zb->xsize * zb->ysize * sizeof(ZPOINT);
@@ -7,6 +7,7 @@
 
 #include "zfeatures.h"
 #include "pbitops.h"
+#include "atomicAdjust.h"
 
 typedef unsigned int ZPOINT;
 #define ZB_Z_BITS 20
@@ -150,6 +151,11 @@ struct ZBuffer {
   int reference_alpha;
   int blend_r, blend_g, blend_b, blend_a;
   ZB_storePixelFunc store_pix_func;
+
+  /* The triangle fillers write only to rows ymin <= y < ymax.
+     Normally this is the whole buffer; the tile rasterizer narrows it
+     to one band of rows for each worker. */
+  int ymin, ymax;
 };
 
 struct ZBufferPoint {
@@ -169,20 +175,21 @@ struct ZBufferPoint {
 /* zbuffer.c */
 
 #ifdef DO_PSTATS
-extern int pixel_count_white_untextured;
-extern int pixel_count_flat_untextured;
-extern int pixel_count_smooth_untextured;
-extern int pixel_count_white_textured;
-extern int pixel_count_flat_textured;
-extern int pixel_count_smooth_textured;
-extern int pixel_count_white_perspective;
-extern int pixel_count_flat_perspective;
-extern int pixel_count_smooth_perspective;
-extern int pixel_count_smooth_multitex2;
-extern int pixel_count_smooth_multitex3;
+/* These may be incremented by several tile workers at once. */
+extern TVOLATILE AtomicAdjust::Integer pixel_count_white_untextured;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_flat_untextured;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_smooth_untextured;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_white_textured;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_flat_textured;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_smooth_textured;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_white_perspective;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_flat_perspective;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_smooth_perspective;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_smooth_multitex2;
+extern TVOLATILE AtomicAdjust::Integer pixel_count_smooth_multitex3;
 
 #define COUNT_PIXELS(pixel_count, p0, p1, p2) \
-  (pixel_count) += abs((p0)->x * ((p1)->y - (p2)->y) + (p1)->x * ((p2)->y - (p0)->y) + (p2)->x * ((p0)->y - (p1)->y)) / 2
+  AtomicAdjust::add((pixel_count), abs((p0)->x * ((p1)->y - (p2)->y) + (p1)->x * ((p2)->y - (p0)->y) + (p2)->x * ((p0)->y - (p1)->y)) / 2)
 
 #else
 
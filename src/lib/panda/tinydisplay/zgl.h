@@ -130,6 +130,7 @@ typedef struct GLTexture {
 } GLTexture;
 
 struct GLContext;
+class TinyTileRasterizer;
 
 typedef void (*gl_draw_triangle_func)(struct GLContext *c,
                                       GLVertex *p0,GLVertex *p1,GLVertex *p2);
@@ -178,6 +179,10 @@ typedef struct GLContext {
   gl_draw_triangle_func draw_triangle_front,draw_triangle_back;
   ZB_fillTriangleFunc zb_fill_tri;
 
+  /* if not NULL, filled triangles are binned here instead of being
+     drawn immediately (see td-num-threads) */
+  TinyTileRasterizer *tiles;
+
   /* current vertex state */
   V4 current_color;
   V4 current_normal;
@@ -209,6 +214,7 @@ void gl_draw_triangle_line(GLContext *c,
                            GLVertex *p0,GLVertex *p1,GLVertex *p2);
 void gl_draw_triangle_fill(GLContext *c,
                            GLVertex *p0,GLVertex *p1,GLVertex *p2);
+void gl_flush_tiles(GLContext *c);
 
 /* light.c */
 void gl_enable_disable_light(GLContext *c,int light,int v);
@@ -0,0 +1,169 @@
+// Filename: zsimd.h
+// Created by:  agent (17Oct26)
+//
+////////////////////////////////////////////////////////////////////
+//
+// PANDA 3D SOFTWARE
+// Copyright (c) Carnegie Mellon University.  All rights reserved.
+//
+// All use of this software is subject to the terms of the revised BSD
+// license.  You should have received a copy of this license along
+// with this source code in a file named "LICENSE."
+//
+////////////////////////////////////////////////////////////////////
+
+#ifndef ZSIMD_H
+#define ZSIMD_H
+
+/* Helpers for the vectorized span fillers generated into
+   ztriangle_simd_code.h; see ztriangle_simd_two.h.  Each operates on
+   four adjacent pixels of a scan line at once, and reproduces the
+   32-bit integer arithmetic of the corresponding scalar macro in
+   zbuffer.h exactly, overflow and all, so that the vectorized fillers
+   write the same pixels as the scalar ones.
+
+   The functions are tagged with the instruction set they need, so
+   that this code may be compiled without -msse2; the vectorized
+   fillers are only selected if the CPU supports them. */
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define ZB_SIMD_X86
+#define ZB_SSE2 __attribute__((target("sse2")))
+#include <emmintrin.h>
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define ZB_SIMD_X86
+#define ZB_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef ZB_SIMD_X86
+
+/* Returns the four values (v, v + dv, v + 2 * dv, v + 3 * dv). */
+static inline ZB_SSE2 __m128i
+zsimd_ramp(unsigned int v, int dv) {
+  unsigned int d = (unsigned int)dv;
+  return _mm_setr_epi32((int)v, (int)(v + d), (int)(v + 2 * d), (int)(v + 3 * d));
+}
+
+/* Returns the step that advances a ramp by four pixels. */
+static inline ZB_SSE2 __m128i
+zsimd_step4(int dv) {
+  return _mm_set1_epi32((int)((unsigned int)dv * 4));
+}
+
+/* The low 32 bits of the product of each pair of lanes.  SSE2 has no
+   32-bit multiply, so this is assembled from two 32x32->64 multiplies
+   on the even and odd lanes. */
+static inline ZB_SSE2 __m128i
+zsimd_mullo(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/* Unsigned a < b, as a lane mask. */
+static inline ZB_SSE2 __m128i
+zsimd_cmplt_epu32(__m128i a, __m128i b) {
+  __m128i bias = _mm_set1_epi32((int)0x80000000);
+  return _mm_cmplt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+}
+
+static inline ZB_SSE2 __m128i
+zsimd_all_on() {
+  return _mm_set1_epi32(-1);
+}
+
+static inline ZB_SSE2 __m128i
+zsimd_load(const void *p) {
+  return _mm_loadu_si128((const __m128i *)p);
+}
+
+/* Stores v into the lanes of p selected by mask, leaving the others
+   as they were.  Since a scan line is only ever filled by one thread,
+   rewriting the unselected lanes with their old values is safe. */
+static inline ZB_SSE2 void
+zsimd_store_masked(void *p, __m128i v, __m128i mask) {
+  __m128i old = _mm_loadu_si128((const __m128i *)p);
+  _mm_storeu_si128((__m128i *)p, _mm_or_si128(_mm_and_si128(mask, v),
+                                              _mm_andnot_si128(mask, old)));
+}
+
+/* RGBA_TO_PIXEL(). */
+static inline ZB_SSE2 __m128i
+zsimd_rgba_to_pixel(__m128i r, __m128i g, __m128i b, __m128i a) {
+  __m128i pa = _mm_and_si128(_mm_slli_epi32(a, 16), _mm_set1_epi32((int)0xff000000));
+  __m128i pr = _mm_and_si128(_mm_slli_epi32(r, 8), _mm_set1_epi32(0xff0000));
+  __m128i pg = _mm_and_si128(g, _mm_set1_epi32(0xff00));
+  __m128i pb = _mm_srli_epi32(b, 8);
+  return _mm_or_si128(_mm_or_si128(pa, pr), _mm_or_si128(pg, pb));
+}
+
+/* PIXEL_R(), PIXEL_G(), PIXEL_B() and PIXEL_A(). */
+static inline ZB_SSE2 __m128i
+zsimd_pixel_r(__m128i p) {
+  return _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xff0000)), 8);
+}
+
+static inline ZB_SSE2 __m128i
+zsimd_pixel_g(__m128i p) {
+  return _mm_and_si128(p, _mm_set1_epi32(0xff00));
+}
+
+static inline ZB_SSE2 __m128i
+zsimd_pixel_b(__m128i p) {
+  return _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xff)), 8);
+}
+
+static inline ZB_SSE2 __m128i
+zsimd_pixel_a(__m128i p) {
+  return _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32((int)0xff000000)), 16);
+}
+
+/* PCOMPONENT_MULT(). */
+static inline ZB_SSE2 __m128i
+zsimd_pcomponent_mult(__m128i c1, __m128i c2) {
+  return _mm_srli_epi32(zsimd_mullo(c1, c2), 16);
+}
+
+/* PALPHA_MULT(). */
+static inline ZB_SSE2 __m128i
+zsimd_palpha_mult(__m128i c1, __m128i c2) {
+  return _mm_srai_epi32(zsimd_mullo(_mm_srai_epi32(c1, 2), c2), 14);
+}
+
+/* PIXEL_BLEND_RGB(). */
+static inline ZB_SSE2 __m128i
+zsimd_pixel_blend_rgb(__m128i rgb, __m128i r, __m128i g, __m128i b, __m128i a) {
+  __m128i ia = _mm_sub_epi32(_mm_set1_epi32(0xffff), a);
+  __m128i br = _mm_srli_epi32(_mm_add_epi32(zsimd_mullo(zsimd_pixel_r(rgb), ia),
+                                            zsimd_mullo(r, a)), 16);
+  __m128i bg = _mm_srli_epi32(_mm_add_epi32(zsimd_mullo(zsimd_pixel_g(rgb), ia),
+                                            zsimd_mullo(g, a)), 16);
+  __m128i bb = _mm_srli_epi32(_mm_add_epi32(zsimd_mullo(zsimd_pixel_b(rgb), ia),
+                                            zsimd_mullo(b, a)), 16);
+  return zsimd_rgba_to_pixel(br, bg, bb, a);
+}
+
+/* ZB_TEXEL() looked up in the indicated level, for each lane.  The
+   texel offsets are computed together, but there is no gather
+   instruction in SSE2, so the texels themselves are fetched one at a
+   time. */
+static inline ZB_SSE2 __m128i
+zsimd_lookup_texture(const ZTextureLevel &level, __m128i s, __m128i t) {
+  __m128i ti = _mm_srl_epi32(_mm_and_si128(t, _mm_set1_epi32((int)level.t_mask)),
+                             _mm_cvtsi32_si128((int)level.t_shift));
+  __m128i si = _mm_srl_epi32(_mm_and_si128(s, _mm_set1_epi32((int)level.s_mask)),
+                             _mm_cvtsi32_si128((int)level.s_shift));
+  __m128i index = _mm_or_si128(ti, si);
+  const PIXEL *pixmap = level.pixmap;
+  return _mm_setr_epi32(pixmap[(unsigned int)_mm_cvtsi128_si32(index)],
+                        pixmap[(unsigned int)_mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(1, 1, 1, 1)))],
+                        pixmap[(unsigned int)_mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(2, 2, 2, 2)))],
+                        pixmap[(unsigned int)_mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(3, 3, 3, 3)))]);
+}
+
+#endif  // ZB_SIMD_X86
+
+#endif
@@ -7,7 +7,7 @@
   float fdx1, fdx2, fdy1, fdy2, fz, d1, d2;
   ZPOINT *pz1;
   PIXEL *pp1;
-  int part, update_left, update_right;
+  int part, update_left, update_right, y;
 
   int nb_lines, dx1, dy1, tmp, dx2, dy2;
 
@@ -53,8 +53,6 @@
 
   EARLY_OUT();
 
-  COUNT_PIXELS(PIXEL_COUNT, p0, p1, p2);
-
   /* we sort the vertex with increasing y */
   if (p1->y < p0->y) {
     t = p0;
@@ -72,6 +70,12 @@
     p2 = t;
   }
 
+  /* a triangle spanning several bands is counted only once, by the
+     band that holds its top row */
+  if (p0->y >= zb->ymin) {
+    COUNT_PIXELS(PIXEL_COUNT, p0, p1, p2);
+  }
+
   /* we compute dXdx and dXdy for all interpolated values */
   
   fdx1 = (float) (p1->x - p0->x);
@@ -213,6 +217,7 @@
 
   pp1 = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p0->y);
   pz1 = zb->zbuf + p0->y * zb->xsize;
+  y = p0->y;
 
   DRAW_INIT();
 
@@ -341,6 +346,9 @@
 
     while (nb_lines>0) {
       nb_lines--;
+      /* the edges are stepped through every row, so that each row
+         in the band is drawn exactly as the full buffer would draw it */
+      if (y >= zb->ymin) {
 #ifndef DRAW_LINE
       /* generic draw line */
       {
@@ -417,6 +425,7 @@
 #else
       DRAW_LINE();
 #endif
+      }
       
       /* left edge */
       error+=derror;
@@ -483,6 +492,9 @@
       /* screen coordinates */
       pp1=(PIXEL *)((char *)pp1 + zb->linesize);
       pz1+=zb->xsize;
+      y++;
+      if (y >= zb->ymax)
+        return;
     }
   }
 }
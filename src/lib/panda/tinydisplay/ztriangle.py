@@ -8,6 +8,8 @@ inner-loop triangle scan function.  The code in
 tinyGraphicsStateGuardian.cxx will select the appropriate function
 pointer at draw time. """
 
+import itertools
+
 # This is the number of generated ztriangle_code_*.h and
 # ztriangle_*.cxx files we will produce.  You may change this freely;
 # you should also change the Sources.pp file accordingly.
@@ -140,6 +142,15 @@ def getFref(ops):
     fref = 'ztriangle_code_%s[%s]' % (codeSeg, i)
     return fref
 
+def getSimdFref(ops):
+    # Returns a string that evaluates to a pointer reference to the
+    # vectorized version of the indicated function, or NULL if there
+    # is none.
+    if tuple(ops) not in simdDict:
+        return 'NULL'
+    fref = 'ztriangle_simd_code[%s]' % (simdDict[tuple(ops)])
+    return fref
+
 def closeCode():
     """ Close the previously-opened code file. """
     if code:
@@ -211,6 +222,120 @@ except DoneException:
 assert count == OptionsCount
 closeCode()
 
+# Next, generate the vectorized fillers into ztriangle_simd_code.h.
+# These are only generated for the most common combinations of
+# options, listed here; see ztriangle_simd_two.h.
+SimdOptions = [
+    # depth write
+    [ 'zon', 'zoff' ],
+
+    # color write
+    [ 'cstore', 'cblend' ],
+
+    # alpha test
+    [ 'anone', 'aless', 'amore' ],
+
+    # depth test
+    [ 'znone', 'zless' ],
+
+    # texture filters
+    [ 'tnearest', 'tmipmap' ],
+    ]
+
+# The shade model and texturing combinations that
+# ztriangle_simd_two.h provides, for each of the above.
+SimdExtraOptions = [
+    [ 'smooth', 'untextured' ],
+    [ 'white', 'textured' ],
+    [ 'smooth', 'textured' ],
+    [ 'white', 'perspective' ],
+    [ 'smooth', 'perspective' ],
+    ]
+
+# The vector forms of the CodeTable macros, each operating on four
+# pixels at once.
+SimdCodeTable = {
+    # depth write
+    'zon' : '#define STORE_Z_SIMD(pz, zz, mask) zsimd_store_masked(pz, zz, mask)',
+    'zoff' : '#define STORE_Z_SIMD(pz, zz, mask)',
+
+    # color write
+    'cstore' : '#define STORE_PIX_SIMD(pp, rgb, r, g, b, a, mask) zsimd_store_masked(pp, rgb, mask)',
+    'cblend' : '#define STORE_PIX_SIMD(pp, rgb, r, g, b, a, mask) zsimd_store_masked(pp, zsimd_pixel_blend_rgb(zsimd_load(pp), r, g, b, a), mask)',
+
+    # alpha test
+    'anone' : '#define ACMP_SIMD(zb, a) zsimd_all_on()',
+    'aless' : '#define ACMP_SIMD(zb, a) _mm_cmplt_epi32(a, _mm_set1_epi32((zb)->reference_alpha))',
+    'amore' : '#define ACMP_SIMD(zb, a) _mm_cmpgt_epi32(a, _mm_set1_epi32((zb)->reference_alpha))',
+
+    # depth test
+    'znone' : '#define ZCMP_SIMD(pz, zz) zsimd_all_on()',
+    'zless' : '#define ZCMP_SIMD(pz, zz) zsimd_cmplt_epu32(zsimd_load(pz), zz)',
+
+    # texture filters
+    'tnearest' : '#define ZB_LOOKUP_TEXTURE_SIMD(texture_def, s, t, level) zsimd_lookup_texture((texture_def)->levels[0], s, t)',
+    'tmipmap' : '#define ZB_LOOKUP_TEXTURE_SIMD(texture_def, s, t, level) zsimd_lookup_texture((texture_def)->levels[(level)], s, t)',
+}
+
+ZTriangleSimdStub = """
+/* This file is generated code--do not edit.  See ztriangle.py. */
+#include <stdlib.h>
+#include <stdio.h>
+#include "pandabase.h"
+#include "zbuffer.h"
+#include "zsimd.h"
+
+/* Pick up all of the generated code references to
+   ztriangle_simd_two.h. */
+
+#include "ztriangle_table.h"
+#include "ztriangle_simd_code.h"
+"""
+
+# Maps the full ops vector of each vectorized filler to its index
+# within ztriangle_simd_code[].
+simdDict = {}
+simdList = []
+
+code = open('ztriangle_simd_code.h', 'wb')
+print >> code, '/* This file is generated code--do not edit.  See ztriangle.py. */'
+print >> code, ''
+print >> code, '#ifdef ZB_SIMD_X86'
+print >> code, ''
+
+zt = open('ztriangle_simd.cxx', 'wb')
+print >> zt, ZTriangleSimdStub
+
+for keywordList in itertools.product(*SimdOptions):
+    for keyword in keywordList:
+        print >> code, CodeTable[keyword]
+        print >> code, SimdCodeTable[keyword]
+
+    ops = []
+    for i in range(len(keywordList)):
+        ops.append(Options[i].index(keywordList[i]))
+
+    fname = 'FB_triangle_simd_%s' % ('_'.join(keywordList))
+    print >> code, '#define FNAME(name) %s_ ## name' % (fname)
+    print >> code, '#define SCALAR_FILL_TRI_FUNCS fill_tri_funcs%s' % (''.join(map(lambda o: '[%s]' % (o), ops)))
+    print >> code, '#include "ztriangle_simd_two.h"'
+    print >> code, ''
+
+    for shade, texturing in SimdExtraOptions:
+        fops = ops + [ExtraOptions[0].index(shade), ExtraOptions[1].index(texturing)]
+        simdDict[tuple(fops)] = len(simdList)
+        simdList.append('%s_%s_%s' % (fname, shade, texturing))
+
+print >> code, '#endif  // ZB_SIMD_X86'
+print >> code, ''
+print >> code, 'ZB_fillTriangleFunc ztriangle_simd_code[%s] = {' % (len(simdList))
+print >> code, '#ifdef ZB_SIMD_X86'
+for fname in simdList:
+    print >> code, '  %s,' % (fname)
+print >> code, '#endif  // ZB_SIMD_X86'
+print >> code, '};'
+code.close()
+
 # Now, generate the table of function pointers.
 
 # The external reference for the table containing the above function
@@ -230,9 +355,10 @@ print >> table_def, ''
 
 for i in range(NumSegments):
     print >> table_def, 'extern ZB_fillTriangleFunc ztriangle_code_%s[];' % (i + 1)
+print >> table_def, 'extern ZB_fillTriangleFunc ztriangle_simd_code[];'
 print >> table_def, ''
 
-def writeTableEntry(ops):
+def writeTableEntry(ops, getFref = getFref):
     indent = '  ' * (len(ops) + 1)
     i = len(ops)
     numOps = len(FullOptions[i])
@@ -247,10 +373,10 @@ def writeTableEntry(ops):
         # Intermediate levels: write out a nested reference.
         for j in range(numOps - 1):
             print >> table_def, indent + '{'
-            writeTableEntry(ops + [j])
+            writeTableEntry(ops + [j], getFref)
             print >> table_def, indent + '},'
         print >> table_def, indent + '{'
-        writeTableEntry(ops + [numOps - 1])
+        writeTableEntry(ops + [numOps - 1], getFref)
         print >> table_def, indent + '}'
 
 arraySizeList = []
@@ -263,6 +389,15 @@ print >> table_decl, 'extern const ZB_fillTriangleFunc fill_tri_funcs%s;' % (arr
 
 writeTableEntry([])
 print >> table_def, '};'
+print >> table_def, ''
+
+# The vectorized fillers get a table of the same shape, which is NULL
+# where there is no vectorized version.
+print >> table_def, 'const ZB_fillTriangleFunc simd_fill_tri_funcs%s = {' % (arraySize)
+print >> table_decl, 'extern const ZB_fillTriangleFunc simd_fill_tri_funcs%s;' % (arraySize)
+
+writeTableEntry([], getSimdFref)
+print >> table_def, '};'
 
 
         
@@ -0,0 +1,663 @@
+/*
+ * Vectorized versions of some of the triangle fillers in
+ * ztriangle_two.h.  These are instantiated by ztriangle.py, for the
+ * common combinations of options (see SimdOptions there), into
+ * ztriangle_simd_code.h.  Each draws the same pixels as its scalar
+ * counterpart: the setup and edge walking are the shared code in
+ * ztriangle.h, and only the inner loop along each scan line differs,
+ * handling four pixels at a time with the helpers in zsimd.h.  The
+ * last few pixels of each line are drawn with the scalar PUT_PIXEL.
+ *
+ * In addition to the macros used by ztriangle_two.h, the including
+ * code defines the vector forms ZCMP_SIMD, ACMP_SIMD, STORE_PIX_SIMD,
+ * STORE_Z_SIMD and ZB_LOOKUP_TEXTURE_SIMD, and SCALAR_FILL_TRI_FUNCS,
+ * the slice of fill_tri_funcs with the same options, which supplies
+ * the scalar fillers for the cases handled here only by EARLY_OUT.
+ */
+
+#ifndef NB_INTERP
+#define NB_INTERP 8
+#endif
+
+static ZB_SSE2 void
+FNAME(smooth_untextured) (ZBuffer *zb,
+                          ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+  __m128i dz4, dr4, dg4, db4, da4;
+
+#define INTERP_Z
+#define INTERP_RGB
+
+#define EARLY_OUT()                                     \
+  {                                                     \
+    int c0, c1, c2;                                     \
+    c0 = RGBA_TO_PIXEL(p0->r, p0->g, p0->b, p0->a);     \
+    c1 = RGBA_TO_PIXEL(p1->r, p1->g, p1->b, p1->a);     \
+    c2 = RGBA_TO_PIXEL(p2->r, p2->g, p2->b, p2->a);     \
+    if (c0 == c1 && c0 == c2) {                         \
+      /* It's really a flat-shaded triangle. */         \
+      SCALAR_FILL_TRI_FUNCS[1][0](zb, p0, p1, p2);      \
+      return;                                           \
+    }                                                   \
+  }
+
+#define DRAW_INIT()                             \
+  {                                             \
+    dz4 = zsimd_step4(dzdx);                    \
+    dr4 = zsimd_step4(drdx);                    \
+    dg4 = zsimd_step4(dgdx);                    \
+    db4 = zsimd_step4(dbdx);                    \
+    da4 = zsimd_step4(dadx);                    \
+  }
+
+#define PUT_PIXEL(_a)                                                   \
+  {                                                                     \
+    zz=z >> ZB_POINT_Z_FRAC_BITS;                                       \
+    if (ZCMP(pz[_a], zz)) {                                             \
+      if (ACMP(zb, oa1)) {                                              \
+        STORE_PIX(pp[_a], RGBA_TO_PIXEL(or1, og1, ob1, oa1), or1, og1, ob1, oa1); \
+        STORE_Z(pz[_a], zz);                                            \
+      }                                                                 \
+    }                                                                   \
+    z+=dzdx;                                                            \
+    og1+=dgdx;                                                          \
+    or1+=drdx;                                                          \
+    ob1+=dbdx;                                                          \
+    oa1+=dadx;                                                          \
+  }
+
+#define PUT_PIXEL4()                                                    \
+  {                                                                     \
+    __m128i zz4 = _mm_srli_epi32(z4, ZB_POINT_Z_FRAC_BITS);             \
+    __m128i mask = _mm_and_si128(ZCMP_SIMD(pz, zz4), ACMP_SIMD(zb, oa4)); \
+    if (_mm_movemask_epi8(mask) != 0) {                                 \
+      STORE_PIX_SIMD(pp, zsimd_rgba_to_pixel(or4, og4, ob4, oa4),       \
+                     or4, og4, ob4, oa4, mask);                         \
+      STORE_Z_SIMD(pz, zz4, mask);                                      \
+    }                                                                   \
+    z4 = _mm_add_epi32(z4, dz4);                                        \
+    or4 = _mm_add_epi32(or4, dr4);                                      \
+    og4 = _mm_add_epi32(og4, dg4);                                      \
+    ob4 = _mm_add_epi32(ob4, db4);                                      \
+    oa4 = _mm_add_epi32(oa4, da4);                                      \
+  }
+
+#define DRAW_LINE()                                                     \
+  {                                                                     \
+    ZPOINT *pz;                                                         \
+    PIXEL *pp;                                                          \
+    unsigned int z,zz;                                                  \
+    unsigned int or1,og1,ob1,oa1;                                       \
+    int n;                                                              \
+    __m128i z4,or4,og4,ob4,oa4;                                         \
+    n=(x2 >> 16) - x1;                                                  \
+    pp=(PIXEL *)((char *)pp1 + x1 * PSZB);                              \
+    pz=pz1+x1;                                                          \
+    z4=zsimd_ramp(z1, dzdx);                                            \
+    or4=zsimd_ramp(r1, drdx);                                           \
+    og4=zsimd_ramp(g1, dgdx);                                           \
+    ob4=zsimd_ramp(b1, dbdx);                                           \
+    oa4=zsimd_ramp(a1, dadx);                                           \
+    while (n>=3) {                                                      \
+      PUT_PIXEL4();                                                     \
+      pz+=4;                                                            \
+      pp=(PIXEL *)((char *)pp + 4 * PSZB);                              \
+      n-=4;                                                             \
+    }                                                                   \
+    z=(unsigned int)_mm_cvtsi128_si32(z4);                              \
+    or1=(unsigned int)_mm_cvtsi128_si32(or4);                           \
+    og1=(unsigned int)_mm_cvtsi128_si32(og4);                           \
+    ob1=(unsigned int)_mm_cvtsi128_si32(ob4);                           \
+    oa1=(unsigned int)_mm_cvtsi128_si32(oa4);                           \
+    while (n>=0) {                                                      \
+      PUT_PIXEL(0);                                                     \
+      pz+=1;                                                            \
+      pp=(PIXEL *)((char *)pp + PSZB);                                  \
+      n-=1;                                                             \
+    }                                                                   \
+  }
+
+#define PIXEL_COUNT pixel_count_smooth_untextured
+
+#include "ztriangle.h"
+#undef PUT_PIXEL4
+}
+
+static ZB_SSE2 void
+FNAME(white_textured) (ZBuffer *zb,
+                       ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+  ZTextureDef *texture_def;
+  __m128i dz4, ds4, dt4;
+
+#define INTERP_Z
+#define INTERP_ST
+
+#define EARLY_OUT()                             \
+  {                                             \
+  }
+
+#define DRAW_INIT()                             \
+  {                                             \
+    texture_def = &zb->current_textures[0];     \
+    dz4 = zsimd_step4(dzdx);                    \
+    ds4 = zsimd_step4(dsdx);                    \
+    dt4 = zsimd_step4(dtdx);                    \
+  }
+
+#define PUT_PIXEL(_a)                                                   \
+  {                                                                     \
+    zz=z >> ZB_POINT_Z_FRAC_BITS;                                       \
+    if (ZCMP(pz[_a], zz)) {                                             \
+      tmp = ZB_LOOKUP_TEXTURE(texture_def, s, t, mipmap_level, mipmap_dx); \
+      if (ACMP(zb, PIXEL_A(tmp))) {                                     \
+        STORE_PIX(pp[_a], tmp, PIXEL_R(tmp), PIXEL_G(tmp), PIXEL_B(tmp), PIXEL_A(tmp)); \
+        STORE_Z(pz[_a], zz);                                            \
+      }                                                                 \
+    }                                                                   \
+    z+=dzdx;                                                            \
+    s+=dsdx;                                                            \
+    t+=dtdx;                                                            \
+  }
+
+#define PUT_PIXEL4()                                                    \
+  {                                                                     \
+    __m128i zz4 = _mm_srli_epi32(z4, ZB_POINT_Z_FRAC_BITS);             \
+    __m128i mask = ZCMP_SIMD(pz, zz4);                                  \
+    if (_mm_movemask_epi8(mask) != 0) {                                 \
+      __m128i tex = ZB_LOOKUP_TEXTURE_SIMD(texture_def, s4, t4, mipmap_level); \
+      __m128i ta = zsimd_pixel_a(tex);                                  \
+      mask = _mm_and_si128(mask, ACMP_SIMD(zb, ta));                    \
+      STORE_PIX_SIMD(pp, tex, zsimd_pixel_r(tex), zsimd_pixel_g(tex),   \
+                     zsimd_pixel_b(tex), ta, mask);                     \
+      STORE_Z_SIMD(pz, zz4, mask);                                      \
+    }                                                                   \
+    z4 = _mm_add_epi32(z4, dz4);                                        \
+    s4 = _mm_add_epi32(s4, ds4);                                        \
+    t4 = _mm_add_epi32(t4, dt4);                                        \
+  }
+
+#define DRAW_LINE()                                                     \
+  {                                                                     \
+    ZPOINT *pz;                                                         \
+    PIXEL *pp;                                                          \
+    unsigned int z,zz;                                                  \
+    unsigned int s,t;                                                   \
+    int n;                                                              \
+    __m128i z4,s4,t4;                                                   \
+    n=(x2 >> 16) - x1;                                                  \
+    pp=(PIXEL *)((char *)pp1 + x1 * PSZB);                              \
+    pz=pz1+x1;                                                          \
+    z4=zsimd_ramp(z1, dzdx);                                            \
+    s4=zsimd_ramp(s1, dsdx);                                            \
+    t4=zsimd_ramp(t1, dtdx);                                            \
+    while (n>=3) {                                                      \
+      PUT_PIXEL4();                                                     \
+      pz+=4;                                                            \
+      pp=(PIXEL *)((char *)pp + 4 * PSZB);                              \
+      n-=4;                                                             \
+    }                                                                   \
+    z=(unsigned int)_mm_cvtsi128_si32(z4);                              \
+    s=(unsigned int)_mm_cvtsi128_si32(s4);                              \
+    t=(unsigned int)_mm_cvtsi128_si32(t4);                              \
+    while (n>=0) {                                                      \
+      PUT_PIXEL(0);                                                     \
+      pz+=1;                                                            \
+      pp=(PIXEL *)((char *)pp + PSZB);                                  \
+      n-=1;                                                             \
+    }                                                                   \
+  }
+
+#define PIXEL_COUNT pixel_count_white_textured
+
+#include "ztriangle.h"
+#undef PUT_PIXEL4
+}
+
+static ZB_SSE2 void
+FNAME(smooth_textured) (ZBuffer *zb,
+                        ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+  ZTextureDef *texture_def;
+  __m128i dz4, dr4, dg4, db4, da4, ds4, dt4;
+
+#define INTERP_Z
+#define INTERP_ST
+#define INTERP_RGB
+
+#define EARLY_OUT()                                     \
+  {                                                     \
+    int c0, c1, c2;                                     \
+    c0 = RGBA_TO_PIXEL(p0->r, p0->g, p0->b, p0->a);     \
+    c1 = RGBA_TO_PIXEL(p1->r, p1->g, p1->b, p1->a);     \
+    c2 = RGBA_TO_PIXEL(p2->r, p2->g, p2->b, p2->a);     \
+    if (c0 == c1 && c0 == c2) {                         \
+      /* It's really a flat-shaded triangle. */         \
+      if (c0 == 0xffffffff) {                           \
+        /* Actually, it's a white triangle. */          \
+        FNAME(white_textured)(zb, p0, p1, p2);          \
+        return;                                         \
+      }                                                 \
+      SCALAR_FILL_TRI_FUNCS[1][1](zb, p0, p1, p2);      \
+      return;                                           \
+    }                                                   \
+  }
+
+#define DRAW_INIT()                             \
+  {                                             \
+    texture_def = &zb->current_textures[0];     \
+    dz4 = zsimd_step4(dzdx);                    \
+    dr4 = zsimd_step4(drdx);                    \
+    dg4 = zsimd_step4(dgdx);                    \
+    db4 = zsimd_step4(dbdx);                    \
+    da4 = zsimd_step4(dadx);                    \
+    ds4 = zsimd_step4(dsdx);                    \
+    dt4 = zsimd_step4(dtdx);                    \
+  }
+
+#define PUT_PIXEL(_a)                                                   \
+  {                                                                     \
+    zz=z >> ZB_POINT_Z_FRAC_BITS;                                       \
+    if (ZCMP(pz[_a], zz)) {                                             \
+      tmp = ZB_LOOKUP_TEXTURE(texture_def, s, t, mipmap_level, mipmap_dx); \
+      int a = PALPHA_MULT(oa1, PIXEL_A(tmp));                           \
+      if (ACMP(zb, a)) {                                                \
+        STORE_PIX(pp[_a],                                               \
+                  RGBA_TO_PIXEL(PCOMPONENT_MULT(or1, PIXEL_R(tmp)),     \
+                                PCOMPONENT_MULT(og1, PIXEL_G(tmp)),     \
+                                PCOMPONENT_MULT(ob1, PIXEL_B(tmp)),     \
+                                a),                                     \
+                  PCOMPONENT_MULT(or1, PIXEL_R(tmp)),                   \
+                  PCOMPONENT_MULT(og1, PIXEL_G(tmp)),                   \
+                  PCOMPONENT_MULT(ob1, PIXEL_B(tmp)),                   \
+                  a);                                                   \
+        STORE_Z(pz[_a], zz);                                            \
+      }                                                                 \
+    }                                                                   \
+    z+=dzdx;                                                            \
+    og1+=dgdx;                                                          \
+    or1+=drdx;                                                          \
+    ob1+=dbdx;                                                          \
+    oa1+=dadx;                                                          \
+    s+=dsdx;                                                            \
+    t+=dtdx;                                                            \
+  }
+
+#define PUT_PIXEL4()                                                    \
+  {                                                                     \
+    __m128i zz4 = _mm_srli_epi32(z4, ZB_POINT_Z_FRAC_BITS);             \
+    __m128i mask = ZCMP_SIMD(pz, zz4);                                  \
+    if (_mm_movemask_epi8(mask) != 0) {                                 \
+      __m128i tex = ZB_LOOKUP_TEXTURE_SIMD(texture_def, s4, t4, mipmap_level); \
+      __m128i a = zsimd_palpha_mult(oa4, zsimd_pixel_a(tex));           \
+      mask = _mm_and_si128(mask, ACMP_SIMD(zb, a));                     \
+      __m128i r = zsimd_pcomponent_mult(or4, zsimd_pixel_r(tex));       \
+      __m128i g = zsimd_pcomponent_mult(og4, zsimd_pixel_g(tex));       \
+      __m128i b = zsimd_pcomponent_mult(ob4, zsimd_pixel_b(tex));       \
+      STORE_PIX_SIMD(pp, zsimd_rgba_to_pixel(r, g, b, a),               \
+                     r, g, b, a, mask);                                 \
+      STORE_Z_SIMD(pz, zz4, mask);                                      \
+    }                                                                   \
+    z4 = _mm_add_epi32(z4, dz4);                                        \
+    or4 = _mm_add_epi32(or4, dr4);                                      \
+    og4 = _mm_add_epi32(og4, dg4);                                      \
+    ob4 = _mm_add_epi32(ob4, db4);                                      \
+    oa4 = _mm_add_epi32(oa4, da4);                                      \
+    s4 = _mm_add_epi32(s4, ds4);                                        \
+    t4 = _mm_add_epi32(t4, dt4);                                        \
+  }
+
+#define DRAW_LINE()                                                     \
+  {                                                                     \
+    ZPOINT *pz;                                                         \
+    PIXEL *pp;                                                          \
+    unsigned int z,zz;                                                  \
+    unsigned int or1,og1,ob1,oa1;                                       \
+    unsigned int s,t;                                                   \
+    int n;                                                              \
+    __m128i z4,or4,og4,ob4,oa4,s4,t4;                                   \
+    n=(x2 >> 16) - x1;                                                  \
+    pp=(PIXEL *)((char *)pp1 + x1 * PSZB);                              \
+    pz=pz1+x1;                                                          \
+    z4=zsimd_ramp(z1, dzdx);                                            \
+    or4=zsimd_ramp(r1, drdx);                                           \
+    og4=zsimd_ramp(g1, dgdx);                                           \
+    ob4=zsimd_ramp(b1, dbdx);                                           \
+    oa4=zsimd_ramp(a1, dadx);                                           \
+    s4=zsimd_ramp(s1, dsdx);                                            \
+    t4=zsimd_ramp(t1, dtdx);                                            \
+    while (n>=3) {                                                      \
+      PUT_PIXEL4();                                                     \
+      pz+=4;                                                            \
+      pp=(PIXEL *)((char *)pp + 4 * PSZB);                              \
+      n-=4;                                                             \
+    }                                                                   \
+    z=(unsigned int)_mm_cvtsi128_si32(z4);                              \
+    or1=(unsigned int)_mm_cvtsi128_si32(or4);                           \
+    og1=(unsigned int)_mm_cvtsi128_si32(og4);                           \
+    ob1=(unsigned int)_mm_cvtsi128_si32(ob4);                           \
+    oa1=(unsigned int)_mm_cvtsi128_si32(oa4);                           \
+    s=(unsigned int)_mm_cvtsi128_si32(s4);                              \
+    t=(unsigned int)_mm_cvtsi128_si32(t4);                              \
+    while (n>=0) {                                                      \
+      PUT_PIXEL(0);                                                     \
+      pz+=1;                                                            \
+      pp=(PIXEL *)((char *)pp + PSZB);                                  \
+      n-=1;                                                             \
+    }                                                                   \
+  }
+
+#define PIXEL_COUNT pixel_count_smooth_textured
+
+#include "ztriangle.h"
+#undef PUT_PIXEL4
+}
+
+/*
+ * Texture mapping with perspective correction.  As in the scalar
+ * version, s and t are computed exactly every NB_INTERP pixels, and
+ * interpolated linearly between; each block of NB_INTERP pixels is
+ * drawn as NB_INTERP / 4 vectors.
+ */
+
+static ZB_SSE2 void
+FNAME(white_perspective) (ZBuffer *zb,
+                          ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+  ZTextureDef *texture_def;
+  float fdzdx,fndzdx,ndszdx,ndtzdx;
+  __m128i dz4;
+
+#define INTERP_Z
+#define INTERP_STZ
+
+#define EARLY_OUT()                             \
+  {                                             \
+  }
+
+#define DRAW_INIT()                             \
+  {                                             \
+    texture_def = &zb->current_textures[0];     \
+    fdzdx=(float)dzdx;                          \
+    fndzdx=NB_INTERP * fdzdx;                   \
+    ndszdx=NB_INTERP * dszdx;                   \
+    ndtzdx=NB_INTERP * dtzdx;                   \
+    dz4 = zsimd_step4(dzdx);                    \
+  }
+
+#define PUT_PIXEL(_a)                                                   \
+  {                                                                     \
+    zz=z >> ZB_POINT_Z_FRAC_BITS;                                       \
+    if (ZCMP(pz[_a], zz)) {                                             \
+      tmp = ZB_LOOKUP_TEXTURE(texture_def, s, t, mipmap_level, mipmap_dx); \
+      if (ACMP(zb, PIXEL_A(tmp))) {                                     \
+        STORE_PIX(pp[_a], tmp, PIXEL_R(tmp), PIXEL_G(tmp), PIXEL_B(tmp), PIXEL_A(tmp)); \
+        STORE_Z(pz[_a], zz);                                            \
+      }                                                                 \
+    }                                                                   \
+    z+=dzdx;                                                            \
+    s+=dsdx;                                                            \
+    t+=dtdx;                                                            \
+  }
+
+/* z is signed here, as in the scalar DRAW_LINE, so zz is an
+   arithmetic shift. */
+#define PUT_PIXEL4()                                                    \
+  {                                                                     \
+    __m128i zz4 = _mm_srai_epi32(z4, ZB_POINT_Z_FRAC_BITS);             \
+    __m128i mask = ZCMP_SIMD(pz, zz4);                                  \
+    if (_mm_movemask_epi8(mask) != 0) {                                 \
+      __m128i tex = ZB_LOOKUP_TEXTURE_SIMD(texture_def, s4, t4, mipmap_level); \
+      __m128i ta = zsimd_pixel_a(tex);                                  \
+      mask = _mm_and_si128(mask, ACMP_SIMD(zb, ta));                    \
+      STORE_PIX_SIMD(pp, tex, zsimd_pixel_r(tex), zsimd_pixel_g(tex),   \
+                     zsimd_pixel_b(tex), ta, mask);                     \
+      STORE_Z_SIMD(pz, zz4, mask);                                      \
+    }                                                                   \
+    z4 = _mm_add_epi32(z4, dz4);                                        \
+    s4 = _mm_add_epi32(s4, ds4);                                        \
+    t4 = _mm_add_epi32(t4, dt4);                                        \
+  }
+
+#define CALC_ST()                                               \
+  {                                                             \
+    float ss,tt;                                                \
+    ss=(sz * zinv);                                             \
+    tt=(tz * zinv);                                             \
+    s=(int) ss;                                                 \
+    t=(int) tt;                                                 \
+    dsdx= (int)( (dszdx - ss*fdzdx)*zinv );                     \
+    dtdx= (int)( (dtzdx - tt*fdzdx)*zinv );                     \
+    CALC_MIPMAP_LEVEL(mipmap_level, mipmap_dx, dsdx, dtdx);     \
+    s4=zsimd_ramp(s, dsdx);                                     \
+    t4=zsimd_ramp(t, dtdx);                                     \
+    ds4=zsimd_step4(dsdx);                                      \
+    dt4=zsimd_step4(dtdx);                                      \
+  }
+
+#define DRAW_LINE()                                             \
+  {                                                             \
+    ZPOINT *pz;                                                 \
+    PIXEL *pp;                                                  \
+    int s,t,z,zz;                                               \
+    int n,dsdx,dtdx;                                            \
+    float sz,tz,fz,zinv;                                        \
+    __m128i z4,s4,t4,ds4,dt4;                                   \
+    n=(x2>>16)-x1;                                              \
+    fz=(float)z1;                                               \
+    zinv=1.0f / fz;                                             \
+    pp=(PIXEL *)((char *)pp1 + x1 * PSZB);                      \
+    pz=pz1+x1;                                                  \
+    z4=zsimd_ramp(z1, dzdx);                                    \
+    sz=sz1;                                                     \
+    tz=tz1;                                                     \
+    while (n>=(NB_INTERP-1)) {                                  \
+      CALC_ST();                                                \
+      fz+=fndzdx;                                               \
+      zinv=1.0f / fz;                                           \
+      for (int k=0; k<NB_INTERP; k+=4) {                        \
+        PUT_PIXEL4();                                           \
+        pz+=4;                                                  \
+        pp=(PIXEL *)((char *)pp + 4 * PSZB);                    \
+      }                                                         \
+      n-=NB_INTERP;                                             \
+      sz+=ndszdx;                                               \
+      tz+=ndtzdx;                                               \
+    }                                                           \
+    CALC_ST();                                                  \
+    while (n>=3) {                                              \
+      PUT_PIXEL4();                                             \
+      pz+=4;                                                    \
+      pp=(PIXEL *)((char *)pp + 4 * PSZB);                      \
+      n-=4;                                                     \
+    }                                                           \
+    z=_mm_cvtsi128_si32(z4);                                    \
+    s=_mm_cvtsi128_si32(s4);                                    \
+    t=_mm_cvtsi128_si32(t4);                                    \
+    while (n>=0) {                                              \
+      PUT_PIXEL(0);                                             \
+      pz+=1;                                                    \
+      pp=(PIXEL *)((char *)pp + PSZB);                          \
+      n-=1;                                                     \
+    }                                                           \
+  }
+
+#define PIXEL_COUNT pixel_count_white_perspective
+
+#include "ztriangle.h"
+#undef PUT_PIXEL4
+}
+
+static ZB_SSE2 void
+FNAME(smooth_perspective) (ZBuffer *zb,
+                           ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2)
+{
+  ZTextureDef *texture_def;
+  float fdzdx,fndzdx,ndszdx,ndtzdx;
+  __m128i dz4, dr4, dg4, db4, da4;
+
+#define INTERP_Z
+#define INTERP_STZ
+#define INTERP_RGB
+
+#define EARLY_OUT()                                     \
+  {                                                     \
+    int c0, c1, c2;                                     \
+    c0 = RGBA_TO_PIXEL(p0->r, p0->g, p0->b, p0->a);     \
+    c1 = RGBA_TO_PIXEL(p1->r, p1->g, p1->b, p1->a);     \
+    c2 = RGBA_TO_PIXEL(p2->r, p2->g, p2->b, p2->a);     \
+    if (c0 == c1 && c0 == c2) {                         \
+      /* It's really a flat-shaded triangle. */         \
+      if (c0 == 0xffffffff) {                           \
+        /* Actually, it's a white triangle. */          \
+        FNAME(white_perspective)(zb, p0, p1, p2);       \
+        return;                                         \
+      }                                                 \
+      SCALAR_FILL_TRI_FUNCS[1][2](zb, p0, p1, p2);      \
+      return;                                           \
+    }                                                   \
+  }
+
+#define DRAW_INIT()                             \
+  {                                             \
+    texture_def = &zb->current_textures[0];     \
+    fdzdx=(float)dzdx;                          \
+    fndzdx=NB_INTERP * fdzdx;                   \
+    ndszdx=NB_INTERP * dszdx;                   \
+    ndtzdx=NB_INTERP * dtzdx;                   \
+    dz4 = zsimd_step4(dzdx);                    \
+    dr4 = zsimd_step4(drdx);                    \
+    dg4 = zsimd_step4(dgdx);                    \
+    db4 = zsimd_step4(dbdx);                    \
+    da4 = zsimd_step4(dadx);                    \
+  }
+
+#define PUT_PIXEL(_a)                                                   \
+  {                                                                     \
+    zz=z >> ZB_POINT_Z_FRAC_BITS;                                       \
+    if (ZCMP(pz[_a], zz)) {                                             \
+      tmp = ZB_LOOKUP_TEXTURE(texture_def, s, t, mipmap_level, mipmap_dx); \
+      int a = PALPHA_MULT(oa1, PIXEL_A(tmp));                           \
+      if (ACMP(zb, a)) {                                                \
+        STORE_PIX(pp[_a],                                               \
+                  RGBA_TO_PIXEL(PCOMPONENT_MULT(or1, PIXEL_R(tmp)),     \
+                                PCOMPONENT_MULT(og1, PIXEL_G(tmp)),     \
+                                PCOMPONENT_MULT(ob1, PIXEL_B(tmp)),     \
+                                a),                                     \
+                  PCOMPONENT_MULT(or1, PIXEL_R(tmp)),                   \
+                  PCOMPONENT_MULT(og1, PIXEL_G(tmp)),                   \
+                  PCOMPONENT_MULT(ob1, PIXEL_B(tmp)),                   \
+                  a);                                                   \
+        STORE_Z(pz[_a], zz);                                            \
+      }                                                                 \
+    }                                                                   \
+    z+=dzdx;                                                            \
+    og1+=dgdx;                                                          \
+    or1+=drdx;                                                          \
+    ob1+=dbdx;                                                          \
+    oa1+=dadx;                                                          \
+    s+=dsdx;                                                            \
+    t+=dtdx;                                                            \
+  }
+
+#define PUT_PIXEL4()                                                    \
+  {                                                                     \
+    __m128i zz4 = _mm_srai_epi32(z4, ZB_POINT_Z_FRAC_BITS);             \
+    __m128i mask = ZCMP_SIMD(pz, zz4);                                  \
+    if (_mm_movemask_epi8(mask) != 0) {                                 \
+      __m128i tex = ZB_LOOKUP_TEXTURE_SIMD(texture_def, s4, t4, mipmap_level); \
+      __m128i a = zsimd_palpha_mult(oa4, zsimd_pixel_a(tex));           \
+      mask = _mm_and_si128(mask, ACMP_SIMD(zb, a));                     \
+      __m128i r = zsimd_pcomponent_mult(or4, zsimd_pixel_r(tex));       \
+      __m128i g = zsimd_pcomponent_mult(og4, zsimd_pixel_g(tex));       \
+      __m128i b = zsimd_pcomponent_mult(ob4, zsimd_pixel_b(tex));       \
+      STORE_PIX_SIMD(pp, zsimd_rgba_to_pixel(r, g, b, a),               \
+                     r, g, b, a, mask);                                 \
+      STORE_Z_SIMD(pz, zz4, mask);                                      \
+    }                                                                   \
+    z4 = _mm_add_epi32(z4, dz4);                                        \
+    or4 = _mm_add_epi32(or4, dr4);                                      \
+    og4 = _mm_add_epi32(og4, dg4);                                      \
+    ob4 = _mm_add_epi32(ob4, db4);                                      \
+    oa4 = _mm_add_epi32(oa4, da4);                                      \
+    s4 = _mm_add_epi32(s4, ds4);                                        \
+    t4 = _mm_add_epi32(t4, dt4);                                        \
+  }
+
+#define DRAW_LINE()                                             \
+  {                                                             \
+    ZPOINT *pz;                                                 \
+    PIXEL *pp;                                                  \
+    int s,t,z,zz;                                               \
+    int n,dsdx,dtdx;                                            \
+    int or1,og1,ob1,oa1;                                        \
+    float sz,tz,fz,zinv;                                        \
+    __m128i z4,or4,og4,ob4,oa4,s4,t4,ds4,dt4;                   \
+    n=(x2>>16)-x1;                                              \
+    fz=(float)z1;                                               \
+    zinv=1.0f / fz;                                             \
+    pp=(PIXEL *)((char *)pp1 + x1 * PSZB);                      \
+    pz=pz1+x1;                                                  \
+    z4=zsimd_ramp(z1, dzdx);                                    \
+    sz=sz1;                                                     \
+    tz=tz1;                                                     \
+    or4=zsimd_ramp(r1, drdx);                                   \
+    og4=zsimd_ramp(g1, dgdx);                                   \
+    ob4=zsimd_ramp(b1, dbdx);                                   \
+    oa4=zsimd_ramp(a1, dadx);                                   \
+    while (n>=(NB_INTERP-1)) {                                  \
+      CALC_ST();                                                \
+      fz+=fndzdx;                                               \
+      zinv=1.0f / fz;                                           \
+      for (int k=0; k<NB_INTERP; k+=4) {                        \
+        PUT_PIXEL4();                                           \
+        pz+=4;                                                  \
+        pp=(PIXEL *)((char *)pp + 4 * PSZB);                    \
+      }                                                         \
+      n-=NB_INTERP;                                             \
+      sz+=ndszdx;                                               \
+      tz+=ndtzdx;                                               \
+    }                                                           \
+    CALC_ST();                                                  \
+    while (n>=3) {                                              \
+      PUT_PIXEL4();                                             \
+      pz+=4;                                                    \
+      pp=(PIXEL *)((char *)pp + 4 * PSZB);                      \
+      n-=4;                                                     \
+    }                                                           \
+    z=_mm_cvtsi128_si32(z4);                                    \
+    or1=_mm_cvtsi128_si32(or4);                                 \
+    og1=_mm_cvtsi128_si32(og4);                                 \
+    ob1=_mm_cvtsi128_si32(ob4);                                 \
+    oa1=_mm_cvtsi128_si32(oa4);                                 \
+    s=_mm_cvtsi128_si32(s4);                                    \
+    t=_mm_cvtsi128_si32(t4);                                    \
+    while (n>=0) {                                              \
+      PUT_PIXEL(0);                                             \
+      pz+=1;                                                    \
+      pp=(PIXEL *)((char *)pp + PSZB);                          \
+      n-=1;                                                     \
+    }                                                           \
+  }
+
+#define PIXEL_COUNT pixel_count_smooth_perspective
+
+#include "ztriangle.h"
+#undef PUT_PIXEL4
+#undef CALC_ST
+}
+
+#undef ACMP
+#undef ZCMP
+#undef STORE_PIX
+#undef STORE_Z
+#undef FNAME
+#undef INTERP_MIPMAP
+#undef CALC_MIPMAP_LEVEL
+#undef ZB_LOOKUP_TEXTURE
+#undef ACMP_SIMD
+#undef ZCMP_SIMD
+#undef STORE_PIX_SIMD
+#undef STORE_Z_SIMD
+#undef ZB_LOOKUP_TEXTURE_SIMD
+#undef SCALAR_FILL_TRI_FUNCS